@@ -629,6 +629,11 @@ void export_dot(FILE *fd, Program *program);
 typedef struct _wfile WFILE;
 void ast_import_open(WFILE *input, int fileno);
 ExternalDecl *import_external_decl(WFILE *input);
+void ast_export_open(WFILE *fd, int fileno, bool compact);
+void export_external_decl(WFILE *fd, ExternalDecl *exdecl);
+void ast_export_type(WFILE *fd, Type *type);
+Type *import_type(WFILE *input);
+void ast_export_close(WFILE *fd);
 
 //
 // Print
@@ -279,81 +279,99 @@ Designator *clone_designator(const Designator *design)
     return result;
 }
 
+//
+// Clone a list of expressions.  Pending work is (source node, slot for its copy) on an
+// explicit stack rather than the C stack, so that deep trees clone in bounded stack.
+//
 Expr *clone_expression(const Expr *expr)
 {
-    if (expr == NULL)
-        return NULL;
-    Expr *result = new_expression(expr->kind);
-    if (result == NULL)
-        return NULL;
-    switch (expr->kind) {
-    case EXPR_LITERAL:
-        result->u.literal = clone_literal(expr->u.literal);
-        break;
-    case EXPR_VAR:
-        result->u.var = expr->u.var ? xstrdup(expr->u.var) : NULL;
-        break;
-    case EXPR_UNARY_OP:
-        result->u.unary_op.op   = expr->u.unary_op.op;
-        result->u.unary_op.expr = clone_expression(expr->u.unary_op.expr);
-        break;
-    case EXPR_BINARY_OP:
-        result->u.binary_op.op    = expr->u.binary_op.op;
-        result->u.binary_op.left  = clone_expression(expr->u.binary_op.left);
-        result->u.binary_op.right = clone_expression(expr->u.binary_op.right);
-        break;
-    case EXPR_ASSIGN:
-        result->u.assign.target = clone_expression(expr->u.assign.target);
-        result->u.assign.op     = expr->u.assign.op;
-        result->u.assign.value  = clone_expression(expr->u.assign.value);
-        break;
-    case EXPR_COND:
-        result->u.cond.condition = clone_expression(expr->u.cond.condition);
-        result->u.cond.then_expr = clone_expression(expr->u.cond.then_expr);
-        result->u.cond.else_expr = clone_expression(expr->u.cond.else_expr);
-        break;
-    case EXPR_CAST:
-        result->u.cast.type = clone_type(expr->u.cast.type, __func__, __FILE__, __LINE__);
-        result->u.cast.expr = clone_expression(expr->u.cast.expr);
-        break;
-    case EXPR_CALL:
-        result->u.call.func = clone_expression(expr->u.call.func);
-        result->u.call.args = clone_expression(expr->u.call.args);
-        break;
-    case EXPR_COMPOUND:
-        result->u.compound_literal.type =
-            clone_type(expr->u.compound_literal.type, __func__, __FILE__, __LINE__);
-        result->u.compound_literal.init = clone_init_item(expr->u.compound_literal.init);
-        break;
-    case EXPR_SUBSCRIPT:
-        result->u.subscript.left  = clone_expression(expr->u.subscript.left);
-        result->u.subscript.right = clone_expression(expr->u.subscript.right);
-        break;
-    case EXPR_FIELD_ACCESS:
-    case EXPR_PTR_ACCESS:
-        result->u.field_access.expr = clone_expression(expr->u.field_access.expr);
-        result->u.field_access.field =
-            expr->u.field_access.field ? xstrdup(expr->u.field_access.field) : NULL;
-        break;
-    case EXPR_POST_INC:
-    case EXPR_POST_DEC:
-        result->u.post_inc = clone_expression(expr->u.post_inc);
-        break;
-    case EXPR_SIZEOF_EXPR:
-        result->u.sizeof_expr = clone_expression(expr->u.sizeof_expr);
-        break;
-    case EXPR_SIZEOF_TYPE:
-    case EXPR_ALIGNOF:
-        result->u.sizeof_type = clone_type(expr->u.sizeof_type, __func__, __FILE__, __LINE__);
-        break;
-    case EXPR_GENERIC:
-        result->u.generic.controlling_expr = clone_expression(expr->u.generic.controlling_expr);
-        result->u.generic.associations     = clone_generic_assoc(expr->u.generic.associations);
-        break;
+    Expr *head = NULL;
+    AstWorkStack stack;
+    ast_work_init(&stack);
+    ast_work_push(&stack, 0, expr, &head);
+
+    AstWork w;
+    while (ast_work_pop(&stack, &w)) {
+        const Expr *src = w.src;
+        Expr **dst      = w.dst;
+        if (src == NULL) {
+            *dst = NULL;
+            continue;
+        }
+        Expr *result = new_expression(src->kind);
+        *dst         = result;
+        ast_work_push(&stack, 0, src->next, &result->next);
+
+        switch (src->kind) {
+        case EXPR_LITERAL:
+            result->u.literal = clone_literal(src->u.literal);
+            break;
+        case EXPR_VAR:
+            result->u.var = src->u.var ? xstrdup(src->u.var) : NULL;
+            break;
+        case EXPR_UNARY_OP:
+            result->u.unary_op.op = src->u.unary_op.op;
+            ast_work_push(&stack, 0, src->u.unary_op.expr, &result->u.unary_op.expr);
+            break;
+        case EXPR_BINARY_OP:
+            result->u.binary_op.op = src->u.binary_op.op;
+            ast_work_push(&stack, 0, src->u.binary_op.right, &result->u.binary_op.right);
+            ast_work_push(&stack, 0, src->u.binary_op.left, &result->u.binary_op.left);
+            break;
+        case EXPR_ASSIGN:
+            result->u.assign.op = src->u.assign.op;
+            ast_work_push(&stack, 0, src->u.assign.value, &result->u.assign.value);
+            ast_work_push(&stack, 0, src->u.assign.target, &result->u.assign.target);
+            break;
+        case EXPR_COND:
+            ast_work_push(&stack, 0, src->u.cond.else_expr, &result->u.cond.else_expr);
+            ast_work_push(&stack, 0, src->u.cond.then_expr, &result->u.cond.then_expr);
+            ast_work_push(&stack, 0, src->u.cond.condition, &result->u.cond.condition);
+            break;
+        case EXPR_CAST:
+            result->u.cast.type = clone_type(src->u.cast.type, __func__, __FILE__, __LINE__);
+            ast_work_push(&stack, 0, src->u.cast.expr, &result->u.cast.expr);
+            break;
+        case EXPR_CALL:
+            ast_work_push(&stack, 0, src->u.call.args, &result->u.call.args);
+            ast_work_push(&stack, 0, src->u.call.func, &result->u.call.func);
+            break;
+        case EXPR_COMPOUND:
+            result->u.compound_literal.type =
+                clone_type(src->u.compound_literal.type, __func__, __FILE__, __LINE__);
+            result->u.compound_literal.init = clone_init_item(src->u.compound_literal.init);
+            break;
+        case EXPR_SUBSCRIPT:
+            ast_work_push(&stack, 0, src->u.subscript.right, &result->u.subscript.right);
+            ast_work_push(&stack, 0, src->u.subscript.left, &result->u.subscript.left);
+            break;
+        case EXPR_FIELD_ACCESS:
+        case EXPR_PTR_ACCESS:
+            result->u.field_access.field =
+                src->u.field_access.field ? xstrdup(src->u.field_access.field) : NULL;
+            ast_work_push(&stack, 0, src->u.field_access.expr, &result->u.field_access.expr);
+            break;
+        case EXPR_POST_INC:
+        case EXPR_POST_DEC:
+            ast_work_push(&stack, 0, src->u.post_inc, &result->u.post_inc);
+            break;
+        case EXPR_SIZEOF_EXPR:
+            ast_work_push(&stack, 0, src->u.sizeof_expr, &result->u.sizeof_expr);
+            break;
+        case EXPR_SIZEOF_TYPE:
+        case EXPR_ALIGNOF:
+            result->u.sizeof_type = clone_type(src->u.sizeof_type, __func__, __FILE__, __LINE__);
+            break;
+        case EXPR_GENERIC:
+            result->u.generic.associations = clone_generic_assoc(src->u.generic.associations);
+            ast_work_push(&stack, 0, src->u.generic.controlling_expr,
+                          &result->u.generic.controlling_expr);
+            break;
+        }
+        result->type = clone_type(src->type, __func__, __FILE__, __LINE__);
     }
-    result->type = clone_type(expr->type, __func__, __FILE__, __LINE__);
-    result->next = clone_expression(expr->next);
-    return result;
+    ast_work_destroy(&stack);
+    return head;
 }
 
 Literal *clone_literal(const Literal *lit)
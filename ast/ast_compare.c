@@ -262,81 +262,104 @@ bool compare_designator(const Designator *a, const Designator *b)
     return a == NULL && b == NULL;
 }
 
+// Work items of compare_expr()
+enum {
+    CMP_NODE, // two expressions
+    CMP_LIST, // two lists of expressions, linked by `next`
+};
+
+//
+// Compare two expressions.  Pairs of subexpressions still to compare wait on an
+// explicit stack, not the C stack, so that deep trees compare in bounded stack.
+// Arguments of a call are compared as whole lists.
+//
 bool compare_expr(const Expr *a, const Expr *b)
 {
-    if (!a && !b)
-        return true;
-    if (!a || !b)
-        return false;
-    if (a->kind != b->kind)
-        return false;
-    switch (a->kind) {
-    case EXPR_LITERAL:
-        return compare_literal(a->u.literal, b->u.literal);
-    case EXPR_VAR:
-        return compare_ident(a->u.var, b->u.var);
-    case EXPR_UNARY_OP:
-        if (a->u.unary_op.op != b->u.unary_op.op)
-            return false;
-        return compare_expr(a->u.unary_op.expr, b->u.unary_op.expr);
-    case EXPR_BINARY_OP:
-        if (a->u.binary_op.op != b->u.binary_op.op)
-            return false;
-        if (!compare_expr(a->u.binary_op.left, b->u.binary_op.left))
-            return false;
-        return compare_expr(a->u.binary_op.right, b->u.binary_op.right);
-    case EXPR_ASSIGN:
-        if (a->u.assign.op != b->u.assign.op)
-            return false;
-        if (!compare_expr(a->u.assign.target, b->u.assign.target))
-            return false;
-        return compare_expr(a->u.assign.value, b->u.assign.value);
-    case EXPR_COND:
-        if (!compare_expr(a->u.cond.condition, b->u.cond.condition))
-            return false;
-        if (!compare_expr(a->u.cond.then_expr, b->u.cond.then_expr))
-            return false;
-        return compare_expr(a->u.cond.else_expr, b->u.cond.else_expr);
-    case EXPR_CAST:
-        if (!compare_type(a->u.cast.type, b->u.cast.type))
-            return false;
-        return compare_expr(a->u.cast.expr, b->u.cast.expr);
-    case EXPR_CALL:
-        if (!compare_expr(a->u.call.func, b->u.call.func))
-            return false;
-        return compare_expr(a->u.call.args, b->u.call.args);
-    case EXPR_COMPOUND:
-        if (!compare_type(a->u.compound_literal.type, b->u.compound_literal.type))
-            return false;
-        return compare_init_item(a->u.compound_literal.init, b->u.compound_literal.init);
-    case EXPR_SUBSCRIPT:
-        if (!compare_expr(a->u.subscript.left, b->u.subscript.left))
-            return false;
-        return compare_expr(a->u.subscript.right, b->u.subscript.right);
-    case EXPR_FIELD_ACCESS:
-        if (!compare_expr(a->u.field_access.expr, b->u.field_access.expr))
-            return false;
-        return compare_ident(a->u.field_access.field, b->u.field_access.field);
-    case EXPR_PTR_ACCESS:
-        if (!compare_expr(a->u.ptr_access.expr, b->u.ptr_access.expr))
-            return false;
-        return compare_ident(a->u.ptr_access.field, b->u.ptr_access.field);
-    case EXPR_POST_INC:
-        return compare_expr(a->u.post_inc, b->u.post_inc);
-    case EXPR_POST_DEC:
-        return compare_expr(a->u.post_dec, b->u.post_dec);
-    case EXPR_SIZEOF_EXPR:
-        return compare_expr(a->u.sizeof_expr, b->u.sizeof_expr);
-    case EXPR_SIZEOF_TYPE:
-        return compare_type(a->u.sizeof_type, b->u.sizeof_type);
-    case EXPR_ALIGNOF:
-        return compare_type(a->u.align_of, b->u.align_of);
-    case EXPR_GENERIC:
-        if (!compare_expr(a->u.generic.controlling_expr, b->u.generic.controlling_expr))
-            return false;
-        return compare_generic_assoc(a->u.generic.associations, b->u.generic.associations);
+    AstWorkStack stack;
+    ast_work_init(&stack);
+    ast_work_push(&stack, CMP_NODE, a, (void *)b);
+
+    bool same = true;
+    AstWork w;
+    while (same && ast_work_pop(&stack, &w)) {
+        const Expr *x = w.src;
+        const Expr *y = w.dst;
+        if (!x && !y)
+            continue;
+        if (!x || !y || x->kind != y->kind) {
+            same = false;
+            break;
+        }
+        if (w.op == CMP_LIST) {
+            ast_work_push(&stack, CMP_LIST, x->next, (void *)y->next);
+        }
+        switch (x->kind) {
+        case EXPR_LITERAL:
+            same = compare_literal(x->u.literal, y->u.literal);
+            break;
+        case EXPR_VAR:
+            same = compare_ident(x->u.var, y->u.var);
+            break;
+        case EXPR_UNARY_OP:
+            same = x->u.unary_op.op == y->u.unary_op.op;
+            ast_work_push(&stack, CMP_NODE, x->u.unary_op.expr, y->u.unary_op.expr);
+            break;
+        case EXPR_BINARY_OP:
+            same = x->u.binary_op.op == y->u.binary_op.op;
+            ast_work_push(&stack, CMP_NODE, x->u.binary_op.right, y->u.binary_op.right);
+            ast_work_push(&stack, CMP_NODE, x->u.binary_op.left, y->u.binary_op.left);
+            break;
+        case EXPR_ASSIGN:
+            same = x->u.assign.op == y->u.assign.op;
+            ast_work_push(&stack, CMP_NODE, x->u.assign.value, y->u.assign.value);
+            ast_work_push(&stack, CMP_NODE, x->u.assign.target, y->u.assign.target);
+            break;
+        case EXPR_COND:
+            ast_work_push(&stack, CMP_NODE, x->u.cond.else_expr, y->u.cond.else_expr);
+            ast_work_push(&stack, CMP_NODE, x->u.cond.then_expr, y->u.cond.then_expr);
+            ast_work_push(&stack, CMP_NODE, x->u.cond.condition, y->u.cond.condition);
+            break;
+        case EXPR_CAST:
+            same = compare_type(x->u.cast.type, y->u.cast.type);
+            ast_work_push(&stack, CMP_NODE, x->u.cast.expr, y->u.cast.expr);
+            break;
+        case EXPR_CALL:
+            ast_work_push(&stack, CMP_LIST, x->u.call.args, y->u.call.args);
+            ast_work_push(&stack, CMP_NODE, x->u.call.func, y->u.call.func);
+            break;
+        case EXPR_COMPOUND:
+            same = compare_type(x->u.compound_literal.type, y->u.compound_literal.type) &&
+                   compare_init_item(x->u.compound_literal.init, y->u.compound_literal.init);
+            break;
+        case EXPR_SUBSCRIPT:
+            ast_work_push(&stack, CMP_NODE, x->u.subscript.right, y->u.subscript.right);
+            ast_work_push(&stack, CMP_NODE, x->u.subscript.left, y->u.subscript.left);
+            break;
+        case EXPR_FIELD_ACCESS:
+        case EXPR_PTR_ACCESS:
+            same = compare_ident(x->u.field_access.field, y->u.field_access.field);
+            ast_work_push(&stack, CMP_NODE, x->u.field_access.expr, y->u.field_access.expr);
+            break;
+        case EXPR_POST_INC:
+        case EXPR_POST_DEC:
+            ast_work_push(&stack, CMP_NODE, x->u.post_inc, y->u.post_inc);
+            break;
+        case EXPR_SIZEOF_EXPR:
+            ast_work_push(&stack, CMP_NODE, x->u.sizeof_expr, y->u.sizeof_expr);
+            break;
+        case EXPR_SIZEOF_TYPE:
+        case EXPR_ALIGNOF:
+            same = compare_type(x->u.sizeof_type, y->u.sizeof_type);
+            break;
+        case EXPR_GENERIC:
+            same = compare_generic_assoc(x->u.generic.associations, y->u.generic.associations);
+            ast_work_push(&stack, CMP_NODE, x->u.generic.controlling_expr,
+                          y->u.generic.controlling_expr);
+            break;
+        }
     }
-    return compare_type(a->type, b->type);
+    ast_work_destroy(&stack);
+    return same;
 }
 
 bool compare_literal(const Literal *a, const Literal *b)
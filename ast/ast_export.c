@@ -2,12 +2,13 @@
 #include <stdlib.h>
 
 #include "ast.h"
+#include "internal.h"
 #include "tags.h"
 #include "wio.h"
 
 int export_debug; // Enable manually for debug
 
-void export_type(WFILE *fd, Type *type);
+void ast_export_type(WFILE *fd, Type *type);
 void export_type_qualifier(WFILE *fd, const TypeQualifier *qual);
 void export_field(WFILE *fd, Field *field);
 void export_enumerator(WFILE *fd, Enumerator *enumr);
@@ -28,36 +29,56 @@ void export_decl_or_stmt(WFILE *fd, DeclOrStmt *dost);
 void export_for_init(WFILE *fd, ForInit *finit);
 void export_external_decl(WFILE *fd, ExternalDecl *exdecl);
 
+//
+// Open a stream for writing the AST, one external declaration at a time.
+// With `compact` set, the stream uses the varint encoding (see wbegin_compact).
+//
+void ast_export_open(WFILE *fd, int fileno, bool compact)
+{
+    if (wdopen(fd, fileno, "a") < 0) {
+        fprintf(stderr, "Error exporting AST: cannot open file descriptor #%d\n", fileno);
+        exit(1);
+    }
+    if (compact) {
+        wbegin_compact(fd);
+    }
+    wputtag(TAG_PROGRAM, fd);
+}
+
+//
+// Terminate the list of external declarations and close the stream.
+//
+void ast_export_close(WFILE *fd)
+{
+    wputtag(TAG_EOL, fd);
+    wclose(fd);
+}
+
 void export_ast(int fileno, Program *program)
 {
     if (export_debug) {
         printf("--- %s()\n", __func__);
     }
     WFILE fd;
-    if (wdopen(&fd, fileno, "a") < 0) {
-        fprintf(stderr, "Error exporting AST: cannot open file descriptor #%d\n", fileno);
-        exit(1);
-    }
-    wputw(TAG_PROGRAM, &fd);
+    ast_export_open(&fd, fileno, false);
     if (program) {
         for (ExternalDecl *decl = program->decls; decl; decl = decl->next) {
             export_external_decl(&fd, decl);
         }
     }
-    wputw(TAG_EOL, &fd);
-    wclose(&fd);
+    ast_export_close(&fd);
 }
 
-void export_type(WFILE *fd, Type *type)
+void ast_export_type(WFILE *fd, Type *type)
 {
     if (export_debug) {
         printf("--- %s()\n", __func__);
     }
     if (!type) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_TYPE + type->kind, fd);
+    wputtag(TAG_TYPE + type->kind, fd);
     switch (type->kind) {
     case TYPE_VOID:
     case TYPE_BOOL:
@@ -80,30 +101,30 @@ void export_type(WFILE *fd, Type *type)
         break;
     case TYPE_COMPLEX:
     case TYPE_IMAGINARY:
-        export_type(fd, type->u.complex.base);
+        ast_export_type(fd, type->u.complex.base);
         break;
     case TYPE_POINTER:
-        export_type(fd, type->u.pointer.target);
+        ast_export_type(fd, type->u.pointer.target);
         for (const TypeQualifier *q = type->u.pointer.qualifiers; q; q = q->next) {
             export_type_qualifier(fd, q);
         }
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         break;
     case TYPE_ARRAY:
-        export_type(fd, type->u.array.element);
+        ast_export_type(fd, type->u.array.element);
         export_expr(fd, type->u.array.size);
         for (const TypeQualifier *q = type->u.array.qualifiers; q; q = q->next) {
             export_type_qualifier(fd, q);
         }
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         wputw((size_t)type->u.array.is_static, fd);
         break;
     case TYPE_FUNCTION:
-        export_type(fd, type->u.function.return_type);
+        ast_export_type(fd, type->u.function.return_type);
         for (Param *p = type->u.function.params; p; p = p->next) {
             export_param(fd, p);
         }
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         wputw((size_t)type->u.function.variadic, fd);
         break;
     case TYPE_STRUCT:
@@ -112,26 +133,26 @@ void export_type(WFILE *fd, Type *type)
         for (Field *f = type->u.struct_t.fields; f; f = f->next) {
             export_field(fd, f);
         }
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         break;
     case TYPE_ENUM:
         wputstr(type->u.enum_t.name, fd);
         for (Enumerator *e = type->u.enum_t.enumerators; e; e = e->next) {
             export_enumerator(fd, e);
         }
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         break;
     case TYPE_TYPEDEF_NAME:
         wputstr(type->u.typedef_name.name, fd);
         break;
     case TYPE_ATOMIC:
-        export_type(fd, type->u.atomic.base);
+        ast_export_type(fd, type->u.atomic.base);
         break;
     }
     for (const TypeQualifier *q = type->qualifiers; q; q = q->next) {
         export_type_qualifier(fd, q);
     }
-    wputw(TAG_EOL, fd);
+    wputtag(TAG_EOL, fd);
 }
 
 void export_type_qualifier(WFILE *fd, const TypeQualifier *qual)
@@ -140,10 +161,10 @@ void export_type_qualifier(WFILE *fd, const TypeQualifier *qual)
         printf("--- %s()\n", __func__);
     }
     if (!qual) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_TYPEQUALIFIER + qual->kind, fd);
+    wputtag(TAG_TYPEQUALIFIER + qual->kind, fd);
 }
 
 void export_field(WFILE *fd, Field *field)
@@ -152,18 +173,18 @@ void export_field(WFILE *fd, Field *field)
         printf("--- %s()\n", __func__);
     }
     if (!field) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
     switch (field->kind) {
     case FIELD_MEMBER:
-        wputw(TAG_FIELD, fd);
-        export_type(fd, field->u.member.type);
+        wputtag(TAG_FIELD, fd);
+        ast_export_type(fd, field->u.member.type);
         wputstr(field->u.member.name, fd);
         export_expr(fd, field->u.member.bitfield);
         break;
     case FIELD_STATIC_ASSERT:
-        wputw(TAG_STATIC_ASSERT, fd);
+        wputtag(TAG_STATIC_ASSERT, fd);
         export_expr(fd, field->u.static_assrt.condition);
         wputstr(field->u.static_assrt.message, fd);
         break;
@@ -176,10 +197,10 @@ void export_enumerator(WFILE *fd, Enumerator *enumr)
         printf("--- %s()\n", __func__);
     }
     if (!enumr) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_ENUMERATOR, fd);
+    wputtag(TAG_ENUMERATOR, fd);
     wputstr(enumr->name, fd);
     export_expr(fd, enumr->value);
 }
@@ -190,12 +211,12 @@ void export_param(WFILE *fd, Param *param)
         printf("--- %s()\n", __func__);
     }
     if (!param) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_PARAM, fd);
+    wputtag(TAG_PARAM, fd);
     wputstr(param->name, fd);
-    export_type(fd, param->type);
+    ast_export_type(fd, param->type);
     export_decl_spec(fd, param->specifiers);
 }
 
@@ -205,17 +226,17 @@ void export_declaration(WFILE *fd, Declaration *decl)
         printf("--- %s()\n", __func__);
     }
     if (!decl) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_DECLARATION + decl->kind, fd);
+    wputtag(TAG_DECLARATION + decl->kind, fd);
     switch (decl->kind) {
     case DECL_VAR:
         export_decl_spec(fd, decl->u.var.specifiers);
         for (InitDeclarator *id = decl->u.var.declarators; id; id = id->next) {
             export_init_declarator(fd, id);
         }
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         break;
     case DECL_STATIC_ASSERT:
         export_expr(fd, decl->u.static_assrt.condition);
@@ -223,7 +244,7 @@ void export_declaration(WFILE *fd, Declaration *decl)
         break;
     case DECL_EMPTY:
         export_decl_spec(fd, decl->u.empty.specifiers);
-        export_type(fd, decl->u.empty.type);
+        ast_export_type(fd, decl->u.empty.type);
         break;
     }
 }
@@ -234,19 +255,19 @@ void export_decl_spec(WFILE *fd, DeclSpec *spec)
         printf("--- %s()\n", __func__);
     }
     if (!spec) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_DECLSPEC, fd);
+    wputtag(TAG_DECLSPEC, fd);
     for (const TypeQualifier *q = spec->qualifiers; q; q = q->next) {
         export_type_qualifier(fd, q);
     }
-    wputw(TAG_EOL, fd);
+    wputtag(TAG_EOL, fd);
     wputw(spec->storage, fd);
     for (const FunctionSpec *fs = spec->func_specs; fs; fs = fs->next) {
         export_function_spec(fd, fs);
     }
-    wputw(TAG_EOL, fd);
+    wputtag(TAG_EOL, fd);
     export_alignment_spec(fd, spec->align_spec);
 }
 
@@ -256,10 +277,10 @@ void export_function_spec(WFILE *fd, const FunctionSpec *fspec)
         printf("--- %s()\n", __func__);
     }
     if (!fspec) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_FUNCTIONSPEC + fspec->kind, fd);
+    wputtag(TAG_FUNCTIONSPEC + fspec->kind, fd);
 }
 
 void export_alignment_spec(WFILE *fd, AlignmentSpec *aspec)
@@ -268,13 +289,13 @@ void export_alignment_spec(WFILE *fd, AlignmentSpec *aspec)
         printf("--- %s()\n", __func__);
     }
     if (!aspec) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_ALIGNMENTSPEC + aspec->kind, fd);
+    wputtag(TAG_ALIGNMENTSPEC + aspec->kind, fd);
     switch (aspec->kind) {
     case ALIGN_SPEC_TYPE:
-        export_type(fd, aspec->u.type);
+        ast_export_type(fd, aspec->u.type);
         break;
     case ALIGN_SPEC_EXPR:
         export_expr(fd, aspec->u.expr);
@@ -288,11 +309,11 @@ void export_init_declarator(WFILE *fd, InitDeclarator *idecl)
         printf("--- %s()\n", __func__);
     }
     if (!idecl) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_INITDECLARATOR, fd);
-    export_type(fd, idecl->type);
+    wputtag(TAG_INITDECLARATOR, fd);
+    ast_export_type(fd, idecl->type);
     wputstr(idecl->name, fd);
     export_initializer(fd, idecl->init);
 }
@@ -303,10 +324,10 @@ void export_initializer(WFILE *fd, Initializer *init)
         printf("--- %s()\n", __func__);
     }
     if (!init) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_INITIALIZER + init->kind, fd);
+    wputtag(TAG_INITIALIZER + init->kind, fd);
     switch (init->kind) {
     case INITIALIZER_SINGLE:
         export_expr(fd, init->u.expr);
@@ -315,7 +336,7 @@ void export_initializer(WFILE *fd, Initializer *init)
         for (InitItem *item = init->u.items; item; item = item->next) {
             export_init_item(fd, item);
         }
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         break;
     }
 }
@@ -326,14 +347,14 @@ void export_init_item(WFILE *fd, InitItem *item)
         printf("--- %s()\n", __func__);
     }
     if (!item) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_INITITEM, fd);
+    wputtag(TAG_INITITEM, fd);
     for (Designator *d = item->designators; d; d = d->next) {
         export_designator(fd, d);
     }
-    wputw(TAG_EOL, fd);
+    wputtag(TAG_EOL, fd);
     export_initializer(fd, item->init);
 }
 
@@ -343,10 +364,10 @@ void export_designator(WFILE *fd, Designator *desg)
         printf("--- %s()\n", __func__);
     }
     if (!desg) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_DESIGNATOR + desg->kind, fd);
+    wputtag(TAG_DESIGNATOR + desg->kind, fd);
     switch (desg->kind) {
     case DESIGNATOR_ARRAY:
         export_expr(fd, desg->u.expr);
@@ -357,96 +378,131 @@ void export_designator(WFILE *fd, Designator *desg)
     }
 }
 
+// Work items of export_expr(), in the order they must reach the stream
+enum {
+    EXPORT_EXPR,     // one expression, or TAG_EOL for none
+    EXPORT_ARGS,     // a list of arguments, then TAG_EOL
+    EXPORT_TYPE,     // a type
+    EXPORT_STR,      // a string
+    EXPORT_GENERICS, // a list of generic associations, then TAG_EOL
+};
+
+//
+// Export an expression.  Everything that follows a subexpression in the stream waits
+// on an explicit stack, pushed in reverse, so that deep trees export in bounded stack.
+//
 void export_expr(WFILE *fd, Expr *expr)
 {
-    if (export_debug) {
-        printf("--- %s()\n", __func__);
-    }
-    if (!expr) {
-        wputw(TAG_EOL, fd);
-        return;
-    }
-    wputw(TAG_EXPR + expr->kind, fd);
-    switch (expr->kind) {
-    case EXPR_LITERAL:
-        export_literal(fd, expr->u.literal);
-        break;
-    case EXPR_VAR:
-        wputstr(expr->u.var, fd);
-        break;
-    case EXPR_UNARY_OP:
-        wputw(expr->u.unary_op.op, fd);
-        export_expr(fd, expr->u.unary_op.expr);
-        break;
-    case EXPR_BINARY_OP:
-        wputw(expr->u.binary_op.op, fd);
-        export_expr(fd, expr->u.binary_op.left);
-        export_expr(fd, expr->u.binary_op.right);
-        break;
-    case EXPR_ASSIGN:
-        wputw(expr->u.assign.op, fd);
-        export_expr(fd, expr->u.assign.target);
-        export_expr(fd, expr->u.assign.value);
-        break;
-    case EXPR_COND:
-        export_expr(fd, expr->u.cond.condition);
-        export_expr(fd, expr->u.cond.then_expr);
-        export_expr(fd, expr->u.cond.else_expr);
-        break;
-    case EXPR_CAST:
-        export_type(fd, expr->u.cast.type);
-        export_expr(fd, expr->u.cast.expr);
-        break;
-    case EXPR_CALL:
-        export_expr(fd, expr->u.call.func);
-        for (Expr *arg = expr->u.call.args; arg; arg = arg->next) {
-            export_expr(fd, arg);
+    AstWorkStack stack;
+    ast_work_init(&stack);
+    ast_work_push(&stack, EXPORT_EXPR, expr, NULL);
+
+    AstWork w;
+    while (ast_work_pop(&stack, &w)) {
+        switch (w.op) {
+        case EXPORT_TYPE:
+            ast_export_type(fd, (Type *)w.src);
+            continue;
+        case EXPORT_STR:
+            wputstr(w.src, fd);
+            continue;
+        case EXPORT_GENERICS:
+            for (GenericAssoc *ga = (GenericAssoc *)w.src; ga; ga = ga->next) {
+                export_generic_assoc(fd, ga);
+            }
+            wputtag(TAG_EOL, fd);
+            continue;
+        case EXPORT_ARGS:
+            if (w.src) {
+                const Expr *arg = w.src;
+                ast_work_push(&stack, EXPORT_ARGS, arg->next, NULL);
+                ast_work_push(&stack, EXPORT_EXPR, arg, NULL);
+            } else {
+                wputtag(TAG_EOL, fd);
+            }
+            continue;
         }
-        wputw(TAG_EOL, fd);
-        break;
-    case EXPR_COMPOUND:
-        export_type(fd, expr->u.compound_literal.type);
-        for (InitItem *item = expr->u.compound_literal.init; item; item = item->next) {
-            export_init_item(fd, item);
+
+        if (export_debug) {
+            printf("--- %s()\n", __func__);
         }
-        wputw(TAG_EOL, fd);
-        break;
-    case EXPR_SUBSCRIPT:
-        export_expr(fd, expr->u.subscript.left);
-        export_expr(fd, expr->u.subscript.right);
-        break;
-    case EXPR_FIELD_ACCESS:
-        export_expr(fd, expr->u.field_access.expr);
-        wputstr(expr->u.field_access.field, fd);
-        break;
-    case EXPR_PTR_ACCESS:
-        export_expr(fd, expr->u.ptr_access.expr);
-        wputstr(expr->u.ptr_access.field, fd);
-        break;
-    case EXPR_POST_INC:
-        export_expr(fd, expr->u.post_inc);
-        break;
-    case EXPR_POST_DEC:
-        export_expr(fd, expr->u.post_dec);
-        break;
-    case EXPR_SIZEOF_EXPR:
-        export_expr(fd, expr->u.sizeof_expr);
-        break;
-    case EXPR_SIZEOF_TYPE:
-        export_type(fd, expr->u.sizeof_type);
-        break;
-    case EXPR_ALIGNOF:
-        export_type(fd, expr->u.align_of);
-        break;
-    case EXPR_GENERIC:
-        export_expr(fd, expr->u.generic.controlling_expr);
-        for (GenericAssoc *ga = expr->u.generic.associations; ga; ga = ga->next) {
-            export_generic_assoc(fd, ga);
+        Expr *e = (Expr *)w.src;
+        if (!e) {
+            wputtag(TAG_EOL, fd);
+            continue;
+        }
+        wputtag(TAG_EXPR + e->kind, fd);
+        ast_work_push(&stack, EXPORT_TYPE, e->type, NULL);
+        switch (e->kind) {
+        case EXPR_LITERAL:
+            export_literal(fd, e->u.literal);
+            break;
+        case EXPR_VAR:
+            wputstr(e->u.var, fd);
+            break;
+        case EXPR_UNARY_OP:
+            wputw(e->u.unary_op.op, fd);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.unary_op.expr, NULL);
+            break;
+        case EXPR_BINARY_OP:
+            wputw(e->u.binary_op.op, fd);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.binary_op.right, NULL);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.binary_op.left, NULL);
+            break;
+        case EXPR_ASSIGN:
+            wputw(e->u.assign.op, fd);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.assign.value, NULL);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.assign.target, NULL);
+            break;
+        case EXPR_COND:
+            ast_work_push(&stack, EXPORT_EXPR, e->u.cond.else_expr, NULL);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.cond.then_expr, NULL);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.cond.condition, NULL);
+            break;
+        case EXPR_CAST:
+            ast_export_type(fd, e->u.cast.type);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.cast.expr, NULL);
+            break;
+        case EXPR_CALL:
+            ast_work_push(&stack, EXPORT_ARGS, e->u.call.args, NULL);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.call.func, NULL);
+            break;
+        case EXPR_COMPOUND:
+            ast_export_type(fd, e->u.compound_literal.type);
+            for (InitItem *item = e->u.compound_literal.init; item; item = item->next) {
+                export_init_item(fd, item);
+            }
+            wputtag(TAG_EOL, fd);
+            break;
+        case EXPR_SUBSCRIPT:
+            ast_work_push(&stack, EXPORT_EXPR, e->u.subscript.right, NULL);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.subscript.left, NULL);
+            break;
+        case EXPR_FIELD_ACCESS:
+        case EXPR_PTR_ACCESS:
+            ast_work_push(&stack, EXPORT_STR, e->u.field_access.field, NULL);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.field_access.expr, NULL);
+            break;
+        case EXPR_POST_INC:
+        case EXPR_POST_DEC:
+            ast_work_push(&stack, EXPORT_EXPR, e->u.post_inc, NULL);
+            break;
+        case EXPR_SIZEOF_EXPR:
+            ast_work_push(&stack, EXPORT_EXPR, e->u.sizeof_expr, NULL);
+            break;
+        case EXPR_SIZEOF_TYPE:
+            ast_export_type(fd, e->u.sizeof_type);
+            break;
+        case EXPR_ALIGNOF:
+            ast_export_type(fd, e->u.align_of);
+            break;
+        case EXPR_GENERIC:
+            ast_work_push(&stack, EXPORT_GENERICS, e->u.generic.associations, NULL);
+            ast_work_push(&stack, EXPORT_EXPR, e->u.generic.controlling_expr, NULL);
+            break;
         }
-        wputw(TAG_EOL, fd);
-        break;
     }
-    export_type(fd, expr->type);
+    ast_work_destroy(&stack);
 }
 
 void export_literal(WFILE *fd, const Literal *lit)
@@ -455,19 +511,19 @@ void export_literal(WFILE *fd, const Literal *lit)
         printf("--- %s()\n", __func__);
     }
     if (!lit) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_LITERAL + lit->kind, fd);
+    wputtag(TAG_LITERAL + lit->kind, fd);
     switch (lit->kind) {
     case LITERAL_INT:
-        wputw((size_t)lit->u.int_val, fd);
+        wputi(lit->u.int_val, fd);
         break;
     case LITERAL_LONG:
-        wputw((size_t)(unsigned long)lit->u.long_val, fd);
+        wputi(lit->u.long_val, fd);
         break;
     case LITERAL_LONG_LONG:
-        wputw((size_t)(unsigned long long)lit->u.long_long_val, fd);
+        wputi(lit->u.long_long_val, fd);
         break;
     case LITERAL_UINT:
         wputw((size_t)lit->u.uint_val, fd);
@@ -486,7 +542,7 @@ void export_literal(WFILE *fd, const Literal *lit)
         wputld(lit->u.long_double_val, fd);
         break;
     case LITERAL_CHAR:
-        wputw((size_t)lit->u.char_val, fd);
+        wputi(lit->u.char_val, fd);
         break;
     case LITERAL_STRING:
         wputstr(lit->u.string_val, fd);
@@ -503,13 +559,13 @@ void export_generic_assoc(WFILE *fd, GenericAssoc *gasc)
         printf("--- %s()\n", __func__);
     }
     if (!gasc) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_GENERICASSOC + gasc->kind, fd);
+    wputtag(TAG_GENERICASSOC + gasc->kind, fd);
     switch (gasc->kind) {
     case GENERIC_ASSOC_TYPE:
-        export_type(fd, gasc->u.type_assoc.type);
+        ast_export_type(fd, gasc->u.type_assoc.type);
         export_expr(fd, gasc->u.type_assoc.expr);
         break;
     case GENERIC_ASSOC_DEFAULT:
@@ -524,10 +580,10 @@ void export_stmt(WFILE *fd, Stmt *stmt)
         printf("--- %s()\n", __func__);
     }
     if (!stmt) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_STMT + stmt->kind, fd);
+    wputtag(TAG_STMT + stmt->kind, fd);
     switch (stmt->kind) {
     case STMT_EXPR:
         export_expr(fd, stmt->u.expr);
@@ -536,7 +592,7 @@ void export_stmt(WFILE *fd, Stmt *stmt)
         for (DeclOrStmt *ds = stmt->u.compound; ds; ds = ds->next) {
             export_decl_or_stmt(fd, ds);
         }
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         break;
     case STMT_IF:
         export_expr(fd, stmt->u.if_stmt.condition);
@@ -590,10 +646,10 @@ void export_decl_or_stmt(WFILE *fd, DeclOrStmt *dost)
         printf("--- %s()\n", __func__);
     }
     if (!dost) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_DECLORSTMT + dost->kind, fd);
+    wputtag(TAG_DECLORSTMT + dost->kind, fd);
     switch (dost->kind) {
     case DECL_OR_STMT_DECL:
         export_declaration(fd, dost->u.decl);
@@ -610,10 +666,10 @@ void export_for_init(WFILE *fd, ForInit *finit)
         printf("--- %s()\n", __func__);
     }
     if (!finit) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_FORINIT + finit->kind, fd);
+    wputtag(TAG_FORINIT + finit->kind, fd);
     switch (finit->kind) {
     case FOR_INIT_EXPR:
         export_expr(fd, finit->u.expr);
@@ -630,19 +686,19 @@ void export_external_decl(WFILE *fd, ExternalDecl *exdecl)
         printf("--- %s()\n", __func__);
     }
     if (!exdecl) {
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         return;
     }
-    wputw(TAG_EXTERNALDECL + exdecl->kind, fd);
+    wputtag(TAG_EXTERNALDECL + exdecl->kind, fd);
     switch (exdecl->kind) {
     case EXTERNAL_DECL_FUNCTION:
-        export_type(fd, exdecl->u.function.type);
+        ast_export_type(fd, exdecl->u.function.type);
         wputstr(exdecl->u.function.name, fd);
         export_decl_spec(fd, exdecl->u.function.specifiers);
         for (Declaration *d = exdecl->u.function.param_decls; d; d = d->next) {
             export_declaration(fd, d);
         }
-        wputw(TAG_EOL, fd);
+        wputtag(TAG_EOL, fd);
         export_stmt(fd, exdecl->u.function.body);
         break;
     case EXTERNAL_DECL_DECLARATION:
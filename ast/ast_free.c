@@ -215,73 +215,93 @@ void free_designator(Designator *design)
     }
 }
 
+//
+// Prepend a list of expressions (linked by `next`) to another.
+//
+static Expr *splice_expressions(Expr *list, Expr *rest)
+{
+    if (list == NULL)
+        return rest;
+    Expr *tail = list;
+    while (tail->next != NULL)
+        tail = tail->next;
+    tail->next = rest;
+    return list;
+}
+
+//
+// Free a list of expressions without recursion: nodes waiting to be freed are chained
+// through their own `next` fields, and each node's subexpressions join that chain.
+// However deep the tree, no extra memory and no C stack is used.
+//
 void free_expression(Expr *expr)
 {
-    while (expr != NULL) {
-        Expr *next = expr->next;
-        switch (expr->kind) {
+    Expr *pending = expr;
+    while (pending != NULL) {
+        Expr *e = pending;
+        pending = e->next;
+        switch (e->kind) {
         case EXPR_LITERAL:
-            free_literal(expr->u.literal);
+            free_literal(e->u.literal);
             break;
         case EXPR_VAR:
-            xfree(expr->u.var);
+            xfree(e->u.var);
             break;
         case EXPR_UNARY_OP:
-            free_expression(expr->u.unary_op.expr);
+            pending = splice_expressions(e->u.unary_op.expr, pending);
             break;
         case EXPR_BINARY_OP:
-            free_expression(expr->u.binary_op.left);
-            free_expression(expr->u.binary_op.right);
+            pending = splice_expressions(e->u.binary_op.left, pending);
+            pending = splice_expressions(e->u.binary_op.right, pending);
             break;
         case EXPR_ASSIGN:
-            free_expression(expr->u.assign.target);
-            free_expression(expr->u.assign.value);
+            pending = splice_expressions(e->u.assign.target, pending);
+            pending = splice_expressions(e->u.assign.value, pending);
             break;
         case EXPR_COND:
-            free_expression(expr->u.cond.condition);
-            free_expression(expr->u.cond.then_expr);
-            free_expression(expr->u.cond.else_expr);
+            pending = splice_expressions(e->u.cond.condition, pending);
+            pending = splice_expressions(e->u.cond.then_expr, pending);
+            pending = splice_expressions(e->u.cond.else_expr, pending);
             break;
         case EXPR_CAST:
-            free_type(expr->u.cast.type);
-            free_expression(expr->u.cast.expr);
+            free_type(e->u.cast.type);
+            pending = splice_expressions(e->u.cast.expr, pending);
             break;
         case EXPR_CALL:
-            free_expression(expr->u.call.func);
-            free_expression(expr->u.call.args);
+            pending = splice_expressions(e->u.call.func, pending);
+            pending = splice_expressions(e->u.call.args, pending);
             break;
         case EXPR_COMPOUND:
-            free_type(expr->u.compound_literal.type);
-            free_init_item(expr->u.compound_literal.init);
+            free_type(e->u.compound_literal.type);
+            free_init_item(e->u.compound_literal.init);
             break;
         case EXPR_SUBSCRIPT:
-            free_expression(expr->u.subscript.left);
-            free_expression(expr->u.subscript.right);
+            pending = splice_expressions(e->u.subscript.left, pending);
+            pending = splice_expressions(e->u.subscript.right, pending);
             break;
         case EXPR_FIELD_ACCESS:
         case EXPR_PTR_ACCESS:
-            free_expression(expr->u.field_access.expr);
-            xfree(expr->u.field_access.field);
+            pending = splice_expressions(e->u.field_access.expr, pending);
+            xfree(e->u.field_access.field);
             break;
         case EXPR_POST_INC:
         case EXPR_POST_DEC:
-            free_expression(expr->u.post_inc);
+            pending = splice_expressions(e->u.post_inc, pending);
             break;
         case EXPR_SIZEOF_EXPR:
-            free_expression(expr->u.sizeof_expr);
+            pending = splice_expressions(e->u.sizeof_expr, pending);
             break;
         case EXPR_SIZEOF_TYPE:
         case EXPR_ALIGNOF:
-            free_type(expr->u.sizeof_type);
+            free_type(e->u.sizeof_type);
             break;
         case EXPR_GENERIC:
-            free_expression(expr->u.generic.controlling_expr);
-            free_generic_assoc(expr->u.generic.associations);
+            pending = splice_expressions(e->u.generic.controlling_expr, pending);
+            free_generic_assoc(e->u.generic.associations);
             break;
         }
-        free_type(expr->type);
-        xfree(expr);
-        expr = next;
+        free_type(e->type);
+        xfree(e);
     }
 }
 
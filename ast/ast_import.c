@@ -1,6 +1,5 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
 
 #include "ast.h"
 #include "internal.h"
@@ -48,9 +47,16 @@ void ast_import_open(WFILE *input, int fileno)
         fprintf(stderr, "Error importing AST: cannot open file descriptor #%d\n", fileno);
         exit(1);
     }
-    lseek(fileno, 0L, SEEK_SET);
-    size_t tag = wgetw(input);
+    // Read forward only, from wherever the descriptor stands: it may be a pipe.
+    size_t tag = wgettag(input);
     check_input(input, "program tag");
+    if (waccept_compact(input, tag)) {
+        // Header of a compact stream: the program tag follows.
+        tag = wgettag(input);
+        check_input(input, "program tag");
+    } else {
+        check_input(input, "stream header");
+    }
     if (tag != TAG_PROGRAM) {
         fprintf(stderr, "Error: Expected TAG_PROGRAM, got 0x%zx\n", tag);
         exit(1);
@@ -81,7 +87,7 @@ Type *import_type(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "type tag");
     if (tag < TAG_TYPE || tag > TAG_TYPE + TYPE_ATOMIC)
         return NULL;
@@ -192,7 +198,7 @@ TypeQualifier *import_type_qualifier(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "type qualifier tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -210,7 +216,7 @@ Field *import_field(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "field tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -238,7 +244,7 @@ Enumerator *import_enumerator(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "enumerator tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -258,7 +264,7 @@ Param *import_param(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "param tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -279,7 +285,7 @@ Declaration *import_declaration(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "declaration tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -318,7 +324,7 @@ DeclSpec *import_decl_spec(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "decl spec tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -351,7 +357,7 @@ FunctionSpec *import_function_spec(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "function spec tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -369,7 +375,7 @@ AlignmentSpec *import_alignment_spec(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "alignment spec tag");
     if (tag < TAG_ALIGNMENTSPEC || tag > TAG_ALIGNMENTSPEC + ALIGN_SPEC_EXPR)
         return NULL;
@@ -391,7 +397,7 @@ InitDeclarator *import_init_declarator(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "init declarator tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -412,7 +418,7 @@ Initializer *import_initializer(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "initializer tag");
     if (tag < TAG_INITIALIZER || tag > TAG_INITIALIZER + INITIALIZER_COMPOUND)
         return NULL;
@@ -441,7 +447,7 @@ InitItem *import_init_item(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "init item tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -467,7 +473,7 @@ Designator *import_designator(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "designator tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -489,114 +495,153 @@ Designator *import_designator(WFILE *input)
     return desg;
 }
 
+// Work items of import_expr(), in stream order
+enum {
+    IMPORT_EXPR,      // one expression, or TAG_EOL for none, into *(Expr **)dst
+    IMPORT_ARGS,      // a list of arguments ending with TAG_EOL, into *(Expr **)dst
+    IMPORT_ARGS_REST, // after an argument went into *(Expr **)dst: the rest, if any
+    IMPORT_TYPE,      // a type, into *(Type **)dst
+    IMPORT_STR,       // a string, into *(char **)dst; src names it for errors
+    IMPORT_GENERICS,  // associations ending with TAG_EOL, into *(GenericAssoc **)dst
+};
+
+//
+// Import an expression.  The fields that follow a subexpression in the stream wait on
+// an explicit stack, pushed in reverse, so that deep trees import in bounded stack.
+//
 Expr *import_expr(WFILE *input)
 {
-    if (import_debug) {
-        printf("--- %s()\n", __func__);
-    }
-    size_t tag = wgetw(input);
-    check_input(input, "expr tag");
-    if (tag == TAG_EOL)
-        return NULL;
-    if (tag < TAG_EXPR || tag > TAG_EXPR + EXPR_GENERIC) {
-        fprintf(stderr, "Error: Expected TAG_EXPR, got 0x%zx\n", tag);
-        exit(1);
-    }
-    ExprKind kind = (ExprKind)(tag - TAG_EXPR);
-    Expr *expr    = new_expression(kind);
-    switch (kind) {
-    case EXPR_LITERAL:
-        expr->u.literal = import_literal(input);
-        break;
-    case EXPR_VAR:
-        expr->u.var = wgetstr(input);
-        check_input(input, "expr var name");
-        break;
-    case EXPR_UNARY_OP:
-        expr->u.unary_op.op   = wgetw(input);
-        expr->u.unary_op.expr = import_expr(input);
-        break;
-    case EXPR_BINARY_OP:
-        expr->u.binary_op.op    = wgetw(input);
-        expr->u.binary_op.left  = import_expr(input);
-        expr->u.binary_op.right = import_expr(input);
-        break;
-    case EXPR_ASSIGN:
-        expr->u.assign.op     = wgetw(input);
-        expr->u.assign.target = import_expr(input);
-        expr->u.assign.value  = import_expr(input);
-        break;
-    case EXPR_COND:
-        expr->u.cond.condition = import_expr(input);
-        expr->u.cond.then_expr = import_expr(input);
-        expr->u.cond.else_expr = import_expr(input);
-        break;
-    case EXPR_CAST:
-        expr->u.cast.type = import_type(input);
-        expr->u.cast.expr = import_expr(input);
-        break;
-    case EXPR_CALL:
-        expr->u.call.func = import_expr(input);
-        Expr **next_arg   = &expr->u.call.args;
-        for (;;) {
-            *next_arg = import_expr(input);
-            if (!*next_arg)
-                break;
-            next_arg = &(*next_arg)->next;
+    Expr *result = NULL;
+    AstWorkStack stack;
+    ast_work_init(&stack);
+    ast_work_push(&stack, IMPORT_EXPR, NULL, &result);
+
+    AstWork w;
+    while (ast_work_pop(&stack, &w)) {
+        switch (w.op) {
+        case IMPORT_TYPE:
+            *(Type **)w.dst = import_type(input);
+            continue;
+        case IMPORT_STR:
+            *(char **)w.dst = wgetstr(input);
+            check_input(input, w.src);
+            continue;
+        case IMPORT_GENERICS:
+            for (GenericAssoc **next_gasc = w.dst;; next_gasc = &(*next_gasc)->next) {
+                *next_gasc = import_generic_assoc(input);
+                if (!*next_gasc)
+                    break;
+            }
+            continue;
+        case IMPORT_ARGS:
+            // Read one argument in full, then decide whether the list goes on.
+            ast_work_push(&stack, IMPORT_ARGS_REST, NULL, w.dst);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, w.dst);
+            continue;
+        case IMPORT_ARGS_REST:
+            if (*(Expr **)w.dst) {
+                ast_work_push(&stack, IMPORT_ARGS, NULL, &(*(Expr **)w.dst)->next);
+            }
+            continue;
         }
-        break;
-    case EXPR_COMPOUND:
-        expr->u.compound_literal.type = import_type(input);
-        InitItem **next_item          = &expr->u.compound_literal.init;
-        for (;;) {
-            *next_item = import_init_item(input);
-            if (!*next_item)
-                break;
-            next_item = &(*next_item)->next;
+
+        if (import_debug) {
+            printf("--- %s()\n", __func__);
         }
-        break;
-    case EXPR_SUBSCRIPT:
-        expr->u.subscript.left  = import_expr(input);
-        expr->u.subscript.right = import_expr(input);
-        break;
-    case EXPR_FIELD_ACCESS:
-        expr->u.field_access.expr  = import_expr(input);
-        expr->u.field_access.field = wgetstr(input);
-        check_input(input, "field access name");
-        break;
-    case EXPR_PTR_ACCESS:
-        expr->u.ptr_access.expr  = import_expr(input);
-        expr->u.ptr_access.field = wgetstr(input);
-        check_input(input, "ptr access name");
-        break;
-    case EXPR_POST_INC:
-        expr->u.post_inc = import_expr(input);
-        break;
-    case EXPR_POST_DEC:
-        expr->u.post_dec = import_expr(input);
-        break;
-    case EXPR_SIZEOF_EXPR:
-        expr->u.sizeof_expr = import_expr(input);
-        break;
-    case EXPR_SIZEOF_TYPE:
-        expr->u.sizeof_type = import_type(input);
-        break;
-    case EXPR_ALIGNOF:
-        expr->u.align_of = import_type(input);
-        break;
-    case EXPR_GENERIC:
-        expr->u.generic.controlling_expr = import_expr(input);
-        GenericAssoc **next_gasc         = &expr->u.generic.associations;
-        for (;;) {
-            *next_gasc = import_generic_assoc(input);
-            if (!*next_gasc)
-                break;
-            next_gasc = &(*next_gasc)->next;
+        size_t tag = wgettag(input);
+        check_input(input, "expr tag");
+        if (tag == TAG_EOL) {
+            *(Expr **)w.dst = NULL;
+            continue;
+        }
+        if (tag < TAG_EXPR || tag > TAG_EXPR + EXPR_GENERIC) {
+            fprintf(stderr, "Error: Expected TAG_EXPR, got 0x%zx\n", tag);
+            exit(1);
+        }
+        ExprKind kind   = (ExprKind)(tag - TAG_EXPR);
+        Expr *expr      = new_expression(kind);
+        *(Expr **)w.dst = expr;
+        ast_work_push(&stack, IMPORT_TYPE, NULL, &expr->type);
+        switch (kind) {
+        case EXPR_LITERAL:
+            expr->u.literal = import_literal(input);
+            break;
+        case EXPR_VAR:
+            expr->u.var = wgetstr(input);
+            check_input(input, "expr var name");
+            break;
+        case EXPR_UNARY_OP:
+            expr->u.unary_op.op = wgetw(input);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.unary_op.expr);
+            break;
+        case EXPR_BINARY_OP:
+            expr->u.binary_op.op = wgetw(input);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.binary_op.right);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.binary_op.left);
+            break;
+        case EXPR_ASSIGN:
+            expr->u.assign.op = wgetw(input);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.assign.value);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.assign.target);
+            break;
+        case EXPR_COND:
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.cond.else_expr);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.cond.then_expr);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.cond.condition);
+            break;
+        case EXPR_CAST:
+            expr->u.cast.type = import_type(input);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.cast.expr);
+            break;
+        case EXPR_CALL:
+            ast_work_push(&stack, IMPORT_ARGS, NULL, &expr->u.call.args);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.call.func);
+            break;
+        case EXPR_COMPOUND:
+            expr->u.compound_literal.type = import_type(input);
+            InitItem **next_item          = &expr->u.compound_literal.init;
+            for (;;) {
+                *next_item = import_init_item(input);
+                if (!*next_item)
+                    break;
+                next_item = &(*next_item)->next;
+            }
+            break;
+        case EXPR_SUBSCRIPT:
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.subscript.right);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.subscript.left);
+            break;
+        case EXPR_FIELD_ACCESS:
+            ast_work_push(&stack, IMPORT_STR, "field access name", &expr->u.field_access.field);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.field_access.expr);
+            break;
+        case EXPR_PTR_ACCESS:
+            ast_work_push(&stack, IMPORT_STR, "ptr access name", &expr->u.ptr_access.field);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.ptr_access.expr);
+            break;
+        case EXPR_POST_INC:
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.post_inc);
+            break;
+        case EXPR_POST_DEC:
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.post_dec);
+            break;
+        case EXPR_SIZEOF_EXPR:
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.sizeof_expr);
+            break;
+        case EXPR_SIZEOF_TYPE:
+            expr->u.sizeof_type = import_type(input);
+            break;
+        case EXPR_ALIGNOF:
+            expr->u.align_of = import_type(input);
+            break;
+        case EXPR_GENERIC:
+            ast_work_push(&stack, IMPORT_GENERICS, NULL, &expr->u.generic.associations);
+            ast_work_push(&stack, IMPORT_EXPR, NULL, &expr->u.generic.controlling_expr);
+            break;
         }
-        break;
     }
-    expr->type = import_type(input);
-    return expr;
+    ast_work_destroy(&stack);
+    return result;
 }
 
 Literal *import_literal(WFILE *input)
@@ -604,7 +649,7 @@ Literal *import_literal(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "literal tag");
     if (tag < TAG_LITERAL || tag > TAG_LITERAL + LITERAL_ENUM)
         return NULL;
@@ -612,15 +657,15 @@ Literal *import_literal(WFILE *input)
     Literal *lit     = new_literal(kind);
     switch (kind) {
     case LITERAL_INT:
-        lit->u.int_val = (int64_t)wgetw(input);
+        lit->u.int_val = (int64_t)wgeti(input);
         check_input(input, "literal int");
         break;
     case LITERAL_LONG:
-        lit->u.long_val = (long)wgetw(input);
+        lit->u.long_val = (long)wgeti(input);
         check_input(input, "literal long");
         break;
     case LITERAL_LONG_LONG:
-        lit->u.long_long_val = (long long)wgetw(input);
+        lit->u.long_long_val = wgeti(input);
         check_input(input, "literal long long");
         break;
     case LITERAL_UINT:
@@ -645,7 +690,7 @@ Literal *import_literal(WFILE *input)
         check_input(input, "literal long double");
         break;
     case LITERAL_CHAR:
-        lit->u.char_val = (char)wgetw(input);
+        lit->u.char_val = (char)wgeti(input);
         check_input(input, "literal char");
         break;
     case LITERAL_STRING:
@@ -665,7 +710,7 @@ GenericAssoc *import_generic_assoc(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "generic assoc tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -692,7 +737,7 @@ Stmt *import_stmt(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "stmt tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -770,7 +815,7 @@ DeclOrStmt *import_decl_or_stmt(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "decl or stmt tag");
     if (tag == TAG_EOL)
         return NULL;
@@ -796,7 +841,7 @@ ForInit *import_for_init(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "for init tag");
     if (tag < TAG_FORINIT || tag > TAG_FORINIT + FOR_INIT_DECL)
         return NULL;
@@ -818,7 +863,7 @@ ExternalDecl *import_external_decl(WFILE *input)
     if (import_debug) {
         printf("--- %s()\n", __func__);
     }
-    size_t tag = wgetw(input);
+    size_t tag = wgettag(input);
     check_input(input, "external decl tag");
     if (tag < TAG_EXTERNALDECL || tag > TAG_EXTERNALDECL + EXTERNAL_DECL_DECLARATION)
         return NULL;
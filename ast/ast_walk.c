@@ -0,0 +1,62 @@
+//
+// Explicit work stack for the walkers over Expr trees.
+//
+// Generated code produces chains such as `a + b + c + ...` and nested initializers
+// thousands of levels deep.  Walking them by recursion costs a C stack frame per level,
+// which overflows the stack long before memory runs out.  The clone, compare, export
+// and import walkers instead keep their pending work here: a small array inside the
+// stack object, moved to the heap once an expression gets deep.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal.h"
+
+void ast_work_init(AstWorkStack *s)
+{
+    s->items = s->inline_items;
+    s->count = 0;
+    s->cap   = sizeof(s->inline_items) / sizeof(s->inline_items[0]);
+}
+
+void ast_work_push(AstWorkStack *s, int op, const void *src, void *dst)
+{
+    if (s->count == s->cap) {
+        size_t new_cap = 2 * s->cap;
+        AstWork *items;
+        if (s->items == s->inline_items) {
+            items = malloc(new_cap * sizeof(AstWork));
+            if (items)
+                memcpy(items, s->inline_items, s->count * sizeof(AstWork));
+        } else {
+            items = realloc(s->items, new_cap * sizeof(AstWork));
+        }
+        if (!items) {
+            fprintf(stderr, "Out of memory walking an expression %zu levels deep\n", s->count);
+            exit(1);
+        }
+        s->items = items;
+        s->cap   = new_cap;
+    }
+    AstWork *w = &s->items[s->count++];
+    w->op      = op;
+    w->src     = src;
+    w->dst     = dst;
+}
+
+bool ast_work_pop(AstWorkStack *s, AstWork *w)
+{
+    if (s->count == 0)
+        return false;
+    *w = s->items[--s->count];
+    return true;
+}
+
+void ast_work_destroy(AstWorkStack *s)
+{
+    if (s->items != s->inline_items)
+        free(s->items);
+    s->items = s->inline_items;
+    s->count = 0;
+}
@@ -111,6 +111,28 @@ void free_type_spec(TypeSpec *ts);
 //
 TypeSpec *clone_type_spec(const TypeSpec *ts);
 
+//
+// Work stack of the non-recursive Expr walkers (see ast_walk.c).  Each walker defines
+// its own `op` codes; `src` and `dst` are the node to visit and where its result goes.
+//
+typedef struct {
+    int op;
+    const void *src;
+    void *dst;
+} AstWork;
+
+typedef struct {
+    AstWork *items;
+    size_t count;
+    size_t cap;
+    AstWork inline_items[64]; // enough for all but generated expressions
+} AstWorkStack;
+
+void ast_work_init(AstWorkStack *s);
+void ast_work_push(AstWorkStack *s, int op, const void *src, void *dst);
+bool ast_work_pop(AstWorkStack *s, AstWork *w);
+void ast_work_destroy(AstWorkStack *s);
+
 #ifdef __cplusplus
 }
 #endif
@@ -50,6 +50,17 @@ extern "C" {
 // (`,ati, 12` in b_tout.madlen, the r12 frame in b_umod.madlen).
 #define REG_SCRATCH 14 // same register as REG_CNT — see above
 
+// Index registers that count the passes of loops closed by VLM (loops.c): an innermost loop in
+// r8, the loop around it in r9.  No runtime helper touches either, and a loop that holds one
+// makes no call, so neither needs saving.
+#define REG_LOOP 8 // r8, and r9 one level out
+
+// Index registers that address the parameters and autos of a leaf function in place of r6 and
+// r7 (leaf.c).  Every caller expects a call to clobber them, so a function that calls nothing
+// uses them without saving anything; the runtime helpers' own use of r12 does not matter there.
+#define REG_LEAF_PAR  12 // leaf parameter pointer
+#define REG_LEAF_AUTO 11 // leaf auto-variable pointer
+
 #ifdef __cplusplus
 }
 #endif
@@ -124,6 +124,8 @@ struct Besm_Instr {
     unsigned reg;            // index-register 0..15, or displacement (BESM_DATA_Z00)
     int addr;                // offset, or integer data value (BESM_DATA_INT/BSS/EQU)
     char *name;              // symbolic name, optional (heap-owned)
+    const char *sym;         // `name` interned (tac_intern()) when it names a data location,
+                             // so the peephole pass compares locations by address; else NULL
     char *label;             // Madlen label for a data word whose `name` is already an
                              // operand (currently only BESM_DATA_Z00), optional (heap-owned)
     struct Tac_Const *konst; // scalar nonzero constant operand (=N / #N / =Ю'…'), optional
@@ -253,6 +255,41 @@ void mad_format_real(char *buf, size_t n, double val);
 // that rule is skipped.
 void besm_peephole(Besm_Func *func, const Frame *frame);
 
+//
+// What besm_peephole rewrote, for `genbesm --stats`: one count per rule, summed over the
+// fixpoint sweeps.  Rule #30 has no counter of its own — it is what #27 and #28 do to a
+// compare.  Like the TAC optimizer's opt_stats the counts only grow; copy the struct
+// before a call and print the difference to isolate one function.
+//
+typedef enum {
+    PEEP_RELOAD,          // #27    reload of a location A already holds
+    PEEP_DEAD_STORE,      // #28    dead temp store
+    PEEP_NTR,             // #29(a) ntr of the mode R already holds
+    PEEP_DEAD_NTR,        // #29(b) ntr overridden before any use
+    PEEP_JUMP_NEXT,       // #31(a) jump to the next label
+    PEEP_UNREACHABLE,     // #31(b) instruction after an unconditional jump
+    PEEP_INVERT,          // #31(c) conditional branch over a jump, inverted
+    PEEP_IO_DISPLACEMENT, // #32(a) constant folded into an I/O address
+    PEEP_IO_ADDRESS,      // #32(b) I/O address read straight from memory
+    PEEP_NUM_RULES,
+} Besm_PeepRule;
+
+typedef struct {
+    unsigned long functions;
+    unsigned long sweeps;
+    unsigned long instrs_before; // machine instructions entering besm_peephole
+    unsigned long instrs_after;  // and leaving it; labels and directives not counted
+    unsigned long fired[PEEP_NUM_RULES];
+} Besm_PeepStats;
+
+extern Besm_PeepStats besm_peep_stats;
+
+// Print the column header of besm_peep_stats_print.
+void besm_peep_stats_print_header(FILE *out);
+
+// Print one row: what besm_peep_stats gained since `since` (all of it when NULL).
+void besm_peep_stats_print(FILE *out, const char *name, const Besm_PeepStats *since);
+
 //
 // Emit assembly for the selected dialect.  Dispatches to the per-dialect module
 // emitter (emit_madlen_module / emit_unix_module / emit_bemsh_module).
@@ -6,13 +6,16 @@
 
 void besm_free_instr(Besm_Instr *instr)
 {
-    if (!instr)
-        return;
-    xfree(instr->name);
-    xfree(instr->label);
-    tac_free_const(instr->konst);
-    besm_free_instr(instr->next);
-    xfree(instr);
+    // Iterate rather than recurse: one function's list can be a few hundred thousand
+    // instructions long.
+    while (instr) {
+        Besm_Instr *next = instr->next;
+        xfree(instr->name);
+        xfree(instr->label);
+        tac_free_const(instr->konst);
+        xfree(instr);
+        instr = next;
+    }
 }
 
 void besm_free_block(Besm_Block *block)
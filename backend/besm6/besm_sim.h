@@ -0,0 +1,83 @@
+//
+// BESM-6 simulator: runs the backend's Besm_Instr IR in-process, with no assembler,
+// linker or external simulator.
+//
+// Each translation unit is code-generated for the Unix dialect and laid out in one
+// 15-bit word address space: code first, one instruction per address, then data and
+// the literal pool, then the heap (from the symbol `end`) up to the stack at 070000, as
+// b6ld and b6sim arrange it.  The runtime helpers (b$save, b$ret, b$mul, ...) and the
+// syscall leaves (write, read, exit) are the shipped b6as sources, read by a small
+// assembler for their subset of the syntax, so a helper call costs exactly the
+// instructions it takes on the target.  Extracode 077 is the b6sim syscall trap.
+//
+// The machine model follows docs/Besm6_Instruction_Set.md: A, Y, the mode register R
+// with its ω group, M[0..15], the C modifier, stack mode on M[017], and the native
+// floating-point add/multiply/divide with normalization and rounding.  Timing is
+// approximate: every instruction kind has a fixed cycle cost (see sim_exec.c).
+//
+// Executed instructions and cycles are counted per function and per instruction kind,
+// so an instruction-selection or peephole change can be measured by a plain test.
+//
+#ifndef BESM_SIM_H
+#define BESM_SIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "besm.h"
+#include "tac.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Besm_Sim Besm_Sim;
+
+//
+// Create an empty machine.  Program output (write to fd 1) goes to `out`.
+//
+Besm_Sim *besm_sim_create(FILE *out);
+void besm_sim_destroy(Besm_Sim *sim);
+
+//
+// Code-generate every toplevel of one translation unit and add the modules to the
+// image.  Static names of the unit are visible only within it.  The program may be
+// freed afterwards.
+//
+void besm_sim_load_program(Besm_Sim *sim, const Tac_TopLevel *program);
+
+//
+// Assemble one b6as source file, or every `*.s` file of a directory except crt0.s
+// (the simulator provides its own startup), and add it as a unit.  Used for the
+// runtime library in libc/besm6/unix.  A syntax error is fatal.
+//
+void besm_sim_load_assembly(Besm_Sim *sim, const char *path);
+
+//
+// Link the image, then call main(argc, argv), flush() when the program defines it, and
+// exit: the crt0 sequence.  Return the exit status, that is the value main returns or
+// the argument of exit().  An undefined or duplicate symbol, an image that does not
+// fit below the stack, or a machine fault is fatal.  A machine can run once.
+//
+int besm_sim_run(Besm_Sim *sim, int argc, char *const argv[]);
+
+//
+// Dynamic counts gathered by the run.
+//
+uint64_t besm_sim_instruction_count(const Besm_Sim *sim);
+uint64_t besm_sim_cycle_count(const Besm_Sim *sim);
+uint64_t besm_sim_kind_count(const Besm_Sim *sim, Besm_InstrKind kind);
+uint64_t besm_sim_call_count(const Besm_Sim *sim, const char *function);
+uint64_t besm_sim_function_count(const Besm_Sim *sim, const char *function); // instructions
+uint64_t besm_sim_function_cycles(const Besm_Sim *sim, const char *function);
+
+//
+// Report the counts: functions by instructions executed, then instruction kinds.
+//
+void besm_sim_print_profile(FILE *fd, const Besm_Sim *sim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BESM_SIM_H
@@ -9,30 +9,48 @@
 #include "besm.h"
 #include "frame.h"
 #include "internal.h"
+#include "phase.h"
 #include "string_map.h"
 #include "tac.h"
 #include "xalloc.h"
 
+Besm_CodegenOptions besm_codegen_options;
+
 // Forward declaration.
-static void codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl, FILE *out,
-                             Besm_Dialect dialect);
+static Besm_Module *codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl,
+                                     Besm_Dialect dialect);
 static void bemsh_declare_call_targets(Besm_Func *func, const char *self_name);
 
-void codegen_program(const Tac_TopLevel *program, const Tac_TopLevel *tl, FILE *out,
-                     Besm_Dialect dialect)
+Besm_Module *codegen_module(const Tac_TopLevel *program, const Tac_TopLevel *tl,
+                            Besm_Dialect dialect)
 {
     switch (tl->kind) {
     case TAC_TOPLEVEL_FUNCTION:
-        codegen_function(program, tl, out, dialect);
-        break;
-    case TAC_TOPLEVEL_STATIC_VARIABLE:
-        codegen_static_variable(program, tl, out, dialect);
-        break;
+        return codegen_function(program, tl, dialect);
+    case TAC_TOPLEVEL_STATIC_VARIABLE: {
+        phase_begin("data");
+        Besm_Module *module = codegen_static_variable(program, tl, dialect);
+        phase_end();
+        return module;
+    }
     case TAC_TOPLEVEL_STATIC_CONSTANT:
         // String constants are no longer emitted as standalone global modules;
         // each is folded into the (single) module that references it.
         break;
     }
+    return NULL;
+}
+
+void codegen_program(const Tac_TopLevel *program, const Tac_TopLevel *tl, FILE *out,
+                     Besm_Dialect dialect)
+{
+    Besm_Module *module = codegen_module(program, tl, dialect);
+    if (!module)
+        return;
+    phase_begin("emit");
+    besm_emit_module(out, module, dialect);
+    phase_end();
+    besm_free_module(module);
 }
 
 // Declare `v` as an external (SUBP) if it is a module-level name that has no
@@ -44,8 +62,8 @@ static void declare_global_name(Besm_Block *block, Besm_Instr **tail, const Fram
 {
     int sr, so;
     intptr_t dummy;
-    if (frame_lookup(f, name, &sr, &so))
-        return; // local / param
+    if (name[0] == '%' || frame_lookup(f, name, &sr, &so))
+        return; // local / param, or a temporary kept on the stack
     if (map_get(declared, name, &dummy))
         return; // already declared
     Besm_Instr *ssubp = emit(block, tail, BESM_STMT_SUBP);
@@ -162,8 +180,18 @@ static void bemsh_declare_call_targets(Besm_Func *func, const char *self_name)
     map_destroy(&declared);
 }
 
-static void codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl, FILE *out,
-                             Besm_Dialect dialect)
+// The label of a function's call-count record: module-local, and unique in the unit, which
+// the Unix dialect assembles as one file.
+static char *call_counter(const char *name)
+{
+    size_t len  = strlen(name) + 3;
+    char *label = xalloc(len, __func__, __FILE__, __LINE__);
+    snprintf(label, len, "c$%s", name);
+    return label;
+}
+
+static Besm_Module *codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl,
+                                     Besm_Dialect dialect)
 {
     const char *name = tl->u.function.name;
 
@@ -172,6 +200,10 @@ static void codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl
         num_params++;
     bool needs_param_setup = (num_params >= 2) || tl->u.function.variadic;
     bool is_empty          = (tl->u.function.body == NULL);
+    // The runtime that writes the counts out (libc/besm6/unix/callcount.c) counts none of
+    // its own calls.
+    bool count_calls = besm_codegen_options.instrument_calls &&
+                       strncmp(name, "_callcount", strlen("_callcount")) != 0;
 
     Besm_Module *module = besm_new_module(name);
     Besm_Func *func     = besm_new_func(name, BESM_CC_BESM6_C);
@@ -184,6 +216,7 @@ static void codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl
     Besm_Instr *tail   = NULL;
     Frame *f           = NULL; // built for non-empty functions; passed to the peephole pass
     Besm_Instr *utm_sp = NULL; // prologue stack-extension; shrunk/dropped after peephole
+    char *counter      = NULL; // label of the call-count record (--instrument-calls)
 
     Besm_Instr *iname = emit(block, &tail, BESM_STMT_NAME);
     iname->name       = xstrdup(name);
@@ -216,8 +249,17 @@ static void codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl
         //
         // Build the frame early so we can declare SUBP references for static
         // constants before the first instruction that uses them (single-pass assembler).
-        f             = frame_build(tl, program);
+        phase_begin("frame");
+        // The temporaries kept in A and on the stack need no slot: when there are any, the
+        // frame is laid out again without them.
+        f = frame_build(tl, program);
+        StackTemps stacked;
+        if (stack_temps_find(tl, f, &stacked)) {
+            frame_free(f);
+            f = frame_build_unslotted(tl, program, &stacked.temps);
+        }
         int num_autos = frame_num_autos(f);
+        phase_end();
 
         // A parameterless _Noreturn function never returns, so the b/save0 prologue's
         // register saving and the b/ret epilogue are pure waste: nothing is ever
@@ -229,6 +271,10 @@ static void codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl
             Besm_Instr *subp_cret = emit(block, &tail, BESM_STMT_SUBP);
             subp_cret->name       = xstrdup("b$ret");
         }
+        if (count_calls) {
+            Besm_Instr *subp_counts = emit(block, &tail, BESM_STMT_SUBP);
+            subp_counts->name       = xstrdup(BESM_CALL_COUNTS);
+        }
 
         // The `program` entry is a Dubna-monitor convention (Madlen/Bemsh); the Unix
         // b6as path gets its entry point from crt0/the linker and must not emit it —
@@ -303,6 +349,10 @@ static void codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl
                 declare_global_name(block, &tail, f, &declared, instr->u.copy_from_offset.src);
                 declare_global_operand(block, &tail, f, &declared, instr->u.copy_from_offset.dst);
                 break;
+            case TAC_INSTRUCTION_BLOCK_COPY:
+                declare_global_operand(block, &tail, f, &declared, instr->u.block_copy.src_ptr);
+                declare_global_operand(block, &tail, f, &declared, instr->u.block_copy.dst_ptr);
+                break;
             case TAC_INSTRUCTION_JUMP_IF_ZERO:
                 declare_global_operand(block, &tail, f, &declared, instr->u.jump_if_zero.condition);
                 break;
@@ -389,8 +439,28 @@ static void codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl
             utm_sp->addr = num_autos;
         }
 
-        for (const Tac_Instruction *instr = tl->u.function.body; instr; instr = instr->next)
-            codegen_instr(instr, f, block, &tail);
+        phase_begin("isel");
+        codegen_function_begin(name);
+        if (count_calls) {
+            counter = call_counter(name);
+            codegen_count_call(counter, block, &tail);
+        }
+        CountedLoops *loops = counted_loops_find(tl, f);
+        DivModPairs *pairs  = divmod_pairs_find(tl, f, &stacked);
+        for (const Tac_Instruction *instr = tl->u.function.body; instr; instr = instr->next) {
+            if (codegen_counted_loop(loops, &instr, f, block, &tail))
+                continue;
+            if (codegen_divmod(pairs, instr, f, block, &tail))
+                continue;
+            if (codegen_compare_branch(instr, f, block, &tail))
+                instr = instr->next; // the jump went out with the comparison
+            else if (!codegen_stacked(instr, &stacked, f, block, &tail))
+                codegen_instr(instr, f, block, &tail);
+        }
+        counted_loops_free(loops);
+        divmod_pairs_free(pairs);
+        stack_temps_free(&stacked);
+        phase_end();
 
         // A _Noreturn function never reaches its epilogue, and with no b/save there is
         // nothing for b/ret to restore — omit the epilogue jump entirely.
@@ -404,6 +474,7 @@ static void codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl
     // Final polish: peephole-optimize the selected instruction stream before emission.
     // The frame (NULL for empty functions) lets the pass classify temporary slots for
     // dead temp-store elimination; it is freed once the pass no longer needs it.
+    phase_begin("peephole");
     besm_peephole(func, f);
 
     // Peephole may have eliminated every reference to one or more top auto slots, so
@@ -412,13 +483,25 @@ static void codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl
     if (utm_sp != NULL) {
         int used = used_auto_words(func, f);
         if (used < utm_sp->addr) {
-            if (used == 0)
+            if (used == 0) {
                 remove_instr(block, utm_sp);
-            else
+                utm_sp = NULL;
+            } else {
                 utm_sp->addr = used;
+            }
         }
     }
 
+    // A function that calls nothing needs no b/save frame: give it the lightest linkage
+    // that still addresses its parameters and autos.
+    if (f) {
+        bool autos          = utm_sp != NULL;
+        Besm_FrameKind kind = leaf_frame_kind(func, tl, autos);
+        leaf_frame_rewrite(func, tl, kind, autos);
+    }
+
+    phase_end();
+
     if (f)
         frame_free(f);
 
@@ -430,12 +513,16 @@ static void codegen_function(const Tac_TopLevel *program, const Tac_TopLevel *tl
     // Emit this function's block-scope static locals as module-local labeled data, spliced
     // in after the code (before `,end,`).  Done before folding string constants so that a
     // static-local initializer referencing a string literal gets that string folded in too.
+    phase_begin("data");
     besm_emit_static_locals(module, tl, dialect);
+    if (counter) {
+        besm_emit_call_counter(module, name, counter, dialect);
+        xfree(counter);
+    }
 
     // Fold any string literals this function references into its module as local
     // labels, removing their external SUBP declarations.
     besm_fold_string_constants(module, program, dialect);
-
-    besm_emit_module(out, module, dialect);
-    besm_free_module(module);
+    phase_end();
+    return module;
 }
@@ -1,6 +1,7 @@
 #ifndef BESM6_CODEGEN_H
 #define BESM6_CODEGEN_H
 
+#include <stdbool.h>
 #include <stdio.h>
 
 #include "besm.h"
@@ -10,6 +11,15 @@
 extern "C" {
 #endif
 
+// Choices between smaller and faster code, set from the command line before the first
+// toplevel is generated.  The defaults give the smallest code.
+typedef struct {
+    bool speed;            // --speed: step char pointers and store bytes inline, not helpers
+    bool instrument_calls; // --instrument-calls: count the calls of each function with a body
+} Besm_CodegenOptions;
+
+extern Besm_CodegenOptions besm_codegen_options;
+
 // Translate one TAC toplevel declaration to assembly (in the selected dialect)
 // written to `out`.  `program` is the head of the full translation-unit toplevel
 // chain; it is used to identify module-level names so they are not assigned frame
@@ -17,6 +27,13 @@ extern "C" {
 void codegen_program(const Tac_TopLevel *program, const Tac_TopLevel *tl, FILE *out,
                      Besm_Dialect dialect);
 
+// Build the dialect-agnostic module of one toplevel without emitting it: the step
+// codegen_program() renders.  Returns NULL for a toplevel that produces no module
+// (a string constant, folded into its referencing module, or a superseded tentative
+// definition).  The caller frees the module with besm_free_module().
+Besm_Module *codegen_module(const Tac_TopLevel *program, const Tac_TopLevel *tl,
+                            Besm_Dialect dialect);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,312 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "abi.h"
+#include "besm.h"
+#include "codegen.h"
+#include "frame.h"
+#include "internal.h"
+#include "tac.h"
+#include "xalloc.h"
+
+// A quotient and a remainder of the same operands.
+//
+// A digit loop divides its number twice a digit, once for the remainder and once for the
+// quotient, and the translator keeps them apart:
+//
+//     r = n % b  /  ...  /  q = n / b  /  n = q
+//
+// Selected one by one, that is b$mod and b$div, and b$mod divides as b$div does before it
+// multiplies back.  The unsigned pair is dearer still: b$umod runs the long division of
+// b$udiv all over again.  With --speed the pair is selected together, where the first of
+// the two comes, as one call of a helper that returns both:
+//
+//     xta a / xts b / call b$divmod / atx q / 15 xta / atx r      ...and nothing for the second
+//
+// b$divmod (b$udivmod when unsigned) divides once and takes the remainder as a - q*b.  It
+// returns q in A and leaves r pushed in place of a, for the `15 xta` to pop.  That is two
+// words less than the calls of b$div and b$mod, and one divide in place of two.
+//
+// A pair qualifies when both operations call their helpers (see binop_helper), a and b are
+// constants or frame slots whose address is never taken, and nothing between the two
+// transfers control or writes a or b.  The result of the second is stored early, so it must
+// be such a frame slot too, which nothing between may name: a call between may not see it.
+// No value of the pair may be kept on the stack (see codegen_stacked).
+
+typedef struct {
+    const Tac_Instruction *first;  // the one selected for both
+    const Tac_Instruction *second; // selected as nothing
+    const Tac_Instruction *divide;
+} DivModPair;
+
+struct DivModPairs {
+    DivModPair *pairs;
+    int count;
+};
+
+// `name` is always a Tac_Val's var_name, and those are interned (see tac_intern()).  The
+// fun_name of a call is not: an indirect call compares it by its characters.
+static bool is_var(const Tac_Val *v, const char *name)
+{
+    return v && v->kind == TAC_VAL_VAR && v->u.var_name == name;
+}
+
+// Do the two operands hold the same value wherever both are read?
+static bool same_val(const Tac_Val *x, const Tac_Val *y)
+{
+    if (x->kind == TAC_VAL_VAR)
+        return is_var(y, x->u.var_name);
+    if (y->kind != TAC_VAL_CONSTANT)
+        return false;
+    const Besm_ConstWord a = besm_const_word(x->u.constant);
+    const Besm_ConstWord b = besm_const_word(y->u.constant);
+    return !a.is_real && !b.is_real && a.word == b.word;
+}
+
+// Is the instruction a divide or remainder, and of which signedness?
+static bool is_divmod(const Tac_Instruction *instr, bool *divide, bool *is_unsigned)
+{
+    if (instr->kind != TAC_INSTRUCTION_BINARY)
+        return false;
+    switch (instr->u.binary.op) {
+    case TAC_BINARY_DIVIDE:
+    case TAC_BINARY_REMAINDER:
+        *is_unsigned = false;
+        break;
+    case TAC_BINARY_DIVIDE_UNSIGNED:
+    case TAC_BINARY_REMAINDER_UNSIGNED:
+        *is_unsigned = true;
+        break;
+    default:
+        return false;
+    }
+    *divide = instr->u.binary.op == TAC_BINARY_DIVIDE ||
+              instr->u.binary.op == TAC_BINARY_DIVIDE_UNSIGNED;
+    return binop_helper(instr) != NULL;
+}
+
+// Does the value name a frame slot whose address the function never takes?
+static bool is_private_slot(const Tac_TopLevel *fn, const Frame *f, const Tac_Val *v)
+{
+    int reg, off;
+    if (v->kind != TAC_VAL_VAR || !frame_lookup(f, v->u.var_name, &reg, &off))
+        return false;
+    for (const Tac_Instruction *i = fn->u.function.body; i; i = i->next) {
+        switch (i->kind) {
+        case TAC_INSTRUCTION_GET_ADDRESS:
+        case TAC_INSTRUCTION_GET_ADDRESS_BYTE:
+        case TAC_INSTRUCTION_GET_ADDRESS_DECAY:
+            if (is_var(i->u.get_address.src, v->u.var_name))
+                return false;
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+static bool names_in(const Tac_Val *list, const char *name)
+{
+    for (const Tac_Val *v = list; v; v = v->next)
+        if (is_var(v, name))
+            return true;
+    return false;
+}
+
+//
+// Does the instruction name the variable, as an operand or a destination?  An instruction
+// that ends the straight line does, and so does any this does not know.
+//
+static bool names(const Tac_Instruction *i, const char *name)
+{
+    switch (i->kind) {
+    case TAC_INSTRUCTION_UNARY:
+        return is_var(i->u.unary.src, name) || is_var(i->u.unary.dst, name);
+    case TAC_INSTRUCTION_BINARY:
+        return is_var(i->u.binary.src1, name) || is_var(i->u.binary.src2, name) ||
+               is_var(i->u.binary.dst, name);
+    case TAC_INSTRUCTION_COPY:
+        return is_var(i->u.copy.src, name) || is_var(i->u.copy.dst, name);
+    case TAC_INSTRUCTION_SIGN_EXTEND:
+    case TAC_INSTRUCTION_TRUNCATE:
+    case TAC_INSTRUCTION_ZERO_EXTEND:
+    case TAC_INSTRUCTION_PTR_TO_CHAR_PTR:
+    case TAC_INSTRUCTION_CHAR_PTR_TO_PTR:
+        return is_var(i->u.sign_extend.src, name) || is_var(i->u.sign_extend.dst, name);
+    case TAC_INSTRUCTION_GET_ADDRESS:
+    case TAC_INSTRUCTION_GET_ADDRESS_BYTE:
+    case TAC_INSTRUCTION_GET_ADDRESS_DECAY:
+        return is_var(i->u.get_address.src, name) || is_var(i->u.get_address.dst, name);
+    case TAC_INSTRUCTION_LOAD:
+    case TAC_INSTRUCTION_LOAD_BYTE:
+        return is_var(i->u.load.src_ptr, name) || is_var(i->u.load.dst, name);
+    case TAC_INSTRUCTION_STORE:
+    case TAC_INSTRUCTION_STORE_BYTE:
+        return is_var(i->u.store.src, name) || is_var(i->u.store.dst_ptr, name);
+    case TAC_INSTRUCTION_ADD_PTR:
+        return is_var(i->u.add_ptr.ptr, name) || is_var(i->u.add_ptr.index, name) ||
+               is_var(i->u.add_ptr.dst, name);
+    case TAC_INSTRUCTION_FUN_CALL:
+        return names_in(i->u.fun_call.args, name) || is_var(i->u.fun_call.dst, name) ||
+               (i->u.fun_call.indirect && strcmp(i->u.fun_call.fun_name, name) == 0);
+    default:
+        return true;
+    }
+}
+
+// The variable an instruction writes, or NULL.
+static const Tac_Val *written(const Tac_Instruction *i)
+{
+    switch (i->kind) {
+    case TAC_INSTRUCTION_UNARY:
+        return i->u.unary.dst;
+    case TAC_INSTRUCTION_BINARY:
+        return i->u.binary.dst;
+    case TAC_INSTRUCTION_COPY:
+        return i->u.copy.dst;
+    case TAC_INSTRUCTION_SIGN_EXTEND:
+    case TAC_INSTRUCTION_TRUNCATE:
+    case TAC_INSTRUCTION_ZERO_EXTEND:
+    case TAC_INSTRUCTION_PTR_TO_CHAR_PTR:
+    case TAC_INSTRUCTION_CHAR_PTR_TO_PTR:
+        return i->u.sign_extend.dst;
+    case TAC_INSTRUCTION_GET_ADDRESS:
+    case TAC_INSTRUCTION_GET_ADDRESS_BYTE:
+    case TAC_INSTRUCTION_GET_ADDRESS_DECAY:
+        return i->u.get_address.dst;
+    case TAC_INSTRUCTION_LOAD:
+    case TAC_INSTRUCTION_LOAD_BYTE:
+        return i->u.load.dst;
+    case TAC_INSTRUCTION_ADD_PTR:
+        return i->u.add_ptr.dst;
+    case TAC_INSTRUCTION_FUN_CALL:
+        return i->u.fun_call.dst;
+    default:
+        return NULL;
+    }
+}
+
+// Can the straight line from `first` run on past `i`?  Only the instructions `names` and
+// `written` know of, which neither jump nor end the function, keep it going.
+static bool straight(const Tac_Instruction *i)
+{
+    switch (i->kind) {
+    case TAC_INSTRUCTION_STORE:
+    case TAC_INSTRUCTION_STORE_BYTE:
+    case TAC_INSTRUCTION_FUN_CALL:
+        return true;
+    default:
+        return written(i) != NULL;
+    }
+}
+
+//
+// Is the later `second` the other half of `first`?  Fill in `pair` when it is.
+//
+static bool match_pair(const Tac_TopLevel *fn, const Frame *f, const StackTemps *st,
+                       const Tac_Instruction *first, const Tac_Instruction *second,
+                       DivModPair *pair)
+{
+    bool div1, div2, uns1, uns2;
+    if (!is_divmod(first, &div1, &uns1) || !is_divmod(second, &div2, &uns2) ||
+        div1 == div2 || uns1 != uns2)
+        return false;
+
+    const Tac_Val *a = first->u.binary.src1;
+    const Tac_Val *b = first->u.binary.src2;
+    if (!same_val(a, second->u.binary.src1) || !same_val(b, second->u.binary.src2))
+        return false;
+
+    const Tac_Val *vals[] = { a, b, first->u.binary.dst, second->u.binary.dst };
+    for (int k = 0; k < 4; k++)
+        if (vals[k]->kind == TAC_VAL_VAR && map_get(&st->temps, vals[k]->u.var_name, NULL))
+            return false;
+    for (int k = 0; k < 2; k++)
+        if (vals[k]->kind == TAC_VAL_VAR && !is_private_slot(fn, f, vals[k]))
+            return false;
+
+    const Tac_Instruction *divide = div1 ? first : second;
+    const Tac_Val *q              = divide->u.binary.dst;
+    const Tac_Val *r              = div1 ? second->u.binary.dst : first->u.binary.dst;
+    const Tac_Val *early          = second->u.binary.dst;
+    if (!is_private_slot(fn, f, early) || same_val(q, a) || same_val(q, b) || same_val(r, a) ||
+        same_val(r, b) || same_val(q, r))
+        return false;
+    for (const Tac_Instruction *i = first->next; i != second; i = i->next) {
+        const Tac_Val *dst = written(i);
+        if (dst && (same_val(dst, a) || same_val(dst, b)))
+            return false;
+        if (names(i, early->u.var_name))
+            return false;
+    }
+    pair->first  = first;
+    pair->second = second;
+    pair->divide = divide;
+    return true;
+}
+
+DivModPairs *divmod_pairs_find(const Tac_TopLevel *fn, const Frame *f, const StackTemps *st)
+{
+    DivModPairs *pairs = xalloc(sizeof(DivModPairs), __func__, __FILE__, __LINE__);
+    pairs->pairs       = NULL;
+    pairs->count       = 0;
+    if (!besm_codegen_options.speed)
+        return pairs;
+
+    int n = 0;
+    bool divide, is_unsigned;
+    for (const Tac_Instruction *instr = fn->u.function.body; instr; instr = instr->next)
+        if (is_divmod(instr, &divide, &is_unsigned))
+            n++;
+    if (n < 2)
+        return pairs;
+
+    pairs->pairs = xalloc(n / 2 * sizeof(DivModPair), __func__, __FILE__, __LINE__);
+    for (const Tac_Instruction *first = fn->u.function.body; first; first = first->next) {
+        if (!is_divmod(first, &divide, &is_unsigned))
+            continue;
+        for (const Tac_Instruction *i = first->next; i; i = i->next) {
+            if (match_pair(fn, f, st, first, i, &pairs->pairs[pairs->count])) {
+                pairs->count++;
+                first = i;
+                break;
+            }
+            if (!straight(i))
+                break;
+        }
+    }
+    return pairs;
+}
+
+bool codegen_divmod(DivModPairs *pairs, const Tac_Instruction *instr, const Frame *f,
+                    Besm_Block *block, Besm_Instr **tail)
+{
+    for (int k = 0; k < pairs->count; k++) {
+        const DivModPair *pair = &pairs->pairs[k];
+        if (instr == pair->second)
+            return true; // stored with the first
+        if (instr != pair->first)
+            continue;
+
+        const Tac_Instruction *div = pair->divide;
+        const Tac_Instruction *rem = div == pair->first ? pair->second : pair->first;
+        bool is_unsigned           = div->u.binary.op == TAC_BINARY_DIVIDE_UNSIGNED;
+        emit_xta_val(block, tail, f, div->u.binary.src1);
+        emit_xts_val(block, tail, f, div->u.binary.src2);
+        Besm_Instr *call = emit(block, tail, BESM_BRANCH_CALL);
+        call->name       = xstrdup(is_unsigned ? "b$udivmod" : "b$divmod");
+        emit_store_a(block, tail, f, div->u.binary.dst->u.var_name);
+        emit_xta(block, tail, REG_SP, 0); // pop r
+        emit_store_a(block, tail, f, rem->u.binary.dst->u.var_name);
+        return true;
+    }
+    return false;
+}
+
+void divmod_pairs_free(DivModPairs *pairs)
+{
+    if (pairs->pairs)
+        xfree(pairs->pairs);
+    xfree(pairs);
+}
@@ -19,6 +19,15 @@ Besm_Instr *emit(Besm_Block *block, Besm_Instr **tail, Besm_InstrKind kind)
     return i;
 }
 
+// Give `i` the data symbol `name`.  The interned copy is what the peephole pass matches
+// locations by (TAC variable names are interned already, so this is their own pointer);
+// the heap copy is what the emitters print and besm_free_instr() frees.
+void set_sym_name(Besm_Instr *i, const char *name)
+{
+    i->name = xstrdup(name);
+    i->sym  = tac_intern(name);
+}
+
 // Emit XTA: A = mem[reg + off].
 void emit_xta(Besm_Block *b, Besm_Instr **t, int reg, int off)
 {
@@ -59,8 +68,8 @@ void emit_store_a(Besm_Block *b, Besm_Instr **t, const Frame *f, const char *nam
         emit_atx(b, t, reg, off);
     } else {
         Besm_Instr *utc = emit(b, t, BESM_MOD_UTC);
-        utc->name       = xstrdup(name); // C = &global
-        emit(b, t, BESM_MEM_ATX);        // reg=0, addr=0 → mem[C] = A
+        set_sym_name(utc, name);  // C = &global
+        emit(b, t, BESM_MEM_ATX); // reg=0, addr=0 → mem[C] = A
     }
 }
 
@@ -80,7 +89,7 @@ void emit_wtc_ptr(Besm_Block *b, Besm_Instr **t, const Frame *f, const char *nam
         wtc->reg  = reg;
         wtc->addr = off; // C = mem[slot] = pointer word (bits 15:1)
     } else {
-        wtc->name = xstrdup(name); // C = mem[global] = pointer word
+        set_sym_name(wtc, name); // C = mem[global] = pointer word
     }
 }
 
@@ -101,8 +110,8 @@ void emit_asx_ptr(Besm_Block *b, Besm_Instr **t, const Frame *f, const char *nam
         asx->addr       = off;
     } else {
         Besm_Instr *utc = emit(b, t, BESM_MOD_UTC);
-        utc->name       = xstrdup(name); // C = &global
-        emit(b, t, BESM_EXP_SHIFTX);     // reg=0, addr=0 → operand mem[C] = pointer word
+        set_sym_name(utc, name);     // C = &global
+        emit(b, t, BESM_EXP_SHIFTX); // reg=0, addr=0 → operand mem[C] = pointer word
     }
 }
 
@@ -142,7 +151,7 @@ void emit_xta_val(Besm_Block *b, Besm_Instr **t, const Frame *f, const Tac_Val *
             emit_xta(b, t, reg, off);
         } else {
             Besm_Instr *utc = emit(b, t, BESM_MOD_UTC);
-            utc->name       = xstrdup(v->u.var_name);
+            set_sym_name(utc, v->u.var_name);
             emit_xta(b, t, 0, 0);
         }
     } else {
@@ -162,8 +171,8 @@ void emit_xts_val(Besm_Block *b, Besm_Instr **t, const Frame *f, const Tac_Val *
             i->addr       = off;
         } else {
             Besm_Instr *utc = emit(b, t, BESM_MOD_UTC);
-            utc->name       = xstrdup(v->u.var_name);
-            Besm_Instr *i   = emit(b, t, BESM_MEM_XTS);
+            set_sym_name(utc, v->u.var_name);
+            Besm_Instr *i = emit(b, t, BESM_MEM_XTS);
             (void)i; // reg=0, addr=0 → XTS mem[C+0]
         }
     } else {
@@ -181,7 +190,7 @@ void emit_arith_val(Besm_Block *b, Besm_Instr **t, Besm_InstrKind kind, const Fr
             emit_arith(b, t, kind, reg, off);
         } else {
             Besm_Instr *utc = emit(b, t, BESM_MOD_UTC);
-            utc->name       = xstrdup(v->u.var_name);
+            set_sym_name(utc, v->u.var_name);
             emit(b, t, kind); // reg=0, addr=0 → op mem[C+0]
         }
     } else {
@@ -96,8 +96,8 @@ static void bemsh_format_real(char *buf, size_t n, double val)
 
 // Encode a C double as a native BESM-6 48-bit floating-point word (see
 // docs/Besm6_Data_Representation.md §6): bits 48-42 = 7-bit exponent biased by 64, bit 41 =
-// sign, bits 40-1 = 40-bit two's-complement mantissa.  Copied from emit_unix.c's
-// unix_real_word so the two emitters stay decoupled; used only for the octal fallback below.
+// sign, bits 40-1 = 40-bit two's-complement mantissa.  Copied from besm_const.c's
+// besm_real_word so this emitter stays self-contained; used only for the octal fallback below.
 static uint64_t bemsh_real_word(double v)
 {
     if (v == 0.0)
@@ -177,7 +177,8 @@ static const struct {
     { "b$fgt", "_fgt" },     { "b$fge", "_fge" },     { "b$dtoi", "_dtoi" },
     { "b$dtou", "_dtou" },   { "b$utod", "_utod" },   { "b$padd", "_padd" },
     { "b$pinc", "_pinc" },   { "b$pdec", "_pdec" },   { "b$pdiff", "_pdiff" },
-    { "b$stb", "_stb" },     { "b$tout", "_tout" },
+    { "b$stb", "_stb" },     { "b$tout", "_tout" },   { "b$divmod", "_divmd" },
+    { "b$udivmod", "_udvmd" },
 };
 
 // Mangle a name into a valid Bemsh label: ≤6 chars, begins with a letter (a leading `_`
@@ -1,5 +1,4 @@
 #include <inttypes.h>
-#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -7,42 +6,6 @@
 #include "besm.h"
 #include "internal.h"
 
-// Encode a C double as a native BESM-6 48-bit floating-point word (see
-// docs/Besm6_Data_Representation.md §6): bits 48-42 = 7-bit exponent biased by 64, bit 41 =
-// sign, bits 40-1 = 40-bit two's-complement mantissa.  b6as has no floating-point literal
-// syntax, so the Unix emitter renders every real as its octal bit pattern.
-static uint64_t unix_real_word(double v)
-{
-    if (v == 0.0)
-        return 0; // machine zero is the all-zero word
-
-    int e2;
-    double f = frexp(v, &e2); // v = f * 2^e2, with 0.5 <= |f| < 1
-    // A 41-bit two's-complement value T (bit 41 = sign, bits 40-1 = mantissa) with
-    // T / 2^40 = f gives value = (T / 2^40) * 2^e2, i.e. biased exponent E = e2 + 64.
-    int64_t T = llround(ldexp(f, 40));
-    int E     = e2 + 64;
-    if (T >= (INT64_C(1) << 40)) {
-        // f rounded up to 1.0 (fraction not representable): renormalize.
-        T >>= 1;
-        E++;
-    }
-    // BESM-6 normalization requires the sign bit (41) to differ from bit 40.  frexp's
-    // magnitude is [0.5, 1); a negative exact half (f == -0.5, T == -2^39) has bit 41 ==
-    // bit 40 — un-normalized.  Renormalize to mantissa -1.0 (T == -2^40, one lower
-    // exponent) so the bit pattern matches the hardware / Madlen assembler
-    // (e.g. -1.0 = 0x810000000000, not 0x838000000000).
-    if (T == -(INT64_C(1) << 39)) {
-        T = -(INT64_C(1) << 40); // T * 2, one lower exponent
-        E--;
-    }
-    if (E < 1 || E > 127)
-        fatal_error("floating constant %g out of BESM-6 exponent range", v);
-
-    uint64_t mant = (uint64_t)T & ((UINT64_C(1) << 41) - 1); // bits 41-1
-    return ((uint64_t)E << 41) | mant;
-}
-
 //
 // Unix (b6as) assembler emitter.  Renders the dialect-agnostic Besm_Module in the
 // AT&T-style syntax accepted by b6as (docs/Besm6_Unix_Assembler.md): segment directives
@@ -146,7 +109,7 @@ static void unix_operand(char *buf, size_t n, const Besm_Instr *i)
 {
     if (i->konst) {
         Besm_ConstWord w = besm_const_word(i->konst);
-        uint64_t word    = w.is_real ? unix_real_word(w.real_val) : w.word;
+        uint64_t word    = w.is_real ? besm_real_word(w.real_val) : w.word;
         snprintf(buf, n, "#%s%" PRIo64, unix_octal_prefix(word), word);
         return;
     }
@@ -324,7 +287,7 @@ static const Besm_Instr *emit_unix_special(FILE *out, const Besm_Instr *instr, S
         set_segment(out, cur, SEG_DATA);
         if (instr->name)
             emit_ulabel(out, instr->name);
-        uint64_t word = unix_real_word(instr->real_val);
+        uint64_t word = besm_real_word(instr->real_val);
         snprintf(a, sizeof(a), "%s%" PRIo64, unix_octal_prefix(word), word);
         emit_udir(out, ".word", a);
         break;
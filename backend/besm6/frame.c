@@ -17,9 +17,11 @@
 #define SLOT_TEMP(v) ((((int)(v)) >> 20) & 1)
 
 struct Frame {
-    StringMap slots;     // name -> SLOT_ENCODE(reg, offset, temp)
+    StringMap slots;            // name -> SLOT_ENCODE(reg, offset, temp)
+    StringMap temp_refs;        // temporary name -> number of operands naming it
     int num_autos;
-    bool *auto_is_temp;  // size num_autos; true if that auto slot holds a '%'+digit temporary
+    bool *auto_is_temp;         // size num_autos; true if that auto slot holds a '%'+digit temp
+    const StringMap *unslotted; // while building: the temporaries to give no slot, or NULL
 };
 
 // A TAC name denotes a compiler temporary (new_temp) when it is '%' followed by a digit;
@@ -41,6 +43,8 @@ static void assign_if_new(Frame *f, const char *name, int reg, int *counter)
     intptr_t dummy;
     if (map_get(&f->slots, name, &dummy))
         return; // already assigned (e.g. a parameter)
+    if (f->unslotted && map_get(f->unslotted, name, &dummy))
+        return; // kept off the frame by the caller
     map_insert(&f->slots, name, SLOT_ENCODE(reg, *counter, name_is_temp(name)), 0);
     (*counter)++;
 }
@@ -51,8 +55,14 @@ static void assign_if_new(Frame *f, const char *name, int reg, int *counter)
 static void collect_vals(Frame *f, const Tac_Val *v, int *auto_count)
 {
     for (; v; v = v->next) {
-        if (v->kind == TAC_VAL_VAR)
-            assign_if_new(f, v->u.var_name, REG_AUTO, auto_count);
+        if (v->kind != TAC_VAL_VAR)
+            continue;
+        assign_if_new(f, v->u.var_name, REG_AUTO, auto_count);
+        if (name_is_temp(v->u.var_name)) {
+            intptr_t refs = 0;
+            map_get(&f->temp_refs, v->u.var_name, &refs);
+            map_insert(&f->temp_refs, v->u.var_name, refs + 1, 0);
+        }
     }
 }
 
@@ -209,6 +219,10 @@ static void collect_instr(Frame *f, const Tac_Instruction *instr, int *auto_coun
         assign_if_new(f, instr->u.copy_from_offset.src, REG_AUTO, auto_count);
         collect_vals(f, instr->u.copy_from_offset.dst, auto_count);
         break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        collect_vals(f, instr->u.block_copy.src_ptr, auto_count);
+        collect_vals(f, instr->u.block_copy.dst_ptr, auto_count);
+        break;
     case TAC_INSTRUCTION_JUMP:
     case TAC_INSTRUCTION_LABEL:
         break; // no values
@@ -271,13 +285,21 @@ static void fill_auto_is_temp(const char *key, intptr_t value, const void *arg)
 }
 
 Frame *frame_build(const Tac_TopLevel *fn, const Tac_TopLevel *program)
+{
+    return frame_build_unslotted(fn, program, NULL);
+}
+
+Frame *frame_build_unslotted(const Tac_TopLevel *fn, const Tac_TopLevel *program,
+                             const StringMap *unslotted)
 {
     (void)program; // local/global is now encoded in the name (leading '%')
 
     Frame *f         = (Frame *)xalloc(sizeof(Frame), __func__, __FILE__, __LINE__);
     f->num_autos     = 0;
     f->auto_is_temp  = NULL;
+    f->unslotted     = unslotted;
     map_init(&f->slots);
+    map_init(&f->temp_refs);
 
     // Assign params first (REG_PAR, 0..N-1). Param names are '%'-prefixed too, but a
     // parameter is never a compiler temporary.
@@ -308,6 +330,7 @@ Frame *frame_build(const Tac_TopLevel *fn, const Tac_TopLevel *program)
         TempFill tf = { f->auto_is_temp, f->num_autos };
         map_iterate(&f->slots, fill_auto_is_temp, &tf);
     }
+    f->unslotted = NULL;
 
     return f;
 }
@@ -327,6 +350,13 @@ bool frame_lookup(const Frame *f, const char *name, int *reg, int *offset)
     return true;
 }
 
+int frame_temp_refs(const Frame *f, const char *name)
+{
+    intptr_t refs = 0;
+    map_get(&f->temp_refs, name, &refs);
+    return (int)refs;
+}
+
 int frame_num_autos(const Frame *f)
 {
     return f->num_autos;
@@ -335,6 +365,7 @@ int frame_num_autos(const Frame *f)
 void frame_free(Frame *f)
 {
     map_destroy(&f->slots);
+    map_destroy(&f->temp_refs);
     if (f->auto_is_temp)
         xfree(f->auto_is_temp);
     xfree(f);
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 
+#include "string_map.h"
 #include "tac.h"
 
 #ifdef __cplusplus
@@ -30,6 +31,11 @@ typedef struct Frame Frame;
 // not assigned auto slots.
 Frame *frame_build(const Tac_TopLevel *fn, const Tac_TopLevel *program);
 
+// Build the frame giving no slot to the temporaries in `unslotted`, which the caller keeps
+// elsewhere (see stack.c); frame_build is this with none.
+Frame *frame_build_unslotted(const Tac_TopLevel *fn, const Tac_TopLevel *program,
+                             const StringMap *unslotted);
+
 // Look up a variable name. Returns true and fills *reg and *offset on hit.
 bool frame_lookup(const Frame *f, const char *name, int *reg, int *offset);
 
@@ -40,6 +46,11 @@ int frame_num_autos(const Frame *f);
 // peephole pass to limit dead-store elimination to never-aliased temporaries.
 bool frame_slot_is_temp(const Frame *f, int reg, int off);
 
+// Number of operands in the function body that name the '%'+digit temporary `name`,
+// definitions included; 0 for any other name.  A temporary named exactly twice, by the
+// instruction that defines it and by the one that reads it, has no other use.
+int frame_temp_refs(const Frame *f, const char *name);
+
 void frame_free(Frame *f);
 
 #ifdef __cplusplus
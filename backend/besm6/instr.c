@@ -4,6 +4,7 @@
 
 #include "abi.h"
 #include "besm.h"
+#include "codegen.h"
 #include "frame.h"
 #include "internal.h"
 #include "tac.h"
@@ -67,6 +68,174 @@ static void emit_member_fatptr(Besm_Block *block, Besm_Instr **tail, const Frame
     aox->name       = xstrdup(fat_marker_const(byte_num)); // marker + offset_enc
 }
 
+// Local labels of the sequences that branch within themselves: `%P<n>$<function>`,
+// numbered afresh in each function.  The function's name keeps them apart in a Unix file,
+// where the modules share one namespace; the number comes first, so that Madlen's
+// 8-character truncation cannot merge two labels of one module.
+static const char *label_function;
+static int label_count;
+
+void codegen_function_begin(const char *name)
+{
+    label_function = name;
+    label_count    = 0;
+}
+
+char *new_local_label(void)
+{
+    size_t len  = strlen(label_function) + 16;
+    char *label = xalloc(len, __func__, __FILE__, __LINE__);
+    snprintf(label, len, "%%P%d$%s", ++label_count, label_function);
+    return label;
+}
+
+static void emit_branch(Besm_Block *block, Besm_Instr **tail, Besm_InstrKind kind,
+                        const char *label)
+{
+    Besm_Instr *br = emit(block, tail, kind);
+    br->name       = xstrdup(label);
+}
+
+static void emit_label(Besm_Block *block, Besm_Instr **tail, char *label)
+{
+    Besm_Instr *lbl = emit(block, tail, BESM_STMT_LABEL);
+    lbl->name       = label; // takes ownership
+}
+
+static void emit_literal_op(Besm_Block *block, Besm_Instr **tail, Besm_InstrKind kind,
+                            const char *literal)
+{
+    Besm_Instr *op = emit(block, tail, kind);
+    op->name       = xstrdup(literal);
+}
+
+// A = ptr + 1 for a char* fat pointer, inline (--speed): the body of b/pinc without the
+// call.  Stepping back the offset code is stepping back the exponent by 8, which keeps the
+// marker (bit 48) for offset_enc 1..5; the marker drops out, and ω of the multiplicative
+// mode E-N leaves says so, only when the byte was the last of its word.  A marker-clear
+// operand underflows to zero and takes the same path, as it does in the helper:
+//   xta p  /  e-n 64+8  /  uza done  /  xta p  /  aax =77777  /  arx =1  /  aox =:64
+//   done:
+static void emit_pinc_inline(Besm_Block *block, Besm_Instr **tail, const Frame *f,
+                             const Tac_Val *ptr)
+{
+    char *done = new_local_label();
+    emit_xta_val(block, tail, f, ptr);
+    Besm_Instr *esub = emit(block, tail, BESM_EXP_ESUBN);
+    esub->addr       = 64 + 8; // offset_enc - 1
+    emit_branch(block, tail, BESM_BRANCH_UZA, done); // marker kept: same word
+    emit_xta_val(block, tail, f, ptr);
+    emit_literal_op(block, tail, BESM_LOG_AAX, "=77777"); // word address
+    emit_literal_op(block, tail, BESM_LOG_ARX, "=1");     // the next word
+    emit_literal_op(block, tail, BESM_LOG_AOX, "=:64");   // marker + offset_enc 5 (MSB)
+    emit_label(block, tail, done);
+}
+
+// A = ptr - 1 for a char* fat pointer, inline (--speed): the body of b/pdec.  An exponent
+// lowered by 40 keeps the marker only for offset_enc 5, the first byte of a word, which
+// wraps to the last byte of the word before; any other offset, marker-clear included,
+// steps the exponent up by 8:
+//   xta p  /  e-n 64+40  /  u1a step
+//   xta p  /  aax =77777  /  arx =-1  /  aax =77777  /  aox =:40  /  uj done
+//   step:  xta p  /  e+n 64+8  /  aox =:40
+//   done:
+static void emit_pdec_inline(Besm_Block *block, Besm_Instr **tail, const Frame *f,
+                             const Tac_Val *ptr)
+{
+    char *step = new_local_label();
+    char *done = new_local_label();
+    emit_xta_val(block, tail, f, ptr);
+    Besm_Instr *esub = emit(block, tail, BESM_EXP_ESUBN);
+    esub->addr       = 64 + 40;
+    emit_branch(block, tail, BESM_BRANCH_U1A, step); // marker gone: offset_enc < 5
+    emit_xta_val(block, tail, f, ptr);
+    emit_literal_op(block, tail, BESM_LOG_AAX, "=77777");
+    emit_literal_op(block, tail, BESM_LOG_ARX, "=7777777777777776"); // word - 1, end-around
+    emit_literal_op(block, tail, BESM_LOG_AAX, "=77777");
+    emit_literal_op(block, tail, BESM_LOG_AOX, "=:40"); // marker + offset_enc 0 (LSB)
+    emit_branch(block, tail, BESM_BRANCH_UJ, done);
+    emit_label(block, tail, step);
+    emit_xta_val(block, tail, f, ptr);
+    Besm_Instr *eadd = emit(block, tail, BESM_EXP_EADDN);
+    eadd->addr       = 64 + 8;                          // offset_enc + 1
+    emit_literal_op(block, tail, BESM_LOG_AOX, "=:40"); // the marker, for a bare address
+    emit_label(block, tail, done);
+}
+
+// *ptr = src for a char* fat pointer, inline (--speed): a read-modify-write that flips
+// the bits in which the target byte differs from the new value, so no byte mask is
+// needed.  The pointer's exponent 64+8*enc shifts the byte down, as for a byte load, and
+// a word of exponent 64-8*enc, made from it and pushed, shifts the difference back up:
+//   xta =:40  /  e-x p  /  15 atx         — push the left-shift count
+//   xta p  /  ati 14  /  14 xta           — A = the containing word W
+//   asx p  /  aex src  /  aax =377        — A = (byte of W) ^ src
+//   15 asx  /  14 aex  /  14 atx          — W ^= A << 8*enc
+// As with the inline byte load, the pointer must carry the marker.
+static void emit_stb_inline(Besm_Block *block, Besm_Instr **tail, const Frame *f,
+                            const Tac_Val *ptr, const Tac_Val *src)
+{
+    emit_literal_op(block, tail, BESM_MEM_XTA, "=:40"); // exponent 64, zero mantissa
+    emit_arith_val(block, tail, BESM_EXP_ESUBX, f, ptr);
+    emit_atx(block, tail, REG_SP, 0); // push
+    emit_xta_val(block, tail, f, ptr);
+    Besm_Instr *ati = emit(block, tail, BESM_MEM_ATI);
+    ati->addr       = REG_SCRATCH; // r14 = word address
+    emit_xta(block, tail, REG_SCRATCH, 0);
+    emit_asx_ptr(block, tail, f, ptr->u.var_name);
+    emit_arith_val(block, tail, BESM_LOG_AEX, f, src);
+    emit_literal_op(block, tail, BESM_LOG_AAX, "=377");
+    Besm_Instr *asx = emit(block, tail, BESM_EXP_SHIFTX);
+    asx->reg        = REG_SP; // pop the count
+    Besm_Instr *aex = emit(block, tail, BESM_LOG_AEX);
+    aex->reg        = REG_SCRATCH;
+    emit_atx(block, tail, REG_SCRATCH, 0);
+}
+
+// UTC to a word of a module-level name, so that the next instruction reaches it whatever
+// its address (see emit_xta_val).
+static void emit_utc_name(Besm_Block *block, Besm_Instr **tail, const char *name, int off)
+{
+    Besm_Instr *utc = emit(block, tail, BESM_MOD_UTC);
+    set_sym_name(utc, name);
+    utc->addr = off;
+}
+
+// WTC of a pointer variable, then a UTC of `off` words unless it is 0: C points `off` words
+// past where the pointer does.
+static void emit_wtc_ptr_at(Besm_Block *block, Besm_Instr **tail, const Frame *f,
+                            const char *name, int off)
+{
+    emit_wtc_ptr(block, tail, f, name);
+    if (off != 0) {
+        Besm_Instr *utc = emit(block, tail, BESM_MOD_UTC);
+        utc->addr       = off;
+    }
+}
+
+void codegen_count_call(const char *counter, Besm_Block *block, Besm_Instr **tail)
+{
+    char *done = new_local_label();
+    emit_utc_name(block, tail, counter, 0);
+    emit(block, tail, BESM_MEM_XTA);
+    emit_literal_op(block, tail, BESM_ARITH_ADD, "=1");
+    emit_utc_name(block, tail, counter, 0);
+    emit(block, tail, BESM_MEM_ATX);
+    emit_literal_op(block, tail, BESM_LOG_AEX, "=1");
+    emit_branch(block, tail, BESM_BRANCH_U1A, done); // counted before: registered
+    emit_utc_name(block, tail, BESM_CALL_COUNTS, 0);
+    emit(block, tail, BESM_MEM_XTA);
+    emit_utc_name(block, tail, counter, 1);
+    emit(block, tail, BESM_MEM_ATX);
+    Besm_Instr *vtm = emit(block, tail, BESM_REG_VTM);
+    vtm->reg        = REG_SCRATCH;
+    vtm->name       = xstrdup(counter);
+    Besm_Instr *ita = emit(block, tail, BESM_MEM_ITA);
+    ita->addr       = REG_SCRATCH;
+    emit_utc_name(block, tail, BESM_CALL_COUNTS, 0);
+    emit(block, tail, BESM_MEM_ATX);
+    emit_label(block, tail, done);
+}
+
 // Emit a binary op that lowers to a runtime helper:  dst = helper(src1, src2).
 //
 // Used by the integer comparisons (b/eq, b/ne, b/lt, b/le, b/gt, b/ge and the unsigned
@@ -113,6 +282,112 @@ static void emit_unary_helper(Besm_Block *b, Besm_Instr **t, const Frame *f, con
     emit_atx(b, t, dr, doff);
 }
 
+// Compare and branch: an integer comparison whose only use is the conditional jump right
+// after it.  The branch needs ω, not a 0/1 word, so the comparison is done inline and the
+// jump tests the ω it leaves — no helper call and return, no boolean stored and reloaded.
+//
+//   ==, !=    XTA a / AEX b            logical ω: a ^ b ≠ 0        true: UZA / U1A
+//   <, >=     XTA a / A-X b            additive ω: a - b < 0       true: U1A / UZA
+//   >, <=     XTA a / X-A b            additive ω: b - a < 0       true: U1A / UZA
+//
+// These are the operations b/eq .. b/ge perform on the same operands, so the 41-bit signed
+// semantics do not change; AEX compares all 48 bits, so == and != also serve unsigned and
+// floating-point operands (FP equality is bit equality, as in b/eq).  The unsigned
+// orderings inline the body of b/ult, which picks the bit of y at the highest position
+// where x and y differ — 1 exactly when x < y over the whole 48-bit word:
+//
+//   XTA x / XTS y / 15 AEX / 15 ATX / YTA / 15 APX / ASN 64+47     true: U1A
+//
+// with x < y for <, and ≥ as its negation; > and ≤ swap the operands.  The FP orderings
+// keep their helpers: they run under a different R mode (NTR) and restore it on return.
+//
+bool codegen_compare_branch(const Tac_Instruction *instr, const Frame *f, Besm_Block *block,
+                            Besm_Instr **tail)
+{
+    const Tac_Instruction *jump = instr->next;
+    if (instr->kind != TAC_INSTRUCTION_BINARY || !jump ||
+        (jump->kind != TAC_INSTRUCTION_JUMP_IF_ZERO &&
+         jump->kind != TAC_INSTRUCTION_JUMP_IF_NOT_ZERO))
+        return false;
+
+    // The jump must read the comparison's result and nothing else may.  (JUMP_IF_ZERO and
+    // JUMP_IF_NOT_ZERO share the {condition, target} layout.)
+    const Tac_Val *dst  = instr->u.binary.dst;
+    const Tac_Val *cond = jump->u.jump_if_zero.condition;
+    if (cond->kind != TAC_VAL_VAR || cond->u.var_name != dst->u.var_name ||
+        frame_temp_refs(f, dst->u.var_name) != 2)
+        return false;
+
+    const Tac_Val *x = instr->u.binary.src1;
+    const Tac_Val *y = instr->u.binary.src2;
+    Besm_InstrKind op;
+    bool true_if_nonzero; // does ω = 1 mean the comparison holds?
+    switch (instr->u.binary.op) {
+    case TAC_BINARY_EQUAL:
+        op              = BESM_LOG_AEX;
+        true_if_nonzero = false;
+        break;
+    case TAC_BINARY_NOT_EQUAL:
+        op              = BESM_LOG_AEX;
+        true_if_nonzero = true;
+        break;
+    case TAC_BINARY_LESS_THAN:
+        op              = BESM_ARITH_SUB;
+        true_if_nonzero = true;
+        break;
+    case TAC_BINARY_GREATER_OR_EQUAL:
+        op              = BESM_ARITH_SUB;
+        true_if_nonzero = false;
+        break;
+    case TAC_BINARY_GREATER_THAN:
+        op              = BESM_ARITH_RSUB;
+        true_if_nonzero = true;
+        break;
+    case TAC_BINARY_LESS_OR_EQUAL:
+        op              = BESM_ARITH_RSUB;
+        true_if_nonzero = false;
+        break;
+    case TAC_BINARY_LESS_THAN_UNSIGNED:
+    case TAC_BINARY_GREATER_OR_EQUAL_UNSIGNED:
+    case TAC_BINARY_GREATER_THAN_UNSIGNED:
+    case TAC_BINARY_LESS_OR_EQUAL_UNSIGNED:
+        op              = BESM_LOG_APX;
+        true_if_nonzero = instr->u.binary.op == TAC_BINARY_LESS_THAN_UNSIGNED ||
+                          instr->u.binary.op == TAC_BINARY_GREATER_THAN_UNSIGNED;
+        if (instr->u.binary.op == TAC_BINARY_GREATER_THAN_UNSIGNED ||
+            instr->u.binary.op == TAC_BINARY_LESS_OR_EQUAL_UNSIGNED) {
+            x = instr->u.binary.src2;
+            y = instr->u.binary.src1;
+        }
+        break;
+    default:
+        return false;
+    }
+
+    emit_xta_val(block, tail, f, x);
+    if (op == BESM_LOG_APX) {
+        emit_xts_val(block, tail, f, y);
+        Besm_Instr *diff = emit(block, tail, BESM_LOG_AEX); // A = x ^ y, Y = y
+        diff->reg        = REG_SP;
+        Besm_Instr *push = emit(block, tail, BESM_MEM_ATX);
+        push->reg        = REG_SP;
+        emit(block, tail, BESM_EXP_YTA);                    // A = y
+        Besm_Instr *pack = emit(block, tail, BESM_LOG_APX); // the bits of y where x ≠ y
+        pack->reg        = REG_SP;
+        Besm_Instr *top  = emit(block, tail, BESM_EXP_SHIFTN);
+        top->addr        = 64 + 47; // A = the highest of them
+    } else {
+        emit_arith_val(block, tail, op, f, y);
+    }
+
+    // Jump if zero branches when the comparison fails.
+    if (jump->kind == TAC_INSTRUCTION_JUMP_IF_ZERO)
+        true_if_nonzero = !true_if_nonzero;
+    Besm_Instr *branch = emit(block, tail, true_if_nonzero ? BESM_BRANCH_U1A : BESM_BRANCH_UZA);
+    branch->name       = xstrdup(jump->u.jump_if_zero.target);
+    return true;
+}
+
 // Extract the integer value of an integer constant (used for constant shift counts).
 static long tac_const_int(const Tac_Const *c)
 {
@@ -155,6 +430,172 @@ static int tac_const_log2(const Tac_Val *v)
     return k;
 }
 
+// The divisor of a signed divide or remainder selected inline (--speed): a positive constant
+// below 2^40, where the FP unit holds every integer exactly; 0 when the helper is called.
+static long inline_divisor(const Tac_Val *v)
+{
+    if (!besm_codegen_options.speed || v->kind != TAC_VAL_CONSTANT)
+        return 0;
+    long d = tac_const_int(v->u.constant);
+    return d > 0 && d < (1L << 40) ? d : 0;
+}
+
+// The reciprocal of the divisor d rounded up to the 40-bit mantissa, m / 2^e with
+// m = ceil(2^e / d) normalized, as a native word; false when a multiply by it does not floor
+// every quotient.  |a| * m / 2^e exceeds |a| / d by |a| * (m*d - 2^e) / (d * 2^e), which
+// stays below 1/d, and so never reaches the next integer, for every |a| < 2^40 exactly when
+// (m*d - 2^e) * 2^40 < 2^e.  About half of all divisors pass, 3, 5, 10 and 100 among them.
+static bool divisor_reciprocal(long d, uint64_t *word)
+{
+    int k = 0;
+    while ((1L << k) < d)
+        k++;
+    int e                = 39 + k; // 2^39 <= m < 2^40
+    unsigned __int128 p  = (unsigned __int128)1 << e;
+    uint64_t m           = (uint64_t)((p + (unsigned __int128)d - 1) / (unsigned __int128)d);
+    unsigned __int128 md = (unsigned __int128)m * (unsigned __int128)d;
+    if ((md - p) << 40 >= p)
+        return false;
+    *word = ((uint64_t)(104 - e) << 41) | m; // value m * 2^(E-64-40), E = 104 - e
+    return true;
+}
+
+// Signed divide or remainder by a constant d (--speed), inline instead of b/div or b/mod.
+// The sequence is the helper's with the divisor known: |a| in INT-format is multiplied by the
+// reciprocal of d, or divided by d when no reciprocal floors exactly (see
+// divisor_reciprocal), and the integer part of the product is |q|.  With normalization on
+// and rounding off, the product never rounds up past an integer, and re-aligning to the INT
+// exponent under R=3 drops the fraction.  The remainder multiplies |q| back by d and takes it
+// from |a|, pushed for it; the dividend's sign goes on last, as C truncates toward zero.
+//
+//   xta a  /  ntr 2  /  aox =:64  /  avx a  /  [15 atx]  /  a*x =1/d (or a/x =d)
+//   ntr 3  /  a+x =:64                                        — |q|
+//   [ntr 2  /  a*x =d:64  /  15 x-a  /  ntr 3  /  a+x =:64]    — |r| = |a| - |q|*d
+//   avx a  /  aax =37777777777777
+//
+// Like the helpers it ends with R=3 and ω logical.
+static void emit_const_divide(Besm_Block *b, Besm_Instr **t, const Frame *f, const Tac_Val *src1,
+                              long d, bool remainder, int dr, int doff)
+{
+    char buf[32];
+    uint64_t recip;
+    bool multiply = divisor_reciprocal(d, &recip);
+
+    emit_xta_val(b, t, f, src1);
+    Besm_Instr *ntr = emit(b, t, BESM_EXP_SETR);
+    ntr->addr       = 2;                            // normalize, do not round
+    emit_literal_op(b, t, BESM_LOG_AOX, "=:64");    // INT-format a
+    emit_arith_val(b, t, BESM_ARITH_CNEG, f, src1); // |a|, normalized
+    if (remainder) {
+        Besm_Instr *push = emit(b, t, BESM_MEM_ATX);
+        push->reg        = REG_SP;
+    }
+    if (multiply)
+        snprintf(buf, sizeof(buf), "=%llo", (unsigned long long)recip);
+    else
+        snprintf(buf, sizeof(buf), "=%llo", (unsigned long long)besm_real_word((double)d));
+    emit_literal_op(b, t, multiply ? BESM_ARITH_MUL : BESM_ARITH_DIV, buf);
+    ntr       = emit(b, t, BESM_EXP_SETR);
+    ntr->addr = 3;
+    emit_literal_op(b, t, BESM_ARITH_ADD, "=:64"); // truncate to the integer |q|
+    if (remainder) {
+        ntr       = emit(b, t, BESM_EXP_SETR);
+        ntr->addr = 2;
+        snprintf(buf, sizeof(buf), "=%llo", (unsigned long long)((UINT64_C(0150) << 41) | d));
+        emit_literal_op(b, t, BESM_ARITH_MUL, buf);    // |q| * d
+        Besm_Instr *sub = emit(b, t, BESM_ARITH_RSUB); // pop |a|: |a| - |q| * d
+        sub->reg        = REG_SP;
+        ntr             = emit(b, t, BESM_EXP_SETR);
+        ntr->addr       = 3;
+        emit_literal_op(b, t, BESM_ARITH_ADD, "=:64");
+    }
+    emit_arith_val(b, t, BESM_ARITH_CNEG, f, src1); // the sign of a
+    emit_literal_op(b, t, BESM_LOG_AAX, "=37777777777777");
+    emit_atx(b, t, dr, doff);
+}
+
+// The runtime helper a binary operation calls, under the convention of emit_binop_helper, or
+// NULL when it has an inline sequence.
+//
+// Comparisons lower to a relational helper, unless one only decides the jump after it (see
+// codegen_compare_branch).  b/eq/b/ne are signedness-independent, and FP ==/!= are pure bit
+// equality, so they serve every type.  The FP orderings mirror the integer b/lt..b/ge but
+// bracket the subtract with NTR so the additive sign reflects the FP difference (equal
+// operands normalize to an exact zero).
+//
+// Unsigned add and subtract cannot use the inline additive unit: full 48-bit unsigned values
+// carry data in the exponent field (bits 48-42), which A+X misreads.  b/uadd and b/usub do
+// true 48-bit modular arithmetic via 24-bit half-words with explicit carry.
+//
+// Multiply uses b/mul (the inline A*X needs FP normalization and INT-format bridging, which
+// the helper encapsulates); b/umul forms the full 48-bit low product via operand splitting,
+// without the signed 41-bit truncation b/mul applies.  Signed divide and remainder use
+// b/div / b/mod, which bridge raw operands to INT-format, FP-divide the absolute values,
+// correct the exponent and reapply the sign (b/mod = a - (a/b)*b).  That FP bridge is wrong
+// for unsigned operands >= 2^40 or with bit 48 set, so b/udiv does an integer long division
+// over the full 48-bit word and b/umod computes a - (a/b)*b from it.  A multiply by a
+// constant power of two, and an unsigned divide or remainder by one, are strength-reduced
+// to a shift or a mask instead; with --speed a signed divide or remainder by a positive
+// constant is selected inline (see emit_const_divide).
+//
+const char *binop_helper(const Tac_Instruction *instr)
+{
+    const Tac_Val *src1 = instr->u.binary.src1;
+    const Tac_Val *src2 = instr->u.binary.src2;
+    switch (instr->u.binary.op) {
+    case TAC_BINARY_EQUAL:
+        return "b$eq";
+    case TAC_BINARY_NOT_EQUAL:
+        return "b$ne";
+    case TAC_BINARY_LESS_THAN:
+        return "b$lt";
+    case TAC_BINARY_LESS_OR_EQUAL:
+        return "b$le";
+    case TAC_BINARY_GREATER_THAN:
+        return "b$gt";
+    case TAC_BINARY_GREATER_OR_EQUAL:
+        return "b$ge";
+    case TAC_BINARY_LESS_THAN_UNSIGNED:
+        return "b$ult";
+    case TAC_BINARY_LESS_OR_EQUAL_UNSIGNED:
+        return "b$ule";
+    case TAC_BINARY_GREATER_THAN_UNSIGNED:
+        return "b$ugt";
+    case TAC_BINARY_GREATER_OR_EQUAL_UNSIGNED:
+        return "b$uge";
+    case TAC_BINARY_LESS_THAN_DOUBLE:
+        return "b$flt";
+    case TAC_BINARY_LESS_OR_EQUAL_DOUBLE:
+        return "b$fle";
+    case TAC_BINARY_GREATER_THAN_DOUBLE:
+        return "b$fgt";
+    case TAC_BINARY_GREATER_OR_EQUAL_DOUBLE:
+        return "b$fge";
+    case TAC_BINARY_ADD_UNSIGNED:
+        return "b$uadd";
+    case TAC_BINARY_SUBTRACT_UNSIGNED:
+        return "b$usub";
+    case TAC_BINARY_MULTIPLY:
+        if (tac_const_log2(src1) >= 0 || tac_const_log2(src2) >= 0)
+            return NULL;
+        return "b$mul";
+    case TAC_BINARY_MULTIPLY_UNSIGNED:
+        if (tac_const_log2(src1) >= 0 || tac_const_log2(src2) >= 0)
+            return NULL;
+        return "b$umul";
+    case TAC_BINARY_DIVIDE:
+        return inline_divisor(src2) ? NULL : "b$div";
+    case TAC_BINARY_REMAINDER:
+        return inline_divisor(src2) ? NULL : "b$mod";
+    case TAC_BINARY_DIVIDE_UNSIGNED:
+        return tac_const_log2(src2) >= 0 ? NULL : "b$udiv";
+    case TAC_BINARY_REMAINDER_UNSIGNED:
+        return tac_const_log2(src2) >= 0 ? NULL : "b$umod";
+    default:
+        return NULL;
+    }
+}
+
 // Emit a shift:  dst = src1 << src2  (left) or  dst = src1 >> src2  (right).
 //
 // Shifts are logical for both int and unsigned, and right-shift does no sign extension.
@@ -340,7 +781,11 @@ void codegen_instr(const Tac_Instruction *instr, const Frame *f, Besm_Block *blo
             // ORs the new byte into place, and writes the word back; r15 is unchanged.
             // The pointer may be frame-local or a module-level global, so load it with
             // emit_xta_val (global-safe: UTC name + XTA for a global, a plain frame XTA
-            // otherwise).
+            // otherwise).  With --speed the read-modify-write is selected inline instead.
+            if (besm_codegen_options.speed) {
+                emit_stb_inline(block, tail, f, instr->u.store.dst_ptr, instr->u.store.src);
+                break;
+            }
             emit_xta_val(block, tail, f, instr->u.store.dst_ptr); // A = fat pointer (a)
             emit_xts_val(block, tail, f, instr->u.store.src);     // push a; A = value (b)
             Besm_Instr *call = emit(block, tail, BESM_BRANCH_CALL);
@@ -453,80 +898,10 @@ void codegen_instr(const Tac_Instruction *instr, const Frame *f, Besm_Block *blo
         int rd, od;
         lookup(f, dst->u.var_name, &rd, &od);
 
-        // Comparisons lower to a runtime relational helper.  The unsigned ordering ops
-        // temporarily reuse the signed helpers (correct within the 41-bit signed range)
-        // until the b/ult/b/ule/b/ugt/b/uge library lands (TODO: task #20).  b/eq/b/ne
-        // are signedness-independent.
-        const char *cmp_helper = NULL;
-        switch (instr->u.binary.op) {
-        case TAC_BINARY_EQUAL:
-            cmp_helper = "b$eq";
-            break;
-        case TAC_BINARY_NOT_EQUAL:
-            cmp_helper = "b$ne";
-            break;
-        case TAC_BINARY_LESS_THAN:
-            cmp_helper = "b$lt";
-            break;
-        case TAC_BINARY_LESS_OR_EQUAL:
-            cmp_helper = "b$le";
-            break;
-        case TAC_BINARY_GREATER_THAN:
-            cmp_helper = "b$gt";
-            break;
-        case TAC_BINARY_GREATER_OR_EQUAL:
-            cmp_helper = "b$ge";
-            break;
-        case TAC_BINARY_LESS_THAN_UNSIGNED:
-            cmp_helper = "b$ult";
-            break;
-        case TAC_BINARY_LESS_OR_EQUAL_UNSIGNED:
-            cmp_helper = "b$ule";
-            break;
-        case TAC_BINARY_GREATER_THAN_UNSIGNED:
-            cmp_helper = "b$ugt";
-            break;
-        case TAC_BINARY_GREATER_OR_EQUAL_UNSIGNED:
-            cmp_helper = "b$uge";
-            break;
-        // Floating-point orderings.  The FP helpers mirror the integer b/lt..b/ge but
-        // bracket the subtract with NTR so the additive sign reflects the FP difference
-        // (equal operands normalize to an exact zero).  FP ==/!= are pure bit equality,
-        // so they keep using the type-independent b/eq/b/ne above.
-        case TAC_BINARY_LESS_THAN_DOUBLE:
-            cmp_helper = "b$flt";
-            break;
-        case TAC_BINARY_LESS_OR_EQUAL_DOUBLE:
-            cmp_helper = "b$fle";
-            break;
-        case TAC_BINARY_GREATER_THAN_DOUBLE:
-            cmp_helper = "b$fgt";
-            break;
-        case TAC_BINARY_GREATER_OR_EQUAL_DOUBLE:
-            cmp_helper = "b$fge";
-            break;
-        default:
-            break;
-        }
-        if (cmp_helper) {
-            emit_binop_helper(block, tail, f, src1, src2, cmp_helper, rd, od);
-            break;
-        }
-
-        // Unsigned add cannot use the inline additive unit: full 48-bit unsigned values
-        // carry data in the exponent field (bits 48-42), which A+X misreads.  The b/uadd
-        // helper does true 48-bit modular add via 24-bit half-words with explicit carry.
-        // Signed ADD stays inline as A+X below.
-        if (instr->u.binary.op == TAC_BINARY_ADD_UNSIGNED) {
-            emit_binop_helper(block, tail, f, src1, src2, "b$uadd", rd, od);
-            break;
-        }
-
-        // Unsigned subtract has the same exponent-field hazard as unsigned add: A-X
-        // misreads the data in bits 48-42.  The b/usub helper does true 48-bit modular
-        // subtract.  Signed SUBTRACT stays inline as A-X below.
-        if (instr->u.binary.op == TAC_BINARY_SUBTRACT_UNSIGNED) {
-            emit_binop_helper(block, tail, f, src1, src2, "b$usub", rd, od);
+        // Operations with no inline sequence call a runtime helper (see binop_helper).
+        const char *helper = binop_helper(instr);
+        if (helper) {
+            emit_binop_helper(block, tail, f, src1, src2, helper, rd, od);
             break;
         }
 
@@ -544,83 +919,43 @@ void codegen_instr(const Tac_Instruction *instr, const Frame *f, Besm_Block *blo
                 k   = tac_const_log2(src1);
                 var = src2;
             }
-            if (k >= 0) {
-                emit_xta_val(block, tail, f, var);
-                Besm_Instr *asn = emit(block, tail, BESM_EXP_SHIFTN);
-                asn->addr       = 64 - k; // logical left shift by k bits
-                if (instr->u.binary.op == TAC_BINARY_MULTIPLY) {
-                    Besm_Instr *aax = emit(block, tail, BESM_LOG_AAX);
-                    aax->name       = xstrdup("=37777777777777"); // mask to 41 bits
-                }
-                emit_atx(block, tail, rd, od);
-                break;
+            emit_xta_val(block, tail, f, var);
+            Besm_Instr *asn = emit(block, tail, BESM_EXP_SHIFTN);
+            asn->addr       = 64 - k; // logical left shift by k bits
+            if (instr->u.binary.op == TAC_BINARY_MULTIPLY) {
+                Besm_Instr *aax = emit(block, tail, BESM_LOG_AAX);
+                aax->name       = xstrdup("=37777777777777"); // mask to 41 bits
             }
-        }
-
-        // Multiply uses the b/mul runtime helper (the inline A*X needs FP normalization and
-        // INT-format bridging, which the helper encapsulates).  Correct for signed operands.
-        if (instr->u.binary.op == TAC_BINARY_MULTIPLY) {
-            emit_binop_helper(block, tail, f, src1, src2, "b$mul", rd, od);
-            break;
-        }
-
-        // Unsigned multiply uses b/umul, which forms the full 48-bit (low) product over the
-        // entire unsigned range via operand splitting, without the signed 41-bit truncation
-        // b/mul applies.
-        if (instr->u.binary.op == TAC_BINARY_MULTIPLY_UNSIGNED) {
-            emit_binop_helper(block, tail, f, src1, src2, "b$umul", rd, od);
-            break;
-        }
-
-        // Signed divide and remainder use the b/div / b/mod runtime helpers, which bridge
-        // raw operands to INT-format, FP-divide the absolute values, correct the exponent
-        // and reapply the sign (b/mod = a - (a/b)*b).  Correct for signed operands and for
-        // unsigned within the 41-bit range; full 48-bit unsigned divide/remainder use
-        // b/udiv / b/umod below.
-        if (instr->u.binary.op == TAC_BINARY_DIVIDE) {
-            emit_binop_helper(block, tail, f, src1, src2, "b$div", rd, od);
-            break;
-        }
-        if (instr->u.binary.op == TAC_BINARY_REMAINDER) {
-            emit_binop_helper(block, tail, f, src1, src2, "b$mod", rd, od);
+            emit_atx(block, tail, rd, od);
             break;
         }
 
-        // Unsigned divide uses b/udiv.  The signed b/div borrows the hardware FP unit
-        // (40-bit mantissa, bit 48 read as a sign), so it is wrong for unsigned operands
-        // >= 2^40 or with bit 48 set.  b/udiv instead does an integer long division over
-        // the full 48-bit word (divisor-shift / subtract loop).  Strength reduction:
-        // unsigned divide by a constant 2^k is an exact logical right shift by k (unsigned
+        // Unsigned divide by a constant 2^k is an exact logical right shift by k (unsigned
         // is full-48-bit logical, so no sign extension).
         if (instr->u.binary.op == TAC_BINARY_DIVIDE_UNSIGNED) {
-            int k = tac_const_log2(src2);
-            if (k >= 0) {
-                emit_xta_val(block, tail, f, src1);
-                Besm_Instr *asn = emit(block, tail, BESM_EXP_SHIFTN);
-                asn->addr       = 64 + k; // logical right shift by k bits
-                emit_atx(block, tail, rd, od);
-                break;
-            }
-            emit_binop_helper(block, tail, f, src1, src2, "b$udiv", rd, od);
+            emit_xta_val(block, tail, f, src1);
+            Besm_Instr *asn = emit(block, tail, BESM_EXP_SHIFTN);
+            asn->addr       = 64 + tac_const_log2(src2); // logical right shift by k bits
+            emit_atx(block, tail, rd, od);
             break;
         }
 
-        // Unsigned remainder uses b/umod.  The signed b/mod shares b/div's FP bridge and so
-        // is wrong for the same out-of-range unsigned operands.  b/umod computes the full
-        // 48-bit residue as a - (a/b)*b, reusing b/udiv / b/umul / b/usub.  Strength
-        // reduction: unsigned remainder by a constant 2^k is masking the low k bits.
+        // Unsigned remainder by a constant 2^k is masking the low k bits.
         if (instr->u.binary.op == TAC_BINARY_REMAINDER_UNSIGNED) {
-            int k = tac_const_log2(src2);
-            if (k >= 0) {
-                emit_xta_val(block, tail, f, src1);
-                Besm_Instr *aax = emit(block, tail, BESM_LOG_AAX);
-                char buf[32];
-                snprintf(buf, sizeof(buf), "=%lo", (1UL << k) - 1); // mask low k bits
-                aax->name = xstrdup(buf);
-                emit_atx(block, tail, rd, od);
-                break;
-            }
-            emit_binop_helper(block, tail, f, src1, src2, "b$umod", rd, od);
+            emit_xta_val(block, tail, f, src1);
+            Besm_Instr *aax = emit(block, tail, BESM_LOG_AAX);
+            char buf[32];
+            snprintf(buf, sizeof(buf), "=%lo", (1UL << tac_const_log2(src2)) - 1);
+            aax->name = xstrdup(buf); // mask low k bits
+            emit_atx(block, tail, rd, od);
+            break;
+        }
+
+        // Signed divide and remainder by a positive constant, with --speed.
+        if (instr->u.binary.op == TAC_BINARY_DIVIDE ||
+            instr->u.binary.op == TAC_BINARY_REMAINDER) {
+            emit_const_divide(block, tail, f, src1, inline_divisor(src2),
+                              instr->u.binary.op == TAC_BINARY_REMAINDER, rd, od);
             break;
         }
 
@@ -1028,10 +1363,18 @@ void codegen_instr(const Tac_Instruction *instr, const Frame *f, Besm_Block *blo
         // struct-member GET_ADDRESS, marker clear — the helper treats it as byte #0).
         // A constant ±1 delta uses the dedicated b/pinc / b/pdec (no division); any other
         // delta uses b/padd, which distributes the signed byte count across the word
-        // address and the 3-bit offset.
+        // address and the 3-bit offset.  With --speed the ±1 steps are selected inline.
         if (scale == 1) {
             if (index->kind == TAC_VAL_CONSTANT && index->u.constant->kind == TAC_CONST_INT &&
                 (index->u.constant->u.int_val == 1 || index->u.constant->u.int_val == -1)) {
+                if (besm_codegen_options.speed) {
+                    if (index->u.constant->u.int_val == 1)
+                        emit_pinc_inline(block, tail, f, ptr);
+                    else
+                        emit_pdec_inline(block, tail, f, ptr);
+                    emit_atx(block, tail, rd, od);
+                    break;
+                }
                 emit_xta_val(block, tail, f, ptr); // A = fat pointer
                 Besm_Instr *call = emit(block, tail, BESM_BRANCH_CALL);
                 call->name = xstrdup(index->u.constant->u.int_val == 1 ? "b$pinc" : "b$pdec");
@@ -1145,7 +1488,7 @@ void codegen_instr(const Tac_Instruction *instr, const Frame *f, Besm_Block *blo
                 emit_xta(block, tail, br, bo + woff);
             } else {
                 Besm_Instr *utc = emit(block, tail, BESM_MOD_UTC);
-                utc->name       = xstrdup(base);
+                set_sym_name(utc, base);
                 emit_xta(block, tail, 0, woff);
             }
             Besm_Instr *asn = emit(block, tail, BESM_EXP_SHIFTN);
@@ -1168,7 +1511,7 @@ void codegen_instr(const Tac_Instruction *instr, const Frame *f, Besm_Block *blo
             emit_xta(block, tail, br, bo + woff);
         } else {
             Besm_Instr *utc = emit(block, tail, BESM_MOD_UTC);
-            utc->name       = xstrdup(base);
+            set_sym_name(utc, base);
             emit_xta(block, tail, 0, woff);
         }
         int dr, doff;
@@ -1210,11 +1553,46 @@ void codegen_instr(const Tac_Instruction *instr, const Frame *f, Besm_Block *blo
             emit_atx(block, tail, br, bo + woff);
         } else {
             Besm_Instr *utc = emit(block, tail, BESM_MOD_UTC);
-            utc->name       = xstrdup(base);
+            set_sym_name(utc, base);
             emit_atx(block, tail, 0, woff);
         }
         break;
     }
+    // BLOCK_COPY  copy `size` bytes (n words) from *src_ptr to *dst_ptr
+    //
+    // In C:  a = b;   (a struct/union too large for the translator to unroll)
+    // TAC:   block_copy src_ptr, dst_ptr, size
+    //
+    // A loop counted by VLM in r14, which steps it from 1-n up to 0.  Each pass reloads C
+    // from the two pointers, so no other index register is needed, and the counter is the
+    // index of the access itself: EA = n-1 + M[14] + C walks from word 0 to word n-1.
+    //   14 ,vtm, 1-n
+    //   loop: src ,wtc,  /  14 ,xta, n-1  /  dst ,wtc,  /  14 ,atx, n-1  /  14 ,vlm, loop
+    //
+    // The n-1 rides in the 12-bit address field of XTA/ATX, which bounds a loop at 4096
+    // words.  A larger aggregate takes one loop per 4096 words; each after the first steps
+    // the pointers by its first word with a UTC after the WTC, which adds to C.
+    case TAC_INSTRUCTION_BLOCK_COPY: {
+        int words       = (instr->u.block_copy.size + BESM6_WORD_BYTES - 1) / BESM6_WORD_BYTES;
+        const char *src = instr->u.block_copy.src_ptr->u.var_name;
+        const char *dst = instr->u.block_copy.dst_ptr->u.var_name;
+        for (int first = 0; first < words; first += 4096) {
+            int n           = words - first < 4096 ? words - first : 4096;
+            char *loop      = new_local_label();
+            Besm_Instr *vtm = emit(block, tail, BESM_REG_VTM);
+            vtm->reg        = REG_SCRATCH;
+            vtm->addr       = 1 - n;
+            emit_label(block, tail, xstrdup(loop));
+            emit_wtc_ptr_at(block, tail, f, src, first);
+            emit_xta(block, tail, REG_SCRATCH, n - 1);
+            emit_wtc_ptr_at(block, tail, f, dst, first);
+            emit_atx(block, tail, REG_SCRATCH, n - 1);
+            Besm_Instr *vlm = emit(block, tail, BESM_BRANCH_VLM);
+            vlm->reg        = REG_SCRATCH;
+            vlm->name       = loop; // takes ownership
+        }
+        break;
+    }
     case TAC_INSTRUCTION_ALLOCATE_LOCAL:
         // Frame-slot reservation only; the slot is sized in frame_build and the
         // prologue's stack extension covers it. No runtime instruction is emitted.
@@ -28,6 +28,11 @@ typedef struct {
 
 Besm_ConstWord besm_const_word(const Tac_Const *c);
 
+// The native 48-bit word of a floating-point value: 7-bit exponent biased by 64, sign,
+// 40-bit two's-complement mantissa.  A value outside the exponent range is a fatal error.
+// Defined in besm_const.c.
+uint64_t besm_real_word(double v);
+
 // The widest address each instruction format can carry in its own field.  A Format-1 offset
 // is 12 bits — every address in the peripherals map fits (033 reaches 04177, 002 reaches
 // 0237), so an I/O intrinsic's constant address is always an immediate and the Format-1 S
@@ -63,6 +68,9 @@ extern const char *const besm_latin_mnem[];
 // Append a new instruction to a block, maintaining *tail.
 Besm_Instr *emit(Besm_Block *block, Besm_Instr **tail, Besm_InstrKind kind);
 
+// Give `i` the data symbol `name`: a heap copy in ->name, the interned one in ->sym.
+void set_sym_name(Besm_Instr *i, const char *name);
+
 // Emit XTA: A = mem[reg + off].
 void emit_xta(Besm_Block *b, Besm_Instr **t, int reg, int off);
 
@@ -93,10 +101,97 @@ void emit_store_a(Besm_Block *b, Besm_Instr **t, const Frame *f, const char *nam
 void emit_arith_val(Besm_Block *b, Besm_Instr **t, Besm_InstrKind kind, const Frame *f,
                     const Tac_Val *v);
 
+// Start instruction selection for the function `name`: the local labels of the sequences
+// selected inline are numbered afresh in each function (defined in instr.c).
+void codegen_function_begin(const char *name);
+
+// A fresh local label of the current function, owned by the caller (defined in instr.c).
+char *new_local_label(void);
+
+// Call counting (genbesm --instrument-calls).  Each instrumented function has a record in
+// its module: the count, a link, and the function's name packed as a string.  The prologue
+// bumps the count, and on the first call links the record into the list the runtime keeps
+// at BESM_CALL_COUNTS; the startup code calls BESM_CALL_COUNT_DUMP to write it to stderr
+// when main returns (libc/besm6/unix/callcount.c).
+#define BESM_CALL_COUNTS     "_callcounts"
+#define BESM_CALL_COUNT_DUMP "_callcount_dump"
+
+// Count a call to the function whose record is labelled `counter` (defined in instr.c).
+void codegen_count_call(const char *counter, Besm_Block *block, Besm_Instr **tail);
+
 // Lower one TAC instruction (defined in instr.c).
 void codegen_instr(const Tac_Instruction *instr, const Frame *f, Besm_Block *block,
                    Besm_Instr **tail);
 
+// Lower an integer comparison together with the conditional jump that follows it and is its
+// only use, branching on ω instead of calling a relational helper; return false, emitting
+// nothing, when `instr` is not such a pair (defined in instr.c).
+bool codegen_compare_branch(const Tac_Instruction *instr, const Frame *f, Besm_Block *block,
+                            Besm_Instr **tail);
+
+// The counted loops of a function that VLM closes, found before instruction selection
+// (defined in loops.c).
+typedef struct CountedLoops CountedLoops;
+
+CountedLoops *counted_loops_find(const Tac_TopLevel *fn, const Frame *f);
+
+// Lower the head or the jump back of a counted loop, advancing *instr past the test the
+// head replaces; return false, emitting nothing, for any other instruction.
+bool codegen_counted_loop(CountedLoops *loops, const Tac_Instruction **instr, const Frame *f,
+                          Besm_Block *block, Besm_Instr **tail);
+
+void counted_loops_free(CountedLoops *loops);
+
+// The frame a function needs, decided once selection and the peephole pass are done and the
+// calls left in it are known (defined in leaf.c).
+typedef enum {
+    BESM_FRAME_FULL, // b$save and b$ret
+    BESM_FRAME_LEAF, // calls nothing: parameters and autos through r12 and r11, nothing saved
+    BESM_FRAME_NONE, // calls nothing and addresses no parameter or auto
+} Besm_FrameKind;
+
+// Classify a function selected with the standard prologue; `autos` is true when it still
+// reserves auto slots.  Without --speed a linkage longer than the standard one is not taken.
+Besm_FrameKind leaf_frame_kind(const Besm_Func *func, const Tac_TopLevel *tl, bool autos);
+
+// Replace the standard prologue and each `uj b$ret` by the linkage of `kind`.
+void leaf_frame_rewrite(Besm_Func *func, const Tac_TopLevel *tl, Besm_FrameKind kind,
+                        bool autos);
+
+// The binary operation's runtime helper, or NULL when it is selected inline (defined in
+// instr.c).
+const char *binop_helper(const Tac_Instruction *instr);
+
+// The single-use expression temporaries of a function that live in A and on the hardware
+// stack instead of in frame slots, found before the frame is laid out (defined in stack.c).
+typedef struct {
+    StringMap temps; // the stacked temporaries
+    int depth;       // how many hold values during selection; the newest is in A
+} StackTemps;
+
+// Find them; return false, with `st` still to be freed, when there are none.
+bool stack_temps_find(const Tac_TopLevel *fn, const Frame *f, StackTemps *st);
+
+// Lower an instruction that reads or defines a stacked temporary; return false, emitting
+// nothing, for any other instruction.
+bool codegen_stacked(const Tac_Instruction *instr, StackTemps *st, const Frame *f,
+                     Besm_Block *block, Besm_Instr **tail);
+
+void stack_temps_free(StackTemps *st);
+
+// The divides and remainders of the same operands selected together with --speed, found
+// before instruction selection (defined in divmod.c).
+typedef struct DivModPairs DivModPairs;
+
+DivModPairs *divmod_pairs_find(const Tac_TopLevel *fn, const Frame *f, const StackTemps *st);
+
+// Lower a divide or remainder of a pair; return false, emitting nothing, for any other
+// instruction, and for a divide that is selected as it is.
+bool codegen_divmod(DivModPairs *pairs, const Tac_Instruction *instr, const Frame *f,
+                    Besm_Block *block, Besm_Instr **tail);
+
+void divmod_pairs_free(DivModPairs *pairs);
+
 // Lower a call to a <besm6.h> compiler intrinsic into inline machine instructions, or
 // return false when `instr` is an ordinary call (defined in intrinsics.c).  Every
 // `__besm6_` name is handled here: they all collide under Madlen's 8-character truncation,
@@ -104,10 +199,11 @@ void codegen_instr(const Tac_Instruction *instr, const Frame *f, Besm_Block *blo
 bool codegen_intrinsic(const Tac_Instruction *instr, const Frame *f, Besm_Block *block,
                        Besm_Instr **tail);
 
-// Emit a module-level static variable (defined in static.c).  `program` is the full
-// toplevel chain, used to fold referenced string constants into this module.
-void codegen_static_variable(const Tac_TopLevel *program, const Tac_TopLevel *tl, FILE *out,
-                             Besm_Dialect dialect);
+// Build the module of a module-level static variable, or return NULL when another toplevel
+// supersedes it (defined in static.c).  `program` is the full toplevel chain, used to fold
+// referenced string constants into this module.
+Besm_Module *codegen_static_variable(const Tac_TopLevel *program, const Tac_TopLevel *tl,
+                                     Besm_Dialect dialect);
 
 // Pack a string static-init into a BESM_DATA_LOG chain; the first word is labeled
 // `label` when non-NULL (defined in static.c).  `dialect` selects text encoding:
@@ -124,6 +220,11 @@ void besm_fold_string_constants(Besm_Module *module, const Tac_TopLevel *program
 // spliced into the function's module just before its `,end,` (defined in static.c).
 void besm_emit_static_locals(Besm_Module *module, const Tac_TopLevel *fn, Besm_Dialect dialect);
 
+// Emit the call-count record of the function `name`, labelled `counter`, spliced in before
+// the module's `,end,` like a static local (defined in static.c).
+void besm_emit_call_counter(Besm_Module *module, const char *name, const char *counter,
+                            Besm_Dialect dialect);
+
 // Mangle a name into a valid Bemsh label: ≤6 chars, letter-first, letters/digits/`_` only,
 // with runtime helpers (`b$…`) mapped to their `libbem.bin` exports (`_…`).  A pure
 // deterministic function of the name (defined in emit_bemsh.c); exposed for unit testing.
@@ -0,0 +1,288 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "abi.h"
+#include "besm.h"
+#include "codegen.h"
+#include "internal.h"
+#include "tac.h"
+
+// Frames of leaf functions.
+//
+// Every function is selected with the standard linkage: `its 13 / call b$save` at entry,
+// which saves r13, r7, r6 and r5 and points r6 at the parameters and r7 at the autos, and a
+// `uj b$ret` at each return, which restores them.  That is twenty-odd instructions a call,
+// more than the whole body of an accessor.  A function that calls nothing need not save
+// anything: it addresses its parameters and autos through r12 and r11 instead, which every
+// caller already expects a call to clobber (the runtime helpers use r12 freely), and leaves
+// r13 and r5-r7 alone.  Once selection and the peephole pass are done the calls that remain
+// are known, and the function is given the frame it needs:
+//
+//   no frame     — neither a parameter nor an auto is addressed:
+//                      [14 j+m 15 / 15 utm 1]  ntr 7   ...   13 uj
+//                  (the bracketed pair pops the arguments of two or more parameters)
+//   leaf frame   — parameters or autos are addressed, through r12 and r11:
+//                      [15 atx / 15 mtj 12 / 14 j+m 12]  [15 mtj 11]  ntr 7  [15 utm k]
+//                      ...   12 mtj 15   13 uj
+//                  (with one parameter r12 is r15 before the push, `15 mtj 12 / 15 atx`;
+//                  with none the epilogue resets r15 from r11)
+//   full frame   — anything else keeps b$save and b$ret.
+//
+// The parameters start where b$save would have put them, with the last argument pushed
+// after the others, and the autos follow them; r15 returns to the first argument, or where
+// it was with no parameters, as b$ret leaves it.  b$ret also returns A with ω logical, so
+// the epilogue of a function that returns a value sets the mode with an `aox` of word 0,
+// unless the value was just loaded.
+//
+// A function is a leaf when nothing is left that transfers control and comes back — no
+// `call`, no `vjm` — and nothing in it uses r11 or r12 already.  Variadic functions, and
+// any reaching b$ret by other than `uj`, keep the full frame.  So does a leaf whose inline
+// linkage is longer than `its 13 / call b$save` and its `uj`s, unless --speed asks for it:
+// with parameters the set-up and the reset of r15 at each return usually are.
+
+//
+// Does the instruction name an index register in its address field rather than its
+// modifier field?
+//
+static bool reg_in_addr(Besm_InstrKind kind)
+{
+    switch (kind) {
+    case BESM_MEM_ITA:
+    case BESM_MEM_ATI:
+    case BESM_MEM_ITS:
+    case BESM_MEM_STI:
+    case BESM_MEM_MTJ:
+    case BESM_REG_JADDM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// A machine instruction, rather than a directive or a data word.
+static bool is_machine(Besm_InstrKind kind)
+{
+    return kind < BESM_STMT_LABEL;
+}
+
+//
+// Does the instruction use index register `r`, as its modifier or its operand?
+//
+static bool uses_reg(const Besm_Instr *i, int r)
+{
+    if (!is_machine(i->kind))
+        return false;
+    if ((int)i->reg == r)
+        return true;
+    return reg_in_addr(i->kind) && i->name == NULL && i->addr == r;
+}
+
+static bool is_save(const Besm_Instr *i)
+{
+    return i->kind == BESM_BRANCH_CALL && i->name &&
+           (strcmp(i->name, "b$save") == 0 || strcmp(i->name, "b$save0") == 0);
+}
+
+static bool is_ret(const Besm_Instr *i)
+{
+    return i->name && strcmp(i->name, "b$ret") == 0 && is_machine(i->kind);
+}
+
+//
+// Does A hold its value with ω logical after `i`, as b$ret returns it?  `logical` is the
+// answer before it; a label forgets it.
+//
+static bool step_logical(bool logical, const Besm_Instr *i)
+{
+    switch (i->kind) {
+    case BESM_MEM_XTA:
+    case BESM_MEM_XTS:
+    case BESM_MEM_ITA:
+    case BESM_LOG_AAX:
+    case BESM_LOG_AOX:
+    case BESM_LOG_AEX:
+    case BESM_IO_EXT: // the value read, like ita
+    case BESM_IO_MOD:
+        return true;
+    // Neither A nor the mode changes.
+    case BESM_MEM_ATX:
+    case BESM_MEM_MTJ:
+    case BESM_REG_VTM:
+    case BESM_REG_UTM:
+    case BESM_REG_JADDM:
+    case BESM_MOD_UTC:
+    case BESM_MOD_WTC:
+        return logical;
+    default:
+        return false;
+    }
+}
+
+static int count_params(const Tac_TopLevel *tl)
+{
+    int n = 0;
+    for (const Tac_Param *p = tl->u.function.params; p; p = p->next)
+        n++;
+    return n;
+}
+
+// Does the function return a value?  A function that does not leaves A unspecified.
+static bool returns_value(const Tac_TopLevel *tl)
+{
+    for (const Tac_Instruction *i = tl->u.function.body; i; i = i->next)
+        if (i->kind == TAC_INSTRUCTION_RETURN && i->u.return_.src)
+            return true;
+    return false;
+}
+
+Besm_FrameKind leaf_frame_kind(const Besm_Func *func, const Tac_TopLevel *tl, bool autos)
+{
+    if (tl->u.function.variadic)
+        return BESM_FRAME_FULL;
+
+    int num_params = count_params(tl);
+    bool value     = returns_value(tl);
+
+    bool saves = false, addressed = autos, logical = false;
+    int rets = 0, modes = 0; // returns, and those that must set ω logical
+    for (const Besm_Block *b = func->blocks; b; b = b->next) {
+        for (const Besm_Instr *i = b->body; i; logical = step_logical(logical, i), i = i->next) {
+            if (is_save(i)) {
+                saves = true;
+                continue;
+            }
+            if (i->kind == BESM_BRANCH_CALL || i->kind == BESM_BRANCH_VJM)
+                return BESM_FRAME_FULL;
+            if (is_ret(i)) {
+                if (i->kind != BESM_BRANCH_UJ)
+                    return BESM_FRAME_FULL;
+                rets++;
+                if (value && !logical)
+                    modes++;
+            }
+            if (uses_reg(i, REG_LEAF_PAR) || uses_reg(i, REG_LEAF_AUTO))
+                return BESM_FRAME_FULL;
+            if (uses_reg(i, REG_PAR) || uses_reg(i, REG_AUTO))
+                addressed = true;
+        }
+    }
+    if (!saves)
+        return BESM_FRAME_FULL; // no standard prologue to replace
+
+    // The smallest code keeps b$save when the inline linkage is longer than its two
+    // instructions and a `uj` a return; --speed takes it anyway.
+    Besm_FrameKind kind = addressed ? BESM_FRAME_LEAF : BESM_FRAME_NONE;
+    int prologue        = 1; // ntr 7
+    if (kind == BESM_FRAME_NONE)
+        prologue += num_params > 1 ? 2 : 0;
+    else
+        prologue += (num_params > 1 ? 3 : 2 * num_params) + (autos ? 1 : 0);
+    int length = prologue + rets + modes + (kind == BESM_FRAME_LEAF ? rets : 0);
+    if (!besm_codegen_options.speed && length > 2 + rets)
+        return BESM_FRAME_FULL;
+    return kind;
+}
+
+//
+// Insert a new instruction after `prev`.
+//
+static Besm_Instr *insert_after(Besm_Instr *prev, Besm_InstrKind kind, int reg, int addr)
+{
+    Besm_Instr *i = besm_new_instr(kind);
+    i->reg        = reg;
+    i->addr       = addr;
+    i->next       = prev->next;
+    prev->next    = i;
+    return i;
+}
+
+void leaf_frame_rewrite(Besm_Func *func, const Tac_TopLevel *tl, Besm_FrameKind kind,
+                        bool autos)
+{
+    if (kind == BESM_FRAME_FULL)
+        return;
+
+    int num_params = count_params(tl);
+    bool value     = returns_value(tl);
+
+    bool logical = false;
+    for (Besm_Block *b = func->blocks; b; b = b->next) {
+        Besm_Instr *prev = NULL;
+        for (Besm_Instr *i = b->body; i; prev = i, i = i->next) {
+            bool before = logical;
+            logical     = step_logical(logical, i);
+            // The prologue: `its 13 / call b$save` becomes the frame set-up.
+            if (i->kind == BESM_MEM_ITS && i->addr == REG_RET && i->next && is_save(i->next)) {
+                Besm_Instr *save = i->next;
+                Besm_Instr *last = prev;
+                if (kind == BESM_FRAME_NONE) {
+                    if (num_params > 1) {
+                        last = insert_after(last, BESM_REG_JADDM, REG_CNT, REG_SP);
+                        last = insert_after(last, BESM_REG_UTM, REG_SP, 1);
+                    }
+                } else {
+                    if (num_params == 1) {
+                        last = insert_after(last, BESM_MEM_MTJ, REG_SP, REG_LEAF_PAR);
+                        last = insert_after(last, BESM_MEM_ATX, REG_SP, 0);
+                    } else if (num_params > 1) {
+                        last = insert_after(last, BESM_MEM_ATX, REG_SP, 0);
+                        last = insert_after(last, BESM_MEM_MTJ, REG_SP, REG_LEAF_PAR);
+                        last = insert_after(last, BESM_REG_JADDM, REG_CNT, REG_LEAF_PAR);
+                    }
+                    if (autos)
+                        last = insert_after(last, BESM_MEM_MTJ, REG_SP, REG_LEAF_AUTO);
+                }
+                last       = insert_after(last, BESM_EXP_SETR, 0, 7);
+                last->next = save->next;
+                save->next = NULL;
+                besm_free_instr(i);
+                i = last;
+                continue;
+            }
+            if (!is_machine(i->kind))
+                continue;
+            // Each `uj b$ret` becomes the epilogue.
+            if (is_ret(i)) {
+                Besm_Instr *last = prev;
+                if (kind == BESM_FRAME_LEAF)
+                    last = insert_after(last, BESM_MEM_MTJ,
+                                        num_params > 0 ? REG_LEAF_PAR : REG_LEAF_AUTO, REG_SP);
+                if (value && !before)
+                    last = insert_after(last, BESM_LOG_AOX, 0, 0);
+                last       = insert_after(last, BESM_BRANCH_UJ, REG_RET, 0);
+                last->next = i->next;
+                i->next    = NULL;
+                besm_free_instr(i);
+                i = last;
+                continue;
+            }
+            // The frame moves from r6 and r7 to r12 and r11.
+            if (i->reg == REG_PAR)
+                i->reg = REG_LEAF_PAR;
+            else if (i->reg == REG_AUTO)
+                i->reg = REG_LEAF_AUTO;
+            if (reg_in_addr(i->kind) && i->name == NULL) {
+                if (i->addr == REG_PAR)
+                    i->addr = REG_LEAF_PAR;
+                else if (i->addr == REG_AUTO)
+                    i->addr = REG_LEAF_AUTO;
+            }
+        }
+    }
+
+    // b$ret is no longer referenced.
+    for (Besm_Block *b = func->blocks; b; b = b->next) {
+        Besm_Instr *prev = NULL;
+        for (Besm_Instr *i = b->body; i; prev = i, i = i->next) {
+            if (i->kind == BESM_STMT_SUBP && i->name && strcmp(i->name, "b$ret") == 0) {
+                if (prev)
+                    prev->next = i->next;
+                else
+                    b->body = i->next;
+                i->next = NULL;
+                besm_free_instr(i);
+                break;
+            }
+        }
+    }
+}
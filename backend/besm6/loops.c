@@ -0,0 +1,409 @@
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "abi.h"
+#include "besm.h"
+#include "codegen.h"
+#include "frame.h"
+#include "internal.h"
+#include "tac.h"
+#include "xalloc.h"
+
+// Counted loops closed by VLM.
+//
+// The translator lowers `for (i = c; i < n; i++) body`, and the `while` loop that steps i
+// last, to
+//
+//     top:   t = i < n  /  jump_if_zero t, exit
+//            body
+//            i = i + 1  /  jump top
+//     exit:
+//
+// which selects to a load, a subtract and a branch out at the top of every pass, and a jump
+// back at its end.  VLM counts in an index register instead: while M[r] is non-zero it steps
+// it by one and branches, so a register that starts at 1-k runs the loop k times and falls
+// through.  i keeps its slot and its step, so the body and the code after the loop read it
+// as before; only the test leaves the loop.
+//
+// With a constant start and bound the trip count k is known when the loop is entered:
+//
+//     r ,vtm, 1-k
+//     top:   body  /  i = i + 1  /  r ,vlm, top
+//
+// which is shorter than the test it replaces.  Otherwise the count is taken from i - n at
+// run time, and the test runs once more when VLM falls through:
+//
+//     arm:   xta i  /  a-x n  /  uza exit  /  ati r  /  r ,utm, 1
+//     top:   body  /  i = i + 1  /  r ,vlm, top  /  uj arm
+//     exit:
+//
+// That is three words longer than the test, so it is selected only with --speed.  ATI keeps
+// the low 15 bits of i - n: a loop of more than 32768 passes is run a part at a time, each
+// arming running at least one pass and no more than are left, until the test at `arm` ends
+// it.
+//
+// A loop qualifies when i and n are frame slots whose address is never taken (n may also be
+// a constant), nothing but the step writes i and nothing writes n, nothing jumps into the
+// loop but the jump back, and the body makes no call that returns: b/save does not keep the
+// register, and a callee may close loops of its own in it.  The runtime helpers the body may
+// call leave r8 and r9 alone.  An innermost loop counts in r8 and the loop around it in r9;
+// a loop with two levels of counted loops inside it keeps its test.
+
+#define LOOP_LEVELS   2     // r8 and r9
+#define LOOP_MAX_TRIP 32768 // the most passes a 15-bit register counts
+
+typedef struct {
+    int head;                    // index of the label at the top
+    int back;                    // index of the jump back to it
+    const Tac_Instruction *top;  // the label at the top
+    const Tac_Instruction *test; // the jump_if_zero that leaves the loop
+    const Tac_Instruction *jump; // the jump back
+    const Tac_Val *var;          // i
+    const Tac_Val *bound;        // n
+    const char *exit;            // the label after the jump back
+    int trip;                    // the trip count when known, else 0
+    int level;                   // depth of the counted loops inside
+    char *arm;                   // label of the run-time test, once selected
+} CountedLoop;
+
+struct CountedLoops {
+    CountedLoop *loops;
+    int count;
+};
+
+// The value of a signed integer constant; false for a variable or any other constant.
+static bool const_value(const Tac_Val *v, long *value)
+{
+    if (v->kind != TAC_VAL_CONSTANT)
+        return false;
+    const Tac_Const *c = v->u.constant;
+    switch (c->kind) {
+    case TAC_CONST_INT:
+        *value = (long)c->u.int_val;
+        return true;
+    case TAC_CONST_LONG:
+        *value = c->u.long_val;
+        return true;
+    case TAC_CONST_LONG_LONG:
+        *value = (long)c->u.long_long_val;
+        return true;
+    case TAC_CONST_SCHAR:
+        *value = c->u.char_val;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// `name` is interned, as are the names of the TAC it is looked for in (see tac_intern()).
+static bool is_var(const Tac_Val *v, const char *name)
+{
+    return v && v->kind == TAC_VAL_VAR && v->u.var_name == name;
+}
+
+// The variable an instruction assigns, or NULL (as get_defining_dst in copy_prop.c).
+static const Tac_Val *instr_dst(const Tac_Instruction *instr)
+{
+    switch (instr->kind) {
+    case TAC_INSTRUCTION_UNARY:
+        return instr->u.unary.dst;
+    case TAC_INSTRUCTION_BINARY:
+        return instr->u.binary.dst;
+    case TAC_INSTRUCTION_COPY:
+        return instr->u.copy.dst;
+    case TAC_INSTRUCTION_SIGN_EXTEND:
+    case TAC_INSTRUCTION_TRUNCATE:
+    case TAC_INSTRUCTION_ZERO_EXTEND:
+    case TAC_INSTRUCTION_DOUBLE_TO_INT:
+    case TAC_INSTRUCTION_DOUBLE_TO_UINT:
+    case TAC_INSTRUCTION_INT_TO_DOUBLE:
+    case TAC_INSTRUCTION_UINT_TO_DOUBLE:
+    case TAC_INSTRUCTION_FLOAT_TO_DOUBLE:
+    case TAC_INSTRUCTION_DOUBLE_TO_FLOAT:
+    case TAC_INSTRUCTION_INT_TO_FLOAT:
+    case TAC_INSTRUCTION_UINT_TO_FLOAT:
+    case TAC_INSTRUCTION_FLOAT_TO_INT:
+    case TAC_INSTRUCTION_FLOAT_TO_UINT:
+    case TAC_INSTRUCTION_LONG_DOUBLE_TO_INT:
+    case TAC_INSTRUCTION_LONG_DOUBLE_TO_UINT:
+    case TAC_INSTRUCTION_INT_TO_LONG_DOUBLE:
+    case TAC_INSTRUCTION_UINT_TO_LONG_DOUBLE:
+    case TAC_INSTRUCTION_LONG_DOUBLE_TO_DOUBLE:
+    case TAC_INSTRUCTION_DOUBLE_TO_LONG_DOUBLE:
+    case TAC_INSTRUCTION_LONG_DOUBLE_TO_FLOAT:
+    case TAC_INSTRUCTION_FLOAT_TO_LONG_DOUBLE:
+    case TAC_INSTRUCTION_PTR_TO_CHAR_PTR:
+    case TAC_INSTRUCTION_CHAR_PTR_TO_PTR:
+        return instr->u.sign_extend.dst; // all conversions share this layout
+    case TAC_INSTRUCTION_GET_ADDRESS:
+    case TAC_INSTRUCTION_GET_ADDRESS_BYTE:
+    case TAC_INSTRUCTION_GET_ADDRESS_DECAY:
+        return instr->u.get_address.dst;
+    case TAC_INSTRUCTION_LOAD:
+    case TAC_INSTRUCTION_LOAD_BYTE:
+        return instr->u.load.dst;
+    case TAC_INSTRUCTION_ADD_PTR:
+        return instr->u.add_ptr.dst;
+    case TAC_INSTRUCTION_PTR_DIFF:
+        return instr->u.ptr_diff.dst;
+    case TAC_INSTRUCTION_COPY_FROM_OFFSET:
+    case TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET:
+        return instr->u.copy_from_offset.dst;
+    case TAC_INSTRUCTION_FUN_CALL:
+    case TAC_INSTRUCTION_FUN_CALL_NORETURN:
+        return instr->u.fun_call.dst;
+    default:
+        return NULL;
+    }
+}
+
+// The label a jump goes to, or NULL for any other instruction.  (JUMP_IF_ZERO and
+// JUMP_IF_NOT_ZERO share the {condition, target} layout.)
+static const char *jump_target(const Tac_Instruction *instr)
+{
+    switch (instr->kind) {
+    case TAC_INSTRUCTION_JUMP:
+        return instr->u.jump.target;
+    case TAC_INSTRUCTION_JUMP_IF_ZERO:
+    case TAC_INSTRUCTION_JUMP_IF_NOT_ZERO:
+        return instr->u.jump_if_zero.target;
+    default:
+        return NULL;
+    }
+}
+
+// Is `v` a frame slot whose address the function never takes?  Only then are the
+// instructions that name it all the ones that write it.
+static bool is_private_slot(const Tac_Instruction *const *code, int n, const Frame *f,
+                            const Tac_Val *v)
+{
+    int reg, off;
+    if (v->kind != TAC_VAL_VAR || !frame_lookup(f, v->u.var_name, &reg, &off))
+        return false;
+    for (int k = 0; k < n; k++) {
+        switch (code[k]->kind) {
+        case TAC_INSTRUCTION_GET_ADDRESS:
+        case TAC_INSTRUCTION_GET_ADDRESS_BYTE:
+        case TAC_INSTRUCTION_GET_ADDRESS_DECAY:
+            if (is_var(code[k]->u.get_address.src, v->u.var_name))
+                return false;
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+// Is the step `i = i + 1` the one that ends at code[back - 1]?  Set *first to its first
+// instruction: the add itself, or the add into a temporary the copy after it reads.
+static bool match_step(const Tac_Instruction *const *code, int back, const Frame *f,
+                       const char *var, int *first)
+{
+    const Tac_Instruction *add = code[back - 1];
+    const char *sum            = var;
+    *first                     = back - 1;
+    if (add->kind == TAC_INSTRUCTION_COPY) {
+        if (!is_var(add->u.copy.dst, var) || add->u.copy.src->kind != TAC_VAL_VAR)
+            return false;
+        sum = add->u.copy.src->u.var_name;
+        if (frame_temp_refs(f, sum) != 2)
+            return false;
+        add = code[--*first];
+    }
+    long one;
+    return add->kind == TAC_INSTRUCTION_BINARY && add->u.binary.op == TAC_BINARY_ADD &&
+           is_var(add->u.binary.dst, sum) && is_var(add->u.binary.src1, var) &&
+           const_value(add->u.binary.src2, &one) && one == 1;
+}
+
+// Does code[head] begin a loop VLM can close?  Fill in `loop` when it does.
+static bool match_loop(const Tac_Instruction *const *code, int n, int head, const Frame *f,
+                       CountedLoop *loop)
+{
+    if (code[head]->kind != TAC_INSTRUCTION_LABEL || head + 2 >= n)
+        return false;
+    const Tac_Instruction *top  = code[head];
+    const Tac_Instruction *cmp  = code[head + 1];
+    const Tac_Instruction *test = code[head + 2];
+    if (cmp->kind != TAC_INSTRUCTION_BINARY || cmp->u.binary.op != TAC_BINARY_LESS_THAN ||
+        test->kind != TAC_INSTRUCTION_JUMP_IF_ZERO ||
+        !is_var(test->u.jump_if_zero.condition, cmp->u.binary.dst->u.var_name) ||
+        frame_temp_refs(f, cmp->u.binary.dst->u.var_name) != 2)
+        return false;
+
+    const Tac_Val *var   = cmp->u.binary.src1;
+    const Tac_Val *bound = cmp->u.binary.src2;
+    long limit           = 0;
+    bool const_bound     = const_value(bound, &limit);
+    if (!is_private_slot(code, n, f, var) ||
+        (!const_bound && !is_private_slot(code, n, f, bound)) ||
+        is_var(bound, var->u.var_name))
+        return false;
+
+    // The jump back must be the only way to the top, and fall through to the exit.
+    int back = -1;
+    for (int k = 0; k < n; k++) {
+        const char *target = jump_target(code[k]);
+        if (!target || target != top->u.label.name)
+            continue;
+        if (back >= 0 || k <= head + 2 || code[k]->kind != TAC_INSTRUCTION_JUMP)
+            return false;
+        back = k;
+    }
+    const char *exit = test->u.jump_if_zero.target;
+    if (back < 0 || back + 1 >= n || code[back + 1]->kind != TAC_INSTRUCTION_LABEL ||
+        code[back + 1]->u.label.name != exit)
+        return false;
+
+    int step;
+    if (!match_step(code, back, f, var->u.var_name, &step) || step <= head + 2)
+        return false;
+    for (int k = head + 3; k < step; k++) {
+        const Tac_Val *dst = instr_dst(code[k]);
+        if (code[k]->kind == TAC_INSTRUCTION_FUN_CALL || is_var(dst, var->u.var_name) ||
+            (!const_bound && is_var(dst, bound->u.var_name)))
+            return false;
+    }
+
+    // No jump from outside may land in the body.
+    for (int k = 0; k < n; k++) {
+        const char *target = jump_target(code[k]);
+        if (!target || (k > head && k < back))
+            continue;
+        for (int m = head + 3; m < back; m++)
+            if (code[m]->kind == TAC_INSTRUCTION_LABEL && code[m]->u.label.name == target)
+                return false;
+    }
+
+    // A constant start right before the top, with a constant bound, gives the trip count.
+    loop->trip = 0;
+    long start;
+    const Tac_Instruction *init = head > 0 ? code[head - 1] : NULL;
+    if (const_bound && init && init->kind == TAC_INSTRUCTION_COPY &&
+        is_var(init->u.copy.dst, var->u.var_name) && const_value(init->u.copy.src, &start) &&
+        limit > start && limit - start <= LOOP_MAX_TRIP)
+        loop->trip = (int)(limit - start);
+    if (loop->trip == 0 && !besm_codegen_options.speed)
+        return false;
+
+    loop->head  = head;
+    loop->back  = back;
+    loop->top   = top;
+    loop->test  = test;
+    loop->jump  = code[back];
+    loop->var   = var;
+    loop->bound = bound;
+    loop->exit  = exit;
+    loop->level = 0;
+    loop->arm   = NULL;
+    return true;
+}
+
+// Innermost first, so that each loop's level is known before the loops around it.
+static int by_span(const void *a, const void *b)
+{
+    const CountedLoop *x = a;
+    const CountedLoop *y = b;
+    return (x->back - x->head) - (y->back - y->head);
+}
+
+CountedLoops *counted_loops_find(const Tac_TopLevel *fn, const Frame *f)
+{
+    int n = 0;
+    for (const Tac_Instruction *instr = fn->u.function.body; instr; instr = instr->next)
+        n++;
+    CountedLoops *loops = xalloc(sizeof(CountedLoops), __func__, __FILE__, __LINE__);
+    loops->loops        = NULL;
+    loops->count        = 0;
+    if (n == 0)
+        return loops;
+
+    const Tac_Instruction **code =
+        xalloc(n * sizeof(Tac_Instruction *), __func__, __FILE__, __LINE__);
+    int k = 0;
+    for (const Tac_Instruction *instr = fn->u.function.body; instr; instr = instr->next)
+        code[k++] = instr;
+
+    CountedLoop *found = xalloc(n * sizeof(CountedLoop), __func__, __FILE__, __LINE__);
+    int count          = 0;
+    for (int head = 0; head < n; head++)
+        if (match_loop(code, n, head, f, &found[count]))
+            count++;
+    xfree(code);
+
+    // Loops nest or are disjoint; each is one level above the deepest loop inside it.
+    qsort(found, count, sizeof(CountedLoop), by_span);
+    for (int i = 0; i < count; i++)
+        for (int j = 0; j < i; j++)
+            if (found[j].head > found[i].head && found[j].back < found[i].back &&
+                found[j].level >= found[i].level)
+                found[i].level = found[j].level + 1;
+
+    // Keep the loops that have a register.
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+        if (found[i].level < LOOP_LEVELS)
+            found[kept++] = found[i];
+    if (kept == 0) {
+        xfree(found);
+        return loops;
+    }
+    loops->loops = found;
+    loops->count = kept;
+    return loops;
+}
+
+bool codegen_counted_loop(CountedLoops *loops, const Tac_Instruction **instr, const Frame *f,
+                          Besm_Block *block, Besm_Instr **tail)
+{
+    for (int i = 0; i < loops->count; i++) {
+        CountedLoop *loop = &loops->loops[i];
+        int reg           = REG_LOOP + loop->level;
+        if (*instr == loop->top) {
+            if (loop->trip > 0) {
+                Besm_Instr *vtm = emit(block, tail, BESM_REG_VTM);
+                vtm->reg        = reg;
+                vtm->addr       = 1 - loop->trip;
+            } else {
+                loop->arm       = new_local_label();
+                Besm_Instr *lbl = emit(block, tail, BESM_STMT_LABEL);
+                lbl->name       = xstrdup(loop->arm);
+                emit_xta_val(block, tail, f, loop->var);
+                emit_arith_val(block, tail, BESM_ARITH_SUB, f, loop->bound);
+                Besm_Instr *uza = emit(block, tail, BESM_BRANCH_UZA);
+                uza->name       = xstrdup(loop->exit); // i - n >= 0: no pass left
+                Besm_Instr *ati = emit(block, tail, BESM_MEM_ATI);
+                ati->addr       = reg;
+                Besm_Instr *utm = emit(block, tail, BESM_REG_UTM);
+                utm->reg        = reg;
+                utm->addr       = 1;
+            }
+            Besm_Instr *lbl = emit(block, tail, BESM_STMT_LABEL);
+            lbl->name       = xstrdup(loop->top->u.label.name);
+            *instr          = loop->test; // the test is done at the arming
+            return true;
+        }
+        if (*instr == loop->jump) {
+            Besm_Instr *vlm = emit(block, tail, BESM_BRANCH_VLM);
+            vlm->reg        = reg;
+            vlm->name       = xstrdup(loop->top->u.label.name);
+            if (loop->arm) {
+                Besm_Instr *uj = emit(block, tail, BESM_BRANCH_UJ);
+                uj->name       = xstrdup(loop->arm);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void counted_loops_free(CountedLoops *loops)
+{
+    for (int i = 0; i < loops->count; i++)
+        if (loops->loops[i].arm)
+            xfree(loops->loops[i].arm);
+    if (loops->loops)
+        xfree(loops->loops);
+    xfree(loops);
+}
@@ -1,5 +1,6 @@
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "abi.h"
@@ -71,7 +72,7 @@ typedef struct {
                       // LOC_DEREF: the pointer's slot number
     const char *name; // LOC_GLOBAL: the global's symbol;  LOC_DEREF: the global *pointer*'s
                       // symbol, or NULL when the pointer is the frame slot (reg, off).
-                      // Borrowed from the group's UTC ->name; see the lifetime note below.
+                      // Interned (the group's ->sym), so two names match by address.
 } Loc;
 
 static Loc loc_none(void)
@@ -95,12 +96,12 @@ static bool loc_eq(Loc a, Loc b)
     case LOC_FRAME:
         return a.reg == b.reg && a.off == b.off;
     case LOC_GLOBAL:
-        return a.off == b.off && strcmp(a.name, b.name) == 0;
+        return a.off == b.off && a.name == b.name;
     case LOC_DEREF:
         if ((a.name == NULL) != (b.name == NULL))
             return false;
         if (a.name != NULL)
-            return strcmp(a.name, b.name) == 0;
+            return a.name == b.name;
         return a.reg == b.reg && a.off == b.off;
     default:
         return false;
@@ -130,9 +131,8 @@ static bool loc_eq(Loc a, Loc b)
 // `atx`/`stx` that settles `a_loc` on the pointer's own location or on LOC_NONE — either
 // way discarding the LOC_DEREF.  A CALL, which may write anything, is a block boundary.
 //
-// `Loc.name` borrows the `->name` of the group's UTC.  Deletion always removes a whole group
-// at the cursor, and `a_loc` is only ever read to match a *later* group, so the instruction
-// a tracked name points into always outlives the state that names it.
+// `Loc.name` is the interned `->sym` of the group's UTC or WTC, not its heap `->name`: it
+// lives until the end of the translation unit, so deleting the group leaves it valid.
 //
 typedef struct {
     Loc a_loc;    // the location A currently mirrors (LOC_NONE: unknown)
@@ -208,8 +208,8 @@ static Besm_Instr *c_group_consumer(Besm_Instr *first, int *count)
 //                        prologue's `utc 14,1`); C holds an address, not a location's name
 //   any other consumer — `xts`, `asx`, arithmetic, `vjm`, `vtm`: not a plain word access
 //
-// A `utc` whose name is a Madlen constant literal (`,utc, =i1`) also classifies as
-// LOC_GLOBAL, which is sound: a constant-pool entry has a fixed address like any global.
+// A named `utc`/`wtc` matches only through its interned ->sym (see set_sym_name()); one
+// that lacks it is LOC_NONE, which is always safe.
 static Loc c_group_loc(const Besm_Instr *first)
 {
     Loc l               = loc_none();
@@ -218,12 +218,12 @@ static Loc c_group_loc(const Besm_Instr *first)
     if (first->kind == BESM_MOD_UTC) {
         // A `utc` names a location only when it carries a symbol and no index register:
         // C = &name + addr.  `utc reg,off` computes an address instead.
-        if (first->name == NULL || first->konst != NULL || first->reg != 0)
+        if (first->sym == NULL || first->konst != NULL || first->reg != 0)
             return loc_none();
         if (c == NULL || is_c_setter(c))
             return loc_none();
         l.kind = LOC_GLOBAL;
-        l.name = first->name;
+        l.name = first->sym;
         l.off  = first->addr; // the consumer's own offset is added below
     } else {                  // BESM_MOD_WTC: C = the pointer's contents — a dereference
         if (first->konst != NULL)
@@ -231,10 +231,10 @@ static Loc c_group_loc(const Besm_Instr *first)
         if (first->name != NULL) {
             // `wtc name`: through the module-level pointer `name`.  An index register
             // would make the pointer's own word a computed address we cannot name.
-            if (first->reg != 0 || first->addr != 0)
+            if (first->sym == NULL || first->reg != 0 || first->addr != 0)
                 return loc_none();
             l.kind = LOC_DEREF;
-            l.name = first->name;
+            l.name = first->sym;
         } else { // `wtc reg,off`: through the frame-resident pointer in that slot
             l.kind = LOC_DEREF;
             l.reg  = (int)first->reg;
@@ -257,11 +257,14 @@ static Loc c_group_loc(const Besm_Instr *first)
 // symbolic or constant operand (a global load emits its own UTC; a nonzero literal names no
 // slot).  An operandless `xta` reaching here is a zero load and yields LOC_FRAME(0, 0) —
 // mem[0] — never a real slot; a bare `xta`/`atx` that reads mem[C] belongs to a C group and
-// is stepped by the sweep, so it never reaches this function.
+// is stepped by the sweep, so it never reaches this function.  Nor is `15 xta`/`15 atx` a
+// slot: in stack mode it pops or pushes, and the word it reaches moves with r15.
 static Loc plain_loc(const Besm_Instr *i)
 {
     if ((i->kind != BESM_MEM_XTA && i->kind != BESM_MEM_ATX) || has_operand_symbol(i))
         return loc_none();
+    if ((int)i->reg == REG_SP && i->addr == 0)
+        return loc_none();
     Loc l = { LOC_FRAME, (int)i->reg, i->addr, NULL };
     return l;
 }
@@ -379,9 +382,12 @@ static bool rule_redundant_ntr(const Besm_Instr *cur, const PeepState *st)
 //
 typedef bool (*PeepRule)(const Besm_Instr *cur, const PeepState *st);
 
-static const PeepRule rule_table[] = {
-    rule_redundant_reload,
-    rule_redundant_ntr,
+static const struct {
+    PeepRule match;
+    Besm_PeepRule stat; // the besm_peep_stats counter it bumps
+} rule_table[] = {
+    { rule_redundant_reload, PEEP_RELOAD },
+    { rule_redundant_ntr, PEEP_NTR },
 };
 #define NUM_RULES (sizeof(rule_table) / sizeof(rule_table[0]))
 
@@ -769,7 +775,7 @@ static int try_io_memory_address(Besm_Instr *cur)
         wtc->reg  = (unsigned)base.reg;
         wtc->addr = base.off;
     } else {
-        wtc->name = xstrdup(base.name); // borrowed from `cur`, which is about to be freed
+        set_sym_name(wtc, base.name); // interned, so it outlives `cur`, which is freed next
     }
     return nodes;
 }
@@ -881,6 +887,7 @@ static bool peephole_sweep(Besm_Block *block, const Frame *frame, const bool *mu
         // Rule #31(b): unreachable tail.  Code after an unconditional transfer and
         // before the next label/directive can never execute; delete it.
         if (st.in_unreachable && unreachable_deletable(cur)) {
+            besm_peep_stats.fired[PEEP_UNREACHABLE]++;
             Besm_Instr *next = cur->next;
             delete_instr(block, prev, cur);
             cur     = next;
@@ -899,6 +906,7 @@ static bool peephole_sweep(Besm_Block *block, const Frame *frame, const bool *mu
             // group, so it has to be caught before the group is stepped past.
             int fold = try_io_memory_address(cur);
             if (fold > 0) {
+                besm_peep_stats.fired[PEEP_IO_ADDRESS]++;
                 cur     = delete_run(block, prev, cur, fold);
                 changed = true;
                 continue;
@@ -912,6 +920,7 @@ static bool peephole_sweep(Besm_Block *block, const Frame *frame, const bool *mu
                 // Rule #27 for a global: the whole `utc name` + `xta` group reloads a
                 // location A already holds.  Delete setter and consumer together.
                 if (consumer->kind == BESM_MEM_XTA && loc_eq(gl, st.a_loc)) {
+                    besm_peep_stats.fired[PEEP_RELOAD]++;
                     Besm_Instr *next = consumer->next;
                     delete_group(block, prev, cur, count);
                     cur     = next;
@@ -940,7 +949,8 @@ static bool peephole_sweep(Besm_Block *block, const Frame *frame, const bool *mu
 
         bool deleted = false;
         for (size_t r = 0; r < NUM_RULES; r++) {
-            if (rule_table[r](cur, &st)) {
+            if (rule_table[r].match(cur, &st)) {
+                besm_peep_stats.fired[rule_table[r].stat]++;
                 Besm_Instr *next = cur->next;
                 delete_instr(block, prev, cur);
                 cur     = next;
@@ -952,8 +962,17 @@ static bool peephole_sweep(Besm_Block *block, const Frame *frame, const bool *mu
         // Rule #28: dead temp-store elimination (needs look-ahead + the frame).
         // Rule #29(b): dead NTR elimination (needs forward look-ahead).
         // Rule #31(a): jump to the immediately following label (needs look-ahead).
-        if (!deleted && (dead_temp_store(cur, frame, multiblock) || dead_ntr_set(cur) ||
-                         jump_to_next_label(cur))) {
+        Besm_PeepRule lookahead = PEEP_NUM_RULES;
+        if (!deleted) {
+            if (dead_temp_store(cur, frame, multiblock))
+                lookahead = PEEP_DEAD_STORE;
+            else if (dead_ntr_set(cur))
+                lookahead = PEEP_DEAD_NTR;
+            else if (jump_to_next_label(cur))
+                lookahead = PEEP_JUMP_NEXT;
+        }
+        if (lookahead != PEEP_NUM_RULES) {
+            besm_peep_stats.fired[lookahead]++;
             Besm_Instr *next = cur->next;
             delete_instr(block, prev, cur);
             cur     = next;
@@ -963,10 +982,14 @@ static bool peephole_sweep(Besm_Block *block, const Frame *frame, const bool *mu
         // Rule #32: I/O address folding.  Each removes one or two nodes at the cursor and
         // rewrites the `xts`/`wtc`/`ext` trailer that follows in place.
         if (!deleted) {
-            int fold = try_io_displacement_fusion(cur);
-            if (fold == 0)
+            Besm_PeepRule rule = PEEP_IO_DISPLACEMENT;
+            int fold           = try_io_displacement_fusion(cur);
+            if (fold == 0) {
+                rule = PEEP_IO_ADDRESS;
                 fold = try_io_memory_address(cur);
+            }
             if (fold > 0) {
+                besm_peep_stats.fired[rule]++;
                 cur     = delete_run(block, prev, cur, fold);
                 changed = true;
                 deleted = true;
@@ -975,6 +998,7 @@ static bool peephole_sweep(Besm_Block *block, const Frame *frame, const bool *mu
         // Rule #31(c): invert a conditional that only skips an unconditional jump.
         // It mutates `cur` in place and deletes the following `uj`, so re-test `cur`.
         if (!deleted && try_invert_branch_over_jump(block, cur)) {
+            besm_peep_stats.fired[PEEP_INVERT]++;
             changed = true;
             continue; // prev and tracked state stay valid; re-test the rewritten cur
         }
@@ -1008,13 +1032,48 @@ static bool peephole_sweep(Besm_Block *block, const Frame *frame, const bool *mu
     return changed;
 }
 
+Besm_PeepStats besm_peep_stats;
+
+void besm_peep_stats_print_header(FILE *out)
+{
+    fprintf(out, "%-24s %6s %7s %7s %6s %6s %6s %6s %6s %6s %6s %6s %6s\n", "function", "sweeps",
+            "before", "after", "#27", "#28", "#29a", "#29b", "#31a", "#31b", "#31c", "#32a",
+            "#32b");
+}
+
+void besm_peep_stats_print(FILE *out, const char *name, const Besm_PeepStats *since)
+{
+    static const Besm_PeepStats zero;
+    if (!since)
+        since = &zero;
+    fprintf(out, "%-24s %6lu %7lu %7lu", name, besm_peep_stats.sweeps - since->sweeps,
+            besm_peep_stats.instrs_before - since->instrs_before,
+            besm_peep_stats.instrs_after - since->instrs_after);
+    for (int r = 0; r < PEEP_NUM_RULES; r++)
+        fprintf(out, " %6lu", besm_peep_stats.fired[r] - since->fired[r]);
+    fprintf(out, "\n");
+}
+
+// Machine instructions in a block, for the before/after counts; labels and assembler
+// directives cost nothing at run time and are left out.
+static unsigned long count_instrs(const Besm_Block *block)
+{
+    unsigned long n = 0;
+    for (const Besm_Instr *i = block->body; i; i = i->next)
+        if (i->kind < BESM_STMT_LABEL)
+            n++;
+    return n;
+}
+
 void besm_peephole(Besm_Func *func, const Frame *frame)
 {
     if (!func)
         return;
     int num_autos = frame ? frame_num_autos(frame) : 0;
     for (Besm_Func *fn = func; fn; fn = fn->next) {
+        besm_peep_stats.functions++;
         for (Besm_Block *block = fn->blocks; block; block = block->next) {
+            besm_peep_stats.instrs_before += count_instrs(block);
             // The multi-block classification only ever goes stale in the safe direction.
             // Deleting a `wtc %p` + `xta` reload group drops a read of `%p`, which may
             // have been that block's only reference to the slot; the slot then stays
@@ -1023,8 +1082,10 @@ void besm_peephole(Besm_Func *func, const Frame *frame)
             // single-block wrongly.  Compute it once before the fixpoint loop.
             bool *multiblock = compute_multiblock(block, num_autos);
             // Iterate to a fixpoint: one rewrite can expose another.
-            while (peephole_sweep(block, frame, multiblock))
-                ;
+            do
+                besm_peep_stats.sweeps++;
+            while (peephole_sweep(block, frame, multiblock));
+            besm_peep_stats.instrs_after += count_instrs(block);
             if (multiblock)
                 xfree(multiblock);
         }
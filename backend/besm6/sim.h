@@ -0,0 +1,122 @@
+//
+// Private declarations of the BESM-6 simulator.
+//
+#ifndef BESM6_SIM_H
+#define BESM6_SIM_H
+
+#include <stdbool.h>
+
+#include "besm_sim.h"
+#include "string_map.h"
+
+#define SIM_MEM_WORDS  32768                     // 15-bit word address space
+#define SIM_ADDR_MASK  077777                    // address field, index registers, C
+#define SIM_WORD_MASK  ((UINT64_C(1) << 48) - 1) // 48-bit machine word
+#define SIM_STACK_BASE 070000                    // initial M[017]; the heap ends here
+#define SIM_REG_SP     15                        // stack pointer M[017]
+#define SIM_NKINDS     (BESM_DATA_Z00 + 1)
+
+//
+// A translation unit: the names its toplevels define, static ones included.
+//
+typedef struct Sim_Unit Sim_Unit;
+struct Sim_Unit {
+    Sim_Unit *next;
+    StringMap names;
+};
+
+//
+// A loaded module, with the labels only its own instructions can see (%L labels,
+// folded strings, static locals, assembler-local labels).
+//
+typedef struct Sim_Module Sim_Module;
+struct Sim_Module {
+    Sim_Module *next;
+    Besm_Module *module;
+    Sim_Unit *unit;
+    StringMap labels;
+};
+
+//
+// The code range of one Besm_Func, and what it cost.
+//
+typedef struct {
+    const char *name;
+    unsigned entry; // code address of the first instruction
+    uint64_t instructions;
+    uint64_t cycles;
+    uint64_t calls;
+} Sim_Function;
+
+//
+// One machine instruction, its address field resolved: a symbol plus offset, the pool
+// address of a literal, or a plain number, truncated to 15 bits.
+//
+typedef struct {
+    Besm_InstrKind kind;
+    unsigned reg;
+    unsigned field;
+    int opcode; // extracode
+    int func;   // index into `funcs`
+} Sim_Op;
+
+struct Besm_Sim {
+    FILE *out;
+    Sim_Unit *units;
+    Sim_Module *modules;
+    Sim_Module **tail;
+    StringMap globals;  // names with external linkage
+    StringMap literals; // pooled literal word (octal text) -> address
+    bool ran;
+
+    // Image, built by sim_link().
+    unsigned ncode;     // code occupies addresses 1..ncode
+    unsigned brk;       // next free data word
+    Sim_Op *ops;        // indexed by code address
+    int nfuncs;
+    Sim_Function *funcs;
+    unsigned start;     // entry of the startup code
+    uint64_t mem[SIM_MEM_WORDS];
+
+    // Machine state.
+    uint64_t A, Y;
+    unsigned R, C;
+    unsigned M[16];
+    unsigned pc;
+    bool halted;
+    int status;
+
+    // Counters.
+    uint64_t instructions;
+    uint64_t cycles;
+    uint64_t kind_count[SIM_NKINDS];
+};
+
+//
+// Report a fault and exit.  The message names the function being executed, if any.
+//
+_Noreturn void sim_trap(const Besm_Sim *sim, const char *message, ...);
+
+//
+// Add a module to the image as part of `unit`; the simulator takes ownership.
+//
+void sim_add_module(Besm_Sim *sim, Besm_Module *module, Sim_Unit *unit);
+Sim_Unit *sim_new_unit(Besm_Sim *sim);
+
+//
+// Read one b6as source file into a module (sim_asm.c).
+//
+Besm_Module *sim_assemble(const char *path);
+
+//
+// Lay out and resolve every loaded module, including the startup code that calls
+// main(argc, argv) (sim_load.c).
+//
+void sim_link(Besm_Sim *sim, int argc, char *const argv[]);
+
+//
+// Execute from the startup code until exit (sim_exec.c).
+//
+void sim_execute(Besm_Sim *sim);
+
+#endif // BESM6_SIM_H
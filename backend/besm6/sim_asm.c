@@ -0,0 +1,332 @@
+//
+// BESM-6 simulator: a reader for the b6as sources of the runtime library.
+//
+// Only the subset that libc/besm6/unix uses is accepted (docs/Besm6_Unix_Assembler.md):
+//
+//     label:                      a label, on its own line or before an instruction
+//     [reg] mnemonic [operand]    a machine instruction; `$NN` is extracode NN (octal)
+//     .text / .data / .bss        select the segment
+//     .globl name                 export a label
+//     .word expr                  one data word: a number or a name
+//
+// An operand is a sum of numbers and at most one name, or a `#`-pool literal.  A number
+// is decimal, octal with a leading 0, or left-aligned octal `0'NNN`; `'` groups digits.
+// `//` starts a comment.
+//
+// A file becomes one module with one function, named after its first exported label;
+// any other exported label is a secondary entry.  Data words land in the same function
+// body, after the code, the way genbesm splices static locals, and each data label is a
+// zero-length BSS item.
+//
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal.h"
+#include "phase.h"
+#include "sim.h"
+#include "string_map.h"
+#include "xalloc.h"
+
+typedef struct {
+    const char *path;
+    int lineno;
+    StringMap globls; // names of .globl directives
+    bool in_data;     // current segment is .data or .bss
+    Besm_Func *func;
+    Besm_Instr **tail;
+} Asm;
+
+static _Noreturn void asm_error(const Asm *as, const char *message, const char *text)
+{
+    fprintf(stderr, "%s:%d: %s: %s\n", as->path, as->lineno, message, text);
+    exit(1);
+}
+
+static Besm_Instr *asm_append(Asm *as, Besm_InstrKind kind)
+{
+    Besm_Instr *instr = besm_new_instr(kind);
+    *as->tail         = instr;
+    as->tail          = &instr->next;
+    return instr;
+}
+
+static const char *skip_space(const char *p)
+{
+    while (*p == ' ' || *p == '\t')
+        p++;
+    return p;
+}
+
+static bool is_name_char(int c)
+{
+    return isalnum(c) || c == '_' || c == '$' || c == '.';
+}
+
+//
+// Parse one number: decimal, octal with a leading 0, or left-aligned octal 0'NNN.
+//
+static const char *parse_number(const Asm *as, const char *p, uint64_t *value)
+{
+    uint64_t v = 0;
+    if (p[0] == '0' && p[1] == '\'') {
+        int ndigits = 0;
+        for (p += 2; (*p >= '0' && *p <= '7') || *p == '\''; p++) {
+            if (*p != '\'') {
+                v = (v << 3) | (uint64_t)(*p - '0');
+                ndigits++;
+            }
+        }
+        if (ndigits == 0 || ndigits > 16)
+            asm_error(as, "bad left-aligned number", p);
+        v <<= 48 - 3 * ndigits;
+    } else if (p[0] == '0') {
+        for (; (*p >= '0' && *p <= '7') || *p == '\''; p++)
+            if (*p != '\'')
+                v = (v << 3) | (uint64_t)(*p - '0');
+    } else {
+        for (; isdigit((unsigned char)*p); p++)
+            v = v * 10 + (uint64_t)(*p - '0');
+    }
+    if (isalnum((unsigned char)*p))
+        asm_error(as, "bad number", p);
+    *value = v;
+    return p;
+}
+
+//
+// Parse an operand expression into a name (NULL when there is none) and a number.
+//
+static void parse_expr(const Asm *as, const char *p, char *name, size_t name_size,
+                       int64_t *value)
+{
+    int64_t sum = 0;
+    name[0]     = '\0';
+    int sign    = 1;
+    if (*p == '-' || *p == '+') {
+        sign = (*p == '-') ? -1 : 1;
+        p++;
+    }
+    for (;;) {
+        p = skip_space(p);
+        if (isdigit((unsigned char)*p)) {
+            uint64_t v;
+            p = parse_number(as, p, &v);
+            sum += sign * (int64_t)v;
+        } else if (is_name_char((unsigned char)*p) && sign > 0 && !name[0]) {
+            size_t n = 0;
+            while (is_name_char((unsigned char)*p) && n + 1 < name_size)
+                name[n++] = *p++;
+            name[n] = '\0';
+        } else {
+            asm_error(as, "bad operand", p);
+        }
+        p = skip_space(p);
+        if (*p == '\0')
+            break;
+        if (*p != '+' && *p != '-')
+            asm_error(as, "bad operand", p);
+        sign = (*p == '-') ? -1 : 1;
+        p++;
+    }
+    *value = sum;
+}
+
+static void define_label(Asm *as, const char *label)
+{
+    if (as->in_data) {
+        // A label point in the data: a zero-length reservation.
+        Besm_Instr *bss = asm_append(as, BESM_DATA_BSS);
+        bss->name       = xstrdup(label);
+        return;
+    }
+    Besm_InstrKind kind = BESM_STMT_LABEL;
+    if (map_get(&as->globls, label, NULL)) {
+        if (!as->func->name) {
+            as->func->name = xstrdup(label);
+            kind           = BESM_STMT_NAME;
+        } else {
+            kind = BESM_STMT_ENTRY;
+        }
+    }
+    asm_append(as, kind)->name = xstrdup(label);
+}
+
+static void assemble_directive(Asm *as, const char *dir, const char *arg)
+{
+    if (strcmp(dir, ".text") == 0) {
+        as->in_data = false;
+    } else if (strcmp(dir, ".data") == 0 || strcmp(dir, ".bss") == 0) {
+        as->in_data = true;
+    } else if (strcmp(dir, ".globl") == 0) {
+        // Collected by the first pass.
+    } else if (strcmp(dir, ".word") == 0) {
+        if (!as->in_data)
+            asm_error(as, "code and data words cannot mix", dir);
+        char name[64];
+        int64_t value;
+        parse_expr(as, arg, name, sizeof(name), &value);
+        if (name[0]) {
+            // An address word: a plain-pointer Z00 pair.
+            asm_append(as, BESM_DATA_Z00);
+            Besm_Instr *low = asm_append(as, BESM_DATA_Z00);
+            low->name       = xstrdup(name);
+            low->addr       = (int)value;
+        } else {
+            asm_append(as, BESM_DATA_LOG)->log_val = (uint64_t)value & SIM_WORD_MASK;
+        }
+    } else {
+        asm_error(as, "unsupported directive", dir);
+    }
+}
+
+static Besm_InstrKind lookup_mnemonic(const Asm *as, const char *mnem)
+{
+    for (int k = 0; k <= BESM_IO_EXTRACODE; k++)
+        if (besm_latin_mnem[k] && strcmp(besm_latin_mnem[k], mnem) == 0)
+            return (Besm_InstrKind)k;
+    asm_error(as, "unknown instruction", mnem);
+}
+
+static void assemble_instr(Asm *as, const char *p)
+{
+    if (as->in_data)
+        asm_error(as, "instruction in the data segment", p);
+
+    unsigned reg = 0;
+    if (isdigit((unsigned char)*p)) {
+        while (isdigit((unsigned char)*p))
+            reg = reg * 10 + (unsigned)(*p++ - '0');
+        if (reg > 15)
+            asm_error(as, "bad register", p);
+        p = skip_space(p);
+    }
+    char mnem[16];
+    size_t n = 0;
+    while (*p && *p != ' ' && *p != '\t' && n + 1 < sizeof(mnem))
+        mnem[n++] = *p++;
+    mnem[n]         = '\0';
+    const char *arg = skip_space(p);
+
+    Besm_Instr *instr;
+    if (mnem[0] == '$') {
+        instr         = asm_append(as, BESM_IO_EXTRACODE);
+        instr->opcode = (int)strtol(mnem + 1, NULL, 8);
+    } else {
+        instr = asm_append(as, lookup_mnemonic(as, mnem));
+    }
+    instr->reg = reg;
+    if (*arg == '\0')
+        return;
+
+    if (*arg == '#') {
+        // A pool literal, kept in the IR's own literal spelling.
+        uint64_t word;
+        const char *end = parse_number(as, arg + 1, &word);
+        if (*skip_space(end) != '\0')
+            asm_error(as, "bad literal", arg);
+        char text[32];
+        snprintf(text, sizeof(text), "=%llo", (unsigned long long)(word & SIM_WORD_MASK));
+        instr->name = xstrdup(text);
+        return;
+    }
+    char name[64];
+    int64_t value;
+    parse_expr(as, arg, name, sizeof(name), &value);
+    if (name[0]) {
+        if (besm_operand_shape(instr->kind) == BESM_SHAPE_IMM0)
+            asm_error(as, "name in an immediate operand", arg);
+        instr->name = xstrdup(name);
+    }
+    instr->addr = (int)value;
+}
+
+static void collect_globls(Asm *as, FILE *f)
+{
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        const char *p = skip_space(line);
+        if (strncmp(p, ".globl", 6) != 0)
+            continue;
+        p = skip_space(p + 6);
+        char name[64];
+        size_t n = 0;
+        while (is_name_char((unsigned char)*p) && n + 1 < sizeof(name))
+            name[n++] = *p++;
+        name[n] = '\0';
+        map_insert(&as->globls, name, 1, 0);
+    }
+    rewind(f);
+}
+
+Besm_Module *sim_assemble(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+
+    const char *base = strrchr(path, '/');
+    base             = base ? base + 1 : path;
+    char modname[64];
+    snprintf(modname, sizeof(modname), "%.*s", (int)strcspn(base, "."), base);
+
+    phase_begin("assemble");
+    Asm as = { .path = path };
+    map_init(&as.globls);
+    collect_globls(&as, f);
+
+    Besm_Module *module = besm_new_module(modname);
+    as.func             = besm_new_func(NULL, BESM_CC_INTERNAL);
+    as.func->global     = true;
+    as.func->blocks     = besm_new_block();
+    as.tail             = &as.func->blocks->body;
+    module->funcs       = as.func;
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        as.lineno++;
+        char *comment = strstr(line, "//");
+        if (comment)
+            *comment = '\0';
+        line[strcspn(line, "\r\n")] = '\0';
+        for (size_t len = strlen(line); len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t');)
+            line[--len] = '\0';
+
+        const char *p = skip_space(line);
+        if (*p == '\0')
+            continue;
+
+        // label:
+        const char *q = p;
+        while (is_name_char((unsigned char)*q))
+            q++;
+        if (q > p && *q == ':' && !isdigit((unsigned char)*p)) {
+            char label[64];
+            snprintf(label, sizeof(label), "%.*s", (int)(q - p), p);
+            define_label(&as, label);
+            p = skip_space(q + 1);
+            if (*p == '\0')
+                continue;
+        }
+
+        if (*p == '.') {
+            char dir[16];
+            size_t n = 0;
+            while (*p && *p != ' ' && *p != '\t' && n + 1 < sizeof(dir))
+                dir[n++] = *p++;
+            dir[n] = '\0';
+            assemble_directive(&as, dir, skip_space(p));
+        } else {
+            assemble_instr(&as, p);
+        }
+    }
+    fclose(f);
+    map_destroy(&as.globls);
+
+    if (!as.func->name)
+        as.func->name = xstrdup(modname);
+    phase_end();
+    return module;
+}
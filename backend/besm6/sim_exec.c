@@ -0,0 +1,794 @@
+//
+// BESM-6 simulator: instruction execution.
+//
+// Semantics follow docs/Besm6_Instruction_Set.md.  A floating-point result is formed
+// as an 81-bit value, the 41-bit mantissa with the 40 bits of the Y extension below
+// it, then normalized and rounded under the control of R, as the hardware does.
+//
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal.h"
+#include "phase.h"
+#include "sim.h"
+#include "xalloc.h"
+
+#define BIT41    (UINT64_C(1) << 40)       // mantissa sign
+#define BIT48    (UINT64_C(1) << 47)       // top bit; fat-pointer marker
+#define MANTISSA ((UINT64_C(1) << 41) - 1) // bits 41-1
+#define LOW40    ((UINT64_C(1) << 40) - 1) // bits 40-1: the Y extension of a result
+
+#define RAU_NORM_DISABLE   001
+#define RAU_ROUND_DISABLE  002
+#define RAU_LOGICAL        004
+#define RAU_MULTIPLICATIVE 010
+#define RAU_ADDITIVE       020
+#define RAU_MODE           034
+#define RAU_OVF_DISABLE    040
+
+//
+// Approximate cost of each instruction kind, in machine cycles.  The figures are
+// relative: a register transfer costs 1, a memory access 2, a floating-point add
+// about 4, a multiply 8 and a divide 20.  They rank code sequences; they do not
+// predict wall-clock time on the real machine.
+//
+static const unsigned char cycle_cost[SIM_NKINDS] = {
+    [BESM_MEM_XTA] = 2,      [BESM_MEM_ATX] = 2,      [BESM_MEM_STX] = 3,
+    [BESM_MEM_XTS] = 3,      [BESM_MEM_ITA] = 1,      [BESM_MEM_ATI] = 1,
+    [BESM_MEM_ITS] = 2,      [BESM_MEM_STI] = 2,      [BESM_MEM_MTJ] = 1,
+    [BESM_ARITH_ADD] = 4,    [BESM_ARITH_SUB] = 4,    [BESM_ARITH_RSUB] = 4,
+    [BESM_ARITH_ABSSUB] = 4, [BESM_ARITH_MUL] = 8,    [BESM_ARITH_DIV] = 20,
+    [BESM_ARITH_CNEG] = 3,   [BESM_LOG_AAX] = 2,      [BESM_LOG_AOX] = 2,
+    [BESM_LOG_AEX] = 2,      [BESM_LOG_ARX] = 3,      [BESM_LOG_APX] = 4,
+    [BESM_LOG_AUX] = 4,      [BESM_LOG_ACX] = 4,      [BESM_LOG_ANX] = 4,
+    [BESM_EXP_EADDX] = 3,    [BESM_EXP_ESUBX] = 3,    [BESM_EXP_SHIFTX] = 3,
+    [BESM_EXP_SETRMEM] = 2,  [BESM_EXP_GETR] = 1,     [BESM_EXP_YTA] = 1,
+    [BESM_EXP_EADDN] = 2,    [BESM_EXP_ESUBN] = 2,    [BESM_EXP_SHIFTN] = 2,
+    [BESM_EXP_SETR] = 1,     [BESM_REG_VTM] = 1,      [BESM_REG_UTM] = 1,
+    [BESM_REG_JADDM] = 1,    [BESM_MOD_UTC] = 1,      [BESM_MOD_WTC] = 2,
+    [BESM_BRANCH_UZA] = 2,   [BESM_BRANCH_U1A] = 2,   [BESM_BRANCH_UJ] = 2,
+    [BESM_BRANCH_VJM] = 2,   [BESM_BRANCH_VZM] = 2,   [BESM_BRANCH_V1M] = 2,
+    [BESM_BRANCH_VLM] = 2,   [BESM_BRANCH_CALL] = 2,  [BESM_BRANCH_STOP] = 1,
+    [BESM_IO_EXT] = 2,       [BESM_IO_MOD] = 2,       [BESM_IO_EXTRACODE] = 10,
+};
+
+_Noreturn void sim_trap(const Besm_Sim *sim, const char *message, ...)
+{
+    fflush(sim->out);
+    fprintf(stderr, "besmsim: ");
+    if (sim->ops && sim->pc >= 1 && sim->pc <= sim->ncode)
+        fprintf(stderr, "in %s at %05o: ", sim->funcs[sim->ops[sim->pc].func].name, sim->pc);
+
+    va_list ap;
+    va_start(ap, message);
+    vfprintf(stderr, message, ap);
+    va_end(ap);
+
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+//
+// Memory: word 0 always reads as zero and ignores stores.
+//
+static uint64_t load(const Besm_Sim *sim, unsigned addr)
+{
+    return sim->mem[addr & SIM_ADDR_MASK];
+}
+
+static void store(Besm_Sim *sim, unsigned addr, uint64_t word)
+{
+    addr &= SIM_ADDR_MASK;
+    if (addr != 0)
+        sim->mem[addr] = word & SIM_WORD_MASK;
+}
+
+static void set_index(Besm_Sim *sim, unsigned reg, unsigned value)
+{
+    if (reg != 0)
+        sim->M[reg] = value & SIM_ADDR_MASK;
+}
+
+static void push(Besm_Sim *sim, uint64_t word)
+{
+    store(sim, sim->M[SIM_REG_SP], word);
+    sim->M[SIM_REG_SP] = (sim->M[SIM_REG_SP] + 1) & SIM_ADDR_MASK;
+}
+
+static unsigned pop(Besm_Sim *sim)
+{
+    sim->M[SIM_REG_SP] = (sim->M[SIM_REG_SP] - 1) & SIM_ADDR_MASK;
+    return sim->M[SIM_REG_SP];
+}
+
+static void set_mode(Besm_Sim *sim, unsigned mode)
+{
+    sim->R = (sim->R & ~RAU_MODE) | mode;
+}
+
+//
+// The condition UZA and U1A test, selected by the ω group of R.
+//
+static bool omega(const Besm_Sim *sim)
+{
+    switch (sim->R & RAU_MODE) {
+    case RAU_ADDITIVE:
+        return (sim->A & BIT41) != 0;
+    case RAU_MULTIPLICATIVE:
+        return (sim->A & BIT48) == 0;
+    case RAU_LOGICAL:
+        return sim->A != 0;
+    default:
+        return true;
+    }
+}
+
+// The value of an integer word: 41-bit two's complement.
+static int64_t signed_word(uint64_t word)
+{
+    int64_t v = (int64_t)(word & MANTISSA);
+    return (v & (int64_t)BIT41) ? v - ((int64_t)1 << 41) : v;
+}
+
+static int exponent(uint64_t word)
+{
+    return (int)((word >> 41) & 0177);
+}
+
+//
+// Floating point.
+//
+
+// Store a result: `v` holds the mantissa in bits 81-41 and its extension in bits 40-1,
+// scaled by 2^(e-64).  `lost` says nonzero bits fell off below the extension.
+static void fp_result(Besm_Sim *sim, int e, __int128 v, bool lost)
+{
+    if (!(sim->R & RAU_NORM_DISABLE)) {
+        if (v == 0) {
+            sim->A = 0;
+            sim->Y &= ~LOW40;
+            return;
+        }
+        // Shift left until mantissa bits 41 and 40 differ.
+        for (;;) {
+            int top = (int)((v >> 79) & 3);
+            if (top == 1 || top == 2)
+                break;
+            v *= 2;
+            e--;
+        }
+    }
+    int64_t m   = (int64_t)(v >> 40);
+    uint64_t mr = (uint64_t)v & LOW40;
+    if (e < 0) {
+        // Exponent underflow: machine zero.
+        sim->A = 0;
+        sim->Y &= ~LOW40;
+        return;
+    }
+    if (!(sim->R & RAU_ROUND_DISABLE) && (lost || mr != 0))
+        m |= 1;
+    if (m == 0 && !(sim->R & RAU_NORM_DISABLE)) {
+        sim->A = 0;
+        sim->Y &= ~LOW40;
+        return;
+    }
+    if (e > 0177 && !(sim->R & RAU_OVF_DISABLE))
+        sim_trap(sim, "floating-point overflow");
+    sim->A = ((uint64_t)(e & 0177) << 41) | ((uint64_t)m & MANTISSA);
+    sim->Y = (sim->Y & ~LOW40) | mr;
+}
+
+// Bring a sum back into the 41-bit mantissa range by shifting right: the hardware does
+// this even when normalization is off.
+static __int128 fit_mantissa(__int128 v, int *e, bool *lost)
+{
+    const __int128 limit = (__int128)1 << 80;
+    while (v >= limit || v < -limit) {
+        *lost = *lost || (v & 1);
+        v >>= 1;
+        (*e)++;
+    }
+    return v;
+}
+
+// A+X, A-X, X-A, and |A|-|X| when both negations are requested.
+static void fp_add(Besm_Sim *sim, uint64_t x, bool negate_a, bool negate_x)
+{
+    int64_t ma = signed_word(sim->A), mx = signed_word(x);
+    int ea = exponent(sim->A), ex = exponent(x);
+    if (negate_a && negate_x) {
+        ma = ma < 0 ? -ma : ma;
+        mx = mx > 0 ? -mx : mx;
+    } else {
+        if (negate_a)
+            ma = -ma;
+        if (negate_x)
+            mx = -mx;
+    }
+
+    // Align the operand with the smaller exponent; its low bits go to the extension.
+    int64_t m1 = ma, m2 = mx;
+    int e      = ex;
+    if (ea > ex) {
+        m1 = mx;
+        m2 = ma;
+        e  = ea;
+    }
+    int diff    = (ea > ex) ? ea - ex : ex - ea;
+    __int128 v1 = (__int128)m1 * ((__int128)1 << 40);
+    bool lost   = false;
+    if (diff > 80) {
+        lost = (m1 != 0);
+        v1   = (m1 < 0) ? -1 : 0;
+    } else if (diff > 0) {
+        lost = (v1 & ((((__int128)1) << diff) - 1)) != 0;
+        v1 >>= diff;
+    }
+    __int128 v = (__int128)m2 * ((__int128)1 << 40) + v1;
+    v          = fit_mantissa(v, &e, &lost);
+    fp_result(sim, e, v, lost);
+}
+
+static void fp_multiply(Besm_Sim *sim, uint64_t x)
+{
+    int64_t ma = signed_word(sim->A), mx = signed_word(x);
+    if (ma == 0 || mx == 0) {
+        sim->A = 0;
+        sim->Y &= ~LOW40;
+        return;
+    }
+    int e      = exponent(sim->A) + exponent(x) - 64;
+    bool lost  = false;
+    __int128 v = fit_mantissa((__int128)ma * mx, &e, &lost);
+    fp_result(sim, e, v, lost);
+}
+
+static void fp_divide(Besm_Sim *sim, uint64_t x)
+{
+    int64_t ma = signed_word(sim->A), mx = signed_word(x);
+    int top    = (int)((mx >> 39) & 3);
+    if (top != 1 && top != 2)
+        sim_trap(sim, "division by zero");
+
+    // The quotient is truncated to 40 fraction bits, with no rounding.
+    int e               = exponent(sim->A) - exponent(x) + 64;
+    bool negative       = (ma < 0) != (mx < 0);
+    unsigned __int128 q = ((unsigned __int128)(ma < 0 ? -ma : ma) << 40) /
+                          (unsigned __int128)(mx < 0 ? -mx : mx);
+    while (q >= ((unsigned __int128)1 << 40)) {
+        q >>= 1;
+        e++;
+    }
+    __int128 m = negative ? -(__int128)q : (__int128)q;
+    sim->Y     = 0;
+    fp_result(sim, e, m * ((__int128)1 << 40), false);
+}
+
+// E+X, E-X, E+N, E-N: add to the exponent of A.
+static void add_exponent(Besm_Sim *sim, int delta)
+{
+    sim->Y = 0;
+    fp_result(sim, exponent(sim->A) + delta, (__int128)signed_word(sim->A) * ((__int128)1 << 40),
+              false);
+}
+
+//
+// Logical operations.
+//
+
+// ASX, ASN: a positive count shifts [A,Y] right, a negative one shifts [Y,A] left.
+static void shift(Besm_Sim *sim, int n)
+{
+    unsigned __int128 v;
+    if (n >= 0) {
+        v      = (n >= 96) ? 0 : ((unsigned __int128)sim->A << 48) >> n;
+        sim->A = (uint64_t)(v >> 48) & SIM_WORD_MASK;
+        sim->Y = (uint64_t)v & SIM_WORD_MASK;
+    } else {
+        v      = (-n >= 96) ? 0 : (unsigned __int128)sim->A << -n;
+        sim->A = (uint64_t)v & SIM_WORD_MASK;
+        sim->Y = (uint64_t)(v >> 48) & SIM_WORD_MASK;
+    }
+}
+
+// 48-bit add with end-around carry (ARX, ACX, ANX).
+static uint64_t add_cyclic(uint64_t a, uint64_t b)
+{
+    uint64_t sum = a + b;
+    if (sum > SIM_WORD_MASK)
+        sum = (sum & SIM_WORD_MASK) + 1;
+    return sum;
+}
+
+static uint64_t pack_bits(uint64_t a, uint64_t mask)
+{
+    uint64_t result = 0;
+    for (int i = 0; i < 48; i++) {
+        if ((mask >> i) & 1) {
+            result >>= 1;
+            result |= ((a >> i) & 1) << 47;
+        }
+    }
+    return result;
+}
+
+static uint64_t unpack_bits(uint64_t a, uint64_t mask)
+{
+    uint64_t result = 0;
+    for (int i = 47; i >= 0; i--) {
+        result <<= 1;
+        if ((mask >> i) & 1) {
+            result |= (a >> 47) & 1;
+            a = (a << 1) & SIM_WORD_MASK;
+        }
+    }
+    return result;
+}
+
+static void highest_bit(Besm_Sim *sim, uint64_t x)
+{
+    if (sim->A == 0) {
+        sim->Y = 0;
+        sim->A = add_cyclic(0, x);
+        return;
+    }
+    int n = 1;
+    while (!((sim->A << (n - 1)) & BIT48))
+        n++;
+    sim->Y = (n == 48) ? 0 : (sim->A << n) & SIM_WORD_MASK;
+    sim->A = add_cyclic((uint64_t)n, x);
+}
+
+//
+// Extracode 077: the b6sim system calls.  The arguments of a call f(a, b, c) are on
+// the stack (a at M[017]-2, b at M[017]-1) and in the accumulator (c).
+//
+
+// The word address and byte number of a char* fat pointer.
+static unsigned byte_position(uint64_t ptr)
+{
+    unsigned pos = (unsigned)(ptr & SIM_ADDR_MASK) * 6;
+    if (ptr & BIT48)
+        pos += 5 - (unsigned)((ptr >> 44) & 7);
+    return pos;
+}
+
+static void system_call(Besm_Sim *sim, unsigned number)
+{
+    int64_t fd    = signed_word(load(sim, sim->M[SIM_REG_SP] - 2));
+    unsigned pos  = byte_position(load(sim, sim->M[SIM_REG_SP] - 1));
+    int64_t count = signed_word(sim->A);
+
+    switch (number) {
+    case 1: // exit(status)
+        sim->halted = true;
+        sim->status = (int)signed_word(sim->A);
+        break;
+    case 3: // read(fd, buf, count)
+        for (int64_t i = 0; i < count; i++, pos++) {
+            int c = getchar();
+            if (c == EOF) {
+                count = i;
+                break;
+            }
+            unsigned shift_bits = 40 - 8 * (pos % 6);
+            uint64_t word       = load(sim, pos / 6) & ~((uint64_t)0377 << shift_bits);
+            store(sim, pos / 6, word | ((uint64_t)c << shift_bits));
+        }
+        sim->A = (uint64_t)count & MANTISSA;
+        break;
+    case 4: // write(fd, buf, count)
+        for (int64_t i = 0; i < count; i++, pos++) {
+            int c = (int)(load(sim, pos / 6) >> (40 - 8 * (pos % 6))) & 0377;
+            putc(c, fd == 2 ? stderr : sim->out);
+        }
+        sim->A = (uint64_t)count & MANTISSA;
+        break;
+    default:
+        sim_trap(sim, "unsupported system call %u", number);
+    }
+    sim->M[14] = 0; // errno
+}
+
+//
+// Which instructions pop their operand in stack mode (V = 0 and M = 017).
+//
+static bool pops_operand(Besm_InstrKind kind)
+{
+    switch (kind) {
+    case BESM_MEM_XTA:
+    case BESM_ARITH_ADD:
+    case BESM_ARITH_SUB:
+    case BESM_ARITH_RSUB:
+    case BESM_ARITH_ABSSUB:
+    case BESM_ARITH_MUL:
+    case BESM_ARITH_DIV:
+    case BESM_ARITH_CNEG:
+    case BESM_LOG_AAX:
+    case BESM_LOG_AOX:
+    case BESM_LOG_AEX:
+    case BESM_LOG_ARX:
+    case BESM_LOG_APX:
+    case BESM_LOG_AUX:
+    case BESM_LOG_ACX:
+    case BESM_LOG_ANX:
+    case BESM_EXP_EADDX:
+    case BESM_EXP_ESUBX:
+    case BESM_EXP_SHIFTX:
+    case BESM_EXP_SETRMEM:
+    case BESM_MOD_WTC:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void sim_execute(Besm_Sim *sim)
+{
+    sim->pc = sim->start;
+    while (!sim->halted) {
+        if (sim->pc == 0 || sim->pc > sim->ncode)
+            sim_trap(sim, "jump to %05o, outside the code", sim->pc);
+
+        const Sim_Op *op = &sim->ops[sim->pc];
+        Sim_Function *fn = &sim->funcs[op->func];
+        unsigned next    = sim->pc + 1;
+        unsigned v       = (op->field + sim->C) & SIM_ADDR_MASK;
+        unsigned ea      = (sim->M[op->reg] + v) & SIM_ADDR_MASK;
+        unsigned c       = 0; // C after this instruction
+        unsigned cost    = cycle_cost[op->kind];
+
+        sim->instructions++;
+        sim->cycles += cost;
+        sim->kind_count[op->kind]++;
+        fn->instructions++;
+        fn->cycles += cost;
+
+        if (v == 0 && op->reg == SIM_REG_SP && pops_operand(op->kind))
+            ea = pop(sim);
+        uint64_t x = load(sim, ea);
+
+        switch (op->kind) {
+        case BESM_MEM_XTA:
+            sim->A = x;
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_MEM_ATX:
+            store(sim, ea, sim->A);
+            if (v == 0 && op->reg == SIM_REG_SP)
+                sim->M[SIM_REG_SP] = (sim->M[SIM_REG_SP] + 1) & SIM_ADDR_MASK;
+            break;
+        case BESM_MEM_STX:
+            store(sim, ea, sim->A);
+            sim->A = load(sim, pop(sim));
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_MEM_XTS:
+            push(sim, sim->A);
+            sim->A = load(sim, sim->M[op->reg] + v);
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_MEM_ITA:
+            sim->A = sim->M[ea & 017];
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_MEM_ATI:
+            set_index(sim, ea & 017, (unsigned)sim->A);
+            break;
+        case BESM_MEM_ITS:
+            push(sim, sim->A);
+            sim->A = sim->M[ea & 017];
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_MEM_STI:
+            set_index(sim, ea & 017, (unsigned)sim->A);
+            if ((ea & 017) != SIM_REG_SP)
+                sim->A = load(sim, pop(sim));
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_MEM_MTJ:
+            set_index(sim, v & 017, sim->M[op->reg]);
+            break;
+        case BESM_REG_JADDM:
+            set_index(sim, v & 017, sim->M[v & 017] + sim->M[op->reg]);
+            break;
+
+        case BESM_ARITH_ADD:
+            fp_add(sim, x, false, false);
+            set_mode(sim, RAU_ADDITIVE);
+            break;
+        case BESM_ARITH_SUB:
+            fp_add(sim, x, false, true);
+            set_mode(sim, RAU_ADDITIVE);
+            break;
+        case BESM_ARITH_RSUB:
+            fp_add(sim, x, true, false);
+            set_mode(sim, RAU_ADDITIVE);
+            break;
+        case BESM_ARITH_ABSSUB:
+            fp_add(sim, x, true, true);
+            set_mode(sim, RAU_ADDITIVE);
+            break;
+        case BESM_ARITH_CNEG:
+            sim->Y = 0;
+            fp_add(sim, 0, (x & BIT41) != 0, false);
+            set_mode(sim, RAU_ADDITIVE);
+            break;
+        case BESM_ARITH_MUL:
+            fp_multiply(sim, x);
+            set_mode(sim, RAU_MULTIPLICATIVE);
+            break;
+        case BESM_ARITH_DIV:
+            fp_divide(sim, x);
+            set_mode(sim, RAU_MULTIPLICATIVE);
+            break;
+
+        case BESM_LOG_AAX:
+            sim->A &= x;
+            sim->Y = 0;
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_LOG_AOX:
+            sim->A |= x;
+            sim->Y = 0;
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_LOG_AEX:
+            sim->Y = sim->A;
+            sim->A ^= x;
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_LOG_ARX:
+            sim->A = add_cyclic(sim->A, x);
+            sim->Y = 0;
+            set_mode(sim, RAU_MULTIPLICATIVE);
+            break;
+        case BESM_LOG_APX:
+            sim->A = pack_bits(sim->A, x);
+            sim->Y = 0;
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_LOG_AUX:
+            sim->A = unpack_bits(sim->A, x);
+            sim->Y = 0;
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_LOG_ACX:
+            sim->A = add_cyclic((uint64_t)__builtin_popcountll(sim->A), x);
+            sim->Y = 0;
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_LOG_ANX:
+            highest_bit(sim, x);
+            set_mode(sim, RAU_LOGICAL);
+            break;
+
+        case BESM_EXP_EADDX:
+            add_exponent(sim, exponent(x) - 64);
+            set_mode(sim, RAU_MULTIPLICATIVE);
+            break;
+        case BESM_EXP_ESUBX:
+            add_exponent(sim, 64 - exponent(x));
+            set_mode(sim, RAU_MULTIPLICATIVE);
+            break;
+        case BESM_EXP_EADDN:
+            add_exponent(sim, (int)(ea & 0177) - 64);
+            set_mode(sim, RAU_MULTIPLICATIVE);
+            break;
+        case BESM_EXP_ESUBN:
+            add_exponent(sim, 64 - (int)(ea & 0177));
+            set_mode(sim, RAU_MULTIPLICATIVE);
+            break;
+        case BESM_EXP_SHIFTX:
+            shift(sim, exponent(x) - 64);
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_EXP_SHIFTN:
+            shift(sim, (int)(ea & 0177) - 64);
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_EXP_SETRMEM:
+            sim->R = (unsigned)(x >> 41) & 077;
+            break;
+        case BESM_EXP_SETR:
+            sim->R = ea & 077;
+            break;
+        case BESM_EXP_GETR:
+            sim->A = (uint64_t)(sim->R & ea & 0177) << 41;
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        case BESM_EXP_YTA:
+            if ((sim->R & RAU_MODE) == RAU_LOGICAL) {
+                sim->A = sim->Y;
+            } else {
+                int e  = exponent(sim->A) + (int)(ea & 0177) - 64;
+                sim->A = ((uint64_t)(e & 0177) << 41) | (sim->Y & LOW40);
+            }
+            break;
+
+        case BESM_REG_VTM:
+            set_index(sim, op->reg, v);
+            break;
+        case BESM_REG_UTM:
+            set_index(sim, op->reg, sim->M[op->reg] + v);
+            break;
+        case BESM_MOD_UTC:
+            c = ea;
+            break;
+        case BESM_MOD_WTC:
+            c = (unsigned)x & SIM_ADDR_MASK;
+            break;
+
+        case BESM_BRANCH_UZA:
+            sim->Y = sim->A;
+            if (!omega(sim))
+                next = ea;
+            break;
+        case BESM_BRANCH_U1A:
+            sim->Y = sim->A;
+            if (omega(sim))
+                next = ea;
+            break;
+        case BESM_BRANCH_UJ:
+            next = ea;
+            break;
+        case BESM_BRANCH_VJM:
+        case BESM_BRANCH_CALL:
+            set_index(sim, op->kind == BESM_BRANCH_CALL ? 13 : op->reg, next);
+            next = v;
+            if (next >= 1 && next <= sim->ncode) {
+                Sim_Function *callee = &sim->funcs[sim->ops[next].func];
+                if (callee->entry == next)
+                    callee->calls++;
+            }
+            break;
+        case BESM_BRANCH_VZM:
+            if (sim->M[op->reg] == 0)
+                next = v;
+            break;
+        case BESM_BRANCH_V1M:
+            if (sim->M[op->reg] != 0)
+                next = v;
+            break;
+        case BESM_BRANCH_VLM:
+            if (sim->M[op->reg] != 0) {
+                set_index(sim, op->reg, sim->M[op->reg] + 1);
+                next = v;
+            }
+            break;
+        case BESM_BRANCH_STOP:
+            sim->halted = true;
+            break;
+
+        case BESM_IO_EXTRACODE:
+            sim->M[14] = ea;
+            if (op->opcode != 077)
+                sim_trap(sim, "unsupported extracode %o", op->opcode);
+            system_call(sim, ea);
+            set_mode(sim, RAU_LOGICAL);
+            break;
+        default:
+            sim_trap(sim, "privileged instruction %s", besm_latin_mnem[op->kind]);
+        }
+
+        sim->C = c;
+        if (!sim->halted)
+            sim->pc = next;
+    }
+}
+
+int besm_sim_run(Besm_Sim *sim, int argc, char *const argv[])
+{
+    if (sim->ran)
+        sim_trap(sim, "the machine has already run");
+    sim->ran = true;
+    phase_begin("link");
+    sim_link(sim, argc, argv);
+    phase_end();
+
+    phase_begin("execute");
+    sim->M[SIM_REG_SP] = SIM_STACK_BASE;
+    sim_execute(sim);
+    phase_end();
+    fflush(sim->out);
+    return sim->status;
+}
+
+//
+// Counters.
+//
+uint64_t besm_sim_instruction_count(const Besm_Sim *sim)
+{
+    return sim->instructions;
+}
+
+uint64_t besm_sim_cycle_count(const Besm_Sim *sim)
+{
+    return sim->cycles;
+}
+
+uint64_t besm_sim_kind_count(const Besm_Sim *sim, Besm_InstrKind kind)
+{
+    return (unsigned)kind < SIM_NKINDS ? sim->kind_count[kind] : 0;
+}
+
+// Functions of one name (a static function may repeat across units) are summed.
+static uint64_t function_sum(const Besm_Sim *sim, const char *function, int field)
+{
+    uint64_t sum = 0;
+    for (int i = 0; i < sim->nfuncs; i++) {
+        const Sim_Function *f = &sim->funcs[i];
+        if (strcmp(f->name, function) == 0)
+            sum += field == 0 ? f->instructions : field == 1 ? f->cycles : f->calls;
+    }
+    return sum;
+}
+
+uint64_t besm_sim_call_count(const Besm_Sim *sim, const char *function)
+{
+    return function_sum(sim, function, 2);
+}
+
+uint64_t besm_sim_function_count(const Besm_Sim *sim, const char *function)
+{
+    return function_sum(sim, function, 0);
+}
+
+uint64_t besm_sim_function_cycles(const Besm_Sim *sim, const char *function)
+{
+    return function_sum(sim, function, 1);
+}
+
+static int compare_functions(const void *a, const void *b)
+{
+    const Sim_Function *fa = *(const Sim_Function *const *)a;
+    const Sim_Function *fb = *(const Sim_Function *const *)b;
+    if (fa->instructions != fb->instructions)
+        return fa->instructions > fb->instructions ? -1 : 1;
+    if (fa->calls != fb->calls)
+        return fa->calls > fb->calls ? -1 : 1;
+    return strcmp(fa->name, fb->name);
+}
+
+static const char *kind_name(Besm_InstrKind kind)
+{
+    switch (kind) {
+    case BESM_BRANCH_CALL:
+        return "call";
+    case BESM_IO_EXTRACODE:
+        return "extracode";
+    default:
+        return besm_latin_mnem[kind];
+    }
+}
+
+void besm_sim_print_profile(FILE *fd, const Besm_Sim *sim)
+{
+    const Sim_Function **sorted = (const Sim_Function **)xalloc(
+        (sim->nfuncs + 1) * sizeof(Sim_Function *), __func__, __FILE__, __LINE__);
+    int n = 0;
+    for (int i = 0; i < sim->nfuncs; i++)
+        if (sim->funcs[i].instructions > 0)
+            sorted[n++] = &sim->funcs[i];
+    qsort(sorted, n, sizeof(Sim_Function *), compare_functions);
+
+    fprintf(fd, "%12s %12s %10s  %s\n", "instructions", "cycles", "calls", "function");
+    for (int i = 0; i < n; i++)
+        fprintf(fd, "%12llu %12llu %10llu  %s\n", (unsigned long long)sorted[i]->instructions,
+                (unsigned long long)sorted[i]->cycles, (unsigned long long)sorted[i]->calls,
+                sorted[i]->name);
+    xfree(sorted);
+
+    fprintf(fd, "%12s %12s %10s  %s\n", "instructions", "cycles", "percent", "kind");
+    for (int k = 0; k < SIM_NKINDS; k++) {
+        if (sim->kind_count[k] == 0)
+            continue;
+        fprintf(fd, "%12llu %12llu %9.2f%%  %s\n", (unsigned long long)sim->kind_count[k],
+                (unsigned long long)(sim->kind_count[k] * cycle_cost[k]),
+                100.0 * sim->kind_count[k] / sim->instructions, kind_name((Besm_InstrKind)k));
+    }
+    fprintf(fd, "%12llu %12llu %10s  total\n", (unsigned long long)sim->instructions,
+            (unsigned long long)sim->cycles, "");
+}
@@ -0,0 +1,507 @@
+//
+// BESM-6 simulator: loading and linking.
+//
+// Modules are laid out the way b6ld lays out an executable: all code first (one
+// instruction per word address, starting at 1, since word 0 always reads as zero), then
+// the data of every module, then the literal pool; `end` marks the first free word, where
+// malloc's heap starts.  Names resolve innermost first: a module's own labels, then the
+// static names of its translation unit, then the external names of the whole image.
+//
+#include <dirent.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "codegen.h"
+#include "internal.h"
+#include "sim.h"
+#include "xalloc.h"
+
+//
+// A data word whose value is an address, filled in once every name is defined.
+//
+typedef struct Sim_Fixup Sim_Fixup;
+struct Sim_Fixup {
+    Sim_Fixup *next;
+    unsigned addr;
+    const Besm_Instr *item; // BESM_DATA_Z00 pair (high half) or BESM_DATA_REF
+    Sim_Module *module;
+};
+
+Besm_Sim *besm_sim_create(FILE *out)
+{
+    Besm_Sim *sim = (Besm_Sim *)xalloc(sizeof(Besm_Sim), __func__, __FILE__, __LINE__);
+    sim->out      = out;
+    sim->tail     = &sim->modules;
+    map_init(&sim->globals);
+    map_init(&sim->literals);
+    return sim;
+}
+
+void besm_sim_destroy(Besm_Sim *sim)
+{
+    while (sim->modules) {
+        Sim_Module *m = sim->modules;
+        sim->modules  = m->next;
+        besm_free_module(m->module);
+        map_destroy(&m->labels);
+        xfree(m);
+    }
+    while (sim->units) {
+        Sim_Unit *u = sim->units;
+        sim->units  = u->next;
+        map_destroy(&u->names);
+        xfree(u);
+    }
+    map_destroy(&sim->globals);
+    map_destroy(&sim->literals);
+    if (sim->ops)
+        xfree(sim->ops);
+    if (sim->funcs)
+        xfree(sim->funcs);
+    xfree(sim);
+}
+
+Sim_Unit *sim_new_unit(Besm_Sim *sim)
+{
+    Sim_Unit *unit = (Sim_Unit *)xalloc(sizeof(Sim_Unit), __func__, __FILE__, __LINE__);
+    map_init(&unit->names);
+    unit->next = sim->units;
+    sim->units = unit;
+    return unit;
+}
+
+void sim_add_module(Besm_Sim *sim, Besm_Module *module, Sim_Unit *unit)
+{
+    Sim_Module *m = (Sim_Module *)xalloc(sizeof(Sim_Module), __func__, __FILE__, __LINE__);
+    m->module     = module;
+    m->unit       = unit;
+    map_init(&m->labels);
+    *sim->tail = m;
+    sim->tail  = &m->next;
+}
+
+void besm_sim_load_program(Besm_Sim *sim, const Tac_TopLevel *program)
+{
+    Sim_Unit *unit = sim_new_unit(sim);
+    for (const Tac_TopLevel *tl = program; tl; tl = tl->next) {
+        Besm_Module *module = codegen_module(program, tl, BESM_UNIX);
+        if (module)
+            sim_add_module(sim, module, unit);
+    }
+}
+
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static bool is_runtime_source(const char *name)
+{
+    size_t len = strlen(name);
+    return len > 2 && strcmp(name + len - 2, ".s") == 0 && strcmp(name, "crt0.s") != 0;
+}
+
+void besm_sim_load_assembly(Besm_Sim *sim, const char *path)
+{
+    DIR *dir = opendir(path);
+    if (!dir) {
+        sim_add_module(sim, sim_assemble(path), sim_new_unit(sim));
+        return;
+    }
+
+    // Load in name order, so that the layout does not depend on the directory.
+    int count = 0;
+    for (struct dirent *e = readdir(dir); e; e = readdir(dir))
+        if (is_runtime_source(e->d_name))
+            count++;
+    char **names = (char **)xalloc((count + 1) * sizeof(char *), __func__, __FILE__, __LINE__);
+    int n        = 0;
+    rewinddir(dir);
+    for (struct dirent *e = readdir(dir); e && n < count; e = readdir(dir))
+        if (is_runtime_source(e->d_name))
+            names[n++] = xstrdup(e->d_name);
+    closedir(dir);
+    qsort(names, n, sizeof(char *), compare_names);
+
+    for (int i = 0; i < n; i++) {
+        size_t len = strlen(path) + strlen(names[i]) + 2;
+        char *file = (char *)xalloc(len, __func__, __FILE__, __LINE__);
+        snprintf(file, len, "%s/%s", path, names[i]);
+        sim_add_module(sim, sim_assemble(file), sim_new_unit(sim));
+        xfree(file);
+        xfree(names[i]);
+    }
+    xfree(names);
+}
+
+//
+// Startup code: crt0.s, with real arguments.  argv is a word pointer to an array of
+// char* fat pointers, each to a packed string.
+//
+static Besm_Instr *append(Besm_Instr ***tail, Besm_InstrKind kind, unsigned reg, int addr,
+                          const char *name)
+{
+    Besm_Instr *instr = besm_new_instr(kind);
+    instr->reg        = reg;
+    instr->addr       = addr;
+    if (name)
+        instr->name = xstrdup(name);
+    **tail = instr;
+    *tail  = &instr->next;
+    return instr;
+}
+
+static void append_z00(Besm_Instr ***tail, unsigned high, const char *label, const char *name)
+{
+    Besm_Instr *z00a = append(tail, BESM_DATA_Z00, high, 0, NULL);
+    if (label)
+        z00a->label = xstrdup(label);
+    append(tail, BESM_DATA_Z00, 0, 0, name);
+}
+
+static Besm_Module *startup_module(const Besm_Sim *sim, int argc, char *const argv[])
+{
+    Besm_Module *module = besm_new_module("_start");
+    Besm_Func *func     = besm_new_func("_start", BESM_CC_INTERNAL);
+    module->funcs       = func;
+    func->blocks        = besm_new_block();
+    Besm_Instr **tail   = &func->blocks->body;
+
+    append(&tail, BESM_STMT_NAME, 0, 0, "_start");
+    append(&tail, BESM_MEM_XTA, 0, 0, "argc");
+    append(&tail, BESM_MEM_XTS, 0, 0, "argv");
+    append(&tail, BESM_REG_VTM, 14, -2, NULL);
+    append(&tail, BESM_BRANCH_CALL, 0, 0, "main");
+    append(&tail, BESM_MEM_ATX, SIM_REG_SP, 0, NULL);
+    intptr_t unused;
+    if (map_get(&sim->globals, "flush", &unused))
+        append(&tail, BESM_BRANCH_CALL, 0, 0, "flush");
+    if (map_get(&sim->globals, BESM_CALL_COUNT_DUMP, &unused))
+        append(&tail, BESM_BRANCH_CALL, 0, 0, BESM_CALL_COUNT_DUMP);
+    append(&tail, BESM_MEM_XTA, SIM_REG_SP, 0, NULL);
+    append(&tail, BESM_IO_EXTRACODE, 0, 1, NULL)->opcode = 077;
+
+    append(&tail, BESM_DATA_LOG, 0, 0, "argc")->log_val = (uint64_t)argc;
+    append_z00(&tail, 0, "argv", "argv.v");
+    char label[32];
+    for (int i = 0; i < argc; i++) {
+        snprintf(label, sizeof(label), "argv.%d", i);
+        append_z00(&tail, 8 + 5, i == 0 ? "argv.v" : NULL, label);
+    }
+    append(&tail, BESM_DATA_LOG, 0, 0, argc == 0 ? "argv.v" : NULL);
+    for (int i = 0; i < argc; i++) {
+        snprintf(label, sizeof(label), "argv.%d", i);
+        const char *s = argv[i];
+        size_t nbytes = strlen(s) + 1;
+        for (size_t w = 0; w * 6 < nbytes; w++) {
+            uint64_t word = 0;
+            for (size_t b = 0; b < 6; b++) {
+                size_t pos = w * 6 + b;
+                word       = (word << 8) | (pos < nbytes ? (unsigned char)s[pos] : 0);
+            }
+            append(&tail, BESM_DATA_LOG, 0, 0, w == 0 ? label : NULL)->log_val = word;
+        }
+    }
+    return module;
+}
+
+//
+// Symbol definition and lookup.
+//
+static void define(const Besm_Sim *sim, StringMap *map, const char *name, unsigned addr)
+{
+    if (map_get(map, name, NULL))
+        sim_trap(sim, "duplicate symbol %s", name);
+    map_insert(map, name, addr, 0);
+}
+
+static void define_toplevel(Besm_Sim *sim, const Sim_Module *m, const char *name, bool global,
+                            unsigned addr)
+{
+    define(sim, global ? &sim->globals : &m->unit->names, name, addr);
+}
+
+static unsigned lookup_symbol(const Besm_Sim *sim, const Sim_Module *m, const char *name)
+{
+    intptr_t addr;
+    if (map_get(&m->labels, name, &addr) || map_get(&m->unit->names, name, &addr) ||
+        map_get(&sim->globals, name, &addr))
+        return (unsigned)addr;
+    sim_trap(sim, "undefined symbol %s in %s", name, m->module->name);
+}
+
+//
+// Literals: the `konst` operand, or a Madlen literal name (=<octal>, or =:<octal> for
+// the left-aligned form), pooled once per distinct word.
+//
+static bool literal_word(const Besm_Instr *instr, uint64_t *word)
+{
+    if (instr->konst) {
+        Besm_ConstWord w = besm_const_word(instr->konst);
+        *word            = w.is_real ? besm_real_word(w.real_val) : w.word;
+        return true;
+    }
+    if (!instr->name || instr->name[0] != '=')
+        return false;
+
+    const char *p     = instr->name + 1;
+    bool left_aligned = (*p == ':');
+    if (left_aligned)
+        p++;
+    uint64_t value = 0;
+    int ndigits    = 0;
+    for (; *p; p++) {
+        if (*p == ' ')
+            continue;
+        value = (value << 3) | (uint64_t)(*p - '0');
+        ndigits++;
+    }
+    if (left_aligned && ndigits < 16)
+        value <<= 48 - 3 * ndigits;
+    *word = value & SIM_WORD_MASK;
+    return true;
+}
+
+static unsigned pool_address(Besm_Sim *sim, uint64_t word)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "%llo", (unsigned long long)word);
+    intptr_t addr;
+    if (map_get(&sim->literals, key, &addr))
+        return (unsigned)addr;
+    if (sim->brk >= SIM_STACK_BASE)
+        sim_trap(sim, "program does not fit below the stack");
+    sim->mem[sim->brk] = word;
+    map_insert(&sim->literals, key, sim->brk, 0);
+    return sim->brk++;
+}
+
+static unsigned operand_field(Besm_Sim *sim, const Sim_Module *m, const Besm_Instr *instr)
+{
+    uint64_t word;
+    if (literal_word(instr, &word))
+        return pool_address(sim, word);
+    if (instr->name)
+        return (lookup_symbol(sim, m, instr->name) + (unsigned)instr->addr) & SIM_ADDR_MASK;
+    return (unsigned)instr->addr & SIM_ADDR_MASK;
+}
+
+static bool is_machine_instr(const Besm_Instr *instr)
+{
+    return instr->kind <= BESM_IO_EXTRACODE;
+}
+
+//
+// Code layout: give every machine instruction an address, and define the function
+// names, entries and code labels.
+//
+static void layout_code(Besm_Sim *sim)
+{
+    for (Sim_Module *m = sim->modules; m; m = m->next) {
+        for (const Besm_Func *fn = m->module->funcs; fn; fn = fn->next) {
+            Sim_Function *f = &sim->funcs[sim->nfuncs++];
+            f->name         = fn->name;
+            f->entry        = sim->ncode + 1;
+            for (const Besm_Block *b = fn->blocks; b; b = b->next) {
+                for (const Besm_Instr *i = b->body; i; i = i->next) {
+                    unsigned here = sim->ncode + 1;
+                    if (is_machine_instr(i))
+                        sim->ncode++;
+                    else if (i->kind == BESM_STMT_NAME)
+                        define_toplevel(sim, m, i->name, fn->global, here);
+                    else if (i->kind == BESM_STMT_ENTRY)
+                        define_toplevel(sim, m, i->name, true, here);
+                    else if (i->kind == BESM_STMT_LABEL)
+                        define(sim, &m->labels, i->name, here);
+                }
+            }
+        }
+    }
+}
+
+//
+// Data layout of one item list.  Plain words are stored now; address words wait for
+// the fixup pass.
+//
+static void layout_items(Besm_Sim *sim, Sim_Module *m, const Besm_Instr *items,
+                         Sim_Fixup **fixups)
+{
+    for (const Besm_Instr *i = items; i; i = i->next) {
+        if (is_machine_instr(i))
+            continue;
+
+        unsigned nwords = 1;
+        uint64_t word   = 0;
+        switch (i->kind) {
+        case BESM_DATA_LOG:
+            word = i->log_val;
+            break;
+        case BESM_DATA_INT:
+            word = (uint64_t)(int64_t)i->addr & SIM_WORD_MASK;
+            break;
+        case BESM_DATA_REAL:
+            word = besm_real_word(i->real_val);
+            break;
+        case BESM_DATA_BSS:
+            nwords = (unsigned)i->addr;
+            break;
+        case BESM_DATA_EQU:
+            define(sim, &m->labels, i->name, (unsigned)i->addr & SIM_ADDR_MASK);
+            continue;
+        case BESM_DATA_Z00:
+        case BESM_DATA_REF: {
+            Sim_Fixup *fix = (Sim_Fixup *)xalloc(sizeof(Sim_Fixup), __func__, __FILE__, __LINE__);
+            fix->addr      = sim->brk;
+            fix->item      = i;
+            fix->module    = m;
+            fix->next      = *fixups;
+            *fixups        = fix;
+            break;
+        }
+        case BESM_DATA_STRING:
+            sim_trap(sim, "unsupported data item in %s", m->module->name);
+        default:
+            continue; // directives
+        }
+
+        const char *label = (i->kind == BESM_DATA_Z00) ? i->label
+                            : (i->kind == BESM_DATA_REF) ? NULL
+                                                         : i->name;
+        if (label)
+            define(sim, &m->labels, label, sim->brk);
+        if (sim->brk + nwords > SIM_STACK_BASE)
+            sim_trap(sim, "program does not fit below the stack");
+        if (nwords == 1)
+            sim->mem[sim->brk] = word;
+        sim->brk += nwords;
+
+        if (i->kind == BESM_DATA_Z00)
+            i = i->next; // the low half, carrying the address
+    }
+}
+
+static void layout_data(Besm_Sim *sim, Sim_Fixup **fixups)
+{
+    StringMap commons; // external names defined so far only by a tentative definition
+    map_init(&commons);
+
+    for (Sim_Module *m = sim->modules; m; m = m->next) {
+        // Static locals and folded strings live inside the function module.
+        for (const Besm_Func *fn = m->module->funcs; fn; fn = fn->next)
+            for (const Besm_Block *b = fn->blocks; b; b = b->next)
+                layout_items(sim, m, b->body, fixups);
+
+        for (const Besm_DataSection *s = m->module->sections; s; s = s->next) {
+            if (s->name && s->global) {
+                // Tentative definitions of one external name share a single object (a
+                // common); a real definition replaces them.
+                bool common = map_get(&commons, s->name, NULL);
+                if (s->tentative && (common || map_get(&sim->globals, s->name, NULL)))
+                    continue;
+                if (common) {
+                    map_remove_key(&commons, s->name);
+                    map_remove_key(&sim->globals, s->name);
+                }
+                if (s->tentative)
+                    map_insert(&commons, s->name, 1, 0);
+            }
+            if (s->name)
+                define_toplevel(sim, m, s->name, s->global, sim->brk);
+            layout_items(sim, m, s->items, fixups);
+        }
+    }
+    map_destroy(&commons);
+}
+
+static void apply_fixups(Besm_Sim *sim, Sim_Fixup *fixups)
+{
+    while (fixups) {
+        Sim_Fixup *fix         = fixups;
+        fixups                 = fix->next;
+        const Besm_Instr *item = fix->item;
+        if (item->kind == BESM_DATA_REF) {
+            sim->mem[fix->addr] = lookup_symbol(sim, fix->module, item->name);
+        } else {
+            const Besm_Instr *low = item->next;
+            unsigned addr = (lookup_symbol(sim, fix->module, low->name) + (unsigned)low->addr) &
+                            SIM_ADDR_MASK;
+            sim->mem[fix->addr] = ((uint64_t)item->reg << 44) | addr;
+        }
+        xfree(fix);
+    }
+}
+
+//
+// Resolve every machine instruction into `ops`.  The first sweep only pools the
+// literals, so that `end` can be defined past them before any name is looked up.
+//
+static void resolve_code(Besm_Sim *sim)
+{
+    for (const Sim_Module *m = sim->modules; m; m = m->next)
+        for (const Besm_Func *fn = m->module->funcs; fn; fn = fn->next)
+            for (const Besm_Block *b = fn->blocks; b; b = b->next)
+                for (const Besm_Instr *i = b->body; i; i = i->next) {
+                    uint64_t word;
+                    if (is_machine_instr(i) && literal_word(i, &word))
+                        pool_address(sim, word);
+                }
+
+    if (!map_get(&sim->globals, "end", NULL))
+        map_insert(&sim->globals, "end", sim->brk, 0);
+
+    unsigned addr = 1;
+    int func      = 0;
+    for (const Sim_Module *m = sim->modules; m; m = m->next) {
+        for (const Besm_Func *fn = m->module->funcs; fn; fn = fn->next, func++) {
+            for (const Besm_Block *b = fn->blocks; b; b = b->next) {
+                for (const Besm_Instr *i = b->body; i; i = i->next) {
+                    if (!is_machine_instr(i))
+                        continue;
+                    Sim_Op *op = &sim->ops[addr++];
+                    op->kind   = i->kind;
+                    op->func   = func;
+                    op->opcode = i->opcode;
+                    op->reg    = i->reg;
+                    op->field  = operand_field(sim, m, i);
+                }
+            }
+        }
+    }
+}
+
+void sim_link(Besm_Sim *sim, int argc, char *const argv[])
+{
+    // The startup code asks whether flush() exists, so the external names are collected
+    // before it is added; layout_code() defines them again from scratch.
+    for (const Sim_Module *m = sim->modules; m; m = m->next)
+        for (const Besm_Func *fn = m->module->funcs; fn; fn = fn->next)
+            if (fn->global)
+                map_insert(&sim->globals, fn->name, 0, 0);
+    sim_add_module(sim, startup_module(sim, argc, argv), sim_new_unit(sim));
+    map_destroy(&sim->globals);
+    map_init(&sim->globals);
+
+    int nfuncs = 0, ncode = 0;
+    for (const Sim_Module *m = sim->modules; m; m = m->next)
+        for (const Besm_Func *fn = m->module->funcs; fn; fn = fn->next, nfuncs++)
+            for (const Besm_Block *b = fn->blocks; b; b = b->next)
+                for (const Besm_Instr *i = b->body; i; i = i->next)
+                    if (is_machine_instr(i))
+                        ncode++;
+    if (ncode + 1 >= SIM_STACK_BASE)
+        sim_trap(sim, "program does not fit below the stack");
+    sim->funcs = (Sim_Function *)xalloc(nfuncs * sizeof(Sim_Function), __func__, __FILE__,
+                                        __LINE__);
+    sim->ops = (Sim_Op *)xalloc((ncode + 1) * sizeof(Sim_Op), __func__, __FILE__, __LINE__);
+
+    layout_code(sim);
+    sim->brk = sim->ncode + 1;
+
+    Sim_Fixup *fixups = NULL;
+    layout_data(sim, &fixups);
+    resolve_code(sim);
+    apply_fixups(sim, fixups);
+
+    sim->start = sim->funcs[sim->nfuncs - 1].entry; // the startup module comes last
+}
@@ -0,0 +1,291 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "abi.h"
+#include "besm.h"
+#include "frame.h"
+#include "internal.h"
+#include "tac.h"
+#include "xalloc.h"
+
+// Expression temporaries kept in A and on the hardware stack.
+//
+// The translator flattens an expression into a run of instructions, one per operator, each
+// leaving its value in a fresh temporary that the next level reads once:
+//
+//     t1 = a + b  /  t2 = c - d  /  t3 = t1 * t2  /  x = t3 + e
+//
+// Selected one by one, every temporary is a store to its frame slot and a load back:
+//
+//     xta a / a+x b / 7 atx t1 / xta c / a-x d / 7 atx t2 / 7 xta t1 / 7 xts t2 / call b$mul
+//     7 atx t3 / 7 xta t3 / a+x e / atx x
+//
+// The run is already in evaluation order, so the values it leaves behind are used last in,
+// first out, as on the stack machine the accumulator and XTS were built for: the newest
+// value is in A, and XTS, which pushes A as it loads the next operand, saves the others on
+// the hardware stack.  An operator then reads its operands from where they are — the one in
+// A directly, the one beneath it with a stack-mode `15 op`, which pops it — and those
+// temporaries need no slot at all:
+//
+//     xta a / a+x b / xts c / a-x d / call b$mul / a+x e / atx x
+//
+// The runtime helpers take their first operand on the stack and the second in A, which is
+// the same order.
+//
+// A temporary qualifies when it is defined once and read once, by a later node of the same
+// run: an inline integer add, subtract or bitwise op, a binary op that calls a helper
+// (see binop_helper), or a word load.  Anything else ends a run with nothing stacked.  The
+// candidates are then replayed against the stack: an operator must find its stacked
+// operands on top, the second above the first, and a value stored to a variable must leave
+// nothing stacked beneath it.  An operand found in A when it is the first of an operator is
+// taken as the second by an operator that commutes — or by A-X's reverse X-A, or a helper
+// with its operands swapped — otherwise it, and any temporary whose order fails, keeps its
+// slot and the replay runs again.
+//
+
+//
+// The inline instruction of an integer operator, or false when it has none.
+//
+static bool inline_op(Tac_BinaryOperator op, Besm_InstrKind *kind)
+{
+    switch (op) {
+    case TAC_BINARY_ADD:
+        *kind = BESM_ARITH_ADD;
+        return true;
+    case TAC_BINARY_SUBTRACT:
+        *kind = BESM_ARITH_SUB;
+        return true;
+    case TAC_BINARY_BITWISE_AND:
+        *kind = BESM_LOG_AAX;
+        return true;
+    case TAC_BINARY_BITWISE_OR:
+        *kind = BESM_LOG_AOX;
+        return true;
+    case TAC_BINARY_BITWISE_XOR:
+        *kind = BESM_LOG_AEX;
+        return true;
+    default:
+        return false;
+    }
+}
+
+//
+// The helper that takes the operands of `helper` the other way round, or NULL.
+//
+static const char *swapped_helper(const char *helper)
+{
+    static const char *const pairs[][2] = {
+        { "b$eq", "b$eq" },   { "b$ne", "b$ne" },     { "b$mul", "b$mul" },
+        { "b$umul", "b$umul" }, { "b$uadd", "b$uadd" }, { "b$lt", "b$gt" },
+        { "b$gt", "b$lt" },   { "b$le", "b$ge" },     { "b$ge", "b$le" },
+        { "b$ult", "b$ugt" }, { "b$ugt", "b$ult" },   { "b$ule", "b$uge" },
+        { "b$uge", "b$ule" }, { "b$flt", "b$fgt" },   { "b$fgt", "b$flt" },
+        { "b$fle", "b$fge" }, { "b$fge", "b$fle" },
+    };
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++)
+        if (strcmp(pairs[i][0], helper) == 0)
+            return pairs[i][1];
+    return NULL;
+}
+
+//
+// Is this instruction a node, one that may take its operands from the stack or leave its
+// result there?  A comparison decided by the jump right after it is selected with the jump
+// (see codegen_compare_branch), so neither that comparison nor any binary op so placed is.
+//
+static bool is_node(const Tac_Instruction *instr)
+{
+    if (instr->kind == TAC_INSTRUCTION_LOAD)
+        return true;
+    if (instr->kind != TAC_INSTRUCTION_BINARY)
+        return false;
+    const Tac_Instruction *jump = instr->next;
+    if (jump &&
+        (jump->kind == TAC_INSTRUCTION_JUMP_IF_ZERO ||
+         jump->kind == TAC_INSTRUCTION_JUMP_IF_NOT_ZERO) &&
+        jump->u.jump_if_zero.condition->kind == TAC_VAL_VAR &&
+        jump->u.jump_if_zero.condition->u.var_name == instr->u.binary.dst->u.var_name)
+        return false;
+    Besm_InstrKind kind;
+    return inline_op(instr->u.binary.op, &kind) || binop_helper(instr) != NULL;
+}
+
+static const char *node_dst(const Tac_Instruction *instr)
+{
+    const Tac_Val *dst =
+        instr->kind == TAC_INSTRUCTION_LOAD ? instr->u.load.dst : instr->u.binary.dst;
+    return dst->kind == TAC_VAL_VAR ? dst->u.var_name : NULL;
+}
+
+// TAC variable names are interned (see tac_intern()), and so are the names compared here
+// and kept on the replayed stack: equal names are the same pointer.
+static bool is_named(const Tac_Val *v, const char *name)
+{
+    return v->kind == TAC_VAL_VAR && v->u.var_name == name;
+}
+
+static bool is_stacked(const StackTemps *st, const Tac_Val *v)
+{
+    return v->kind == TAC_VAL_VAR && map_get(&st->temps, v->u.var_name, NULL);
+}
+
+//
+// Replay the nodes with the stacked temporaries; return the first that breaks the stack
+// order, or NULL when none does.
+//
+static const char *replay(const Tac_TopLevel *fn, const StackTemps *st, const char **stack)
+{
+    int depth = 0;
+    for (const Tac_Instruction *instr = fn->u.function.body; instr; instr = instr->next) {
+        if (!is_node(instr))
+            continue; // every stacked value was read inside its run
+        if (instr->kind == TAC_INSTRUCTION_BINARY) {
+            const Tac_Val *x = instr->u.binary.src1;
+            const Tac_Val *y = instr->u.binary.src2;
+            bool xs          = is_stacked(st, x);
+            bool ys          = is_stacked(st, y);
+            if (ys) {
+                if (depth == 0 || stack[depth - 1] != y->u.var_name)
+                    return y->u.var_name;
+                depth--;
+            }
+            if (xs) {
+                if (depth == 0 || stack[depth - 1] != x->u.var_name)
+                    return x->u.var_name;
+                depth--;
+            }
+            const char *helper = binop_helper(instr);
+            if (ys && !xs && helper && !swapped_helper(helper))
+                return y->u.var_name;
+        }
+        const char *dst = node_dst(instr);
+        if (dst && map_get(&st->temps, dst, NULL))
+            stack[depth++] = dst;
+        else if (depth > 0)
+            return stack[depth - 1];
+    }
+    return NULL;
+}
+
+bool stack_temps_find(const Tac_TopLevel *fn, const Frame *f, StackTemps *st)
+{
+    map_init(&st->temps);
+    st->depth = 0;
+
+    // A temporary defined by a node and read once by a later node of its run.
+    int count = 0;
+    for (const Tac_Instruction *instr = fn->u.function.body; instr; instr = instr->next) {
+        if (!is_node(instr))
+            continue;
+        const char *dst = node_dst(instr);
+        if (!dst || frame_temp_refs(f, dst) != 2)
+            continue;
+        for (const Tac_Instruction *use = instr->next; use && is_node(use); use = use->next) {
+            if (use->kind == TAC_INSTRUCTION_BINARY &&
+                (is_named(use->u.binary.src1, dst) || is_named(use->u.binary.src2, dst))) {
+                map_insert(&st->temps, dst, 1, 0);
+                count++;
+                break;
+            }
+        }
+    }
+    if (count == 0)
+        return false;
+
+    const char **stack = xalloc(count * sizeof(*stack), __func__, __FILE__, __LINE__);
+    const char *broken;
+    while ((broken = replay(fn, st, stack)) != NULL)
+        map_remove_key(&st->temps, broken);
+    xfree(stack);
+    return st->temps.root != NULL;
+}
+
+//
+// Bring the first operand of a node into A, saving the value there when one is stacked.
+//
+static void load_first(Besm_Block *block, Besm_Instr **tail, const Frame *f, const StackTemps *st,
+                       const Tac_Val *v)
+{
+    if (st->depth > 0)
+        emit_xts_val(block, tail, f, v);
+    else
+        emit_xta_val(block, tail, f, v);
+}
+
+//
+// An operation on A and the value the stack-mode `15 op` pops beneath it.
+//
+static void emit_popped(Besm_Block *block, Besm_Instr **tail, Besm_InstrKind kind)
+{
+    Besm_Instr *op = emit(block, tail, kind);
+    op->reg        = REG_SP;
+}
+
+static void emit_call(Besm_Block *block, Besm_Instr **tail, const char *helper)
+{
+    Besm_Instr *call = emit(block, tail, BESM_BRANCH_CALL);
+    call->name       = xstrdup(helper);
+}
+
+bool codegen_stacked(const Tac_Instruction *instr, StackTemps *st, const Frame *f,
+                     Besm_Block *block, Besm_Instr **tail)
+{
+    if (!st->temps.root || !is_node(instr))
+        return false;
+
+    const char *dst = node_dst(instr);
+    bool stacked    = dst && map_get(&st->temps, dst, NULL);
+    if (instr->kind == TAC_INSTRUCTION_LOAD) {
+        if (!stacked)
+            return false;
+        // C resets after one instruction, so the load comes right after the WTC; a bare XTS
+        // reads through C as XTA does.
+        emit_wtc_ptr(block, tail, f, instr->u.load.src_ptr->u.var_name);
+        emit(block, tail, st->depth > 0 ? BESM_MEM_XTS : BESM_MEM_XTA);
+        st->depth++;
+        return true;
+    }
+
+    const Tac_Val *x = instr->u.binary.src1;
+    const Tac_Val *y = instr->u.binary.src2;
+    bool xs          = is_stacked(st, x);
+    bool ys          = is_stacked(st, y);
+    if (!stacked && !xs && !ys)
+        return false;
+
+    Besm_InstrKind kind;
+    if (inline_op(instr->u.binary.op, &kind)) {
+        if (xs && ys)
+            emit_popped(block, tail, kind == BESM_ARITH_SUB ? BESM_ARITH_RSUB : kind);
+        else if (ys)
+            emit_arith_val(block, tail, kind == BESM_ARITH_SUB ? BESM_ARITH_RSUB : kind, f, x);
+        else {
+            if (!xs)
+                load_first(block, tail, f, st, x);
+            emit_arith_val(block, tail, kind, f, y);
+        }
+    } else {
+        const char *helper = binop_helper(instr);
+        if (ys && !xs) {
+            emit_xts_val(block, tail, f, x);
+            helper = swapped_helper(helper);
+        } else if (!ys) {
+            if (!xs)
+                load_first(block, tail, f, st, x);
+            emit_xts_val(block, tail, f, y);
+        }
+        emit_call(block, tail, helper);
+    }
+
+    st->depth -= xs + ys;
+    if (stacked)
+        st->depth++;
+    else
+        emit_store_a(block, tail, f, dst);
+    return true;
+}
+
+void stack_temps_free(StackTemps *st)
+{
+    map_destroy(&st->temps);
+}
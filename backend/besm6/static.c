@@ -533,15 +533,15 @@ static Besm_Instr *static_data_items(const Tac_Type *type, const Tac_StaticInit
     return head;
 }
 
-void codegen_static_variable(const Tac_TopLevel *program, const Tac_TopLevel *tl, FILE *out,
-                             Besm_Dialect dialect)
+Besm_Module *codegen_static_variable(const Tac_TopLevel *program, const Tac_TopLevel *tl,
+                                     Besm_Dialect dialect)
 {
     // Skip a tentative definition when another toplevel defines (or already tentatively
     // reserves) the same name — see static_var_superseded.  Without this, the streaming
     // frontend's separate tentative + initialized toplevels emit two strong labels of the
     // same name, which the Unix assembler rejects as a duplicate symbol.
     if (static_var_superseded(program, tl))
-        return;
+        return NULL;
 
     const char *name           = tl->u.static_variable.name;
     const Tac_StaticInit *init = tl->u.static_variable.init_list;
@@ -568,8 +568,7 @@ void codegen_static_variable(const Tac_TopLevel *program, const Tac_TopLevel *tl
     module->sections          = section;
 
     besm_fold_string_constants(module, program, dialect);
-    besm_emit_module(out, module, dialect);
-    besm_free_module(module);
+    return module;
 }
 
 // True for a data directive that stores a word and can therefore carry a Madlen label in
@@ -629,6 +628,26 @@ void besm_emit_static_locals(Besm_Module *module, const Tac_TopLevel *fn, Besm_D
     }
 }
 
+// The count and the link are explicit zero words, like a static local's padding (see
+// zero_log_words); the name follows them.
+void besm_emit_call_counter(Besm_Module *module, const char *name, const char *counter,
+                            Besm_Dialect dialect)
+{
+    Tac_StaticInit init           = { .kind = TAC_STATIC_INIT_STRING };
+    init.u.string.val             = (char *)name;
+    init.u.string.len             = strlen(name);
+    init.u.string.null_terminated = true;
+
+    Besm_Instr *count = zero_log_words(2);
+    count->name       = xstrdup(counter);
+    count->next->next = besm_string_log_items(&init, NULL, dialect);
+
+    Besm_Block *last = module->funcs->blocks;
+    while (last->next)
+        last = last->next;
+    insert_before_end(last, count);
+}
+
 // Pack a string static-init into a chain of BESM_DATA_LOG words (6 KOI-7 bytes per
 // word, big-endian).  When `label` is non-NULL it is set as the Madlen label of the
 // first word.  Used both for char-array data and for string constants folded into a
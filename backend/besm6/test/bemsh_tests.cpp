@@ -116,13 +116,10 @@ TEST_F(CodegenTest, BemshMainEntry)
     EXPECT_EQ(R"(ввд$$$
 *
 main   старт 1
-_save0 внешн ._save0
-_ret   внешн ._ret
        входн progra
-       счим 13
-       пв _save0(13)
+       ржа 7
        сч
-       пб _ret
+       пб (13)
        финиш
 квч$$$
 трн$$$
@@ -153,14 +150,11 @@ counte старт 1
 ввд$$$
 *
 f      старт 1
-_save0 внешн ._save0
-_ret   внешн ._ret
 counte внешн .counte
-       счим 13
-       пв _save0(13)
+       ржа 7
        мода counte
        сч
-       пб _ret
+       пб (13)
        финиш
 квч$$$
 трн$$$
@@ -179,12 +173,9 @@ TEST_F(CodegenTest, BemshFloatConst)
     EXPECT_EQ(R"(ввд$$$
 *
 f      старт 1
-_save0 внешн ._save0
-_ret   внешн ._ret
-       счим 13
-       пв _save0(13)
+       ржа 7
        сч =е'1.5'
-       пб _ret
+       пб (13)
        финиш
 квч$$$
 трн$$$
@@ -258,14 +249,11 @@ g      старт 1
 ввд$$$
 *
 f      старт 1
-_save0 внешн ._save0
-_ret   внешн ._ret
 g      внешн .g
-       счим 13
-       пв _save0(13)
+       ржа 7
        уиа g(14)
        счи 14
-       пб _ret
+       пб (13)
        финиш
 квч$$$
 трн$$$
@@ -300,7 +288,8 @@ TEST(BemshMangle, HelperNamesMatchLibbem)
         { "b$fgt", "_fgt" },     { "b$fge", "_fge" },     { "b$dtoi", "_dtoi" },
         { "b$dtou", "_dtou" },   { "b$utod", "_utod" },   { "b$padd", "_padd" },
         { "b$pinc", "_pinc" },   { "b$pdec", "_pdec" },   { "b$pdiff", "_pdiff" },
-        { "b$stb", "_stb" },     { "b$tout", "_tout" },
+        { "b$stb", "_stb" },     { "b$tout", "_tout" },   { "b$divmod", "_divmd" },
+        { "b$udivmod", "_udvmd" },
     };
     std::set<std::string> outputs;
     for (auto &h : helpers) {
@@ -310,7 +299,7 @@ TEST(BemshMangle, HelperNamesMatchLibbem)
         EXPECT_TRUE(letter_first(got)) << got;
         EXPECT_TRUE(outputs.insert(got).second) << "duplicate helper symbol " << got;
     }
-    EXPECT_EQ(outputs.size(), 38u); // all helper exports distinct
+    EXPECT_EQ(outputs.size(), 40u); // all helper exports distinct
 }
 
 // The non-b$ libc leaves carry no '$' and are already ≤6 chars, so they pass through
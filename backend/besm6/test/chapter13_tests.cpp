@@ -729,7 +729,7 @@ TEST_F(CodegenTest, Chapter13_CompoundAssignImplicitCast)
 }
 
 // The book's original `rounded_to_zero = 1e-25` underflows the BESM-6 7-bit
-// float exponent, which the compiler now rejects by design (unix_real_word in
+// float exponent, which the compiler now rejects by design (besm_real_word in
 // besm_const.c fatal_errors on E < 1 rather than flushing to zero).  Such a
 // literal is not compilable for this target, so the variable is renamed `fp_zero`
 // and initialized to an explicit 0.0 — it is simply a floating-point zero, and
@@ -793,7 +793,7 @@ int main(void) {
 // The book's 2^63 double initializers (9223372036854775808. == 2^63, and the
 // ~2^63 values 9223372036854775810ul / 9223372036854776832ul) are dropped: a double
 // magnitude >= 2^63 exceeds the BESM-6 7-bit float exponent, which the compiler now
-// rejects by design (unix_real_word in emit_unix.c calls fatal_error).  The integer
+// rejects by design (besm_real_word in besm_const.c calls fatal_error).  The integer
 // initializers (i, u, l, ul) fold to integer words, so ul's ~2^64 literal is fine.
 // The remaining in-range initializers still exercise the static-init conversions.
 TEST_F(CodegenTest, Chapter13_StaticInitializers)
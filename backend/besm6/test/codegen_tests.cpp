@@ -216,12 +216,10 @@ TEST_F(CodegenTest, MainEntryPointInt)
     std::string output = CompileToMadlen("int main() { return 0; }");
     EXPECT_EQ(R"(c
      main:   ,name,
-    b/ret:   ,subp,
   program:   ,entry,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,xta,
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
@@ -287,16 +285,14 @@ TEST_F(CodegenTest, GetAddressGlobalInt)
     std::string output = CompileToMadlen("extern int g; extern int *p; void foo(void) { p = &g; }");
     EXPECT_EQ(R"(c
       foo:   ,name,
-    b/ret:   ,subp,
         g:   ,subp,
         p:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
           14 ,vtm, g
              ,ita, 14
              ,utc, p
              ,atx,
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
@@ -407,13 +403,11 @@ TEST_F(CodegenTest, ExternVarReturn)
     )");
     EXPECT_EQ(R"(c
       bar:   ,name,
-    b/ret:   ,subp,
       foo:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,utc, foo
              ,xta,
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
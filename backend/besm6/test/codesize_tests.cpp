@@ -0,0 +1,479 @@
+//
+// Code-size harness: compile a fixed corpus through the Unix code generator and compare
+// the size of every toplevel against a checked-in baseline.
+//
+// The corpus is the C programs of the chapter, printf, str and math run-tests — pulled
+// out of the string literals each test passes to CompileAndRun / CompileAndRunBook /
+// CompileTo* — plus the BESM-6 libc sources, each with the options it ships with: those
+// listed in BESM6_LIBC_SPEED (root CMakeLists.txt) under --speed.  Nothing is assembled or run: each program
+// goes through parse, typecheck, translate and codegen_module, and the resulting
+// Besm_Module is measured — machine instructions and data words per toplevel, and the
+// frame each function reserves.  Programs must fit in 32K words, so code growth is a
+// regression even when every run-test still passes.
+//
+// One test per corpus file.  A toplevel may grow by kSlackWords words, or by
+// kSlackPercent of its size when that is more, before the test fails; its frame may not
+// grow at all.  Shrinking is reported, never an error.  After a change that moves the
+// numbers on purpose, regenerate the baseline and commit it with the change:
+//
+//     BESM6_CODESIZE_UPDATE=1 ./besm-tests --gtest_filter='Corpus/CodeSizeTest.*'
+//
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "abi.h"
+#include "besm.h"
+#include "c_escape.h"
+#include "codegen.h"
+#include "parser.h"
+#include "semantic.h"
+#include "structtab.h"
+#include "symtab.h"
+#include "tac.h"
+#include "target.h"
+#include "test_preprocess.h"
+#include "translate.h"
+#include "typetab.h"
+#include "xalloc.h"
+
+namespace {
+
+const int kSlackWords   = 2;
+const int kSlackPercent = 5;
+
+// Size of one toplevel of one program.
+struct Size {
+    int instrs = 0; // machine instructions
+    int data   = 0; // data words: variables, static locals, folded strings
+    int frame  = 0; // auto words the prologue reserves
+};
+
+// program + ' ' + toplevel → size
+using SizeMap = std::map<std::string, Size>;
+
+// One C program of the corpus.
+struct CorpusProgram {
+    std::string name;
+    std::string source;
+    bool speed      = false;   // compile with --speed
+    const char *dir = nullptr; // where its quoted #includes are, for the libc sources
+};
+
+//
+// Extract the C programs of a test file: the string literals passed straight to one of
+// the compile helpers, named after the enclosing TEST_F.  A call whose argument is not
+// a literal (a variable, a concatenation with one) is skipped.
+//
+class LiteralScanner {
+    const std::string &text;
+    size_t pos = 0;
+
+public:
+    explicit LiteralScanner(const std::string &t) : text(t) {}
+
+    std::vector<CorpusProgram> Programs()
+    {
+        static const char *const helpers[] = { "CompileAndRunBook", "CompileAndRun",
+                                               "CompileToMadlen", "CompileToUnix",
+                                               "CompileToBemsh" };
+        std::vector<CorpusProgram> out;
+        std::string test;
+        int calls = 0;
+        while (pos < text.size()) {
+            if (SkipCommentOrLiteral())
+                continue;
+            char c = text[pos];
+            if (!isalpha((unsigned char)c) && c != '_') {
+                pos++;
+                continue;
+            }
+            std::string id = Identifier();
+            if (id == "TEST_F" || id == "TEST") {
+                test  = TestName();
+                calls = 0;
+                continue;
+            }
+            if (std::find(std::begin(helpers), std::end(helpers), id) == std::end(helpers))
+                continue;
+            SkipSpace();
+            if (pos >= text.size() || text[pos] != '(')
+                continue;
+            pos++;
+            std::string source;
+            if (!Literals(source))
+                continue;
+            calls++;
+            out.push_back({ calls == 1 ? test : test + "." + std::to_string(calls), source });
+        }
+        return out;
+    }
+
+private:
+    std::string Identifier()
+    {
+        size_t start = pos;
+        while (pos < text.size() && (isalnum((unsigned char)text[pos]) || text[pos] == '_'))
+            pos++;
+        return text.substr(start, pos - start);
+    }
+
+    // `(Fixture, Name)` → "Name".
+    std::string TestName()
+    {
+        size_t comma = text.find(',', pos);
+        size_t close = text.find(')', pos);
+        if (comma == std::string::npos || close == std::string::npos || comma > close)
+            return "?";
+        pos = comma + 1;
+        SkipSpace();
+        return Identifier();
+    }
+
+    void SkipSpace()
+    {
+        for (;;) {
+            while (pos < text.size() && isspace((unsigned char)text[pos]))
+                pos++;
+            if (text.compare(pos, 2, "//") == 0) {
+                pos = std::min(text.find('\n', pos), text.size());
+            } else if (text.compare(pos, 2, "/*") == 0) {
+                size_t end = text.find("*/", pos + 2);
+                pos        = end == std::string::npos ? text.size() : end + 2;
+            } else {
+                return;
+            }
+        }
+    }
+
+    // Read one string literal at `pos` into `out`; false when there is none.
+    bool Literal(std::string &out)
+    {
+        if (text.compare(pos, 2, "R\"") == 0) {
+            size_t open = text.find('(', pos + 2);
+            if (open == std::string::npos)
+                return false;
+            std::string close = ")" + text.substr(pos + 2, open - pos - 2) + "\"";
+            size_t end        = text.find(close, open + 1);
+            if (end == std::string::npos)
+                return false;
+            out += text.substr(open + 1, end - open - 1);
+            pos = end + close.size();
+            return true;
+        }
+        if (pos >= text.size() || text[pos] != '"')
+            return false;
+        size_t end = pos + 1;
+        while (end < text.size() && text[end] != '"')
+            end += text[end] == '\\' ? 2 : 1;
+        std::string raw = text.substr(pos, end + 1 - pos);
+        size_t len;
+        char *bytes = c_decode_string_literal(raw.c_str(), &len);
+        out.append(bytes, len);
+        xfree(bytes);
+        pos = end + 1;
+        return true;
+    }
+
+    // A run of adjacent literals closing the call: `"a" "b")` or `R"(...)")`.
+    bool Literals(std::string &out)
+    {
+        SkipSpace();
+        if (!Literal(out))
+            return false;
+        for (;;) {
+            SkipSpace();
+            if (!Literal(out))
+                break;
+        }
+        return pos < text.size() && text[pos] == ')';
+    }
+
+    // Step over a comment, string or character literal, so that nothing inside one
+    // is taken for an identifier.
+    bool SkipCommentOrLiteral()
+    {
+        if (text.compare(pos, 2, "//") == 0 || text.compare(pos, 2, "/*") == 0) {
+            SkipSpace();
+            return true;
+        }
+        std::string ignored;
+        if (text[pos] == '"' || text.compare(pos, 2, "R\"") == 0)
+            return Literal(ignored) || (pos++, true);
+        if (text[pos] == '\'') {
+            pos++;
+            while (pos < text.size() && text[pos] != '\'')
+                pos += text[pos] == '\\' ? 2 : 1;
+            pos++;
+            return true;
+        }
+        return false;
+    }
+};
+
+std::string ReadFile(const std::filesystem::path &path)
+{
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+// Words of data a list of items occupies, as the linker lays it out.
+int DataWords(const Besm_Instr *items)
+{
+    int words = 0;
+    for (const Besm_Instr *i = items; i; i = i->next) {
+        switch (i->kind) {
+        case BESM_DATA_BSS:
+            words += i->addr;
+            break;
+        case BESM_DATA_Z00:
+            words++;
+            i = i->next; // the low half of the same word
+            break;
+        case BESM_DATA_INT:
+        case BESM_DATA_REAL:
+        case BESM_DATA_LOG:
+        case BESM_DATA_REF:
+        case BESM_DATA_STRING:
+            words++;
+            break;
+        default:
+            break;
+        }
+    }
+    return words;
+}
+
+// Measure one module into `sizes` under `program`.
+void Measure(const std::string &program, const Besm_Module *module, SizeMap &sizes)
+{
+    for (const Besm_Func *fn = module->funcs; fn; fn = fn->next) {
+        Size &s = sizes[program + " " + fn->name];
+        for (const Besm_Block *b = fn->blocks; b; b = b->next) {
+            for (const Besm_Instr *i = b->body; i; i = i->next) {
+                if (i->kind < BESM_STMT_LABEL)
+                    s.instrs++;
+                // The prologue's stack extension: the first `utm` of the stack pointer.
+                if (i->kind == BESM_REG_UTM && i->reg == REG_SP && s.frame == 0)
+                    s.frame = i->addr;
+            }
+            s.data += DataWords(b->body);
+        }
+    }
+    for (const Besm_DataSection *sec = module->sections; sec; sec = sec->next) {
+        if (sec->name)
+            sizes[program + " " + sec->name].data += DataWords(sec->items);
+    }
+}
+
+// Compile one program and measure every module it produces.
+void Compile(const CorpusProgram &prog, SizeMap &sizes)
+{
+    besm_codegen_options.speed = prog.speed;
+    std::string source = preprocess_source(prog.source, prog.dir);
+    ASSERT_FALSE(source.empty()) << "C preprocessing failed for " << prog.name;
+
+    FILE *input = tmpfile();
+    ASSERT_NE(nullptr, input);
+    fwrite(source.data(), 1, source.size(), input);
+    rewind(input);
+    Program *ast = parse(input);
+    fclose(input);
+    ASSERT_NE(nullptr, ast);
+
+    Tac_TopLevel *all = nullptr, **tail = &all;
+    int label_seq       = 0;
+    ExternalDecl *decls = ast->decls;
+    ast->decls          = nullptr;
+    while (decls) {
+        ExternalDecl *next = decls->next;
+        decls->next        = nullptr;
+        typecheck_decl(decls, &label_seq);
+        *tail = translate(decls, opt_flags_default(), &label_seq);
+        free_external_decl(decls);
+        while (*tail)
+            tail = &(*tail)->next;
+        decls = next;
+    }
+    free_program(ast);
+
+    for (const Tac_TopLevel *tl = all; tl; tl = tl->next) {
+        Besm_Module *module = codegen_module(all, tl, BESM_UNIX);
+        if (module) {
+            Measure(prog.name, module, sizes);
+            besm_free_module(module);
+        }
+    }
+    tac_free_toplevel(all);
+    besm_codegen_options.speed = false;
+    symtab_destroy();
+    structtab_destroy();
+    typetab_destroy();
+    nametab_destroy();
+    tac_intern_destroy();
+}
+
+// The corpus: the chapter, printf, str and math run-test files, and the libc sources as
+// one more entry.
+std::vector<std::string> CorpusNames()
+{
+    std::vector<std::string> names;
+    for (const auto &entry : std::filesystem::directory_iterator(BESM6_TEST_SRC_DIR)) {
+        std::string file = entry.path().filename().string();
+        if ((file.rfind("chapter", 0) == 0 || file == "printf_tests.cpp" ||
+             file == "str_tests.cpp" || file == "math_tests.cpp") &&
+            entry.path().extension() == ".cpp")
+            names.push_back(entry.path().stem().string());
+    }
+    std::sort(names.begin(), names.end());
+    names.push_back("libc");
+    return names;
+}
+
+// Is this libc routine built with --speed?
+bool IsSpeedRoutine(const std::string &name)
+{
+    std::istringstream list(BESM6_LIBC_SPEED);
+    std::string word;
+    while (list >> word)
+        if (word == name)
+            return true;
+    return false;
+}
+
+std::vector<CorpusProgram> CorpusPrograms(const std::string &corpus)
+{
+    std::vector<CorpusProgram> programs;
+    if (corpus != "libc") {
+        std::string text = ReadFile(std::filesystem::path(BESM6_TEST_SRC_DIR) / (corpus + ".cpp"));
+        return LiteralScanner(text).Programs();
+    }
+    for (const char *dir : { "", "unix/" }) {
+        std::vector<std::filesystem::path> files;
+        for (const auto &entry :
+             std::filesystem::directory_iterator(std::string(BESM6_LIBC_DIR "/") + dir))
+            if (entry.path().extension() == ".c")
+                files.push_back(entry.path());
+        std::sort(files.begin(), files.end());
+        for (const auto &f : files)
+            programs.push_back({ dir + f.stem().string(), ReadFile(f),
+                                 *dir == '\0' && IsSpeedRoutine(f.stem().string()),
+                                 BESM6_LIBC_DIR });
+    }
+    return programs;
+}
+
+//
+// The baseline: "corpus program toplevel instrs data frame" per line, '#' comments.
+//
+std::map<std::string, SizeMap> ReadBaseline()
+{
+    std::map<std::string, SizeMap> baseline;
+    std::ifstream in(BESM6_CODESIZE_BASELINE);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream fields(line);
+        std::string corpus, program, toplevel;
+        Size s;
+        if (fields >> corpus >> program >> toplevel >> s.instrs >> s.data >> s.frame)
+            baseline[corpus][program + " " + toplevel] = s;
+    }
+    return baseline;
+}
+
+void WriteBaseline(const std::map<std::string, SizeMap> &baseline)
+{
+    std::ofstream out(BESM6_CODESIZE_BASELINE);
+    out << "# Code size of the code-size corpus (backend/besm6/test/codesize_tests.cpp):\n"
+        << "# corpus program toplevel instructions data-words frame-words.\n"
+        << "# Regenerate: BESM6_CODESIZE_UPDATE=1 ./besm-tests "
+           "--gtest_filter='Corpus/CodeSizeTest.*'\n";
+    for (const auto &[corpus, sizes] : baseline)
+        for (const auto &[key, s] : sizes)
+            out << corpus << " " << key << " " << s.instrs << " " << s.data << " " << s.frame
+                << "\n";
+}
+
+} // namespace
+
+class CodeSizeTest : public ::testing::TestWithParam<std::string> {
+protected:
+    void SetUp() override { target_config = target_lookup("besm6"); }
+
+    void TearDown() override
+    {
+        xreport_lost_memory();
+        EXPECT_EQ(xtotal_allocated_size(), 0);
+        xfree_all();
+    }
+};
+
+TEST_P(CodeSizeTest, MatchesBaseline)
+{
+    const std::string &corpus = GetParam();
+    SizeMap sizes;
+    for (const CorpusProgram &prog : CorpusPrograms(corpus)) {
+        Compile(prog, sizes);
+        if (HasFatalFailure())
+            return;
+    }
+    ASSERT_FALSE(sizes.empty()) << "no programs found in " << corpus;
+
+    std::map<std::string, SizeMap> baseline = ReadBaseline();
+    if (getenv("BESM6_CODESIZE_UPDATE")) {
+        baseline[corpus] = sizes;
+        WriteBaseline(baseline);
+        return;
+    }
+
+    const SizeMap &expected = baseline[corpus];
+    long total = 0, expected_total = 0;
+    int shrunk = 0, added = 0;
+    for (const auto &[key, s] : sizes) {
+        total += s.instrs + s.data;
+        auto it = expected.find(key);
+        if (it == expected.end()) {
+            added++;
+            continue;
+        }
+        const Size &b  = it->second;
+        int words      = s.instrs + s.data;
+        int base_words = b.instrs + b.data;
+        int slack      = std::max(kSlackWords, base_words * kSlackPercent / 100);
+        EXPECT_LE(words, base_words + slack)
+            << key << ": " << s.instrs << " instructions + " << s.data << " data words, was "
+            << b.instrs << " + " << b.data;
+        EXPECT_LE(s.frame, b.frame) << key << ": frame of " << s.frame << " words, was "
+                                    << b.frame;
+        if (words < base_words || s.frame < b.frame)
+            shrunk++;
+        expected_total += base_words;
+    }
+    std::cout << corpus << ": " << sizes.size() << " toplevels, " << total << " words (baseline "
+              << expected_total << " for those it lists)";
+    if (shrunk)
+        std::cout << "; " << shrunk << " shrank";
+    if (added)
+        std::cout << "; " << added << " not in the baseline";
+    std::cout << "\n";
+}
+
+// Name each instance after its corpus: Corpus/CodeSizeTest.MatchesBaseline/chapter5_tests.
+static std::string CorpusName(const ::testing::TestParamInfo<std::string> &param)
+{
+    return param.param;
+}
+
+INSTANTIATE_TEST_SUITE_P(Corpus, CodeSizeTest, ::testing::ValuesIn(CorpusNames()), CorpusName);
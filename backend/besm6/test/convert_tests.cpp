@@ -237,13 +237,11 @@ TEST_F(CodegenTest, FloatToDoubleMadlen)
     std::string output = CompileToMadlen("extern float f; double foo(void) { return f; }");
     EXPECT_EQ(R"(c
       foo:   ,name,
-    b/ret:   ,subp,
         f:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,utc, f
              ,xta,
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
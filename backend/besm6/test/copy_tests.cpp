@@ -51,16 +51,14 @@ TEST_F(CodegenTest, CopyGlobalToGlobal)
     std::string output = CompileToMadlen("extern int g, h; void foo(void) { h = g; }");
     EXPECT_EQ(R"(c
       foo:   ,name,
-    b/ret:   ,subp,
         g:   ,subp,
         h:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,utc, g
              ,xta,
              ,utc, h
              ,atx,
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
@@ -109,14 +107,12 @@ TEST_F(CodegenTest, CopyConstToGlobal)
     std::string output = CompileToMadlen("extern int g; void foo(void) { g = 0; }");
     EXPECT_EQ(R"(c
       foo:   ,name,
-    b/ret:   ,subp,
         g:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,xta,
              ,utc, g
              ,atx,
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
@@ -129,14 +125,12 @@ TEST_F(CodegenTest, CopyNegConst)
     std::string output = CompileToMadlen("extern int g; void foo(void) { g = -1; }");
     EXPECT_EQ(R"(c
       foo:   ,name,
-    b/ret:   ,subp,
         g:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,xta, =37777777777777
              ,utc, g
              ,atx,
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
@@ -212,10 +212,8 @@ TEST_F(CodegenTest, NoreturnCallTailJump)
     std::string output = CompileToMadlen("_Noreturn void die(void); void f(void) { die(); }");
     EXPECT_EQ(R"(c
         f:   ,name,
-    b/ret:   ,subp,
       die:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,uj, die
              ,end,
 )",
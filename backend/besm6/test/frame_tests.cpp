@@ -12,7 +12,7 @@ static Tac_Val *make_var(const char *name)
     auto *v       = static_cast<Tac_Val *>(xalloc(sizeof(Tac_Val), __func__, __FILE__, __LINE__));
     v->next       = nullptr;
     v->kind       = TAC_VAL_VAR;
-    v->u.var_name = xstrdup(name);
+    v->u.var_name = tac_intern(name);
     return v;
 }
 
@@ -64,9 +64,7 @@ static void free_val(Tac_Val *v)
 {
     while (v) {
         Tac_Val *next = v->next;
-        if (v->kind == TAC_VAL_VAR)
-            xfree(v->u.var_name);
-        xfree(v);
+        xfree(v); // var_name is interned
         v = next;
     }
 }
@@ -365,11 +365,9 @@ TEST_F(CodegenTest, IntrinsicStopMadlen)
     )");
     EXPECT_EQ(R"(c
       bye:   ,name,
-    b/ret:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,33, 255
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
@@ -429,10 +427,9 @@ TEST_F(CodegenTest, IntrinsicStopUnix)
     EXPECT_EQ(R"(    .text
     .globl bye
 bye:
-    its 13
- 13 vjm b$save0
+    ntr 7
     stop 5
-    uj b$ret
+ 13 uj
 )",
               output);
 }
@@ -446,12 +443,9 @@ TEST_F(CodegenTest, IntrinsicStopBemsh)
     EXPECT_EQ(R"(ввд$$$
 *
 bye    старт 1
-_save0 внешн ._save0
-_ret   внешн ._ret
-       счим 13
-       пв _save0(13)
+       ржа 7
        стоп 5
-       пб _ret
+       пб (13)
        финиш
 квч$$$
 трн$$$
@@ -551,11 +545,9 @@ TEST_F(CodegenTest, IntrinsicPswMadlen)
     )");
     EXPECT_EQ(R"(c
        rd:   ,name,
-    b/ret:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,ita, 17
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 c
        wr:   ,name,
@@ -568,11 +560,9 @@ c
              ,end,
 c
       cli:   ,name,
-    b/ret:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,24, 1027
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
@@ -619,24 +609,21 @@ TEST_F(CodegenTest, IntrinsicPswUnix)
     EXPECT_EQ(R"(    .text
     .globl getpsw
 getpsw:
-    its 13
- 13 vjm b$save0
+    ntr 7
     ita 17
-    uj b$ret
+ 13 uj
     .text
     .globl cli
 cli:
-    its 13
- 13 vjm b$save0
+    ntr 7
     vtm 1027
-    uj b$ret
+ 13 uj
     .text
     .globl sti
 sti:
-    its 13
- 13 vjm b$save0
+    ntr 7
     vtm 3
-    uj b$ret
+ 13 uj
 )",
               output);
 }
@@ -669,12 +656,9 @@ _ret   внешн ._ret
 ввд$$$
 *
 cli    старт 1
-_save0 внешн ._save0
-_ret   внешн ._ret
-       счим 13
-       пв _save0(13)
+       ржа 7
        уиа 1027
-       пб _ret
+       пб (13)
        финиш
 квч$$$
 трн$$$
@@ -727,12 +711,10 @@ TEST_F(CodegenTest, IntrinsicExtConstMadlen)
     )");
     EXPECT_EQ(R"(c
     ready:   ,name,
-    b/ret:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,xta,
              ,ext, 2073
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
@@ -934,22 +916,18 @@ TEST_F(CodegenTest, IntrinsicExtLongAddrMadlen)
     )");
     EXPECT_EQ(R"(c
       grp:   ,name,
-    b/ret:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,xta,
              ,mod, 159
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 c
       far:   ,name,
-    b/ret:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,xta,
              ,utc, 4096
              ,ext,
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
@@ -1010,11 +988,10 @@ TEST_F(CodegenTest, IntrinsicIoUnix)
     EXPECT_EQ(R"(    .text
     .globl ready
 ready:
-    its 13
- 13 vjm b$save0
+    ntr 7
     xta
     ext 2073
-    uj b$ret
+ 13 uj
     .text
     .globl io
 io:
@@ -1050,13 +1027,10 @@ TEST_F(CodegenTest, IntrinsicExtConstBemsh)
     EXPECT_EQ(R"(ввд$$$
 *
 ready  старт 1
-_save0 внешн ._save0
-_ret   внешн ._ret
-       счим 13
-       пв _save0(13)
+       ржа 7
        сч
        увв 2073
-       пб _ret
+       пб (13)
        финиш
 квч$$$
 трн$$$
@@ -172,16 +172,15 @@ TEST_F(CodegenTest, FpCoalesceBehaviorUnchanged)
     EXPECT_EQ("4210000000000000\n", out);
 }
 
-// Task #30 — compare → branch fusion.  A relational helper's 0/1 result that feeds a
-// JUMP_IF_ZERO is consumed directly by the conditional branch: no boolean temp is stored
-// or reloaded.  This is the emergent product of rule #27 (which drops the reload) and rule
-// #28 (which drops the now-dead store), made correct by the runtime helpers' logical-ω
-// exit contract — every comparison helper leaves ω consistent with its returned A, so the
-// `,uza,` tests the result without a reload.  See docs/Peephole_Rewrites.md §5.4 and the
-// "ω mode and the AU mode register R" section of docs/Besm6_Runtime_Library.md.
+// Task #30 — compare → branch fusion.  A comparison whose 0/1 result only feeds the
+// JUMP_IF_ZERO right after it is selected together with the jump (codegen_compare_branch):
+// the operands are subtracted inline and the conditional branch tests the ω that leaves, so
+// there is no helper call and no boolean temporary stored or reloaded.  A comparison used
+// as a value still calls its helper, whose logical-ω exit contract lets rules #27/#28 drop
+// the reload and the dead store when a branch follows.  See docs/Peephole_Rewrites.md §5.4
+// and the "ω mode and the AU mode register R" section of docs/Besm6_Runtime_Library.md.
 //
-// The fused shape is `xta / xts / ,call, b/lt / ,uza,` with no `,atx,`/`,xta,` of the
-// comparison temporary between the call and the branch.
+// The fused shape is `xta a / a-x b / ,uza,`.
 TEST_F(CodegenTest, CompareBranchFused)
 {
     std::string output =
@@ -193,8 +192,7 @@ TEST_F(CodegenTest, CompareBranchFused)
              ,its, 13
              ,call, b/save
            6 ,xta,
-           6 ,xts, 1
-             ,call, b/lt
+           6 ,a-x, 1
              ,uza, *1
              ,xta, =1
              ,utc, g
@@ -212,7 +210,7 @@ TEST_F(CodegenTest, CompareBranchFused)
 // comparison drives an if/else and prints a distinguishing digit (the listing path
 // upper-cases output, so letters cannot encode a true/false distinction).  The expected
 // string 0101110 is, in order: a<b (7<4) 0, a>b 1, a==b 0, a!=b 1, ua<ub (3<9) 1,
-// x<y (1.5<2.5) 1, x>=y 0 — confirming every helper's ω feeds the branch correctly.
+// x<y (1.5<2.5) 1, x>=y 0 — confirming every comparison's ω feeds the branch correctly.
 TEST_F(CodegenTest, CompareBranchFusedBehaviorUnchanged)
 {
     std::string out = CompileAndRun(R"(
@@ -431,14 +429,12 @@ TEST_F(CodegenTest, RedundantGlobalReloadRemoved)
              ,end,
 c
         f:   ,name,
-    b/ret:   ,subp,
         g:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,xta, =7
              ,utc, g
              ,atx,
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
@@ -654,3 +650,18 @@ TEST_F(CodegenTest, IoAddressDisplacementTooLargeKept)
 )",
               output);
 }
+
+// `genbesm --stats`: the function from RedundantReloadRemoved fires #27 once and #28 once,
+// and the counts before and after differ by exactly those two instructions.
+TEST_F(CodegenTest, PeepholeStatsCountRules)
+{
+    Besm_PeepStats before = besm_peep_stats;
+    CompileToMadlen("extern int g; void foo(int a, int b) { g = a + b; }");
+    EXPECT_EQ(besm_peep_stats.functions - before.functions, 1u);
+    EXPECT_EQ(besm_peep_stats.fired[PEEP_RELOAD] - before.fired[PEEP_RELOAD], 1u);
+    EXPECT_EQ(besm_peep_stats.fired[PEEP_DEAD_STORE] - before.fired[PEEP_DEAD_STORE], 1u);
+    EXPECT_EQ(besm_peep_stats.fired[PEEP_NTR] - before.fired[PEEP_NTR], 0u);
+    EXPECT_EQ((besm_peep_stats.instrs_before - before.instrs_before) -
+                  (besm_peep_stats.instrs_after - before.instrs_after),
+              2u);
+}
@@ -0,0 +1,781 @@
+//
+// Tests for the in-process BESM-6 simulator: compile C through the front end and the
+// Unix code generator, link it with the runtime library, run it, and check the output,
+// the exit status and the dynamic counts.
+//
+#include <gtest/gtest.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "test_preprocess.h"
+
+extern "C" {
+#include "besm_sim.h"
+#include "codegen.h"
+#include "optimize.h"
+#include "parser.h"
+#include "semantic.h"
+#include "structtab.h"
+#include "symtab.h"
+#include "tac.h"
+#include "target.h"
+#include "translate.h"
+#include "typetab.h"
+#include "xalloc.h"
+}
+
+class BesmSimTest : public ::testing::Test {
+protected:
+    Besm_Sim *sim{};
+    FILE *out{};
+    std::string output;
+    int status{};
+
+    void SetUp() override
+    {
+        target_config = target_lookup("besm6");
+        out           = tmpfile();
+        ASSERT_NE(nullptr, out);
+        sim = besm_sim_create(out);
+    }
+
+    void TearDown() override
+    {
+        besm_codegen_options = {};
+        besm_sim_destroy(sim);
+        fclose(out);
+        tac_intern_destroy();
+        xreport_lost_memory();
+        EXPECT_EQ(xtotal_allocated_size(), 0);
+        xfree_all();
+    }
+
+    // Compile `src` as one translation unit and load it into the machine.  Its quoted
+    // #includes are looked up in `dir` first, when given.
+    void Load(const std::string &src, OptFlags flags = opt_flags_default(),
+              const char *dir = nullptr)
+    {
+        std::string source = preprocess_source(src, dir);
+        ASSERT_FALSE(source.empty()) << "C preprocessing failed for test source";
+
+        FILE *input = tmpfile();
+        ASSERT_NE(nullptr, input);
+        fwrite(source.data(), 1, source.size(), input);
+        rewind(input);
+        Program *ast = parse(input);
+        fclose(input);
+        ASSERT_NE(nullptr, ast);
+
+        Tac_TopLevel *program = nullptr;
+        Tac_TopLevel **tail   = &program;
+        int label_seq         = 0;
+        ExternalDecl *decls   = ast->decls;
+        ast->decls            = nullptr;
+        while (decls) {
+            ExternalDecl *next = decls->next;
+            decls->next        = nullptr;
+            typecheck_decl(decls, &label_seq);
+            *tail = translate(decls, flags, &label_seq);
+            free_external_decl(decls);
+            while (*tail)
+                tail = &(*tail)->next;
+            decls = next;
+        }
+        free_program(ast);
+
+        besm_sim_load_program(sim, program);
+        tac_free_toplevel(program);
+        symtab_destroy();
+        structtab_destroy();
+        typetab_destroy();
+        nametab_destroy();
+    }
+
+    // Compile one C file of the BESM-6 libc.
+    void LoadLibc(const char *name)
+    {
+        std::ifstream file(std::string(BESM6_LIBC_DIR) + "/" + name);
+        ASSERT_TRUE(file.good()) << name;
+        std::stringstream text;
+        text << file.rdbuf();
+        Load(text.str(), opt_flags_default(), BESM6_LIBC_DIR);
+    }
+
+    // Load `src` with putchar and the Unix output buffer, then run it.
+    void Run(const char *src, OptFlags flags = opt_flags_default())
+    {
+        Load(src, flags);
+        Start();
+    }
+
+    // Link what is loaded with putchar and the Unix output buffer, then run it.
+    void Start()
+    {
+        LoadLibc("putchar.c");
+        LoadLibc("unix/putbyte.c");
+        LoadLibc("unix/flush.c");
+        besm_sim_load_assembly(sim, BESM6_LIBC_DIR "/unix");
+
+        char name[]  = "prog";
+        char *argv[] = { name, nullptr };
+        status       = besm_sim_run(sim, 1, argv);
+
+        long len = ftell(out);
+        rewind(out);
+        output.assign(static_cast<size_t>(len), '\0');
+        if (len > 0) {
+            EXPECT_EQ(fread(&output[0], 1, static_cast<size_t>(len), out), (size_t)len);
+        }
+    }
+
+    // Start over with an empty machine and output, to run a program again another way.
+    void Restart()
+    {
+        besm_sim_destroy(sim);
+        fclose(out);
+        out = tmpfile();
+        ASSERT_NE(nullptr, out);
+        sim = besm_sim_create(out);
+    }
+};
+
+TEST_F(BesmSimTest, ReturnsExitStatus)
+{
+    Run("int main(void) { return 42; }");
+    EXPECT_EQ(status, 42);
+    EXPECT_EQ(output, "");
+    EXPECT_EQ(besm_sim_call_count(sim, "main"), 1u);
+    EXPECT_EQ(besm_sim_call_count(sim, "flush"), 1u);
+}
+
+TEST_F(BesmSimTest, PrintsThroughWrite)
+{
+    Run("int putchar(int);\n"
+        "int main(void) { putchar('h'); putchar('i'); putchar('\\n'); putchar('!'); return 0; }");
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "hi\n!");
+    EXPECT_EQ(besm_sim_call_count(sim, "putchar"), 4u);
+    EXPECT_EQ(besm_sim_call_count(sim, "write"), 2u);
+}
+
+TEST_F(BesmSimTest, ExitFromNestedCall)
+{
+    Run("void exit(int);\n"
+        "void quit(int n) { exit(n); }\n"
+        "int main(void) { quit(3); return 0; }\n");
+    EXPECT_EQ(status, 3);
+    EXPECT_EQ(besm_sim_call_count(sim, "quit"), 1u);
+    EXPECT_EQ(besm_sim_call_count(sim, "flush"), 0u);
+}
+
+TEST_F(BesmSimTest, RecursiveCallCounts)
+{
+    Run("int fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }\n"
+        "int main(void) { return fib(10); }\n");
+    EXPECT_EQ(status, 55);
+    EXPECT_EQ(besm_sim_call_count(sim, "fib"), 177u);
+    EXPECT_GT(besm_sim_function_count(sim, "fib"), 177u);
+    EXPECT_GE(besm_sim_cycle_count(sim), besm_sim_instruction_count(sim));
+}
+
+TEST_F(BesmSimTest, IntegerArithmetic)
+{
+    Run("int putchar(int);\n"
+        "void put(int n) {\n"
+        "    if (n < 0) { putchar('-'); n = -n; }\n"
+        "    if (n >= 10) put(n / 10);\n"
+        "    putchar('0' + n % 10);\n"
+        "}\n"
+        "int main(void) {\n"
+        "    int a = 1234, b = -56;\n"
+        "    put(a * b); putchar(' ');\n"
+        "    put(a / b); putchar(' ');\n"
+        "    put(a % 100); putchar(' ');\n"
+        "    put(a << 3); putchar(' ');\n"
+        "    put((a >> 2) ^ 7);\n"
+        "    putchar('\\n');\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "-69104 -22 34 9872 307\n");
+    EXPECT_GT(besm_sim_kind_count(sim, BESM_ARITH_MUL), 0u);
+}
+
+TEST_F(BesmSimTest, CharPointers)
+{
+    Run("int putchar(int);\n"
+        "static const char *msg = \"static text\";\n"
+        "void puts_(const char *s) { while (*s) putchar(*s++); putchar('\\n'); }\n"
+        "int main(void) {\n"
+        "    char buf[8];\n"
+        "    char *p = buf;\n"
+        "    for (int i = 0; i < 7; i++) *p++ = 'a' + i;\n"
+        "    *p = 0;\n"
+        "    puts_(buf);\n"
+        "    puts_(msg + 7);\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "abcdefg\ntext\n");
+}
+
+TEST_F(BesmSimTest, FloatingPoint)
+{
+    Run("int main(void) {\n"
+        "    double x = 1.5, y = 0.25;\n"
+        "    double z = (x + y) * 4.0 - x / y;\n" // 7 - 6 = 1
+        "    return (int)(z * 10.0);\n"
+        "}\n");
+    EXPECT_EQ(status, 10);
+}
+
+TEST_F(BesmSimTest, OptimizationLowersInstructionCount)
+{
+    static const char *src = "int main(void) {\n"
+                             "    int s = 0;\n"
+                             "    for (int i = 0; i < 100; i++) {\n"
+                             "        int t = i;\n"
+                             "        int u = t;\n"
+                             "        s = s + u;\n"
+                             "    }\n"
+                             "    return s % 256;\n"
+                             "}\n";
+    OptFlags none{};
+    Run(src, none);
+    EXPECT_EQ(status, 4950 % 256);
+    uint64_t unoptimized = besm_sim_function_count(sim, "main");
+
+    Restart();
+    Run(src);
+    EXPECT_EQ(status, 4950 % 256);
+    EXPECT_LT(besm_sim_function_count(sim, "main"), unoptimized);
+}
+
+// With --speed, char pointers step and store bytes inline.  The walks below cross word
+// boundaries in both directions, store bytes with the high bit set, and step a pointer
+// into a char array inside a struct; none of them calls a pointer helper.
+TEST_F(BesmSimTest, CharPointerStepsInline)
+{
+    besm_codegen_options.speed = true;
+    Run("int putchar(int);\n"
+        "char buf[16];\n"
+        "struct s { int n; char c[8]; } st;\n"
+        "int main(void) {\n"
+        "    char *p = buf, *q;\n"
+        "    for (int i = 0; i < 13; i++)\n"
+        "        *p++ = 'a' + i;\n"
+        "    *p = 0;\n"
+        "    for (q = p; q != buf;)\n"
+        "        putchar(*--q);\n"
+        "    putchar(' ');\n"
+        "    for (p = buf; *p; p++)\n"
+        "        putchar(*p);\n"
+        "    putchar(' ');\n"
+        "    buf[6] = -1;\n"
+        "    buf[5] = 'z';\n"
+        "    putchar(buf[5]);\n"
+        "    putchar((unsigned char)buf[6] == 255 ? 'y' : 'n');\n"
+        "    putchar(buf[7]);\n"
+        "    char *m = st.c;\n"
+        "    *m++ = 'x';\n"
+        "    *m = 'w';\n"
+        "    m--;\n"
+        "    putchar(*m);\n"
+        "    putchar(st.c[1]);\n"
+        "    putchar('\\n');\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "mlkjihgfedcba abcdefghijklm zyhxw\n");
+    EXPECT_EQ(besm_sim_call_count(sim, "b$pinc"), 0u);
+    EXPECT_EQ(besm_sim_call_count(sim, "b$pdec"), 0u);
+    EXPECT_EQ(besm_sim_call_count(sim, "b$stb"), 0u);
+}
+
+// The string and memory routines of the libc, which move whole words once their operands
+// reach a word boundary together, agree with byte loops for every pair of byte offsets.
+TEST_F(BesmSimTest, StringRoutinesMatchByteLoops)
+{
+    for (const char *name : { "memcpy.c", "memmove.c", "memset.c", "memcmp.c", "strlen.c",
+                              "strcpy.c", "strcmp.c" })
+        LoadLibc(name);
+    Run("#include <string.h>\n"
+        "int putchar(int);\n"
+        "char a[40], b[40], r[40];\n"
+        "void fill(char *p, int seed) {\n"
+        "    for (int i = 0; i < 40; i++) p[i] = (char)(seed + i * 7);\n"
+        "}\n"
+        "int differ(void) {\n"
+        "    for (int i = 0; i < 40; i++) if (b[i] != r[i]) return 1;\n"
+        "    return 0;\n"
+        "}\n"
+        "int sign(int v) { return v < 0 ? -1 : v > 0; }\n"
+        "int main(void) {\n"
+        "    int bad = 0;\n"
+        "    for (int so = 0; so < 6; so++)\n"
+        "        for (int d = 0; d < 6; d++)\n"
+        "            for (int n = 0; n < 22; n += 7) {\n"
+        "                fill(a, 1); fill(b, 2); fill(r, 2);\n"
+        "                memcpy(b + d, a + so, n);\n"
+        "                for (int i = 0; i < n; i++) r[d + i] = a[so + i];\n"
+        "                bad += differ();\n"
+        "                fill(b, 3); fill(r, 3);\n"
+        "                memmove(b + d, b + so + 6, n);\n"
+        "                for (int i = 0; i < n; i++) r[d + i] = r[so + 6 + i];\n"
+        "                bad += differ();\n"
+        "                fill(b, 4); fill(r, 4);\n"
+        "                memmove(b + so + 6, b + d, n);\n"
+        "                for (int i = n - 1; i >= 0; i--) r[so + 6 + i] = r[d + i];\n"
+        "                bad += differ();\n"
+        "                fill(b, 5); fill(r, 5);\n"
+        "                memset(b + d, 0300 + so, n);\n"
+        "                for (int i = 0; i < n; i++) r[d + i] = (char)(0300 + so);\n"
+        "                bad += differ();\n"
+        "                fill(b, 6);\n"
+        "                memcpy(r + so, b + d, 30);\n"
+        "                r[so + n] ^= 0200;\n"
+        "                bad += sign(memcmp(b + d, r + so, 30)) != (b[d + n] & 0200 ? 1 : -1);\n"
+        "                bad += memcmp(b + d, r + so, n) != 0;\n"
+        "                fill(a, 'A'); a[so + n] = 0;\n"
+        "                bad += strlen(a + so) != (size_t)n;\n"
+        "                fill(b, 7); fill(r, 7);\n"
+        "                strcpy(b + d, a + so);\n"
+        "                for (int i = 0; i <= n; i++) r[d + i] = a[so + i];\n"
+        "                bad += differ();\n"
+        "                bad += strcmp(b + d, a + so) != 0;\n"
+        "                b[d + n] = 'x';\n"
+        "                bad += strcmp(b + d, a + so) <= 0 || strcmp(a + so, b + d) >= 0;\n"
+        "                if (n > 0) {\n"
+        "                    b[d + n - 1] = 0;\n"
+        "                    bad += strcmp(b + d, a + so) >= 0;\n"
+        "                }\n"
+        "            }\n"
+        "    putchar('0' + bad / 10);\n"
+        "    putchar('0' + bad % 10);\n"
+        "    putchar('\\n');\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "00\n");
+}
+
+// Aligned operands go a word at a time: 600 bytes take under five instructions a byte, where
+// the byte loops took 27 (memcpy) and 11 (strlen).
+TEST_F(BesmSimTest, StringRoutinesMoveWords)
+{
+    LoadLibc("memcpy.c");
+    LoadLibc("strlen.c");
+    Run("#include <string.h>\n"
+        "char a[601], b[601];\n"
+        "int main(void) {\n"
+        "    for (int i = 0; i < 600; i++) a[i] = 'a' + i % 26;\n"
+        "    memcpy(b, a, 600);\n"
+        "    return strlen(b) == 600 ? 0 : 1;\n"
+        "}\n");
+    EXPECT_EQ(status, 0);
+    EXPECT_LT(besm_sim_function_count(sim, "memcpy"), 3000u);
+    EXPECT_LT(besm_sim_function_count(sim, "strlen"), 3000u);
+}
+
+// A comparison that only decides a branch is done inline: each one below branches without
+// a relational helper, and agrees with the helper that computes the same comparison as a
+// value.  The unsigned pairs reach into the top bits of the 48-bit word.
+TEST_F(BesmSimTest, CompareAndBranchInline)
+{
+    Run("int putchar(int);\n"
+        "int branches(long a, long b) {\n"
+        "    int r = 0;\n"
+        "    if (a < b) r |= 1;\n"
+        "    if (a <= b) r |= 2;\n"
+        "    if (a > b) r |= 4;\n"
+        "    if (a >= b) r |= 8;\n"
+        "    if (a == b) r |= 16;\n"
+        "    if (!(a != b)) r |= 32;\n"
+        "    return r;\n"
+        "}\n"
+        "int values(long a, long b) {\n"
+        "    return (a < b) | (a <= b) << 1 | (a > b) << 2 | (a >= b) << 3 |\n"
+        "           (a == b) << 4 | (a == b) << 5;\n"
+        "}\n"
+        "int ubranches(unsigned long a, unsigned long b) {\n"
+        "    int r = 0;\n"
+        "    if (a < b) r |= 1;\n"
+        "    if (a <= b) r |= 2;\n"
+        "    while (a > b) { r |= 4; break; }\n"
+        "    if (!(a >= b)) r |= 8;\n"
+        "    return r;\n"
+        "}\n"
+        "int uvalues(unsigned long a, unsigned long b) {\n"
+        "    return (a < b) | (a <= b) << 1 | (a > b) << 2 | !(a >= b) << 3;\n"
+        "}\n"
+        "int main(void) {\n"
+        "    static const long s[] = { 0, 1, -1, 5, -7, 1099511627775, -1099511627775 };\n"
+        "    static const unsigned long u[] = { 0, 1, 5, 2199023255551, 2199023255552,\n"
+        "                                       0x800000000000, 0xffffffffffff };\n"
+        "    int bad = 0;\n"
+        "    for (int i = 0; i < 7; i++)\n"
+        "        for (int j = 0; j < 7; j++) {\n"
+        "            bad += branches(s[i], s[j]) != values(s[i], s[j]);\n"
+        "            bad += ubranches(u[i], u[j]) != uvalues(u[i], u[j]);\n"
+        "        }\n"
+        "    putchar('0' + branches(-7, 5) / 10);\n"
+        "    putchar('0' + branches(-7, 5) % 10);\n"
+        "    putchar(' ');\n"
+        "    putchar('a' + ubranches(u[6], u[1]));\n"
+        "    putchar('a' + ubranches(u[1], u[5]));\n"
+        "    putchar('\\n');\n"
+        "    return bad;\n"
+        "}\n");
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "03 el\n");
+    EXPECT_EQ(besm_sim_call_count(sim, "branches"), 51u);
+    EXPECT_EQ(besm_sim_call_count(sim, "b$lt"), 49u);
+    EXPECT_EQ(besm_sim_call_count(sim, "b$ult"), 49u);
+}
+
+// A struct too large to unroll is copied by a loop, through every kind of operand: a named
+// variable, a member at an offset, a pointer, a global, an initializer and a return value.
+TEST_F(BesmSimTest, LargeStructCopiesLoop)
+{
+    Run("int putchar(int);\n"
+        "struct big { int a[20]; int tail; };\n"
+        "struct outer { int head; struct big b; } o;\n"
+        "struct big g;\n"
+        "struct big make(int k) {\n"
+        "    struct big b;\n"
+        "    for (int i = 0; i < 20; i++) b.a[i] = k + i;\n"
+        "    b.tail = -k;\n"
+        "    return b;\n"
+        "}\n"
+        "int check(const struct big *p, int k) {\n"
+        "    for (int i = 0; i < 20; i++)\n"
+        "        if (p->a[i] != k + i) return 0;\n"
+        "    return p->tail == -k;\n"
+        "}\n"
+        "int main(void) {\n"
+        "    struct big x, y;\n"
+        "    struct big *p = &y;\n"
+        "    x = make(3);\n"
+        "    y = x;\n"
+        "    g = y;\n"
+        "    o.head = 7;\n"
+        "    o.b = g;\n"
+        "    *p = make(5);\n"
+        "    struct big z = o.b;\n"
+        "    putchar('0' + check(&x, 3));\n"
+        "    putchar('0' + check(&g, 3));\n"
+        "    putchar('0' + check(&o.b, 3));\n"
+        "    putchar('0' + check(&z, 3));\n"
+        "    putchar('0' + check(p, 5));\n"
+        "    putchar('0' + o.head);\n"
+        "    putchar('\\n');\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "111117\n");
+}
+
+// A copy of more than 4096 words, the reach of one loop, takes a loop per 4096 words.
+TEST_F(BesmSimTest, HugeStructCopiesInChunks)
+{
+    Run("int putchar(int);\n"
+        "struct huge { int a[9000]; } g, h;\n"
+        "int main(void) {\n"
+        "    for (int i = 0; i < 9000; i++) g.a[i] = i;\n"
+        "    h = g;\n"
+        "    for (int i = 0; i < 9000; i++)\n"
+        "        if (h.a[i] != i) return 1;\n"
+        "    putchar('y');\n"
+        "    putchar('\\n');\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "y\n");
+}
+
+// Loops of a known trip count close with VLM, counting in r8 or, around an inner one, r9;
+// a loop around two such levels keeps its test.  Leaving early and skipping to the step
+// keep i right, a loop that runs no pass is left alone, and so is one that calls.
+TEST_F(BesmSimTest, CountedLoopsCloseWithVlm)
+{
+    Run("int putchar(int);\n"
+        "int a[10][10];\n"
+        "void put(int v) {\n"
+        "    if (v >= 10) put(v / 10);\n"
+        "    putchar('0' + v % 10);\n"
+        "}\n"
+        "int main(void) {\n"
+        "    int s = 0, i, j, k;\n"
+        "    for (i = 0; i < 10; i++)\n"
+        "        for (j = 0; j < 10; j++)\n"
+        "            a[i][j] = i * j;\n"
+        "    for (k = 0; k < 3; k++)\n"
+        "        for (i = 0; i < 10; i++)\n"
+        "            for (j = 0; j < 10; j++)\n"
+        "                s += a[i][j];\n"
+        "    for (i = 0; i < 100; i++) {\n"
+        "        if (i % 2) continue;\n"
+        "        if (i == 40) break;\n"
+        "        s += i;\n"
+        "    }\n"
+        "    for (j = -5; j < 5; j++)\n"
+        "        s -= j;\n"
+        "    for (k = 5; k < 5; k++)\n"
+        "        s = 0;\n"
+        "    put(s);\n"
+        "    putchar(' ');\n"
+        "    put(i + j + k);\n"
+        "    putchar(' ');\n"
+        "    for (i = 0; i < 3; i++)\n"
+        "        put(i);\n"
+        "    putchar('\\n');\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "6460 50 012\n");
+    EXPECT_EQ(besm_sim_kind_count(sim, BESM_BRANCH_VLM), 110u + 330u + 40u + 10u);
+}
+
+// With --speed a loop whose bound is known only at run time closes with VLM too, armed
+// from i - n on entry.  A loop longer than the 15-bit register counts is armed again.
+TEST_F(BesmSimTest, VariableLoopsCloseWithVlm)
+{
+    besm_codegen_options.speed = true;
+    Run("int putchar(int);\n"
+        "int a[50];\n"
+        "int sum(int from, int n) {\n"
+        "    int s = 0;\n"
+        "    for (int i = from; i < n; i++)\n"
+        "        s += a[i];\n"
+        "    return s;\n"
+        "}\n"
+        "long count(long n) {\n"
+        "    long c = 0, i = 0;\n"
+        "    while (i < n) {\n"
+        "        c += 2;\n"
+        "        i++;\n"
+        "    }\n"
+        "    return c + i;\n"
+        "}\n"
+        "int main(void) {\n"
+        "    for (int i = 0; i < 50; i++)\n"
+        "        a[i] = i;\n"
+        "    putchar('0' + (sum(0, 50) == 1225));\n"
+        "    putchar('0' + (sum(10, 13) == 33));\n"
+        "    putchar('0' + (sum(7, 8) == 7));\n"
+        "    putchar('0' + (sum(9, 9) == 0));\n"
+        "    putchar('0' + (sum(20, 3) == 0));\n"
+        "    putchar('0' + (count(40000) == 120000));\n"
+        "    putchar('0' + (count(-3) == 0));\n"
+        "    putchar('\\n');\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "1111111\n");
+    EXPECT_EQ(besm_sim_kind_count(sim, BESM_BRANCH_VLM), 50u + 54u + 40000u);
+}
+
+// The temporaries of an expression stay in A and on the hardware stack: the operators read
+// them with XTS and stack-mode ops, in either order, and the helpers take them in place.
+TEST_F(BesmSimTest, ExpressionTemporariesStayOnStack)
+{
+    Run("int putchar(int);\n"
+        "int expr(int a, int b, int c, int d) { return (a + b) * (c - d) + (a ^ d); }\n"
+        "int nest(int a, int b, int c, int d) { return a - (b - c) - ((a | d) - (b & c)); }\n"
+        "int rev(int a, int b, int c) { return ((a - b) > c) + (c < (a + b)) * 2; }\n"
+        "int quot(int a, int b, int c) { return (a + b) / (c - a) + c % (a - b); }\n"
+        "int deref(int *p, int *q) { return *p * *q - (*q - *p); }\n"
+        "void put(int v) {\n"
+        "    if (v < 0) { putchar('-'); v = -v; }\n"
+        "    if (v >= 10) put(v / 10);\n"
+        "    putchar('0' + v % 10);\n"
+        "}\n"
+        "int main(void) {\n"
+        "    int x = 6, y = 9;\n"
+        "    put(expr(3, 4, 10, 2));\n"
+        "    putchar(' ');\n"
+        "    put(nest(12, 5, 3, 1));\n"
+        "    putchar(' ');\n"
+        "    put(rev(7, 2, 4) * 10 + rev(1, 2, 4));\n"
+        "    putchar(' ');\n"
+        "    put(quot(5, 3, 9));\n"
+        "    putchar(' ');\n"
+        "    put(deref(&x, &y));\n"
+        "    putchar('\\n');\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "57 -2 30 3 51\n");
+
+    // No store to a temporary and no load back: prologue, seven ops, epilogue.
+    EXPECT_EQ(besm_sim_function_count(sim, "expr"), 11u);
+}
+
+TEST_F(BesmSimTest, InstrumentedCallsCounted)
+{
+    besm_codegen_options.instrument_calls = true;
+    Load("int fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }\n"
+         "int main(void) { return fib(10); }\n");
+    besm_codegen_options.instrument_calls = false;
+    LoadLibc("unix/callcount.c");
+
+    testing::internal::CaptureStderr();
+    Start();
+    std::string counts = testing::internal::GetCapturedStderr();
+    EXPECT_EQ(status, 55);
+    EXPECT_EQ(besm_sim_call_count(sim, "fib"), 177u);
+    EXPECT_EQ(counts, "calls 177 fib\ncalls 1 main\n");
+}
+
+// A function that calls nothing takes no b/save frame.  An accessor's linkage is shorter
+// inline, and is always taken; with parameters it is longer, and taken only with --speed.
+TEST_F(BesmSimTest, LeafFunctionsNeedNoFrame)
+{
+    static const char *src = "int k = 3;\n"
+                             "int get(void) { return k; }\n"
+                             "int add(int a, int b) { return a + b; }\n"
+                             "int pick(int a, int b, int c) {\n"
+                             "    int v[2];\n"
+                             "    v[0] = a;\n"
+                             "    v[1] = c;\n"
+                             "    return v[b];\n"
+                             "}\n"
+                             "int main(void) {\n"
+                             "    int s = 0;\n"
+                             "    for (int i = 0; i < 10; i++)\n"
+                             "        s = add(s, get() + pick(i, i & 1, 2 * i));\n"
+                             "    return s;\n"
+                             "}\n";
+    auto executed = [this] {
+        return besm_sim_function_count(sim, "add") + besm_sim_function_count(sim, "pick") +
+               besm_sim_function_count(sim, "b$save") + besm_sim_function_count(sim, "b$ret");
+    };
+    Run(src);
+    EXPECT_EQ(status, 100);
+    EXPECT_EQ(besm_sim_function_count(sim, "get"), 10u * 4); // ntr, utc, xta, 13 uj
+    EXPECT_EQ(besm_sim_call_count(sim, "b$save"), 20u);      // add and pick
+    uint64_t framed = executed();
+
+    Restart();
+    besm_codegen_options.speed = true;
+    Run(src);
+    EXPECT_EQ(status, 100);
+    EXPECT_EQ(besm_sim_call_count(sim, "b$save"), 0u);
+    EXPECT_LT(executed(), framed);
+}
+
+TEST_F(BesmSimTest, DivisionsByConstantsAndPairsShareWork)
+{
+    static const char *src = "int putchar(int);\n"
+                             "void put(int n) {\n"
+                             "    char d[16];\n"
+                             "    int i = 0;\n"
+                             "    if (n < 0) { putchar('-'); n = -n; }\n"
+                             "    do { d[i++] = '0' + n % 10; n = n / 10; } while (n);\n"
+                             "    while (i > 0) putchar(d[--i]);\n"
+                             "    putchar(' ');\n"
+                             "}\n"
+                             "void hex(unsigned u, unsigned base) {\n"
+                             "    unsigned r = u % base;\n"
+                             "    u = u / base;\n"
+                             "    if (u) hex(u, base);\n"
+                             "    putchar(\"0123456789abcdef\"[r]);\n"
+                             "}\n"
+                             "void qr(int a, int b) {\n"
+                             "    int q = a / b;\n"
+                             "    put(q);\n"
+                             "    put(a % b);\n"
+                             "}\n"
+                             "int exact(int a, int b) {\n"
+                             "    int q = a / b, r = a % b;\n"
+                             "    if (r)\n"
+                             "        return q;\n"
+                             "    return 100 + q;\n"
+                             "}\n"
+                             "int main(void) {\n"
+                             "    int a = -1234567;\n"
+                             "    put(a / 7); put(a % 7); put(a / 100); put(a % 100);\n"
+                             "    put(a / 3); put(a % 3); put(1099511627775 / 10);\n"
+                             "    qr(a, 89); put(exact(13, 4)); put(exact(12, 4));\n"
+                             "    hex(0xdcba987654, 16); putchar(' ');\n"
+                             "    hex(123456789, 9); putchar('\\n');\n"
+                             "    return 0;\n"
+                             "}\n";
+    static const char *expect = "-176366 -5 -12345 -67 -411522 -1 109951162777 -13871 -48 3 103 "
+                                "dcba987654 277266780\n";
+    Run(src);
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, expect);
+    uint64_t divides = besm_sim_kind_count(sim, BESM_ARITH_DIV);
+
+    Restart();
+    besm_codegen_options.speed = true;
+    Run(src);
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, expect);
+    EXPECT_EQ(besm_sim_call_count(sim, "b$mod"), 0u);
+    EXPECT_EQ(besm_sim_call_count(sim, "b$divmod"), 3u); // a / b in qr and exact
+    EXPECT_EQ(besm_sim_call_count(sim, "b$umod"), 0u);
+    EXPECT_LT(besm_sim_kind_count(sim, BESM_ARITH_DIV), divides);
+}
+
+// A pair makes one call of b$divmod (b$udivmod when unsigned) in place of b$div and b$mod:
+// it runs in fewer instructions, counting those of the helpers.  Only qr, uqr and exact
+// divide here.
+TEST_F(BesmSimTest, DivideRemainderPairsRunFaster)
+{
+    static const char *src = "int sink;\n"
+                             "void use(int n) { sink = sink - n; }\n"
+                             "void qr(int a, int b) {\n"
+                             "    int q = a / b;\n"
+                             "    use(q);\n"
+                             "    use(a % b);\n"
+                             "}\n"
+                             "void uqr(unsigned a, unsigned b) {\n"
+                             "    unsigned r = a % b;\n"
+                             "    use(r);\n"
+                             "    use(a / b);\n"
+                             "}\n"
+                             "int exact(int a, int b) {\n"
+                             "    int q = a / b, r = a % b;\n"
+                             "    if (r)\n"
+                             "        return q;\n"
+                             "    return 100 + q;\n"
+                             "}\n"
+                             "int main(void) {\n"
+                             "    int a = -1234567;\n"
+                             "    for (int i = 0; i < 20; i++) {\n"
+                             "        qr(a, 89 + i);\n"
+                             "        uqr(987654321 + i, 9 + i);\n"
+                             "        use(exact(12 + i, 4));\n"
+                             "        a = a + 4321;\n"
+                             "    }\n"
+                             "    return sink & 0177;\n"
+                             "}\n";
+    auto executed = [this] {
+        uint64_t n = 0;
+        for (const char *fn : { "qr", "uqr", "exact", "b$div", "b$mod", "b$mul", "b$udiv",
+                                "b$umod", "b$umul", "b$usub", "b$divmod", "b$udivmod" })
+            n += besm_sim_function_count(sim, fn);
+        return n;
+    };
+    Run(src);
+    int size_status = status;
+    uint64_t size   = executed();
+    EXPECT_EQ(besm_sim_call_count(sim, "b$mod"), 40u); // qr and exact
+    EXPECT_EQ(besm_sim_call_count(sim, "b$umod"), 20u);
+
+    Restart();
+    besm_codegen_options.speed = true;
+    Run(src);
+    EXPECT_EQ(status, size_status);
+    EXPECT_EQ(besm_sim_call_count(sim, "b$mod"), 0u);
+    EXPECT_EQ(besm_sim_call_count(sim, "b$umod"), 0u);
+    EXPECT_EQ(besm_sim_call_count(sim, "b$divmod"), 40u); // qr and exact
+    EXPECT_EQ(besm_sim_call_count(sim, "b$udivmod"), 20u);
+    EXPECT_LT(executed(), size);
+}
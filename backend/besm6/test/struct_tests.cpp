@@ -66,16 +66,14 @@ TEST_F(CodegenTest, CopyOffsetGlobalStruct)
              ,end,
 c
         f:   ,name,
-    b/ret:   ,subp,
         g:   ,subp,
-             ,its, 13
-             ,call, b/save0
+             ,ntr, 7
              ,xta, =7
              ,utc, g
              ,atx,
              ,utc, g
              ,xta, 1
-             ,uj, b/ret
+          13 ,uj,
              ,end,
 )",
               output);
@@ -56,11 +56,10 @@ TEST_F(CodegenTest, UnixGlobalAccess)
     .text
     .globl f
 f:
-    its 13
- 13 vjm b$save0
+    ntr 7
     utc counter
     xta
-    uj b$ret
+ 13 uj
 )",
               out);
 }
@@ -73,10 +72,9 @@ TEST_F(CodegenTest, UnixFloatConst)
     EXPECT_EQ(R"(    .text
     .globl f
 f:
-    its 13
- 13 vjm b$save0
+    ntr 7
     xta #04114436560507534
-    uj b$ret
+ 13 uj
 )",
               out);
 }
@@ -261,13 +259,13 @@ pending:
     .text
     .globl bump
 bump:
-    its 13
- 13 vjm b$save0
+    ntr 7
     utc counter
     xta
     utc pending
     a+x
-    uj b$ret
+    aox
+ 13 uj
 )",
               out);
 }
@@ -6,11 +6,18 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "cache.h"
 #include "codegen.h"
+#include "phase.h"
+#include "server.h"
+#include "string_map.h"
 #include "tac.h"
 #include "wio.h"
 #include "xalloc.h"
 
+#ifndef STDIN_FILENO
+#define STDIN_FILENO 0
+#endif
 #ifndef STDOUT_FILENO
 #define STDOUT_FILENO 1
 #endif
@@ -21,12 +28,20 @@ static FILE *output_file;
 // Structure to hold parsed arguments
 //
 typedef struct {
-    int verbose;          // -v or --verbose
-    int help;             // -h or --help
-    int debug;            // -D or --debug
-    Besm_Dialect dialect; // --madlen / --unix / --bemsh
-    char *input_file;     // Input filename
-    char *output_file;    // Output filename (optional)
+    int verbose;           // -v or --verbose
+    int help;              // -h or --help
+    int debug;             // -D or --debug
+    Besm_Dialect dialect;  // --madlen / --unix / --bemsh
+    char *input_file;      // Input filename
+    char *output_file;     // Output filename (optional)
+    const char *only;      // --only=name,...: emit just these toplevels
+    int time_report;       // --time-report
+    PhaseReportFormat report_format;
+    int stats;             // --stats
+    const char *cache_dir; // --cache
+    const char *server;    // --server
+    int speed;             // --speed
+    int instrument_calls;  // --instrument-calls
 } Args;
 
 // Long-option values for the dialect flags (outside the ASCII range so they do not
@@ -35,6 +50,13 @@ enum {
     OPT_MADLEN = 1000,
     OPT_UNIX,
     OPT_BEMSH,
+    OPT_ONLY,
+    OPT_TIME_REPORT,
+    OPT_STATS,
+    OPT_CACHE,
+    OPT_SERVER,
+    OPT_SPEED,
+    OPT_INSTRUMENT_CALLS,
 };
 
 // Default output-file extension for each dialect.
@@ -66,6 +88,18 @@ static void print_usage(const char *prog_name)
     fprintf(stderr, "        --madlen        Emit Madlen assembly for Dubna\n");
     fprintf(stderr, "        --unix          Emit Unix (b6as) assembly (default)\n");
     fprintf(stderr, "        --bemsh         Emit Bemsh autocode for Dubna\n");
+    fprintf(stderr, "        --only=f1,f2    Emit only the named functions and variables\n");
+    fprintf(stderr, "        --time-report[=json]\n");
+    fprintf(stderr, "                        Print time and memory per phase to stderr\n");
+    fprintf(stderr, "        --speed         Prefer faster code to smaller: inline char-pointer steps\n");
+    fprintf(stderr, "                        and byte stores, leaf functions without b/save,\n");
+    fprintf(stderr, "                        division by constants and divide/remainder pairs\n");
+    fprintf(stderr, "        --instrument-calls\n");
+    fprintf(stderr, "                        Count the calls of each function, written to\n");
+    fprintf(stderr, "                        stderr when main returns (Unix only)\n");
+    fprintf(stderr, "        --stats         Print peephole counters per function to stderr\n");
+    fprintf(stderr, "        --cache DIR     Reuse and store generated code in the cache DIR\n");
+    fprintf(stderr, "        --server SOCKET Serve compile requests on the Unix socket SOCKET\n");
     fprintf(stderr, "    -v, --verbose       Enable verbose mode\n");
     fprintf(stderr, "    -D, --debug         Print debug information\n");
     fprintf(stderr, "    -h, --help          Show this help message\n");
@@ -82,9 +116,16 @@ static void init_args(Args *args)
     // Unix (b6as) is the default dialect; Madlen stays reachable via --madlen (the
     // libc.bin build and the behavioral run tests request it explicitly). See
     // backend/besm6/TODO.md task U4.
-    args->dialect     = BESM_UNIX;
-    args->input_file  = NULL;
-    args->output_file = NULL;
+    args->dialect          = BESM_UNIX;
+    args->input_file       = NULL;
+    args->output_file      = NULL;
+    args->only             = NULL;
+    args->time_report      = 0;
+    args->stats            = 0;
+    args->cache_dir        = NULL;
+    args->server           = NULL;
+    args->speed            = 0;
+    args->instrument_calls = 0;
 }
 
 //
@@ -117,13 +158,20 @@ static char *generate_output_filename(const char *input_file, Besm_Dialect diale
 static int parse_args(int argc, char *argv[], Args *args)
 {
     static struct option long_options[] = {
-        { "verbose", no_argument, 0, 'v' },        //
-        { "help", no_argument, 0, 'h' },           //
-        { "debug", no_argument, 0, 'D' },          //
-        { "madlen", no_argument, 0, OPT_MADLEN },  //
-        { "unix", no_argument, 0, OPT_UNIX },      //
-        { "bemsh", no_argument, 0, OPT_BEMSH },    //
-        {},                                        //
+        { "verbose", no_argument, 0, 'v' },                           //
+        { "help", no_argument, 0, 'h' },                              //
+        { "debug", no_argument, 0, 'D' },                             //
+        { "madlen", no_argument, 0, OPT_MADLEN },                     //
+        { "unix", no_argument, 0, OPT_UNIX },                         //
+        { "bemsh", no_argument, 0, OPT_BEMSH },                       //
+        { "only", required_argument, 0, OPT_ONLY },                   //
+        { "time-report", optional_argument, 0, OPT_TIME_REPORT },     //
+        { "stats", no_argument, 0, OPT_STATS },                       //
+        { "cache", required_argument, 0, OPT_CACHE },                 //
+        { "server", required_argument, 0, OPT_SERVER },               //
+        { "speed", no_argument, 0, OPT_SPEED },                       //
+        { "instrument-calls", no_argument, 0, OPT_INSTRUMENT_CALLS }, //
+        {},                                                           //
     };
 
     int opt;
@@ -154,11 +202,47 @@ static int parse_args(int argc, char *argv[], Args *args)
         case OPT_BEMSH:
             args->dialect = BESM_BEMSH;
             break;
+        case OPT_ONLY:
+            args->only = optarg;
+            break;
+        case OPT_TIME_REPORT:
+            if (!phase_parse_format(optarg, &args->report_format)) {
+                fprintf(stderr, "Error: Unknown --time-report format '%s'\n", optarg);
+                return -1;
+            }
+            args->time_report = 1;
+            break;
+        case OPT_STATS:
+            args->stats = 1;
+            break;
+        case OPT_CACHE:
+            args->cache_dir = optarg;
+            break;
+        case OPT_SERVER:
+            args->server = optarg;
+            break;
+        case OPT_SPEED:
+            args->speed = 1;
+            break;
+        case OPT_INSTRUMENT_CALLS:
+            args->instrument_calls = 1;
+            break;
         case '?': // Unknown option
             return -1;
         }
     }
 
+    // Only the Unix runtime has the list of counters and stderr to write it to.
+    if (args->instrument_calls && args->dialect != BESM_UNIX) {
+        fprintf(stderr, "Error: --instrument-calls needs the Unix dialect\n");
+        return -1;
+    }
+
+    // A server takes its files from each request.
+    if (args->server) {
+        return 0;
+    }
+
     // Check for input filename (required)
     if (optind < argc) {
         args->input_file = argv[optind++];
@@ -197,6 +281,290 @@ static void close_output(const Args *args)
     }
 }
 
+//
+// Name of a toplevel, or NULL.
+//
+static const char *toplevel_name(const Tac_TopLevel *tl)
+{
+    switch (tl->kind) {
+    case TAC_TOPLEVEL_FUNCTION:
+        return tl->u.function.name;
+    case TAC_TOPLEVEL_STATIC_VARIABLE:
+        return tl->u.static_variable.name;
+    case TAC_TOPLEVEL_STATIC_CONSTANT:
+        return tl->u.static_constant.name;
+    default:
+        return NULL;
+    }
+}
+
+//
+// Is `name` one of the comma-separated names in `list`?
+//
+static bool name_listed(const char *list, const char *name)
+{
+    if (!name)
+        return false;
+    size_t len = strlen(name);
+    for (const char *p = list;; p++) {
+        const char *end = strchr(p, ',');
+        size_t n        = end ? (size_t)(end - p) : strlen(p);
+        if (n == len && strncmp(p, name, len) == 0)
+            return true;
+        if (!end)
+            return false;
+        p = end;
+    }
+}
+
+//
+// Append a toplevel to the chain ending at *tail.
+//
+static Tac_TopLevel **append_toplevel(Tac_TopLevel **tail, Tac_TopLevel *tl)
+{
+    *tail = tl;
+    return &tl->next;
+}
+
+static Tac_TopLevel *import_all(WFILE *input)
+{
+    Tac_TopLevel *head = NULL, **tail = &head;
+    for (;;) {
+        Tac_TopLevel *tac = tac_import_toplevel(input);
+        if (!tac)
+            break;
+        tail = append_toplevel(tail, tac);
+    }
+    return head;
+}
+
+//
+// For --only: the listed toplevels, plus every static variable and constant, which the
+// code generator consults by name.  Other functions are never decoded when the stream
+// has an index; without one (older file, or a pipe) they are read and dropped.
+//
+static Tac_TopLevel *import_selected(WFILE *input, const char *only)
+{
+    Tac_TopLevel *head = NULL, **tail = &head;
+    Tac_Index *index   = tac_import_index(input);
+    if (index) {
+        for (size_t i = 0; i < index->count; i++) {
+            const Tac_IndexEntry *e = &index->entries[i];
+            if (e->kind != TAC_TOPLEVEL_FUNCTION || name_listed(only, e->name))
+                tail = append_toplevel(tail, tac_import_toplevel_at(input, e));
+        }
+        tac_free_index(index);
+    } else {
+        for (;;) {
+            Tac_TopLevel *tac = tac_import_toplevel(input);
+            if (!tac)
+                break;
+            if (tac->kind != TAC_TOPLEVEL_FUNCTION || name_listed(only, toplevel_name(tac)))
+                tail = append_toplevel(tail, tac);
+            else
+                tac_free_toplevel(tac);
+        }
+    }
+
+    // Every name on the list must be there.
+    for (const char *p = only; *p;) {
+        const char *end = strchr(p, ',');
+        size_t n        = end ? (size_t)(end - p) : strlen(p);
+        bool found      = false;
+        for (const Tac_TopLevel *tl = head; tl && !found; tl = tl->next) {
+            const char *name = toplevel_name(tl);
+            found            = name && strlen(name) == n && strncmp(name, p, n) == 0;
+        }
+        if (!found && n > 0) {
+            fprintf(stderr, "Error: no function or variable '%.*s'\n", (int)n, p);
+            exit(1);
+        }
+        p += n + (end ? 1 : 0);
+    }
+    return head;
+}
+
+//
+// Compilation cache (--cache).  As in lower, two levels: the whole output, keyed by the
+// input file and the options, and the assembly of each toplevel.
+//
+// A toplevel's code depends on more than the toplevel: on the string constants folded
+// into its module, and for a static variable on the other definitions of its name, which
+// may supersede it.  The constants a module folds are known only once it is built, so an
+// entry lists them with their digests, and a lookup checks them against the program:
+//
+//      nrefs
+//      name digest         -- nrefs lines
+//      assembly...
+//
+// The key is the TAC of the toplevel as lower wrote it.  Lower numbers temporaries and
+// labels across the whole unit, so a function edited to use more or fewer of them shifts
+// the names in every function after it, and those are generated anew.
+//
+typedef struct {
+    WFILE sink;        // toplevels are re-exported here to digest them
+    StringMap consts;  // static constant name -> digest
+    StringMap statics; // static variable name -> definitions in the program
+} ToplevelCache;
+
+static uint64_t toplevel_digest(ToplevelCache *tc, const Tac_TopLevel *tl)
+{
+    wdigest_begin(&tc->sink);
+    tac_export_toplevel(&tc->sink, tl);
+    return wdigest_end(&tc->sink);
+}
+
+static void toplevel_cache_open(ToplevelCache *tc, const Tac_TopLevel *head)
+{
+    if (wopen(&tc->sink, "/dev/null", "w") < 0) {
+        perror("/dev/null");
+        exit(1);
+    }
+    map_init(&tc->consts);
+    map_init(&tc->statics);
+    for (const Tac_TopLevel *tl = head; tl; tl = tl->next) {
+        if (tl->kind == TAC_TOPLEVEL_STATIC_CONSTANT) {
+            map_insert(&tc->consts, tl->u.static_constant.name,
+                       (intptr_t)toplevel_digest(tc, tl), 0);
+        } else if (tl->kind == TAC_TOPLEVEL_STATIC_VARIABLE) {
+            intptr_t count = 0;
+            map_get(&tc->statics, tl->u.static_variable.name, &count);
+            map_insert(&tc->statics, tl->u.static_variable.name, count + 1, 0);
+        }
+    }
+}
+
+static void toplevel_cache_close(ToplevelCache *tc)
+{
+    wclose(&tc->sink);
+    map_destroy(&tc->consts);
+    map_destroy(&tc->statics);
+}
+
+static void toplevel_key(ToplevelCache *tc, CacheKey *key, const Tac_TopLevel *head,
+                         const Tac_TopLevel *tl, Besm_Dialect dialect)
+{
+    cache_key_init(key, "genbesm-toplevel");
+    cache_key_add_word(key, dialect);
+    cache_key_add_word(key, besm_codegen_options.speed);
+    cache_key_add_word(key, besm_codegen_options.instrument_calls);
+    cache_key_add_word(key, toplevel_digest(tc, tl));
+    if (tl->kind != TAC_TOPLEVEL_STATIC_VARIABLE)
+        return;
+
+    // The other definitions of the name, and whether each comes before this one.
+    intptr_t count = 0;
+    map_get(&tc->statics, tl->u.static_variable.name, &count);
+    if (count < 2)
+        return;
+    bool before = true;
+    for (const Tac_TopLevel *o = head; o; o = o->next) {
+        if (o == tl) {
+            before = false;
+        } else if (o->kind == TAC_TOPLEVEL_STATIC_VARIABLE &&
+                   strcmp(o->u.static_variable.name, tl->u.static_variable.name) == 0) {
+            cache_key_add_word(key, before);
+            cache_key_add_word(key, toplevel_digest(tc, o));
+        }
+    }
+}
+
+//
+// Copy the assembly of an entry to the output if the constants it folded are unchanged.
+//
+static bool replay_toplevel(ToplevelCache *tc, const char *path, const char *out_name)
+{
+    FILE *in = fopen(path, "r");
+    if (!in)
+        return false;
+    // Line by line: the assembly that follows starts with white space.
+    char line[1100];
+    int nrefs  = 0;
+    bool valid = fgets(line, sizeof(line), in) && sscanf(line, "%d", &nrefs) == 1;
+    for (int i = 0; valid && i < nrefs; i++) {
+        char name[1024];
+        unsigned long long digest;
+        intptr_t value;
+        valid = fgets(line, sizeof(line), in) &&
+                sscanf(line, "%1023s %llx", name, &digest) == 2 &&
+                map_get(&tc->consts, name, &value) && (uint64_t)value == digest;
+    }
+    if (valid && !cache_copy_stream(in, output_file)) {
+        fprintf(stderr, "Error: cannot write %s\n", out_name);
+        exit(1);
+    }
+    fclose(in);
+    return valid;
+}
+
+static void add_constant(ToplevelCache *tc, StringMap *refs, int *nrefs, const char *name)
+{
+    intptr_t digest;
+    if (name && map_get(&tc->consts, name, &digest) && !map_get(refs, name, NULL)) {
+        map_insert(refs, name, digest, 0);
+        (*nrefs)++;
+    }
+}
+
+static void print_constant(const char *name, intptr_t digest, const void *arg)
+{
+    fprintf((FILE *)arg, "%s %llx\n", name, (unsigned long long)digest);
+}
+
+//
+// Head of an entry: the constants the module refers to, which are those it folded.
+//
+static void list_constants(ToplevelCache *tc, const Besm_Module *module, FILE *out)
+{
+    StringMap refs;
+    int nrefs = 0;
+    map_init(&refs);
+    for (const Besm_Func *fn = module->funcs; fn; fn = fn->next)
+        for (const Besm_Block *b = fn->blocks; b; b = b->next)
+            for (const Besm_Instr *i = b->body; i; i = i->next)
+                add_constant(tc, &refs, &nrefs, i->name);
+    for (const Besm_DataSection *sec = module->sections; sec; sec = sec->next)
+        for (const Besm_Instr *i = sec->items; i; i = i->next)
+            add_constant(tc, &refs, &nrefs, i->name);
+    fprintf(out, "%d\n", nrefs);
+    map_iterate(&refs, print_constant, out);
+    map_destroy(&refs);
+}
+
+//
+// Generate one toplevel into the output and into a new entry, which starts with the
+// list of constants and continues with the same text the output gets.
+//
+static void codegen_and_store(ToplevelCache *tc, const char *dir, const CacheKey *key,
+                              const Tac_TopLevel *head, const Tac_TopLevel *tl,
+                              Besm_Dialect dialect)
+{
+    Besm_Module *module = codegen_module(head, tl, dialect);
+    CacheEntry entry;
+    if (!cache_begin(&entry, dir)) {
+        if (module) {
+            phase_begin("emit");
+            besm_emit_module(output_file, module, dialect);
+            phase_end();
+            besm_free_module(module);
+        }
+        return;
+    }
+    if (module) {
+        list_constants(tc, module, entry.file);
+        long start = ftell(entry.file);
+        phase_begin("emit");
+        besm_emit_module(entry.file, module, dialect);
+        phase_end();
+        besm_free_module(module);
+        fseek(entry.file, start, SEEK_SET);
+        cache_copy_stream(entry.file, output_file);
+    } else {
+        fprintf(entry.file, "0\n");
+    }
+    cache_commit(&entry, dir, key);
+}
+
 //
 // Main processing function
 //
@@ -212,30 +580,84 @@ void process_file(const Args *args)
         // wio_debug        = 1;
         // xalloc_debug     = 1;
     }
+
+    CacheKey file_key;
+    bool cache_file = false;
+    if (args->cache_dir && strcmp(args->input_file, "-") != 0 && args->output_file[0] != '-') {
+        phase_begin("cache");
+        cache_key_init(&file_key, "genbesm");
+        cache_key_add_word(&file_key, args->dialect);
+        cache_key_add_word(&file_key, args->speed);
+        cache_key_add_word(&file_key, args->instrument_calls);
+        cache_key_add_str(&file_key, args->only);
+        cache_file = cache_key_add_file(&file_key, args->input_file);
+        bool hit = cache_file && cache_fetch_file(args->cache_dir, &file_key, args->output_file);
+        phase_end();
+        if (hit) {
+            if (args->verbose)
+                printf("Copied %s from the cache\n", args->output_file);
+            return;
+        }
+    }
     open_output(args);
 
     WFILE input;
-    wopen(&input, args->input_file, "r");
+    int status = strcmp(args->input_file, "-") == 0 ? wdopen(&input, STDIN_FILENO, "r")
+                                                   : wopen(&input, args->input_file, "r");
+    if (status < 0) {
+        perror(args->input_file);
+        exit(1);
+    }
 
     // Phase 1: read all toplevels into a linked chain for global-name resolution.
-    Tac_TopLevel *head = NULL, **tail_ptr = &head;
-    for (;;) {
-        Tac_TopLevel *tac = tac_import_toplevel(&input);
-        if (!tac)
-            break;
-        *tail_ptr = tac;
-        tail_ptr  = &tac->next;
-    }
+    // On a pipe this decodes each declaration as lower flushes it, but code generation
+    // must wait for the end: a later definition may supersede a static variable.
+    phase_begin("import");
+    Tac_TopLevel *head = args->only ? import_selected(&input, args->only) : import_all(&input);
     wclose(&input);
+    phase_end();
 
     // Phase 2: codegen each toplevel with the full program chain as context.
+    ToplevelCache tc;
+    if (args->cache_dir)
+        toplevel_cache_open(&tc, head);
+    if (args->stats)
+        besm_peep_stats_print_header(stderr);
     for (const Tac_TopLevel *tl = head; tl; tl = tl->next) {
+        if (args->only && !name_listed(args->only, toplevel_name(tl)))
+            continue;
         if (args->debug)
             tac_print_toplevel(stdout, tl, 0);
-        codegen_program(head, tl, output_file, args->dialect);
+        Besm_PeepStats before = besm_peep_stats;
+        if (args->cache_dir && tl->kind != TAC_TOPLEVEL_STATIC_CONSTANT) {
+            phase_begin("cache");
+            CacheKey key;
+            toplevel_key(&tc, &key, head, tl, args->dialect);
+            char *entry = cache_lookup(args->cache_dir, &key);
+            bool hit    = entry && replay_toplevel(&tc, entry, args->output_file);
+            xfree(entry);
+            phase_end();
+            if (!hit)
+                codegen_and_store(&tc, args->cache_dir, &key, head, tl, args->dialect);
+        } else {
+            codegen_program(head, tl, output_file, args->dialect);
+        }
+        if (args->stats && besm_peep_stats.functions != before.functions)
+            besm_peep_stats_print(stderr, toplevel_name(tl), &before);
     }
+    if (args->stats)
+        besm_peep_stats_print(stderr, "total", NULL);
     tac_free_toplevel(head);
+    tac_intern_destroy();
     close_output(args);
+    if (args->cache_dir) {
+        toplevel_cache_close(&tc);
+        if (cache_file)
+            cache_store_file(args->cache_dir, &file_key, args->output_file);
+        if (args->verbose)
+            printf("Cache: %lu hits, %lu misses, %lu stored\n", cache_stats.hits,
+                   cache_stats.misses, cache_stats.stores);
+    }
 
     if (args->debug) {
         xreport_lost_memory();
@@ -274,8 +696,23 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    if (args.server) {
+        // Run the requests of compile clients until stopped; see server.h.
+        return server_run(args.server, main);
+    }
+
+    if (args.time_report) {
+        phase_enable();
+    }
+    besm_codegen_options.speed            = args.speed;
+    besm_codegen_options.instrument_calls = args.instrument_calls;
+
     // Pass args to backend for processing
     process_file(&args);
 
+    if (args.time_report) {
+        phase_report(stderr, "genbesm", args.report_format);
+    }
+
     return 0;
 }
@@ -0,0 +1,193 @@
+//
+// profdump: collect the call counts a BESM-6 program compiled with genbesm
+// --instrument-calls writes to stderr, and print them by function, hottest first.
+//
+// The counts are `calls <count> <name>` lines (libc/besm6/unix/callcount.c); every other
+// line, such as the program's own diagnostics, is skipped.  The counts of a function in
+// several files, from several runs, are added up.
+//
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_map.h"
+#include "xalloc.h"
+
+//
+// Structure to hold parsed arguments
+//
+typedef struct {
+    int help;   // -h or --help
+    long limit; // -n or --lines: print this many functions, 0 for all
+    int ninputs;
+    char **inputs;
+} Args;
+
+//
+// One function and its calls.
+//
+typedef struct {
+    const char *name;
+    uint64_t calls;
+} Entry;
+
+typedef struct {
+    Entry *entries;
+    int count;
+} Table;
+
+static void print_usage(const char *prog_name)
+{
+    const char *p = strrchr(prog_name, '/');
+    if (p) {
+        prog_name = p + 1;
+    }
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "    %s [options] file...\n", prog_name);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "    -n, --lines N       Print only the N most called functions\n");
+    fprintf(stderr, "    -h, --help          Show this help message\n");
+    fprintf(stderr, "Each file holds the stderr of a run of a program compiled with\n");
+    fprintf(stderr, "genbesm --instrument-calls; `-` reads the standard input.\n");
+}
+
+static int parse_args(int argc, char *argv[], Args *args)
+{
+    static struct option long_options[] = {
+        { "help", no_argument, 0, 'h' },        //
+        { "lines", required_argument, 0, 'n' }, //
+        {},                                     //
+    };
+
+    int opt;
+    int option_index = 0;
+    char *end;
+
+    if (argc < 2) {
+        args->help = 1;
+        return 0;
+    }
+    while ((opt = getopt_long(argc, argv, "hn:", long_options, &option_index)) != -1) {
+        switch (opt) {
+        case 'h':
+            args->help = 1;
+            return 0;
+        case 'n':
+            args->limit = strtol(optarg, &end, 10);
+            if (*end != '\0' || args->limit < 0) {
+                fprintf(stderr, "Error: Bad number of lines '%s'\n", optarg);
+                return -1;
+            }
+            break;
+        case '?':
+            return -1;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Error: Input filename is required\n");
+        return -1;
+    }
+    args->inputs  = &argv[optind];
+    args->ninputs = argc - optind;
+    return 0;
+}
+
+//
+// Add the counts of one file to `counts`, by name.
+//
+static void read_counts(const char *path, StringMap *counts)
+{
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!in) {
+        perror(path);
+        exit(1);
+    }
+    char line[1024], name[1000];
+    unsigned long long calls;
+    while (fgets(line, sizeof(line), in)) {
+        if (sscanf(line, "calls %llu %999s", &calls, name) != 2)
+            continue;
+        intptr_t sum = 0;
+        map_get(counts, name, &sum);
+        map_insert(counts, name, sum + (intptr_t)calls, 0);
+    }
+    if (in != stdin)
+        fclose(in);
+}
+
+static void count_entry(const char *key, intptr_t value, const void *arg)
+{
+    (void)key;
+    (void)value;
+    (*(int *)arg)++;
+}
+
+static void add_entry(const char *key, intptr_t value, const void *arg)
+{
+    Table *table = (Table *)arg;
+    Entry *e     = &table->entries[table->count++];
+    e->name      = key;
+    e->calls     = (uint64_t)value;
+}
+
+// Most calls first; equal counts by name.
+static int compare_entries(const void *a, const void *b)
+{
+    const Entry *x = a;
+    const Entry *y = b;
+    if (x->calls != y->calls)
+        return x->calls > y->calls ? -1 : 1;
+    return strcmp(x->name, y->name);
+}
+
+static void print_counts(StringMap *counts, long limit)
+{
+    int n = 0;
+    map_iterate(counts, count_entry, &n);
+    if (n == 0) {
+        fprintf(stderr, "Warning: no call counts found\n");
+        return;
+    }
+    Table table   = { 0 };
+    table.entries = xalloc(n * sizeof(Entry), __func__, __FILE__, __LINE__);
+    map_iterate(counts, add_entry, &table);
+    qsort(table.entries, n, sizeof(Entry), compare_entries);
+
+    uint64_t total = 0;
+    for (int i = 0; i < n; i++)
+        total += table.entries[i].calls;
+
+    printf("%12s %7s %7s  %s\n", "calls", "%", "cum%", "function");
+    uint64_t sum = 0;
+    for (int i = 0; i < n && (limit == 0 || i < limit); i++) {
+        const Entry *e = &table.entries[i];
+        sum += e->calls;
+        printf("%12llu %7.2f %7.2f  %s\n", (unsigned long long)e->calls,
+               100.0 * e->calls / total, 100.0 * sum / total, e->name);
+    }
+    xfree(table.entries);
+}
+
+int main(int argc, char *argv[])
+{
+    Args args = { 0 };
+
+    if (parse_args(argc, argv, &args) != 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (args.help) {
+        print_usage(argv[0]);
+        return 0;
+    }
+
+    StringMap counts;
+    map_init(&counts);
+    for (int i = 0; i < args.ninputs; i++)
+        read_counts(args.inputs[i], &counts);
+    print_counts(&counts, args.limit);
+    map_destroy(&counts);
+    return 0;
+}
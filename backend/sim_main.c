@@ -0,0 +1,206 @@
+//
+// besmsim: code-generate TAC for BESM-6, link it with the runtime library and run it
+// on the in-process simulator.
+//
+#include <getopt.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "besm_sim.h"
+#include "codegen.h"
+#include "phase.h"
+#include "semantic.h"
+#include "target.h"
+#include "wio.h"
+#include "xalloc.h"
+
+//
+// Structure to hold parsed arguments
+//
+typedef struct {
+    int help;                // -h or --help
+    int profile;             // -p or --profile
+    const char *runtime_dir; // -L/--runtime
+    int time_report;         // --time-report
+    int instrument_calls;    // --instrument-calls
+    PhaseReportFormat report_format;
+    int ninputs;             // TAC and .s files before `--`
+    char **inputs;
+    int nargs;               // arguments of the program, argv[0] included
+    char **args;
+} Args;
+
+static void print_usage(const char *prog_name)
+{
+    const char *p = strrchr(prog_name, '/');
+    if (p) {
+        prog_name = p + 1;
+    }
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "    %s [options] input.tac|input.s... [-- program-arguments]\n", prog_name);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "    -p, --profile       Print dynamic instruction counts to stderr\n");
+    fprintf(stderr, "    -L, --runtime DIR   Runtime library sources (default: %s)\n",
+            BESM6_RUNTIME_DIR);
+    fprintf(stderr, "    --instrument-calls  Count the calls of each function of the TAC inputs\n");
+    fprintf(stderr, "    --time-report[=json]\n");
+    fprintf(stderr, "                        Print time and memory per phase to stderr\n");
+    fprintf(stderr, "    -h, --help          Show this help message\n");
+    fprintf(stderr, "Each TAC file is one translation unit.\n");
+    fprintf(stderr, "The exit status is the value main() returns, or the argument of exit().\n");
+}
+
+static int parse_args(int argc, char *argv[], Args *args)
+{
+    static struct option long_options[] = {
+        { "help", no_argument, 0, 'h' },              //
+        { "profile", no_argument, 0, 'p' },           //
+        { "runtime", required_argument, 0, 'L' },     //
+        { "time-report", optional_argument, 0, 256 }, //
+        { "instrument-calls", no_argument, 0, 257 },  //
+        {},                                           //
+    };
+
+    int opt;
+    int option_index = 0;
+
+    if (argc < 2) {
+        args->help = 1;
+        return 0;
+    }
+    while ((opt = getopt_long(argc, argv, "+hpL:", long_options, &option_index)) != -1) {
+        switch (opt) {
+        case 'h':
+            args->help = 1;
+            return 0;
+        case 'p':
+            args->profile = 1;
+            break;
+        case 'L':
+            args->runtime_dir = optarg;
+            break;
+        case 256:
+            if (!phase_parse_format(optarg, &args->report_format)) {
+                fprintf(stderr, "Error: Unknown --time-report format '%s'\n", optarg);
+                return -1;
+            }
+            args->time_report = 1;
+            break;
+        case 257:
+            args->instrument_calls = 1;
+            break;
+        case '?':
+            return -1;
+        }
+    }
+
+    // As in tacrun: everything up to `--` is an input, the rest belongs to the program.
+    args->inputs = &argv[optind];
+    while (optind < argc && strcmp(argv[optind], "--") != 0) {
+        args->ninputs++;
+        optind++;
+    }
+    if (args->ninputs == 0) {
+        fprintf(stderr, "Error: Input filename is required\n");
+        return -1;
+    }
+    // The program sees the first input as its argv[0].
+    if (optind < argc) {
+        argv[optind] = args->inputs[0];
+        args->args   = &argv[optind];
+        args->nargs  = argc - optind;
+    } else {
+        args->args  = args->inputs;
+        args->nargs = 1;
+    }
+    return 0;
+}
+
+//
+// Load one TAC file, in either encoding, as a translation unit.
+//
+static void load_tac(Besm_Sim *sim, const char *path)
+{
+    WFILE input;
+    int status = strcmp(path, "-") == 0 ? wdopen(&input, STDIN_FILENO, "r")
+                                        : wopen(&input, path, "r");
+    if (status < 0) {
+        perror(path);
+        exit(1);
+    }
+    phase_begin("import");
+    Tac_TopLevel *program = NULL;
+    Tac_TopLevel **tail   = &program;
+    for (;;) {
+        Tac_TopLevel *tac = tac_import_toplevel(&input);
+        if (!tac)
+            break;
+        *tail = tac;
+        while (*tail)
+            tail = &(*tail)->next;
+    }
+    wclose(&input);
+    phase_end();
+
+    besm_sim_load_program(sim, program);
+    tac_free_toplevel(program);
+}
+
+//
+// Error handling
+//
+void _Noreturn fatal_error(const char *message, ...)
+{
+    fprintf(stderr, "Fatal error: ");
+
+    va_list ap;
+    va_start(ap, message);
+    vfprintf(stderr, message, ap);
+    va_end(ap);
+
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    Args args = { .runtime_dir = BESM6_RUNTIME_DIR };
+
+    if (parse_args(argc, argv, &args) != 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (args.help) {
+        print_usage(argv[0]);
+        return 0;
+    }
+    if (args.time_report)
+        phase_enable();
+    target_config                         = target_lookup("besm6");
+    besm_codegen_options.instrument_calls = args.instrument_calls;
+
+    Besm_Sim *sim = besm_sim_create(stdout);
+    for (int i = 0; i < args.ninputs; i++) {
+        const char *path = args.inputs[i];
+        size_t len       = strlen(path);
+        if (len > 2 && strcmp(path + len - 2, ".s") == 0)
+            besm_sim_load_assembly(sim, path);
+        else
+            load_tac(sim, path);
+    }
+    besm_sim_load_assembly(sim, args.runtime_dir);
+
+    int status = besm_sim_run(sim, args.nargs, args.args);
+    if (args.profile)
+        besm_sim_print_profile(stderr, sim);
+
+    besm_sim_destroy(sim);
+    tac_intern_destroy();
+    if (args.time_report)
+        phase_report(stderr, "besmsim", args.report_format);
+    xfree_all();
+    return status;
+}
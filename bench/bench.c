@@ -0,0 +1,301 @@
+//
+// compiler-bench: compile synthetic stress inputs in-process and report the cost of
+// each stage per unit of work, so that a stage which turns quadratic shows up as a
+// per-token or per-instruction cost that grows with the input.
+//
+// Every input runs in a child process of its own: the peak resident set size the
+// kernel reports is then the peak of that input alone, and an input that crashes a
+// stage is reported without stopping the others.
+//
+#include <getopt.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "codegen.h"
+#include "gen.h"
+#include "optimize.h"
+#include "parser.h"
+#include "phase.h"
+#include "scanner.h"
+#include "semantic.h"
+#include "structtab.h"
+#include "symtab.h"
+#include "target.h"
+#include "translate.h"
+#include "xalloc.h"
+
+//
+// Structure to hold parsed arguments
+//
+typedef struct {
+    int help;     // -h or --help
+    int list;     // -l or --list
+    double scale; // -s or --scale: multiplies every input size
+    int nnames;   // inputs to run; all when none
+    char **names;
+} Args;
+
+//
+// What one input cost.  Stage times are wall-clock nanoseconds.
+//
+typedef struct {
+    int size;
+    unsigned long tokens;
+    unsigned long tac_before; // TAC instructions entering the optimizer
+    unsigned long tac_after;  // and leaving it, what code generation consumes
+    uint64_t parse_nsec;      // scanning included
+    uint64_t translate_nsec;  // typecheck and translation, the optimizer excluded
+    uint64_t optimize_nsec;
+    uint64_t codegen_nsec;
+} Result;
+
+// The optimizer's phases, as named in optimize.c.
+static const char *const optimizer_phases[] = {
+    "const-fold", "cfg", "unreachable", "copy-prop", "dead-store",
+};
+
+static void print_usage(const char *prog_name)
+{
+    const char *p = strrchr(prog_name, '/');
+    if (p) {
+        prog_name = p + 1;
+    }
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "    %s [options] [input...]\n", prog_name);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "    -s, --scale F       Multiply every input size by F (default 1)\n");
+    fprintf(stderr, "    -l, --list          List the inputs and their default sizes\n");
+    fprintf(stderr, "    -h, --help          Show this help message\n");
+    fprintf(stderr, "Without inputs, every input is run.\n");
+}
+
+static int parse_args(int argc, char *argv[], Args *args)
+{
+    static struct option long_options[] = {
+        { "help", no_argument, 0, 'h' },        //
+        { "list", no_argument, 0, 'l' },        //
+        { "scale", required_argument, 0, 's' }, //
+        {},                                     //
+    };
+
+    int opt;
+    int option_index = 0;
+
+    while ((opt = getopt_long(argc, argv, "hls:", long_options, &option_index)) != -1) {
+        switch (opt) {
+        case 'h':
+            args->help = 1;
+            return 0;
+        case 'l':
+            args->list = 1;
+            break;
+        case 's': {
+            char *end;
+            args->scale = strtod(optarg, &end);
+            if (*end != '\0' || args->scale <= 0) {
+                fprintf(stderr, "Error: Bad scale '%s'\n", optarg);
+                return -1;
+            }
+            break;
+        }
+        case '?':
+            return -1;
+        }
+    }
+    args->names  = &argv[optind];
+    args->nnames = argc - optind;
+    for (int i = 0; i < args->nnames; i++) {
+        int found = 0;
+        for (int j = 0; j < bench_num_inputs; j++)
+            found |= strcmp(args->names[i], bench_inputs[j].name) == 0;
+        if (!found) {
+            fprintf(stderr, "Error: Unknown input '%s'\n", args->names[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static uint64_t now_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Nanoseconds per unit, or 0 when there are no units.
+static double per(uint64_t nsec, unsigned long units)
+{
+    return units ? (double)nsec / units : 0.0;
+}
+
+//
+// Compile one input, start to finish, and measure every stage.
+//
+static void compile(const BenchInput *input, int size, Result *r)
+{
+    r->size    = size;
+    FILE *src  = tmpfile();
+    FILE *sink = fopen("/dev/null", "w");
+    if (!src || !sink) {
+        perror("compiler-bench");
+        exit(1);
+    }
+    input->generate(src, size);
+
+    // A pass of the scanner alone, for the token count.
+    rewind(src);
+    init_scanner(src);
+    while (yylex() != TOKEN_EOF)
+        r->tokens++;
+
+    rewind(src);
+    uint64_t t       = now_nsec();
+    Program *program = parse(src);
+    r->parse_nsec    = now_nsec() - t;
+
+    // Typecheck and translate each declaration as `lower` does; the optimizer runs
+    // inside translate() and is timed through its phases.
+    phase_enable();
+    OptStats before     = opt_stats;
+    Tac_TopLevel *head  = NULL;
+    Tac_TopLevel **tail = &head;
+    int label_seq       = 0;
+    symtab_init();
+    structtab_init();
+    t = now_nsec();
+    for (ExternalDecl *decl = program->decls; decl; decl = decl->next) {
+        typecheck_decl(decl, &label_seq);
+        *tail = translate(decl, opt_flags_default(), &label_seq);
+        while (*tail)
+            tail = &(*tail)->next;
+    }
+    uint64_t front = now_nsec() - t;
+    for (size_t i = 0; i < sizeof(optimizer_phases) / sizeof(optimizer_phases[0]); i++) {
+        const PhaseStats *p = phase_stats(optimizer_phases[i]);
+        if (p)
+            r->optimize_nsec += p->nsec;
+    }
+    r->translate_nsec = front - r->optimize_nsec;
+    r->tac_before     = opt_stats.instrs_before - before.instrs_before;
+    r->tac_after      = opt_stats.instrs_after - before.instrs_after;
+
+    t = now_nsec();
+    for (const Tac_TopLevel *tl = head; tl; tl = tl->next)
+        codegen_program(head, tl, sink, BESM_UNIX);
+    r->codegen_nsec = now_nsec() - t;
+
+    fclose(sink);
+    fclose(src);
+}
+
+//
+// One row per input.  `ns/tok` is parse time (scanning included) per token; the
+// optimizer's `ns/TAC` is per instruction it was given, the code generator's per
+// instruction it was left with.
+//
+static void print_header(void)
+{
+    printf("%-16s %7s %8s %8s %6s %8s %8s %8s %6s %8s %8s %6s %8s\n", "input", "size",
+           "tokens", "parse ms", "ns/tok", "xlat ms", "TAC", "opt ms", "ns/TAC", "TAC out",
+           "cg ms", "ns/TAC", "peak MB");
+}
+
+//
+// Run one input in a child process and print its row.
+//
+static int run_input(const BenchInput *input, double scale)
+{
+    int size = (int)(input->size * scale + 0.5);
+    if (size < 1)
+        size = 1;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        Result r = { 0 };
+        compile(input, size, &r);
+
+        // ru_maxrss is in kilobytes on Linux.
+        struct rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        printf("%-16s %7d %8lu %8.1f %6.0f %8.1f %8lu %8.1f %6.0f %8lu %8.1f %6.0f %8.1f\n",
+               input->name, r.size, r.tokens, r.parse_nsec / 1e6, per(r.parse_nsec, r.tokens),
+               r.translate_nsec / 1e6, r.tac_before, r.optimize_nsec / 1e6,
+               per(r.optimize_nsec, r.tac_before), r.tac_after, r.codegen_nsec / 1e6,
+               per(r.codegen_nsec, r.tac_after), ru.ru_maxrss / 1024.0);
+        fflush(stdout);
+        _exit(0);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    if (WIFSIGNALED(status)) {
+        printf("%-16s %7d killed by signal %d\n", input->name, size, WTERMSIG(status));
+        return 1;
+    }
+    if (WEXITSTATUS(status) != 0) {
+        printf("%-16s %7d failed with status %d\n", input->name, size, WEXITSTATUS(status));
+        return 1;
+    }
+    return 0;
+}
+
+//
+// Error handling
+//
+void _Noreturn fatal_error(const char *message, ...)
+{
+    fprintf(stderr, "Fatal error: ");
+
+    va_list ap;
+    va_start(ap, message);
+    vfprintf(stderr, message, ap);
+    va_end(ap);
+
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    Args args = { .scale = 1.0 };
+
+    if (parse_args(argc, argv, &args) != 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (args.help) {
+        print_usage(argv[0]);
+        return 0;
+    }
+    if (args.list) {
+        for (int i = 0; i < bench_num_inputs; i++)
+            printf("%-16s %7d  %s\n", bench_inputs[i].name, bench_inputs[i].size,
+                   bench_inputs[i].description);
+        return 0;
+    }
+    target_config = target_lookup("besm6");
+
+    print_header();
+    int failed = 0;
+    for (int i = 0; i < bench_num_inputs; i++) {
+        const BenchInput *input = &bench_inputs[i];
+        int selected            = args.nnames == 0;
+        for (int j = 0; j < args.nnames; j++)
+            selected |= strcmp(args.names[j], input->name) == 0;
+        if (selected && run_input(input, args.scale) != 0)
+            failed = 1;
+    }
+    return failed;
+}
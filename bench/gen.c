@@ -0,0 +1,147 @@
+//
+// Synthetic stress inputs for the compiler benchmark.  See gen.h.
+//
+#include "gen.h"
+
+//
+// n small functions: the per-declaration cost of every stage, and any table that
+// grows with the unit (symbols, interned names, the codegen's module-level lookups).
+//
+static void gen_functions(FILE *out, int n)
+{
+    for (int i = 0; i < n; i++) {
+        fprintf(out, "int f%d(int a, int b)\n", i);
+        fprintf(out, "{\n");
+        fprintf(out, "    int t = a * %d;\n", i % 97 + 1);
+        fprintf(out, "    if (t > b)\n");
+        fprintf(out, "        return t - b;\n");
+        fprintf(out, "    return b + %d;\n", i);
+        fprintf(out, "}\n");
+    }
+}
+
+//
+// One function of n statements: the dataflow passes, whose sets grow with both the
+// number of instructions and the number of variables live across them.
+//
+static void gen_long_function(FILE *out, int n)
+{
+    fprintf(out, "int big(int a, int b)\n");
+    fprintf(out, "{\n");
+    fprintf(out, "    int s = 0, t = 1, u = 2, v = 3;\n");
+    for (int i = 0; i < n; i++) {
+        switch (i % 5) {
+        case 0:
+            fprintf(out, "    s = s + a * %d;\n", i % 1000);
+            break;
+        case 1:
+            fprintf(out, "    t = s ^ %d;\n", i % 1000);
+            break;
+        case 2:
+            fprintf(out, "    if (t > b) u = u + t; else u = u - %d;\n", i % 1000);
+            break;
+        case 3:
+            fprintf(out, "    v = u;\n");
+            break;
+        default:
+            fprintf(out, "    s = v + t;\n");
+            break;
+        }
+    }
+    fprintf(out, "    return s + t + u + v;\n");
+    fprintf(out, "}\n");
+}
+
+//
+// An expression nested n parentheses deep: every recursive walk over the AST and the
+// translator's temporaries, one per level.
+//
+static void gen_deep_expression(FILE *out, int n)
+{
+    fprintf(out, "int deep(int a)\n");
+    fprintf(out, "{\n");
+    fprintf(out, "    return ");
+    for (int i = 0; i < n; i++)
+        fprintf(out, "(a %c ", "+-*^"[i % 4]);
+    fprintf(out, "1");
+    for (int i = 0; i < n; i++)
+        fprintf(out, ")");
+    fprintf(out, ";\n");
+    fprintf(out, "}\n");
+}
+
+//
+// A static array with n initializers: the initializer lists, their TAC, and the data
+// section.
+//
+static void gen_static_initializer(FILE *out, int n)
+{
+    fprintf(out, "static int table[%d] = {\n", n);
+    for (int i = 0; i < n; i++)
+        fprintf(out, "    %d,%s", (i * 7919) % 100000, (i % 8 == 7) ? "\n" : "");
+    fprintf(out, "\n};\n");
+    fprintf(out, "int lookup(int i)\n");
+    fprintf(out, "{\n");
+    fprintf(out, "    return table[i];\n");
+    fprintf(out, "}\n");
+}
+
+//
+// A switch of n cases: case collection, duplicate checks and the compare chain.
+//
+static void gen_switch(FILE *out, int n)
+{
+    fprintf(out, "int select(int x)\n");
+    fprintf(out, "{\n");
+    fprintf(out, "    switch (x) {\n");
+    for (int i = 0; i < n; i++)
+        fprintf(out, "    case %d:\n        return %d;\n", i * 3, i);
+    fprintf(out, "    default:\n        return -1;\n");
+    fprintf(out, "    }\n");
+    fprintf(out, "}\n");
+}
+
+//
+// A struct of n members, every one of them read: member lookup and layout.
+//
+static void gen_struct(FILE *out, int n)
+{
+    fprintf(out, "struct wide {\n");
+    for (int i = 0; i < n; i++)
+        fprintf(out, "    int m%d;\n", i);
+    fprintf(out, "};\n");
+    fprintf(out, "int sum(struct wide *p)\n");
+    fprintf(out, "{\n");
+    fprintf(out, "    int s = 0;\n");
+    for (int i = 0; i < n; i++)
+        fprintf(out, "    s = s + p->m%d;\n", i);
+    fprintf(out, "    return s;\n");
+    fprintf(out, "}\n");
+}
+
+//
+// n typedefs, each naming the previous one: typedef resolution in the parser's name
+// table and in the type checker.
+//
+static void gen_typedef_chain(FILE *out, int n)
+{
+    fprintf(out, "typedef int t0;\n");
+    for (int i = 1; i < n; i++)
+        fprintf(out, "typedef t%d t%d;\n", i - 1, i);
+    fprintf(out, "t%d last(t%d x)\n", n - 1, n - 1);
+    fprintf(out, "{\n");
+    fprintf(out, "    t%d y = x + 1;\n", n / 2);
+    fprintf(out, "    return y;\n");
+    fprintf(out, "}\n");
+}
+
+const BenchInput bench_inputs[] = {
+    { "functions", "number of functions", 10000, gen_functions },
+    { "long-function", "statements in one function", 100000, gen_long_function },
+    { "deep-expression", "nesting depth of one expression", 2000, gen_deep_expression },
+    { "static-init", "initializers of one array", 100000, gen_static_initializer },
+    { "switch", "cases of one switch", 10000, gen_switch },
+    { "struct", "members of one struct", 1000, gen_struct },
+    { "typedef-chain", "typedefs naming the previous one", 10000, gen_typedef_chain },
+};
+const int bench_num_inputs = sizeof(bench_inputs) / sizeof(bench_inputs[0]);
@@ -0,0 +1,21 @@
+//
+// Generators of synthetic stress inputs for the compiler benchmark.
+//
+// Each generator writes one C translation unit that pushes a single dimension of the
+// compiler to its limit — the number of functions, the length of one function, the
+// nesting depth of an expression, the size of an initializer, and so on — while
+// staying ordinary C that every stage accepts.  `n` is the size along that dimension.
+//
+#pragma once
+
+#include <stdio.h>
+
+typedef struct {
+    const char *name;        // selects the input on the command line
+    const char *description; // what grows, for --list
+    int size;                // default n, multiplied by --scale
+    void (*generate)(FILE *out, int n);
+} BenchInput;
+
+extern const BenchInput bench_inputs[];
+extern const int bench_num_inputs;
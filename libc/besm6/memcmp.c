@@ -3,21 +3,45 @@
  *
  * Returns <0, 0, or >0 according to whether the first differing byte in s1 is
  * less than, equal to, or greater than the corresponding byte in s2, with the
- * bytes interpreted as unsigned char.  s1/s2 are fat char* cursors.
+ * bytes interpreted as unsigned char.  s1/s2 are fat char* cursors.  Once both
+ * reach a word boundary together, equal words are skipped six bytes at a time;
+ * the first word that differs is compared byte by byte.
  */
 #include <string.h>
 
+#include "wordops.h"
+
 int memcmp(const void *s1, const void *s2, size_t n)
 {
     const unsigned char *a = s1;
     const unsigned char *b = s2;
-    while (n > 0) {
+    int count = (int)n;
+    while (count > 0 && MID_WORD(a)) {
+        if (*a != *b) {
+            return (int)*a - (int)*b;
+        }
+        a++;
+        b++;
+        count--;
+    }
+    if (count >= 6 && AT_WORD(b)) {
+        const unsigned *wa = (const unsigned *)a;
+        const unsigned *wb = (const unsigned *)b;
+        while (count >= 6 && *wa == *wb) {
+            wa++;
+            wb++;
+            count -= 6;
+        }
+        a = (const unsigned char *)wa;
+        b = (const unsigned char *)wb;
+    }
+    while (count > 0) {
         if (*a != *b) {
             return (int)*a - (int)*b;
         }
         a++;
         b++;
-        n--;
+        count--;
     }
     return 0;
 }
@@ -3,19 +3,37 @@
  *
  * The objects must not overlap; use memmove for overlapping regions.  On the
  * BESM-6 char* / void* are fat pointers, so the byte cursors d and s advance
- * across word boundaries on their own (b/pinc).
+ * across word boundaries on their own (b/pinc).  Once d reaches a word
+ * boundary, if s has reached one too, whole words are copied, six bytes a
+ * step, and the bytes left over after the last whole word go one at a time.
+ *
+ * The count is kept in an int: the address space is 196,608 bytes, and int
+ * arithmetic is inline where size_t arithmetic calls b/usub.
  */
 #include <string.h>
 
+#include "wordops.h"
+
 void *memcpy(void *dest, const void *src, size_t n)
 {
     char *d = dest;
     const char *s = src;
-    while (n > 0) {
-        *d = *s;
-        d++;
-        s++;
-        n--;
+    int count = (int)n;
+    while (count > 0 && MID_WORD(d)) {
+        *d++ = *s++;
+        count--;
+    }
+    if (count >= 6 && AT_WORD(s)) {
+        unsigned *wd = (unsigned *)d;
+        const unsigned *ws = (const unsigned *)s;
+        for (; count >= 6; count -= 6)
+            *wd++ = *ws++;
+        d = (char *)wd;
+        s = (const char *)ws;
+    }
+    while (count > 0) {
+        *d++ = *s++;
+        count--;
     }
     return dest;
 }
@@ -2,27 +2,41 @@
  * memmove — copy n bytes from src to dest, overlap-safe (C11 §7.24.2.2).
  *
  * Unlike memcpy, the regions may overlap.  When dest precedes src the copy
- * runs forward; otherwise it runs backward (high index to low) so a byte is
- * read before it is overwritten.  d/s are fat char* cursors.
+ * runs forward, which is memcpy's own order: it reads every word or byte
+ * before it stores the one at the same place in dest.  Otherwise it runs
+ * backward from the end, bytes down to a word boundary of dest, whole words
+ * while src is on a boundary too, and the rest bytes again.  d/s are fat char*
+ * cursors.
  */
 #include <string.h>
 
+#include "wordops.h"
+
 void *memmove(void *dest, const void *src, size_t n)
 {
     char *d = dest;
     const char *s = src;
-    if (d < s) {
-        size_t i = 0;
-        while (i < n) {
-            d[i] = s[i];
-            i++;
-        }
-    } else {
-        size_t i = n;
-        while (i > 0) {
-            i--;
-            d[i] = s[i];
-        }
+    if (d < s)
+        return memcpy(dest, src, n);
+
+    int count = (int)n;
+    d += count;
+    s += count;
+    while (count > 0 && MID_WORD(d)) {
+        *--d = *--s;
+        count--;
+    }
+    if (count >= 6 && AT_WORD(s)) {
+        unsigned *wd = (unsigned *)d;
+        const unsigned *ws = (const unsigned *)s;
+        for (; count >= 6; count -= 6)
+            *--wd = *--ws;
+        d = (char *)wd;
+        s = (const char *)ws;
+    }
+    while (count > 0) {
+        *--d = *--s;
+        count--;
     }
     return dest;
 }
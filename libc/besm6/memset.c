@@ -2,18 +2,36 @@
  * memset — fill the first n bytes of s with the byte value c (C11 §7.24.6.1).
  *
  * c is converted to unsigned char before storing.  s is traversed as a fat
- * char* cursor, so the fill crosses word boundaries on its own (b/pinc).
+ * char* cursor up to the first word boundary; from there the byte, replicated
+ * into all six bytes of a word, is stored a word at a time, and the last few
+ * bytes one by one.  The count is an int, whose arithmetic is inline.
  */
 #include <string.h>
 
+#include "wordops.h"
+
 void *memset(void *s, int c, size_t n)
 {
     char *p = s;
     char b = (char)c;          /* value stored is (unsigned char)c */
-    while (n > 0) {
-        *p = b;
-        p++;
-        n--;
+    int count = (int)n;
+    while (count > 0 && MID_WORD(p)) {
+        *p++ = b;
+        count--;
+    }
+    if (count >= 6) {
+        unsigned w = (unsigned char)b;
+        w |= w << 8;
+        w |= w << 16;
+        w |= w << 16;          /* six copies; the shift drops what passes bit 48 */
+        unsigned *wp = (unsigned *)p;
+        for (; count >= 6; count -= 6)
+            *wp++ = w;
+        p = (char *)wp;
+    }
+    while (count > 0) {
+        *p++ = b;
+        count--;
     }
     return s;
 }
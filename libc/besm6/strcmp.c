@@ -3,13 +3,33 @@
  *
  * Returns <0, 0, or >0 according to whether s1 is less than, equal to, or
  * greater than s2, comparing the first differing bytes as unsigned char.
+ * When s1 and s2 reach a word boundary together, equal words without a '\0'
+ * (see strlen for the test) are passed over whole.
  */
 #include <string.h>
 
+#include "wordops.h"
+
 int strcmp(const char *s1, const char *s2)
 {
     const unsigned char *a = (unsigned char *)s1;
     const unsigned char *b = (unsigned char *)s2;
+    while (MID_WORD(a)) {
+        if (*a == 0 || *a != *b)
+            return (int)*a - (int)*b;
+        a++;
+        b++;
+    }
+    if (AT_WORD(b)) {
+        const unsigned *wa = (const unsigned *)a;
+        const unsigned *wb = (const unsigned *)b;
+        while (*wa == *wb && ZERO_BYTES(*wa) == 0) {
+            wa++;
+            wb++;
+        }
+        a = (const unsigned char *)wa;
+        b = (const unsigned char *)wb;
+    }
     while (*a != 0 && *a == *b) {
         a++;
         b++;
@@ -2,14 +2,33 @@
  * strcpy — copy the NUL-terminated string src into dest (C11 §7.24.2.3).
  *
  * Copies up to and including the terminating '\0'.  The objects must not
- * overlap.  dest/src are fat char* cursors advancing across word boundaries.
+ * overlap.  dest/src are fat char* cursors advancing across word boundaries,
+ * byte by byte up to a word boundary of src; when dest is then on one too,
+ * each word of src that holds no '\0' is copied whole (see strlen for the
+ * test), and the word with the terminator byte by byte.
  */
 #include <string.h>
 
+#include "wordops.h"
+
 char *strcpy(char *dest, const char *src)
 {
     char *d = dest;
     const char *s = src;
+    while (MID_WORD(s)) {
+        if ((*d = *s) == 0)
+            return dest;
+        d++;
+        s++;
+    }
+    if (AT_WORD(d)) {
+        unsigned *wd = (unsigned *)d;
+        const unsigned *ws = (const unsigned *)s;
+        while (ZERO_BYTES(*ws) == 0)
+            *wd++ = *ws++;
+        d = (char *)wd;
+        s = (const char *)ws;
+    }
     while (*s != 0) {
         *d = *s;
         d++;
@@ -2,15 +2,30 @@
  * strlen — length of the NUL-terminated string s (C11 §7.24.6.3).
  *
  * Counts bytes up to, but not including, the terminating '\0'.  s is a fat
- * char* cursor, so the scan crosses word boundaries on its own (b/pinc).
+ * char* cursor, stepped byte by byte to the first word boundary; from there the
+ * scan reads whole words.  A byte is zero iff neither its high bit is set nor a
+ * carry reaches the high bit when its low seven bits are added to 0177; the add
+ * is arx, which cannot carry from one byte into the next here, so the flags
+ * are exact, and anx finds the first of them.
  */
+#include <besm6.h>
 #include <string.h>
 
+#include "wordops.h"
+
 size_t strlen(const char *s)
 {
     const char *p = s;
-    while (*p != 0) {
+    while (MID_WORD(p)) {
+        if (*p == 0)
+            return (size_t)(p - s);
         p++;
     }
-    return (size_t)(p - s);
+
+    const unsigned *w = (const unsigned *)p;
+    unsigned zero;
+    while ((zero = ZERO_BYTES(*w)) == 0)
+        w++;
+    /* The high bit of byte #k is bit 8k+1 counted from the MSB. */
+    return (size_t)((const char *)w - s) + (__besm6_anx(zero, 0) >> 3);
 }
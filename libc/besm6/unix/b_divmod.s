@@ -0,0 +1,48 @@
+// b6as port of libc/besm6/madlen/b_divmod.madlen (see the Madlen original for full
+// commentary). Runtime-helper names use $ (b6as).
+//
+// Signed quotient and remainder of the same operands:  q = a / b,  r = a % b  (C semantics).
+//
+// Helper convention: dividend a is on the stack at mem[r15-1], divisor b is in the
+// accumulator A.  The quotient is returned in A and the remainder in a's stack word, which
+// stays pushed (net r15 = entry): the caller stores q, then pops r with `15 xta`.
+//
+// One divide instead of the two of b$div and b$mod: q = b$div(a, b), then
+// r = a - q * b
+// by b$mul and one x-a.  |q * b| <= |a|, so the product and the difference are exact.
+//
+// CALL clobbers r13, so the entry return address is saved in the frame.  b$div and b$mul
+// touch only r13/r14/r15 (+A/Y), so the frame base r12 survives both calls.  Frame
+// (relative to r12): a = r12-1, b = r12+0, r13 = r12+1, q = r12+2.
+//
+// NB: like b$umod this routine has NO base directive and uses no literals: b$div and b$mul
+// reload r14 with their own base and never restore it.
+//
+    .text
+    .globl b$divmod
+b$divmod:
+ 15 atx             // push b: mem[E] := b, r15 := E+1
+    ita 13          // A := saved return address (r13)
+ 15 atx             // push r13: mem[E+1] := r13, r15 := E+2
+ 15 mtj 12          // r12 := r15 = E+2
+ 12 utm -2          // r12 := E  (a = r12-1, b = r12, r13 = r12+1)
+ 15 utm 1           // reserve the q slot r12+2: r15 := E+3
+
+// q = b$div(a, b)
+ 12 xta -1          // A := a
+ 12 xts             // push a, A := b   (load via r12+0)
+ 13 vjm b$div       // A := q = a / b ; helper pops one word -> r15 = E+3
+ 12 atx 2           // q slot := q
+
+// r = a - b$mul(q, b)
+ 12 xts             // push q (still in A), A := b
+ 13 vjm b$mul       // A := p = q * b ; r15 = E+3
+ 12 x-a -1          // A := a - p = r
+ 12 atx -1          // a's word := r  (left on the stack for the caller)
+
+// restore r13, return q
+ 12 xta 1           // A := saved r13
+    ati 13          // r13 := A
+ 12 xta 2           // A := q  (result; XTA leaves logical w-mode)
+ 15 utm -3          // drop b, r13, q: r15 := entry  (E+3 -> E), r stays at E-1
+ 13 uj              // return to caller
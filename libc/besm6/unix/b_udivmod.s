@@ -0,0 +1,53 @@
+// b6as port of libc/besm6/madlen/b_udivmod.madlen (see the Madlen original for full
+// commentary). Runtime-helper names use $ (b6as).
+//
+// Unsigned quotient and remainder of the same operands:  q = a / b,  r = a % b
+// (full 48-bit range).
+//
+// Helper convention: dividend a is on the stack at mem[r15-1], divisor b is in the
+// accumulator A.  The quotient is returned in A and the remainder in a's stack word, which
+// stays pushed (net r15 = entry): the caller stores q, then pops r with `15 xta`.
+//
+// b$umod with the quotient kept: q = b$udiv(a, b), then r = a - q * b by b$umul and
+// b$usub -- one long division instead of the two of b$udiv and b$umod.
+//
+// CALL clobbers r13, so the entry return address is saved in the frame.  b$umul and b$usub
+// touch only r13/r14/r15 (+A/Y); b$udiv additionally uses r10/r11 -- but none touch r12, so
+// the frame base r12 survives all three nested calls.  Frame (relative to r12): a = r12-1,
+// b = r12+0 (then q * b), r13 = r12+1, q = r12+2.
+//
+// NB: like b$umod this routine has NO base directive and uses no literals.
+//
+    .text
+    .globl b$udivmod
+b$udivmod:
+ 15 atx             // push b: mem[E] := b, r15 := E+1
+    ita 13          // A := saved return address (r13)
+ 15 atx             // push r13: mem[E+1] := r13, r15 := E+2
+ 15 mtj 12          // r12 := r15 = E+2
+ 12 utm -2          // r12 := E  (a = r12-1, b = r12, r13 = r12+1)
+ 15 utm 1           // reserve the q slot r12+2: r15 := E+3
+
+// q = b$udiv(a, b)
+ 12 xta -1          // A := a
+ 12 xts             // push a, A := b   (load via r12+0)
+ 13 vjm b$udiv      // A := q = a / b ; helper pops one word -> r15 = E+3
+ 12 atx 2           // q slot := q
+
+// p = b$umul(q, b)
+ 12 xts             // push q (still in A), A := b
+ 13 vjm b$umul      // A := p = q * b ; r15 = E+3
+ 12 atx             // b's word := p  (b no longer needed)
+
+// r = b$usub(a, p) = a - p
+ 12 xta -1          // A := a
+ 12 xts             // push a, A := p   (load via r12+0)
+ 13 vjm b$usub      // A := r = a - p ; r15 = E+3
+ 12 atx -1          // a's word := r  (left on the stack for the caller)
+
+// restore r13, return q
+ 12 xta 1           // A := saved r13
+    ati 13          // r13 := A
+ 12 xta 2           // A := q  (result; XTA leaves logical w-mode)
+ 15 utm -3          // drop p, r13, q: r15 := entry  (E+3 -> E), r stays at E-1
+ 13 uj              // return to caller
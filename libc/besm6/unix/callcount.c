@@ -0,0 +1,56 @@
+/*
+ * Call counts of the functions compiled with genbesm --instrument-calls (Unix target).
+ *
+ * Each instrumented function has a record in its module: the count, a link, and the
+ * function's name packed six bytes to the word.  The prologue bumps the count and, on
+ * the first call, links the record in front of _callcounts.  The startup code calls
+ * _callcount_dump after main returns (and flush), which writes one line per function
+ * that ran to stderr, most recently registered first:
+ *
+ *     calls <count> <name>
+ *
+ * profdump collects these lines from the rest of the program's stderr.  Nothing is
+ * written when no instrumented function ran.  Like flush, the dump is skipped when the
+ * program ends through exit().
+ */
+extern int write(int fd, char *buf, int n);
+
+struct callcount {
+    int count;
+    struct callcount *next;
+    int name; /* the first word of the name */
+};
+
+struct callcount *_callcounts;
+
+static void _callcount_number(int n)
+{
+    char digits[16];
+    int i;
+
+    i = 16;
+    do {
+        digits[--i] = '0' + n % 10;
+        n           = n / 10;
+    } while (n > 0);
+    write(2, &digits[i], 16 - i);
+}
+
+void _callcount_dump(void)
+{
+    struct callcount *c;
+    char *name;
+    int len;
+
+    for (c = _callcounts; c; c = c->next) {
+        name = (char *)&c->name;
+        len  = 0;
+        while (name[len])
+            len++;
+        write(2, "calls ", 6);
+        _callcount_number(c->count);
+        write(2, " ", 1);
+        write(2, name, len);
+        write(2, "\n", 1);
+    }
+}
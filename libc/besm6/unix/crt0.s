@@ -7,7 +7,9 @@
 // Startup calls main(argc, argv) with argc=0 and a dummy argv[] (one NULL
 // entry), following the C convention: arg1 (argc) pushed, last arg (argv) in
 // the accumulator, r14 = -argc_count.  main's int result is left in the
-// accumulator and passed straight to _exit (SYS_exit, $77 1).
+// accumulator and passed straight to _exit (SYS_exit, $77 1), after flush()
+// and _callcount_dump() (callcount.c), which writes nothing unless code compiled
+// with genbesm --instrument-calls ran.
 //
 // `xts <argvp>` expands to `utc argvp` + `xts`, reaching argvp with a 15-bit address.  A
 // bare `xts argvp` would encode it in the 12-bit short-address field, which b6as/b6ld
@@ -25,6 +27,7 @@ _start:
  13 vjm main        // call main(argc, argv); int result left in ACC
  15 atx             // push status
  13 vjm flush       // call flush();
+ 13 vjm _callcount_dump // call _callcount_dump();
  15 xta             // pop status
     $77 1           // _exit(status): SYS_exit, status already in ACC
 
@@ -0,0 +1,27 @@
+/*
+ * wordops.h — word-at-a-time helpers shared by the string and memory routines.
+ *
+ * Private to the libc sources: it is not installed with the headers in include/.
+ * A char* on the BESM-6 is a fat pointer to one of the six bytes of a word; the
+ * routines step one byte at a time up to a word boundary and then go six bytes
+ * a step through an unsigned *.
+ */
+#ifndef WORDOPS_H
+#define WORDOPS_H
+
+#include <besm6.h>
+
+/* Is p at byte #0 of its word, or past it?  The round trip through a word pointer says. */
+#define AT_WORD(p)  ((const char *)(const unsigned *)(p) == (const char *)(p))
+#define MID_WORD(p) ((const char *)(const unsigned *)(p) != (const char *)(p))
+
+#define LOW7 0x7f7f7f7f7f7fU /* the low seven bits of each byte */
+
+/*
+ * The high bit of each zero byte of the word w: a byte is zero iff neither its
+ * high bit is set nor a carry reaches it when its low seven bits are added to
+ * 0177.  arx cannot carry from one byte into the next here, so the flags are exact.
+ */
+#define ZERO_BYTES(w) (~(__besm6_arx((w) & LOW7, LOW7) | (w) | LOW7))
+
+#endif /* WORDOPS_H */
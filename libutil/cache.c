@@ -0,0 +1,251 @@
+//
+// Content-addressed cache of compiler stage outputs.  See cache.h.
+//
+#include "cache.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "xalloc.h"
+
+#define FNV_OFFSET 14695981039346656037ull
+#define FNV_PRIME  1099511628211ull
+
+CacheStats cache_stats;
+
+static bool exe_digested;
+static uint64_t exe_digest;
+static bool write_failed; // warned once; stop trying to store
+
+static uint64_t fnv(uint64_t h, const unsigned char *p, size_t len)
+{
+    while (len-- > 0) {
+        h ^= *p++;
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+//
+// Digest a stream to its end.
+//
+static uint64_t fnv_stream(uint64_t h, FILE *f)
+{
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        h = fnv(h, buf, n);
+    return h;
+}
+
+//
+// The running executable stands in for the compiler version: any rebuild that could
+// change an output changes the key of every entry.  Where /proc is not mounted, the
+// build time of this file is the best there is.
+//
+static uint64_t executable_digest(void)
+{
+    if (!exe_digested) {
+        FILE *f = fopen("/proc/self/exe", "rb");
+        if (f) {
+            exe_digest = fnv_stream(FNV_OFFSET, f);
+            fclose(f);
+        } else {
+            static const char built[] = __DATE__ " " __TIME__;
+            exe_digest = fnv(FNV_OFFSET, (const unsigned char *)built, sizeof(built));
+        }
+        exe_digested = true;
+    }
+    return exe_digest;
+}
+
+void cache_key_init(CacheKey *key, const char *stage)
+{
+    key->hash = FNV_OFFSET;
+    cache_key_add_word(key, executable_digest());
+    cache_key_add_str(key, stage);
+}
+
+void cache_key_add(CacheKey *key, const void *data, size_t len)
+{
+    key->hash = fnv(key->hash, data, len);
+}
+
+// The terminating NUL goes in too, so that "ab" + "c" and "a" + "bc" differ.
+void cache_key_add_str(CacheKey *key, const char *str)
+{
+    if (!str)
+        str = "";
+    cache_key_add(key, str, strlen(str) + 1);
+}
+
+void cache_key_add_word(CacheKey *key, uint64_t word)
+{
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++)
+        bytes[i] = (unsigned char)(word >> (8 * i));
+    cache_key_add(key, bytes, sizeof(bytes));
+}
+
+bool cache_key_add_file(CacheKey *key, const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) < 0 || !S_ISREG(st.st_mode))
+        return false;
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    key->hash = fnv_stream(key->hash, f);
+    fclose(f);
+    return true;
+}
+
+//
+// DIR/ab/cdef0123456789, or DIR/ab alone for the directory of the entry.
+//
+static char *entry_path(const char *dir, const CacheKey *key, bool subdir_only)
+{
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)key->hash);
+
+    size_t len = strlen(dir) + sizeof(hex) + 2;
+    char *path = xalloc(len, __func__, __FILE__, __LINE__);
+    if (subdir_only)
+        snprintf(path, len, "%s/%.2s", dir, hex);
+    else
+        snprintf(path, len, "%s/%.2s/%s", dir, hex, hex + 2);
+    return path;
+}
+
+char *cache_lookup(const char *dir, const CacheKey *key)
+{
+    char *path = entry_path(dir, key, false);
+    if (access(path, R_OK) == 0) {
+        cache_stats.hits++;
+        return path;
+    }
+    cache_stats.misses++;
+    xfree(path);
+    return NULL;
+}
+
+static void warn_write_failed(const char *path)
+{
+    if (!write_failed)
+        fprintf(stderr, "Warning: cannot write cache entry %s: %s\n", path, strerror(errno));
+    write_failed = true;
+}
+
+bool cache_begin(CacheEntry *entry, const char *dir)
+{
+    entry->tmp_path = NULL;
+    entry->file     = NULL;
+    if (write_failed)
+        return false;
+    if (mkdir(dir, 0777) < 0 && errno != EEXIST) {
+        warn_write_failed(dir);
+        return false;
+    }
+
+    static const char pattern[] = "/tmp.XXXXXX";
+    entry->tmp_path             = xalloc(strlen(dir) + sizeof(pattern), __func__, __FILE__, __LINE__);
+    strcpy(entry->tmp_path, dir);
+    strcat(entry->tmp_path, pattern);
+    int fd = mkstemp(entry->tmp_path);
+    if (fd >= 0)
+        entry->file = fdopen(fd, "w+b");
+    if (!entry->file) {
+        warn_write_failed(entry->tmp_path);
+        if (fd >= 0) {
+            close(fd);
+            unlink(entry->tmp_path);
+        }
+        xfree(entry->tmp_path);
+        entry->tmp_path = NULL;
+        return false;
+    }
+    return true;
+}
+
+void cache_commit(CacheEntry *entry, const char *dir, const CacheKey *key)
+{
+    bool ok      = fclose(entry->file) == 0;
+    entry->file  = NULL;
+    char *subdir = entry_path(dir, key, true);
+    char *path   = entry_path(dir, key, false);
+    if (ok && (mkdir(subdir, 0777) == 0 || errno == EEXIST) &&
+        rename(entry->tmp_path, path) == 0) {
+        cache_stats.stores++;
+    } else {
+        warn_write_failed(path);
+        unlink(entry->tmp_path);
+    }
+    xfree(subdir);
+    xfree(path);
+    xfree(entry->tmp_path);
+    entry->tmp_path = NULL;
+}
+
+void cache_abort(CacheEntry *entry)
+{
+    if (entry->file)
+        fclose(entry->file);
+    if (entry->tmp_path) {
+        unlink(entry->tmp_path);
+        xfree(entry->tmp_path);
+    }
+    entry->file     = NULL;
+    entry->tmp_path = NULL;
+}
+
+bool cache_copy_stream(FILE *from, FILE *to)
+{
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), from)) > 0)
+        if (fwrite(buf, 1, n, to) != n)
+            return false;
+    return !ferror(from);
+}
+
+bool cache_fetch_file(const char *dir, const CacheKey *key, const char *dest)
+{
+    char *path = cache_lookup(dir, key);
+    if (!path)
+        return false;
+    FILE *from = fopen(path, "rb");
+    xfree(path);
+    if (!from)
+        return false;
+    FILE *to = fopen(dest, "wb");
+    if (!to) {
+        perror(dest);
+        exit(1);
+    }
+    bool ok = cache_copy_stream(from, to);
+    fclose(from);
+    if (fclose(to) != 0 || !ok) {
+        fprintf(stderr, "Error: cannot write %s\n", dest);
+        exit(1);
+    }
+    return true;
+}
+
+void cache_store_file(const char *dir, const CacheKey *key, const char *src)
+{
+    CacheEntry entry;
+    if (!cache_begin(&entry, dir))
+        return;
+    FILE *from = fopen(src, "rb");
+    if (!from || !cache_copy_stream(from, entry.file)) {
+        if (from)
+            fclose(from);
+        cache_abort(&entry);
+        return;
+    }
+    fclose(from);
+    cache_commit(&entry, dir, key);
+}
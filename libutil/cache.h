@@ -0,0 +1,89 @@
+//
+// Content-addressed cache of compiler stage outputs (the --cache option of lower and
+// genbesm).
+//
+// An entry is a file in a cache directory that any number of runs may share, named by a
+// 64-bit key: the entry for key 0xabcdef0123456789 is DIR/ab/cdef0123456789.  The key is
+// an FNV-1a digest, like the hashes of the TAC index, of everything the output depends
+// on: the compiler executable itself, which stands in for its version, the stage, the
+// options that change the output, and the input.  Nothing is ever invalidated; an entry
+// whose key no longer comes up is never read again, and the directory may be emptied at
+// any time.
+//
+// A new entry is written to a temporary file in DIR and renamed into place, so runs
+// sharing a directory never read a partial entry.  Failing to write one is not an
+// error: the run warns once and goes on without storing.
+//
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint64_t hash;
+} CacheKey;
+
+//
+// Lookups and stores since the start of the run, for -v.
+//
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long stores;
+} CacheStats;
+
+extern CacheStats cache_stats;
+
+//
+// Build a key: the executable and `stage` first, then whatever the caller adds.
+//
+void cache_key_init(CacheKey *key, const char *stage);
+void cache_key_add(CacheKey *key, const void *data, size_t len);
+void cache_key_add_str(CacheKey *key, const char *str);
+void cache_key_add_word(CacheKey *key, uint64_t word);
+
+//
+// Add the contents of a regular file.  Return false when it cannot be read, or is not
+// a regular file (a pipe can be read only once).
+//
+bool cache_key_add_file(CacheKey *key, const char *path);
+
+//
+// Path of the entry for `key`, or NULL when there is none.  Free it with xfree().
+//
+char *cache_lookup(const char *dir, const CacheKey *key);
+
+//
+// An entry being written: a temporary file, published by cache_commit().
+//
+typedef struct {
+    char *tmp_path;
+    FILE *file;
+} CacheEntry;
+
+bool cache_begin(CacheEntry *entry, const char *dir);
+void cache_commit(CacheEntry *entry, const char *dir, const CacheKey *key);
+void cache_abort(CacheEntry *entry);
+
+//
+// Copy the rest of `from` to `to`.
+//
+bool cache_copy_stream(FILE *from, FILE *to);
+
+//
+// Whole outputs: copy the entry for `key` to the file `dest`, or store the file `src`
+// under `key`.  An entry is copied rather than hard-linked, so that a later run writing
+// the same output in place cannot change the entry.
+//
+bool cache_fetch_file(const char *dir, const CacheKey *key, const char *dest);
+void cache_store_file(const char *dir, const CacheKey *key, const char *src);
+
+#ifdef __cplusplus
+}
+#endif
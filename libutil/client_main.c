@@ -0,0 +1,34 @@
+//
+// compile-client: run a tool invocation on a compile server (see server.h).
+//
+//      compile-client SOCKET lower [options] input.ast output.tac
+//
+// sends the command to the server listening on SOCKET, which runs it in the working
+// directory and with the standard streams of the client, and exits with its status.
+// When no server listens on SOCKET, the command is run directly instead, so a build
+// works the same with or without the server.
+//
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "server.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+        fprintf(stderr, "Usage:\n");
+        fprintf(stderr, "    compile-client socket command [arguments...]\n");
+        return argc < 3 ? 1 : 0;
+    }
+
+    static const int fds[3] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+    int status              = server_request(argv[1], &argv[2], fds);
+    if (status >= 0)
+        return status;
+
+    // No server: run the tool here.
+    execvp(argv[2], &argv[2]);
+    perror(argv[2]);
+    return 127;
+}
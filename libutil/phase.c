@@ -0,0 +1,218 @@
+//
+// Per-phase timing and memory report.
+//
+// The table is small and phases are few, so a name is found by a linear scan; the
+// pointer is compared before the string, which settles the common case of a call site
+// passing the same literal every time.
+//
+#include "phase.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "xalloc.h"
+
+#define MAX_PHASES 64
+#define MAX_DEPTH  32
+
+//
+// One active phase: what it had consumed at entry, and what its nested phases have
+// consumed since, so that phase_end() can charge the difference.
+//
+typedef struct {
+    int index;
+    uint64_t start_nsec;
+    uint64_t start_allocs;
+    uint64_t start_bytes;
+    uint64_t child_nsec;
+    uint64_t child_allocs;
+    uint64_t child_bytes;
+    size_t saved_peak; // the enclosing region's peak, restored at exit
+} PhaseFrame;
+
+bool phase_enabled;
+
+static PhaseStats phases[MAX_PHASES];
+static int nphases;
+static PhaseFrame stack[MAX_DEPTH];
+static int depth;
+static uint64_t enable_nsec; // when phase_enable() was called
+static size_t enable_allocs; // xalloc counters at that time
+static size_t enable_bytes;
+
+static uint64_t now_nsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void phase_enable(void)
+{
+    phase_reset();
+    phase_enabled = true;
+    enable_allocs = xallocation_count();
+    enable_bytes  = xcumulative_allocated_size();
+    xset_peak_allocated_size(0);
+    enable_nsec   = now_nsec();
+}
+
+static int phase_index(const char *name)
+{
+    for (int i = 0; i < nphases; i++)
+        if (phases[i].name == name || strcmp(phases[i].name, name) == 0)
+            return i;
+    if (nphases == MAX_PHASES) {
+        fprintf(stderr, "Too many phases for --time-report: %s\n", name);
+        exit(1);
+    }
+    phases[nphases].name = name;
+    return nphases++;
+}
+
+void phase_begin(const char *name)
+{
+    if (!phase_enabled)
+        return;
+    if (depth == MAX_DEPTH) {
+        fprintf(stderr, "Phases nested too deep for --time-report: %s\n", name);
+        exit(1);
+    }
+    PhaseFrame *f   = &stack[depth++];
+    f->index        = phase_index(name);
+    f->child_nsec   = 0;
+    f->child_allocs = 0;
+    f->child_bytes  = 0;
+    f->saved_peak   = xset_peak_allocated_size(0);
+    f->start_allocs = xallocation_count();
+    f->start_bytes  = xcumulative_allocated_size();
+    f->start_nsec   = now_nsec();
+}
+
+void phase_end(void)
+{
+    if (!phase_enabled || depth == 0)
+        return;
+    uint64_t end        = now_nsec();
+    const PhaseFrame *f = &stack[--depth];
+    PhaseStats *p       = &phases[f->index];
+    uint64_t nsec       = end - f->start_nsec;
+    uint64_t allocs     = xallocation_count() - f->start_allocs;
+    uint64_t bytes      = xcumulative_allocated_size() - f->start_bytes;
+
+    p->calls++;
+    p->nsec += nsec - f->child_nsec;
+    p->allocs += allocs - f->child_allocs;
+    p->bytes += bytes - f->child_bytes;
+
+    size_t peak = xpeak_allocated_size();
+    if (peak > p->peak_bytes)
+        p->peak_bytes = peak;
+    xset_peak_allocated_size(peak > f->saved_peak ? peak : f->saved_peak);
+
+    if (depth > 0) {
+        PhaseFrame *parent = &stack[depth - 1];
+        parent->child_nsec += nsec;
+        parent->child_allocs += allocs;
+        parent->child_bytes += bytes;
+    }
+}
+
+bool phase_parse_format(const char *arg, PhaseReportFormat *format)
+{
+    if (!arg || strcmp(arg, "text") == 0) {
+        *format = PHASE_REPORT_TEXT;
+        return true;
+    }
+    if (strcmp(arg, "json") == 0) {
+        *format = PHASE_REPORT_JSON;
+        return true;
+    }
+    return false;
+}
+
+const PhaseStats *phase_stats(const char *name)
+{
+    for (int i = 0; i < nphases; i++)
+        if (strcmp(phases[i].name, name) == 0)
+            return &phases[i];
+    return NULL;
+}
+
+void phase_reset(void)
+{
+    memset(phases, 0, sizeof(phases));
+    nphases       = 0;
+    depth         = 0;
+    phase_enabled = false;
+}
+
+// Print a phase name as a JSON string; names are plain ASCII, but quote the two
+// characters JSON requires.
+static void print_json_string(FILE *out, const char *s)
+{
+    putc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\')
+            putc('\\', out);
+        putc(*s, out);
+    }
+    putc('"', out);
+}
+
+void phase_report(FILE *out, const char *tool, PhaseReportFormat format)
+{
+    // Close phases left open by an early exit, so their time is not lost.
+    while (depth > 0)
+        phase_end();
+
+    uint64_t total = now_nsec() - enable_nsec;
+
+    // What ran outside every phase: the driver itself, option parsing, cleanup.
+    uint64_t other_nsec   = total;
+    uint64_t all_allocs   = xallocation_count() - enable_allocs;
+    uint64_t all_bytes    = xcumulative_allocated_size() - enable_bytes;
+    uint64_t other_allocs = all_allocs;
+    for (int i = 0; i < nphases; i++) {
+        other_nsec   = (other_nsec > phases[i].nsec) ? other_nsec - phases[i].nsec : 0;
+        other_allocs = other_allocs - phases[i].allocs;
+    }
+    size_t peak = xpeak_allocated_size();
+
+    if (format == PHASE_REPORT_JSON) {
+        fprintf(out, "{\"tool\": ");
+        print_json_string(out, tool);
+        fprintf(out, ", \"total_ns\": %llu, \"allocs\": %llu, \"peak_bytes\": %zu, \"phases\": [",
+                (unsigned long long)total, (unsigned long long)all_allocs, peak);
+        for (int i = 0; i < nphases; i++) {
+            const PhaseStats *p = &phases[i];
+            fprintf(out, "%s\n  {\"name\": ", i ? "," : "");
+            print_json_string(out, p->name);
+            fprintf(out,
+                    ", \"calls\": %llu, \"ns\": %llu, \"allocs\": %llu, \"bytes\": %llu, "
+                    "\"peak_bytes\": %llu}",
+                    (unsigned long long)p->calls, (unsigned long long)p->nsec,
+                    (unsigned long long)p->allocs, (unsigned long long)p->bytes,
+                    (unsigned long long)p->peak_bytes);
+        }
+        fprintf(out, "%s], \"other_ns\": %llu}\n", nphases ? "\n" : "",
+                (unsigned long long)other_nsec);
+        return;
+    }
+
+    fprintf(out, "%s: time report\n", tool);
+    fprintf(out, "%-24s %8s %10s %6s %10s %10s %10s\n", "phase", "calls", "msec", "%", "allocs",
+            "kbytes", "peak kb");
+    for (int i = 0; i < nphases; i++) {
+        const PhaseStats *p = &phases[i];
+        fprintf(out, "%-24s %8llu %10.3f %5.1f%% %10llu %10.1f %10.1f\n", p->name,
+                (unsigned long long)p->calls, p->nsec / 1e6,
+                total ? 100.0 * p->nsec / total : 0.0, (unsigned long long)p->allocs,
+                p->bytes / 1024.0, p->peak_bytes / 1024.0);
+    }
+    fprintf(out, "%-24s %8s %10.3f %5.1f%% %10llu\n", "other", "", other_nsec / 1e6,
+            total ? 100.0 * other_nsec / total : 0.0, (unsigned long long)other_allocs);
+    fprintf(out, "%-24s %8s %10.3f %6s %10llu %10.1f %10.1f\n", "total", "", total / 1e6, "",
+            (unsigned long long)all_allocs, all_bytes / 1024.0, peak / 1024.0);
+}
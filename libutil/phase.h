@@ -0,0 +1,75 @@
+//
+// Per-phase timing and memory report (the --time-report option of every tool).
+//
+// A phase is a named region of work bracketed by phase_begin() and phase_end().  Phases
+// nest: time and allocations spent in an inner phase are charged to the inner phase
+// only, so each row of the report is the phase's own cost and the rows add up.  A phase
+// may be entered many times (once per declaration, once per optimizer iteration); the
+// report sums the entries.  Names are compared as strings and are expected to be string
+// literals, which the table keeps by pointer.
+//
+// Instrumentation is off until phase_enable(); until then phase_begin() and phase_end()
+// return after one test, so the call sites stay in release builds.
+//
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PHASE_REPORT_TEXT, // aligned table for people
+    PHASE_REPORT_JSON, // one JSON object for scripts
+} PhaseReportFormat;
+
+//
+// Per-phase totals, as reported.
+//
+typedef struct {
+    const char *name;
+    uint64_t calls;
+    uint64_t nsec;       // own time, nested phases excluded
+    uint64_t allocs;     // own xalloc() calls
+    uint64_t bytes;      // own bytes requested from xalloc()
+    uint64_t peak_bytes; // highest live xalloc total seen while the phase was active
+} PhaseStats;
+
+extern bool phase_enabled;
+
+//
+// Start collecting; the wall-clock total of the report runs from here.
+//
+void phase_enable(void);
+
+void phase_begin(const char *name);
+void phase_end(void);
+
+//
+// Parse the argument of --time-report: NULL or "text" gives a table, "json" a JSON
+// object.  Return false for anything else.
+//
+bool phase_parse_format(const char *arg, PhaseReportFormat *format);
+
+//
+// Print every phase in the order first entered, an "other" row for the time outside
+// any phase, and the totals.  `tool` names the program in the report.
+//
+void phase_report(FILE *out, const char *tool, PhaseReportFormat format);
+
+//
+// Look up one phase; NULL when it was never entered.
+//
+const PhaseStats *phase_stats(const char *name);
+
+//
+// Forget every phase and disable collection.
+//
+void phase_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
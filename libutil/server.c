@@ -0,0 +1,319 @@
+//
+// Compile server and client over a Unix socket.  See server.h.
+//
+#include "server.h"
+
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cache.h"
+#include "xalloc.h"
+
+static volatile sig_atomic_t stopping;
+
+static void stop(int sig)
+{
+    (void)sig;
+    stopping = 1;
+}
+
+//
+// Fill in the address of the socket at `path`; false when the path does not fit.
+//
+static bool socket_address(struct sockaddr_un *addr, const char *path)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path))
+        return false;
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+static int connect_to(const char *path)
+{
+    struct sockaddr_un addr;
+    if (!socket_address(&addr, path))
+        return -1;
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0)
+        return -1;
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static bool write_all(int fd, const void *data, size_t len)
+{
+    const char *p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void *data, size_t len)
+{
+    char *p = data;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+//
+// Run one request in a process of its own, with the client's descriptors as its standard
+// streams, and return its exit status as a shell would report it.
+//
+static int run_request(ServerMain tool_main, const int fds[3], const char *cwd, int argc,
+                       char *argv[])
+{
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        for (int i = 0; i < 3; i++)
+            if (dup2(fds[i], i) < 0)
+                _exit(1);
+        signal(SIGPIPE, SIG_DFL);
+        if (chdir(cwd) < 0) {
+            perror(cwd);
+            exit(1);
+        }
+        // The server parsed its own options; start getopt afresh for the request.
+#ifdef __GLIBC__
+        optind = 0;
+#else
+        optind = 1;
+#endif
+        exit(tool_main(argc, argv));
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0)
+        if (errno != EINTR)
+            return 1;
+    if (WIFSIGNALED(status))
+        return 128 + WTERMSIG(status);
+    return WEXITSTATUS(status);
+}
+
+//
+// Receive a request on `conn`, run it and send back its status.  Runs in a process forked
+// for the connection, so that the server goes back to accepting at once.
+//
+static void serve(int conn, ServerMain tool_main)
+{
+    uint32_t header[2]; // argc, payload length
+    struct iovec iov = { header, sizeof(header) };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(3 * sizeof(int))];
+    } control;
+    struct msghdr msg   = { 0 };
+    msg.msg_iov         = &iov;
+    msg.msg_iovlen      = 1;
+    msg.msg_control     = control.buf;
+    msg.msg_controllen  = sizeof(control.buf);
+    ssize_t n           = recvmsg(conn, &msg, 0);
+    if (n == 0)
+        return; // closed unsent: a check whether the server is up
+    struct cmsghdr *fdm = n == sizeof(header) ? CMSG_FIRSTHDR(&msg) : NULL;
+    if (!fdm || fdm->cmsg_level != SOL_SOCKET || fdm->cmsg_type != SCM_RIGHTS ||
+        fdm->cmsg_len != CMSG_LEN(3 * sizeof(int)) || header[0] == 0 || header[1] == 0) {
+        fprintf(stderr, "Warning: malformed compile server request\n");
+        return;
+    }
+    int fds[3];
+    memcpy(fds, CMSG_DATA(fdm), sizeof(fds));
+
+    // The payload: the working directory, then argc arguments.
+    uint32_t argc   = header[0];
+    char *payload   = xalloc(header[1], __func__, __FILE__, __LINE__);
+    char **argv     = xalloc((argc + 1) * sizeof(char *), __func__, __FILE__, __LINE__);
+    char *end       = payload + header[1];
+    const char *cwd = payload;
+    char *p         = payload;
+    bool ok         = read_all(conn, payload, header[1]) && end[-1] == '\0';
+    for (uint32_t i = 0; ok && i < argc; i++) {
+        p += strlen(p) + 1;
+        ok      = p < end;
+        argv[i] = p;
+    }
+    argv[argc] = NULL;
+
+    int32_t status = 1;
+    if (ok)
+        status = run_request(tool_main, fds, cwd, (int)argc, argv);
+    else
+        fprintf(stderr, "Warning: malformed compile server request\n");
+    for (int i = 0; i < 3; i++)
+        close(fds[i]);
+    write_all(conn, &status, sizeof(status));
+    xfree(argv);
+    xfree(payload);
+}
+
+//
+// Bind and listen on `path`, replacing a stale socket.  Return the socket, or -1.
+//
+static int listen_on(const char *path)
+{
+    struct sockaddr_un addr;
+    if (!socket_address(&addr, path)) {
+        fprintf(stderr, "Error: socket path too long: %s\n", path);
+        return -1;
+    }
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+        perror("socket");
+        return -1;
+    }
+    int rc = bind(sock, (struct sockaddr *)&addr, sizeof(addr));
+    if (rc < 0 && errno == EADDRINUSE) {
+        // Left by a server that is gone, unless one still answers.
+        int live = connect_to(path);
+        if (live >= 0) {
+            fprintf(stderr, "Error: a compile server is already listening on %s\n", path);
+            close(live);
+            close(sock);
+            return -1;
+        }
+        unlink(path);
+        rc = bind(sock, (struct sockaddr *)&addr, sizeof(addr));
+    }
+    if (rc < 0 || listen(sock, SOMAXCONN) < 0) {
+        perror(path);
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+int server_run(const char *path, ServerMain tool_main)
+{
+    int sock = listen_on(path);
+    if (sock < 0)
+        return 1;
+
+    // Stop on a signal by breaking out of accept(); requests already running finish.
+    struct sigaction sa = { 0 };
+    sa.sa_handler       = stop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGCHLD, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+
+    // Digest the executable once here, rather than in every request that uses --cache.
+    CacheKey warm;
+    cache_key_init(&warm, "");
+
+    while (!stopping) {
+        int conn = accept(sock, NULL, NULL);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            perror("accept");
+            break;
+        }
+        fflush(NULL);
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(sock);
+            signal(SIGINT, SIG_DFL);
+            signal(SIGTERM, SIG_DFL);
+            signal(SIGCHLD, SIG_DFL);
+            serve(conn, tool_main);
+            _exit(0);
+        }
+        if (pid < 0)
+            perror("fork");
+        close(conn);
+    }
+    close(sock);
+    unlink(path);
+    return 0;
+}
+
+int server_request(const char *path, char *const argv[], const int fds[3])
+{
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd)))
+        return -1;
+    int sock = connect_to(path);
+    if (sock < 0)
+        return -1;
+
+    uint32_t argc = 0;
+    size_t len    = strlen(cwd) + 1;
+    for (; argv[argc]; argc++)
+        len += strlen(argv[argc]) + 1;
+    char *payload = xalloc(len, __func__, __FILE__, __LINE__);
+    char *p       = payload;
+    strcpy(p, cwd);
+    p += strlen(cwd) + 1;
+    for (uint32_t i = 0; i < argc; i++) {
+        strcpy(p, argv[i]);
+        p += strlen(argv[i]) + 1;
+    }
+
+    uint32_t header[2] = { argc, (uint32_t)len };
+    struct iovec iov   = { header, sizeof(header) };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(3 * sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg   = { 0 };
+    msg.msg_iov         = &iov;
+    msg.msg_iovlen      = 1;
+    msg.msg_control     = control.buf;
+    msg.msg_controllen  = sizeof(control.buf);
+    struct cmsghdr *fdm = CMSG_FIRSTHDR(&msg);
+    fdm->cmsg_level     = SOL_SOCKET;
+    fdm->cmsg_type      = SCM_RIGHTS;
+    fdm->cmsg_len       = CMSG_LEN(3 * sizeof(int));
+    memcpy(CMSG_DATA(fdm), fds, 3 * sizeof(int));
+
+    // Once the request is sent the tool may have run, so a failure from here on is the
+    // request's and must not make the caller run the tool again.
+    int32_t status = 1;
+    if (sendmsg(sock, &msg, 0) != sizeof(header)) {
+        status = -1;
+    } else if (!write_all(sock, payload, len) || !read_all(sock, &status, sizeof(status))) {
+        fprintf(stderr, "Error: compile server on %s dropped the request\n", path);
+        status = 1;
+    }
+    xfree(payload);
+    close(sock);
+    return status;
+}
@@ -0,0 +1,47 @@
+//
+// Compile server (the --server option of parse, lower and genbesm) and its client.
+//
+// A build that runs a tool once per file pays for process startup every time, and with
+// --cache for digesting the tool executable as well.  A server started once per tool
+// listens on a local Unix socket and runs the tool for each request it accepts, with the
+// argument list, working directory and standard streams of the client that sent it, and
+// sends back its exit status; the client exits with that status, so a build sees no
+// difference from running the tool itself.
+//
+// Each request runs in a process forked from the server.  The tools keep their tables
+// (symtab, structtab, typetab, nametab), their xalloc() pool and their unit-wide counters
+// in globals, and exit(1) on the first error; a request in its own process starts from
+// the state the server was in before any request, and an error ends that request only.
+//
+// The connection carries, from the client, one message of two words, argc and the length
+// of the payload, with the three standard descriptors attached as SCM_RIGHTS; then the
+// payload: the working directory and the arguments, each NUL-terminated.  The server
+// answers with the exit status as one word.  Both ends are on the same host, so words go
+// in host order.
+//
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int (*ServerMain)(int argc, char *argv[]);
+
+//
+// Listen on the Unix socket at `path` and run `tool_main` for each request, until SIGINT
+// or SIGTERM; then remove the socket.  A stale socket left by a server that is gone is
+// replaced.  Return the exit status for the server: 0 when stopped, 1 when it could not
+// listen.
+//
+int server_run(const char *path, ServerMain tool_main);
+
+//
+// Run argv[] on the server at `path`, with fds[0], fds[1] and fds[2] as its standard
+// input, output and error, and wait for it to finish.  Return its exit status, or -1
+// when no server accepts the request, so the caller may run the tool itself.
+//
+int server_request(const char *path, char *const argv[], const int fds[3]);
+
+#ifdef __cplusplus
+}
+#endif
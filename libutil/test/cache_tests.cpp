@@ -0,0 +1,140 @@
+//
+// Tests for the content-addressed cache of stage outputs.
+//
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "cache.h"
+#include "xalloc.h"
+
+class CacheTest : public ::testing::Test {
+protected:
+    char dir[32];
+
+    void SetUp() override
+    {
+        snprintf(dir, sizeof(dir), "/tmp/cache_XXXXXX");
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        cache_stats = CacheStats{};
+    }
+
+    void TearDown() override
+    {
+        std::string cmd = std::string("rm -rf ") + dir;
+        EXPECT_EQ(system(cmd.c_str()), 0);
+        xfree_all();
+    }
+
+    static CacheKey Key(const char *stage, const char *input)
+    {
+        CacheKey key;
+        cache_key_init(&key, stage);
+        cache_key_add_str(&key, input);
+        return key;
+    }
+
+    // Write `text` to a new file in the cache directory's parent.
+    std::string WriteFile(const char *name, const std::string &text)
+    {
+        std::string path = std::string(dir) + "." + name;
+        FILE *f          = fopen(path.c_str(), "w");
+        fputs(text.c_str(), f);
+        fclose(f);
+        return path;
+    }
+
+    static std::string ReadFile(const std::string &path)
+    {
+        std::string text;
+        FILE *f = fopen(path.c_str(), "r");
+        if (!f)
+            return text;
+        int c;
+        while ((c = getc(f)) != EOF)
+            text += (char)c;
+        fclose(f);
+        return text;
+    }
+};
+
+TEST_F(CacheTest, KeyDependsOnEverythingAdded)
+{
+    EXPECT_EQ(Key("lower", "int x;").hash, Key("lower", "int x;").hash);
+    EXPECT_NE(Key("lower", "int x;").hash, Key("genbesm", "int x;").hash);
+    EXPECT_NE(Key("lower", "int x;").hash, Key("lower", "int y;").hash);
+
+    // String boundaries are part of the key.
+    CacheKey a, b;
+    cache_key_init(&a, "lower");
+    cache_key_add_str(&a, "ab");
+    cache_key_add_str(&a, "c");
+    cache_key_init(&b, "lower");
+    cache_key_add_str(&b, "a");
+    cache_key_add_str(&b, "bc");
+    EXPECT_NE(a.hash, b.hash);
+}
+
+TEST_F(CacheTest, MissThenStoreThenHit)
+{
+    CacheKey key = Key("lower", "int x;");
+    EXPECT_EQ(cache_lookup(dir, &key), nullptr);
+    EXPECT_EQ(cache_stats.misses, 1u);
+
+    CacheEntry entry;
+    ASSERT_TRUE(cache_begin(&entry, dir));
+    fputs("output", entry.file);
+    cache_commit(&entry, dir, &key);
+    EXPECT_EQ(cache_stats.stores, 1u);
+
+    char *path = cache_lookup(dir, &key);
+    ASSERT_NE(path, nullptr);
+    EXPECT_EQ(cache_stats.hits, 1u);
+    EXPECT_EQ(ReadFile(path), "output");
+    xfree(path);
+
+    CacheKey other = Key("lower", "int y;");
+    EXPECT_EQ(cache_lookup(dir, &other), nullptr);
+}
+
+TEST_F(CacheTest, AbortLeavesNoEntry)
+{
+    CacheKey key = Key("lower", "int x;");
+    CacheEntry entry;
+    ASSERT_TRUE(cache_begin(&entry, dir));
+    fputs("partial", entry.file);
+    std::string tmp = entry.tmp_path;
+    cache_abort(&entry);
+    EXPECT_NE(access(tmp.c_str(), F_OK), 0);
+    EXPECT_EQ(cache_lookup(dir, &key), nullptr);
+    EXPECT_EQ(cache_stats.stores, 0u);
+}
+
+TEST_F(CacheTest, StoreAndFetchFile)
+{
+    std::string src  = WriteFile("src", "line 1\nline 2\n");
+    std::string dest = std::string(dir) + ".dest";
+
+    CacheKey key;
+    cache_key_init(&key, "genbesm");
+    ASSERT_TRUE(cache_key_add_file(&key, src.c_str()));
+    EXPECT_FALSE(cache_fetch_file(dir, &key, dest.c_str()));
+
+    cache_store_file(dir, &key, src.c_str());
+    ASSERT_TRUE(cache_fetch_file(dir, &key, dest.c_str()));
+    EXPECT_EQ(ReadFile(dest), "line 1\nline 2\n");
+
+    unlink(src.c_str());
+    unlink(dest.c_str());
+}
+
+TEST_F(CacheTest, KeyRejectsUnreadableFile)
+{
+    CacheKey key;
+    cache_key_init(&key, "lower");
+    EXPECT_FALSE(cache_key_add_file(&key, "/nonexistent/input.ast"));
+    EXPECT_FALSE(cache_key_add_file(&key, dir));
+}
@@ -0,0 +1,127 @@
+//
+// Tests for the per-phase timing and memory report.
+//
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+
+#include "phase.h"
+#include "xalloc.h"
+
+class PhaseTest : public ::testing::Test {
+protected:
+    void SetUp() override { phase_enable(); }
+
+    void TearDown() override
+    {
+        phase_reset();
+        xfree_all();
+    }
+
+    // Run phase_report() into a string.
+    static std::string Report(PhaseReportFormat format)
+    {
+        FILE *out = tmpfile();
+        phase_report(out, "test", format);
+        long len = ftell(out);
+        rewind(out);
+        std::string text(static_cast<size_t>(len), '\0');
+        EXPECT_EQ(fread(&text[0], 1, text.size(), out), text.size());
+        fclose(out);
+        return text;
+    }
+};
+
+TEST_F(PhaseTest, DisabledPhasesAreNotRecorded)
+{
+    phase_reset();
+    phase_begin("quiet");
+    phase_end();
+    EXPECT_EQ(phase_stats("quiet"), nullptr);
+}
+
+TEST_F(PhaseTest, CountsCallsAndAllocations)
+{
+    for (int i = 0; i < 3; i++) {
+        phase_begin("work");
+        xfree(xalloc(40, __func__, __FILE__, __LINE__));
+        phase_end();
+    }
+    const PhaseStats *work = phase_stats("work");
+    ASSERT_NE(work, nullptr);
+    EXPECT_EQ(work->calls, 3u);
+    EXPECT_EQ(work->allocs, 3u);
+    EXPECT_EQ(work->bytes, 120u);
+    EXPECT_EQ(work->peak_bytes, 40u);
+}
+
+TEST_F(PhaseTest, NestedPhaseIsChargedSeparately)
+{
+    phase_begin("outer");
+    void *a = xalloc(100, __func__, __FILE__, __LINE__);
+    phase_begin("inner");
+    void *b = xalloc(10, __func__, __FILE__, __LINE__);
+    xfree(b);
+    phase_end();
+    xfree(a);
+    phase_end();
+
+    const PhaseStats *outer = phase_stats("outer");
+    const PhaseStats *inner = phase_stats("inner");
+    ASSERT_NE(outer, nullptr);
+    ASSERT_NE(inner, nullptr);
+    EXPECT_EQ(outer->allocs, 1u);
+    EXPECT_EQ(outer->bytes, 100u);
+    EXPECT_EQ(inner->allocs, 1u);
+    EXPECT_EQ(inner->bytes, 10u);
+
+    // Peaks are inclusive: the inner phase saw the outer block live, and the outer phase
+    // keeps the peak reached inside the inner one.
+    EXPECT_EQ(inner->peak_bytes, 110u);
+    EXPECT_EQ(outer->peak_bytes, 110u);
+}
+
+TEST_F(PhaseTest, ParseFormat)
+{
+    PhaseReportFormat format = PHASE_REPORT_JSON;
+    EXPECT_TRUE(phase_parse_format(nullptr, &format));
+    EXPECT_EQ(format, PHASE_REPORT_TEXT);
+    EXPECT_TRUE(phase_parse_format("json", &format));
+    EXPECT_EQ(format, PHASE_REPORT_JSON);
+    EXPECT_TRUE(phase_parse_format("text", &format));
+    EXPECT_EQ(format, PHASE_REPORT_TEXT);
+    EXPECT_FALSE(phase_parse_format("xml", &format));
+}
+
+TEST_F(PhaseTest, TextReport)
+{
+    phase_begin("parse");
+    phase_end();
+    std::string text = Report(PHASE_REPORT_TEXT);
+    EXPECT_EQ(text.rfind("test: time report\n", 0), 0u);
+    EXPECT_NE(text.find("\nparse "), std::string::npos);
+    EXPECT_NE(text.find("\nother "), std::string::npos);
+    EXPECT_NE(text.find("\ntotal "), std::string::npos);
+}
+
+TEST_F(PhaseTest, JsonReport)
+{
+    phase_begin("emit");
+    xfree(xalloc(8, __func__, __FILE__, __LINE__));
+    phase_end();
+    std::string json = Report(PHASE_REPORT_JSON);
+    EXPECT_EQ(json.rfind("{\"tool\": \"test\", \"total_ns\": ", 0), 0u);
+    EXPECT_NE(json.find("{\"name\": \"emit\", \"calls\": 1, \"ns\": "), std::string::npos);
+    EXPECT_NE(json.find("\"allocs\": 1, \"bytes\": 8, \"peak_bytes\": 8}"), std::string::npos);
+    EXPECT_EQ(json.substr(json.size() - 2), "}\n");
+}
+
+TEST_F(PhaseTest, ReportClosesOpenPhases)
+{
+    phase_begin("unfinished");
+    Report(PHASE_REPORT_TEXT);
+    const PhaseStats *p = phase_stats("unfinished");
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(p->calls, 1u);
+}
@@ -0,0 +1,188 @@
+//
+// Tests for the compile server and its client.
+//
+#include <getopt.h>
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "server.h"
+#include "xalloc.h"
+
+//
+// A tool for the server to run: prints its options, arguments and working directory to
+// stdout, and exits with the status given by -x, the way a tool fails.
+//
+static int echo_main(int argc, char *argv[])
+{
+    static struct option long_options[] = {
+        { "exit", required_argument, 0, 'x' }, //
+        {},                                    //
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "vx:", long_options, nullptr)) != -1) {
+        switch (opt) {
+        case 'v':
+            printf("-v ");
+            break;
+        case 'x':
+            fprintf(stderr, "failing\n");
+            exit(atoi(optarg));
+        default:
+            return 2;
+        }
+    }
+    for (int i = optind; i < argc; i++)
+        printf("%s ", argv[i]);
+    char cwd[4096];
+    printf("in %s\n", getcwd(cwd, sizeof(cwd)));
+    return 0;
+}
+
+class ServerTest : public ::testing::Test {
+protected:
+    char path[32];
+    pid_t server = -1;
+
+    void SetUp() override
+    {
+        snprintf(path, sizeof(path), "/tmp/server_XXXXXX");
+        int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        unlink(path);
+    }
+
+    void TearDown() override
+    {
+        if (server > 0)
+            Stop();
+        unlink(path);
+        xfree_all();
+    }
+
+    void Start()
+    {
+        server = fork();
+        ASSERT_GE(server, 0);
+        if (server == 0)
+            _exit(server_run(path, echo_main));
+
+        // Wait for the server to accept.
+        for (int i = 0; i < 500 && !Listening(); i++)
+            usleep(10000);
+        ASSERT_TRUE(Listening());
+    }
+
+    bool Listening()
+    {
+        struct sockaddr_un addr = {};
+        addr.sun_family         = AF_UNIX;
+        strcpy(addr.sun_path, path);
+        int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool up  = connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+        close(sock);
+        return up;
+    }
+
+    // Stop the server and return its exit status.
+    int Stop()
+    {
+        kill(server, SIGTERM);
+        int status;
+        EXPECT_EQ(waitpid(server, &status, 0), server);
+        server = -1;
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    // Run a request; return its status, and what it wrote to stdout and stderr.
+    int Request(std::vector<const char *> args, std::string *out, std::string *err)
+    {
+        FILE *files[3] = { tmpfile(), tmpfile(), tmpfile() };
+        int fds[3]     = { fileno(files[0]), fileno(files[1]), fileno(files[2]) };
+        args.push_back(nullptr);
+        int status = server_request(path, const_cast<char *const *>(args.data()), fds);
+        *out       = Contents(files[1]);
+        *err       = Contents(files[2]);
+        for (FILE *f : files)
+            fclose(f);
+        return status;
+    }
+
+    static std::string Contents(FILE *f)
+    {
+        std::string text;
+        rewind(f);
+        int c;
+        while ((c = getc(f)) != EOF)
+            text += (char)c;
+        return text;
+    }
+};
+
+TEST_F(ServerTest, NoServerIsReported)
+{
+    std::string out, err;
+    EXPECT_EQ(Request({ "echo", "a" }, &out, &err), -1);
+    EXPECT_EQ(out, "");
+}
+
+TEST_F(ServerTest, RunsRequestsWithClientStreamsAndDirectory)
+{
+    Start();
+    char cwd[4096];
+    ASSERT_NE(getcwd(cwd, sizeof(cwd)), nullptr);
+
+    std::string out, err;
+    EXPECT_EQ(Request({ "echo", "-v", "in.ast", "out.tac" }, &out, &err), 0);
+    EXPECT_EQ(out, std::string("-v in.ast out.tac in ") + cwd + "\n");
+    EXPECT_EQ(err, "");
+
+    // Options are parsed afresh for every request.
+    EXPECT_EQ(Request({ "echo", "b.ast" }, &out, &err), 0);
+    EXPECT_EQ(out, std::string("b.ast in ") + cwd + "\n");
+    EXPECT_EQ(Stop(), 0);
+    EXPECT_NE(access(path, F_OK), 0);
+}
+
+TEST_F(ServerTest, FailingRequestLeavesServerRunning)
+{
+    Start();
+    std::string out, err;
+    EXPECT_EQ(Request({ "echo", "--exit", "3" }, &out, &err), 3);
+    EXPECT_EQ(err, "failing\n");
+    EXPECT_EQ(Request({ "echo", "x" }, &out, &err), 0);
+    EXPECT_EQ(out.substr(0, 5), "x in ");
+}
+
+TEST_F(ServerTest, SecondServerOnSameSocketFails)
+{
+    Start();
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(server_run(path, echo_main), 1);
+    EXPECT_NE(testing::internal::GetCapturedStderr().find("already listening"),
+              std::string::npos);
+}
+
+TEST_F(ServerTest, StaleSocketIsReplaced)
+{
+    Start();
+    kill(server, SIGKILL);
+    waitpid(server, nullptr, 0);
+    server = -1;
+    ASSERT_EQ(access(path, F_OK), 0);
+
+    Start();
+    std::string out, err;
+    EXPECT_EQ(Request({ "echo", "y" }, &out, &err), 0);
+    EXPECT_EQ(out.substr(0, 5), "y in ");
+}
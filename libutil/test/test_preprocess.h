@@ -49,9 +49,10 @@ inline bool source_has_directive(const std::string &src)
 }
 
 // Expand SRC with the system C preprocessor against the BESM-6 include dir.
-// Directive-free input is returned unchanged.  On cpp/popen failure an empty
-// string is returned (callers GTEST_SKIP() in that case).
-inline std::string preprocess_source(const std::string &src)
+// A quoted #include is looked up in QUOTE_DIR first, when given, as for a file
+// read from there.  Directive-free input is returned unchanged.  On cpp/popen
+// failure an empty string is returned (callers GTEST_SKIP() in that case).
+inline std::string preprocess_source(const std::string &src, const char *quote_dir = nullptr)
 {
     if (!source_has_directive(src))
         return src;
@@ -69,6 +70,11 @@ inline std::string preprocess_source(const std::string &src)
         // markers are kept (no -P): our scanner consumes them and they preserve
         // original line numbers for diagnostics.
         std::string cmd = BESM6_CPP " -E -x c -nostdinc -I" BESM6_INCLUDE_DIR " ";
+        if (quote_dir) {
+            cmd += "-iquote ";
+            cmd += quote_dir;
+            cmd += " ";
+        }
         cmd += path;
         cmd += " 2>/dev/null";
 
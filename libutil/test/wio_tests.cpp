@@ -377,3 +377,143 @@ TEST_F(WIOTest, WGetStrLongString)
     EXPECT_EQ(wgetw(&rstream), 7u);
     wclose(&rstream);
 }
+
+//
+// Compact encoding: varints, zigzag integers, interned tags and strings, raw floats.
+// The reader recognizes the header word and switches to the compact encoding itself.
+//
+TEST_F(WIOTest, CompactRoundTrip)
+{
+    WFILE wstream;
+    ASSERT_GE(wopen(&wstream, filename, "w"), 0);
+    ASSERT_EQ(wbegin_compact(&wstream), 0);
+    EXPECT_TRUE(wstream.compact);
+    EXPECT_EQ(wputw(0, &wstream), 0);
+    EXPECT_EQ(wputw(127, &wstream), 0);
+    EXPECT_EQ(wputw(128, &wstream), 0);
+    EXPECT_EQ(wputw((size_t)-2, &wstream), 0);
+    EXPECT_EQ(wputi(-1, &wstream), 0);
+    EXPECT_EQ(wputi(INT64_MIN, &wstream), 0);
+    EXPECT_EQ(wputi(INT64_MAX, &wstream), 0);
+    EXPECT_EQ(wputtag(0x45585052, &wstream), 0); // first appearance
+    EXPECT_EQ(wputtag(0x54595045, &wstream), 0);
+    EXPECT_EQ(wputtag(0x45585052, &wstream), 0); // reference
+    EXPECT_EQ(wputtag(0, &wstream), 0);
+    EXPECT_EQ(wputstr("counter", &wstream), 0);
+    EXPECT_EQ(wputstr("", &wstream), 0);
+    EXPECT_EQ(wputstr("counter", &wstream), 0);
+    EXPECT_EQ(wputd(-2.5, &wstream), 0);
+    EXPECT_EQ(wputdata("a\0b", 3, &wstream), 0);
+    wclose(&wstream);
+
+    WFILE rstream;
+    ASSERT_GE(wopen(&rstream, filename, "r"), 0);
+    EXPECT_TRUE(waccept_compact(&rstream, wgetw(&rstream)));
+    EXPECT_EQ(wgetw(&rstream), 0u);
+    EXPECT_EQ(wgetw(&rstream), 127u);
+    EXPECT_EQ(wgetw(&rstream), 128u);
+    EXPECT_EQ(wgetw(&rstream), (size_t)-2);
+    EXPECT_EQ(wgeti(&rstream), -1);
+    EXPECT_EQ(wgeti(&rstream), INT64_MIN);
+    EXPECT_EQ(wgeti(&rstream), INT64_MAX);
+    EXPECT_EQ(wgettag(&rstream), 0x45585052u);
+    EXPECT_EQ(wgettag(&rstream), 0x54595045u);
+    EXPECT_EQ(wgettag(&rstream), 0x45585052u);
+    EXPECT_EQ(wgettag(&rstream), 0u);
+    char *str = wgetstr(&rstream);
+    EXPECT_STREQ(str, "counter");
+    xfree(str);
+    EXPECT_EQ(wgetstr(&rstream), nullptr);
+    str = wgetstr(&rstream);
+    EXPECT_STREQ(str, "counter");
+    xfree(str);
+    EXPECT_EQ(wgetd(&rstream), -2.5);
+    size_t len;
+    char *data = static_cast<char *>(wgetdata(&len, &rstream));
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(len, 3u);
+    EXPECT_EQ(memcmp(data, "a\0b", 3), 0);
+    xfree(data);
+    EXPECT_FALSE(werror(&rstream));
+    EXPECT_EQ(wgetw(&rstream), (size_t)-1);
+    EXPECT_TRUE(weof(&rstream));
+    wclose(&rstream);
+}
+
+//
+// A stream without the header stays in the word format; a header of an unknown
+// version is reported as an error.
+//
+TEST_F(WIOTest, CompactHeaderDetection)
+{
+    WFILE wstream;
+    ASSERT_GE(wopen(&wstream, filename, "w"), 0);
+    EXPECT_EQ(wputw(0x50524f47, &wstream), 0);
+    EXPECT_EQ(wputw(WIO_COMPACT_MAGIC | (WIO_COMPACT_VERSION + 1), &wstream), 0);
+    wclose(&wstream);
+
+    WFILE rstream;
+    ASSERT_GE(wopen(&rstream, filename, "r"), 0);
+    EXPECT_FALSE(waccept_compact(&rstream, wgetw(&rstream)));
+    EXPECT_FALSE(rstream.compact);
+    EXPECT_FALSE(werror(&rstream));
+    EXPECT_FALSE(waccept_compact(&rstream, wgetw(&rstream)));
+    EXPECT_TRUE(werror(&rstream));
+    wclose(&rstream);
+}
+
+//
+// A varint cut short by the end of file is an error, not a clean EOF.
+//
+TEST_F(WIOTest, CompactTruncatedVarint)
+{
+    WFILE wstream;
+    ASSERT_GE(wopen(&wstream, filename, "w"), 0);
+    ASSERT_EQ(wbegin_compact(&wstream), 0);
+    EXPECT_EQ(wputw(1000000, &wstream), 0);
+    wclose(&wstream);
+    ASSERT_EQ(truncate(filename, sizeof(size_t) + 1), 0);
+
+    WFILE rstream;
+    ASSERT_GE(wopen(&rstream, filename, "r"), 0);
+    EXPECT_TRUE(waccept_compact(&rstream, wgetw(&rstream)));
+    EXPECT_EQ(wgetw(&rstream), (size_t)-1);
+    EXPECT_TRUE(werror(&rstream));
+    EXPECT_FALSE(weof(&rstream));
+    wclose(&rstream);
+}
+
+//
+// After wrestart_tables() on both sides, a compact stream decodes from that point on
+// its own: the reader may seek there, and the offsets and digests agree.
+//
+TEST_F(WIOTest, CompactRestartAndOffsets)
+{
+    WFILE wstream;
+    ASSERT_GE(wopen(&wstream, filename, "w"), 0);
+    ASSERT_EQ(wbegin_compact(&wstream), 0);
+    EXPECT_EQ(wputstr("alpha", &wstream), 0);
+    wrestart_tables(&wstream);
+    size_t mark = woffset(&wstream);
+    wdigest_begin(&wstream);
+    EXPECT_EQ(wputstr("alpha", &wstream), 0);
+    EXPECT_EQ(wputtag(0x74706c76, &wstream), 0);
+    size_t digest = wdigest_end(&wstream);
+    EXPECT_EQ(wputfixed(mark, &wstream), 0);
+    wclose(&wstream);
+
+    WFILE rstream;
+    ASSERT_GE(wopen(&rstream, filename, "r"), 0);
+    EXPECT_TRUE(waccept_compact(&rstream, wgetw(&rstream)));
+    ASSERT_EQ(wseek(&rstream, -(long)sizeof(size_t), SEEK_END), 0);
+    EXPECT_EQ(wgetfixed(&rstream), mark);
+    ASSERT_EQ(wseek(&rstream, mark, SEEK_SET), 0);
+    EXPECT_EQ(woffset(&rstream), mark);
+    wrestart_tables(&rstream);
+    wdigest_begin(&rstream);
+    EXPECT_STREQ(wgetstr_tmp(&rstream), "alpha");
+    EXPECT_EQ(wgettag(&rstream), 0x74706c76u);
+    EXPECT_EQ(wdigest_end(&rstream), digest);
+    EXPECT_FALSE(werror(&rstream));
+    wclose(&rstream);
+}
@@ -349,3 +349,29 @@ TEST_F(XAllocTest, ReportWithLeaks)
     EXPECT_NE(output.find("test_func"), std::string::npos);
     // TearDown calls xfree_all() to clean up the outstanding block.
 }
+
+TEST_F(XAllocTest, PeakTracksHighestLiveSize)
+{
+    xset_peak_allocated_size(0);
+    void *a = xalloc(100, __func__, __FILE__, __LINE__);
+    void *b = xalloc(50, __func__, __FILE__, __LINE__);
+    xfree(a);
+    EXPECT_EQ(xtotal_allocated_size(), 50u);
+    EXPECT_EQ(xpeak_allocated_size(), 150u);
+
+    // Restarting the peak never drops it below what is live now.
+    EXPECT_EQ(xset_peak_allocated_size(0), 150u);
+    EXPECT_EQ(xpeak_allocated_size(), 50u);
+    xfree(b);
+}
+
+TEST_F(XAllocTest, CumulativeCountsIgnoreFrees)
+{
+    size_t count = xallocation_count();
+    size_t bytes = xcumulative_allocated_size();
+    xfree(xalloc(10, __func__, __FILE__, __LINE__));
+    xfree(xstrdup("abc"));
+    EXPECT_EQ(xallocation_count(), count + 2);
+    EXPECT_EQ(xcumulative_allocated_size(), bytes + 14);
+    EXPECT_EQ(xtotal_allocated_size(), 0u);
+}
@@ -5,23 +5,91 @@
 // A `WFILE` structure includes a buffer, file descriptor, and state flags,
 // with functions mirroring `stdio.h` but operating on `size_t` words in native byte order.
 //
+// A stream may switch to the compact encoding right after its first word (see
+// wbegin_compact): from then on every word is a LEB128 varint, a string is an index into
+// a per-stream string table, a tag is an index into a per-stream tag table, and a
+// floating-point value is its raw IEEE bytes.  The same put/get calls serve both
+// encodings, so the AST and TAC serializers do not care which one is in effect.
+//
 #include "wio.h"
 
 #include <errno.h>
 #include <fcntl.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "string_map.h"
 #include "xalloc.h"
 
-#define BUFFER_SIZE (4096 / sizeof(size_t)) /* Buffer holds words, aligned to page size */
+#define BUFFER_SIZE 4096 /* Buffer holds bytes, aligned to page size */
 
 int wio_debug; // Enable manually for debug
 
+//
+// Strings and tags of a compact stream.  Both sides number the entries from 1 in the
+// order of their first appearance; index 0 stands for the empty string or TAG_EOL.
+// The writer looks entries up by value, the reader by index.
+//
+struct _wtable {
+    // Writer side: value -> index.
+    StringMap string_index; // string -> index
+    size_t *tag_keys;       // open-addressing hash of tag words...
+    size_t *tag_values;     // ...and their indices (0 = empty slot)
+    size_t tag_slots;       // power of two
+
+    // Reader side: index - 1 -> value.
+    char **strings;
+    size_t *tags;
+    size_t strings_cap;
+    size_t tags_cap;
+
+    size_t nstrings; // Entries defined so far, both sides
+    size_t ntags;
+
+    char *scratch; // Buffer of wgetstr_tmp(), either encoding
+    size_t scratch_cap;
+};
+
+static void free_table(WFILE *stream)
+{
+    struct _wtable *t = stream->table;
+    if (!t)
+        return;
+    map_destroy(&t->string_index);
+    for (size_t i = 0; i < t->nstrings && t->strings; i++) {
+        free(t->strings[i]);
+    }
+    free(t->strings);
+    free(t->tags);
+    free(t->tag_keys);
+    free(t->tag_values);
+    free(t->scratch);
+    free(t);
+    stream->table   = NULL;
+    stream->compact = false;
+}
+
+static void init_stream(WFILE *stream, int fd, char mode, bool must_close_fd)
+{
+    stream->fd            = fd;
+    stream->buffer_pos    = 0;
+    stream->buffer_count  = 0;
+    stream->is_eof        = false;
+    stream->is_error      = false;
+    stream->compact       = false;
+    stream->mode          = mode;
+    stream->must_close_fd = must_close_fd;
+    stream->table         = NULL;
+    stream->offset        = 0;
+    stream->digest        = 0;
+    stream->digesting     = false;
+}
+
 //
 // Open a file with appropriate flags based on mode (`r`, `w`, `a`),
 // allocate a `WFILE` structure and buffer.
@@ -48,19 +116,12 @@ int wopen(WFILE *stream, const char *path, const char *mode)
     if (fd == -1)
         return -1;
 
-    stream->buffer = malloc(BUFFER_SIZE * sizeof(size_t));
+    stream->buffer = malloc(BUFFER_SIZE);
     if (!stream->buffer) {
         close(fd);
         return -1;
     }
-
-    stream->fd            = fd;
-    stream->buffer_pos    = 0;
-    stream->buffer_count  = 0;
-    stream->is_eof        = false;
-    stream->is_error      = false;
-    stream->mode          = m;
-    stream->must_close_fd = true;
+    init_stream(stream, fd, m, true);
     return 0;
 }
 
@@ -79,6 +140,7 @@ int wreopen(WFILE *stream, const char *path, const char *mode)
         close(stream->fd);
         stream->must_close_fd = false;
     }
+    free_table(stream);
     free(stream->buffer);
 
     return wopen(stream, path, mode);
@@ -98,18 +160,11 @@ int wdopen(WFILE *stream, int fildes, const char *mode)
         return -1;
     }
 
-    stream->buffer = malloc(BUFFER_SIZE * sizeof(size_t));
+    stream->buffer = malloc(BUFFER_SIZE);
     if (!stream->buffer) {
         return -1;
     }
-
-    stream->fd            = fildes;
-    stream->buffer_pos    = 0;
-    stream->buffer_count  = 0;
-    stream->is_eof        = false;
-    stream->is_error      = false;
-    stream->mode          = m;
-    stream->must_close_fd = false;
+    init_stream(stream, fildes, m, false);
     return 0;
 }
 
@@ -123,15 +178,20 @@ int wflush(WFILE *stream)
         return -1;
     }
 
-    if (stream->buffer_pos > 0) {
-        ssize_t bytes_to_write = stream->buffer_pos * sizeof(size_t);
-        ssize_t bytes_written  = write(stream->fd, stream->buffer, bytes_to_write);
-        if (bytes_written != bytes_to_write) {
+    size_t done = 0;
+    while (done < stream->buffer_pos) {
+        ssize_t bytes_written =
+            write(stream->fd, stream->buffer + done, stream->buffer_pos - done);
+        if (bytes_written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_written <= 0) {
             stream->is_error = true;
             return -1;
         }
-        stream->buffer_pos = 0;
+        done += bytes_written;
     }
+    stream->buffer_pos = 0;
     return 0;
 }
 
@@ -151,11 +211,20 @@ void wclose(WFILE *stream)
         close(stream->fd);
         stream->must_close_fd = false;
     }
+    free_table(stream);
     free(stream->buffer);
 }
 
 //
-// Adjust file position in word units, flush buffer if writing.
+// Size of one position unit: a word, or a byte in compact mode.
+//
+static size_t position_unit(const WFILE *stream)
+{
+    return stream->compact ? 1 : sizeof(size_t);
+}
+
+//
+// Adjust file position in word units (bytes in compact mode), flush buffer if writing.
 //
 int wseek(WFILE *stream, long offset, int whence)
 {
@@ -168,7 +237,7 @@ int wseek(WFILE *stream, long offset, int whence)
         wflush(stream);
     }
 
-    off_t new_offset = lseek(stream->fd, offset * sizeof(size_t), whence);
+    off_t new_offset = lseek(stream->fd, offset * position_unit(stream), whence);
     if (new_offset == -1) {
         stream->is_error = true;
         return -1;
@@ -177,11 +246,12 @@ int wseek(WFILE *stream, long offset, int whence)
     stream->buffer_pos   = 0;
     stream->buffer_count = 0;
     stream->is_eof       = false;
+    stream->offset       = new_offset;
     return 0;
 }
 
 //
-// Return current position in words, accounting for buffered data.
+// Return current position in words (bytes in compact mode), accounting for buffered data.
 //
 long wtell(WFILE *stream)
 {
@@ -197,13 +267,13 @@ long wtell(WFILE *stream)
     }
 
     if (stream->mode == 'r') {
-        pos -= stream->buffer_count * sizeof(size_t);
-        pos += stream->buffer_pos * sizeof(size_t);
+        pos -= stream->buffer_count;
+        pos += stream->buffer_pos;
     } else {
-        pos += stream->buffer_pos * sizeof(size_t);
+        pos += stream->buffer_pos;
     }
 
-    return pos / sizeof(size_t);
+    return pos / position_unit(stream);
 }
 
 //
@@ -217,37 +287,177 @@ void wrewind(WFILE *stream)
 }
 
 //
-// Read the next word, refilling the buffer if empty. Return `(size_t)-1` on EOF or error.
+// Fold bytes into the running digest (FNV-1a).
 //
-size_t wgetw(WFILE *stream)
+static void digest_bytes(WFILE *stream, const unsigned char *p, size_t len)
 {
-    if (!stream || stream->mode != 'r') {
-        errno = EINVAL;
-        return (size_t)-1;
+    uint64_t h = stream->digest;
+    while (len-- > 0) {
+        h ^= *p++;
+        h *= 1099511628211ull;
     }
+    stream->digest = (size_t)h;
+}
 
-    if (stream->buffer_pos >= stream->buffer_count) {
-        stream->buffer_pos   = 0;
-        stream->buffer_count = 0;
+//
+// Fill `data` with the next `len` bytes, refilling the buffer as often as needed: a pipe
+// may deliver a value split across several reads.  A clean end of stream before the
+// first byte sets the EOF flag; running dry in the middle of a value is an error.
+//
+static int get_bytes(WFILE *stream, void *data, size_t len)
+{
+    unsigned char *p = data;
+    size_t done      = 0;
 
-        ssize_t bytes_read = read(stream->fd, stream->buffer, BUFFER_SIZE * sizeof(size_t));
-        if (bytes_read <= 0) {
-            if (bytes_read == 0) {
-                stream->is_eof = true;
-            } else {
+    while (done < len) {
+        if (stream->buffer_pos >= stream->buffer_count) {
+            stream->buffer_pos   = 0;
+            stream->buffer_count = 0;
+
+            ssize_t bytes_read = read(stream->fd, stream->buffer, BUFFER_SIZE);
+            if (bytes_read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytes_read <= 0) {
+                if (bytes_read == 0 && done == 0) {
+                    stream->is_eof = true;
+                } else {
+                    stream->is_error = true;
+                }
+                return -1;
+            }
+            stream->buffer_count = bytes_read;
+        }
+        size_t chunk = stream->buffer_count - stream->buffer_pos;
+        if (chunk > len - done) {
+            chunk = len - done;
+        }
+        memcpy(p + done, stream->buffer + stream->buffer_pos, chunk);
+        stream->buffer_pos += chunk;
+        done += chunk;
+    }
+    if (stream->digesting) {
+        digest_bytes(stream, p, len);
+    }
+    stream->offset += len;
+    return 0;
+}
+
+//
+// Append `len` bytes to the buffer, flushing whenever it fills up.
+//
+static int put_bytes(WFILE *stream, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    if (stream->digesting) {
+        digest_bytes(stream, p, len);
+    }
+    stream->offset += len;
+    while (len > 0) {
+        if (stream->buffer_pos >= BUFFER_SIZE) {
+            if (wflush(stream) != 0) {
+                return -1;
+            }
+        }
+        size_t chunk = BUFFER_SIZE - stream->buffer_pos;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(stream->buffer + stream->buffer_pos, p, chunk);
+        stream->buffer_pos += chunk;
+        p += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+//
+// Unsigned LEB128: seven bits per byte, low group first, high bit set on all but the last.
+//
+static int put_varint(WFILE *stream, size_t v)
+{
+    unsigned char bytes[(sizeof(size_t) * 8 + 6) / 7];
+    size_t n = 0;
+    do {
+        unsigned char b = v & 0x7f;
+        v >>= 7;
+        if (v != 0) {
+            b |= 0x80;
+        }
+        bytes[n++] = b;
+    } while (v != 0);
+    return put_bytes(stream, bytes, n);
+}
+
+static size_t get_varint(WFILE *stream)
+{
+    size_t v       = 0;
+    unsigned shift = 0;
+    for (;;) {
+        unsigned char b;
+        if (get_bytes(stream, &b, 1) < 0) {
+            if (shift > 0) {
+                // Stream ended in the middle of a value.
+                stream->is_eof   = false;
                 stream->is_error = true;
             }
             return (size_t)-1;
         }
-
-        stream->buffer_count = bytes_read / sizeof(size_t);
-        if (bytes_read % sizeof(size_t) != 0) {
+        if (shift >= sizeof(size_t) * 8) {
+            // Longer than any value we could have written.
             stream->is_error = true;
             return (size_t)-1;
         }
+        v |= (size_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return v;
+        }
+        shift += 7;
+    }
+}
+
+//
+// Allocate the string and tag tables of a stream.
+//
+static void alloc_table(WFILE *stream)
+{
+    stream->table = calloc(1, sizeof(struct _wtable));
+    if (!stream->table) {
+        fprintf(stderr, "Out of memory allocating stream table\n");
+        exit(1);
+    }
+    map_init(&stream->table->string_index);
+}
+
+//
+// Switch a stream to compact mode.
+//
+static void enter_compact(WFILE *stream)
+{
+    if (!stream->table) {
+        alloc_table(stream);
+    }
+    stream->compact = true;
+}
+
+//
+// Read the next word, refilling the buffer if empty. Return `(size_t)-1` on EOF or error.
+// In compact mode the word is a LEB128 varint.
+//
+size_t wgetw(WFILE *stream)
+{
+    if (!stream || stream->mode != 'r') {
+        errno = EINVAL;
+        return (size_t)-1;
     }
 
-    size_t w = stream->buffer[stream->buffer_pos++];
+    size_t w;
+    if (stream->compact) {
+        w = get_varint(stream);
+    } else if (get_bytes(stream, &w, sizeof(w)) < 0) {
+        return (size_t)-1;
+    }
     if (wio_debug) {
         printf("    %s %#zx\n", __func__, w);
     }
@@ -256,6 +466,7 @@ size_t wgetw(WFILE *stream)
 
 //
 // Buffer a word, flushing when the buffer is full.
+// In compact mode the word is written as a LEB128 varint.
 //
 int wputw(size_t w, WFILE *stream)
 {
@@ -264,17 +475,164 @@ int wputw(size_t w, WFILE *stream)
         return -1;
     }
 
-    if (stream->buffer_pos >= BUFFER_SIZE) {
-        if (wflush(stream) != 0) {
-            return -1;
+    if (wio_debug) {
+        printf("    %s %#zx\n", __func__, w);
+    }
+    if (stream->compact) {
+        return put_varint(stream, w);
+    }
+    return put_bytes(stream, &w, sizeof(w));
+}
+
+//
+// Read a signed integer written by wputi().
+//
+long long wgeti(WFILE *stream)
+{
+    size_t w = wgetw(stream);
+    if (stream->compact) {
+        // Undo the zigzag mapping: 0, 1, 2, 3, ... -> 0, -1, 1, -2, ...
+        return (long long)(w >> 1) ^ -(long long)(w & 1);
+    }
+    return (long long)w;
+}
+
+//
+// Write a signed integer.  A plain word in the word format; in compact mode a zigzag
+// varint, so that small negative numbers stay short.
+//
+int wputi(long long i, WFILE *stream)
+{
+    if (stream && stream->compact) {
+        unsigned long long u = (unsigned long long)i;
+        return wputw((size_t)((u << 1) ^ (i < 0 ? ~0ULL : 0)), stream);
+    }
+    return wputw((size_t)i, stream);
+}
+
+//
+// Find a tag word in the writer's hash table; return its index, or 0 when absent.
+//
+static size_t tag_lookup(const struct _wtable *t, size_t tag)
+{
+    if (t->tag_slots == 0) {
+        return 0;
+    }
+    size_t mask = t->tag_slots - 1;
+    for (size_t i = (tag * 0x9e3779b9u) & mask;; i = (i + 1) & mask) {
+        if (t->tag_values[i] == 0) {
+            return 0;
+        }
+        if (t->tag_keys[i] == tag) {
+            return t->tag_values[i];
         }
     }
+}
 
-    if (wio_debug) {
-        printf("    %s %#zx\n", __func__, w);
+static void tag_insert(struct _wtable *t, size_t tag, size_t index)
+{
+    if (2 * (t->ntags + 1) > t->tag_slots) {
+        // Keep the table at most half full: rehash into twice the slots.
+        size_t old_slots   = t->tag_slots;
+        size_t *old_keys   = t->tag_keys;
+        size_t *old_values = t->tag_values;
+
+        t->tag_slots  = old_slots ? 2 * old_slots : 256;
+        t->tag_keys   = calloc(t->tag_slots, sizeof(size_t));
+        t->tag_values = calloc(t->tag_slots, sizeof(size_t));
+        if (!t->tag_keys || !t->tag_values) {
+            fprintf(stderr, "Out of memory growing compact tag table\n");
+            exit(1);
+        }
+        for (size_t i = 0; i < old_slots; i++) {
+            if (old_values[i] != 0) {
+                tag_insert(t, old_keys[i], old_values[i]);
+            }
+        }
+        free(old_keys);
+        free(old_values);
     }
-    stream->buffer[stream->buffer_pos++] = w;
-    return 0;
+    size_t mask = t->tag_slots - 1;
+    size_t i    = (tag * 0x9e3779b9u) & mask;
+    while (t->tag_values[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    t->tag_keys[i]   = tag;
+    t->tag_values[i] = index;
+}
+
+//
+// Grow a reader-side table to hold at least `need` entries.
+//
+static void *grow_vector(void *vec, size_t *cap, size_t need, size_t elem_size)
+{
+    if (need <= *cap) {
+        return vec;
+    }
+    size_t new_cap = *cap ? 2 * *cap : 256;
+    while (new_cap < need) {
+        new_cap *= 2;
+    }
+    vec = realloc(vec, new_cap * elem_size);
+    if (!vec) {
+        fprintf(stderr, "Out of memory growing compact stream table\n");
+        exit(1);
+    }
+    *cap = new_cap;
+    return vec;
+}
+
+//
+// Read a tag written by wputtag().  Return `(size_t)-1` on EOF or error.
+//
+size_t wgettag(WFILE *stream)
+{
+    if (!stream || !stream->compact) {
+        return wgetw(stream);
+    }
+    struct _wtable *t = stream->table;
+    size_t index      = wgetw(stream);
+    if (index == 0 || index == (size_t)-1) {
+        return index; // TAG_EOL, or EOF
+    }
+    if (index == t->ntags + 1) {
+        // First appearance: the tag word itself follows.
+        size_t tag = wgetw(stream);
+        if (weof(stream) || werror(stream)) {
+            return (size_t)-1;
+        }
+        t->tags            = grow_vector(t->tags, &t->tags_cap, index, sizeof(size_t));
+        t->tags[t->ntags++] = tag;
+        return tag;
+    }
+    if (index > t->ntags) {
+        stream->is_error = true;
+        return (size_t)-1;
+    }
+    return t->tags[index - 1];
+}
+
+//
+// Write a node tag.  A plain word in the word format.  In compact mode, a tag is the
+// varint index of its entry in the tag table; on its first appearance the tag word
+// follows, which defines that entry for the reader.  Zero (TAG_EOL) is written as is.
+//
+int wputtag(size_t tag, WFILE *stream)
+{
+    if (!stream || !stream->compact || tag == 0) {
+        return wputw(tag, stream);
+    }
+    struct _wtable *t = stream->table;
+    size_t index      = tag_lookup(t, tag);
+    if (index != 0) {
+        return wputw(index, stream);
+    }
+    index = ++t->ntags;
+    tag_insert(t, tag, index);
+    if (wputw(index, stream) < 0) {
+        return -1;
+    }
+    return wputw(tag, stream);
 }
 
 //
@@ -321,49 +679,124 @@ void wclearerr(WFILE *stream)
 }
 
 //
-// Read a zero terminated string, aligned to word boundary.
-// Return a dynamically allocated buffer; the caller frees it with xfree().
-// The buffer grows as needed, so the string may be of any length.
-// In case of zero length string return NULL.
+// Read a string from the compact stream's string table (see wputstr).
 //
-char *wgetstr(WFILE *stream)
+static const char *get_table_string(WFILE *stream)
+{
+    struct _wtable *t = stream->table;
+    size_t index      = wgetw(stream);
+    if (index == 0 || index == (size_t)-1) {
+        return NULL;
+    }
+    if (index == t->nstrings + 1) {
+        // First appearance: length and bytes follow.
+        size_t len = wgetw(stream);
+        if (weof(stream) || werror(stream)) {
+            return NULL;
+        }
+        char *str = malloc(len + 1);
+        if (!str) {
+            fprintf(stderr, "Out of memory reading %zu-byte string\n", len);
+            exit(1);
+        }
+        if (get_bytes(stream, str, len) < 0) {
+            stream->is_eof   = false;
+            stream->is_error = true;
+            free(str);
+            return NULL;
+        }
+        str[len]   = '\0';
+        t->strings = grow_vector(t->strings, &t->strings_cap, index, sizeof(char *));
+        t->strings[t->nstrings++] = str;
+    } else if (index > t->nstrings) {
+        stream->is_error = true;
+        return NULL;
+    }
+    return t->strings[index - 1];
+}
+
+//
+// Read a word-format string into the stream's scratch buffer, which grows as
+// needed, so the string may be of any length.
+//
+static const char *get_word_string(WFILE *stream)
 {
-    size_t capacity = 128; // words
-    size_t *buf     = xalloc(capacity * sizeof(size_t), __func__, __FILE__, __LINE__);
-    size_t n        = 0;
+    struct _wtable *t = stream->table;
+    size_t n          = 0; // words read
 
     for (;;) {
-        buf[n] = wgetw(stream);
+        if ((n + 1) * sizeof(size_t) > t->scratch_cap) {
+            t->scratch = grow_vector(t->scratch, &t->scratch_cap, (n + 1) * sizeof(size_t), 1);
+        }
+        size_t w = wgetw(stream);
         if (stream->is_eof) {
-            xfree(buf);
             return NULL;
         }
-        if (n == 0 && buf[n] == 0) {
+        if (n == 0 && w == 0) {
             // Read empty string.
-            xfree(buf);
             return NULL;
         }
+        memcpy(t->scratch + n * sizeof(size_t), &w, sizeof(size_t));
+        n++;
+
         // Does this word contain '\0' byte?
-        bool is_last_word = memchr(&buf[n], '\0', sizeof(size_t)) != NULL;
-        if (is_last_word) {
-            if (wio_debug) {
-                printf("    %s '%s'\n", __func__, (char *)buf);
-            }
-            char *str = xstrdup((char *)buf);
-            xfree(buf);
-            return str;
-        }
-        if (++n == capacity) {
-            // Grow the word buffer: xalloc has no realloc, so copy into a larger block.
-            size_t *bigger = xalloc(capacity * 2 * sizeof(size_t), __func__, __FILE__, __LINE__);
-            memcpy(bigger, buf, capacity * sizeof(size_t));
-            xfree(buf);
-            buf = bigger;
-            capacity *= 2;
+        if (memchr(&w, '\0', sizeof(size_t)) != NULL) {
+            return t->scratch;
         }
     }
 }
 
+//
+// Read a zero terminated string, aligned to word boundary, into storage owned by
+// the stream.  The result stays valid until the next call of wgetstr_tmp() on the
+// same stream, which saves an allocation when the caller keeps its own copy anyway.
+// In case of zero length string return NULL.
+//
+const char *wgetstr_tmp(WFILE *stream)
+{
+    if (!stream->table) {
+        alloc_table(stream);
+    }
+    const char *str = stream->compact ? get_table_string(stream) : get_word_string(stream);
+    if (str && wio_debug) {
+        printf("    %s '%s'\n", __func__, str);
+    }
+    return str;
+}
+
+//
+// Read a zero terminated string, aligned to word boundary.
+// Return a dynamically allocated buffer; the caller frees it with xfree().
+// In case of zero length string return NULL.
+//
+char *wgetstr(WFILE *stream)
+{
+    const char *str = wgetstr_tmp(stream);
+    return str ? xstrdup(str) : NULL;
+}
+
+//
+// Write a string through the compact stream's string table.  A string already in the
+// table costs one varint, its index.  On the first appearance the new index is followed
+// by the length and the bytes, so each name is stored once per stream.
+//
+static int put_table_string(const char *str, WFILE *stream)
+{
+    struct _wtable *t = stream->table;
+    intptr_t index;
+    if (map_get(&t->string_index, str, &index)) {
+        return wputw((size_t)index, stream);
+    }
+    index = ++t->nstrings;
+    map_insert(&t->string_index, str, index, 0);
+
+    size_t len = strlen(str);
+    if (wputw((size_t)index, stream) < 0 || wputw(len, stream) < 0) {
+        return -1;
+    }
+    return put_bytes(stream, str, len);
+}
+
 //
 // Write a zero terminated string, aligned to word boundary.
 //
@@ -372,10 +805,13 @@ int wputstr(const char *str, WFILE *stream)
     if (wio_debug) {
         printf("    %s '%s'\n", __func__, str ? str : "(empty)");
     }
-    if (str == NULL) {
+    if (str == NULL || (stream->compact && str[0] == '\0')) {
         // Write empty string.
         return wputw(0, stream);
     }
+    if (stream->compact) {
+        return put_table_string(str, stream);
+    }
     for (;;) {
         size_t w          = 0;
         bool is_last_word = memccpy(&w, str, '\0', sizeof(w)) != NULL;
@@ -394,7 +830,7 @@ int wputstr(const char *str, WFILE *stream)
 // Write a byte blob of a known length, aligned to word boundary: one word holding the
 // byte count, then the bytes themselves, zero-padded to the last word.  Unlike wputstr()
 // nothing terminates the data, so it may contain NUL bytes — which is what a decoded C
-// string literal such as "a\0c" needs.
+// string literal such as "a\0c" needs.  In compact mode there is no padding.
 //
 int wputdata(const void *data, size_t len, WFILE *stream)
 {
@@ -404,6 +840,9 @@ int wputdata(const void *data, size_t len, WFILE *stream)
     if (wputw(len, stream) < 0) {
         return -1;
     }
+    if (stream->compact) {
+        return put_bytes(stream, data, len);
+    }
     const char *p = data;
     for (size_t pos = 0; pos < len; pos += sizeof(size_t)) {
         size_t w     = 0;
@@ -428,18 +867,25 @@ void *wgetdata(size_t *len, WFILE *stream)
 {
     *len     = 0;
     size_t n = wgetw(stream);
-    if (stream->is_eof || n == 0) {
+    if (stream->is_eof || stream->is_error || n == 0) {
         return NULL;
     }
     size_t nwords = (n + sizeof(size_t) - 1) / sizeof(size_t);
     char *buf     = xalloc(nwords * sizeof(size_t) + 1, __func__, __FILE__, __LINE__);
-    for (size_t i = 0; i < nwords; i++) {
-        size_t w = wgetw(stream);
-        if (stream->is_eof) {
+    if (stream->compact) {
+        if (get_bytes(stream, buf, n) < 0) {
             xfree(buf);
             return NULL;
         }
-        memcpy(buf + i * sizeof(size_t), &w, sizeof(size_t));
+    } else {
+        for (size_t i = 0; i < nwords; i++) {
+            size_t w = wgetw(stream);
+            if (stream->is_eof) {
+                xfree(buf);
+                return NULL;
+            }
+            memcpy(buf + i * sizeof(size_t), &w, sizeof(size_t));
+        }
     }
     buf[n] = '\0';
     if (wio_debug) {
@@ -454,6 +900,13 @@ void *wgetdata(size_t *len, WFILE *stream)
 //
 double wgetd(WFILE *stream)
 {
+    if (stream->compact) {
+        // Raw IEEE bytes
+        double f;
+        if (get_bytes(stream, &f, sizeof(f)) < 0)
+            return nan("");
+        return f;
+    }
     if (sizeof(double) == sizeof(size_t)) {
         // One word
         union {
@@ -489,6 +942,10 @@ double wgetd(WFILE *stream)
 //
 int wputd(double f, WFILE *stream)
 {
+    if (stream->compact) {
+        // Raw IEEE bytes
+        return put_bytes(stream, &f, sizeof(f));
+    }
     if (sizeof(double) == sizeof(size_t)) {
         // One word
         union {
@@ -520,7 +977,12 @@ long double wgetld(WFILE *stream)
         size_t w[(sizeof(long double) + sizeof(size_t) - 1) / sizeof(size_t)];
         long double f;
     } u;
-    u.f           = 0;
+    u.f = 0;
+    if (stream->compact) {
+        if (get_bytes(stream, &u, sizeof(u.f)) < 0)
+            return __builtin_nanl("");
+        return u.f;
+    }
     size_t nwords = sizeof(u.w) / sizeof(size_t);
     for (size_t i = 0; i < nwords; i++) {
         u.w[i] = wgetw(stream);
@@ -536,7 +998,11 @@ int wputld(long double f, WFILE *stream)
         long double f;
         size_t w[(sizeof(long double) + sizeof(size_t) - 1) / sizeof(size_t)];
     } u;
-    u.f           = f;
+    memset(&u, 0, sizeof(u)); // keep the padding bytes of an x87 value deterministic
+    u.f = f;
+    if (stream->compact) {
+        return put_bytes(stream, &u, sizeof(u.f));
+    }
     size_t nwords = sizeof(u.w) / sizeof(size_t);
     for (size_t i = 0; i < nwords; i++) {
         if (wputw(u.w[i], stream) < 0)
@@ -544,3 +1010,117 @@ int wputld(long double f, WFILE *stream)
     }
     return 0;
 }
+
+//
+// Start the compact encoding on a stream opened for writing: write the header word
+// (WIO_COMPACT_MAGIC plus the format version) in the word format, then switch.
+// Call it before anything else is written.
+//
+int wbegin_compact(WFILE *stream)
+{
+    if (!stream || (stream->mode != 'w' && stream->mode != 'a') || stream->compact) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (wputw(WIO_COMPACT_MAGIC | WIO_COMPACT_VERSION, stream) < 0) {
+        return -1;
+    }
+    enter_compact(stream);
+    return 0;
+}
+
+//
+// Given the first word read from a stream, tell whether it is the header of a compact
+// stream.  If so, switch the reader to the compact encoding and return true; the caller
+// then reads its first real tag.  A header of a newer, unknown version is an error.
+//
+bool waccept_compact(WFILE *stream, size_t header)
+{
+    if (!stream || stream->compact || (header & ~(size_t)0xff) != WIO_COMPACT_MAGIC) {
+        return false;
+    }
+    unsigned version = header & 0xff;
+    if (version == 0 || version > WIO_COMPACT_VERSION) {
+        fprintf(stderr, "Error: compact stream version %u is not supported\n", version);
+        stream->is_error = true;
+        return false;
+    }
+    enter_compact(stream);
+    return true;
+}
+
+//
+// Number of bytes read or written so far.  It counts from the place where the stream was
+// opened, so for a file written from the start it is the file position; wseek() resets it
+// to the new position.
+//
+size_t woffset(const WFILE *stream)
+{
+    return stream ? stream->offset : 0;
+}
+
+//
+// Read a full native word, bypassing the compact encoding.
+//
+size_t wgetfixed(WFILE *stream)
+{
+    size_t w;
+    if (!stream || stream->mode != 'r' || get_bytes(stream, &w, sizeof(w)) < 0) {
+        return (size_t)-1;
+    }
+    return w;
+}
+
+//
+// Write a full native word, bypassing the compact encoding: a fixed-size field that a
+// reader can find at a known distance from the end of the file.
+//
+int wputfixed(size_t w, WFILE *stream)
+{
+    if (!stream || (stream->mode != 'w' && stream->mode != 'a')) {
+        errno = EINVAL;
+        return -1;
+    }
+    return put_bytes(stream, &w, sizeof(w));
+}
+
+//
+// Start a digest of the bytes read or written from now on.
+//
+void wdigest_begin(WFILE *stream)
+{
+    stream->digest    = (size_t)14695981039346656037ull;
+    stream->digesting = true;
+}
+
+//
+// Stop digesting and return the digest of the bytes since wdigest_begin().
+//
+size_t wdigest_end(WFILE *stream)
+{
+    stream->digesting = false;
+    return stream->digest;
+}
+
+//
+// Forget all strings and tags of a compact stream, on either side.  When the writer and
+// the reader both restart at the same point, everything after it decodes without the
+// bytes before it.  No effect in the word format.
+//
+void wrestart_tables(WFILE *stream)
+{
+    struct _wtable *t = stream ? stream->table : NULL;
+    if (!t || !stream->compact) {
+        return;
+    }
+    map_destroy(&t->string_index);
+    map_init(&t->string_index);
+    for (size_t i = 0; i < t->nstrings && t->strings; i++) {
+        free(t->strings[i]);
+    }
+    if (t->tag_values) {
+        memset(t->tag_values, 0, t->tag_slots * sizeof(size_t));
+    }
+    t->nstrings = 0;
+    t->ntags    = 0;
+}
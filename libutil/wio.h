@@ -11,19 +11,34 @@ extern "C" {
 #endif
 
 //
-// WFILE structure: Contains a file descriptor (`fd`), a buffer
-// for `size_t` words, buffer position and count, EOF and error flags,
-// and mode (`r`, `w`, or `a`).
+// Header word of a compact stream: 'cmp' in bits 8..31, the format version in bits 0..7.
+// It never collides with a TAG_* word of the AST or TAC format, so a reader can tell the
+// two encodings apart from the first word of a stream.
+//
+#define WIO_COMPACT_MAGIC   ((size_t)0x636d7000)
+#define WIO_COMPACT_VERSION 1
+
+struct _wtable; // compact-mode string and tag tables, private to wio.c
+
+//
+// WFILE structure: Contains a file descriptor (`fd`), a byte buffer,
+// buffer position and count, EOF and error flags, encoding,
+// mode (`r`, `w`, or `a`), and a running byte offset and digest.
 //
 struct _wfile {
-    int fd;              /* Underlying file descriptor */
-    size_t *buffer;      /* Buffer for read/write operations */
-    size_t buffer_pos;   /* Current position in buffer */
-    size_t buffer_count; /* Number of words in buffer */
-    bool is_eof;         /* End-of-file flag */
-    bool is_error;       /* Error flag */
-    bool must_close_fd;  /* after wopen */
-    char mode;           /* 'r' for read, 'w' for write, 'a' for append */
+    int fd;                /* Underlying file descriptor */
+    unsigned char *buffer; /* Buffer for read/write operations */
+    size_t buffer_pos;     /* Current byte position in buffer */
+    size_t buffer_count;   /* Number of bytes in buffer */
+    bool is_eof;           /* End-of-file flag */
+    bool is_error;         /* Error flag */
+    bool must_close_fd;    /* after wopen */
+    bool compact;          /* Varint encoding, after wbegin_compact() or waccept_compact() */
+    char mode;             /* 'r' for read, 'w' for write, 'a' for append */
+    struct _wtable *table; /* Strings and tags seen so far, string buffer */
+    size_t offset;         /* Bytes read or written since open, or file position after wseek */
+    size_t digest;         /* FNV-1a of the bytes since wdigest_begin() */
+    bool digesting;        /* Update `digest` on every byte */
 };
 typedef struct _wfile WFILE;
 
@@ -37,6 +52,10 @@ long wtell(WFILE *stream);
 void wrewind(WFILE *stream);
 size_t wgetw(WFILE *stream);
 int wputw(size_t w, WFILE *stream);
+long long wgeti(WFILE *stream);
+int wputi(long long i, WFILE *stream);
+size_t wgettag(WFILE *stream);
+int wputtag(size_t tag, WFILE *stream);
 double wgetd(WFILE *stream);
 int wputd(double w, WFILE *stream);
 long double wgetld(WFILE *stream);
@@ -45,11 +64,30 @@ bool weof(const WFILE *stream);
 bool werror(const WFILE *stream);
 int wfileno(const WFILE *stream);
 void wclearerr(WFILE *stream);
-char *wgetstr(WFILE *stream); // dynamically allocated
+char *wgetstr(WFILE *stream);           // dynamically allocated
+const char *wgetstr_tmp(WFILE *stream); // valid until the next call
 int wputstr(const char *str, WFILE *stream);
 void *wgetdata(size_t *len, WFILE *stream); // dynamically allocated
 int wputdata(const void *data, size_t len, WFILE *stream);
 
+//
+// Compact encoding: LEB128 varints, a per-stream string table, raw IEEE floats.
+//
+int wbegin_compact(WFILE *stream);
+bool waccept_compact(WFILE *stream, size_t header);
+
+//
+// Random access: byte offsets that need no lseek (so they work on pipes too), raw words
+// in either encoding, a digest of a range of bytes, and restarting the compact tables
+// so that a reader may begin decoding at a recorded offset.
+//
+size_t woffset(const WFILE *stream);
+size_t wgetfixed(WFILE *stream);
+int wputfixed(size_t w, WFILE *stream);
+void wdigest_begin(WFILE *stream);
+size_t wdigest_end(WFILE *stream);
+void wrestart_tables(WFILE *stream);
+
 #ifdef __cplusplus
 }
 #endif
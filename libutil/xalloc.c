@@ -47,6 +47,14 @@ typedef struct BlockHeader {
 //
 static BlockHeader *head = NULL;
 
+//
+// Running totals, kept up to date by xalloc() and xfree() so that reading them is O(1).
+//
+static size_t live_bytes;       // requested bytes not yet freed
+static size_t peak_bytes;       // highest live_bytes since the last xset_peak_allocated_size()
+static size_t allocation_count; // xalloc() calls, ever
+static size_t allocated_bytes;  // bytes requested by those calls, ever
+
 //
 // Allocate size bytes and return a pointer to the memory.
 // Exits the program with an error message if allocation fails.
@@ -76,6 +84,12 @@ void *xalloc(size_t size, const char *funcname, const char *filename, unsigned l
     h->filename       = filename;
     h->lineno         = lineno;
 
+    live_bytes += size;
+    if (live_bytes > peak_bytes)
+        peak_bytes = live_bytes;
+    allocation_count++;
+    allocated_bytes += size;
+
     /* Insert into the doubly linked list */
     if (head == NULL) {
         /* First allocation */
@@ -137,6 +151,7 @@ void xfree(void *ptr)
     // Just in case.
     h->next = NULL;
     h->prev = NULL;
+    live_bytes -= h->requested_size;
 
     /* Free the entire block (header + user data) */
     free(h);
@@ -168,11 +183,41 @@ void xreport_lost_memory()
 //
 size_t xtotal_allocated_size()
 {
-    size_t total = 0;
-    for (const BlockHeader *h = head; h; h = h->next) {
-        total += h->requested_size;
-    }
-    return total;
+    return live_bytes;
+}
+
+//
+// Return the highest value xtotal_allocated_size() has reached.
+//
+size_t xpeak_allocated_size()
+{
+    return peak_bytes;
+}
+
+//
+// Restart peak tracking from `peak` (raised to the current live size if it is lower)
+// and return the previous peak.  A caller that measures the peak of a region resets it
+// at the start and, at the end, restores the larger of the two values.
+//
+size_t xset_peak_allocated_size(size_t peak)
+{
+    size_t old = peak_bytes;
+    peak_bytes = (peak > live_bytes) ? peak : live_bytes;
+    return old;
+}
+
+//
+// Return the number of xalloc() calls, and the bytes they requested, since the start.
+// Freeing does not decrease either count.
+//
+size_t xallocation_count()
+{
+    return allocation_count;
+}
+
+size_t xcumulative_allocated_size()
+{
+    return allocated_bytes;
 }
 
 //
@@ -189,6 +234,7 @@ void xfree_all()
         free(head);
         head = next;
     }
+    live_bytes = 0;
 }
 
 //
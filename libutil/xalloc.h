@@ -34,6 +34,10 @@ char *xstrdup(const char *str);
 char *xmemdup(const void *data, size_t len);
 void xreport_lost_memory(void);
 size_t xtotal_allocated_size(void);
+size_t xpeak_allocated_size(void);
+size_t xset_peak_allocated_size(size_t peak);
+size_t xallocation_count(void);
+size_t xcumulative_allocated_size(void);
 char *xstruniq(const char *prefix, int *counter);
 
 #ifdef __cplusplus
@@ -142,6 +142,10 @@ static void note_instr(StringMap *observable, const StringMap *private_set,
         note_name(observable, private_set, ins->u.copy_from_offset.src);
         note_vals(observable, private_set, ins->u.copy_from_offset.dst);
         break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        note_vals(observable, private_set, ins->u.block_copy.src_ptr);
+        note_vals(observable, private_set, ins->u.block_copy.dst_ptr);
+        break;
     case TAC_INSTRUCTION_JUMP_IF_ZERO:
         note_vals(observable, private_set, ins->u.jump_if_zero.condition);
         break;
@@ -927,6 +927,7 @@ Tac_Instruction *constant_fold(Tac_Instruction *body)
             Tac_Val *folded = fold_unary_const(cur->u.unary.op, cur->u.unary.src->u.constant);
             if (folded) {
                 opt_trace_instr("[const-fold] unary fold:", cur);
+                opt_stats.folded++;
                 Tac_Instruction *copy = tac_new_instruction(TAC_INSTRUCTION_COPY);
                 copy->u.copy.src      = folded;
                 copy->u.copy.dst      = cur->u.unary.dst; // steal dst
@@ -955,6 +956,7 @@ Tac_Instruction *constant_fold(Tac_Instruction *body)
                                                 cur->u.binary.src2->u.constant);
             if (folded) {
                 opt_trace_instr("[const-fold] binary fold:", cur);
+                opt_stats.folded++;
                 Tac_Instruction *copy = tac_new_instruction(TAC_INSTRUCTION_COPY);
                 copy->u.copy.src      = folded;
                 copy->u.copy.dst      = cur->u.binary.dst; // steal dst
@@ -990,6 +992,7 @@ Tac_Instruction *constant_fold(Tac_Instruction *body)
                 fold_conversion(cur->kind, cur->u.sign_extend.src->u.constant, dst_kind);
             if (folded) {
                 opt_trace_instr("[const-fold] conversion fold:", cur);
+                opt_stats.folded++;
                 Tac_Instruction *copy = tac_new_instruction(TAC_INSTRUCTION_COPY);
                 copy->u.copy.src      = folded;
                 copy->u.copy.dst      = cur->u.sign_extend.dst; // steal dst
@@ -1022,6 +1025,7 @@ Tac_Instruction *constant_fold(Tac_Instruction *body)
             cur->u.jump_if_zero.condition->kind == TAC_VAL_CONSTANT) {
             bool is_zero = const_is_zero(cur->u.jump_if_zero.condition->u.constant);
             bool take    = (cur->kind == TAC_INSTRUCTION_JUMP_IF_ZERO) ? is_zero : !is_zero;
+            opt_stats.branches_resolved++;
 
             if (take) {
                 // Always taken: build a Jump, stealing the target label string.
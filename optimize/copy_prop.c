@@ -46,9 +46,9 @@
 // ============================================================================
 
 typedef struct {
-    char *name;   // owned (xstrdup); the destination name, == the map key
-    Tac_Val *src; // owned (dup_val) — an independent copy, not a borrow into the
-                  // instruction stream, which substitution/self-copy removal frees
+    const char *name; // interned (tac_intern); the destination name, == the map key
+    Tac_Val *src;     // owned (dup_val) — an independent copy, not a borrow into the
+                      // instruction stream, which substitution/self-copy removal frees
 } CopyPair;
 
 static Tac_Val *dup_val(const Tac_Val *v);
@@ -58,7 +58,6 @@ static void pair_free(intptr_t value)
     CopyPair *p = (CopyPair *)value;
     if (!p)
         return;
-    xfree(p->name);
     tac_free_val(p->src);
     xfree(p);
 }
@@ -76,16 +75,17 @@ static void copy_set_destroy(StringMap *cs)
 // ============================================================================
 
 typedef struct {
-    char **keys;
+    const char **keys;
     int count;
     int cap;
 } KeyBuf;
 
-static void keybuf_push(KeyBuf *kb, char *key)
+static void keybuf_push(KeyBuf *kb, const char *key)
 {
     if (kb->count == kb->cap) {
         int new_cap     = kb->cap ? kb->cap * 2 : 8;
-        char **new_keys = xalloc(new_cap * sizeof(char *), __func__, __FILE__, __LINE__);
+        const char **new_keys =
+            xalloc(new_cap * sizeof(char *), __func__, __FILE__, __LINE__);
         for (int i = 0; i < kb->count; i++)
             new_keys[i] = kb->keys[i];
         xfree(kb->keys);
@@ -96,7 +96,7 @@ static void keybuf_push(KeyBuf *kb, char *key)
 }
 
 // Remove all collected keys from cs; free the associated CopyPair values.
-// kb.keys[i] points into the CopyPair's name field; pair_free will free it.
+// kb.keys[i] is the CopyPair's interned name field, which stays valid.
 // map_remove_key frees the StringNode's own copy of the key string.
 static void keybuf_flush(KeyBuf *kb, StringMap *cs)
 {
@@ -114,8 +114,8 @@ static void keybuf_flush(KeyBuf *kb, StringMap *cs)
 
 // ============================================================================
 // copy_set_copy: deep-copy src into dst (dst must be a freshly initialised
-// empty map). Each CopyPair is duplicated (its name re-xstrdup'd); the borrowed
-// `src` Tac_Val pointer is shared, since it points into the instruction stream.
+// empty map). Each CopyPair is duplicated (the interned name is shared, the src
+// value is copied with dup_val).
 // Used to seed a block's in-set from a predecessor's out-set.
 // ============================================================================
 
@@ -129,7 +129,7 @@ static void copy_cb(const char *key, intptr_t value, const void *arg)
     const CopyCtx *ctx = (const CopyCtx *)arg;
     const CopyPair *sp = (const CopyPair *)value;
     CopyPair *np       = xalloc(sizeof(CopyPair), __func__, __FILE__, __LINE__);
-    np->name           = xstrdup(sp->name);
+    np->name           = sp->name;
     np->src            = dup_val(sp->src);
     map_insert_free(ctx->dst, np->name, (intptr_t)np, 0, pair_free);
 }
@@ -156,8 +156,9 @@ static void kill_name_cb(const char *key, intptr_t value, const void *arg)
     (void)key;
     const KillNameCtx *ctx = (const KillNameCtx *)arg;
     const CopyPair *pair   = (const CopyPair *)value;
-    if (strcmp(pair->name, ctx->name) == 0 ||
-        (pair->src->kind == TAC_VAL_VAR && strcmp(pair->src->u.var_name, ctx->name) == 0)) {
+    // Names are interned: equal names share a pointer.
+    if (pair->name == ctx->name ||
+        (pair->src->kind == TAC_VAL_VAR && pair->src->u.var_name == ctx->name)) {
         keybuf_push(ctx->kb, pair->name);
     }
 }
@@ -279,7 +280,7 @@ static void apply_transfer(StringMap *cs, const Tac_Instruction *ins, const Stri
             if (ins->is_volatile)
                 return;
             CopyPair *p = xalloc(sizeof(CopyPair), __func__, __FILE__, __LINE__);
-            p->name     = xstrdup(dst->u.var_name);
+            p->name     = dst->u.var_name;
             p->src      = dup_val(ins->u.copy.src);
             map_insert_free(cs, p->name, (intptr_t)p, 0, pair_free);
             OPT_TRACE(
@@ -305,9 +306,10 @@ static void apply_transfer(StringMap *cs, const Tac_Instruction *ins, const Stri
         return;
     }
 
-    if (ins->kind == TAC_INSTRUCTION_STORE) {
+    if (ins->kind == TAC_INSTRUCTION_STORE || ins->kind == TAC_INSTRUCTION_BLOCK_COPY) {
         // A store writes through a pointer, which may alias any address-taken
-        // variable: kill copies involving them. (Store defines no named var.)
+        // variable: kill copies involving them. (Store defines no named var.) A
+        // block copy writes through its destination pointer the same way.
         OPT_TRACE("[copy-prop] store: kill address-taken copies\n");
         kill_alias_set(cs, address_taken);
         return;
@@ -412,7 +414,7 @@ static Tac_Val *dup_val(const Tac_Val *v)
         *nc            = *v->u.constant;
         nv->u.constant = nc;
     } else {
-        nv->u.var_name = xstrdup(v->u.var_name);
+        nv->u.var_name = v->u.var_name; // interned: share it
     }
     return nv;
 }
@@ -436,6 +438,7 @@ static void subst_val(Tac_Val **vp, const StringMap *cs)
     v->next           = NULL; // isolate before freeing; tac_free_val follows .next
     tac_free_val(v);
     *vp = repl;
+    opt_stats.uses_substituted++;
 }
 
 // ============================================================================
@@ -543,6 +546,10 @@ static void subst_instruction(Tac_Instruction *ins, const StringMap *cs)
     case TAC_INSTRUCTION_COPY_FROM_OFFSET:
     case TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET:
         break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        subst_val(&ins->u.block_copy.src_ptr, cs);
+        subst_val(&ins->u.block_copy.dst_ptr, cs);
+        break;
     case TAC_INSTRUCTION_JUMP_IF_ZERO:
         subst_val(&ins->u.jump_if_zero.condition, cs);
         break;
@@ -682,9 +689,10 @@ void propagate_copies(OptCfg *cfg, const Tac_TopLevel *fn)
             // a no-op — unlink and free it.
             if (ins->kind == TAC_INSTRUCTION_COPY && ins->u.copy.src->kind == TAC_VAL_VAR &&
                 ins->u.copy.dst->kind == TAC_VAL_VAR &&
-                strcmp(ins->u.copy.src->u.var_name, ins->u.copy.dst->u.var_name) == 0) {
+                ins->u.copy.src->u.var_name == ins->u.copy.dst->u.var_name) {
                 OPT_TRACE("[copy-prop] removed self-copy %s = %s\n", ins->u.copy.dst->u.var_name,
                           ins->u.copy.src->u.var_name);
+                opt_stats.self_copies++;
                 if (prev)
                     prev->next = next;
                 else
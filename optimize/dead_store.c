@@ -294,6 +294,12 @@ static void live_transfer_backward(StringMap *ls, const Tac_Instruction *ins,
     case TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET:
         live_add(ls, ins->u.copy_from_offset.src); // char*, not Tac_Val*
         break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        // Reads through src_ptr, which may point at any address-taken variable.
+        live_set_union(ls, address_taken);
+        live_add_val(ls, ins->u.block_copy.src_ptr);
+        live_add_val(ls, ins->u.block_copy.dst_ptr);
+        break;
     case TAC_INSTRUCTION_JUMP_IF_ZERO:
         live_add_val(ls, ins->u.jump_if_zero.condition);
         break;
@@ -308,8 +314,8 @@ static void live_transfer_backward(StringMap *ls, const Tac_Instruction *ins,
 // ============================================================================
 // is_removable: true for pure instructions, whose only effect is to define their
 // destination — safe to delete when that destination is dead. Excluded (kept
-// even when dst is dead): STORE and COPY_TO_OFFSET (write through a pointer /
-// into a struct field — observable), FUN_CALL (arbitrary side effects), and all
+// even when dst is dead): STORE, COPY_TO_OFFSET and BLOCK_COPY (write through a
+// pointer / into a struct field — observable), FUN_CALL (arbitrary side effects), and all
 // control-flow instructions. GET_ADDRESS, LOAD, ADD_PTR and COPY_FROM_OFFSET are
 // pure reads and so are removable when their result is unused.
 // ============================================================================
@@ -479,6 +485,7 @@ void eliminate_dead_stores(const OptCfg *cfg, const Tac_TopLevel *fn)
             if (dst && is_removable(ins->kind) && !ins->is_volatile && !map_get(&live, dst, NULL)) {
                 OPT_TRACE("[dead-store] block %d: dst '%s' is dead", i, dst);
                 opt_trace_instr(" removing:", ins);
+                opt_stats.stores_killed++;
                 Tac_Instruction *prev = (j > 0) ? block_insts[i][j - 1] : NULL;
                 if (prev)
                     prev->next = ins->next;
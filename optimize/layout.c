@@ -0,0 +1,369 @@
+// ============================================================================
+// layout.c — profile-guided block layout.
+//
+// The translator emits blocks in source order, and the other passes keep it, so
+// the code generators lay out every `if` with its then-part falling through and
+// every loop with its test at the top and a jump back at the bottom, whichever
+// way the program actually goes. With a block profile (see optimize.h) the
+// blocks are reordered instead so that the hot successor of each block follows
+// it, in the manner of Pettis and Hansen:
+//
+//   1. Weigh every CFG edge by how often it was followed: a jump's edge by the
+//      block's entries, a conditional jump's by how often it was taken and not.
+//   2. Visit the edges hottest first, and join the chain ending at the source
+//      to the chain starting at the destination, unless both are one chain.
+//   3. Rotate a loop whose chain starts with its test, when the jump back is
+//      taken more often than the loop is entered: the test moves after the
+//      body, so each pass costs the conditional jump back rather than the test
+//      and an unconditional jump. A test of the `i < n` form the code generator
+//      may count in a register (VLM on BESM-6) stays at the top.
+//   4. Join chains once more over the edges the rotation freed, and place the
+//      chains: the entry's first, the rest in source order.
+//
+// Then each block is made to reach its successors from where it now stands:
+// a jump to the next block is dropped; a conditional jump whose fall-through
+// went elsewhere is inverted when its target is next, and otherwise gets a jump
+// to the old fall-through; a block that fell through gets a jump.
+//
+// See docs/TAC_Optimization.md §"Profile-guided block layout".
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfg.h"
+#include "optimize.h"
+#include "string_map.h"
+#include "xalloc.h"
+
+// The counts of one function.
+typedef struct {
+    int ninstrs;       // instructions of the body the counts were taken of
+    int nblocks;
+    int cap;
+    int *first;        // per block: index of its first instruction
+    uint64_t *entries; // per block: times control reached it
+    uint64_t *taken;   // per block: times the jump that ends it was taken
+} ProfileFunction;
+
+struct OptProfile {
+    StringMap functions; // name -> ProfileFunction*
+};
+
+// A CFG edge and how often it was followed.
+typedef struct {
+    int from, to;
+    uint64_t weight;
+} Edge;
+
+static void free_function(intptr_t value)
+{
+    ProfileFunction *pf = (ProfileFunction *)value;
+    xfree(pf->first);
+    xfree(pf->entries);
+    xfree(pf->taken);
+    xfree(pf);
+}
+
+static void add_block(ProfileFunction *pf, int first, uint64_t entries, uint64_t taken)
+{
+    if (pf->nblocks == pf->cap) {
+        int cap     = pf->cap ? 2 * pf->cap : 16;
+        int *f      = xalloc(cap * sizeof(int), __func__, __FILE__, __LINE__);
+        uint64_t *e = xalloc(cap * sizeof(uint64_t), __func__, __FILE__, __LINE__);
+        uint64_t *t = xalloc(cap * sizeof(uint64_t), __func__, __FILE__, __LINE__);
+        if (pf->nblocks > 0) {
+            memcpy(f, pf->first, pf->nblocks * sizeof(int));
+            memcpy(e, pf->entries, pf->nblocks * sizeof(uint64_t));
+            memcpy(t, pf->taken, pf->nblocks * sizeof(uint64_t));
+            xfree(pf->first);
+            xfree(pf->entries);
+            xfree(pf->taken);
+        }
+        pf->first   = f;
+        pf->entries = e;
+        pf->taken   = t;
+        pf->cap     = cap;
+    }
+    pf->first[pf->nblocks]   = first;
+    pf->entries[pf->nblocks] = entries;
+    pf->taken[pf->nblocks]   = taken;
+    pf->nblocks++;
+}
+
+OptProfile *opt_profile_read(const char *path)
+{
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        perror(path);
+        exit(1);
+    }
+    OptProfile *profile = xalloc(sizeof(OptProfile), __func__, __FILE__, __LINE__);
+    map_init(&profile->functions);
+
+    ProfileFunction *pf = NULL;
+    char line[1024], name[1000];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), in)) {
+        lineno++;
+        int ninstrs, first;
+        unsigned long long entries, taken;
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        if (sscanf(line, "function %999s %d", name, &ninstrs) == 2) {
+            pf          = xalloc(sizeof(ProfileFunction), __func__, __FILE__, __LINE__);
+            pf->ninstrs = ninstrs;
+            map_insert_free(&profile->functions, name, (intptr_t)pf, 0, free_function);
+        } else if (pf && sscanf(line, "%d %llu %llu", &first, &entries, &taken) == 3) {
+            add_block(pf, first, entries, taken);
+        } else {
+            fprintf(stderr, "Error: %s:%d: not a block profile line\n", path, lineno);
+            exit(1);
+        }
+    }
+    fclose(in);
+    return profile;
+}
+
+void opt_profile_free(OptProfile *profile)
+{
+    map_destroy_free(&profile->functions, free_function);
+    xfree(profile);
+}
+
+// The chain a block is in, by its first block.
+static int chain_head(const int *prev, int b)
+{
+    while (prev[b] >= 0)
+        b = prev[b];
+    return b;
+}
+
+// Step 2: join chains along the edges, hottest first.
+static void join_chains(const Edge *edges, int nedges, int *next, int *prev)
+{
+    for (int i = 0; i < nedges; i++) {
+        int a = edges[i].from, b = edges[i].to;
+        if (edges[i].weight == 0 || b == 0 || next[a] >= 0 || prev[b] >= 0 ||
+            chain_head(prev, a) == b)
+            continue;
+        next[a] = b;
+        prev[b] = a;
+    }
+}
+
+// Hottest first; ties in source order, so that equal counts leave the code alone.
+static int compare_edges(const void *x, const void *y)
+{
+    const Edge *a = x, *b = y;
+    if (a->weight != b->weight)
+        return a->weight > b->weight ? -1 : 1;
+    if (a->from != b->from)
+        return a->from - b->from;
+    return a->to - b->to;
+}
+
+// A loop test the code generator may count in a register: `t = i < n` and a jump out on
+// t, alone in its block after the label.
+static bool is_counted_test(const OptBlock *b)
+{
+    const Tac_Instruction *label = b->first;
+    const Tac_Instruction *cmp   = label->next;
+    const Tac_Instruction *test  = cmp ? cmp->next : NULL;
+    return label->kind == TAC_INSTRUCTION_LABEL && cmp && cmp->kind == TAC_INSTRUCTION_BINARY &&
+           cmp->u.binary.op == TAC_BINARY_LESS_THAN && test == b->last &&
+           test->kind == TAC_INSTRUCTION_JUMP_IF_ZERO;
+}
+
+// Step 3: move the test of a loop after its body when the jump back is the hotter way in.
+static void rotate_loops(const OptCfg *cfg, const Edge *edges, int nedges,
+                         const uint64_t *entries, int *next, int *prev)
+{
+    for (int h = 1; h < cfg->nblocks; h++) {
+        const OptBlock *head = cfg->blocks[h];
+        int body             = next[h];
+        if (prev[h] >= 0 || body < 0 || head->nsucc != 2 || is_counted_test(head))
+            continue;
+        int tail = body;
+        while (next[tail] >= 0)
+            tail = next[tail];
+        uint64_t back = 0;
+        for (int i = 0; i < nedges; i++)
+            if (edges[i].from == tail && edges[i].to == h)
+                back += edges[i].weight;
+        if (back == 0 || back <= entries[h] - back)
+            continue;
+
+        // The test leaves the loop on its other edge, so it must not lead into the chain.
+        int out = head->succs[0]->id == body ? head->succs[1]->id : head->succs[0]->id;
+        if (out == h || chain_head(prev, out) == h)
+            continue;
+        OPT_TRACE("[layout] block %d: test moved after block %d\n", h, tail);
+        next[h]    = -1;
+        prev[body] = -1;
+        next[tail] = h;
+        prev[h]    = tail;
+    }
+}
+
+// The label a jump to `b` names, prepended when the block has none.
+static const char *block_label(OptBlock *b, int *label_seq)
+{
+    if (b->first && b->first->kind == TAC_INSTRUCTION_LABEL)
+        return b->first->u.label.name;
+    char name[32];
+    snprintf(name, sizeof(name), "%%%d", (*label_seq)++);
+    Tac_Instruction *label = tac_new_instruction(TAC_INSTRUCTION_LABEL);
+    label->u.label.name    = tac_intern(name);
+    label->next            = b->first;
+    b->first               = label;
+    if (!b->last)
+        b->last = label;
+    return label->u.label.name;
+}
+
+static void append_jump(OptBlock *b, const char *target)
+{
+    Tac_Instruction *jump = tac_new_instruction(TAC_INSTRUCTION_JUMP);
+    jump->u.jump.target   = tac_intern(target);
+    b->last->next         = jump;
+    b->last               = jump;
+}
+
+static void drop_last(OptBlock *b)
+{
+    Tac_Instruction *jump = b->last;
+    if (b->first == jump) {
+        b->first = b->last = NULL;
+    } else {
+        Tac_Instruction *prev = b->first;
+        while (prev->next != jump)
+            prev = prev->next;
+        prev->next = NULL;
+        b->last    = prev;
+    }
+    tac_free_instruction(jump);
+}
+
+// Make each block reach its successors from its place in `order`.
+static void fix_successors(OptBlock **order, int n, int *label_seq)
+{
+    for (int p = 0; p < n; p++) {
+        OptBlock *b          = order[p];
+        const OptBlock *next = p + 1 < n ? order[p + 1] : NULL;
+        Tac_Instruction *end = b->last;
+        switch (end->kind) {
+        case TAC_INSTRUCTION_JUMP:
+            if (b->succs[0] == next)
+                drop_last(b);
+            break;
+        case TAC_INSTRUCTION_JUMP_IF_ZERO:
+        case TAC_INSTRUCTION_JUMP_IF_NOT_ZERO: {
+            OptBlock *fall = b->succs[1];
+            if (fall == next)
+                break;
+            const char *target = block_label(fall, label_seq);
+            if (b->succs[0] == next) {
+                // Same condition, the other way: jump to the old fall-through instead.
+                Tac_Val *condition = end->u.jump_if_zero.condition;
+                if (end->kind == TAC_INSTRUCTION_JUMP_IF_ZERO) {
+                    end->kind                          = TAC_INSTRUCTION_JUMP_IF_NOT_ZERO;
+                    end->u.jump_if_not_zero.condition = condition;
+                    end->u.jump_if_not_zero.target    = tac_intern(target);
+                } else {
+                    end->kind                      = TAC_INSTRUCTION_JUMP_IF_ZERO;
+                    end->u.jump_if_zero.condition = condition;
+                    end->u.jump_if_zero.target    = tac_intern(target);
+                }
+            } else {
+                append_jump(b, target);
+            }
+            break;
+        }
+        case TAC_INSTRUCTION_RETURN:
+            break;
+        default:
+            if (b->nsucc == 1 && b->succs[0] != next)
+                append_jump(b, block_label(b->succs[0], label_seq));
+            break;
+        }
+    }
+}
+
+void layout_function(Tac_TopLevel *fn, const OptProfile *profile, int *label_seq)
+{
+    intptr_t value;
+    Tac_Instruction *body = fn->u.function.body;
+    if (!body || !map_get(&profile->functions, fn->u.function.name, &value))
+        return;
+    const ProfileFunction *pf = (const ProfileFunction *)value;
+    int ninstrs               = 0;
+    for (const Tac_Instruction *i = body; i; i = i->next)
+        ninstrs++;
+
+    // The blocks must be the ones counted, instruction for instruction.
+    OptCfg *cfg = cfg_build(body);
+    int n       = cfg->nblocks;
+    bool same   = ninstrs == pf->ninstrs && n == pf->nblocks;
+    for (int b = 0, index = 0; same && b < n; b++) {
+        same = pf->first[b] == index;
+        for (const Tac_Instruction *i = cfg->blocks[b]->first; i; i = i->next)
+            index++;
+    }
+    if (!same)
+        fprintf(stderr, "Warning: the profile of %s is of different code, not used\n",
+                fn->u.function.name);
+    if (!same || pf->entries[0] == 0) {
+        fn->u.function.body = cfg_flatten(cfg);
+        cfg_free(cfg);
+        return;
+    }
+
+    // Step 1: the edges and their weights.
+    Edge *edges = xalloc(2 * n * sizeof(Edge), __func__, __FILE__, __LINE__);
+    int nedges  = 0;
+    for (int b = 0; b < n; b++) {
+        const OptBlock *block = cfg->blocks[b];
+        uint64_t taken        = pf->taken[b] < pf->entries[b] ? pf->taken[b] : pf->entries[b];
+        switch (block->last->kind) {
+        case TAC_INSTRUCTION_JUMP_IF_ZERO:
+        case TAC_INSTRUCTION_JUMP_IF_NOT_ZERO:
+            edges[nedges++] = (Edge){ b, block->succs[0]->id, taken };
+            edges[nedges++] = (Edge){ b, block->succs[1]->id, pf->entries[b] - taken };
+            break;
+        default:
+            if (block->nsucc == 1)
+                edges[nedges++] = (Edge){ b, block->succs[0]->id, pf->entries[b] };
+            break;
+        }
+    }
+    qsort(edges, nedges, sizeof(Edge), compare_edges);
+
+    // Steps 2-4: the chains, then the order.
+    int *next = xalloc(n * sizeof(int), __func__, __FILE__, __LINE__);
+    int *prev = xalloc(n * sizeof(int), __func__, __FILE__, __LINE__);
+    for (int b = 0; b < n; b++)
+        next[b] = prev[b] = -1;
+    join_chains(edges, nedges, next, prev);
+    rotate_loops(cfg, edges, nedges, pf->entries, next, prev);
+    join_chains(edges, nedges, next, prev);
+
+    OptBlock **order = xalloc(n * sizeof(OptBlock *), __func__, __FILE__, __LINE__);
+    int placed       = 0;
+    for (int h = 0; h < n; h++) {
+        if (prev[h] >= 0)
+            continue;
+        for (int b = h; b >= 0; b = next[b])
+            order[placed++] = cfg->blocks[b];
+    }
+    fix_successors(order, n, label_seq);
+
+    memcpy(cfg->blocks, order, n * sizeof(OptBlock *));
+    fn->u.function.body = cfg_flatten(cfg);
+    cfg_free(cfg);
+    xfree(order);
+    xfree(next);
+    xfree(prev);
+    xfree(edges);
+}
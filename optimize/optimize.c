@@ -26,6 +26,7 @@
 #include "optimize.h"
 
 #include "cfg.h"
+#include "phase.h"
 
 // Pass entry points, implemented in the sibling translation units.
 Tac_Instruction *constant_fold(Tac_Instruction *body);
@@ -36,6 +37,9 @@ void eliminate_dead_stores(const OptCfg *cfg, const Tac_TopLevel *fn);
 // Process-global trace switch (see optimize.h). Default off.
 int optimize_debug;
 
+// Running pass counters (see optimize.h).
+OptStats opt_stats;
+
 // Print one instruction under `prefix`, gated by optimize_debug. tac_print_instruction
 // emits its own trailing newline, so the line reads "<prefix> <instruction>".
 void opt_trace_instr(const char *prefix, const Tac_Instruction *ins)
@@ -49,6 +53,39 @@ void opt_trace_instr(const char *prefix, const Tac_Instruction *ins)
         printf("(null)\n");
 }
 
+void opt_stats_print_header(FILE *out)
+{
+    fprintf(out, "%-24s %5s %7s %7s %6s %6s %6s %6s %6s %6s %6s %6s\n", "function", "iter",
+            "before", "after", "fold", "branch", "blocks", "jumps", "labels", "subst", "selfcp",
+            "dead");
+}
+
+void opt_stats_print(FILE *out, const char *name, const OptStats *since)
+{
+    static const OptStats zero;
+    if (!since)
+        since = &zero;
+    fprintf(out, "%-24s %5lu %7lu %7lu %6lu %6lu %6lu %6lu %6lu %6lu %6lu %6lu\n", name,
+            opt_stats.iterations - since->iterations,
+            opt_stats.instrs_before - since->instrs_before,
+            opt_stats.instrs_after - since->instrs_after, opt_stats.folded - since->folded,
+            opt_stats.branches_resolved - since->branches_resolved,
+            opt_stats.blocks_removed - since->blocks_removed,
+            opt_stats.jumps_removed - since->jumps_removed,
+            opt_stats.labels_removed - since->labels_removed,
+            opt_stats.uses_substituted - since->uses_substituted,
+            opt_stats.self_copies - since->self_copies,
+            opt_stats.stores_killed - since->stores_killed);
+}
+
+static unsigned long count_instructions(const Tac_Instruction *body)
+{
+    unsigned long n = 0;
+    for (; body; body = body->next)
+        n++;
+    return n;
+}
+
 // Default flags: every CLI-toggleable pass is enabled, tracing off. Constant
 // folding has no flag — it always runs, to keep the downstream code generators
 // simpler.
@@ -70,35 +107,48 @@ Tac_Instruction *optimize_function(Tac_Instruction *body, OptFlags flags, const
         return NULL;
 
     optimize_debug = flags.debug ? 1 : 0;
+    opt_stats.functions++;
+    opt_stats.instrs_before += count_instructions(body);
 
     int iter = 0;
     for (;;) {
         iter++;
+        opt_stats.iterations++;
         OPT_TRACE("[optimize] iteration %d\n", iter);
 
         // Constant folding first, on the flat list (no CFG required).
         OPT_TRACE("[optimize] running pass: const-fold\n");
+        phase_begin("const-fold");
         body = constant_fold(body);
+        phase_end();
 
         // Split into basic blocks for the three CFG-based passes.
+        phase_begin("cfg");
         OptCfg *cfg = cfg_build(body);
+        phase_end();
         OPT_TRACE("[optimize] cfg built: %d blocks\n", cfg->nblocks);
 
         if (flags.unreachable_elim) {
             OPT_TRACE("[optimize] running pass: unreachable-elim\n");
+            phase_begin("unreachable");
             eliminate_unreachable(cfg);
+            phase_end();
         } else {
             OPT_TRACE("[optimize] pass unreachable-elim: skipped (disabled)\n");
         }
         if (flags.copy_propagation) {
             OPT_TRACE("[optimize] running pass: copy-prop\n");
+            phase_begin("copy-prop");
             propagate_copies(cfg, fn);
+            phase_end();
         } else {
             OPT_TRACE("[optimize] pass copy-prop: skipped (disabled)\n");
         }
         if (flags.dead_store_elim) {
             OPT_TRACE("[optimize] running pass: dead-store-elim\n");
+            phase_begin("dead-store");
             eliminate_dead_stores(cfg, fn);
+            phase_end();
         } else {
             OPT_TRACE("[optimize] pass dead-store-elim: skipped (disabled)\n");
         }
@@ -112,8 +162,10 @@ Tac_Instruction *optimize_function(Tac_Instruction *body, OptFlags flags, const
         bool body_freed = (cfg->blocks[0]->first != body);
 
         // Rejoin the (possibly modified) blocks into a flat list.
+        phase_begin("cfg");
         Tac_Instruction *new_body = cfg_flatten(cfg);
         cfg_free(cfg);
+        phase_end();
 
         // An empty result is also a terminal condition: nothing left to iterate.
         if (!new_body) {
@@ -128,6 +180,7 @@ Tac_Instruction *optimize_function(Tac_Instruction *body, OptFlags flags, const
         // both the comparison and the free.)
         if (!body_freed && tac_compare_instruction(new_body, body)) {
             OPT_TRACE("[optimize] fixed point reached after %d iteration(s)\n", iter);
+            opt_stats.instrs_after += count_instructions(new_body);
             return new_body;
         }
         if (body_freed) {
@@ -30,9 +30,54 @@ extern int optimize_debug;
 // optimize_debug. Used to show an instruction before/after a rewrite.
 void opt_trace_instr(const char *prefix, const Tac_Instruction *ins);
 
+// What the passes rewrote, for `lower --stats`. The passes add to the global
+// opt_stats unconditionally — an increment costs less than testing a switch — and
+// a driver that wants one function's numbers copies opt_stats before the call and
+// prints the difference afterwards. Every count is summed over fixed-point
+// iterations.
+typedef struct {
+    unsigned long functions;         // bodies optimized
+    unsigned long iterations;        // pipeline iterations to the fixed point
+    unsigned long instrs_before;     // instructions entering optimize_function
+    unsigned long instrs_after;      // instructions leaving it
+    unsigned long folded;            // const-fold: unary, binary and conversions folded
+    unsigned long branches_resolved; // const-fold: conditional jumps on a constant
+    unsigned long blocks_removed;    // unreachable: non-empty blocks freed
+    unsigned long jumps_removed;     // unreachable: jumps to the next block
+    unsigned long labels_removed;    // unreachable: labels nothing jumps to
+    unsigned long uses_substituted;  // copy-prop: source operands replaced
+    unsigned long self_copies;       // copy-prop: x = x removed after substitution
+    unsigned long stores_killed;     // dead-store: dead definitions removed
+} OptStats;
+
+extern OptStats opt_stats;
+
+// Print the column header of opt_stats_print.
+void opt_stats_print_header(FILE *out);
+
+// Print one row: what opt_stats gained since `since` (all of it when NULL).
+void opt_stats_print(FILE *out, const char *name, const OptStats *since);
+
 // Returns the optimized body in place (modifies the list).
 // Caller owns the result; caller freed the original list.
 // `fn` is the function's own toplevel — its params and automatic locals let the
 // CFG passes tell private locals from observable globals. Pass NULL when no such
 // context is available (the optimizer then makes no global-vs-local distinction).
 Tac_Instruction *optimize_function(Tac_Instruction *body, OptFlags flags, const Tac_TopLevel *fn);
+
+// Block profile for profile-guided layout (`lower --profile-use`), as `tacrun --profile-out`
+// writes it from a run of the TAC `lower` gives without one.  A text file: after `#`
+// comments, a line `function <name> <instructions>` per function that ran, followed by a
+// line `<first> <entries> <taken>` per basic block in order — the index of the block's
+// first instruction, how often control reached it, and how often the jump that ends it
+// was taken.  Reading a file that is missing or malformed is a fatal error.
+typedef struct OptProfile OptProfile;
+
+OptProfile *opt_profile_read(const char *path);
+void opt_profile_free(OptProfile *profile);
+
+// Reorder the blocks of function `fn` so that the hot successor of each block falls
+// through to it, inverting conditional jumps and adding jumps as the new order needs.
+// A function the profile has no counts for, or counts of different code, is left as it
+// is.  New labels are numbered from the unit-wide *label_seq (see translate.h).
+void layout_function(Tac_TopLevel *fn, const OptProfile *profile, int *label_seq);
@@ -170,7 +170,7 @@ protected:
     static Tac_Val *make_var(const char *name)
     {
         Tac_Val *val    = tac_new_val(TAC_VAL_VAR);
-        val->u.var_name = xstrdup(name);
+        val->u.var_name = tac_intern(name);
         return val;
     }
 
@@ -216,7 +216,7 @@ protected:
     {
         Tac_Instruction *i          = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_ZERO);
         i->u.jump_if_zero.condition = cond;
-        i->u.jump_if_zero.target    = xstrdup(target);
+        i->u.jump_if_zero.target    = tac_intern(target);
         return i;
     }
 
@@ -224,21 +224,21 @@ protected:
     {
         Tac_Instruction *i              = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_NOT_ZERO);
         i->u.jump_if_not_zero.condition = cond;
-        i->u.jump_if_not_zero.target    = xstrdup(target);
+        i->u.jump_if_not_zero.target    = tac_intern(target);
         return i;
     }
 
     static Tac_Instruction *make_label(const char *name)
     {
         Tac_Instruction *i = tac_new_instruction(TAC_INSTRUCTION_LABEL);
-        i->u.label.name    = xstrdup(name);
+        i->u.label.name    = tac_intern(name);
         return i;
     }
 
     static Tac_Instruction *make_jump(const char *target)
     {
         Tac_Instruction *i = tac_new_instruction(TAC_INSTRUCTION_JUMP);
-        i->u.jump.target   = xstrdup(target);
+        i->u.jump.target   = tac_intern(target);
         return i;
     }
 
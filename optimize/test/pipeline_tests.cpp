@@ -312,3 +312,41 @@ TEST_F(PipelineTest, DeadLocalRemovedAlongsideGlobalWrite)
               "    kind: var\n"
               "    name: g\n");
 }
+
+// ---------------------------------------------------------------------------
+// Pass statistics (lower --stats)
+// ---------------------------------------------------------------------------
+
+TEST_F(PipelineTest, StatsCountEachPass)
+{
+    OptStats before = opt_stats;
+    OptimizeYaml("int g;\n"
+                 "int f(void) {\n"
+                 "    int x = 2 * 3;\n" // folded; x copied into y, then dead
+                 "    int y = x;\n"
+                 "    if (0) g = 1;\n" // branch resolved, its block unreachable
+                 "    return y;\n"
+                 "}\n");
+    EXPECT_EQ(opt_stats.functions - before.functions, 1u);
+    EXPECT_GE(opt_stats.iterations - before.iterations, 2u);
+    EXPECT_LT(opt_stats.instrs_after - before.instrs_after,
+              opt_stats.instrs_before - before.instrs_before);
+    EXPECT_GE(opt_stats.folded - before.folded, 1u);
+    EXPECT_EQ(opt_stats.branches_resolved - before.branches_resolved, 1u);
+    EXPECT_EQ(opt_stats.blocks_removed - before.blocks_removed, 1u);
+    EXPECT_GE(opt_stats.uses_substituted - before.uses_substituted, 1u);
+    EXPECT_GE(opt_stats.stores_killed - before.stores_killed, 1u);
+}
+
+TEST_F(PipelineTest, StatsOnlyCountEnabledPasses)
+{
+    OptFlags flags         = opt_flags_default();
+    flags.copy_propagation = false;
+    flags.dead_store_elim  = false;
+    OptStats before        = opt_stats;
+    OptimizeYaml("int f(void) { int x = 1; int y = x; return y; }", flags);
+    EXPECT_EQ(opt_stats.uses_substituted, before.uses_substituted);
+    EXPECT_EQ(opt_stats.stores_killed, before.stores_killed);
+    EXPECT_EQ(opt_stats.instrs_after - before.instrs_after,
+              opt_stats.instrs_before - before.instrs_before);
+}
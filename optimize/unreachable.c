@@ -49,12 +49,13 @@ static void remove_useless_jumps(OptCfg *cfg)
         const OptBlock *nb = cfg->blocks[next];
         if (nb->first->kind != TAC_INSTRUCTION_LABEL)
             continue;
-        if (strcmp(nb->first->u.label.name, target) != 0)
+        if (nb->first->u.label.name != target) // interned names
             continue;
 
         // Unlink the trailing Jump. If it was the block's only instruction the
         // block becomes empty; otherwise walk to its predecessor and re-terminate.
         OPT_TRACE("[unreach] block %d: dropping useless jump to %s\n", i, target);
+        opt_stats.jumps_removed++;
         Tac_Instruction *jmp = b->last;
         if (b->first == b->last) {
             b->first = b->last = NULL;
@@ -117,6 +118,7 @@ static void remove_unused_labels(OptCfg *cfg)
             continue;
 
         OPT_TRACE("[unreach] block %d: dropping unused label %s\n", i, lbl->u.label.name);
+        opt_stats.labels_removed++;
         Tac_Instruction *new_first = lbl->next;
         lbl->next                  = NULL;
         tac_free_instruction(lbl);
@@ -160,6 +162,8 @@ void eliminate_unreachable(OptCfg *cfg)
         OptBlock *b = cfg->blocks[i];
         if (!b->reachable) {
             OPT_TRACE("[unreach] freeing unreachable block %d\n", i);
+            if (b->first)
+                opt_stats.blocks_removed++;
             tac_free_instruction(b->first);
             b->first = NULL;
             b->last  = NULL;
@@ -5,7 +5,10 @@
 #include <string.h>
 
 #include "parser.h"
+#include "phase.h"
 #include "scanner.h"
+#include "server.h"
+#include "wio.h"
 #include "xalloc.h"
 
 //
@@ -31,6 +34,12 @@ typedef struct {
     int help;            // -h or --help
     int debug;           // -D or --debug
     OutputFormat format; // Output format (--ast, --yaml, --dot)
+    int compact;         // --compact
+    int time_report;     // --time-report
+    PhaseReportFormat report_format;
+    const char *server;  // --server
+    const char *prefix;  // --prefix-snapshot
+    const char *save;    // --save-prefix-snapshot
     char *input_file;    // Input filename
     char *output_file;   // Output filename (optional)
 } Args;
@@ -50,6 +59,15 @@ void print_usage(const char *prog_name)
     fprintf(stderr, "    --ast            Emit AST in binary format (default)\n");
     fprintf(stderr, "    --yaml           Emit YAML format\n");
     fprintf(stderr, "    --dot            Emit Graphviz DOT script\n");
+    fprintf(stderr, "    --compact        Use compact varint encoding for binary AST\n");
+    fprintf(stderr, "    --time-report[=json]\n");
+    fprintf(stderr, "                     Print time and memory per phase to stderr\n");
+    fprintf(stderr, "    --prefix-snapshot FILE\n");
+    fprintf(stderr, "                     Resume after the prefix saved in FILE, when the input\n");
+    fprintf(stderr, "                     begins with it\n");
+    fprintf(stderr, "    --save-prefix-snapshot FILE\n");
+    fprintf(stderr, "                     Save the parsed input as a prefix snapshot in FILE\n");
+    fprintf(stderr, "    --server SOCKET  Serve compile requests on the Unix socket SOCKET\n");
     fprintf(stderr, "    -v, --verbose    Enable verbose mode\n");
     fprintf(stderr, "    -D, --debug      Print debug information\n");
     fprintf(stderr, "    -h, --help       Show this help message\n");
@@ -64,6 +82,11 @@ void init_args(Args *args)
     args->help        = 0;
     args->debug       = 0;
     args->format      = FORMAT_AST; // Default format
+    args->compact     = 0;
+    args->time_report = 0;
+    args->server      = NULL;
+    args->prefix      = NULL;
+    args->save        = NULL;
     args->input_file  = NULL;
     args->output_file = NULL;
 }
@@ -100,13 +123,18 @@ char *generate_output_filename(const char *input_file, OutputFormat format)
 int parse_args(int argc, char *argv[], Args *args)
 {
     static struct option long_options[] = {
-        { "verbose", no_argument, 0, 'v' }, //
-        { "help", no_argument, 0, 'h' },    //
-        { "debug", no_argument, 0, 'D' },   //
-        { "ast", no_argument, 0, 'a' },     //
-        { "yaml", no_argument, 0, 'y' },    //
-        { "dot", no_argument, 0, 'd' },     //
-        {},                                 //
+        { "verbose", no_argument, 0, 'v' },                    //
+        { "help", no_argument, 0, 'h' },                       //
+        { "debug", no_argument, 0, 'D' },                      //
+        { "ast", no_argument, 0, 'a' },                        //
+        { "yaml", no_argument, 0, 'y' },                       //
+        { "dot", no_argument, 0, 'd' },                        //
+        { "compact", no_argument, 0, 'c' },                    //
+        { "time-report", optional_argument, 0, 'R' },          //
+        { "server", required_argument, 0, 'S' },               //
+        { "prefix-snapshot", required_argument, 0, 'P' },      //
+        { "save-prefix-snapshot", required_argument, 0, 's' }, //
+        {},                                                    //
     };
 
     int opt;
@@ -138,11 +166,35 @@ int parse_args(int argc, char *argv[], Args *args)
         case 'a':
             args->format = FORMAT_AST;
             break;
+        case 'c':
+            args->compact = 1;
+            break;
+        case 'R':
+            if (!phase_parse_format(optarg, &args->report_format)) {
+                fprintf(stderr, "Error: Unknown --time-report format '%s'\n", optarg);
+                return -1;
+            }
+            args->time_report = 1;
+            break;
+        case 'S':
+            args->server = optarg;
+            break;
+        case 'P':
+            args->prefix = optarg;
+            break;
+        case 's':
+            args->save = optarg;
+            break;
         case '?': // Unknown option
             return -1;
         }
     }
 
+    // A server takes its files from each request.
+    if (args->server) {
+        return 0;
+    }
+
     // Check for input filename (required)
     if (optind < argc) {
         args->input_file = argv[optind++];
@@ -165,6 +217,22 @@ int parse_args(int argc, char *argv[], Args *args)
     return 0;
 }
 
+//
+// Put the declarations of a prefix snapshot before those parsed after it.
+//
+static void prepend_prefix(Program *program, ExternalDecl *prefix)
+{
+    if (!prefix) {
+        return;
+    }
+    ExternalDecl *last = prefix;
+    while (last->next) {
+        last = last->next;
+    }
+    last->next     = program->decls;
+    program->decls = prefix;
+}
+
 //
 // Main processing function
 //
@@ -181,43 +249,104 @@ void process_file(const Args *args)
         export_debug = 1;
         wio_debug    = 1;
     }
-    FILE *input_file = fopen(args->input_file, "r");
+    FILE *input_file = stdin;
+    if (strcmp(args->input_file, "-") != 0) {
+        input_file = fopen(args->input_file, "r");
+    }
     if (!input_file) {
         perror(args->input_file);
         exit(1);
     }
-    Program *program = parse(input_file);
-    fclose(input_file);
-
     FILE *output_file = stdout;
     if (args->output_file[0] != '-') {
         output_file = fopen(args->output_file, "w");
     }
 
+    // A server parses one file after another: each starts at line 1 of no file.
+    scanner_lineno      = 1;
+    scanner_filename[0] = '\0';
+
+    // Declarations of the prefix snapshot the input begins with, if any.
+    ExternalDecl *prefix = NULL;
+    if (args->prefix) {
+        phase_begin("prefix");
+        bool resumed = prefix_load(args->prefix, input_file, &prefix);
+        phase_end();
+        if (args->verbose) {
+            printf("%s prefix snapshot %s\n", resumed ? "Resuming after" : "Not using",
+                   args->prefix);
+        }
+    }
+
+    Program *program;
     switch (args->format) {
     default:
     case FORMAT_AST:
         if (args->verbose) {
             printf("Emitting AST in binary format to %s\n", args->output_file);
         }
-        if (args->debug) {
-            print_program(stdout, program);
+        {
+            // Pass each external declaration on as soon as it is parsed, so that
+            // `parse | lower` overlaps: lower translates while we scan the rest.
+            WFILE out;
+            program             = new_program();
+            program->decls      = prefix;
+            ExternalDecl **tail = &program->decls;
+            ast_export_open(&out, fileno(output_file), args->compact);
+            for (; *tail; tail = &(*tail)->next) {
+                export_external_decl(&out, *tail);
+            }
+            parse_begin(input_file);
+            for (;;) {
+                phase_begin("parse");
+                ExternalDecl *decl = parse_next();
+                phase_end();
+                if (!decl)
+                    break;
+                *tail = decl;
+                tail  = &decl->next;
+                if (args->debug) {
+                    print_external_decl(stdout, decl, 0);
+                }
+                phase_begin("export");
+                export_external_decl(&out, decl);
+                wflush(&out);
+                phase_end();
+            }
+            ast_export_close(&out);
         }
-        export_ast(fileno(output_file), program);
         break;
     case FORMAT_YAML:
+        phase_begin("parse");
+        program = parse(input_file);
+        phase_end();
+        prepend_prefix(program, prefix);
         if (args->verbose) {
             printf("Emitting YAML format to %s\n", args->output_file);
         }
+        phase_begin("export");
         export_yaml(output_file, program);
+        phase_end();
         break;
     case FORMAT_DOT:
+        phase_begin("parse");
+        program = parse(input_file);
+        phase_end();
+        prepend_prefix(program, prefix);
         if (args->verbose) {
             printf("Emitting Graphviz DOT script to %s\n", args->output_file);
         }
+        phase_begin("export");
         export_dot(output_file, program);
+        phase_end();
         break;
     }
+    if (args->save) {
+        prefix_save(args->save, input_file, program);
+    }
+    if (input_file != stdin) {
+        fclose(input_file);
+    }
 
     if (output_file != stdout) {
         fclose(output_file);
@@ -266,8 +395,21 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    if (args.server) {
+        // Run the requests of compile clients until stopped; see server.h.
+        return server_run(args.server, main);
+    }
+
+    if (args.time_report) {
+        phase_enable();
+    }
+
     // Pass args to backend for processing
     process_file(&args);
 
+    if (args.time_report) {
+        phase_report(stderr, "parse", args.report_format);
+    }
+
     return 0;
 }
@@ -47,6 +47,15 @@ void nametab_purge(int level)
     map_remove_level(&nametab, level);
 }
 
+//
+// Call func for each name, in ascending order, with its value.
+//
+void nametab_iterate(void (*func)(const char *name, intptr_t value, const void *arg),
+                     const void *arg)
+{
+    map_iterate(&nametab, func, arg);
+}
+
 //
 // Deallocate the symbol table.
 //
@@ -6,6 +6,7 @@
 
 #include "internal.h"
 #include "parser_internal.h"
+#include "phase.h"
 #include "scanner.h"
 #include "xalloc.h"
 
@@ -55,13 +56,23 @@ static int token_translation(int token)
 }
 
 /* Token handling */
+
+// Read the next token from the scanner; the time it takes is the "scan" phase.
+static int scan_token()
+{
+    phase_begin("scan");
+    int token = token_translation(yylex());
+    phase_end();
+    return token;
+}
+
 void advance_token()
 {
     if (peek_token > 0) {
         current_token = peek_token;
         peek_token    = 0;
     } else {
-        current_token = token_translation(yylex());
+        current_token = scan_token();
     }
     current_lexeme = get_yytext();
 }
@@ -89,7 +100,7 @@ int next_token()
             strcpy(lexeme_buffer, current_lexeme);
             current_lexeme = lexeme_buffer;
         }
-        peek_token = token_translation(yylex());
+        peek_token = scan_token();
     }
     return peek_token;
 }
@@ -257,3 +268,22 @@ Program *parse(FILE *input)
     }
     return program;
 }
+
+//
+// Parse one external declaration at a time, so that a caller can pass each one on
+// before the rest of the file is scanned: parse_begin(), then parse_next() until it
+// returns NULL at end of file.
+//
+void parse_begin(FILE *input)
+{
+    init_scanner(input);
+    advance_token();
+}
+
+ExternalDecl *parse_next(void)
+{
+    if (current_token == TOKEN_EOF) {
+        return NULL;
+    }
+    return parse_external_declaration();
+}
@@ -22,6 +22,8 @@ extern int wio_debug;
 // Parse
 //
 Program *parse(FILE *input);
+void parse_begin(FILE *input);
+ExternalDecl *parse_next(void);
 Declarator *parse_declarator(void);
 int parser_get_token(void);
 const char *parser_get_lexeme(void);
@@ -44,6 +46,18 @@ void nametab_define(const char *name, int token, int level);
 void nametab_remove(const char *name);
 void nametab_purge(int level);
 void nametab_destroy(void);
+void nametab_iterate(void (*func)(const char *name, intptr_t value, const void *arg),
+                     const void *arg);
+
+//
+// Prefix snapshots (prefix.c).  prefix_save() records the declarations and the name table
+// of a whole parsed input; prefix_load() checks that `input` begins with the same lines
+// and, if so, restores them into the name table and *decls and leaves `input` and the
+// scanner location after the prefix, for parse() to go on from there.  When it does not,
+// prefix_load() returns false with `input` rewound and nothing changed.
+//
+void prefix_save(const char *path, FILE *input, const Program *program);
+bool prefix_load(const char *path, FILE *input, ExternalDecl **decls);
 
 #ifdef GTEST_API_
 void advance_token(void);
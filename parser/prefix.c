@@ -0,0 +1,191 @@
+//
+// Prefix snapshots: the declarations and the name table left by parsing a common prefix of
+// many inputs, typically the preprocessed standard headers, so that a later parse of an
+// input that begins with the same prefix resumes after it instead of scanning it again.
+//
+// A prefix is a number of lines.  Line markers (`# 12 "file.h" 1`) and null directives
+// are skipped when lines are counted and digested: they only set the location for error
+// messages, and the preprocessor names the main file in them, which differs from input to
+// input.  The other lines must match byte for byte, newline included.  Since the prefix
+// was parsed to its end as a whole file, it ends between two external declarations, and
+// the parser, which keeps nothing between declarations but the name table, may continue
+// from the first line after it.
+//
+// File layout (wio words):
+//
+//      PREFIX_MAGIC, lines, digest,
+//      names: { name, token }..., "",
+//      declarations: count, ExternalDecl...
+//
+// The digest is keyed by the parse executable (see cache.h), so a rebuilt parser ignores
+// the snapshots of the old one.
+//
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cache.h"
+#include "parser.h"
+#include "scanner.h"
+#include "wio.h"
+#include "xalloc.h"
+
+#define PREFIX_MAGIC 0x70726678 // 'prfx'
+
+//
+// Is this line a line marker or a null directive, which the scanner takes as location?
+//
+static bool is_line_marker(const char *line)
+{
+    if (line[0] != '#')
+        return false;
+    const char *p = line + 1;
+    while (*p == ' ' || *p == '\t')
+        p++;
+    return isdigit((unsigned char)*p) || *p == '\n' || *p == '\0';
+}
+
+//
+// Set the location from a line marker, as scan_line_marker() does: the name is kept as
+// spelled, quotes included, and the newline that ends the marker starts the line it names.
+//
+static void track_marker(const char *line)
+{
+    int lineno;
+    const char *open  = strchr(line, '"');
+    const char *close = open ? strchr(open + 1, '"') : NULL;
+    if (!close || sscanf(line, "# %d", &lineno) != 1)
+        return;
+    size_t len = (size_t)(close - open + 1);
+    if (len > sizeof(scanner_filename) - 1)
+        len = sizeof(scanner_filename) - 1;
+    memcpy(scanner_filename, open, len);
+    scanner_filename[len] = '\0';
+    scanner_lineno        = lineno - 1;
+}
+
+//
+// Digest the first `max_lines` lines of `input` from its start, markers excluded, or all
+// of it when max_lines is 0.  Set *lines to the number digested.  When `track` is set,
+// follow the markers and count the newlines as the scanner would, so that it may resume
+// from where this stops.
+//
+static uint64_t digest_lines(FILE *input, size_t max_lines, size_t *lines, bool track)
+{
+    CacheKey key;
+    cache_key_init(&key, "parse-prefix");
+    *lines = 0;
+
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    while ((max_lines == 0 || *lines < max_lines) && (len = getline(&line, &cap, input)) > 0) {
+        bool marker = is_line_marker(line);
+        if (track) {
+            if (marker)
+                track_marker(line);
+            if (line[len - 1] == '\n')
+                scanner_lineno++;
+        }
+        if (marker)
+            continue;
+        cache_key_add(&key, line, (size_t)len);
+        ++*lines;
+    }
+    free(line);
+    return key.hash;
+}
+
+static void put_name(const char *name, intptr_t token, const void *arg)
+{
+    WFILE *out = (WFILE *)arg;
+    wputstr(name, out);
+    wputw((size_t)token, out);
+}
+
+void prefix_save(const char *path, FILE *input, const Program *program)
+{
+    if (fseek(input, 0, SEEK_SET) < 0) {
+        fprintf(stderr, "Error: a prefix snapshot needs a file to read, not a pipe\n");
+        exit(1);
+    }
+    size_t lines;
+    uint64_t digest = digest_lines(input, 0, &lines, false);
+
+    // Written beside the snapshot and renamed into place, so no parse reads half of one.
+    size_t tmp_len = strlen(path) + 5;
+    char *tmp_path = xalloc(tmp_len, __func__, __FILE__, __LINE__);
+    snprintf(tmp_path, tmp_len, "%s.tmp", path);
+    WFILE out;
+    if (wopen(&out, tmp_path, "w") < 0) {
+        perror(tmp_path);
+        exit(1);
+    }
+    wputw(PREFIX_MAGIC, &out);
+    wputw(lines, &out);
+    wputw(digest, &out);
+    nametab_iterate(put_name, &out);
+    wputstr("", &out);
+
+    size_t count = 0;
+    for (const ExternalDecl *decl = program->decls; decl; decl = decl->next)
+        count++;
+    wputw(count, &out);
+    for (ExternalDecl *decl = program->decls; decl; decl = decl->next)
+        export_external_decl(&out, decl);
+
+    bool ok = wflush(&out) == 0 && !werror(&out);
+    wclose(&out);
+    if (!ok || rename(tmp_path, path) < 0) {
+        perror(path);
+        unlink(tmp_path);
+        exit(1);
+    }
+    xfree(tmp_path);
+}
+
+bool prefix_load(const char *path, FILE *input, ExternalDecl **decls)
+{
+    *decls = NULL;
+    WFILE in;
+    if (wopen(&in, path, "r") < 0)
+        return false;
+    size_t magic  = wgetw(&in);
+    size_t lines  = wgetw(&in);
+    size_t digest = wgetw(&in);
+    if (weof(&in) || werror(&in) || magic != PREFIX_MAGIC || fseek(input, 0, SEEK_SET) < 0) {
+        wclose(&in);
+        return false;
+    }
+
+    // Compare the input with the prefix; keep the location the scanner would have had.
+    int lineno = scanner_lineno;
+    char filename[sizeof(scanner_filename)];
+    strcpy(filename, scanner_filename);
+    size_t matched;
+    if (digest_lines(input, lines, &matched, true) != digest || matched != lines) {
+        scanner_lineno = lineno;
+        strcpy(scanner_filename, filename);
+        rewind(input);
+        wclose(&in);
+        return false;
+    }
+
+    const char *name;
+    while ((name = wgetstr_tmp(&in)) != NULL)
+        nametab_define(name, (int)wgetw(&in), 0);
+    ExternalDecl **tail = decls;
+    for (size_t n = wgetw(&in); n > 0; n--) {
+        *tail = weof(&in) ? NULL : import_external_decl(&in);
+        if (!*tail) {
+            fprintf(stderr, "Error: %s: corrupt prefix snapshot\n", path);
+            exit(1);
+        }
+        tail = &(*tail)->next;
+    }
+    wclose(&in);
+    return true;
+}
@@ -0,0 +1,142 @@
+//
+// Tests for prefix snapshots: an input parsed after the snapshot of a prefix it begins
+// with gives the same program as when it is parsed whole.
+//
+#include <unistd.h>
+
+#include <string>
+
+#include "fixture.h"
+
+static const char header[] = "typedef unsigned long size_t;\n"
+                             "enum color { RED, GREEN };\n"
+                             "struct pair { size_t a, b; };\n"
+                             "int lookup(enum color c);\n";
+
+class PrefixTest : public ParserTest {
+protected:
+    char snapshot[32];
+    char header_path[32];
+    char input_path[32];
+
+    // A fresh temporary name in `path`, so that parallel test runs do not share files.
+    static void TempName(char *path, size_t size, const char *pattern)
+    {
+        strncpy(path, pattern, size);
+        int fd = mkstemp(path);
+        close(fd);
+        unlink(path);
+    }
+
+    void SetUp() override
+    {
+        ParserTest::SetUp();
+        TempName(snapshot, sizeof(snapshot), "/tmp/prefix_XXXXXX");
+        TempName(header_path, sizeof(header_path), "/tmp/prefix_header_XXXXXX");
+        TempName(input_path, sizeof(input_path), "/tmp/prefix_input_XXXXXX");
+    }
+
+    void TearDown() override
+    {
+        unlink(snapshot);
+        unlink(header_path);
+        unlink(input_path);
+        ParserTest::TearDown();
+    }
+
+    static FILE *WriteFile(const char *name, const std::string &text)
+    {
+        FILE *f = fopen(name, "w+");
+        fputs(text.c_str(), f);
+        rewind(f);
+        return f;
+    }
+
+    void SaveHeader(const std::string &text)
+    {
+        FILE *f    = WriteFile(header_path, text);
+        Program *p = parse(f);
+        prefix_save(snapshot, f, p);
+        fclose(f);
+        free_program(p);
+        nametab_destroy();
+    }
+
+    // Parse `text` after the snapshot, when it applies, into `program`; check that the
+    // result is the same as a parse of the whole text.  Return whether it applied.
+    bool ParseAfterPrefix(const std::string &text)
+    {
+        FILE *f              = WriteFile(input_path, text);
+        ExternalDecl *prefix = nullptr;
+        bool resumed         = prefix_load(snapshot, f, &prefix);
+        if (!resumed) {
+            EXPECT_EQ(ftell(f), 0);
+        }
+        program = parse(f);
+        if (prefix) {
+            ExternalDecl *last = prefix;
+            while (last->next)
+                last = last->next;
+            last->next     = program->decls;
+            program->decls = prefix;
+        }
+        nametab_destroy();
+
+        rewind(f);
+        Program *whole = parse(f);
+        fclose(f);
+        EXPECT_TRUE(compare_program(program, whole));
+        free_program(whole);
+        return resumed;
+    }
+};
+
+TEST_F(PrefixTest, ResumesAfterPrefix)
+{
+    SaveHeader(header);
+
+    // size_t is known as a typedef name only from the snapshot.
+    EXPECT_TRUE(ParseAfterPrefix(std::string(header) +
+                                 "size_t area(struct pair *p) { return p->a * p->b; }\n"
+                                 "int green(void) { return lookup(GREEN); }\n"));
+    int count = 0;
+    for (ExternalDecl *decl = program->decls; decl; decl = decl->next)
+        count++;
+    EXPECT_EQ(count, 6);
+}
+
+TEST_F(PrefixTest, LineMarkersAreNotCompared)
+{
+    SaveHeader(std::string("# 1 \"header.c\"\n# 1 \"types.h\" 1\n") + header +
+               "# 2 \"header.c\" 2\n");
+    EXPECT_TRUE(ParseAfterPrefix(std::string("# 1 \"main.c\"\n# 1 \"types.h\" 1\n") + header +
+                                 "# 2 \"main.c\" 2\n"
+                                 "size_t zero(void) { return 0; }\n"));
+}
+
+TEST_F(PrefixTest, LocationFollowsMarkersOfInput)
+{
+    SaveHeader(header);
+    FILE *f = WriteFile(input_path, std::string("# 1 \"main.c\"\n# 5 \"types.h\" 1\n") + header);
+    ExternalDecl *prefix = nullptr;
+    EXPECT_TRUE(prefix_load(snapshot, f, &prefix));
+    fclose(f);
+    EXPECT_STREQ(scanner_filename, "\"types.h\"");
+    EXPECT_EQ(scanner_lineno, 9); // the line after the four of the header
+
+    program        = new_program();
+    program->decls = prefix;
+}
+
+TEST_F(PrefixTest, DifferentPrefixIsNotUsed)
+{
+    SaveHeader(header);
+    std::string edited = header;
+    edited.replace(edited.find("GREEN"), 5, "BLUE");
+    EXPECT_FALSE(ParseAfterPrefix(edited + "int blue(void) { return lookup(BLUE); }\n"));
+
+    // Nor is it when the input is shorter than the prefix.
+    free_program(program);
+    nametab_destroy();
+    EXPECT_FALSE(ParseAfterPrefix("typedef unsigned long size_t;\n"));
+}
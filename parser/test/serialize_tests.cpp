@@ -1,4 +1,7 @@
+#include <string>
+
 #include "fixture.h"
+#include "wio.h"
 
 TEST_F(ParserTest, ExportEmptyProgram)
 {
@@ -6,6 +9,7 @@ TEST_F(ParserTest, ExportEmptyProgram)
 
     int fd = CreateAstFile();
     export_ast(fd, program);
+    lseek(fd, 0, SEEK_SET); // import reads forward from the current position
 
     Program *deserialized = import_ast(fd);
     EXPECT_TRUE(compare_program(program, deserialized));
@@ -21,6 +25,7 @@ TEST_F(ParserTest, ExportSimpleFunction)
 
     int fd = CreateAstFile();
     export_ast(fd, program);
+    lseek(fd, 0, SEEK_SET);
 
     Program *deserialized = import_ast(fd);
     print_program(stdout, deserialized);
@@ -29,6 +34,70 @@ TEST_F(ParserTest, ExportSimpleFunction)
     free_program(deserialized);
 }
 
+TEST_F(ParserTest, ExportCompact)
+{
+    program = parse(CreateTempFile("int count(int n) { int k = -1; while (n > 0) { n = n / 2; "
+                                   "k = k + 1; } return k; }"));
+    ASSERT_NE(nullptr, program);
+
+    int fd = CreateAstFile();
+    WFILE out;
+    ast_export_open(&out, fd, true);
+    for (ExternalDecl *decl = program->decls; decl; decl = decl->next) {
+        export_external_decl(&out, decl);
+    }
+    ast_export_close(&out);
+    lseek(fd, 0, SEEK_SET);
+
+    Program *deserialized = import_ast(fd);
+    EXPECT_TRUE(compare_program(program, deserialized));
+    close(fd);
+    free_program(deserialized);
+}
+
+// Import reads forward only, so the AST may come through a pipe.
+TEST_F(ParserTest, ImportFromPipe)
+{
+    program = parse(CreateTempFile("int g; int main() { return g; }"));
+    ASSERT_NE(nullptr, program);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    export_ast(fds[1], program);
+    close(fds[1]);
+
+    Program *deserialized = import_ast(fds[0]);
+    EXPECT_TRUE(compare_program(program, deserialized));
+    close(fds[0]);
+    free_program(deserialized);
+}
+
+// A long chain of additions nests 100000 levels deep on the left: clone, compare, export,
+// import and free must all get through it without running out of stack.
+TEST_F(ParserTest, DeepExpressionRoundTrip)
+{
+    std::string source = "int f(int a) { return a";
+    for (int i = 0; i < 100000; i++)
+        source += " + a";
+    source += "; }";
+    program = parse(CreateTempFile(source.c_str()));
+    ASSERT_NE(nullptr, program);
+
+    Expr *body = program->decls->u.function.body->u.compound->u.stmt->u.expr;
+    Expr *copy = clone_expression(body);
+    EXPECT_TRUE(compare_expr(body, copy));
+    free_expression(copy);
+
+    int fd = CreateAstFile();
+    export_ast(fd, program);
+    lseek(fd, 0, SEEK_SET);
+
+    Program *deserialized = import_ast(fd);
+    EXPECT_TRUE(compare_program(program, deserialized));
+    close(fd);
+    free_program(deserialized);
+}
+
 #if 0
 TEST_F(ParserTest, ExportComplexType)
 {
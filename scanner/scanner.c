@@ -26,7 +26,7 @@ static int scan_operator(void);
 static void scan_line_marker(void);
 
 // Current location in input file
-int scanner_lineno;
+int scanner_lineno = 1;
 char scanner_filename[1024];
 
 // Initialize scanner with input file
@@ -121,6 +121,8 @@ again:
 // Consume a character and add to yytext
 static void consume_char(void)
 {
+    if (next_char == '\n')
+        scanner_lineno++;
     if (yyleng < (int)(sizeof(yytext) - 1)) {
         yytext[yyleng++] = next_char;
         yytext[yyleng]   = '\0';
@@ -299,8 +301,8 @@ static void scan_line_marker()
         yyleng = 0;
         scan_string();
 
-        // Store in current_location
-        scanner_lineno = line_num;
+        // Store in current_location: the newline that ends the marker starts line_num.
+        scanner_lineno = line_num - 1;
         strncpy(scanner_filename, yytext, sizeof(scanner_filename) - 1);
         scanner_filename[sizeof(scanner_filename) - 1] = '\0';
     }
@@ -299,3 +299,22 @@ int main() {
 
     EXPECT_EQ(GetNextToken(), TOKEN_EOF);
 }
+
+// Lines after a marker are counted from the line it names
+TEST_F(ScannerTest, CountsLinesAfterMarker)
+{
+    SetInput(R"(# 7 "main.c"
+int
+/* two
+   lines */ x
+// comment
+;
+)");
+    EXPECT_EQ(GetNextToken(), TOKEN_INT);
+    EXPECT_EQ(scanner_lineno, 7);
+    EXPECT_EQ(GetNextToken(), TOKEN_IDENTIFIER);
+    EXPECT_EQ(scanner_lineno, 9);
+    EXPECT_EQ(GetNextToken(), TOKEN_SEMICOLON);
+    EXPECT_EQ(scanner_lineno, 11);
+    EXPECT_STREQ(scanner_filename, "\"main.c\"");
+}
@@ -208,6 +208,16 @@ static void register_enum_constants(const Type *enum_type)
 static int anon_struct_counter = 0;
 static void register_inline_struct_defs(const Type *t);
 
+int typecheck_anon_seq(void)
+{
+    return anon_struct_counter;
+}
+
+void typecheck_set_anon_seq(int seq)
+{
+    anon_struct_counter = seq;
+}
+
 // Reject a struct/union tag reference whose keyword disagrees with an existing tag of the
 // same name (C11 §6.7.2.3): e.g. using `union x` where `struct x` is already in scope.
 void check_tag_kind(const Type *t)
@@ -30,6 +30,21 @@ void label_loops(const ExternalDecl *ast, int *seq);
 // Validate labeled statements and goto targets within a function.
 void resolve_labels(const ExternalDecl *ast);
 
+// Anonymous structs and unions named so far (`__anon_N`); the names appear in the TAC.
+int typecheck_anon_seq(void);
+void typecheck_set_anon_seq(int seq);
+
+// The file-scope state of the symbol, struct and typedef tables and the counters typecheck
+// keeps with them, saved between two external declarations and restored into empty tables
+// (defined in snapshot.c).  semantic_load_tables() returns false on a truncated stream.
+void semantic_save_tables(WFILE *out);
+bool semantic_load_tables(WFILE *in);
+
+// Lookups in the symbol, struct and typedef tables, reported by name when the hook is
+// set: what a declaration depends on, for lower --incremental.
+typedef enum { LOOKUP_SYMBOL, LOOKUP_STRUCT, LOOKUP_TYPEDEF } LookupTable;
+extern void (*semantic_lookup_hook)(LookupTable table, const char *name);
+
 // Error handling.
 #ifdef __cplusplus
 [[noreturn]]
@@ -0,0 +1,198 @@
+//
+// The symbol, struct and typedef tables as a word stream, for the prefix snapshots of
+// lower (see translator/snapshot.h).  Only file-scope state is saved: the tables are
+// written between two external declarations, when every deeper scope has been purged.
+//
+// Layout (wio words):
+//
+//      string counter, anonymous struct counter,
+//      symbols:      { name, kind, linkage | block_scope << 1, type, by kind... }..., "",
+//      structs:      { tag, kind, complete, alignment, size, { name, offset, type }..., "" }...,
+//                    "",
+//      typedefs:     { name, level, type }..., "",
+//      static locals, oldest first: { function, source, name }..., ""
+//
+// A static local keeps only its names: its type and initializer went into the TAC of its
+// function, and what is left of it names the later statics of the same source name.
+//
+#include <stdint.h>
+
+#include "semantic.h"
+#include "string_map.h"
+#include "structtab.h"
+#include "symtab.h"
+#include "typetab.h"
+#include "wio.h"
+#include "xalloc.h"
+
+extern StringMap symtab;
+extern StringMap structtab;
+extern StringMap typetab;
+
+static void put_symbol(const char *name, intptr_t value, const void *arg)
+{
+    WFILE *out        = (WFILE *)arg;
+    const Symbol *sym = (const Symbol *)value;
+    wputstr(name, out);
+    wputw(sym->kind, out);
+    wputw(sym->has_linkage | sym->block_scope << 1, out);
+    ast_export_type(out, sym->type);
+    switch (sym->kind) {
+    case SYM_FUNC:
+        wputw(sym->u.func.defined | sym->u.func.global << 1 | sym->u.func.noret << 2, out);
+        break;
+    case SYM_STATIC:
+        wputw(sym->u.static_var.global, out);
+        wputw(sym->u.static_var.init_kind, out);
+        tac_export_static_init(out, sym->u.static_var.init_list);
+        break;
+    case SYM_CONST:
+        tac_export_static_init(out, sym->u.const_init);
+        break;
+    case SYM_ENUM:
+        wputi(sym->u.enum_val, out);
+        break;
+    default:
+        break;
+    }
+}
+
+static void put_struct(const char *tag, intptr_t value, const void *arg)
+{
+    WFILE *out           = (WFILE *)arg;
+    const StructDef *def = (const StructDef *)value;
+    wputstr(tag, out);
+    wputw(def->kind, out);
+    wputw(def->complete, out);
+    wputi(def->alignment, out);
+    wputi(def->size, out);
+    for (const FieldDef *f = def->members; f; f = f->next) {
+        wputstr(f->name, out);
+        wputi(f->offset, out);
+        ast_export_type(out, f->type);
+    }
+    wputstr("", out);
+}
+
+static void put_typedef(const char *name, intptr_t value, const void *arg)
+{
+    WFILE *out         = (WFILE *)arg;
+    const TypeDef *def = (const TypeDef *)value;
+    wputstr(name, out);
+    wputi(def->level, out);
+    ast_export_type(out, def->type);
+}
+
+//
+// The static locals from the oldest: the list keeps the newest first.
+//
+static void put_static_locals(WFILE *out, const StaticLocalRec *r)
+{
+    if (!r)
+        return;
+    put_static_locals(out, r->next);
+    wputstr(r->func, out);
+    wputstr(r->source, out);
+    wputstr(r->name, out);
+}
+
+void semantic_save_tables(WFILE *out)
+{
+    wputw(symtab_string_seq(), out);
+    wputw(typecheck_anon_seq(), out);
+    map_iterate(&symtab, put_symbol, out);
+    wputstr("", out);
+    map_iterate(&structtab, put_struct, out);
+    wputstr("", out);
+    map_iterate(&typetab, put_typedef, out);
+    wputstr("", out);
+    put_static_locals(out, static_locals_head());
+    wputstr("", out);
+}
+
+static void get_symbol(WFILE *in, char *name)
+{
+    SymbolKind kind = (SymbolKind)wgetw(in);
+    size_t flags    = wgetw(in);
+    Symbol *sym     = new_symbol(name, import_type(in), kind);
+
+    sym->has_linkage = flags & 1;
+    sym->block_scope = (flags >> 1) & 1;
+    switch (kind) {
+    case SYM_FUNC:
+        flags               = wgetw(in);
+        sym->u.func.defined = flags & 1;
+        sym->u.func.global  = (flags >> 1) & 1;
+        sym->u.func.noret   = (flags >> 2) & 1;
+        break;
+    case SYM_STATIC:
+        sym->u.static_var.global    = wgetw(in);
+        sym->u.static_var.init_kind = (InitKind)wgetw(in);
+        sym->u.static_var.init_list = tac_import_static_init(in);
+        break;
+    case SYM_CONST:
+        sym->u.const_init = tac_import_static_init(in);
+        break;
+    case SYM_ENUM:
+        sym->u.enum_val = (int)wgeti(in);
+        break;
+    default:
+        break;
+    }
+    symtab_restore(sym);
+}
+
+static void get_struct(WFILE *in, char *tag)
+{
+    TypeKind kind     = (TypeKind)wgetw(in);
+    bool complete     = wgetw(in);
+    int alignment     = (int)wgeti(in);
+    int size          = (int)wgeti(in);
+    FieldDef *members = NULL;
+    FieldDef **tail   = &members;
+    char *name;
+    while ((name = wgetstr(in)) != NULL) {
+        int offset = (int)wgeti(in);
+        *tail      = new_member(name, import_type(in), offset);
+        tail       = &(*tail)->next;
+        xfree(name);
+    }
+    structtab_add_struct(tag, kind, complete, alignment, size, members, 0);
+}
+
+static void get_typedef(WFILE *in, char *name)
+{
+    int level  = (int)wgeti(in);
+    Type *type = import_type(in);
+    typetab_add(name, type, level);
+    free_type(type);
+}
+
+bool semantic_load_tables(WFILE *in)
+{
+    symtab_set_string_seq((int)wgetw(in));
+    typecheck_set_anon_seq((int)wgetw(in));
+
+    char *name;
+    while ((name = wgetstr(in)) != NULL) {
+        get_symbol(in, name);
+        xfree(name);
+    }
+    while ((name = wgetstr(in)) != NULL) {
+        get_struct(in, name);
+        xfree(name);
+    }
+    while ((name = wgetstr(in)) != NULL) {
+        get_typedef(in, name);
+        xfree(name);
+    }
+    while ((name = wgetstr(in)) != NULL) {
+        char *source  = wgetstr(in);
+        char *backend = wgetstr(in);
+        static_locals_restore(name, source, backend);
+        xfree(name);
+        xfree(source);
+        xfree(backend);
+    }
+    return !werror(in) && !weof(in);
+}
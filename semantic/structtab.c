@@ -102,6 +102,8 @@ void structtab_add_struct(const char *tag, TypeKind kind, bool complete, int ali
 //
 bool structtab_exists(const char *tag)
 {
+    if (semantic_lookup_hook)
+        semantic_lookup_hook(LOOKUP_STRUCT, tag);
     intptr_t value = 0;
     if (!map_get(&structtab, tag, &value)) {
         return false;
@@ -116,6 +118,8 @@ bool structtab_exists(const char *tag)
 //
 StructDef *structtab_find(const char *tag)
 {
+    if (semantic_lookup_hook)
+        semantic_lookup_hook(LOOKUP_STRUCT, tag);
     intptr_t value = 0;
     if (!map_get(&structtab, tag, &value)) {
         fatal_error("Struct or union '%s' not found", tag);
@@ -125,6 +129,8 @@ StructDef *structtab_find(const char *tag)
 
 StructDef *structtab_find_opt(const char *tag)
 {
+    if (semantic_lookup_hook)
+        semantic_lookup_hook(LOOKUP_STRUCT, tag);
     intptr_t value = 0;
     if (!map_get(&structtab, tag, &value)) {
         return NULL;
@@ -182,6 +182,16 @@ StaticLocalRec *static_locals_head(void)
     return static_locals_list;
 }
 
+void static_locals_restore(const char *func, const char *source, const char *name)
+{
+    StaticLocalRec *rec = xalloc(sizeof(StaticLocalRec), __func__, __FILE__, __LINE__);
+    rec->func           = xstrdup(func);
+    rec->source         = xstrdup(source);
+    rec->name           = xstrdup(name);
+    rec->next           = static_locals_list;
+    static_locals_list  = rec;
+}
+
 static void static_locals_clear(void)
 {
     StaticLocalRec *r = static_locals_list;
@@ -256,6 +266,16 @@ char *symtab_add_string(const char *s, size_t len)
     return ret;
 }
 
+int symtab_string_seq(void)
+{
+    return str_id;
+}
+
+void symtab_set_string_seq(int seq)
+{
+    str_id = seq;
+}
+
 //
 // Add an enum constant
 // Precondition: name is a non-null string.
@@ -269,6 +289,14 @@ void symtab_add_enum_const(const char *ident, int val, int level)
     map_insert_free(&symtab, ident, (intptr_t)sym, level, symtab_destroy_callback);
 }
 
+//
+// Add a file-scope symbol as it was saved (semantic/snapshot.c).
+//
+void symtab_restore(Symbol *sym)
+{
+    map_insert_free(&symtab, sym->name, (intptr_t)sym, 0, symtab_destroy_callback);
+}
+
 //
 // Get a symbol by name (fails if not found)
 // Precondition: name is a non-null string.
@@ -290,6 +318,8 @@ Symbol *symtab_get(const char *name)
 //
 Symbol *symtab_get_opt(const char *name)
 {
+    if (semantic_lookup_hook)
+        semantic_lookup_hook(LOOKUP_SYMBOL, name);
     intptr_t value = 0;
     if (!map_get(&symtab, name, &value)) {
         return NULL;
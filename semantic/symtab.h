@@ -109,6 +109,8 @@ void static_locals_set_function(const char *fn);
 const char *static_locals_add(const char *source, const Type *type, Tac_StaticInit *init);
 // Head of the captured-static-local list (the translator iterates and filters by ->func).
 StaticLocalRec *static_locals_head(void);
+// Add the names of a static local already translated, as a prefix snapshot saved them.
+void static_locals_restore(const char *func, const char *source, const char *name);
 
 // Add a function
 void symtab_add_fun(const char *name, const Type *t, bool global, bool defined, bool noret);
@@ -118,11 +120,19 @@ void symtab_add_fun(const char *name, const Type *t, bool global, bool defined,
 // Add a string literal: len decoded bytes, which may include embedded NULs.
 char *symtab_add_string(const char *s, size_t len);
 
+// The counter that numbers string literals (`_strN`) across the unit.  A driver that
+// replays a declaration's cached TAC instead of translating it advances it by hand.
+int symtab_string_seq(void);
+void symtab_set_string_seq(int seq);
+
 // Add an enum constant
 void symtab_add_enum_const(const char *ident, int val, int level);
 // Precondition: name is a non-null string.
 // Postcondition: A Symbol with SYM_ENUM, name, type int, and integer value is added.
 
+// Add a file-scope symbol read back from a prefix snapshot; the table takes it over.
+void symtab_restore(Symbol *sym);
+
 // Get a symbol by name (fails if not found)
 Symbol *symtab_get(const char *name);
 // Precondition: name is a non-null string.
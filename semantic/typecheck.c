@@ -19,6 +19,9 @@
 // Enable debug output
 int semantic_debug;
 
+// Report table lookups (see semantic.h).
+void (*semantic_lookup_hook)(LookupTable table, const char *name);
+
 // Level of scope for nested compound operators.
 int scope_level;
 
@@ -67,6 +67,8 @@ void typetab_add(const char *ident, const Type *type, int level)
 //
 bool typetab_exists(const char *name)
 {
+    if (semantic_lookup_hook)
+        semantic_lookup_hook(LOOKUP_TYPEDEF, name);
     intptr_t value = 0;
     return map_get(&typetab, name, &value);
 }
@@ -78,6 +80,8 @@ bool typetab_exists(const char *name)
 //
 TypeDef *typetab_find(const char *name)
 {
+    if (semantic_lookup_hook)
+        semantic_lookup_hook(LOOKUP_TYPEDEF, name);
     intptr_t value = 0;
     if (!map_get(&typetab, name, &value)) {
         fatal_error("Typedef '%s' not found", name);
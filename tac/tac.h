@@ -133,6 +133,7 @@ typedef enum {
     TAC_INSTRUCTION_COPY_BYTE_TO_OFFSET,   // sub-word packed char member (byte read-modify-write)
     TAC_INSTRUCTION_COPY_FROM_OFFSET,
     TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET, // sub-word packed char member (byte extract)
+    TAC_INSTRUCTION_BLOCK_COPY,            // whole aggregate, word pointer to word pointer
     TAC_INSTRUCTION_JUMP,
     TAC_INSTRUCTION_JUMP_IF_ZERO,
     TAC_INSTRUCTION_JUMP_IF_NOT_ZERO,
@@ -349,18 +350,23 @@ typedef struct Tac_Instruction {
             Tac_Val *dst;
         } copy_from_offset; // also COPY_BYTE_FROM_OFFSET
         struct {
-            char *target;
+            Tac_Val *src_ptr; // word pointer to the first source word
+            Tac_Val *dst_ptr; // word pointer to the first destination word
+            int size;         // in target bytes, a whole number of words
+        } block_copy;
+        struct {
+            char *target; // Interned, see tac_intern()
         } jump;
         struct {
             Tac_Val *condition;
-            char *target;
+            char *target; // Interned
         } jump_if_zero;
         struct {
             Tac_Val *condition;
-            char *target;
+            char *target; // Interned
         } jump_if_not_zero;
         struct {
-            char *name;
+            char *name; // Interned
         } label;
         struct {
             char *fun_name;
@@ -392,7 +398,7 @@ typedef struct Tac_Val {
     Tac_ValKind kind;
     union {
         struct Tac_Const *constant;
-        char *var_name;
+        char *var_name; // Interned, see tac_intern()
     } u;
 } Tac_Val;
 
@@ -557,6 +563,15 @@ void tac_free_static_local(Tac_StaticLocal *sl);
 void tac_free_static_init(Tac_StaticInit *init);
 void tac_free_toplevel(Tac_TopLevel *toplevel);
 
+//
+// Interned names: Tac_Val var_name, label names and jump targets point into one
+// table per translation unit, so equal names compare equal by address.  The table
+// owns the strings: assign tac_intern(name), never xstrdup(), and do not free them.
+//
+char *tac_intern(const char *name);
+size_t tac_intern_count(void);
+void tac_intern_destroy(void);
+
 //
 // Print
 //
@@ -574,6 +589,7 @@ void tac_print_type(FILE *fd, const Tac_Type *type, int depth);
 void tac_print_param(FILE *fd, const Tac_Param *param, int depth);
 void tac_print_static_init(FILE *fd, const Tac_StaticInit *init, int depth);
 void tac_print_instruction(FILE *fd, const Tac_Instruction *instr, int depth);
+const char *tac_instruction_name(Tac_InstructionKind kind);
 void tac_print_toplevel(FILE *fd, const Tac_TopLevel *toplevel, int depth);
 void tac_print_program(FILE *fd, const Tac_Program *program);
 
@@ -599,15 +615,47 @@ bool tac_compare_program(const Tac_Program *a, const Tac_Program *b);
 //
 typedef struct _wfile WFILE;
 
+//
+// Entry of the optional trailing index of a TAC stream: where each toplevel starts.
+//
+typedef struct {
+    char *name;            // Toplevel name
+    Tac_TopLevelKind kind; // Function, static variable or static constant
+    size_t offset;         // Bytes from the start of the stream
+    size_t hash;           // FNV-1a of the toplevel's encoded bytes
+} Tac_IndexEntry;
+
+typedef struct {
+    size_t count;
+    Tac_IndexEntry *entries; // In stream order
+} Tac_Index;
+
+void tac_export_begin_stream(WFILE *out, bool compact, bool with_index);
 void tac_export_toplevel(WFILE *out, const Tac_TopLevel *tl);
 void tac_export_end_stream(WFILE *out);
 void tac_export_program(WFILE *out, const Tac_Program *prog);
+void tac_export_static_init(WFILE *out, const Tac_StaticInit *si);
 
 //
 // Binary import (wio stream)
 //
 Tac_TopLevel *tac_import_toplevel(WFILE *in);
 Tac_Program *tac_import_program(WFILE *in);
+Tac_StaticInit *tac_import_static_init(WFILE *in);
+
+// Pass every name the importer reads — variables, labels, functions, statics — through
+// `fn`, which returns the name to use instead (valid until its next call); NULL stops
+// renaming.  The compilation cache renumbers the temporaries of a cached function this way.
+void tac_import_set_rename(const char *(*fn)(const char *name));
+
+//
+// Random access through the trailing index.  The stream must be a seekable file, opened
+// for reading at its start.  tac_import_index() returns NULL when there is no index.
+//
+Tac_Index *tac_import_index(WFILE *in);
+const Tac_IndexEntry *tac_lookup(const Tac_Index *index, const char *name);
+Tac_TopLevel *tac_import_toplevel_at(WFILE *in, const Tac_IndexEntry *entry);
+void tac_free_index(Tac_Index *index);
 
 //
 // YAML export
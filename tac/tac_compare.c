@@ -48,13 +48,9 @@ bool tac_compare_const(const Tac_Const *a, const Tac_Const *b)
     return false;
 }
 
-// Compare two Tac_Val structures recursively
-bool tac_compare_val(const Tac_Val *a, const Tac_Val *b)
+// Compare one Tac_Val node, ignoring the rest of the list
+static bool compare_val_node(const Tac_Val *a, const Tac_Val *b)
 {
-    if (a == b)
-        return true;
-    if (!a || !b)
-        return false;
     if (a->kind != b->kind)
         return false;
     if (a->kind == TAC_VAL_CONSTANT) {
@@ -66,7 +62,17 @@ bool tac_compare_val(const Tac_Val *a, const Tac_Val *b)
         if (a->u.var_name && strcmp(a->u.var_name, b->u.var_name) != 0)
             return false;
     }
-    return tac_compare_val(a->next, b->next);
+    return true;
+}
+
+// Compare two lists of Tac_Val, node by node
+bool tac_compare_val(const Tac_Val *a, const Tac_Val *b)
+{
+    for (; a != b; a = a->next, b = b->next) {
+        if (!a || !b || !compare_val_node(a, b))
+            return false;
+    }
+    return true;
 }
 
 // Compare two Tac_Type structures recursively
@@ -139,13 +145,9 @@ static bool tac_compare_static_local(const Tac_StaticLocal *a, const Tac_StaticL
     return tac_compare_static_local(a->next, b->next);
 }
 
-// Compare two Tac_StaticInit structures recursively
-bool tac_compare_static_init(const Tac_StaticInit *a, const Tac_StaticInit *b)
+// Compare one Tac_StaticInit node, ignoring the rest of the list
+static bool compare_static_init_node(const Tac_StaticInit *a, const Tac_StaticInit *b)
 {
-    if (a == b)
-        return true;
-    if (!a || !b)
-        return false;
     if (a->kind != b->kind)
         return false;
     switch (a->kind) {
@@ -199,16 +201,22 @@ bool tac_compare_static_init(const Tac_StaticInit *a, const Tac_StaticInit *b)
             return false;
         break;
     }
-    return tac_compare_static_init(a->next, b->next);
+    return true;
 }
 
-// Compare two Tac_Instruction structures recursively
-bool tac_compare_instruction(const Tac_Instruction *a, const Tac_Instruction *b)
+// Compare two lists of Tac_StaticInit, node by node
+bool tac_compare_static_init(const Tac_StaticInit *a, const Tac_StaticInit *b)
+{
+    for (; a != b; a = a->next, b = b->next) {
+        if (!a || !b || !compare_static_init_node(a, b))
+            return false;
+    }
+    return true;
+}
+
+// Compare one Tac_Instruction node, ignoring the rest of the list
+static bool compare_instruction_node(const Tac_Instruction *a, const Tac_Instruction *b)
 {
-    if (a == b)
-        return true;
-    if (!a || !b)
-        return false;
     if (a->kind != b->kind)
         return false;
     if (a->is_volatile != b->is_volatile)
@@ -292,6 +300,10 @@ bool tac_compare_instruction(const Tac_Instruction *a, const Tac_Instruction *b)
             return false;
         return a->u.copy_from_offset.offset == b->u.copy_from_offset.offset &&
                tac_compare_val(a->u.copy_from_offset.dst, b->u.copy_from_offset.dst);
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        return tac_compare_val(a->u.block_copy.src_ptr, b->u.block_copy.src_ptr) &&
+               tac_compare_val(a->u.block_copy.dst_ptr, b->u.block_copy.dst_ptr) &&
+               a->u.block_copy.size == b->u.block_copy.size;
     case TAC_INSTRUCTION_JUMP:
         if ((a->u.jump.target == NULL) != (b->u.jump.target == NULL))
             return false;
@@ -334,7 +346,17 @@ bool tac_compare_instruction(const Tac_Instruction *a, const Tac_Instruction *b)
             return false;
         break;
     }
-    return tac_compare_instruction(a->next, b->next);
+    return true;
+}
+
+// Compare two lists of Tac_Instruction, node by node
+bool tac_compare_instruction(const Tac_Instruction *a, const Tac_Instruction *b)
+{
+    for (; a != b; a = a->next, b = b->next) {
+        if (!a || !b || !compare_instruction_node(a, b))
+            return false;
+    }
+    return true;
 }
 
 // Compare two Tac_TopLevel structures recursively
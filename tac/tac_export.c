@@ -1,4 +1,6 @@
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "tac.h"
 #include "tags.h"
@@ -6,25 +8,35 @@
 
 int export_tac_debug;
 
+//
+// Index entries of the stream being written, collected by tac_export_toplevel() and
+// written out by tac_export_end_stream().  One indexed stream at a time.
+//
+static struct {
+    WFILE *stream; // NULL when no index is wanted
+    Tac_IndexEntry *entries;
+    size_t count;
+    size_t cap;
+} index_out;
+
 static void export_type(WFILE *out, const Tac_Type *t);
-static void export_static_init(WFILE *out, const Tac_StaticInit *si);
 
 static void export_const(WFILE *out, const Tac_Const *c)
 {
     if (!c) {
-        wputw(TAG_EOL, out);
+        wputtag(TAG_EOL, out);
         return;
     }
-    wputw(TAG_TAC_CONST + c->kind, out);
+    wputtag(TAG_TAC_CONST + c->kind, out);
     switch (c->kind) {
     case TAC_CONST_INT:
-        wputw((size_t)(uint64_t)c->u.int_val, out);
+        wputi(c->u.int_val, out);
         break;
     case TAC_CONST_LONG:
-        wputw((size_t)c->u.long_val, out);
+        wputi(c->u.long_val, out);
         break;
     case TAC_CONST_LONG_LONG:
-        wputw((size_t)(unsigned long long)c->u.long_long_val, out);
+        wputi(c->u.long_long_val, out);
         break;
     case TAC_CONST_UINT:
         wputw((size_t)c->u.uint_val, out);
@@ -45,7 +57,7 @@ static void export_const(WFILE *out, const Tac_Const *c)
         wputld(c->u.long_double_val, out);
         break;
     case TAC_CONST_SCHAR:
-        wputw((unsigned)c->u.char_val, out);
+        wputi(c->u.char_val, out);
         break;
     case TAC_CONST_UCHAR:
         wputw((unsigned)c->u.uchar_val, out);
@@ -55,32 +67,31 @@ static void export_const(WFILE *out, const Tac_Const *c)
     }
 }
 
-static void export_val(WFILE *out, const Tac_Val *v)
+static void export_val_node(WFILE *out, const Tac_Val *v)
 {
-    if (!v) {
-        wputw(TAG_EOL, out);
-        return;
-    }
-    wputw(TAG_TAC_VAL + v->kind, out);
+    wputtag(TAG_TAC_VAL + v->kind, out);
     if (v->kind == TAC_VAL_CONSTANT) {
         export_const(out, v->u.constant);
     } else {
         wputstr(v->u.var_name ? v->u.var_name : "", out);
     }
-    export_val(out, v->next);
 }
 
-static void export_instr(WFILE *out, const Tac_Instruction *instr)
+// A list is its nodes in order, then TAG_EOL.
+static void export_val(WFILE *out, const Tac_Val *v)
+{
+    for (; v; v = v->next)
+        export_val_node(out, v);
+    wputtag(TAG_EOL, out);
+}
+
+static void export_instr_node(WFILE *out, const Tac_Instruction *instr)
 {
-    if (!instr) {
-        wputw(TAG_EOL, out);
-        return;
-    }
     {
         size_t tag = TAG_TAC_INSTR + instr->kind;
         if (instr->is_volatile)
             tag |= TAG_INSTR_VOLATILE;
-        wputw(tag, out);
+        wputtag(tag, out);
     }
     switch (instr->kind) {
     case TAC_INSTRUCTION_RETURN:
@@ -146,7 +157,7 @@ static void export_instr(WFILE *out, const Tac_Instruction *instr)
     case TAC_INSTRUCTION_ADD_PTR:
         export_val(out, instr->u.add_ptr.ptr);
         export_val(out, instr->u.add_ptr.index);
-        wputw((size_t)instr->u.add_ptr.scale, out);
+        wputi(instr->u.add_ptr.scale, out);
         export_val(out, instr->u.add_ptr.dst);
         break;
     case TAC_INSTRUCTION_PTR_DIFF:
@@ -158,14 +169,19 @@ static void export_instr(WFILE *out, const Tac_Instruction *instr)
     case TAC_INSTRUCTION_COPY_BYTE_TO_OFFSET:
         export_val(out, instr->u.copy_to_offset.src);
         wputstr(instr->u.copy_to_offset.dst ? instr->u.copy_to_offset.dst : "", out);
-        wputw((size_t)instr->u.copy_to_offset.offset, out);
+        wputi(instr->u.copy_to_offset.offset, out);
         break;
     case TAC_INSTRUCTION_COPY_FROM_OFFSET:
     case TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET:
         wputstr(instr->u.copy_from_offset.src ? instr->u.copy_from_offset.src : "", out);
-        wputw((size_t)instr->u.copy_from_offset.offset, out);
+        wputi(instr->u.copy_from_offset.offset, out);
         export_val(out, instr->u.copy_from_offset.dst);
         break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        export_val(out, instr->u.block_copy.src_ptr);
+        export_val(out, instr->u.block_copy.dst_ptr);
+        wputi(instr->u.block_copy.size, out);
+        break;
     case TAC_INSTRUCTION_JUMP:
         wputstr(instr->u.jump.target ? instr->u.jump.target : "", out);
         break;
@@ -186,22 +202,29 @@ static void export_instr(WFILE *out, const Tac_Instruction *instr)
         break;
     case TAC_INSTRUCTION_ALLOCATE_LOCAL:
         wputstr(instr->u.allocate_local.name ? instr->u.allocate_local.name : "", out);
-        wputw((size_t)instr->u.allocate_local.size, out);
-        wputw((size_t)instr->u.allocate_local.alignment, out);
+        wputi(instr->u.allocate_local.size, out);
+        wputi(instr->u.allocate_local.alignment, out);
         break;
     default:
         break;
     }
-    export_instr(out, instr->next);
+}
+
+// A list is its nodes in order, then TAG_EOL.
+static void export_instr(WFILE *out, const Tac_Instruction *instr)
+{
+    for (; instr; instr = instr->next)
+        export_instr_node(out, instr);
+    wputtag(TAG_EOL, out);
 }
 
 static void export_param(WFILE *out, const Tac_Param *p)
 {
     if (!p) {
-        wputw(TAG_EOL, out);
+        wputtag(TAG_EOL, out);
         return;
     }
-    wputw(TAG_TAC_PARAM, out);
+    wputtag(TAG_TAC_PARAM, out);
     wputstr(p->name ? p->name : "", out);
     export_param(out, p->next);
 }
@@ -209,23 +232,74 @@ static void export_param(WFILE *out, const Tac_Param *p)
 static void export_static_local(WFILE *out, const Tac_StaticLocal *sl)
 {
     if (!sl) {
-        wputw(TAG_EOL, out);
+        wputtag(TAG_EOL, out);
         return;
     }
-    wputw(TAG_TAC_STATIC_LOC, out);
+    wputtag(TAG_TAC_STATIC_LOC, out);
     wputstr(sl->name ? sl->name : "", out);
     export_type(out, sl->type);
-    export_static_init(out, sl->init_list);
+    tac_export_static_init(out, sl->init_list);
     export_static_local(out, sl->next);
 }
 
+static const char *toplevel_name(const Tac_TopLevel *tl)
+{
+    switch (tl->kind) {
+    case TAC_TOPLEVEL_FUNCTION:
+        return tl->u.function.name;
+    case TAC_TOPLEVEL_STATIC_VARIABLE:
+        return tl->u.static_variable.name;
+    case TAC_TOPLEVEL_STATIC_CONSTANT:
+        return tl->u.static_constant.name;
+    default:
+        return NULL;
+    }
+}
+
+//
+// Remember where a toplevel starts, for the trailing index.
+//
+static Tac_IndexEntry *add_index_entry(WFILE *out, const Tac_TopLevel *tl)
+{
+    if (index_out.count == index_out.cap) {
+        index_out.cap     = index_out.cap ? 2 * index_out.cap : 64;
+        index_out.entries = realloc(index_out.entries, index_out.cap * sizeof(Tac_IndexEntry));
+        if (!index_out.entries) {
+            fprintf(stderr, "Out of memory growing TAC index\n");
+            exit(1);
+        }
+    }
+    const char *name  = toplevel_name(tl);
+    Tac_IndexEntry *e = &index_out.entries[index_out.count++];
+    e->name           = strdup(name ? name : "");
+    e->kind           = tl->kind;
+    e->offset         = woffset(out);
+    e->hash           = 0;
+    if (!e->name) {
+        fprintf(stderr, "Out of memory growing TAC index\n");
+        exit(1);
+    }
+    return e;
+}
+
+//
+// Write one toplevel.  In a compact stream the string and tag tables restart at every
+// toplevel, so each one can be decoded on its own, starting from its index entry.
+//
 void tac_export_toplevel(WFILE *out, const Tac_TopLevel *tl)
 {
     if (!tl) {
-        wputw(TAG_EOL, out);
+        wputtag(TAG_EOL, out);
         return;
     }
-    wputw(TAG_TAC_TOPLEVEL + tl->kind, out);
+    wrestart_tables(out);
+
+    Tac_IndexEntry *entry = NULL;
+    if (out == index_out.stream) {
+        entry = add_index_entry(out, tl);
+        wdigest_begin(out);
+    }
+    wputtag(TAG_TAC_TOPLEVEL + tl->kind, out);
     switch (tl->kind) {
     case TAC_TOPLEVEL_FUNCTION:
         wputstr(tl->u.function.name ? tl->u.function.name : "", out);
@@ -240,31 +314,92 @@ void tac_export_toplevel(WFILE *out, const Tac_TopLevel *tl)
         wputstr(tl->u.static_variable.name ? tl->u.static_variable.name : "", out);
         wputw(tl->u.static_variable.global ? 1 : 0, out);
         export_type(out, tl->u.static_variable.type);
-        export_static_init(out, tl->u.static_variable.init_list);
+        tac_export_static_init(out, tl->u.static_variable.init_list);
         break;
     case TAC_TOPLEVEL_STATIC_CONSTANT:
         wputstr(tl->u.static_constant.name ? tl->u.static_constant.name : "", out);
         export_type(out, tl->u.static_constant.type);
-        export_static_init(out, tl->u.static_constant.init);
+        tac_export_static_init(out, tl->u.static_constant.init);
         break;
     default:
         break;
     }
+    if (entry) {
+        entry->hash = wdigest_end(out);
+    }
+}
+
+//
+// Start a TAC stream.  With `compact` set, the stream is written in the varint encoding
+// (see wbegin_compact); tac_import_toplevel() recognizes either form on its own.
+// Without it, nothing is written and the stream keeps the word format.
+//
+//
+// Start a TAC stream: the compact header if requested, and collection of the trailing
+// index when `with_index` is set.
+//
+void tac_export_begin_stream(WFILE *out, bool compact, bool with_index)
+{
+    if (compact)
+        wbegin_compact(out);
+    if (with_index)
+        index_out.stream = out;
+}
+
+static void free_index_out(void)
+{
+    for (size_t i = 0; i < index_out.count; i++)
+        free(index_out.entries[i].name);
+    free(index_out.entries);
+    memset(&index_out, 0, sizeof(index_out));
+}
+
+//
+// Trailing index, after the TAG_EOL that ends the toplevels:
+//
+//      TAG_TAC_INDEX, count,
+//      count x { name, kind, offset, hash },
+//      index offset, TAG_TAC_INDEX         -- two raw words, at the very end
+//
+// The body is in the stream's encoding (with fresh compact tables); the last two words
+// are raw, so a reader finds them at a fixed distance from the end of the file.
+// Offsets are in bytes from the start of the stream.  Sequential readers stop at
+// TAG_EOL and never see any of it.
+//
+static void export_index(WFILE *out)
+{
+    wrestart_tables(out);
+    size_t index_offset = woffset(out);
+    wputtag(TAG_TAC_INDEX, out);
+    wputw(index_out.count, out);
+    for (size_t i = 0; i < index_out.count; i++) {
+        const Tac_IndexEntry *e = &index_out.entries[i];
+        wputstr(e->name, out);
+        wputw(e->kind, out);
+        wputw(e->offset, out);
+        wputw(e->hash, out);
+    }
+    wputfixed(index_offset, out);
+    wputfixed(TAG_TAC_INDEX, out);
 }
 
 void tac_export_end_stream(WFILE *out)
 {
-    wputw(TAG_EOL, out);
+    wputtag(TAG_EOL, out);
+    if (out == index_out.stream) {
+        export_index(out);
+        free_index_out();
+    }
     wflush(out);
 }
 
 static void export_type(WFILE *out, const Tac_Type *t)
 {
     if (!t) {
-        wputw(TAG_EOL, out);
+        wputtag(TAG_EOL, out);
         return;
     }
-    wputw(TAG_TAC_TYPE + t->kind, out);
+    wputtag(TAG_TAC_TYPE + t->kind, out);
     switch (t->kind) {
     case TAC_TYPE_SCHAR:
     case TAC_TYPE_UCHAR:
@@ -290,11 +425,11 @@ static void export_type(WFILE *out, const Tac_Type *t)
         break;
     case TAC_TYPE_ARRAY:
         export_type(out, t->u.array.elem_type);
-        wputw((size_t)t->u.array.size, out);
+        wputi(t->u.array.size, out);
         break;
     case TAC_TYPE_STRUCTURE:
         wputstr(t->u.structure.tag ? t->u.structure.tag : "", out);
-        wputw((size_t)t->u.structure.size, out);
+        wputi(t->u.structure.size, out);
         break;
     default:
         break;
@@ -302,25 +437,21 @@ static void export_type(WFILE *out, const Tac_Type *t)
     export_type(out, t->next);
 }
 
-static void export_static_init(WFILE *out, const Tac_StaticInit *si)
+static void export_static_init_node(WFILE *out, const Tac_StaticInit *si)
 {
-    if (!si) {
-        wputw(TAG_EOL, out);
-        return;
-    }
-    wputw(TAG_TAC_STATIC_INIT + si->kind, out);
+    wputtag(TAG_TAC_STATIC_INIT + si->kind, out);
     switch (si->kind) {
     case TAC_STATIC_INIT_I8:
-        wputw((size_t)(unsigned char)si->u.char_val, out);
+        wputi(si->u.char_val, out);
         break;
     case TAC_STATIC_INIT_I16:
-        wputw((size_t)(uint16_t)si->u.short_val, out);
+        wputi(si->u.short_val, out);
         break;
     case TAC_STATIC_INIT_I32:
-        wputw((size_t)(unsigned int)si->u.int_val, out);
+        wputi(si->u.int_val, out);
         break;
     case TAC_STATIC_INIT_I64:
-        wputw((size_t)(unsigned long long)si->u.long_val, out);
+        wputi(si->u.long_val, out);
         break;
     case TAC_STATIC_INIT_U8:
         wputw((size_t)si->u.uchar_val, out);
@@ -344,7 +475,7 @@ static void export_static_init(WFILE *out, const Tac_StaticInit *si)
         wputld(si->u.long_double_val, out);
         break;
     case TAC_STATIC_INIT_ZERO:
-        wputw((size_t)si->u.zero_bytes, out);
+        wputi(si->u.zero_bytes, out);
         break;
     case TAC_STATIC_INIT_STRING:
         // A length-prefixed blob, not wputstr: the decoded bytes may include NULs.
@@ -354,16 +485,23 @@ static void export_static_init(WFILE *out, const Tac_StaticInit *si)
         break;
     case TAC_STATIC_INIT_POINTER:
         wputstr(si->u.pointer.name ? si->u.pointer.name : "", out);
-        wputw(si->u.pointer.byte_offset, out);
+        wputi(si->u.pointer.byte_offset, out);
         break;
     case TAC_STATIC_INIT_FAT_POINTER:
         wputstr(si->u.pointer.name ? si->u.pointer.name : "", out);
-        wputw(si->u.pointer.byte_offset, out);
+        wputi(si->u.pointer.byte_offset, out);
         break;
     default:
         break;
     }
-    export_static_init(out, si->next);
+}
+
+// A list is its nodes in order, then TAG_EOL.
+void tac_export_static_init(WFILE *out, const Tac_StaticInit *si)
+{
+    for (; si; si = si->next)
+        export_static_init_node(out, si);
+    wputtag(TAG_EOL, out);
 }
 
 void tac_export_program(WFILE *out, const Tac_Program *prog)
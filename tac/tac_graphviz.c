@@ -471,6 +471,9 @@ static void emit_instruction(FILE *fd, const Tac_Instruction *instr, int parent_
         emit_string(fd, instr->u.copy_from_offset.src);
         fprintf(fd, " offset=%d", instr->u.copy_from_offset.offset);
         break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        fprintf(fd, "BlockCopy size=%d", instr->u.block_copy.size);
+        break;
     case TAC_INSTRUCTION_JUMP:
         fprintf(fd, "Jump: ");
         emit_string(fd, instr->u.jump.target);
@@ -648,6 +651,10 @@ static void emit_instruction(FILE *fd, const Tac_Instruction *instr, int parent_
     case TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET:
         emit_val(fd, instr->u.copy_from_offset.dst, id, "dst");
         break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        emit_val(fd, instr->u.block_copy.src_ptr, id, "src_ptr");
+        emit_val(fd, instr->u.block_copy.dst_ptr, id, "dst_ptr");
+        break;
     case TAC_INSTRUCTION_JUMP:
     case TAC_INSTRUCTION_LABEL:
         break;
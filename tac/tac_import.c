@@ -19,24 +19,46 @@ static void check_input(const WFILE *in, const char *ctx)
     }
 }
 
+// Rewrite applied to every name read, or NULL (see tac_import_set_rename).
+static const char *(*rename_name)(const char *name);
+
+void tac_import_set_rename(const char *(*fn)(const char *name))
+{
+    rename_name = fn;
+}
+
+// Read a name, through the rename hook when one is set.  Valid until the next read.
+static const char *get_name_tmp(WFILE *in)
+{
+    const char *name = wgetstr_tmp(in);
+    return name && rename_name ? rename_name(name) : name;
+}
+
+// Read a name into a buffer of its own, or NULL for an empty one.
+static char *get_name(WFILE *in)
+{
+    const char *name = get_name_tmp(in);
+    return name ? xstrdup(name) : NULL;
+}
+
 static Tac_Const *import_const(WFILE *in)
 {
-    size_t tag = wgetw(in);
+    size_t tag = wgettag(in);
     check_input(in, "const tag");
     if (tag < TAG_TAC_CONST || tag > TAG_TAC_CONST + TAC_CONST_UCHAR)
         return NULL;
     Tac_Const *c = tac_new_const((Tac_ConstKind)(tag - TAG_TAC_CONST));
     switch (c->kind) {
     case TAC_CONST_INT:
-        c->u.int_val = (int64_t)wgetw(in);
+        c->u.int_val = (int64_t)wgeti(in);
         check_input(in, "const int");
         break;
     case TAC_CONST_LONG:
-        c->u.long_val = (long)wgetw(in);
+        c->u.long_val = (long)wgeti(in);
         check_input(in, "const long");
         break;
     case TAC_CONST_LONG_LONG:
-        c->u.long_long_val = (long long)wgetw(in);
+        c->u.long_long_val = wgeti(in);
         check_input(in, "const long long");
         break;
     case TAC_CONST_UINT:
@@ -64,7 +86,7 @@ static Tac_Const *import_const(WFILE *in)
         check_input(in, "const long double");
         break;
     case TAC_CONST_SCHAR:
-        c->u.char_val = (int)wgetw(in);
+        c->u.char_val = (int)wgeti(in);
         check_input(in, "const char");
         break;
     case TAC_CONST_UCHAR:
@@ -77,9 +99,10 @@ static Tac_Const *import_const(WFILE *in)
     return c;
 }
 
-static Tac_Val *import_val(WFILE *in)
+// Read one node, or NULL at the TAG_EOL that ends a list.
+static Tac_Val *import_val_node(WFILE *in)
 {
-    size_t tag = wgetw(in);
+    size_t tag = wgettag(in);
     check_input(in, "val tag");
     if (tag < TAG_TAC_VAL || tag > TAG_TAC_VAL + TAC_VAL_VAR)
         return NULL;
@@ -87,18 +110,25 @@ static Tac_Val *import_val(WFILE *in)
     if (v->kind == TAC_VAL_CONSTANT) {
         v->u.constant = import_const(in);
     } else {
-        v->u.var_name = wgetstr(in);
+        v->u.var_name = tac_intern(get_name_tmp(in));
         check_input(in, "val var_name");
     }
-    v->next = import_val(in);
     return v;
 }
 
+static Tac_Val *import_val(WFILE *in)
+{
+    Tac_Val *head = NULL;
+    for (Tac_Val **p = &head; (*p = import_val_node(in)) != NULL; p = &(*p)->next)
+        ;
+    return head;
+}
+
 static Tac_Type *import_type(WFILE *in);
 
 static Tac_Type *import_type(WFILE *in)
 {
-    size_t tag = wgetw(in);
+    size_t tag = wgettag(in);
     check_input(in, "type tag");
     if (tag < TAG_TAC_TYPE || tag > TAG_TAC_TYPE + TAC_TYPE_STRUCTURE)
         return NULL;
@@ -128,13 +158,13 @@ static Tac_Type *import_type(WFILE *in)
         break;
     case TAC_TYPE_ARRAY:
         t->u.array.elem_type = import_type(in);
-        t->u.array.size      = (int)wgetw(in);
+        t->u.array.size      = (int)wgeti(in);
         check_input(in, "array size");
         break;
     case TAC_TYPE_STRUCTURE:
-        t->u.structure.tag = wgetstr(in);
+        t->u.structure.tag = get_name(in);
         check_input(in, "structure tag");
-        t->u.structure.size = (int)wgetw(in);
+        t->u.structure.size = (int)wgeti(in);
         check_input(in, "structure size");
         break;
     default:
@@ -144,28 +174,29 @@ static Tac_Type *import_type(WFILE *in)
     return t;
 }
 
-static Tac_StaticInit *import_static_init(WFILE *in)
+// Read one node, or NULL at the TAG_EOL that ends a list.
+static Tac_StaticInit *import_static_init_node(WFILE *in)
 {
-    size_t tag = wgetw(in);
+    size_t tag = wgettag(in);
     check_input(in, "static_init tag");
     if (tag < TAG_TAC_STATIC_INIT || tag > TAG_TAC_STATIC_INIT + TAC_STATIC_INIT_FAT_POINTER)
         return NULL;
     Tac_StaticInit *si = tac_new_static_init((Tac_StaticInitKind)(tag - TAG_TAC_STATIC_INIT));
     switch (si->kind) {
     case TAC_STATIC_INIT_I8:
-        si->u.char_val = (int8_t)wgetw(in);
+        si->u.char_val = (int8_t)wgeti(in);
         check_input(in, "static_init i8");
         break;
     case TAC_STATIC_INIT_I16:
-        si->u.short_val = (int16_t)wgetw(in);
+        si->u.short_val = (int16_t)wgeti(in);
         check_input(in, "static_init i16");
         break;
     case TAC_STATIC_INIT_I32:
-        si->u.int_val = (int32_t)wgetw(in);
+        si->u.int_val = (int32_t)wgeti(in);
         check_input(in, "static_init i32");
         break;
     case TAC_STATIC_INIT_I64:
-        si->u.long_val = (int64_t)wgetw(in);
+        si->u.long_val = (int64_t)wgeti(in);
         check_input(in, "static_init i64");
         break;
     case TAC_STATIC_INIT_U8:
@@ -197,7 +228,7 @@ static Tac_StaticInit *import_static_init(WFILE *in)
         check_input(in, "static_init long double");
         break;
     case TAC_STATIC_INIT_ZERO:
-        si->u.zero_bytes = (int)wgetw(in);
+        si->u.zero_bytes = (int)wgeti(in);
         check_input(in, "static_init zero");
         break;
     case TAC_STATIC_INIT_STRING:
@@ -207,32 +238,39 @@ static Tac_StaticInit *import_static_init(WFILE *in)
         check_input(in, "static_init string null_terminated");
         break;
     case TAC_STATIC_INIT_POINTER:
-        si->u.pointer.name = wgetstr(in);
+        si->u.pointer.name = get_name(in);
         check_input(in, "static_init pointer name");
-        si->u.pointer.byte_offset = (int)wgetw(in);
+        si->u.pointer.byte_offset = (int)wgeti(in);
         check_input(in, "static_init pointer offset");
         break;
     case TAC_STATIC_INIT_FAT_POINTER:
-        si->u.pointer.name = wgetstr(in);
+        si->u.pointer.name = get_name(in);
         check_input(in, "static_init fat_pointer name");
-        si->u.pointer.byte_offset = (int)wgetw(in);
+        si->u.pointer.byte_offset = (int)wgeti(in);
         check_input(in, "static_init fat_pointer offset");
         break;
     default:
         break;
     }
-    si->next = import_static_init(in);
     return si;
 }
 
+Tac_StaticInit *tac_import_static_init(WFILE *in)
+{
+    Tac_StaticInit *head = NULL;
+    for (Tac_StaticInit **p = &head; (*p = import_static_init_node(in)) != NULL; p = &(*p)->next)
+        ;
+    return head;
+}
+
 static Tac_Param *import_param(WFILE *in)
 {
-    size_t tag = wgetw(in);
+    size_t tag = wgettag(in);
     check_input(in, "param tag");
     if (tag != TAG_TAC_PARAM)
         return NULL;
     Tac_Param *p = tac_new_param();
-    p->name      = wgetstr(in);
+    p->name      = get_name(in);
     check_input(in, "param name");
     p->next = import_param(in);
     return p;
@@ -240,22 +278,23 @@ static Tac_Param *import_param(WFILE *in)
 
 static Tac_StaticLocal *import_static_local(WFILE *in)
 {
-    size_t tag = wgetw(in);
+    size_t tag = wgettag(in);
     check_input(in, "static local tag");
     if (tag != TAG_TAC_STATIC_LOC)
         return NULL;
     Tac_StaticLocal *sl = tac_new_static_local();
-    sl->name            = wgetstr(in);
+    sl->name            = get_name(in);
     check_input(in, "static local name");
     sl->type      = import_type(in);
-    sl->init_list = import_static_init(in);
+    sl->init_list = tac_import_static_init(in);
     sl->next      = import_static_local(in);
     return sl;
 }
 
-static Tac_Instruction *import_instr(WFILE *in)
+// Read one node, or NULL at the TAG_EOL that ends a list.
+static Tac_Instruction *import_instr_node(WFILE *in)
 {
-    size_t tag = wgetw(in);
+    size_t tag = wgettag(in);
     check_input(in, "instr tag");
     bool is_volatile = (tag & TAG_INSTR_VOLATILE) != 0;
     tag &= ~TAG_INSTR_VOLATILE;
@@ -329,7 +368,7 @@ static Tac_Instruction *import_instr(WFILE *in)
     case TAC_INSTRUCTION_ADD_PTR:
         instr->u.add_ptr.ptr   = import_val(in);
         instr->u.add_ptr.index = import_val(in);
-        instr->u.add_ptr.scale = (int)wgetw(in);
+        instr->u.add_ptr.scale = (int)wgeti(in);
         check_input(in, "add_ptr scale");
         instr->u.add_ptr.dst = import_val(in);
         break;
@@ -341,36 +380,42 @@ static Tac_Instruction *import_instr(WFILE *in)
     case TAC_INSTRUCTION_COPY_TO_OFFSET:
     case TAC_INSTRUCTION_COPY_BYTE_TO_OFFSET:
         instr->u.copy_to_offset.src = import_val(in);
-        instr->u.copy_to_offset.dst = wgetstr(in);
+        instr->u.copy_to_offset.dst = get_name(in);
         check_input(in, "copy_to_offset dst");
-        instr->u.copy_to_offset.offset = (int)wgetw(in);
+        instr->u.copy_to_offset.offset = (int)wgeti(in);
         check_input(in, "copy_to_offset offset");
         break;
     case TAC_INSTRUCTION_COPY_FROM_OFFSET:
     case TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET:
-        instr->u.copy_from_offset.src = wgetstr(in);
+        instr->u.copy_from_offset.src = get_name(in);
         check_input(in, "copy_from_offset src");
-        instr->u.copy_from_offset.offset = (int)wgetw(in);
+        instr->u.copy_from_offset.offset = (int)wgeti(in);
         check_input(in, "copy_from_offset offset");
         instr->u.copy_from_offset.dst = import_val(in);
         break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        instr->u.block_copy.src_ptr = import_val(in);
+        instr->u.block_copy.dst_ptr = import_val(in);
+        instr->u.block_copy.size    = (int)wgeti(in);
+        check_input(in, "block_copy size");
+        break;
     case TAC_INSTRUCTION_JUMP:
-        instr->u.jump.target = wgetstr(in);
+        instr->u.jump.target = tac_intern(get_name_tmp(in));
         check_input(in, "jump target");
         break;
     case TAC_INSTRUCTION_JUMP_IF_ZERO:
     case TAC_INSTRUCTION_JUMP_IF_NOT_ZERO:
         instr->u.jump_if_zero.condition = import_val(in);
-        instr->u.jump_if_zero.target    = wgetstr(in);
+        instr->u.jump_if_zero.target    = tac_intern(get_name_tmp(in));
         check_input(in, "jump_if_zero target");
         break;
     case TAC_INSTRUCTION_LABEL:
-        instr->u.label.name = wgetstr(in);
+        instr->u.label.name = tac_intern(get_name_tmp(in));
         check_input(in, "label name");
         break;
     case TAC_INSTRUCTION_FUN_CALL:
     case TAC_INSTRUCTION_FUN_CALL_NORETURN:
-        instr->u.fun_call.fun_name = wgetstr(in);
+        instr->u.fun_call.fun_name = get_name(in);
         check_input(in, "fun_call fun_name");
         instr->u.fun_call.indirect = (bool)wgetw(in);
         check_input(in, "fun_call indirect");
@@ -378,24 +423,39 @@ static Tac_Instruction *import_instr(WFILE *in)
         instr->u.fun_call.dst  = import_val(in);
         break;
     case TAC_INSTRUCTION_ALLOCATE_LOCAL:
-        instr->u.allocate_local.name = wgetstr(in);
+        instr->u.allocate_local.name = get_name(in);
         check_input(in, "allocate_local name");
-        instr->u.allocate_local.size = (int)wgetw(in);
+        instr->u.allocate_local.size = (int)wgeti(in);
         check_input(in, "allocate_local size");
-        instr->u.allocate_local.alignment = (int)wgetw(in);
+        instr->u.allocate_local.alignment = (int)wgeti(in);
         check_input(in, "allocate_local alignment");
         break;
     default:
         break;
     }
-    instr->next = import_instr(in);
     return instr;
 }
 
+static Tac_Instruction *import_instr(WFILE *in)
+{
+    Tac_Instruction *head = NULL;
+    for (Tac_Instruction **p = &head; (*p = import_instr_node(in)) != NULL; p = &(*p)->next)
+        ;
+    return head;
+}
+
 Tac_TopLevel *tac_import_toplevel(WFILE *in)
 {
-    size_t tag = wgetw(in);
+    wrestart_tables(in); // see tac_export_toplevel()
+    size_t tag = wgettag(in);
     check_input(in, "toplevel tag");
+    if (waccept_compact(in, tag)) {
+        // Header of a compact stream: the first toplevel follows.
+        tag = wgettag(in);
+        check_input(in, "toplevel tag");
+    } else {
+        check_input(in, "stream header");
+    }
     if (tag == TAG_EOL) {
         return NULL;
     }
@@ -406,7 +466,7 @@ Tac_TopLevel *tac_import_toplevel(WFILE *in)
     Tac_TopLevel *tl = tac_new_toplevel((Tac_TopLevelKind)(tag - TAG_TAC_TOPLEVEL));
     switch (tl->kind) {
     case TAC_TOPLEVEL_FUNCTION:
-        tl->u.function.name = wgetstr(in);
+        tl->u.function.name = get_name(in);
         check_input(in, "function name");
         tl->u.function.global = (bool)wgetw(in);
         check_input(in, "function global");
@@ -419,18 +479,18 @@ Tac_TopLevel *tac_import_toplevel(WFILE *in)
         tl->u.function.body          = import_instr(in);
         break;
     case TAC_TOPLEVEL_STATIC_VARIABLE:
-        tl->u.static_variable.name = wgetstr(in);
+        tl->u.static_variable.name = get_name(in);
         check_input(in, "static_variable name");
         tl->u.static_variable.global = (bool)wgetw(in);
         check_input(in, "static_variable global");
         tl->u.static_variable.type      = import_type(in);
-        tl->u.static_variable.init_list = import_static_init(in);
+        tl->u.static_variable.init_list = tac_import_static_init(in);
         break;
     case TAC_TOPLEVEL_STATIC_CONSTANT:
-        tl->u.static_constant.name = wgetstr(in);
+        tl->u.static_constant.name = get_name(in);
         check_input(in, "static_constant name");
         tl->u.static_constant.type = import_type(in);
-        tl->u.static_constant.init = import_static_init(in);
+        tl->u.static_constant.init = tac_import_static_init(in);
         break;
     default:
         break;
@@ -448,3 +508,117 @@ Tac_Program *tac_import_program(WFILE *in)
     }
     return prog;
 }
+
+//
+// Seek to a byte offset; wseek() counts in words unless the stream is compact.
+//
+static int seek_bytes(WFILE *in, long offset, int whence)
+{
+    long unit = in->compact ? 1 : (long)sizeof(size_t);
+    if (offset % unit != 0)
+        return -1;
+    return wseek(in, offset / unit, whence);
+}
+
+//
+// Read the trailing index of a TAC stream written with tac_export_begin_stream(...,
+// true), see export_index().  Returns NULL when the file has no index or cannot seek;
+// the stream is then left at its first toplevel, ready for tac_import_toplevel().
+//
+Tac_Index *tac_import_index(WFILE *in)
+{
+    if (wseek(in, 0, SEEK_SET) < 0) {
+        wclearerr(in);
+        return NULL;
+    }
+    size_t header = wgetfixed(in);
+    if (!in->compact && !waccept_compact(in, header) && werror(in)) {
+        return NULL;
+    }
+
+    // Two raw words at the end: offset of the index, and its tag.
+    size_t index_offset = (size_t)-1;
+    size_t magic        = 0;
+    if (seek_bytes(in, -2 * (long)sizeof(size_t), SEEK_END) == 0) {
+        index_offset = wgetfixed(in);
+        magic        = wgetfixed(in);
+    }
+    if (magic != TAG_TAC_INDEX || werror(in) || weof(in) ||
+        seek_bytes(in, (long)index_offset, SEEK_SET) < 0) {
+        wclearerr(in);
+        seek_bytes(in, in->compact ? (long)sizeof(size_t) : 0, SEEK_SET);
+        return NULL;
+    }
+
+    wrestart_tables(in);
+    size_t tag = wgettag(in);
+    check_input(in, "index tag");
+    if (tag != TAG_TAC_INDEX) {
+        fprintf(stderr, "Error: bad TAC index tag 0x%zx (expected 0x%x)\n", tag, TAG_TAC_INDEX);
+        exit(1);
+    }
+    Tac_Index *index = (Tac_Index *)xalloc(sizeof(Tac_Index), __func__, __FILE__, __LINE__);
+    index->count     = wgetw(in);
+    check_input(in, "index count");
+    if (index->count > 0) {
+        index->entries = (Tac_IndexEntry *)xalloc(index->count * sizeof(Tac_IndexEntry),
+                                                  __func__, __FILE__, __LINE__);
+    }
+    for (size_t i = 0; i < index->count; i++) {
+        Tac_IndexEntry *e = &index->entries[i];
+        e->name           = wgetstr(in);
+        check_input(in, "index name");
+        e->kind = (Tac_TopLevelKind)wgetw(in);
+        check_input(in, "index kind");
+        e->offset = wgetw(in);
+        check_input(in, "index offset");
+        e->hash = wgetw(in);
+        check_input(in, "index hash");
+    }
+    return index;
+}
+
+//
+// Find a toplevel by name.  The first one wins when a name repeats.
+//
+const Tac_IndexEntry *tac_lookup(const Tac_Index *index, const char *name)
+{
+    if (!index || !name)
+        return NULL;
+    for (size_t i = 0; i < index->count; i++) {
+        const char *n = index->entries[i].name;
+        if (n && strcmp(n, name) == 0)
+            return &index->entries[i];
+    }
+    return NULL;
+}
+
+//
+// Seek to the toplevel of an index entry and decode just that one.  The bytes must
+// still match the hash recorded by the writer.
+//
+Tac_TopLevel *tac_import_toplevel_at(WFILE *in, const Tac_IndexEntry *entry)
+{
+    if (seek_bytes(in, (long)entry->offset, SEEK_SET) < 0) {
+        fprintf(stderr, "Error: cannot seek to TAC toplevel '%s'\n", entry->name);
+        exit(1);
+    }
+    wdigest_begin(in);
+    Tac_TopLevel *tl = tac_import_toplevel(in);
+    if (wdigest_end(in) != entry->hash) {
+        fprintf(stderr, "Error: TAC toplevel '%s' does not match its index entry\n",
+                entry->name);
+        exit(1);
+    }
+    return tl;
+}
+
+void tac_free_index(Tac_Index *index)
+{
+    if (!index)
+        return;
+    for (size_t i = 0; i < index->count; i++)
+        xfree(index->entries[i].name);
+    xfree(index->entries);
+    xfree(index);
+}
@@ -0,0 +1,102 @@
+//
+// Interned names of TAC operands.
+//
+// Variable operands, labels and jump targets are drawn from one table, so that every
+// occurrence of a name such as `%123` points to the same string: one allocation per
+// distinct name instead of one per use, and two names are equal exactly when their
+// pointers are.  The table owns the strings; tac_free_*() leaves them alone.
+//
+// Strings live until tac_intern_destroy(), which the drivers call at the end of the
+// translation unit.  They are allocated with malloc(), not xalloc(), so that they
+// survive xfree_all() between units and stay out of the leak accounting.
+//
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tac.h"
+
+static char **slots;    // open-addressing hash table of interned strings
+static size_t nslots;   // power of two, or 0 before the first call
+static size_t nstrings; // occupied slots
+
+// FNV-1a
+static size_t hash_name(const char *name)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ull;
+    }
+    return (size_t)h;
+}
+
+static void grow_table(void)
+{
+    size_t old_nslots = nslots;
+    char **old_slots  = slots;
+
+    nslots = old_nslots ? 2 * old_nslots : 1024;
+    slots  = calloc(nslots, sizeof(char *));
+    if (!slots) {
+        fprintf(stderr, "Out of memory growing the TAC name table\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < old_nslots; i++) {
+        if (old_slots[i]) {
+            size_t j = hash_name(old_slots[i]) & (nslots - 1);
+            while (slots[j])
+                j = (j + 1) & (nslots - 1);
+            slots[j] = old_slots[i];
+        }
+    }
+    free(old_slots);
+}
+
+//
+// Return the interned copy of `name`, adding it on first sight.  NULL stays NULL.
+//
+char *tac_intern(const char *name)
+{
+    if (!name)
+        return NULL;
+    if (2 * (nstrings + 1) > nslots)
+        grow_table();
+
+    size_t i = hash_name(name) & (nslots - 1);
+    for (; slots[i]; i = (i + 1) & (nslots - 1)) {
+        if (strcmp(slots[i], name) == 0)
+            return slots[i];
+    }
+    size_t len = strlen(name) + 1;
+    slots[i]   = malloc(len);
+    if (!slots[i]) {
+        fprintf(stderr, "Out of memory interning name '%s'\n", name);
+        exit(1);
+    }
+    memcpy(slots[i], name, len);
+    nstrings++;
+    return slots[i];
+}
+
+//
+// Number of distinct names interned so far.
+//
+size_t tac_intern_count(void)
+{
+    return nstrings;
+}
+
+//
+// Release every interned name.  Any TAC still referring to them must be gone.
+//
+void tac_intern_destroy(void)
+{
+    for (size_t i = 0; i < nslots; i++)
+        free(slots[i]);
+    free(slots);
+    slots    = NULL;
+    nslots   = 0;
+    nstrings = 0;
+}
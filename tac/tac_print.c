@@ -342,6 +342,64 @@ void tac_print_static_init(FILE *fd, const Tac_StaticInit *init, int depth)
     }
 }
 
+// Lower-case name of an instruction kind, as printed in the dumps.
+const char *tac_instruction_name(Tac_InstructionKind kind)
+{
+    static const char *const names[] = {
+        [TAC_INSTRUCTION_RETURN]                = "return",
+        [TAC_INSTRUCTION_SIGN_EXTEND]           = "sign_extend",
+        [TAC_INSTRUCTION_TRUNCATE]              = "truncate",
+        [TAC_INSTRUCTION_ZERO_EXTEND]           = "zero_extend",
+        [TAC_INSTRUCTION_DOUBLE_TO_INT]         = "double_to_int",
+        [TAC_INSTRUCTION_DOUBLE_TO_UINT]        = "double_to_uint",
+        [TAC_INSTRUCTION_INT_TO_DOUBLE]         = "int_to_double",
+        [TAC_INSTRUCTION_UINT_TO_DOUBLE]        = "uint_to_double",
+        [TAC_INSTRUCTION_FLOAT_TO_DOUBLE]       = "float_to_double",
+        [TAC_INSTRUCTION_DOUBLE_TO_FLOAT]       = "double_to_float",
+        [TAC_INSTRUCTION_INT_TO_FLOAT]          = "int_to_float",
+        [TAC_INSTRUCTION_UINT_TO_FLOAT]         = "uint_to_float",
+        [TAC_INSTRUCTION_FLOAT_TO_INT]          = "float_to_int",
+        [TAC_INSTRUCTION_FLOAT_TO_UINT]         = "float_to_uint",
+        [TAC_INSTRUCTION_LONG_DOUBLE_TO_INT]    = "long_double_to_int",
+        [TAC_INSTRUCTION_LONG_DOUBLE_TO_UINT]   = "long_double_to_uint",
+        [TAC_INSTRUCTION_INT_TO_LONG_DOUBLE]    = "int_to_long_double",
+        [TAC_INSTRUCTION_UINT_TO_LONG_DOUBLE]   = "uint_to_long_double",
+        [TAC_INSTRUCTION_LONG_DOUBLE_TO_DOUBLE] = "long_double_to_double",
+        [TAC_INSTRUCTION_DOUBLE_TO_LONG_DOUBLE] = "double_to_long_double",
+        [TAC_INSTRUCTION_LONG_DOUBLE_TO_FLOAT]  = "long_double_to_float",
+        [TAC_INSTRUCTION_FLOAT_TO_LONG_DOUBLE]  = "float_to_long_double",
+        [TAC_INSTRUCTION_PTR_TO_CHAR_PTR]       = "ptr_to_char_ptr",
+        [TAC_INSTRUCTION_CHAR_PTR_TO_PTR]       = "char_ptr_to_ptr",
+        [TAC_INSTRUCTION_UNARY]                 = "unary",
+        [TAC_INSTRUCTION_BINARY]                = "binary",
+        [TAC_INSTRUCTION_COPY]                  = "copy",
+        [TAC_INSTRUCTION_GET_ADDRESS]           = "get_address",
+        [TAC_INSTRUCTION_GET_ADDRESS_BYTE]      = "get_address_byte",
+        [TAC_INSTRUCTION_GET_ADDRESS_DECAY]     = "get_address_decay",
+        [TAC_INSTRUCTION_LOAD]                  = "load",
+        [TAC_INSTRUCTION_LOAD_BYTE]             = "load_byte",
+        [TAC_INSTRUCTION_STORE]                 = "store",
+        [TAC_INSTRUCTION_STORE_BYTE]            = "store_byte",
+        [TAC_INSTRUCTION_ADD_PTR]               = "add_ptr",
+        [TAC_INSTRUCTION_PTR_DIFF]              = "ptr_diff",
+        [TAC_INSTRUCTION_COPY_TO_OFFSET]        = "copy_to_offset",
+        [TAC_INSTRUCTION_COPY_BYTE_TO_OFFSET]   = "copy_byte_to_offset",
+        [TAC_INSTRUCTION_COPY_FROM_OFFSET]      = "copy_from_offset",
+        [TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET] = "copy_byte_from_offset",
+        [TAC_INSTRUCTION_BLOCK_COPY]            = "block_copy",
+        [TAC_INSTRUCTION_JUMP]                  = "jump",
+        [TAC_INSTRUCTION_JUMP_IF_ZERO]          = "jump_if_zero",
+        [TAC_INSTRUCTION_JUMP_IF_NOT_ZERO]      = "jump_if_not_zero",
+        [TAC_INSTRUCTION_LABEL]                 = "label",
+        [TAC_INSTRUCTION_FUN_CALL]              = "fun_call",
+        [TAC_INSTRUCTION_FUN_CALL_NORETURN]     = "fun_call_noreturn",
+        [TAC_INSTRUCTION_ALLOCATE_LOCAL]        = "allocate_local",
+    };
+    if ((unsigned)kind < sizeof(names) / sizeof(names[0]) && names[kind])
+        return names[kind];
+    return "unknown";
+}
+
 // Print a Tac_Instruction recursively to a file
 void tac_print_instruction(FILE *fd, const Tac_Instruction *instr, int depth)
 {
@@ -353,78 +411,6 @@ void tac_print_instruction(FILE *fd, const Tac_Instruction *instr, int depth)
     print_indent(fd, depth);
     fprintf(fd, "Instruction: ");
     switch (instr->kind) {
-    case TAC_INSTRUCTION_RETURN:
-        fprintf(fd, "return\n");
-        break;
-    case TAC_INSTRUCTION_SIGN_EXTEND:
-        fprintf(fd, "sign_extend\n");
-        break;
-    case TAC_INSTRUCTION_TRUNCATE:
-        fprintf(fd, "truncate\n");
-        break;
-    case TAC_INSTRUCTION_ZERO_EXTEND:
-        fprintf(fd, "zero_extend\n");
-        break;
-    case TAC_INSTRUCTION_DOUBLE_TO_INT:
-        fprintf(fd, "double_to_int\n");
-        break;
-    case TAC_INSTRUCTION_DOUBLE_TO_UINT:
-        fprintf(fd, "double_to_uint\n");
-        break;
-    case TAC_INSTRUCTION_INT_TO_DOUBLE:
-        fprintf(fd, "int_to_double\n");
-        break;
-    case TAC_INSTRUCTION_UINT_TO_DOUBLE:
-        fprintf(fd, "uint_to_double\n");
-        break;
-    case TAC_INSTRUCTION_FLOAT_TO_DOUBLE:
-        fprintf(fd, "float_to_double\n");
-        break;
-    case TAC_INSTRUCTION_DOUBLE_TO_FLOAT:
-        fprintf(fd, "double_to_float\n");
-        break;
-    case TAC_INSTRUCTION_INT_TO_FLOAT:
-        fprintf(fd, "int_to_float\n");
-        break;
-    case TAC_INSTRUCTION_UINT_TO_FLOAT:
-        fprintf(fd, "uint_to_float\n");
-        break;
-    case TAC_INSTRUCTION_FLOAT_TO_INT:
-        fprintf(fd, "float_to_int\n");
-        break;
-    case TAC_INSTRUCTION_FLOAT_TO_UINT:
-        fprintf(fd, "float_to_uint\n");
-        break;
-    case TAC_INSTRUCTION_LONG_DOUBLE_TO_INT:
-        fprintf(fd, "long_double_to_int\n");
-        break;
-    case TAC_INSTRUCTION_LONG_DOUBLE_TO_UINT:
-        fprintf(fd, "long_double_to_uint\n");
-        break;
-    case TAC_INSTRUCTION_INT_TO_LONG_DOUBLE:
-        fprintf(fd, "int_to_long_double\n");
-        break;
-    case TAC_INSTRUCTION_UINT_TO_LONG_DOUBLE:
-        fprintf(fd, "uint_to_long_double\n");
-        break;
-    case TAC_INSTRUCTION_LONG_DOUBLE_TO_DOUBLE:
-        fprintf(fd, "long_double_to_double\n");
-        break;
-    case TAC_INSTRUCTION_DOUBLE_TO_LONG_DOUBLE:
-        fprintf(fd, "double_to_long_double\n");
-        break;
-    case TAC_INSTRUCTION_LONG_DOUBLE_TO_FLOAT:
-        fprintf(fd, "long_double_to_float\n");
-        break;
-    case TAC_INSTRUCTION_FLOAT_TO_LONG_DOUBLE:
-        fprintf(fd, "float_to_long_double\n");
-        break;
-    case TAC_INSTRUCTION_PTR_TO_CHAR_PTR:
-        fprintf(fd, "ptr_to_char_ptr\n");
-        break;
-    case TAC_INSTRUCTION_CHAR_PTR_TO_PTR:
-        fprintf(fd, "char_ptr_to_ptr\n");
-        break;
     case TAC_INSTRUCTION_UNARY:
         fprintf(fd, "unary %s\n",
                 instr->u.unary.op == TAC_UNARY_COMPLEMENT          ? "complement"
@@ -462,68 +448,8 @@ void tac_print_instruction(FILE *fd, const Tac_Instruction *instr, int depth)
                     ? "greater_or_equal_double"
                                                                     : "right_shift");
         break;
-    case TAC_INSTRUCTION_COPY:
-        fprintf(fd, "copy\n");
-        break;
-    case TAC_INSTRUCTION_GET_ADDRESS:
-        fprintf(fd, "get_address\n");
-        break;
-    case TAC_INSTRUCTION_GET_ADDRESS_BYTE:
-        fprintf(fd, "get_address_byte\n");
-        break;
-    case TAC_INSTRUCTION_GET_ADDRESS_DECAY:
-        fprintf(fd, "get_address_decay\n");
-        break;
-    case TAC_INSTRUCTION_LOAD:
-        fprintf(fd, "load\n");
-        break;
-    case TAC_INSTRUCTION_LOAD_BYTE:
-        fprintf(fd, "load_byte\n");
-        break;
-    case TAC_INSTRUCTION_STORE:
-        fprintf(fd, "store\n");
-        break;
-    case TAC_INSTRUCTION_STORE_BYTE:
-        fprintf(fd, "store_byte\n");
-        break;
-    case TAC_INSTRUCTION_ADD_PTR:
-        fprintf(fd, "add_ptr\n");
-        break;
-    case TAC_INSTRUCTION_PTR_DIFF:
-        fprintf(fd, "ptr_diff\n");
-        break;
-    case TAC_INSTRUCTION_COPY_TO_OFFSET:
-        fprintf(fd, "copy_to_offset\n");
-        break;
-    case TAC_INSTRUCTION_COPY_BYTE_TO_OFFSET:
-        fprintf(fd, "copy_byte_to_offset\n");
-        break;
-    case TAC_INSTRUCTION_COPY_FROM_OFFSET:
-        fprintf(fd, "copy_from_offset\n");
-        break;
-    case TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET:
-        fprintf(fd, "copy_byte_from_offset\n");
-        break;
-    case TAC_INSTRUCTION_JUMP:
-        fprintf(fd, "jump\n");
-        break;
-    case TAC_INSTRUCTION_JUMP_IF_ZERO:
-        fprintf(fd, "jump_if_zero\n");
-        break;
-    case TAC_INSTRUCTION_JUMP_IF_NOT_ZERO:
-        fprintf(fd, "jump_if_not_zero\n");
-        break;
-    case TAC_INSTRUCTION_LABEL:
-        fprintf(fd, "label\n");
-        break;
-    case TAC_INSTRUCTION_FUN_CALL:
-        fprintf(fd, "fun_call\n");
-        break;
-    case TAC_INSTRUCTION_FUN_CALL_NORETURN:
-        fprintf(fd, "fun_call_noreturn\n");
-        break;
-    case TAC_INSTRUCTION_ALLOCATE_LOCAL:
-        fprintf(fd, "allocate_local\n");
+    default:
+        fprintf(fd, "%s\n", tac_instruction_name(instr->kind));
         break;
     }
     switch (instr->kind) {
@@ -663,6 +589,16 @@ void tac_print_instruction(FILE *fd, const Tac_Instruction *instr, int depth)
         fprintf(fd, "Dst:\n");
         tac_print_val(fd, instr->u.copy_from_offset.dst, depth + 2);
         break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        print_indent(fd, depth + 1);
+        fprintf(fd, "SrcPtr:\n");
+        tac_print_val(fd, instr->u.block_copy.src_ptr, depth + 2);
+        print_indent(fd, depth + 1);
+        fprintf(fd, "DstPtr:\n");
+        tac_print_val(fd, instr->u.block_copy.dst_ptr, depth + 2);
+        print_indent(fd, depth + 1);
+        fprintf(fd, "Size: %d\n", instr->u.block_copy.size);
+        break;
     case TAC_INSTRUCTION_JUMP:
         print_indent(fd, depth + 1);
         fprintf(fd, "Target: %s\n", instr->u.jump.target ? instr->u.jump.target : "(null)");
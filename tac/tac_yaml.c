@@ -808,6 +808,17 @@ static void export_yaml_instruction(FILE *fd, const Tac_Instruction *instr, int
         fprintf(fd, "dst:\n");
         export_yaml_val(fd, instr->u.copy_from_offset.dst, level + 1);
         break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        fprintf(fd, "block_copy\n");
+        print_indent(fd, level);
+        fprintf(fd, "src_ptr:\n");
+        export_yaml_val(fd, instr->u.block_copy.src_ptr, level + 1);
+        print_indent(fd, level);
+        fprintf(fd, "dst_ptr:\n");
+        export_yaml_val(fd, instr->u.block_copy.dst_ptr, level + 1);
+        print_indent(fd, level);
+        fprintf(fd, "size: %d\n", instr->u.block_copy.size);
+        break;
     case TAC_INSTRUCTION_JUMP:
         fprintf(fd, "jump\n");
         print_indent(fd, level);
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <cstdio>
@@ -32,10 +33,11 @@ protected:
         xfree_all();
     }
 
-    Tac_Program *roundtrip(Tac_Program *prog)
+    Tac_Program *roundtrip(Tac_Program *prog, bool compact = false, bool with_index = false)
     {
         WFILE wout;
         wopen(&wout, tmppath, "w");
+        tac_export_begin_stream(&wout, compact, with_index);
         tac_export_program(&wout, prog);
         wclose(&wout);
 
@@ -58,7 +60,7 @@ protected:
     static Tac_Val *make_var(const char *name)
     {
         Tac_Val *val    = tac_new_val(TAC_VAL_VAR);
-        val->u.var_name = xstrdup(name);
+        val->u.var_name = tac_intern(name);
         return val;
     }
 
@@ -622,7 +624,7 @@ TEST_F(TacBinaryTest, JumpInstructions)
         Tac_Program *orig            = tac_new_program();
         orig->decls                  = make_empty_function("f", true);
         Tac_Instruction *instr       = tac_new_instruction(TAC_INSTRUCTION_JUMP);
-        instr->u.jump.target         = xstrdup("loop_end");
+        instr->u.jump.target         = tac_intern("loop_end");
         orig->decls->u.function.body = instr;
 
         Tac_Program *copy = roundtrip(orig);
@@ -635,7 +637,7 @@ TEST_F(TacBinaryTest, JumpInstructions)
         orig->decls                     = make_empty_function("f", true);
         Tac_Instruction *instr          = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_ZERO);
         instr->u.jump_if_zero.condition = make_var("cond");
-        instr->u.jump_if_zero.target    = xstrdup("false_lbl");
+        instr->u.jump_if_zero.target    = tac_intern("false_lbl");
         orig->decls->u.function.body    = instr;
 
         Tac_Program *copy = roundtrip(orig);
@@ -648,7 +650,7 @@ TEST_F(TacBinaryTest, JumpInstructions)
         orig->decls                         = make_empty_function("f", true);
         Tac_Instruction *instr              = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_NOT_ZERO);
         instr->u.jump_if_not_zero.condition = make_var("cond");
-        instr->u.jump_if_not_zero.target    = xstrdup("true_lbl");
+        instr->u.jump_if_not_zero.target    = tac_intern("true_lbl");
         orig->decls->u.function.body        = instr;
 
         Tac_Program *copy = roundtrip(orig);
@@ -660,7 +662,7 @@ TEST_F(TacBinaryTest, JumpInstructions)
         Tac_Program *orig            = tac_new_program();
         orig->decls                  = make_empty_function("f", true);
         Tac_Instruction *instr       = tac_new_instruction(TAC_INSTRUCTION_LABEL);
-        instr->u.label.name          = xstrdup("loop_start");
+        instr->u.label.name          = tac_intern("loop_start");
         orig->decls->u.function.body = instr;
 
         Tac_Program *copy = roundtrip(orig);
@@ -719,7 +721,7 @@ TEST_F(TacBinaryTest, InstructionSequence)
     orig->decls       = make_empty_function("f", true);
 
     Tac_Instruction *lbl = tac_new_instruction(TAC_INSTRUCTION_LABEL);
-    lbl->u.label.name    = xstrdup("entry");
+    lbl->u.label.name    = tac_intern("entry");
 
     Tac_Instruction *ret = tac_new_instruction(TAC_INSTRUCTION_RETURN);
     ret->u.return_.src   = make_const_int(0);
@@ -734,6 +736,29 @@ TEST_F(TacBinaryTest, InstructionSequence)
     tac_free_program(copy);
 }
 
+// Lists are written, read, compared and freed in loops: a body of 200000 instructions
+// must not exhaust the stack.
+TEST_F(TacBinaryTest, LongInstructionList)
+{
+    Tac_Program *orig = tac_new_program();
+    orig->decls       = make_empty_function("f", true);
+
+    Tac_Instruction **tail = &orig->decls->u.function.body;
+    for (int i = 0; i < 200000; i++) {
+        Tac_Instruction *copy = tac_new_instruction(TAC_INSTRUCTION_COPY);
+        copy->u.copy.src      = make_const_int(i);
+        copy->u.copy.dst      = make_var("x");
+        *tail                 = copy;
+        tail                  = &copy->next;
+    }
+
+    Tac_Program *copy = roundtrip(orig, true);
+    EXPECT_TRUE(tac_compare_program(orig, copy));
+
+    tac_free_program(orig);
+    tac_free_program(copy);
+}
+
 // ---------------------------------------------------------------------------
 // Types
 // ---------------------------------------------------------------------------
@@ -1036,3 +1061,223 @@ TEST_F(TacBinaryTest, AllocateLocal)
     tac_free_program(orig);
     tac_free_program(copy);
 }
+
+// ---------------------------------------------------------------------------
+// Compact encoding
+// ---------------------------------------------------------------------------
+
+// Extreme values must survive the zigzag/varint encoding unchanged.
+TEST_F(TacBinaryTest, CompactExtremeConstants)
+{
+    const int64_t values[] = { 0, -1, 1, 63, -64, 64, INT32_MIN, INT32_MAX, INT64_MIN, INT64_MAX };
+
+    for (int64_t v : values) {
+        Tac_Const *c                 = tac_new_const(TAC_CONST_LONG_LONG);
+        c->u.long_long_val           = v;
+        Tac_Val *val                 = tac_new_val(TAC_VAL_CONSTANT);
+        val->u.constant              = c;
+        Tac_Instruction *i           = tac_new_instruction(TAC_INSTRUCTION_RETURN);
+        i->u.return_.src             = val;
+        Tac_Program *orig            = tac_new_program();
+        orig->decls                  = make_empty_function("f", true);
+        orig->decls->u.function.body = i;
+
+        Tac_Program *copy = roundtrip(orig, true);
+        EXPECT_TRUE(tac_compare_program(orig, copy)) << "value=" << v;
+
+        tac_free_program(orig);
+        tac_free_program(copy);
+    }
+}
+
+// A function body of the usual shape: temporaries reused across many instructions,
+// small constants, a static with a negative initializer.  Both encodings must give
+// back the same program, and the compact one must be well under half the size.
+TEST_F(TacBinaryTest, CompactRoundTripAndSize)
+{
+    Tac_Program *orig = tac_new_program();
+    Tac_TopLevel *fn  = make_empty_function("accumulate", true);
+
+    Tac_Instruction **tail = &fn->u.function.body;
+    for (int n = 0; n < 200; n++) {
+        Tac_Instruction *add = tac_new_instruction(TAC_INSTRUCTION_BINARY);
+        add->u.binary.op     = TAC_BINARY_ADD;
+        add->u.binary.src1   = make_var("sum.1");
+        add->u.binary.src2   = make_const_int(n - 100);
+        add->u.binary.dst    = make_var("%tmp.7");
+        Tac_Instruction *cp  = tac_new_instruction(TAC_INSTRUCTION_COPY);
+        cp->u.copy.src       = make_var("%tmp.7");
+        cp->u.copy.dst       = make_var("sum.1");
+        add->next            = cp;
+        *tail                = add;
+        tail                 = &cp->next;
+    }
+    Tac_Instruction *ret = tac_new_instruction(TAC_INSTRUCTION_RETURN);
+    ret->u.return_.src   = make_var("sum.1");
+    *tail                = ret;
+
+    Tac_TopLevel *sv                = tac_new_toplevel(TAC_TOPLEVEL_STATIC_VARIABLE);
+    sv->u.static_variable.name      = xstrdup("bias");
+    sv->u.static_variable.type      = tac_new_type(TAC_TYPE_INT);
+    Tac_StaticInit *si              = tac_new_static_init(TAC_STATIC_INIT_I32);
+    si->u.int_val                   = -5;
+    sv->u.static_variable.init_list = si;
+    fn->next                        = sv;
+    orig->decls                     = fn;
+
+    struct stat st;
+    Tac_Program *words = roundtrip(orig, false);
+    ASSERT_EQ(stat(tmppath, &st), 0);
+    off_t word_size = st.st_size;
+    EXPECT_TRUE(tac_compare_program(orig, words));
+
+    Tac_Program *compact = roundtrip(orig, true);
+    ASSERT_EQ(stat(tmppath, &st), 0);
+    off_t compact_size = st.st_size;
+    EXPECT_TRUE(tac_compare_program(orig, compact));
+
+    EXPECT_LT(compact_size * 3, word_size) << "compact " << compact_size << " vs word "
+                                           << word_size << " bytes";
+
+    tac_free_program(orig);
+    tac_free_program(words);
+    tac_free_program(compact);
+}
+
+// ---------------------------------------------------------------------------
+// Interned names
+// ---------------------------------------------------------------------------
+
+// Every occurrence of a variable or label name comes back as the one interned string,
+// so that the optimizer and backend can compare names by address.
+TEST_F(TacBinaryTest, ImportInternsNames)
+{
+    Tac_Program *orig      = tac_new_program();
+    orig->decls            = make_empty_function("f", true);
+    Tac_Instruction *lbl   = tac_new_instruction(TAC_INSTRUCTION_LABEL);
+    lbl->u.label.name      = tac_intern("%L1");
+    Tac_Instruction *cp    = tac_new_instruction(TAC_INSTRUCTION_COPY);
+    cp->u.copy.src         = make_var("%7");
+    cp->u.copy.dst         = make_var("x");
+    Tac_Instruction *jmp   = tac_new_instruction(TAC_INSTRUCTION_JUMP);
+    jmp->u.jump.target     = tac_intern("%L1");
+    Tac_Instruction *ret   = tac_new_instruction(TAC_INSTRUCTION_RETURN);
+    ret->u.return_.src     = make_var("%7");
+    lbl->next              = cp;
+    cp->next               = jmp;
+    jmp->next              = ret;
+
+    orig->decls->u.function.body = lbl;
+
+    for (bool compact : { false, true }) {
+        Tac_Program *copy = roundtrip(orig, compact);
+        ASSERT_NE(nullptr, copy);
+        EXPECT_TRUE(tac_compare_program(orig, copy));
+
+        const Tac_Instruction *body = copy->decls->u.function.body;
+        const Tac_Instruction *rjmp = body->next->next;
+        const Tac_Instruction *rret = rjmp->next;
+        EXPECT_EQ(body->u.label.name, rjmp->u.jump.target);
+        EXPECT_EQ(body->next->u.copy.src->u.var_name, rret->u.return_.src->u.var_name);
+        EXPECT_EQ(rret->u.return_.src->u.var_name, tac_intern("%7"));
+        tac_free_program(copy);
+    }
+    tac_free_program(orig);
+}
+
+// ---------------------------------------------------------------------------
+// Trailing index and random access
+// ---------------------------------------------------------------------------
+
+// Compare one toplevel, ignoring the rest of its chain.
+static bool same_toplevel(Tac_TopLevel *a, Tac_TopLevel *b)
+{
+    Tac_TopLevel *next = a->next;
+    a->next            = nullptr;
+    bool same          = tac_compare_toplevel(a, b);
+    a->next            = next;
+    return same;
+}
+
+TEST_F(TacBinaryTest, IndexRandomAccess)
+{
+    Tac_Program *orig   = tac_new_program();
+    Tac_TopLevel **tail = &orig->decls;
+    for (const char *name : { "first", "second", "third" }) {
+        Tac_TopLevel *fn     = make_empty_function(name, true);
+        Tac_Instruction *cp  = tac_new_instruction(TAC_INSTRUCTION_COPY);
+        cp->u.copy.src       = make_const_int(7);
+        cp->u.copy.dst       = make_var("%1");
+        Tac_Instruction *ret = tac_new_instruction(TAC_INSTRUCTION_RETURN);
+        ret->u.return_.src   = make_var("%1");
+        cp->next             = ret;
+        fn->u.function.body  = cp;
+        *tail                = fn;
+        tail                 = &fn->next;
+    }
+    Tac_TopLevel *sv                = tac_new_toplevel(TAC_TOPLEVEL_STATIC_VARIABLE);
+    sv->u.static_variable.name      = xstrdup("counter");
+    sv->u.static_variable.type      = tac_new_type(TAC_TYPE_INT);
+    sv->u.static_variable.init_list = tac_new_static_init(TAC_STATIC_INIT_I32);
+    *tail                           = sv;
+    Tac_TopLevel *third             = orig->decls->next->next;
+
+    for (bool compact : { false, true }) {
+        // Sequential readers stop at TAG_EOL, before the index.
+        Tac_Program *copy = roundtrip(orig, compact, true);
+        EXPECT_TRUE(tac_compare_program(orig, copy));
+        tac_free_program(copy);
+
+        WFILE win;
+        wopen(&win, tmppath, "r");
+        Tac_Index *index = tac_import_index(&win);
+        ASSERT_NE(nullptr, index);
+        ASSERT_EQ(index->count, 4u);
+        EXPECT_STREQ(index->entries[0].name, "first");
+        EXPECT_EQ(index->entries[3].kind, TAC_TOPLEVEL_STATIC_VARIABLE);
+
+        // The name is part of the hashed bytes.
+        EXPECT_NE(index->entries[0].hash, index->entries[1].hash);
+        EXPECT_LT(index->entries[0].offset, index->entries[1].offset);
+
+        EXPECT_EQ(nullptr, tac_lookup(index, "missing"));
+        const Tac_IndexEntry *e = tac_lookup(index, "third");
+        ASSERT_NE(nullptr, e);
+        Tac_TopLevel *tl = tac_import_toplevel_at(&win, e);
+        EXPECT_TRUE(same_toplevel(third, tl));
+        tac_free_toplevel(tl);
+
+        // Backwards, and a data toplevel.
+        tl = tac_import_toplevel_at(&win, tac_lookup(index, "first"));
+        EXPECT_TRUE(same_toplevel(orig->decls, tl));
+        tac_free_toplevel(tl);
+        tl = tac_import_toplevel_at(&win, tac_lookup(index, "counter"));
+        EXPECT_TRUE(same_toplevel(sv, tl));
+        tac_free_toplevel(tl);
+
+        tac_free_index(index);
+        wclose(&win);
+    }
+    tac_free_program(orig);
+}
+
+// Without an index, tac_import_index() leaves the stream ready for sequential reading.
+TEST_F(TacBinaryTest, IndexAbsent)
+{
+    Tac_Program *orig = tac_new_program();
+    orig->decls       = make_empty_function("only", false);
+
+    for (bool compact : { false, true }) {
+        Tac_Program *copy = roundtrip(orig, compact, false);
+        tac_free_program(copy);
+
+        WFILE win;
+        wopen(&win, tmppath, "r");
+        EXPECT_EQ(nullptr, tac_import_index(&win));
+        copy = tac_import_program(&win);
+        EXPECT_TRUE(tac_compare_program(orig, copy));
+        tac_free_program(copy);
+        wclose(&win);
+    }
+    tac_free_program(orig);
+}
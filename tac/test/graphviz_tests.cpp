@@ -65,7 +65,7 @@ protected:
     static Tac_Val *make_var(const char *name)
     {
         Tac_Val *val    = tac_new_val(TAC_VAL_VAR);
-        val->u.var_name = xstrdup(name);
+        val->u.var_name = tac_intern(name);
         return val;
     }
 
@@ -588,7 +588,7 @@ TEST_F(TacDotTest, InstructionJump)
 {
     Tac_TopLevel *tl       = make_empty_function("f", true);
     Tac_Instruction *instr = tac_new_instruction(TAC_INSTRUCTION_JUMP);
-    instr->u.jump.target   = xstrdup("loop_end");
+    instr->u.jump.target   = tac_intern("loop_end");
     tl->u.function.body    = instr;
 
     std::string out = capture(tl);
@@ -604,7 +604,7 @@ TEST_F(TacDotTest, InstructionJumpIfZero)
     Tac_TopLevel *tl                = make_empty_function("f", true);
     Tac_Instruction *instr          = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_ZERO);
     instr->u.jump_if_zero.condition = make_var("flag");
-    instr->u.jump_if_zero.target    = xstrdup("done");
+    instr->u.jump_if_zero.target    = tac_intern("done");
     tl->u.function.body             = instr;
 
     std::string out = capture(tl);
@@ -620,7 +620,7 @@ TEST_F(TacDotTest, InstructionJumpIfNotZero)
     Tac_TopLevel *tl                    = make_empty_function("f", true);
     Tac_Instruction *instr              = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_NOT_ZERO);
     instr->u.jump_if_not_zero.condition = make_var("flag");
-    instr->u.jump_if_not_zero.target    = xstrdup("loop_top");
+    instr->u.jump_if_not_zero.target    = tac_intern("loop_top");
     tl->u.function.body                 = instr;
 
     std::string out = capture(tl);
@@ -634,7 +634,7 @@ TEST_F(TacDotTest, InstructionLabel)
 {
     Tac_TopLevel *tl       = make_empty_function("f", true);
     Tac_Instruction *instr = tac_new_instruction(TAC_INSTRUCTION_LABEL);
-    instr->u.label.name    = xstrdup("loop_start");
+    instr->u.label.name    = tac_intern("loop_start");
     tl->u.function.body    = instr;
 
     std::string out = capture(tl);
@@ -1094,7 +1094,7 @@ TEST_F(TacDotTest, MultipleInstructions)
     i1->u.copy.dst      = make_var("x");
 
     Tac_Instruction *i2 = tac_new_instruction(TAC_INSTRUCTION_LABEL);
-    i2->u.label.name    = xstrdup("top");
+    i2->u.label.name    = tac_intern("top");
 
     Tac_Instruction *i3 = tac_new_instruction(TAC_INSTRUCTION_RETURN);
     i3->u.return_.src   = make_var("x");
@@ -51,7 +51,7 @@ protected:
     static Tac_Val *make_var(const char *name)
     {
         Tac_Val *val    = tac_new_val(TAC_VAL_VAR);
-        val->u.var_name = xstrdup(name);
+        val->u.var_name = tac_intern(name);
         return val;
     }
 
@@ -575,7 +575,7 @@ TEST_F(TacYamlTest, JumpInstruction)
 {
     Tac_TopLevel *tl       = make_empty_function("f", true);
     Tac_Instruction *instr = tac_new_instruction(TAC_INSTRUCTION_JUMP);
-    instr->u.jump.target   = xstrdup("loop_end");
+    instr->u.jump.target   = tac_intern("loop_end");
     tl->u.function.body    = instr;
 
     std::string out = capture(tl);
@@ -589,7 +589,7 @@ TEST_F(TacYamlTest, LabelInstruction)
 {
     Tac_TopLevel *tl       = make_empty_function("f", true);
     Tac_Instruction *instr = tac_new_instruction(TAC_INSTRUCTION_LABEL);
-    instr->u.label.name    = xstrdup("loop_start");
+    instr->u.label.name    = tac_intern("loop_start");
     tl->u.function.body    = instr;
 
     std::string out = capture(tl);
@@ -604,7 +604,7 @@ TEST_F(TacYamlTest, JumpIfZeroInstruction)
     Tac_TopLevel *tl                = make_empty_function("f", true);
     Tac_Instruction *instr          = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_ZERO);
     instr->u.jump_if_zero.condition = make_var("cond");
-    instr->u.jump_if_zero.target    = xstrdup("false_lbl");
+    instr->u.jump_if_zero.target    = tac_intern("false_lbl");
     tl->u.function.body             = instr;
 
     std::string out = capture(tl);
@@ -620,7 +620,7 @@ TEST_F(TacYamlTest, JumpIfNotZeroInstruction)
     Tac_TopLevel *tl                    = make_empty_function("f", true);
     Tac_Instruction *instr              = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_NOT_ZERO);
     instr->u.jump_if_not_zero.condition = make_var("cond");
-    instr->u.jump_if_not_zero.target    = xstrdup("true_lbl");
+    instr->u.jump_if_not_zero.target    = tac_intern("true_lbl");
     tl->u.function.body                 = instr;
 
     std::string out = capture(tl);
@@ -682,7 +682,7 @@ TEST_F(TacYamlTest, InstructionSequence)
     Tac_TopLevel *tl = make_empty_function("f", true);
 
     Tac_Instruction *lbl = tac_new_instruction(TAC_INSTRUCTION_LABEL);
-    lbl->u.label.name    = xstrdup("entry");
+    lbl->u.label.name    = tac_intern("entry");
 
     Tac_Instruction *ret = tac_new_instruction(TAC_INSTRUCTION_RETURN);
     ret->u.return_.src   = make_const_int(0);
@@ -0,0 +1,648 @@
+//
+// TAC interpreter: the execution loop and the dynamic counts.
+//
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal.h"
+#include "target.h"
+#include "xalloc.h"
+
+//
+// Function being executed, for trap messages.
+//
+static const Tr_Function *current;
+
+_Noreturn void tr_trap(const Tacrun *vm, const char *message, ...)
+{
+    fflush(vm->out);
+    fprintf(stderr, "tacrun: ");
+    if (current)
+        fprintf(stderr, "in %s: ", current->name);
+
+    va_list ap;
+    va_start(ap, message);
+    vfprintf(stderr, message, ap);
+    va_end(ap);
+
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+//
+// Value widths.  A signed result is kept in the low int_bits of the word, with the bits
+// above it clear; an unsigned result uses the whole word.
+//
+uint64_t tr_mask(const Tacrun *vm, uint64_t word)
+{
+    return unsigned_narrow(word, vm->word_bits);
+}
+
+uint64_t tr_int(const Tacrun *vm, int64_t value)
+{
+    return unsigned_narrow((uint64_t)value, vm->int_bits);
+}
+
+int64_t tr_signed(const Tacrun *vm, uint64_t word)
+{
+    return sign_narrow(word, vm->int_bits);
+}
+
+uint64_t tr_double_word(double d)
+{
+    uint64_t word;
+    memcpy(&word, &d, sizeof(word));
+    return word;
+}
+
+double tr_word_double(uint64_t word)
+{
+    double d;
+    memcpy(&d, &word, sizeof(d));
+    return d;
+}
+
+uint64_t tr_check_address(const Tacrun *vm, uint64_t addr)
+{
+    addr &= TR_ADDR_MASK;
+    if (addr == 0)
+        tr_trap(vm, "null pointer dereference");
+    return addr;
+}
+
+uint64_t tr_byte_pos(const Tacrun *vm, uint64_t ptr)
+{
+    uint64_t pos = (ptr & TR_ADDR_MASK) * vm->word_bytes;
+    if (ptr & TR_FAT_MARKER)
+        pos += vm->word_bytes - 1 - ((ptr >> TR_FAT_SHIFT) & 7);
+    return pos;
+}
+
+uint64_t tr_fat_pointer(const Tacrun *vm, uint64_t pos)
+{
+    uint64_t byte = pos % vm->word_bytes;
+    return TR_FAT_MARKER | (vm->word_bytes - 1 - byte) << TR_FAT_SHIFT |
+           ((pos / vm->word_bytes) & TR_ADDR_MASK);
+}
+
+unsigned tr_get_byte(const Tacrun *vm, uint64_t pos)
+{
+    uint64_t addr  = tr_check_address(vm, pos / vm->word_bytes);
+    unsigned shift = (vm->word_bytes - 1 - pos % vm->word_bytes) * 8;
+    return (vm->mem[addr] >> shift) & 0xff;
+}
+
+void tr_put_byte(Tacrun *vm, uint64_t pos, unsigned byte)
+{
+    uint64_t addr  = tr_check_address(vm, pos / vm->word_bytes);
+    unsigned shift = (vm->word_bytes - 1 - pos % vm->word_bytes) * 8;
+    vm->mem[addr]  = (vm->mem[addr] & ~((uint64_t)0xff << shift)) | (uint64_t)(byte & 0xff)
+                                                                        << shift;
+}
+
+static inline uint64_t get(const Tacrun *vm, uint64_t fp, const Tr_Operand *o)
+{
+    switch (o->where) {
+    case TR_CONST:
+        return o->value;
+    case TR_FRAME:
+        return vm->mem[fp + o->value];
+    case TR_GLOBAL:
+        return vm->mem[o->value];
+    default:
+        return 0;
+    }
+}
+
+static inline void put(Tacrun *vm, uint64_t fp, const Tr_Operand *o, uint64_t word)
+{
+    if (o->where == TR_FRAME)
+        vm->mem[fp + o->value] = word;
+    else if (o->where == TR_GLOBAL)
+        vm->mem[o->value] = word;
+}
+
+//
+// Word address of a named object: a frame slot or a static.
+//
+static inline uint64_t address_of(uint64_t fp, const Tr_Operand *o)
+{
+    return o->where == TR_FRAME ? fp + o->value : o->value;
+}
+
+static uint64_t unary(const Tacrun *vm, int op, uint64_t a)
+{
+    switch (op) {
+    case TAC_UNARY_COMPLEMENT:
+        return tr_int(vm, ~tr_signed(vm, a));
+    case TAC_UNARY_NEGATE:
+        return tr_int(vm, -tr_signed(vm, a));
+    case TAC_UNARY_NOT:
+        return a == 0;
+    case TAC_UNARY_NEGATE_UNSIGNED:
+        return tr_mask(vm, -a);
+    case TAC_UNARY_NEGATE_DOUBLE:
+        return tr_double_word(-tr_word_double(a));
+    case TAC_UNARY_COMPLEMENT_UNSIGNED:
+        return tr_mask(vm, ~a);
+    }
+    tr_trap(vm, "unknown unary operator %d", op);
+}
+
+static uint64_t shift_count(const Tacrun *vm, uint64_t b)
+{
+    int64_t n = tr_signed(vm, b);
+    return (n < 0 || n >= vm->word_bits) ? (uint64_t)vm->word_bits : (uint64_t)n;
+}
+
+static uint64_t binary(const Tacrun *vm, int op, uint64_t a, uint64_t b)
+{
+    const int64_t sa = tr_signed(vm, a), sb = tr_signed(vm, b);
+    const uint64_t ua = tr_mask(vm, a), ub = tr_mask(vm, b);
+    uint64_t n;
+
+    switch (op) {
+    case TAC_BINARY_ADD:
+        return tr_int(vm, (int64_t)((uint64_t)sa + (uint64_t)sb));
+    case TAC_BINARY_SUBTRACT:
+        return tr_int(vm, (int64_t)((uint64_t)sa - (uint64_t)sb));
+    case TAC_BINARY_MULTIPLY:
+        return tr_int(vm, (int64_t)((uint64_t)sa * (uint64_t)sb));
+    case TAC_BINARY_DIVIDE:
+        if (sb == 0)
+            tr_trap(vm, "division by zero");
+        return tr_int(vm, sa / sb);
+    case TAC_BINARY_REMAINDER:
+        if (sb == 0)
+            tr_trap(vm, "division by zero");
+        return tr_int(vm, sa % sb);
+    case TAC_BINARY_EQUAL:
+        return a == b;
+    case TAC_BINARY_NOT_EQUAL:
+        return a != b;
+    case TAC_BINARY_LESS_THAN:
+        return sa < sb;
+    case TAC_BINARY_LESS_OR_EQUAL:
+        return sa <= sb;
+    case TAC_BINARY_GREATER_THAN:
+        return sa > sb;
+    case TAC_BINARY_GREATER_OR_EQUAL:
+        return sa >= sb;
+    case TAC_BINARY_BITWISE_AND:
+        return a & b;
+    case TAC_BINARY_BITWISE_OR:
+        return a | b;
+    case TAC_BINARY_BITWISE_XOR:
+        return a ^ b;
+    case TAC_BINARY_LEFT_SHIFT:
+        n = shift_count(vm, b);
+        return n >= (uint64_t)vm->word_bits ? 0 : tr_mask(vm, a << n);
+    case TAC_BINARY_RIGHT_SHIFT:
+        n = shift_count(vm, b);
+        if (vm->logical_shift)
+            return n >= (uint64_t)vm->word_bits ? 0 : ua >> n;
+        return tr_int(vm, sa >> (n >= (uint64_t)vm->int_bits ? vm->int_bits - 1 : (int)n));
+    case TAC_BINARY_RIGHT_SHIFT_LOGICAL:
+        n = shift_count(vm, b);
+        return n >= (uint64_t)vm->word_bits ? 0 : ua >> n;
+    case TAC_BINARY_DIVIDE_UNSIGNED:
+        if (ub == 0)
+            tr_trap(vm, "division by zero");
+        return ua / ub;
+    case TAC_BINARY_REMAINDER_UNSIGNED:
+        if (ub == 0)
+            tr_trap(vm, "division by zero");
+        return ua % ub;
+    case TAC_BINARY_LESS_THAN_UNSIGNED:
+        return ua < ub;
+    case TAC_BINARY_LESS_OR_EQUAL_UNSIGNED:
+        return ua <= ub;
+    case TAC_BINARY_GREATER_THAN_UNSIGNED:
+        return ua > ub;
+    case TAC_BINARY_GREATER_OR_EQUAL_UNSIGNED:
+        return ua >= ub;
+    case TAC_BINARY_ADD_UNSIGNED:
+        return tr_mask(vm, ua + ub);
+    case TAC_BINARY_SUBTRACT_UNSIGNED:
+        return tr_mask(vm, ua - ub);
+    case TAC_BINARY_MULTIPLY_UNSIGNED:
+        return tr_mask(vm, ua * ub);
+    case TAC_BINARY_ADD_DOUBLE:
+        return tr_double_word(tr_word_double(a) + tr_word_double(b));
+    case TAC_BINARY_SUBTRACT_DOUBLE:
+        return tr_double_word(tr_word_double(a) - tr_word_double(b));
+    case TAC_BINARY_MULTIPLY_DOUBLE:
+        return tr_double_word(tr_word_double(a) * tr_word_double(b));
+    case TAC_BINARY_DIVIDE_DOUBLE:
+        return tr_double_word(tr_word_double(a) / tr_word_double(b));
+    case TAC_BINARY_LESS_THAN_DOUBLE:
+        return tr_word_double(a) < tr_word_double(b);
+    case TAC_BINARY_LESS_OR_EQUAL_DOUBLE:
+        return tr_word_double(a) <= tr_word_double(b);
+    case TAC_BINARY_GREATER_THAN_DOUBLE:
+        return tr_word_double(a) > tr_word_double(b);
+    case TAC_BINARY_GREATER_OR_EQUAL_DOUBLE:
+        return tr_word_double(a) >= tr_word_double(b);
+    }
+    tr_trap(vm, "unknown binary operator %d", op);
+}
+
+//
+// Floating-point to integer conversions.  Out-of-range values are undefined in C;
+// they wrap here.
+//
+static uint64_t double_to_int(const Tacrun *vm, uint64_t a)
+{
+    return tr_int(vm, (int64_t)tr_word_double(a));
+}
+
+static uint64_t double_to_uint(const Tacrun *vm, uint64_t a)
+{
+    double d = tr_word_double(a);
+    return tr_mask(vm, d < 0 ? (uint64_t)(int64_t)d : (uint64_t)d);
+}
+
+//
+// Reserve a frame of `nwords` below the stack pointer.
+//
+static uint64_t push_frame(Tacrun *vm, uint64_t nwords)
+{
+    if (vm->sp < vm->heap_top + nwords)
+        tr_trap(vm, "stack overflow");
+    vm->sp -= nwords;
+    return vm->sp;
+}
+
+//
+// Call through a pointer: the address must be the code word of a function.
+//
+static Tr_Function *callee_at(const Tacrun *vm, uint64_t ptr)
+{
+    uint64_t addr = ptr & TR_ADDR_MASK;
+    if (addr == 0 || addr > (uint64_t)vm->nfuncs)
+        tr_trap(vm, "call through pointer %#llo, which is not a function",
+                (unsigned long long)ptr);
+    return vm->funcs[addr - 1];
+}
+
+//
+// Evaluate the arguments of a call into a new frame and run the callee.
+//
+static uint64_t call_op(Tacrun *vm, uint64_t fp, const Tr_Op *op)
+{
+    Tr_Function *fn   = op->callee ? op->callee : callee_at(vm, get(vm, fp, &op->src1));
+    uint64_t nparams  = fn->nparams > op->nargs ? fn->nparams : op->nargs;
+    uint64_t saved_sp = vm->sp;
+    uint64_t callee   = push_frame(vm, fn->nautos + nparams);
+
+    for (int i = 0; i < op->nargs; i++)
+        vm->mem[callee + fn->nautos + i] = get(vm, fp, &op->args[i]);
+    for (uint64_t i = op->nargs; i < nparams; i++)
+        vm->mem[callee + fn->nautos + i] = 0;
+
+    uint64_t result = tr_call(vm, fn, callee, op->nargs);
+    vm->sp          = saved_sp;
+    return result;
+}
+
+//
+// Take the jump at `pc` to the label at `target`: count it, and return the pc the loop
+// steps past the label from.
+//
+static long jump(Tr_Function *fn, long pc, long target)
+{
+    fn->taken[pc]++;
+    fn->entries[target]++;
+    return target;
+}
+
+uint64_t tr_call(Tacrun *vm, Tr_Function *fn, uint64_t fp, int nargs)
+{
+    const Tr_Function *caller = current;
+    fn->calls++;
+    if (fn->builtin) {
+        uint64_t result = fn->builtin(vm, &vm->mem[fp + fn->nautos], nargs);
+        current         = caller;
+        return result;
+    }
+    current = fn;
+    memset(&vm->mem[fp], 0, fn->nautos * sizeof(uint64_t));
+
+    const Tr_Op *ops = fn->ops;
+    uint64_t result  = 0;
+    for (long pc = 0; pc < fn->nops; pc++) {
+        const Tr_Op *op = &ops[pc];
+        uint64_t a, b;
+
+        fn->instructions++;
+        fn->entries[pc]++;
+        vm->instructions++;
+        vm->kind_counts[op->kind]++;
+
+        switch (op->kind) {
+        case TAC_INSTRUCTION_RETURN:
+            result = get(vm, fp, &op->src1);
+            goto done;
+        case TAC_INSTRUCTION_SIGN_EXTEND:
+            put(vm, fp, &op->dst, tr_int(vm, (int8_t)(get(vm, fp, &op->src1) & 0xff)));
+            break;
+        case TAC_INSTRUCTION_TRUNCATE:
+        case TAC_INSTRUCTION_ZERO_EXTEND:
+            put(vm, fp, &op->dst, get(vm, fp, &op->src1) & 0xff);
+            break;
+        case TAC_INSTRUCTION_DOUBLE_TO_INT:
+        case TAC_INSTRUCTION_FLOAT_TO_INT:
+        case TAC_INSTRUCTION_LONG_DOUBLE_TO_INT:
+            put(vm, fp, &op->dst, double_to_int(vm, get(vm, fp, &op->src1)));
+            break;
+        case TAC_INSTRUCTION_DOUBLE_TO_UINT:
+        case TAC_INSTRUCTION_FLOAT_TO_UINT:
+        case TAC_INSTRUCTION_LONG_DOUBLE_TO_UINT:
+            put(vm, fp, &op->dst, double_to_uint(vm, get(vm, fp, &op->src1)));
+            break;
+        case TAC_INSTRUCTION_INT_TO_DOUBLE:
+        case TAC_INSTRUCTION_INT_TO_FLOAT:
+        case TAC_INSTRUCTION_INT_TO_LONG_DOUBLE:
+            a = get(vm, fp, &op->src1);
+            put(vm, fp, &op->dst, tr_double_word((double)tr_signed(vm, a)));
+            break;
+        case TAC_INSTRUCTION_UINT_TO_DOUBLE:
+        case TAC_INSTRUCTION_UINT_TO_FLOAT:
+        case TAC_INSTRUCTION_UINT_TO_LONG_DOUBLE:
+            a = get(vm, fp, &op->src1);
+            put(vm, fp, &op->dst, tr_double_word((double)tr_mask(vm, a)));
+            break;
+        case TAC_INSTRUCTION_FLOAT_TO_DOUBLE:
+        case TAC_INSTRUCTION_DOUBLE_TO_FLOAT:
+        case TAC_INSTRUCTION_LONG_DOUBLE_TO_DOUBLE:
+        case TAC_INSTRUCTION_DOUBLE_TO_LONG_DOUBLE:
+        case TAC_INSTRUCTION_LONG_DOUBLE_TO_FLOAT:
+        case TAC_INSTRUCTION_FLOAT_TO_LONG_DOUBLE:
+        case TAC_INSTRUCTION_COPY:
+            put(vm, fp, &op->dst, get(vm, fp, &op->src1));
+            break;
+        case TAC_INSTRUCTION_PTR_TO_CHAR_PTR:
+            a = get(vm, fp, &op->src1) & TR_ADDR_MASK;
+            put(vm, fp, &op->dst, tr_fat_pointer(vm, a * vm->word_bytes));
+            break;
+        case TAC_INSTRUCTION_CHAR_PTR_TO_PTR:
+            put(vm, fp, &op->dst, get(vm, fp, &op->src1) & TR_ADDR_MASK);
+            break;
+        case TAC_INSTRUCTION_UNARY:
+            put(vm, fp, &op->dst, unary(vm, op->op, get(vm, fp, &op->src1)));
+            break;
+        case TAC_INSTRUCTION_BINARY:
+            a = get(vm, fp, &op->src1);
+            b = get(vm, fp, &op->src2);
+            put(vm, fp, &op->dst, binary(vm, op->op, a, b));
+            break;
+        case TAC_INSTRUCTION_GET_ADDRESS:
+            put(vm, fp, &op->dst, address_of(fp, &op->src1));
+            break;
+        case TAC_INSTRUCTION_GET_ADDRESS_BYTE:
+            // A standalone char sits in the low byte of its word.
+            a = address_of(fp, &op->src1);
+            put(vm, fp, &op->dst, tr_fat_pointer(vm, a * vm->word_bytes + vm->word_bytes - 1));
+            break;
+        case TAC_INSTRUCTION_GET_ADDRESS_DECAY:
+            a = address_of(fp, &op->src1);
+            put(vm, fp, &op->dst, tr_fat_pointer(vm, a * vm->word_bytes));
+            break;
+        case TAC_INSTRUCTION_LOAD:
+            a = tr_check_address(vm, get(vm, fp, &op->src1));
+            put(vm, fp, &op->dst, vm->mem[a]);
+            break;
+        case TAC_INSTRUCTION_LOAD_BYTE:
+            a = tr_byte_pos(vm, get(vm, fp, &op->src1));
+            put(vm, fp, &op->dst, tr_get_byte(vm, a));
+            break;
+        case TAC_INSTRUCTION_STORE:
+            a          = tr_check_address(vm, get(vm, fp, &op->dst));
+            vm->mem[a] = get(vm, fp, &op->src1);
+            break;
+        case TAC_INSTRUCTION_STORE_BYTE:
+            a = tr_byte_pos(vm, get(vm, fp, &op->dst));
+            tr_put_byte(vm, a, (unsigned)get(vm, fp, &op->src1));
+            break;
+        case TAC_INSTRUCTION_ADD_PTR:
+            a = get(vm, fp, &op->src1);
+            b = (uint64_t)tr_signed(vm, get(vm, fp, &op->src2));
+            if (op->imm == 1) {
+                put(vm, fp, &op->dst, tr_fat_pointer(vm, tr_byte_pos(vm, a) + b));
+            } else {
+                uint64_t addr = a + b * (op->imm / vm->word_bytes);
+                put(vm, fp, &op->dst, (a & ~(uint64_t)TR_ADDR_MASK) | (addr & TR_ADDR_MASK));
+            }
+            break;
+        case TAC_INSTRUCTION_PTR_DIFF:
+            a = tr_byte_pos(vm, get(vm, fp, &op->src1));
+            b = tr_byte_pos(vm, get(vm, fp, &op->src2));
+            put(vm, fp, &op->dst, tr_int(vm, (int64_t)(a - b)));
+            break;
+        case TAC_INSTRUCTION_COPY_TO_OFFSET:
+            a          = address_of(fp, &op->dst) + op->imm / vm->word_bytes;
+            vm->mem[a] = get(vm, fp, &op->src1);
+            break;
+        case TAC_INSTRUCTION_COPY_BYTE_TO_OFFSET:
+            a = address_of(fp, &op->dst) * vm->word_bytes + op->imm;
+            tr_put_byte(vm, a, (unsigned)get(vm, fp, &op->src1));
+            break;
+        case TAC_INSTRUCTION_COPY_FROM_OFFSET:
+            a = address_of(fp, &op->src1) + op->imm / vm->word_bytes;
+            put(vm, fp, &op->dst, vm->mem[a]);
+            break;
+        case TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET:
+            a = address_of(fp, &op->src1) * vm->word_bytes + op->imm;
+            put(vm, fp, &op->dst, tr_get_byte(vm, a));
+            break;
+        case TAC_INSTRUCTION_BLOCK_COPY:
+            a = tr_check_address(vm, get(vm, fp, &op->src1));
+            b = tr_check_address(vm, get(vm, fp, &op->dst));
+            if (a + op->imm > TR_MEM_WORDS || b + op->imm > TR_MEM_WORDS)
+                tr_trap(vm, "block copy beyond the end of memory");
+            memmove(&vm->mem[b], &vm->mem[a], (size_t)op->imm * sizeof(vm->mem[0]));
+            break;
+        case TAC_INSTRUCTION_JUMP:
+            pc = jump(fn, pc, op->imm);
+            break;
+        case TAC_INSTRUCTION_JUMP_IF_ZERO:
+            if (get(vm, fp, &op->src1) == 0)
+                pc = jump(fn, pc, op->imm);
+            break;
+        case TAC_INSTRUCTION_JUMP_IF_NOT_ZERO:
+            if (get(vm, fp, &op->src1) != 0)
+                pc = jump(fn, pc, op->imm);
+            break;
+        case TAC_INSTRUCTION_FUN_CALL:
+        case TAC_INSTRUCTION_FUN_CALL_NORETURN:
+            a = call_op(vm, fp, op);
+            put(vm, fp, &op->dst, a);
+            current = fn;
+            break;
+        case TAC_INSTRUCTION_LABEL:
+        case TAC_INSTRUCTION_ALLOCATE_LOCAL:
+            break;
+        }
+    }
+done:
+    current = caller;
+    return result;
+}
+
+//
+// Run the entry point with `argc` strings on the heap.
+//
+static int run_main(Tacrun *vm, Tr_Function *entry, int argc, char *const argv[])
+{
+    const int W   = vm->word_bytes;
+    uint64_t args = tr_malloc(vm, (uint64_t)(argc + 1) * W) & TR_ADDR_MASK;
+    for (int i = 0; i < argc; i++) {
+        size_t len   = strlen(argv[i]);
+        uint64_t str = tr_malloc(vm, len + 1);
+        uint64_t pos = tr_byte_pos(vm, str);
+        for (size_t k = 0; k <= len; k++)
+            tr_put_byte(vm, pos + k, (unsigned char)argv[i][k]);
+        vm->mem[args + i] = str;
+    }
+    vm->mem[args + argc] = 0;
+
+    uint64_t nparams = entry->nparams > 2 ? entry->nparams : 2;
+    uint64_t fp      = push_frame(vm, entry->nautos + nparams);
+    memset(&vm->mem[fp + entry->nautos], 0, nparams * sizeof(uint64_t));
+    vm->mem[fp + entry->nautos]     = tr_int(vm, argc);
+    vm->mem[fp + entry->nautos + 1] = args;
+    return (int)tr_signed(vm, tr_call(vm, entry, fp, 2));
+}
+
+int tacrun_main(Tacrun *vm, int argc, char *const argv[])
+{
+    Tr_Function *entry = tr_function(vm, "main");
+    if (!entry || !entry->tl)
+        entry = tr_function(vm, "program");
+    if (!entry || !entry->tl) {
+        fprintf(stderr, "tacrun: no main() or program() to run\n");
+        return 1;
+    }
+
+    volatile int status;
+    if (setjmp(vm->exit_jump) == 0)
+        status = run_main(vm, entry, argc, argv);
+    else
+        status = vm->exit_status;
+    current = NULL;
+    vm->sp  = TR_MEM_WORDS;
+    fflush(vm->out);
+    return status;
+}
+
+Tacrun *tacrun_create(const Tac_Program *prog, FILE *out)
+{
+    Tacrun *vm = xalloc(sizeof(Tacrun), __func__, __FILE__, __LINE__);
+    vm->prog   = prog;
+    vm->out    = out;
+    vm->mem    = xalloc(TR_MEM_WORDS * sizeof(uint64_t), __func__, __FILE__, __LINE__);
+    vm->sp     = TR_MEM_WORDS;
+    map_init(&vm->functions);
+    map_init(&vm->symbols);
+    tr_load(vm);
+    return vm;
+}
+
+void tacrun_destroy(Tacrun *vm)
+{
+    tr_unload(vm);
+    xfree(vm->free_list);
+    xfree(vm->mem);
+    xfree(vm);
+}
+
+uint64_t tacrun_instruction_count(const Tacrun *vm)
+{
+    return vm->instructions;
+}
+
+uint64_t tacrun_kind_count(const Tacrun *vm, Tac_InstructionKind kind)
+{
+    return (unsigned)kind < TR_NKINDS ? vm->kind_counts[kind] : 0;
+}
+
+uint64_t tacrun_call_count(const Tacrun *vm, const char *function)
+{
+    const Tr_Function *fn = tr_function(vm, function);
+    return fn ? fn->calls : 0;
+}
+
+uint64_t tacrun_function_count(const Tacrun *vm, const char *function)
+{
+    const Tr_Function *fn = tr_function(vm, function);
+    return fn ? fn->instructions : 0;
+}
+
+static int compare_functions(const void *a, const void *b)
+{
+    const Tr_Function *fa = *(const Tr_Function *const *)a;
+    const Tr_Function *fb = *(const Tr_Function *const *)b;
+    if (fa->instructions != fb->instructions)
+        return fa->instructions > fb->instructions ? -1 : 1;
+    if (fa->calls != fb->calls)
+        return fa->calls > fb->calls ? -1 : 1;
+    return strcmp(fa->name, fb->name);
+}
+
+void tacrun_print_profile(FILE *fd, const Tacrun *vm)
+{
+    Tr_Function **sorted = xalloc(vm->nfuncs * sizeof(Tr_Function *), __func__, __FILE__, __LINE__);
+    int n = 0;
+    for (int i = 0; i < vm->nfuncs; i++)
+        if (vm->funcs[i]->calls > 0)
+            sorted[n++] = vm->funcs[i];
+    qsort(sorted, n, sizeof(Tr_Function *), compare_functions);
+
+    fprintf(fd, "%12s %10s  %s\n", "instructions", "calls", "function");
+    for (int i = 0; i < n; i++)
+        fprintf(fd, "%12llu %10llu  %s%s\n", (unsigned long long)sorted[i]->instructions,
+                (unsigned long long)sorted[i]->calls, sorted[i]->name,
+                sorted[i]->builtin ? " (libc)" : "");
+    xfree(sorted);
+
+    fprintf(fd, "%12s %10s  %s\n", "instructions", "percent", "kind");
+    for (int k = 0; k < TR_NKINDS; k++) {
+        if (vm->kind_counts[k] == 0)
+            continue;
+        fprintf(fd, "%12llu %9.2f%%  %s\n", (unsigned long long)vm->kind_counts[k],
+                100.0 * vm->kind_counts[k] / vm->instructions,
+                tac_instruction_name((Tac_InstructionKind)k));
+    }
+    fprintf(fd, "%12llu %10s  total\n", (unsigned long long)vm->instructions, "");
+}
+
+//
+// Does control leave a basic block after this instruction?  The same blocks as the
+// optimizer's CFG (optimize/cfg.c), so that the profile names them by their first op.
+//
+static bool ends_block(Tac_InstructionKind kind)
+{
+    return kind == TAC_INSTRUCTION_JUMP || kind == TAC_INSTRUCTION_JUMP_IF_ZERO ||
+           kind == TAC_INSTRUCTION_JUMP_IF_NOT_ZERO || kind == TAC_INSTRUCTION_RETURN;
+}
+
+void tacrun_write_block_profile(FILE *fd, const Tacrun *vm)
+{
+    fprintf(fd, "# function name instructions / block-start entries taken\n");
+    for (int i = 0; i < vm->nfuncs; i++) {
+        const Tr_Function *fn = vm->funcs[i];
+        if (!fn->tl || fn->calls == 0)
+            continue;
+        fprintf(fd, "function %s %d\n", fn->name, fn->nops);
+        for (int first = 0; first < fn->nops;) {
+            int last = first;
+            while (last + 1 < fn->nops && !ends_block(fn->ops[last].kind) &&
+                   fn->ops[last + 1].kind != TAC_INSTRUCTION_LABEL)
+                last++;
+            fprintf(fd, "%d %llu %llu\n", first, (unsigned long long)fn->entries[first],
+                    (unsigned long long)fn->taken[last]);
+            first = last + 1;
+        }
+    }
+}
@@ -0,0 +1,147 @@
+//
+// Private declarations of the TAC interpreter.
+//
+#ifndef TACRUN_INTERNAL_H
+#define TACRUN_INTERNAL_H
+
+#include <setjmp.h>
+
+#include "string_map.h"
+#include "tacrun.h"
+
+#define TR_MEM_WORDS  32768                  // 15-bit word address space
+#define TR_ADDR_MASK  077777                 // word address field of a pointer
+#define TR_FAT_MARKER ((uint64_t)1 << 47)    // bit 48: a char*/void* pointer
+#define TR_FAT_SHIFT  44                     // bits 47-45: offset_enc = 5 - byte#
+#define TR_NKINDS     (TAC_INSTRUCTION_ALLOCATE_LOCAL + 1)
+
+//
+// Where an operand lives, resolved once at load time.
+//
+typedef enum {
+    TR_NONE,   // absent (a call without a result, a bare return)
+    TR_CONST,  // `value` is the word itself
+    TR_FRAME,  // `value` is a word offset from the frame pointer
+    TR_GLOBAL, // `value` is an absolute word address
+} Tr_Where;
+
+typedef struct {
+    Tr_Where where;
+    uint64_t value;
+} Tr_Operand;
+
+typedef struct Tr_Function Tr_Function;
+
+//
+// One instruction, with names replaced by operands and labels by op indices.
+//
+typedef struct {
+    Tac_InstructionKind kind;
+    int op;               // Tac_UnaryOperator or Tac_BinaryOperator
+    Tr_Operand src1;
+    Tr_Operand src2;
+    Tr_Operand dst;
+    long imm;             // jump target, ADD_PTR scale, member byte offset, or BLOCK_COPY words
+    int nargs;
+    Tr_Operand *args;     // FUN_CALL arguments
+    Tr_Function *callee;  // direct FUN_CALL; NULL when the call is indirect
+} Tr_Op;
+
+//
+// A libc routine implemented on the host.  Arguments are guest words.
+//
+typedef uint64_t (*Tr_Builtin)(Tacrun *vm, const uint64_t *args, int nargs);
+
+struct Tr_Function {
+    const char *name;
+    uint64_t address;        // code word: the value of &function
+    const Tac_TopLevel *tl;  // NULL for a libc routine
+    Tr_Builtin builtin;
+    int nparams;
+    int nautos;              // frame words below the parameters
+    int nops;
+    Tr_Op *ops;
+    StringMap statics;       // block-scope static name -> word address
+    uint64_t calls;          // dynamic counts
+    uint64_t instructions;
+    uint64_t *entries;       // per op: times control reached it, by falling in or a jump
+    uint64_t *taken;         // per op: times the jump there was taken
+};
+
+//
+// A block on the free list of the guest heap.
+//
+typedef struct {
+    uint64_t addr; // first data word; the word before it holds the size
+    uint64_t size; // in words
+} Tr_FreeBlock;
+
+struct Tacrun {
+    const Tac_Program *prog;
+    FILE *out;
+    uint64_t *mem;
+    int word_bytes;          // target int_size
+    int word_bits;           // unsigned value width
+    int int_bits;            // signed value width
+    bool logical_shift;      // signed >> zero-fills
+
+    int nfuncs;
+    Tr_Function **funcs;     // indexed by code address - 1
+    StringMap functions;     // name -> Tr_Function*
+    StringMap symbols;       // static object name -> word address
+
+    uint64_t heap_top;       // first word above the heap
+    uint64_t sp;             // lowest word of the stack
+    int nfree;
+    int free_cap;
+    Tr_FreeBlock *free_list;
+
+    jmp_buf exit_jump;       // taken by exit()
+    int exit_status;
+
+    uint64_t instructions;
+    uint64_t kind_counts[TR_NKINDS];
+};
+
+//
+// load.c
+//
+Tr_Function *tr_function(const Tacrun *vm, const char *name);
+void tr_load(Tacrun *vm);
+void tr_unload(Tacrun *vm);
+
+//
+// exec.c
+//
+uint64_t tr_call(Tacrun *vm, Tr_Function *fn, uint64_t fp, int nargs);
+_Noreturn void tr_trap(const Tacrun *vm, const char *message, ...);
+uint64_t tr_mask(const Tacrun *vm, uint64_t word);
+uint64_t tr_int(const Tacrun *vm, int64_t value);
+int64_t tr_signed(const Tacrun *vm, uint64_t word);
+uint64_t tr_double_word(double d);
+double tr_word_double(uint64_t word);
+
+//
+// Byte addressing.  A byte position is word * word_bytes + byte#, with byte #0 in the
+// most significant position.  A pointer without the marker bit addresses byte #0.
+//
+uint64_t tr_byte_pos(const Tacrun *vm, uint64_t ptr);
+uint64_t tr_fat_pointer(const Tacrun *vm, uint64_t pos);
+unsigned tr_get_byte(const Tacrun *vm, uint64_t pos);
+void tr_put_byte(Tacrun *vm, uint64_t pos, unsigned byte);
+uint64_t tr_check_address(const Tacrun *vm, uint64_t addr);
+
+//
+// libc.c
+//
+typedef struct {
+    const char *name;
+    Tr_Builtin func;
+} Tr_LibcEntry;
+
+extern const Tr_LibcEntry tr_libc[]; // terminated by a NULL name
+
+uint64_t tr_malloc(Tacrun *vm, uint64_t nbytes);
+void tr_free(Tacrun *vm, uint64_t ptr);
+
+#endif // TACRUN_INTERNAL_H
@@ -0,0 +1,429 @@
+//
+// TAC interpreter: host-side C library.  A call to a function that the program does not
+// define lands here.  Strings are read and written in guest memory through fat pointers;
+// output goes to the stream given to tacrun_create().
+//
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal.h"
+#include "xalloc.h"
+
+//
+// Growable host byte buffer.
+//
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} Buffer;
+
+static void buf_append(Buffer *b, const char *s, size_t n)
+{
+    if (b->len + n + 1 > b->cap) {
+        size_t cap = b->cap ? b->cap : 64;
+        while (cap < b->len + n + 1)
+            cap *= 2;
+        char *data = xalloc(cap, __func__, __FILE__, __LINE__);
+        if (b->data) {
+            memcpy(data, b->data, b->len);
+            xfree(b->data);
+        }
+        b->data = data;
+        b->cap  = cap;
+    }
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+}
+
+static uint64_t arg(const uint64_t *args, int nargs, int i)
+{
+    return i < nargs ? args[i] : 0;
+}
+
+//
+// Append the NUL-terminated guest string at `ptr` to `b`.
+//
+static void read_string(const Tacrun *vm, uint64_t ptr, Buffer *b)
+{
+    for (uint64_t pos = tr_byte_pos(vm, ptr);; pos++) {
+        char c = (char)tr_get_byte(vm, pos);
+        if (c == '\0')
+            break;
+        buf_append(b, &c, 1);
+    }
+}
+
+static void write_bytes(Tacrun *vm, uint64_t ptr, const char *s, size_t n)
+{
+    uint64_t pos = tr_byte_pos(vm, ptr);
+    for (size_t i = 0; i < n; i++)
+        tr_put_byte(vm, pos + i, (unsigned char)s[i]);
+}
+
+//
+// printf-style formatting of guest words.  Each conversion is handed to the host
+// snprintf with the flags, width and precision it was written with.
+//
+static void format(const Tacrun *vm, uint64_t fmt, const uint64_t *args, int nargs, Buffer *out)
+{
+    Buffer f = { 0 };
+    read_string(vm, fmt, &f);
+    int next = 0;
+
+    for (const char *p = f.data ? f.data : ""; *p; p++) {
+        if (*p != '%') {
+            buf_append(out, p, 1);
+            continue;
+        }
+        char spec[32] = "%";
+        size_t n      = 1;
+        int star[2], nstar = 0;
+
+        for (p++; *p && strchr("-+ #0", *p) && n < 8; p++)
+            spec[n++] = *p;
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                if (*p != '.')
+                    break;
+                spec[n++] = *p++;
+            }
+            if (*p == '*') {
+                star[nstar++] = (int)tr_signed(vm, arg(args, nargs, next++));
+                spec[n++]     = *p++;
+            } else {
+                while (*p >= '0' && *p <= '9' && n < 24)
+                    spec[n++] = *p++;
+            }
+        }
+        while (*p && strchr("hlLqjzt", *p))
+            p++;
+        if (*p == '\0')
+            break;
+
+        char text[512];
+        int len       = 0;
+        uint64_t word = (*p == '%') ? 0 : arg(args, nargs, next++);
+        const int w1 = nstar > 0 ? star[0] : 0, w2 = nstar > 1 ? star[1] : 0;
+
+#define EMIT(suffix, value)                                                            \
+    do {                                                                               \
+        memcpy(spec + n, suffix, sizeof(suffix));                                      \
+        len = nstar == 0   ? snprintf(text, sizeof(text), spec, value)                 \
+              : nstar == 1 ? snprintf(text, sizeof(text), spec, w1, value)             \
+                           : snprintf(text, sizeof(text), spec, w1, w2, value);        \
+    } while (0)
+
+        switch (*p) {
+        case 'd':
+        case 'i':
+            EMIT("lld", (long long)tr_signed(vm, word));
+            break;
+        case 'u':
+            EMIT("llu", (unsigned long long)tr_mask(vm, word));
+            break;
+        case 'o':
+        case 'p':
+            EMIT("llo", (unsigned long long)tr_mask(vm, word));
+            break;
+        case 'x':
+            EMIT("llx", (unsigned long long)tr_mask(vm, word));
+            break;
+        case 'X':
+            EMIT("llX", (unsigned long long)tr_mask(vm, word));
+            break;
+        case 'c':
+            EMIT("c", (int)(word & 0xff));
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G': {
+            char suffix[2] = { *p, 0 };
+            memcpy(spec + n, suffix, sizeof(suffix));
+            double d = tr_word_double(word);
+            len      = nstar == 0   ? snprintf(text, sizeof(text), spec, d)
+                       : nstar == 1 ? snprintf(text, sizeof(text), spec, w1, d)
+                                    : snprintf(text, sizeof(text), spec, w1, w2, d);
+            break;
+        }
+        case 's': {
+            Buffer s = { 0 };
+            if (word != 0)
+                read_string(vm, word, &s);
+            else
+                buf_append(&s, "(null)", 6);
+            memcpy(spec + n, "s", 2);
+            // A string may be longer than `text`: format it straight into the output.
+            char *host = xalloc(s.len + 512, __func__, __FILE__, __LINE__);
+            int hl     = nstar == 0   ? snprintf(host, s.len + 512, spec, s.data)
+                         : nstar == 1 ? snprintf(host, s.len + 512, spec, w1, s.data)
+                                      : snprintf(host, s.len + 512, spec, w1, w2, s.data);
+            if (hl > 0)
+                buf_append(out, host, (size_t)hl < s.len + 511 ? (size_t)hl : s.len + 511);
+            xfree(host);
+            xfree(s.data);
+            continue;
+        }
+        case '%':
+            buf_append(out, "%", 1);
+            continue;
+        default:
+            // Unknown conversion: print it as written.
+            buf_append(out, "%", 1);
+            buf_append(out, p, 1);
+            continue;
+        }
+#undef EMIT
+        if (len > 0)
+            buf_append(out, text, (size_t)len < sizeof(text) ? (size_t)len : sizeof(text) - 1);
+    }
+    xfree(f.data);
+}
+
+static uint64_t libc_printf(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    Buffer out = { 0 };
+    format(vm, arg(args, nargs, 0), args + 1, nargs - 1, &out);
+    if (out.len > 0)
+        fwrite(out.data, 1, out.len, vm->out);
+    xfree(out.data);
+    return tr_int(vm, (int64_t)out.len);
+}
+
+static uint64_t libc_sprintf(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    Buffer out = { 0 };
+    format(vm, arg(args, nargs, 1), args + 2, nargs - 2, &out);
+    write_bytes(vm, arg(args, nargs, 0), out.data ? out.data : "", out.len + 1);
+    xfree(out.data);
+    return tr_int(vm, (int64_t)out.len);
+}
+
+static uint64_t libc_snprintf(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    Buffer out  = { 0 };
+    uint64_t sz = tr_mask(vm, arg(args, nargs, 1));
+    format(vm, arg(args, nargs, 2), args + 3, nargs - 3, &out);
+    if (sz > 0) {
+        size_t n = out.len < sz ? out.len : sz - 1;
+        write_bytes(vm, arg(args, nargs, 0), out.data ? out.data : "", n);
+        write_bytes(vm, tr_fat_pointer(vm, tr_byte_pos(vm, arg(args, nargs, 0)) + n), "", 1);
+    }
+    xfree(out.data);
+    return tr_int(vm, (int64_t)out.len);
+}
+
+static uint64_t libc_putchar(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    fputc((int)(arg(args, nargs, 0) & 0xff), vm->out);
+    return arg(args, nargs, 0) & 0xff;
+}
+
+static uint64_t libc_puts(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    Buffer s = { 0 };
+    read_string(vm, arg(args, nargs, 0), &s);
+    buf_append(&s, "\n", 1);
+    fwrite(s.data, 1, s.len, vm->out);
+    xfree(s.data);
+    return 0;
+}
+
+static uint64_t libc_getchar(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    (void)args;
+    (void)nargs;
+    int c = getchar();
+    return tr_int(vm, c == EOF ? -1 : c);
+}
+
+static uint64_t libc_exit(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    vm->exit_status = (int)tr_signed(vm, arg(args, nargs, 0));
+    longjmp(vm->exit_jump, 1);
+}
+
+static uint64_t libc_abort(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    (void)args;
+    (void)nargs;
+    tr_trap(vm, "abort() called");
+}
+
+uint64_t tr_malloc(Tacrun *vm, uint64_t nbytes)
+{
+    uint64_t nwords = (nbytes + vm->word_bytes - 1) / vm->word_bytes;
+    if (nwords == 0)
+        nwords = 1;
+
+    uint64_t addr = 0;
+    for (int i = 0; i < vm->nfree; i++) {
+        if (vm->free_list[i].size >= nwords) {
+            addr              = vm->free_list[i].addr;
+            vm->free_list[i] = vm->free_list[--vm->nfree];
+            break;
+        }
+    }
+    if (addr == 0) {
+        if (nwords >= TR_MEM_WORDS || vm->heap_top + nwords + 1 > vm->sp)
+            return 0;
+        vm->mem[vm->heap_top] = nwords;
+        addr                  = vm->heap_top + 1;
+        vm->heap_top += nwords + 1;
+    }
+    memset(&vm->mem[addr], 0, vm->mem[addr - 1] * sizeof(uint64_t));
+    return tr_fat_pointer(vm, addr * vm->word_bytes);
+}
+
+void tr_free(Tacrun *vm, uint64_t ptr)
+{
+    uint64_t addr = ptr & TR_ADDR_MASK;
+    if (addr == 0)
+        return;
+    if (vm->nfree == vm->free_cap) {
+        int cap            = vm->free_cap ? 2 * vm->free_cap : 16;
+        Tr_FreeBlock *list = xalloc(cap * sizeof(Tr_FreeBlock), __func__, __FILE__, __LINE__);
+        if (vm->free_list) {
+            memcpy(list, vm->free_list, vm->nfree * sizeof(Tr_FreeBlock));
+            xfree(vm->free_list);
+        }
+        vm->free_list = list;
+        vm->free_cap  = cap;
+    }
+    vm->free_list[vm->nfree++] = (Tr_FreeBlock){ addr, vm->mem[addr - 1] };
+}
+
+static uint64_t libc_malloc(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    return tr_malloc(vm, tr_mask(vm, arg(args, nargs, 0)));
+}
+
+static uint64_t libc_calloc(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    return tr_malloc(vm, tr_mask(vm, arg(args, nargs, 0)) * tr_mask(vm, arg(args, nargs, 1)));
+}
+
+static uint64_t libc_realloc(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    uint64_t old = arg(args, nargs, 0);
+    uint64_t ptr = tr_malloc(vm, tr_mask(vm, arg(args, nargs, 1)));
+    if (ptr != 0 && (old & TR_ADDR_MASK) != 0) {
+        uint64_t from = old & TR_ADDR_MASK, to = ptr & TR_ADDR_MASK;
+        uint64_t n    = vm->mem[from - 1] < vm->mem[to - 1] ? vm->mem[from - 1] : vm->mem[to - 1];
+        memcpy(&vm->mem[to], &vm->mem[from], n * sizeof(uint64_t));
+        tr_free(vm, old);
+    }
+    return ptr;
+}
+
+static uint64_t libc_free(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    tr_free(vm, arg(args, nargs, 0));
+    return 0;
+}
+
+static uint64_t libc_strlen(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    uint64_t pos = tr_byte_pos(vm, arg(args, nargs, 0)), n = 0;
+    while (tr_get_byte(vm, pos + n) != 0)
+        n++;
+    return n;
+}
+
+static uint64_t compare_bytes(Tacrun *vm, const uint64_t *args, int nargs, uint64_t limit,
+                              bool stop_at_nul)
+{
+    uint64_t a = tr_byte_pos(vm, arg(args, nargs, 0));
+    uint64_t b = tr_byte_pos(vm, arg(args, nargs, 1));
+    for (uint64_t i = 0; i < limit; i++) {
+        unsigned ca = tr_get_byte(vm, a + i), cb = tr_get_byte(vm, b + i);
+        if (ca != cb)
+            return tr_int(vm, ca < cb ? -1 : 1);
+        if (stop_at_nul && ca == 0)
+            break;
+    }
+    return 0;
+}
+
+static uint64_t libc_strcmp(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    return compare_bytes(vm, args, nargs, UINT64_MAX, true);
+}
+
+static uint64_t libc_strncmp(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    return compare_bytes(vm, args, nargs, tr_mask(vm, arg(args, nargs, 2)), true);
+}
+
+static uint64_t libc_memcmp(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    return compare_bytes(vm, args, nargs, tr_mask(vm, arg(args, nargs, 2)), false);
+}
+
+static uint64_t libc_strcpy(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    uint64_t dst = tr_byte_pos(vm, arg(args, nargs, 0));
+    uint64_t src = tr_byte_pos(vm, arg(args, nargs, 1));
+    for (uint64_t i = 0;; i++) {
+        unsigned c = tr_get_byte(vm, src + i);
+        tr_put_byte(vm, dst + i, c);
+        if (c == 0)
+            break;
+    }
+    return arg(args, nargs, 0);
+}
+
+static uint64_t libc_strcat(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    uint64_t end     = tr_fat_pointer(vm, tr_byte_pos(vm, args[0]) + libc_strlen(vm, args, 1));
+    uint64_t copy[2] = { end, arg(args, nargs, 1) };
+    libc_strcpy(vm, copy, 2);
+    return arg(args, nargs, 0);
+}
+
+static uint64_t libc_memcpy(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    uint64_t dst = tr_byte_pos(vm, arg(args, nargs, 0));
+    uint64_t src = tr_byte_pos(vm, arg(args, nargs, 1));
+    uint64_t n   = tr_mask(vm, arg(args, nargs, 2));
+    if (dst > src && dst < src + n) {
+        for (uint64_t i = n; i-- > 0;)
+            tr_put_byte(vm, dst + i, tr_get_byte(vm, src + i));
+    } else {
+        for (uint64_t i = 0; i < n; i++)
+            tr_put_byte(vm, dst + i, tr_get_byte(vm, src + i));
+    }
+    return arg(args, nargs, 0);
+}
+
+static uint64_t libc_memset(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    uint64_t dst = tr_byte_pos(vm, arg(args, nargs, 0));
+    unsigned c   = (unsigned)(arg(args, nargs, 1) & 0xff);
+    uint64_t n   = tr_mask(vm, arg(args, nargs, 2));
+    for (uint64_t i = 0; i < n; i++)
+        tr_put_byte(vm, dst + i, c);
+    return arg(args, nargs, 0);
+}
+
+static uint64_t libc_abs(Tacrun *vm, const uint64_t *args, int nargs)
+{
+    int64_t v = tr_signed(vm, arg(args, nargs, 0));
+    return tr_int(vm, v < 0 ? -v : v);
+}
+
+const Tr_LibcEntry tr_libc[] = {
+    { "printf", libc_printf },   { "sprintf", libc_sprintf }, { "snprintf", libc_snprintf },
+    { "putchar", libc_putchar }, { "putbyte", libc_putchar }, { "putch", libc_putchar },
+    { "puts", libc_puts },       { "getchar", libc_getchar }, { "exit", libc_exit },
+    { "abort", libc_abort },     { "malloc", libc_malloc },   { "calloc", libc_calloc },
+    { "realloc", libc_realloc }, { "free", libc_free },       { "strlen", libc_strlen },
+    { "strcmp", libc_strcmp },   { "strncmp", libc_strncmp }, { "strcpy", libc_strcpy },
+    { "strcat", libc_strcat },   { "memcpy", libc_memcpy },   { "memmove", libc_memcpy },
+    { "memset", libc_memset },   { "memcmp", libc_memcmp },   { "abs", libc_abs },
+    { "labs", libc_abs },        { NULL, NULL },
+};
@@ -0,0 +1,612 @@
+//
+// TAC interpreter: lay out code and static data, and compile each function body into an
+// array of ops with every name resolved to a frame slot, an absolute address or a callee.
+//
+#include <string.h>
+
+#include "internal.h"
+#include "semantic.h"
+#include "target.h"
+#include "xalloc.h"
+
+//
+// Names visible inside one function while its body is compiled.
+//
+typedef struct {
+    Tacrun *vm;
+    Tr_Function *fn;
+    StringMap params; // name -> parameter index
+    StringMap autos;  // name -> frame offset
+    StringMap labels; // name -> op index
+} Scope;
+
+Tr_Function *tr_function(const Tacrun *vm, const char *name)
+{
+    intptr_t value;
+    if (!map_get(&vm->functions, name, &value))
+        return NULL;
+    return (Tr_Function *)value;
+}
+
+//
+// Storage of a static object in words; mirrors codegen_sizeof() of the BESM-6 backend:
+// a char array is packed word_bytes to a word, and a struct is rounded up to whole words.
+//
+static int type_words(const Tacrun *vm, const Tac_Type *t)
+{
+    switch (t->kind) {
+    case TAC_TYPE_ARRAY:
+        if (t->u.array.elem_type->kind == TAC_TYPE_SCHAR ||
+            t->u.array.elem_type->kind == TAC_TYPE_UCHAR)
+            return (t->u.array.size + vm->word_bytes - 1) / vm->word_bytes;
+        return type_words(vm, t->u.array.elem_type) * t->u.array.size;
+    case TAC_TYPE_STRUCTURE:
+        return (t->u.structure.size + vm->word_bytes - 1) / vm->word_bytes;
+    default:
+        return 1;
+    }
+}
+
+//
+// True when the static layout of `t` is byte-packed: a char array, a struct, or an array
+// of structs.  Other types get one word per init item.
+//
+static bool is_packed(const Tac_Type *t)
+{
+    while (t->kind == TAC_TYPE_ARRAY)
+        t = t->u.array.elem_type;
+    return t->kind == TAC_TYPE_SCHAR || t->kind == TAC_TYPE_UCHAR ||
+           t->kind == TAC_TYPE_STRUCTURE;
+}
+
+//
+// Register a function, giving it the next code word.
+//
+static Tr_Function *add_function(Tacrun *vm, const char *name)
+{
+    Tr_Function *fn = xalloc(sizeof(Tr_Function), __func__, __FILE__, __LINE__);
+    fn->name        = name;
+    fn->address     = vm->nfuncs + 1;
+    map_init(&fn->statics);
+
+    vm->funcs[vm->nfuncs++] = fn;
+    map_insert(&vm->functions, name, (intptr_t)fn, 0);
+    return fn;
+}
+
+//
+// Reserve `nwords` of static storage.
+//
+static uint64_t allocate_static(Tacrun *vm, const char *name, int nwords)
+{
+    if (nwords < 1)
+        nwords = 1;
+    uint64_t addr = vm->heap_top;
+    if (addr + nwords >= TR_MEM_WORDS)
+        fatal_error("tacrun: static data does not fit in memory at '%s'", name);
+    vm->heap_top += nwords;
+    return addr;
+}
+
+//
+// Address of a static object, a block-scope static of `fn`, or a function.
+//
+static bool symbol_address(const Tacrun *vm, const Tr_Function *fn, const char *name,
+                           uint64_t *addr)
+{
+    intptr_t value;
+    if ((fn && map_get(&fn->statics, name, &value)) || map_get(&vm->symbols, name, &value)) {
+        *addr = (uint64_t)value;
+        return true;
+    }
+    const Tr_Function *callee = tr_function(vm, name);
+    if (callee) {
+        *addr = callee->address;
+        return true;
+    }
+    return false;
+}
+
+//
+// Value of one word-sized static init item.
+//
+static uint64_t init_word(const Tacrun *vm, const Tr_Function *fn, const Tac_StaticInit *it)
+{
+    uint64_t addr;
+
+    switch (it->kind) {
+    case TAC_STATIC_INIT_I8:
+        return (uint8_t)it->u.char_val;
+    case TAC_STATIC_INIT_U8:
+        return it->u.uchar_val;
+    case TAC_STATIC_INIT_I16:
+        return tr_int(vm, it->u.short_val);
+    case TAC_STATIC_INIT_I32:
+        return tr_int(vm, it->u.int_val);
+    case TAC_STATIC_INIT_I64:
+        return tr_int(vm, it->u.long_val);
+    case TAC_STATIC_INIT_U16:
+        return it->u.ushort_val;
+    case TAC_STATIC_INIT_U32:
+        return it->u.uint_val;
+    case TAC_STATIC_INIT_U64:
+        return tr_mask(vm, it->u.ulong_val);
+    case TAC_STATIC_INIT_FLOAT:
+        return tr_double_word(it->u.float_val);
+    case TAC_STATIC_INIT_DOUBLE:
+        return tr_double_word(it->u.double_val);
+    case TAC_STATIC_INIT_LONG_DOUBLE:
+        return tr_double_word((double)it->u.long_double_val);
+    case TAC_STATIC_INIT_POINTER:
+    case TAC_STATIC_INIT_FAT_POINTER:
+        if (!symbol_address(vm, fn, it->u.pointer.name, &addr))
+            fatal_error("tacrun: undefined symbol '%s' in static initializer",
+                        it->u.pointer.name);
+        if (it->kind == TAC_STATIC_INIT_POINTER)
+            return addr + it->u.pointer.byte_offset / vm->word_bytes;
+        return tr_fat_pointer(vm, addr * vm->word_bytes + it->u.pointer.byte_offset);
+    default:
+        fatal_error("tacrun: unexpected static init kind %d", (int)it->kind);
+    }
+}
+
+//
+// Fill the storage of one static object from its init list, the way the BESM-6 backend
+// lays it out: byte items packed from the most significant byte, word items one per word.
+// Items past the end of the object are dropped.
+//
+static void init_static(Tacrun *vm, const Tr_Function *fn, uint64_t addr, const Tac_Type *type,
+                        const Tac_StaticInit *init)
+{
+    const uint64_t W    = vm->word_bytes;
+    const uint64_t size = type_words(vm, type) * W; // bytes
+    const bool packed   = is_packed(type);
+    uint64_t pos        = 0;                        // byte cursor
+
+    for (const Tac_StaticInit *it = init; it; it = it->next) {
+        switch (it->kind) {
+        case TAC_STATIC_INIT_ZERO:
+            pos += it->u.zero_bytes;
+            if (!packed)
+                pos = (pos + W - 1) / W * W;
+            break;
+        case TAC_STATIC_INIT_STRING: {
+            size_t len = it->u.string.val ? it->u.string.len : 0;
+            for (size_t i = 0; i < len; i++, pos++)
+                if (pos < size)
+                    tr_put_byte(vm, addr * W + pos, (uint8_t)it->u.string.val[i]);
+            if (it->u.string.null_terminated)
+                pos++;
+            if (!packed)
+                pos = (pos + W - 1) / W * W;
+            break;
+        }
+        case TAC_STATIC_INIT_I8:
+        case TAC_STATIC_INIT_U8:
+            if (packed) {
+                if (pos < size)
+                    tr_put_byte(vm, addr * W + pos, (unsigned)init_word(vm, fn, it));
+                pos++;
+                break;
+            }
+            // A standalone char takes the low byte of its own word.
+            // fall through
+        default:
+            pos = (pos + W - 1) / W * W;
+            if (pos < size)
+                vm->mem[addr + pos / W] = init_word(vm, fn, it);
+            pos += W;
+            break;
+        }
+    }
+}
+
+//
+// Pass 1: code words, then static storage.  Every name gets its address before any
+// initializer or function body refers to it.
+//
+static void layout(Tacrun *vm)
+{
+    int count = 0;
+    for (const Tac_TopLevel *tl = vm->prog->decls; tl; tl = tl->next)
+        count += (tl->kind == TAC_TOPLEVEL_FUNCTION);
+    for (const Tr_LibcEntry *e = tr_libc; e->name; e++)
+        count++;
+    vm->funcs = xalloc(count * sizeof(Tr_Function *), __func__, __FILE__, __LINE__);
+
+    for (const Tac_TopLevel *tl = vm->prog->decls; tl; tl = tl->next) {
+        if (tl->kind != TAC_TOPLEVEL_FUNCTION)
+            continue;
+        if (tr_function(vm, tl->u.function.name))
+            fatal_error("tacrun: function '%s' is defined twice", tl->u.function.name);
+        Tr_Function *fn = add_function(vm, tl->u.function.name);
+        fn->tl          = tl;
+    }
+    for (const Tr_LibcEntry *e = tr_libc; e->name; e++) {
+        if (!tr_function(vm, e->name))
+            add_function(vm, e->name)->builtin = e->func;
+    }
+
+    // A code word holds its own address, so that a function name read as a value and
+    // the address of that function agree.
+    vm->heap_top = vm->nfuncs + 1;
+    for (int i = 0; i < vm->nfuncs; i++)
+        vm->mem[vm->funcs[i]->address] = vm->funcs[i]->address;
+
+    for (const Tac_TopLevel *tl = vm->prog->decls; tl; tl = tl->next) {
+        const char *name;
+        const Tac_Type *type;
+
+        switch (tl->kind) {
+        case TAC_TOPLEVEL_STATIC_VARIABLE:
+            name = tl->u.static_variable.name;
+            type = tl->u.static_variable.type;
+            break;
+        case TAC_TOPLEVEL_STATIC_CONSTANT:
+            name = tl->u.static_constant.name;
+            type = tl->u.static_constant.type;
+            break;
+        default: {
+            Tr_Function *fn = tr_function(vm, tl->u.function.name);
+            for (const Tac_StaticLocal *s = tl->u.function.static_locals; s; s = s->next) {
+                uint64_t addr = allocate_static(vm, s->name, type_words(vm, s->type));
+                map_insert(&fn->statics, s->name, (intptr_t)addr, 0);
+            }
+            continue;
+        }
+        }
+        // A tentative definition and the real one share storage.
+        if (!map_get(&vm->symbols, name, NULL))
+            map_insert(&vm->symbols, name,
+                       (intptr_t)allocate_static(vm, name, type_words(vm, type)), 0);
+    }
+}
+
+//
+// Pass 2: initial values.
+//
+static void initialize(Tacrun *vm)
+{
+    for (const Tac_TopLevel *tl = vm->prog->decls; tl; tl = tl->next) {
+        intptr_t addr;
+        switch (tl->kind) {
+        case TAC_TOPLEVEL_STATIC_VARIABLE:
+            map_get(&vm->symbols, tl->u.static_variable.name, &addr);
+            init_static(vm, NULL, addr, tl->u.static_variable.type,
+                        tl->u.static_variable.init_list);
+            break;
+        case TAC_TOPLEVEL_STATIC_CONSTANT:
+            map_get(&vm->symbols, tl->u.static_constant.name, &addr);
+            init_static(vm, NULL, addr, tl->u.static_constant.type, tl->u.static_constant.init);
+            break;
+        case TAC_TOPLEVEL_FUNCTION: {
+            const Tr_Function *fn = tr_function(vm, tl->u.function.name);
+            for (const Tac_StaticLocal *s = tl->u.function.static_locals; s; s = s->next) {
+                map_get(&fn->statics, s->name, &addr);
+                init_static(vm, fn, addr, s->type, s->init_list);
+            }
+            break;
+        }
+        }
+    }
+}
+
+//
+// Word of a constant operand.
+//
+static uint64_t const_word(const Tacrun *vm, const Tac_Const *c)
+{
+    switch (c->kind) {
+    case TAC_CONST_INT:
+        return tr_int(vm, c->u.int_val);
+    case TAC_CONST_LONG:
+        return tr_int(vm, c->u.long_val);
+    case TAC_CONST_LONG_LONG:
+        return tr_int(vm, c->u.long_long_val);
+    case TAC_CONST_UINT:
+        return tr_mask(vm, c->u.uint_val);
+    case TAC_CONST_ULONG:
+        return tr_mask(vm, c->u.ulong_val);
+    case TAC_CONST_ULONG_LONG:
+        return tr_mask(vm, c->u.ulong_long_val);
+    case TAC_CONST_FLOAT:
+        return tr_double_word(c->u.float_val);
+    case TAC_CONST_DOUBLE:
+        return tr_double_word(c->u.double_val);
+    case TAC_CONST_LONG_DOUBLE:
+        return tr_double_word((double)c->u.long_double_val);
+    case TAC_CONST_SCHAR:
+        return tr_int(vm, (signed char)c->u.char_val);
+    case TAC_CONST_UCHAR:
+        return c->u.uchar_val;
+    }
+    return 0;
+}
+
+//
+// Give every automatic name of the body a frame word.  Local aggregates come first,
+// so that the one-word temporaries cannot be overrun by an aggregate.
+//
+static void add_auto(Scope *scope, const char *name, int nwords)
+{
+    if (name[0] != '%' || map_get(&scope->params, name, NULL) ||
+        map_get(&scope->autos, name, NULL))
+        return;
+    map_insert(&scope->autos, name, scope->fn->nautos, 0);
+    scope->fn->nautos += nwords;
+}
+
+static void add_auto_val(Scope *scope, const Tac_Val *v)
+{
+    for (; v; v = v->next)
+        if (v->kind == TAC_VAL_VAR)
+            add_auto(scope, v->u.var_name, 1);
+}
+
+static void scan_frame(Scope *scope, const Tac_Instruction *body)
+{
+    const int W = scope->vm->word_bytes;
+
+    for (const Tac_Instruction *in = body; in; in = in->next)
+        if (in->kind == TAC_INSTRUCTION_ALLOCATE_LOCAL)
+            add_auto(scope, in->u.allocate_local.name, (in->u.allocate_local.size + W - 1) / W);
+
+    for (const Tac_Instruction *in = body; in; in = in->next) {
+        switch (in->kind) {
+        case TAC_INSTRUCTION_UNARY:
+            add_auto_val(scope, in->u.unary.src);
+            add_auto_val(scope, in->u.unary.dst);
+            break;
+        case TAC_INSTRUCTION_BINARY:
+            add_auto_val(scope, in->u.binary.src1);
+            add_auto_val(scope, in->u.binary.src2);
+            add_auto_val(scope, in->u.binary.dst);
+            break;
+        case TAC_INSTRUCTION_ADD_PTR:
+            add_auto_val(scope, in->u.add_ptr.ptr);
+            add_auto_val(scope, in->u.add_ptr.index);
+            add_auto_val(scope, in->u.add_ptr.dst);
+            break;
+        case TAC_INSTRUCTION_PTR_DIFF:
+            add_auto_val(scope, in->u.ptr_diff.ptr_a);
+            add_auto_val(scope, in->u.ptr_diff.ptr_b);
+            add_auto_val(scope, in->u.ptr_diff.dst);
+            break;
+        case TAC_INSTRUCTION_COPY_TO_OFFSET:
+        case TAC_INSTRUCTION_COPY_BYTE_TO_OFFSET:
+            add_auto_val(scope, in->u.copy_to_offset.src);
+            add_auto(scope, in->u.copy_to_offset.dst, 1);
+            break;
+        case TAC_INSTRUCTION_COPY_FROM_OFFSET:
+        case TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET:
+            add_auto(scope, in->u.copy_from_offset.src, 1);
+            add_auto_val(scope, in->u.copy_from_offset.dst);
+            break;
+        case TAC_INSTRUCTION_BLOCK_COPY:
+            add_auto_val(scope, in->u.block_copy.src_ptr);
+            add_auto_val(scope, in->u.block_copy.dst_ptr);
+            break;
+        case TAC_INSTRUCTION_JUMP_IF_ZERO:
+            add_auto_val(scope, in->u.jump_if_zero.condition);
+            break;
+        case TAC_INSTRUCTION_JUMP_IF_NOT_ZERO:
+            add_auto_val(scope, in->u.jump_if_not_zero.condition);
+            break;
+        case TAC_INSTRUCTION_FUN_CALL:
+        case TAC_INSTRUCTION_FUN_CALL_NORETURN:
+            if (in->u.fun_call.indirect)
+                add_auto(scope, in->u.fun_call.fun_name, 1);
+            add_auto_val(scope, in->u.fun_call.args);
+            add_auto_val(scope, in->u.fun_call.dst);
+            break;
+        case TAC_INSTRUCTION_RETURN:
+            add_auto_val(scope, in->u.return_.src);
+            break;
+        case TAC_INSTRUCTION_JUMP:
+        case TAC_INSTRUCTION_LABEL:
+        case TAC_INSTRUCTION_ALLOCATE_LOCAL:
+            break;
+        default:
+            // Every other kind (conversions, copy, get_address, load, store) has the
+            // {src, dst} layout of `copy`.
+            add_auto_val(scope, in->u.copy.src);
+            add_auto_val(scope, in->u.copy.dst);
+            break;
+        }
+    }
+}
+
+//
+// Operand for a name: a parameter, an automatic, a block-scope static, a static object
+// or a function.
+//
+static Tr_Operand name_operand(const Scope *scope, const char *name)
+{
+    intptr_t value;
+    uint64_t addr;
+
+    if (map_get(&scope->params, name, &value))
+        return (Tr_Operand){ TR_FRAME, (uint64_t)(scope->fn->nautos + value) };
+    if (map_get(&scope->autos, name, &value))
+        return (Tr_Operand){ TR_FRAME, (uint64_t)value };
+    if (symbol_address(scope->vm, scope->fn, name, &addr))
+        return (Tr_Operand){ TR_GLOBAL, addr };
+    fatal_error("tacrun: undefined symbol '%s' in function %s", name, scope->fn->name);
+}
+
+static Tr_Operand val_operand(const Scope *scope, const Tac_Val *v)
+{
+    if (!v)
+        return (Tr_Operand){ TR_NONE, 0 };
+    if (v->kind == TAC_VAL_CONSTANT)
+        return (Tr_Operand){ TR_CONST, const_word(scope->vm, v->u.constant) };
+    return name_operand(scope, v->u.var_name);
+}
+
+static long label_index(const Scope *scope, const char *name)
+{
+    intptr_t value;
+    if (!map_get(&scope->labels, name, &value))
+        fatal_error("tacrun: undefined label '%s' in function %s", name, scope->fn->name);
+    return (long)value;
+}
+
+static void compile_op(const Scope *scope, const Tac_Instruction *in, Tr_Op *op)
+{
+    op->kind = in->kind;
+    switch (in->kind) {
+    case TAC_INSTRUCTION_RETURN:
+        op->src1 = val_operand(scope, in->u.return_.src);
+        break;
+    case TAC_INSTRUCTION_UNARY:
+        op->op   = in->u.unary.op;
+        op->src1 = val_operand(scope, in->u.unary.src);
+        op->dst  = val_operand(scope, in->u.unary.dst);
+        break;
+    case TAC_INSTRUCTION_BINARY:
+        op->op   = in->u.binary.op;
+        op->src1 = val_operand(scope, in->u.binary.src1);
+        op->src2 = val_operand(scope, in->u.binary.src2);
+        op->dst  = val_operand(scope, in->u.binary.dst);
+        break;
+    case TAC_INSTRUCTION_ADD_PTR:
+        op->src1 = val_operand(scope, in->u.add_ptr.ptr);
+        op->src2 = val_operand(scope, in->u.add_ptr.index);
+        op->dst  = val_operand(scope, in->u.add_ptr.dst);
+        op->imm  = in->u.add_ptr.scale;
+        if (op->imm != 1 && op->imm % scope->vm->word_bytes != 0)
+            fatal_error("tacrun: pointer scale %ld is not a whole number of words in %s",
+                        op->imm, scope->fn->name);
+        break;
+    case TAC_INSTRUCTION_PTR_DIFF:
+        op->src1 = val_operand(scope, in->u.ptr_diff.ptr_a);
+        op->src2 = val_operand(scope, in->u.ptr_diff.ptr_b);
+        op->dst  = val_operand(scope, in->u.ptr_diff.dst);
+        break;
+    case TAC_INSTRUCTION_COPY_TO_OFFSET:
+    case TAC_INSTRUCTION_COPY_BYTE_TO_OFFSET:
+        op->src1 = val_operand(scope, in->u.copy_to_offset.src);
+        op->dst  = name_operand(scope, in->u.copy_to_offset.dst);
+        op->imm  = in->u.copy_to_offset.offset;
+        break;
+    case TAC_INSTRUCTION_COPY_FROM_OFFSET:
+    case TAC_INSTRUCTION_COPY_BYTE_FROM_OFFSET:
+        op->src1 = name_operand(scope, in->u.copy_from_offset.src);
+        op->dst  = val_operand(scope, in->u.copy_from_offset.dst);
+        op->imm  = in->u.copy_from_offset.offset;
+        break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        op->src1 = val_operand(scope, in->u.block_copy.src_ptr);
+        op->dst  = val_operand(scope, in->u.block_copy.dst_ptr);
+        op->imm  = in->u.block_copy.size / scope->vm->word_bytes;
+        break;
+    case TAC_INSTRUCTION_JUMP:
+        op->imm = label_index(scope, in->u.jump.target);
+        break;
+    case TAC_INSTRUCTION_JUMP_IF_ZERO:
+        op->src1 = val_operand(scope, in->u.jump_if_zero.condition);
+        op->imm  = label_index(scope, in->u.jump_if_zero.target);
+        break;
+    case TAC_INSTRUCTION_JUMP_IF_NOT_ZERO:
+        op->src1 = val_operand(scope, in->u.jump_if_not_zero.condition);
+        op->imm  = label_index(scope, in->u.jump_if_not_zero.target);
+        break;
+    case TAC_INSTRUCTION_FUN_CALL:
+    case TAC_INSTRUCTION_FUN_CALL_NORETURN: {
+        if (in->u.fun_call.indirect) {
+            op->src1 = name_operand(scope, in->u.fun_call.fun_name);
+        } else {
+            op->callee = tr_function(scope->vm, in->u.fun_call.fun_name);
+            if (!op->callee)
+                fatal_error("tacrun: undefined function '%s' called from %s",
+                            in->u.fun_call.fun_name, scope->fn->name);
+        }
+        for (const Tac_Val *a = in->u.fun_call.args; a; a = a->next)
+            op->nargs++;
+        if (op->nargs > 0)
+            op->args = xalloc(op->nargs * sizeof(Tr_Operand), __func__, __FILE__, __LINE__);
+        int i = 0;
+        for (const Tac_Val *a = in->u.fun_call.args; a; a = a->next)
+            op->args[i++] = val_operand(scope, a);
+        op->dst = val_operand(scope, in->u.fun_call.dst);
+        break;
+    }
+    case TAC_INSTRUCTION_LABEL:
+    case TAC_INSTRUCTION_ALLOCATE_LOCAL:
+        break;
+    default:
+        op->src1 = val_operand(scope, in->u.copy.src);
+        op->dst  = val_operand(scope, in->u.copy.dst);
+        break;
+    }
+}
+
+static void compile_function(Tacrun *vm, Tr_Function *fn)
+{
+    Scope scope = { .vm = vm, .fn = fn };
+    map_init(&scope.params);
+    map_init(&scope.autos);
+    map_init(&scope.labels);
+
+    for (const Tac_Param *p = fn->tl->u.function.params; p; p = p->next)
+        map_insert(&scope.params, p->name, fn->nparams++, 0);
+    scan_frame(&scope, fn->tl->u.function.body);
+
+    for (const Tac_Instruction *in = fn->tl->u.function.body; in; in = in->next) {
+        if (in->kind == TAC_INSTRUCTION_LABEL)
+            map_insert(&scope.labels, in->u.label.name, fn->nops, 0);
+        fn->nops++;
+    }
+    if (fn->nops > 0) {
+        fn->ops     = xalloc(fn->nops * sizeof(Tr_Op), __func__, __FILE__, __LINE__);
+        fn->entries = xalloc(fn->nops * sizeof(uint64_t), __func__, __FILE__, __LINE__);
+        fn->taken   = xalloc(fn->nops * sizeof(uint64_t), __func__, __FILE__, __LINE__);
+    }
+
+    int i = 0;
+    for (const Tac_Instruction *in = fn->tl->u.function.body; in; in = in->next)
+        compile_op(&scope, in, &fn->ops[i++]);
+
+    map_destroy(&scope.params);
+    map_destroy(&scope.autos);
+    map_destroy(&scope.labels);
+}
+
+void tr_load(Tacrun *vm)
+{
+    const Target *t = target_config;
+    if (t->short_size != t->int_size || t->long_size != t->int_size ||
+        t->llong_size != t->int_size || t->pointer_size != t->int_size ||
+        t->double_size != t->int_size || t->aggregate_align != t->int_size)
+        fatal_error("tacrun: target %s is not word-addressed", t->name);
+
+    vm->word_bytes    = (int)t->int_size;
+    vm->word_bits     = (int)t->int_size * 8;
+    vm->int_bits      = t->int_bits;
+    vm->logical_shift = t->right_shift_is_logical;
+    if (vm->word_bits > 48)
+        fatal_error("tacrun: target %s has words wider than 48 bits", t->name);
+
+    layout(vm);
+    initialize(vm);
+    for (int i = 0; i < vm->nfuncs; i++)
+        if (vm->funcs[i]->tl)
+            compile_function(vm, vm->funcs[i]);
+}
+
+void tr_unload(Tacrun *vm)
+{
+    for (int i = 0; i < vm->nfuncs; i++) {
+        Tr_Function *fn = vm->funcs[i];
+        for (int k = 0; k < fn->nops; k++)
+            xfree(fn->ops[k].args);
+        xfree(fn->ops);
+        xfree(fn->entries);
+        xfree(fn->taken);
+        map_destroy(&fn->statics);
+        xfree(fn);
+    }
+    xfree(vm->funcs);
+    map_destroy(&vm->functions);
+    map_destroy(&vm->symbols);
+}
@@ -0,0 +1,214 @@
+//
+// tacrun: execute TAC produced by `lower` and report dynamic instruction counts.
+//
+#include <getopt.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "phase.h"
+#include "semantic.h"
+#include "tacrun.h"
+#include "target.h"
+#include "wio.h"
+#include "xalloc.h"
+
+//
+// Structure to hold parsed arguments
+//
+typedef struct {
+    int help;                // -h or --help
+    int profile;             // -p or --profile
+    const char *profile_out; // --profile-out
+    const char *target_name; // -t/--target
+    int time_report;         // --time-report
+    PhaseReportFormat report_format;
+    int ninputs;             // TAC files before `--`
+    char **inputs;
+    int nargs;               // arguments of the program, argv[0] included
+    char **args;
+} Args;
+
+static void print_usage(const char *prog_name)
+{
+    const char *p = strrchr(prog_name, '/');
+    if (p) {
+        prog_name = p + 1;
+    }
+    fprintf(stderr, "Usage:\n");
+    fprintf(stderr, "    %s [options] input.tac... [-- program-arguments]\n", prog_name);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "    -p, --profile       Print dynamic instruction counts to stderr\n");
+    fprintf(stderr, "    --profile-out FILE  Write block counts for lower --profile-use\n");
+    fprintf(stderr, "    -t, --target NAME   Target architecture (default: besm6)\n");
+    fprintf(stderr, "    --time-report[=json]\n");
+    fprintf(stderr, "                        Print time and memory per phase to stderr\n");
+    fprintf(stderr, "    -h, --help          Show this help message\n");
+    fprintf(stderr, "The exit status is the value main() returns, or the argument of exit().\n");
+}
+
+static int parse_args(int argc, char *argv[], Args *args)
+{
+    static struct option long_options[] = {
+        { "help", no_argument, 0, 'h' },              //
+        { "profile", no_argument, 0, 'p' },           //
+        { "target", required_argument, 0, 't' },      //
+        { "time-report", optional_argument, 0, 256 }, //
+        { "profile-out", required_argument, 0, 257 }, //
+        {},                                           //
+    };
+
+    int opt;
+    int option_index = 0;
+
+    if (argc < 2) {
+        args->help = 1;
+        return 0;
+    }
+    while ((opt = getopt_long(argc, argv, "+hpt:", long_options, &option_index)) != -1) {
+        switch (opt) {
+        case 'h':
+            args->help = 1;
+            return 0;
+        case 'p':
+            args->profile = 1;
+            break;
+        case 't':
+            args->target_name = optarg;
+            break;
+        case 256:
+            if (!phase_parse_format(optarg, &args->report_format)) {
+                fprintf(stderr, "Error: Unknown --time-report format '%s'\n", optarg);
+                return -1;
+            }
+            args->time_report = 1;
+            break;
+        case 257:
+            args->profile_out = optarg;
+            break;
+        case '?':
+            return -1;
+        }
+    }
+
+    // Options stop at the first input ("+" above), so that the program's own options
+    // after `--` are left alone.  Everything up to `--` is an input.
+    args->inputs = &argv[optind];
+    while (optind < argc && strcmp(argv[optind], "--") != 0) {
+        args->ninputs++;
+        optind++;
+    }
+    if (args->ninputs == 0) {
+        fprintf(stderr, "Error: Input filename is required\n");
+        return -1;
+    }
+    // The program sees the first input as its argv[0].
+    if (optind < argc) {
+        argv[optind] = args->inputs[0];
+        args->args   = &argv[optind];
+        args->nargs  = argc - optind;
+    } else {
+        args->args  = args->inputs;
+        args->nargs = 1;
+    }
+    return 0;
+}
+
+//
+// Read every toplevel of one TAC file, in either encoding, onto the end of `tail`.
+//
+static Tac_TopLevel **import_file(const char *path, Tac_TopLevel **tail)
+{
+    WFILE input;
+    int status = strcmp(path, "-") == 0 ? wdopen(&input, STDIN_FILENO, "r")
+                                        : wopen(&input, path, "r");
+    if (status < 0) {
+        perror(path);
+        exit(1);
+    }
+    for (;;) {
+        Tac_TopLevel *tac = tac_import_toplevel(&input);
+        if (!tac)
+            break;
+        *tail = tac;
+        while (*tail)
+            tail = &(*tail)->next;
+    }
+    wclose(&input);
+    return tail;
+}
+
+//
+// Error handling
+//
+void _Noreturn fatal_error(const char *message, ...)
+{
+    fprintf(stderr, "Fatal error: ");
+
+    va_list ap;
+    va_start(ap, message);
+    vfprintf(stderr, message, ap);
+    va_end(ap);
+
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    Args args = { .target_name = "besm6" };
+
+    if (parse_args(argc, argv, &args) != 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (args.help) {
+        print_usage(argv[0]);
+        return 0;
+    }
+
+    if (args.time_report)
+        phase_enable();
+
+    target_config = target_lookup(args.target_name);
+    if (!target_config) {
+        fprintf(stderr, "Unknown target '%s'. Known targets:\n", args.target_name);
+        target_list();
+        exit(1);
+    }
+
+    Tac_Program program = { NULL };
+    Tac_TopLevel **tail = &program.decls;
+    phase_begin("import");
+    for (int i = 0; i < args.ninputs; i++)
+        tail = import_file(args.inputs[i], tail);
+    phase_end();
+
+    phase_begin("load");
+    Tacrun *vm = tacrun_create(&program, stdout);
+    phase_end();
+    phase_begin("execute");
+    int status = tacrun_main(vm, args.nargs, args.args);
+    phase_end();
+    if (args.profile)
+        tacrun_print_profile(stderr, vm);
+    if (args.profile_out) {
+        FILE *fd = fopen(args.profile_out, "w");
+        if (!fd) {
+            perror(args.profile_out);
+            exit(1);
+        }
+        tacrun_write_block_profile(fd, vm);
+        fclose(fd);
+    }
+
+    tacrun_destroy(vm);
+    tac_free_toplevel(program.decls);
+    tac_intern_destroy();
+    if (args.time_report)
+        phase_report(stderr, "tacrun", args.report_format);
+    xfree_all();
+    return status;
+}
@@ -0,0 +1,71 @@
+//
+// TAC interpreter: runs a Tac_Program on the host, modelling the BESM-6 memory layout.
+//
+// Memory is an array of 48-bit words addressed by 15-bit word addresses, as on the
+// target.  Scalars and word pointers take one word each, char arrays and char struct
+// members are packed six bytes to a word, and char*/void* values are fat pointers in
+// the layout the BESM-6 lowering emits.  Integer results wrap to the signed and
+// unsigned widths of the active target (target_config).  Floating-point words hold
+// host doubles: arithmetic is IEEE, not the native BESM-6 format.
+//
+// Calls to functions that no input defines go to a small host-side libc: printf,
+// putchar, puts, malloc and friends, string and memory routines, exit.
+//
+// Every executed instruction is counted, per function and per instruction kind, so
+// an optimizer change can be measured without a simulator.
+//
+#ifndef TACRUN_H
+#define TACRUN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "tac.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Tacrun Tacrun;
+
+//
+// Load a program: lay out its static data and resolve every name.  The program must
+// stay alive until tacrun_destroy().  Program output goes to `out`.  An unknown name,
+// a target that is not word-addressed, or a program that does not fit in memory is a
+// fatal error.
+//
+Tacrun *tacrun_create(const Tac_Program *prog, FILE *out);
+void tacrun_destroy(Tacrun *vm);
+
+//
+// Call main() (or program(), the Dubna entry point) with the given arguments and
+// return its exit status: the value main returns, or the argument of exit().
+//
+int tacrun_main(Tacrun *vm, int argc, char *const argv[]);
+
+//
+// Dynamic counts gathered so far.
+//
+uint64_t tacrun_instruction_count(const Tacrun *vm);
+uint64_t tacrun_kind_count(const Tacrun *vm, Tac_InstructionKind kind);
+uint64_t tacrun_call_count(const Tacrun *vm, const char *function);
+uint64_t tacrun_function_count(const Tacrun *vm, const char *function); // instructions
+
+//
+// Report the counts: functions by instructions executed, then instruction kinds.
+//
+void tacrun_print_profile(FILE *fd, const Tacrun *vm);
+
+//
+// Write the block profile that `lower --profile-use` lays code out by (see optimize.h):
+// for every function that ran, how often each basic block was entered and the jump that
+// ends it was taken.
+//
+void tacrun_write_block_profile(FILE *fd, const Tacrun *vm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TACRUN_H
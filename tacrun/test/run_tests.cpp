@@ -0,0 +1,354 @@
+//
+// Tests for the TAC interpreter: compile C through the front end, run the TAC, and
+// check the program output, the exit status and the dynamic counts.
+//
+#include <gtest/gtest.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+
+#include "test_preprocess.h"
+
+extern "C" {
+#include "optimize.h"
+#include "parser.h"
+#include "semantic.h"
+#include "structtab.h"
+#include "symtab.h"
+#include "tac.h"
+#include "tacrun.h"
+#include "target.h"
+#include "translate.h"
+#include "typetab.h"
+#include "xalloc.h"
+
+[[noreturn]] void fatal_error(const char *message, ...)
+{
+    fprintf(stderr, "Fatal error: ");
+    va_list ap;
+    va_start(ap, message);
+    vfprintf(stderr, message, ap);
+    va_end(ap);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+}
+
+class TacrunTest : public ::testing::Test {
+protected:
+    Tac_Program program{};
+    Tacrun *vm{};
+    FILE *out{};
+    std::string output;
+    int status{};
+
+    void SetUp() override { target_config = target_lookup("besm6"); }
+
+    void TearDown() override
+    {
+        Reset();
+        tac_intern_destroy();
+        xreport_lost_memory();
+        EXPECT_EQ(xtotal_allocated_size(), 0);
+        xfree_all();
+    }
+
+    // Drop the program and the front-end tables, so that another unit can be compiled.
+    void Reset()
+    {
+        if (vm)
+            tacrun_destroy(vm);
+        vm = nullptr;
+        tac_free_toplevel(program.decls);
+        program.decls = nullptr;
+        if (out)
+            fclose(out);
+        out = nullptr;
+        symtab_destroy();
+        structtab_destroy();
+        typetab_destroy();
+        nametab_destroy();
+    }
+
+    // Compile `src` as one translation unit into `program`.
+    void Compile(const char *src, OptFlags flags)
+    {
+        std::string source = preprocess_source(src);
+        ASSERT_FALSE(source.empty()) << "C preprocessing failed for test source";
+
+        FILE *input = tmpfile();
+        ASSERT_NE(nullptr, input);
+        fwrite(source.data(), 1, source.size(), input);
+        rewind(input);
+        Program *ast = parse(input);
+        fclose(input);
+        ASSERT_NE(nullptr, ast);
+
+        Tac_TopLevel **tail = &program.decls;
+        int label_seq       = 0;
+        ExternalDecl *decls = ast->decls;
+        ast->decls          = nullptr;
+        while (decls) {
+            ExternalDecl *next = decls->next;
+            decls->next        = nullptr;
+            typecheck_decl(decls, &label_seq);
+            *tail = translate(decls, flags, &label_seq);
+            free_external_decl(decls);
+            while (*tail)
+                tail = &(*tail)->next;
+            decls = next;
+        }
+        free_program(ast);
+    }
+
+    // Compile and run `src`; the output lands in `output` and the exit code in `status`.
+    void Run(const char *src, OptFlags flags = opt_flags_default())
+    {
+        Compile(src, flags);
+        Execute();
+    }
+
+    // Run the compiled `program` again from a fresh interpreter.
+    void Execute()
+    {
+        if (vm)
+            tacrun_destroy(vm);
+        if (out)
+            fclose(out);
+        out = tmpfile();
+        ASSERT_NE(nullptr, out);
+        vm = tacrun_create(&program, out);
+
+        char name[]  = "prog";
+        char *argv[] = { name, nullptr };
+        status       = tacrun_main(vm, 1, argv);
+
+        long len = ftell(out);
+        rewind(out);
+        output.assign(static_cast<size_t>(len), '\0');
+        if (len > 0) {
+            EXPECT_EQ(fread(&output[0], 1, static_cast<size_t>(len), out), (size_t)len);
+        }
+    }
+};
+
+TEST_F(TacrunTest, ReturnsExitStatus)
+{
+    Run("int main(void) { return 42; }");
+    EXPECT_EQ(status, 42);
+    EXPECT_EQ(output, "");
+    EXPECT_EQ(tacrun_call_count(vm, "main"), 1u);
+}
+
+TEST_F(TacrunTest, ExitFromNestedCall)
+{
+    Run("void exit(int);\n"
+        "int puts(const char *);\n"
+        "void quit(int n) { puts(\"bye\"); exit(n); }\n"
+        "int main(void) { quit(3); return 0; }\n");
+    EXPECT_EQ(status, 3);
+    EXPECT_EQ(output, "bye\n");
+}
+
+TEST_F(TacrunTest, RecursionAndCounts)
+{
+    Run("int fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }\n"
+        "int main(void) { return fib(10); }\n");
+    EXPECT_EQ(status, 55);
+    EXPECT_EQ(tacrun_call_count(vm, "fib"), 177u);
+    EXPECT_EQ(tacrun_kind_count(vm, TAC_INSTRUCTION_FUN_CALL), 177u);
+    EXPECT_EQ(tacrun_kind_count(vm, TAC_INSTRUCTION_RETURN), 178u);
+
+    uint64_t total = 0;
+    for (int k = 0; k <= TAC_INSTRUCTION_ALLOCATE_LOCAL; k++)
+        total += tacrun_kind_count(vm, (Tac_InstructionKind)k);
+    EXPECT_EQ(total, tacrun_instruction_count(vm));
+    EXPECT_EQ(tacrun_function_count(vm, "fib") + tacrun_function_count(vm, "main"), total);
+}
+
+TEST_F(TacrunTest, PrintfFormats)
+{
+    Run("#include <stdio.h>\n"
+        "int main(void) {\n"
+        "    printf(\"%d|%5d|%-4d|%u|%x|%o|%c|%s|%.3s|%%\\n\", -7, 42, 3, 10u, 255, 8, 'z',\n"
+        "           \"str\", \"abcdef\");\n"
+        "    printf(\"%g %.2f\\n\", 1.5 * 3, 2.0 / 3);\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(output, "-7|   42|3   |10|ff|10|z|str|abc|%\n4.5 0.67\n");
+}
+
+TEST_F(TacrunTest, PackedCharacters)
+{
+    Run("#include <stdio.h>\n"
+        "struct P { int x; char c; char d; int y; };\n"
+        "char msg[] = \"hello, world\";\n"
+        "int main(void) {\n"
+        "    struct P p;\n"
+        "    char *s = msg;\n"
+        "    p.x = 1; p.c = 'a'; p.d = 'b'; p.y = 2;\n"
+        "    s += 7;\n"
+        "    *s = 'W';\n"
+        "    printf(\"%d%c%c%d %s %d %d\\n\", p.x, p.c, p.d, p.y, msg, (int)(s - msg),\n"
+        "           (int)sizeof(struct P));\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(output, "1ab2 hello, World 7 18\n");
+}
+
+TEST_F(TacrunTest, StaticData)
+{
+    Run("#include <stdio.h>\n"
+        "static int tab[4] = { 1, 2, 3 };\n"
+        "char *names[] = { \"ab\", \"cd\" };\n"
+        "struct S { char tag; int v; } pairs[2] = { { 'x', 10 }, { 'y', 20 } };\n"
+        "int counter(void) { static int calls = 5; return ++calls; }\n"
+        "int main(void) {\n"
+        "    counter();\n"
+        "    printf(\"%d %d %s %c%d%c%d %d\\n\", tab[2], tab[3], names[1], pairs[0].tag,\n"
+        "           pairs[0].v, pairs[1].tag, pairs[1].v, counter());\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(output, "3 0 cd x10y20 7\n");
+}
+
+TEST_F(TacrunTest, HeapAndStrings)
+{
+    Run("#include <stdio.h>\n"
+        "#include <stdlib.h>\n"
+        "#include <string.h>\n"
+        "struct node { int v; struct node *next; };\n"
+        "int main(void) {\n"
+        "    struct node *head = 0;\n"
+        "    for (int i = 0; i < 5; i++) {\n"
+        "        struct node *n = malloc(sizeof *n);\n"
+        "        n->v = i; n->next = head; head = n;\n"
+        "    }\n"
+        "    int sum = 0;\n"
+        "    while (head) { struct node *n = head; sum += n->v; head = n->next; free(n); }\n"
+        "    char *buf = malloc(32);\n"
+        "    strcpy(buf, \"abc\");\n"
+        "    strcat(buf, \"def\");\n"
+        "    printf(\"%d %s %d %d\\n\", sum, buf, (int)strlen(buf), strcmp(buf, \"abd\") < 0);\n"
+        "    free(buf);\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(output, "10 abcdef 6 1\n");
+}
+
+TEST_F(TacrunTest, UnaryOperatorsOnVariables)
+{
+    Run("#include <stdio.h>\n"
+        "int abs_of(long v) { unsigned long u; if (v < 0) u = -v; else u = v; return (int)u; }\n"
+        "int main(void) {\n"
+        "    int x = 5, z = 0;\n"
+        "    printf(\"%d %d %d %d %d\\n\", -x, ~x, !x, !z, abs_of(-4));\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(output, "-5 -6 0 1 4\n");
+    EXPECT_GT(tacrun_kind_count(vm, TAC_INSTRUCTION_UNARY), 0u);
+}
+
+TEST_F(TacrunTest, TargetIntegerWidths)
+{
+    // BESM-6: signed arithmetic wraps at 41 bits, unsigned at 48.
+    Run("#include <stdio.h>\n"
+        "int main(void) {\n"
+        "    long big = 1;\n"
+        "    for (int i = 0; i < 40; i++) big *= 2;\n"
+        "    unsigned long u = 0;\n"
+        "    u -= 1;\n"
+        "    printf(\"%ld %lo %d\\n\", big, u, (int)(u >> 44));\n"
+        "    return 0;\n"
+        "}\n");
+    EXPECT_EQ(output, "-1099511627776 7777777777777777 15\n");
+}
+
+TEST_F(TacrunTest, VarargsAndFunctionPointers)
+{
+    Run("#include <stdarg.h>\n"
+        "int sum(int n, ...) {\n"
+        "    va_list ap; int s = 0;\n"
+        "    va_start(ap, n);\n"
+        "    for (int i = 0; i < n; i++) s += va_arg(ap, int);\n"
+        "    va_end(ap);\n"
+        "    return s;\n"
+        "}\n"
+        "static int sq(int x) { return x * x; }\n"
+        "int apply(int (*f)(int), int x) { return f(x); }\n"
+        "int main(void) { return sum(3, 10, 20, 30) + apply(sq, 4); }\n");
+    EXPECT_EQ(status, 76);
+    EXPECT_EQ(tacrun_call_count(vm, "sq"), 1u);
+}
+
+//
+// Differential check: the optimizer must not change what a program prints, and it
+// should not make it execute more instructions.
+//
+class TacrunDifferentialTest : public TacrunTest {
+protected:
+    static constexpr const char *kSource =
+        "#include <stdio.h>\n"
+        "int collatz(int n) {\n"
+        "    int steps = 0;\n"
+        "    while (n != 1) { int t = n; if (t % 2) n = 3 * t + 1; else n = t / 2; steps++; }\n"
+        "    return steps;\n"
+        "}\n"
+        "int main(void) {\n"
+        "    int best = 0, arg = 0;\n"
+        "    for (int i = 1; i < 200; i++) { int s = collatz(i); if (s > best) { best = s; arg = i; } }\n"
+        "    printf(\"%d %d\\n\", arg, best);\n"
+        "    return 0;\n"
+        "}\n";
+
+    void RunUnoptimized()
+    {
+        OptFlags none{};
+        Run(kSource, none);
+    }
+};
+
+TEST_F(TacrunDifferentialTest, OptimizerPreservesOutput)
+{
+    Run(kSource);
+    std::string optimized = output;
+    uint64_t executed     = tacrun_instruction_count(vm);
+    EXPECT_EQ(optimized, "171 124\n");
+
+    Reset();
+    RunUnoptimized();
+    EXPECT_EQ(output, optimized);
+    EXPECT_LE(executed, tacrun_instruction_count(vm));
+}
+
+//
+// Profile-guided layout: a profile of the run reorders the blocks so that the hot paths fall
+// through, which must keep the output and take fewer jumps.
+//
+TEST_F(TacrunDifferentialTest, ProfileLayoutTakesFewerJumps)
+{
+    Run(kSource);
+    std::string expected = output;
+    uint64_t jumps       = tacrun_kind_count(vm, TAC_INSTRUCTION_JUMP);
+
+    const char *path = "layout_test.prof";
+    FILE *prof       = fopen(path, "w");
+    ASSERT_NE(nullptr, prof);
+    tacrun_write_block_profile(prof, vm);
+    fclose(prof);
+    OptProfile *profile = opt_profile_read(path);
+    remove(path);
+    ASSERT_NE(nullptr, profile);
+
+    tacrun_destroy(vm);
+    vm            = nullptr;
+    int label_seq = 10000;
+    for (Tac_TopLevel *fn = program.decls; fn; fn = fn->next)
+        layout_function(fn, profile, &label_seq);
+    opt_profile_free(profile);
+
+    Execute();
+    EXPECT_EQ(output, expected);
+    EXPECT_LT(tacrun_kind_count(vm, TAC_INSTRUCTION_JUMP), jumps);
+}
@@ -477,7 +477,8 @@ static bool aggregate_named_base(const Expr *e, const char **name, int *off)
 // COPY_TO_OFFSET) or, for a pointer/subscript/nested lvalue, an address reached by ADD_PTR +
 // LOAD / STORE.  A non-lvalue source (a function-call return or compound literal) is first
 // materialised into a named temporary via gen_expr.  This generalises gen_struct_assign to
-// the cases where either operand is reached through a pointer.
+// the cases where either operand is reached through a pointer.  A large aggregate is
+// copied by one BLOCK_COPY between the two addresses instead.
 static Tac_Val *gen_aggregate_assign(TacCtx *ctx, Expr *target, Expr *value)
 {
     int w      = target_word_bytes();
@@ -504,6 +505,12 @@ static Tac_Val *gen_aggregate_assign(TacCtx *ctx, Expr *target, Expr *value)
         }
     }
 
+    if (aggregate_copy_is_block(nbytes)) {
+        Tac_Val *from = sname ? gen_aggregate_address(ctx, sname, soff) : val_var(sptr->u.var_name);
+        Tac_Val *to   = dname ? gen_aggregate_address(ctx, dname, doff) : val_var(dptr->u.var_name);
+        gen_block_copy(ctx, from, to, nbytes);
+        nwords = 0; // nothing left to unroll
+    }
     for (int i = 0; i < nwords; i++) {
         Tac_Val *word = new_var_val(ctx);
         if (sname) {
@@ -557,7 +564,7 @@ static Tac_Val *gen_aggregate_assign(TacCtx *ctx, Expr *target, Expr *value)
 // aggregate base), this reads the source the same way gen_aggregate_assign does: a named
 // base via COPY_FROM_OFFSET, a call/compound rvalue materialised by gen_expr, or — the case
 // gen_struct_assign got wrong for `agg = *ptr` — a pointer/subscript lvalue loaded word by
-// word through ADD_PTR + LOAD.
+// word through ADD_PTR + LOAD.  A large aggregate is copied by one BLOCK_COPY instead.
 void gen_aggregate_init_from_expr(TacCtx *ctx, const char *dname, int doff, Expr *value,
                                   int nbytes)
 {
@@ -577,6 +584,11 @@ void gen_aggregate_init_from_expr(TacCtx *ctx, const char *dname, int doff, Expr
         }
     }
 
+    if (aggregate_copy_is_block(nbytes)) {
+        Tac_Val *from = sname ? gen_aggregate_address(ctx, sname, soff) : val_var(sptr->u.var_name);
+        gen_block_copy(ctx, from, gen_aggregate_address(ctx, dname, doff), nbytes);
+        nwords = 0; // nothing left to unroll
+    }
     for (int i = 0; i < nwords; i++) {
         Tac_Val *word = new_var_val(ctx);
         if (sname) {
@@ -617,7 +629,7 @@ static Tac_Val *gen_logical_and(TacCtx *ctx, Expr *l, Expr *r)
 
     Tac_Instruction *jz          = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_ZERO);
     jz->u.jump_if_zero.condition = left;
-    jz->u.jump_if_zero.target    = false_l; // instruction takes ownership
+    jz->u.jump_if_zero.target    = tac_intern(false_l);
     tac_append(ctx, jz);
 
     Tac_Val *right       = gen_cond_val(ctx, r);
@@ -629,7 +641,7 @@ static Tac_Val *gen_logical_and(TacCtx *ctx, Expr *l, Expr *r)
     tac_append(ctx, bin);
     emit_jump(ctx, end_l);
 
-    emit_label(ctx, false_l); // false_l still valid; owned by jz
+    emit_label(ctx, false_l);
     Tac_Instruction *cp = tac_new_instruction(TAC_INSTRUCTION_COPY);
     cp->u.copy.src      = val_int(0);
     cp->u.copy.dst      = val_var(dst_name);
@@ -637,6 +649,7 @@ static Tac_Val *gen_logical_and(TacCtx *ctx, Expr *l, Expr *r)
 
     emit_label(ctx, end_l);
     xfree(end_l);
+    xfree(false_l);
     Tac_Val *result = val_var(dst_name);
     xfree(dst_name);
     return result;
@@ -651,7 +664,7 @@ static Tac_Val *gen_logical_or(TacCtx *ctx, Expr *l, Expr *r)
 
     Tac_Instruction *jnz              = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_NOT_ZERO);
     jnz->u.jump_if_not_zero.condition = left;
-    jnz->u.jump_if_not_zero.target    = true_l; // instruction takes ownership
+    jnz->u.jump_if_not_zero.target    = tac_intern(true_l);
     tac_append(ctx, jnz);
 
     Tac_Val *right       = gen_cond_val(ctx, r);
@@ -663,7 +676,7 @@ static Tac_Val *gen_logical_or(TacCtx *ctx, Expr *l, Expr *r)
     tac_append(ctx, bin);
     emit_jump(ctx, end_l);
 
-    emit_label(ctx, true_l); // true_l still valid; owned by jnz
+    emit_label(ctx, true_l);
     Tac_Instruction *cp = tac_new_instruction(TAC_INSTRUCTION_COPY);
     cp->u.copy.src      = val_int(1);
     cp->u.copy.dst      = val_var(dst_name);
@@ -671,6 +684,7 @@ static Tac_Val *gen_logical_or(TacCtx *ctx, Expr *l, Expr *r)
 
     emit_label(ctx, end_l);
     xfree(end_l);
+    xfree(true_l);
     Tac_Val *result = val_var(dst_name);
     xfree(dst_name);
     return result;
@@ -1308,7 +1322,7 @@ Tac_Val *gen_expr(TacCtx *ctx, Expr *e)
 
             Tac_Instruction *jz          = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_ZERO);
             jz->u.jump_if_zero.condition = cond_val;
-            jz->u.jump_if_zero.target    = else_l; // instruction takes ownership
+            jz->u.jump_if_zero.target    = tac_intern(else_l);
             tac_append(ctx, jz);
 
             Tac_Val *then_val = gen_expr(ctx, e->u.cond.then_expr);
@@ -1323,6 +1337,7 @@ Tac_Val *gen_expr(TacCtx *ctx, Expr *e)
 
             emit_label(ctx, end_l);
             xfree(end_l);
+            xfree(else_l);
             Tac_Val *result = val_var(slot);
             xfree(slot);
             return result;
@@ -1334,7 +1349,7 @@ Tac_Val *gen_expr(TacCtx *ctx, Expr *e)
 
         Tac_Instruction *jz          = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_ZERO);
         jz->u.jump_if_zero.condition = cond_val;
-        jz->u.jump_if_zero.target    = else_l; // instruction takes ownership
+        jz->u.jump_if_zero.target    = tac_intern(else_l);
         tac_append(ctx, jz);
 
         Tac_Val *then_val        = gen_expr(ctx, e->u.cond.then_expr);
@@ -1353,6 +1368,7 @@ Tac_Val *gen_expr(TacCtx *ctx, Expr *e)
 
         emit_label(ctx, end_l);
         xfree(end_l);
+        xfree(else_l);
         Tac_Val *result = val_var(dst_name);
         xfree(dst_name);
         return result;
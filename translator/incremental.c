@@ -0,0 +1,537 @@
+//
+// Incremental recompilation for lower.  See incremental.h.
+//
+#include "incremental.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "semantic.h"
+#include "string_map.h"
+#include "structtab.h"
+#include "symtab.h"
+#include "typetab.h"
+#include "xalloc.h"
+
+#define INCREMENTAL_MAGIC 0x696e6372 // 'incr' - trailer of the database
+
+IncrementalStats incremental_stats;
+
+static WFILE digest_sink; // what is digested is written here
+static bool sink_open;
+
+static void begin_digest(void)
+{
+    if (!sink_open) {
+        if (wopen(&digest_sink, "/dev/null", "w") < 0) {
+            perror("/dev/null");
+            exit(1);
+        }
+        sink_open = true;
+    }
+    wdigest_begin(&digest_sink);
+}
+
+uint64_t decl_digest(ExternalDecl *ast)
+{
+    begin_digest();
+    export_external_decl(&digest_sink, ast);
+    return wdigest_end(&digest_sink);
+}
+
+//
+// Renaming of the names a record numbered from the unit-wide counters.
+//
+typedef struct {
+    int seq_lo, seq_hi, seq_delta; // %N and %LN
+    int str_lo, str_hi, str_delta; // _strN
+} Renumber;
+
+static Renumber renumber;
+
+//
+// Rename hook for tac_import: shift a counter-numbered name of the record being read.
+//
+static const char *renumber_name(const char *name)
+{
+    static char buf[64];
+    size_t prefix;
+    int lo, hi, delta;
+    if (name[0] == '%' && isdigit((unsigned char)name[1])) {
+        prefix = 1;
+    } else if (strncmp(name, "%L", 2) == 0 && isdigit((unsigned char)name[2])) {
+        prefix = 2;
+    } else if (strncmp(name, "_str", 4) == 0 && isdigit((unsigned char)name[4])) {
+        prefix = 4;
+    } else {
+        return name;
+    }
+    if (name[0] == '%') {
+        lo    = renumber.seq_lo;
+        hi    = renumber.seq_hi;
+        delta = renumber.seq_delta;
+    } else {
+        lo    = renumber.str_lo;
+        hi    = renumber.str_hi;
+        delta = renumber.str_delta;
+    }
+    char *end;
+    long n = strtol(name + prefix, &end, 10);
+    if (*end != '\0' || n < lo || n >= hi)
+        return name;
+    snprintf(buf, sizeof(buf), "%.*s%ld", (int)prefix, name, n + delta);
+    return buf;
+}
+
+void decl_record_write(WFILE *out, const Tac_TopLevel *tac, int seq_in, int seq_out, int str_in,
+                       int str_out)
+{
+    wputw(seq_in, out);
+    wputw(seq_out, out);
+    wputw(str_in, out);
+    wputw(str_out, out);
+    for (const Tac_TopLevel *t = tac; t; t = t->next)
+        tac_export_toplevel(out, t);
+    tac_export_toplevel(out, NULL);
+}
+
+Tac_TopLevel *decl_record_read(WFILE *in, const char *path, int seq_in, int str_in,
+                               int *label_seq)
+{
+    renumber.seq_lo    = (int)wgetw(in);
+    renumber.seq_hi    = (int)wgetw(in);
+    renumber.str_lo    = (int)wgetw(in);
+    renumber.str_hi    = (int)wgetw(in);
+    renumber.seq_delta = seq_in - renumber.seq_lo;
+    renumber.str_delta = str_in - renumber.str_lo;
+    if (werror(in) || weof(in)) {
+        fprintf(stderr, "Error: bad TAC record in %s\n", path);
+        exit(1);
+    }
+
+    tac_import_set_rename(renumber_name);
+    Tac_TopLevel *head  = NULL;
+    Tac_TopLevel **tail = &head;
+    while ((*tail = tac_import_toplevel(in)) != NULL)
+        while (*tail)
+            tail = &(*tail)->next;
+    tac_import_set_rename(NULL);
+
+    // What translate() does to the tables besides: the initializer of a static variable
+    // moves into its toplevel, so that a later declaration of the variable emits nothing.
+    void (*hook)(LookupTable, const char *) = semantic_lookup_hook;
+    semantic_lookup_hook                    = NULL;
+    for (const Tac_TopLevel *t = head; t; t = t->next) {
+        if (t->kind != TAC_TOPLEVEL_STATIC_VARIABLE)
+            continue;
+        Symbol *sym = symtab_get_opt(t->u.static_variable.name);
+        if (sym && sym->kind == SYM_STATIC) {
+            tac_free_static_init(sym->u.static_var.init_list);
+            sym->u.static_var.init_list = NULL;
+        }
+    }
+    semantic_lookup_hook = hook;
+
+    *label_seq = seq_in + renumber.seq_hi - renumber.seq_lo;
+    symtab_set_string_seq(str_in + renumber.str_hi - renumber.str_lo);
+    return head;
+}
+
+//
+// The database, written in word format:
+//
+//      options
+//      record...                           -- see decl_record_write()
+//      count, count x { key, offset, ndeps, ndeps x { table, name, digest } }
+//      index offset, INCREMENTAL_MAGIC     -- two raw words, at the very end
+//
+// An entry of the index is a declaration in the order of the unit.  Offsets are in bytes
+// from the start of the file.  A digest of 0 stands for a name that was not in its table.
+//
+typedef struct {
+    LookupTable table;
+    char *name;
+    uint64_t digest;
+} Dependency;
+
+typedef struct {
+    uint64_t key;
+    size_t offset;
+    size_t ndeps;
+    Dependency *deps;
+    size_t same_key; // next record with the key, as repeated declarations have; or NO_RECORD
+} Record;
+
+#define NO_RECORD ((size_t)-1)
+
+typedef struct {
+    size_t count;
+    size_t cap;
+    Record *records;
+} RecordList;
+
+static char *db_path;
+static char *new_path; // the database being written, renamed into place at close
+static uint64_t db_options;
+static WFILE old_db, new_db;
+static bool old_open, new_open;
+static RecordList old_records, new_records;
+static StringMap old_by_key; // hex key -> index of the first record with it
+static StringMap used;       // table digit and name -> digest, while recording
+static const Record *hit;    // the record incremental_find() found reusable
+
+static void key_name(char *buf, size_t size, uint64_t key)
+{
+    snprintf(buf, size, "%016llx", (unsigned long long)key);
+}
+
+static Record *add_record(RecordList *list)
+{
+    if (list->count == list->cap) {
+        size_t cap     = list->cap ? list->cap * 2 : 64;
+        Record *bigger = xalloc(cap * sizeof(Record), __func__, __FILE__, __LINE__);
+        if (list->count > 0)
+            memcpy(bigger, list->records, list->count * sizeof(Record));
+        xfree(list->records);
+        list->records = bigger;
+        list->cap     = cap;
+    }
+    Record *r = &list->records[list->count++];
+    memset(r, 0, sizeof(*r));
+    return r;
+}
+
+static void free_records(RecordList *list)
+{
+    for (size_t i = 0; i < list->count; i++) {
+        for (size_t j = 0; j < list->records[i].ndeps; j++)
+            xfree(list->records[i].deps[j].name);
+        xfree(list->records[i].deps);
+    }
+    xfree(list->records);
+    memset(list, 0, sizeof(*list));
+}
+
+//
+// Values of `used` that are no digest: a name not digested yet, and a name that is no
+// dependency.  String literals are numbered from a counter and renumbered on replay, so
+// they are none.
+//
+#define DIGEST_PENDING ((uint64_t)-1)
+#define DIGEST_SKIP    ((uint64_t)-2)
+
+//
+// Digest of the current entry for a name, 0 when there is none, or DIGEST_SKIP.
+//
+static uint64_t entry_digest(LookupTable table, const char *name)
+{
+    begin_digest();
+    switch (table) {
+    case LOOKUP_SYMBOL: {
+        const Symbol *sym = symtab_get_opt(name);
+        if (!sym)
+            return 0;
+        if (sym->kind == SYM_CONST)
+            return DIGEST_SKIP;
+        wputw(sym->kind, &digest_sink);
+        wputw(sym->has_linkage | sym->block_scope << 1, &digest_sink);
+        ast_export_type(&digest_sink, sym->type);
+        switch (sym->kind) {
+        case SYM_FUNC:
+            wputw(sym->u.func.defined | sym->u.func.global << 1 | sym->u.func.noret << 2,
+                  &digest_sink);
+            break;
+        case SYM_STATIC:
+            wputw(sym->u.static_var.global, &digest_sink);
+            wputw(sym->u.static_var.init_kind, &digest_sink);
+            tac_export_static_init(&digest_sink, sym->u.static_var.init_list);
+            break;
+        case SYM_ENUM:
+            wputi(sym->u.enum_val, &digest_sink);
+            break;
+        default:
+            break;
+        }
+        break;
+    }
+    case LOOKUP_STRUCT: {
+        const StructDef *def = structtab_find_opt(name);
+        if (!def)
+            return 0;
+        wputw(def->kind, &digest_sink);
+        wputw(def->complete, &digest_sink);
+        wputi(def->alignment, &digest_sink);
+        wputi(def->size, &digest_sink);
+        for (const FieldDef *f = def->members; f; f = f->next) {
+            wputstr(f->name, &digest_sink);
+            wputi(f->offset, &digest_sink);
+            ast_export_type(&digest_sink, f->type);
+        }
+        break;
+    }
+    case LOOKUP_TYPEDEF: {
+        if (!typetab_exists(name))
+            return 0;
+        const TypeDef *def = typetab_find(name);
+        wputi(def->level, &digest_sink);
+        ast_export_type(&digest_sink, def->type);
+        break;
+    }
+    }
+    uint64_t digest = wdigest_end(&digest_sink);
+    return digest != 0 && digest < DIGEST_SKIP ? digest : 1;
+}
+
+static void record_lookup(LookupTable table, const char *name)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%d%s", (int)table, name);
+    if (!map_get(&used, buf, NULL))
+        map_insert(&used, buf, (intptr_t)DIGEST_PENDING, 0);
+}
+
+typedef struct {
+    size_t count;
+    const char **names;
+} NameList;
+
+static void count_name(const char *key, intptr_t value, const void *arg)
+{
+    (void)key;
+    (void)value;
+    (*(size_t *)arg)++;
+}
+
+static void add_pending(const char *key, intptr_t value, const void *arg)
+{
+    NameList *list = (NameList *)arg;
+    if ((uint64_t)value == DIGEST_PENDING)
+        list->names[list->count++] = key;
+}
+
+//
+// Digest the entries of the names recorded since the last time.  Translation moves the
+// initializer of a static variable out of its entry, so the entries a declaration depends
+// on are digested as typecheck leaves them, and a name only the translation looks up as
+// the translation leaves it.  Digesting looks the names up again; that is no dependency.
+//
+static void settle_digests(void)
+{
+    semantic_lookup_hook = NULL;
+    size_t n             = 0;
+    map_iterate(&used, count_name, &n);
+    if (n == 0)
+        return;
+    NameList pending = { 0, xalloc(n * sizeof(char *), __func__, __FILE__, __LINE__) };
+    map_iterate(&used, add_pending, &pending);
+    for (size_t i = 0; i < pending.count; i++) {
+        const char *key = pending.names[i];
+        map_insert(&used, key, (intptr_t)entry_digest((LookupTable)(key[0] - '0'), key + 1), 0);
+    }
+    xfree(pending.names);
+}
+
+//
+// A recorded name, as a dependency of `r`.
+//
+static void add_dependency(const char *key, intptr_t value, const void *arg)
+{
+    Record *r = (Record *)arg;
+    if ((uint64_t)value == DIGEST_SKIP)
+        return;
+    Dependency *d = &r->deps[r->ndeps++];
+    d->table      = (LookupTable)(key[0] - '0');
+    d->name       = xstrdup(key + 1);
+    d->digest     = (uint64_t)value;
+}
+
+//
+// Read the index of the old database.  Anything amiss, and it is ignored.
+//
+static void load_index(void)
+{
+    size_t word = sizeof(size_t);
+    if (wgetw(&old_db) != db_options || wseek(&old_db, -2, SEEK_END) < 0)
+        return;
+    size_t index_offset = wgetfixed(&old_db);
+    size_t magic        = wgetfixed(&old_db);
+    if (magic != INCREMENTAL_MAGIC || werror(&old_db) || index_offset % word != 0 ||
+        wseek(&old_db, (long)(index_offset / word), SEEK_SET) < 0)
+        return;
+
+    size_t count = wgetw(&old_db);
+    for (size_t i = 0; i < count && !werror(&old_db) && !weof(&old_db); i++) {
+        Record *r = add_record(&old_records);
+        r->key    = wgetw(&old_db);
+        r->offset = wgetw(&old_db);
+        r->ndeps  = wgetw(&old_db);
+        if (werror(&old_db) || weof(&old_db))
+            break;
+        if (r->ndeps > 0)
+            r->deps = xalloc(r->ndeps * sizeof(Dependency), __func__, __FILE__, __LINE__);
+        for (size_t j = 0; j < r->ndeps; j++) {
+            r->deps[j].table  = (LookupTable)wgetw(&old_db);
+            r->deps[j].name   = wgetstr(&old_db);
+            r->deps[j].digest = wgetw(&old_db);
+        }
+    }
+    if (werror(&old_db) || weof(&old_db) || old_records.count != count) {
+        free_records(&old_records);
+        return;
+    }
+    for (size_t i = count; i-- > 0;) {
+        char hex[17];
+        intptr_t next;
+        key_name(hex, sizeof(hex), old_records.records[i].key);
+        old_records.records[i].same_key =
+            map_get(&old_by_key, hex, &next) ? (size_t)next : NO_RECORD;
+        map_insert(&old_by_key, hex, (intptr_t)i, 0);
+    }
+}
+
+static void write_failed(const char *path)
+{
+    fprintf(stderr, "Warning: cannot write %s: %s\n", path, strerror(errno));
+    if (new_open) {
+        wclose(&new_db);
+        new_open = false;
+    }
+    remove(new_path);
+}
+
+void incremental_open(const char *path, uint64_t options)
+{
+    db_path    = xstrdup(path);
+    db_options = options;
+    new_path   = xalloc(strlen(path) + 5, __func__, __FILE__, __LINE__);
+    strcpy(new_path, path);
+    strcat(new_path, ".tmp");
+    memset(&incremental_stats, 0, sizeof(incremental_stats));
+
+    if (wopen(&old_db, path, "r") == 0) {
+        old_open = true;
+        load_index();
+    }
+    if (wopen(&new_db, new_path, "w") < 0) {
+        write_failed(new_path);
+        return;
+    }
+    new_open = true;
+    wputw(options, &new_db);
+}
+
+void incremental_begin(void)
+{
+    map_destroy(&used);
+    hit                  = NULL;
+    semantic_lookup_hook = record_lookup;
+}
+
+bool incremental_find(uint64_t key)
+{
+    char hex[17];
+    intptr_t i;
+    settle_digests();
+    hit = NULL;
+    key_name(hex, sizeof(hex), key);
+    size_t n = map_get(&old_by_key, hex, &i) ? (size_t)i : NO_RECORD;
+    for (; n != NO_RECORD && !hit; n = old_records.records[n].same_key) {
+        const Record *r = &old_records.records[n];
+        bool changed    = false;
+        for (size_t j = 0; j < r->ndeps && !changed; j++)
+            changed = entry_digest(r->deps[j].table, r->deps[j].name) != r->deps[j].digest;
+        if (!changed)
+            hit = r;
+    }
+    semantic_lookup_hook = record_lookup;
+    return hit != NULL;
+}
+
+Tac_TopLevel *incremental_replay(int seq_in, int str_in, int *label_seq)
+{
+    if (wseek(&old_db, (long)(hit->offset / sizeof(size_t)), SEEK_SET) < 0) {
+        fprintf(stderr, "Error: cannot seek in %s\n", db_path);
+        exit(1);
+    }
+    return decl_record_read(&old_db, db_path, seq_in, str_in, label_seq);
+}
+
+void incremental_store(uint64_t key, const Tac_TopLevel *tac, int seq_in, int seq_out,
+                       int str_in, int str_out)
+{
+    settle_digests();
+    if (hit)
+        incremental_stats.reused++;
+    else
+        incremental_stats.translated++;
+    if (new_open) {
+        Record *r = add_record(&new_records);
+        r->key    = key;
+        r->offset = woffset(&new_db);
+        if (hit) {
+            r->ndeps = hit->ndeps;
+            if (r->ndeps > 0)
+                r->deps = xalloc(r->ndeps * sizeof(Dependency), __func__, __FILE__, __LINE__);
+            for (size_t j = 0; j < r->ndeps; j++) {
+                r->deps[j]      = hit->deps[j];
+                r->deps[j].name = xstrdup(hit->deps[j].name);
+            }
+        } else {
+            size_t n = 0;
+            map_iterate(&used, count_name, &n);
+            if (n > 0)
+                r->deps = xalloc(n * sizeof(Dependency), __func__, __FILE__, __LINE__);
+            map_iterate(&used, add_dependency, r);
+        }
+        decl_record_write(&new_db, tac, seq_in, seq_out, str_in, str_out);
+        if (werror(&new_db))
+            write_failed(new_path);
+    }
+    map_destroy(&used);
+    hit = NULL;
+}
+
+void incremental_close(void)
+{
+    semantic_lookup_hook = NULL;
+    if (new_open) {
+        size_t index_offset = woffset(&new_db);
+        wputw(new_records.count, &new_db);
+        for (size_t i = 0; i < new_records.count; i++) {
+            const Record *r = &new_records.records[i];
+            wputw(r->key, &new_db);
+            wputw(r->offset, &new_db);
+            wputw(r->ndeps, &new_db);
+            for (size_t j = 0; j < r->ndeps; j++) {
+                wputw(r->deps[j].table, &new_db);
+                wputstr(r->deps[j].name, &new_db);
+                wputw(r->deps[j].digest, &new_db);
+            }
+        }
+        wputfixed(index_offset, &new_db);
+        wputfixed(INCREMENTAL_MAGIC, &new_db);
+        bool failed = wflush(&new_db) != 0 || werror(&new_db);
+        wclose(&new_db);
+        new_open = false;
+        if (failed)
+            write_failed(new_path);
+        else if (rename(new_path, db_path) < 0)
+            write_failed(db_path);
+    }
+    if (old_open) {
+        wclose(&old_db);
+        old_open = false;
+    }
+    free_records(&old_records);
+    free_records(&new_records);
+    map_destroy(&old_by_key);
+    map_destroy(&used);
+    xfree(db_path);
+    xfree(new_path);
+    db_path  = NULL;
+    new_path = NULL;
+    hit      = NULL;
+}
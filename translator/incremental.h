@@ -0,0 +1,86 @@
+//
+// Incremental recompilation for lower (--incremental).
+//
+// The TAC of every external declaration of the last run is kept in a database beside the
+// output, together with what the declaration depended on: the entries of the symbol,
+// struct and typedef tables that typecheck and translate looked up while processing it,
+// each by name and a digest of its contents.  On the next run a declaration is still
+// typechecked, as that builds the tables for the declarations after it, but when its
+// digest, and the digest of every entry it depended on, are unchanged, translation and
+// optimization are skipped and its previous TAC is spliced in.
+//
+// The unit-wide counters that name temporaries and labels (`%N`, `%LN`) and string
+// literals (`_strN`) are not dependencies: a record keeps the counters at the start and
+// the end of its declaration, and the names in its ranges are renumbered as it is read
+// back, so that a function which grows does not invalidate every function after it.
+//
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "tac.h"
+#include "wio.h"
+
+//
+// Digest of a declaration, as the AST stream encodes it.
+//
+uint64_t decl_digest(ExternalDecl *ast);
+
+//
+// The TAC of one declaration, as the compilation cache and the database store it:
+//
+//      seq_in, seq_out, str_in, str_out, toplevel..., TAG_EOL
+//
+// decl_record_read() renumbers it from the counters at the start of the declaration in
+// this run, and advances *label_seq and the string counter past it.  `path` names the
+// file in error messages.
+//
+void decl_record_write(WFILE *out, const Tac_TopLevel *tac, int seq_in, int seq_out, int str_in,
+                       int str_out);
+Tac_TopLevel *decl_record_read(WFILE *in, const char *path, int seq_in, int str_in,
+                               int *label_seq);
+
+//
+// Declarations reused from the database and translated anew, for -v.
+//
+typedef struct {
+    unsigned long reused;
+    unsigned long translated;
+} IncrementalStats;
+
+extern IncrementalStats incremental_stats;
+
+//
+// Load the database at `path`, left by a run with the same `options` key; start afresh
+// when there is none, or it is from other options.  A new database is written beside it
+// and replaces it at incremental_close().
+//
+void incremental_open(const char *path, uint64_t options);
+void incremental_close(void);
+
+//
+// For each declaration in order: incremental_begin() before typecheck, to start recording
+// its lookups; incremental_find() after, to see whether the previous TAC of the
+// declaration may be reused, nothing it depended on having changed; if so,
+// incremental_replay() to splice it in; and incremental_store() with the TAC the
+// declaration ends up with, either way.  `key` covers the declaration itself (see
+// decl_digest()).
+//
+void incremental_begin(void);
+bool incremental_find(uint64_t key);
+Tac_TopLevel *incremental_replay(int seq_in, int str_in, int *label_seq);
+void incremental_store(uint64_t key, const Tac_TopLevel *tac, int seq_in, int seq_out,
+                       int str_in, int str_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCREMENTAL_H */
@@ -1,3 +1,4 @@
+#include <ctype.h>
 #include <fcntl.h>
 #include <getopt.h>
 #include <stdarg.h>
@@ -10,8 +11,13 @@
 #define STDOUT_FILENO 1
 #endif
 
+#include "cache.h"
+#include "incremental.h"
 #include "optimize.h"
+#include "phase.h"
 #include "semantic.h"
+#include "server.h"
+#include "snapshot.h"
 #include "structtab.h"
 #include "symtab.h"
 #include "target.h"
@@ -46,6 +52,17 @@ typedef struct {
     int no_copy_prop;        // --no-copy-prop
     int no_dead_store;       // --no-dead-store
     int opt_debug;           // --opt-debug
+    int compact;             // --compact
+    int time_report;         // --time-report
+    PhaseReportFormat report_format;
+    int stats;               // --stats
+    const char *cache_dir;   // --cache
+    int incremental;         // --incremental
+    int incremental_check;   // --incremental-check
+    const char *server;      // --server
+    const char *profile_use; // --profile-use
+    const char *prefix;      // --prefix-snapshot
+    const char *save_prefix; // --save-prefix-snapshot
 } Args;
 
 //
@@ -67,6 +84,24 @@ static void print_usage(const char *prog_name)
     fprintf(stderr, "    --no-copy-prop      Disable copy propagation\n");
     fprintf(stderr, "    --no-dead-store     Disable dead store elimination\n");
     fprintf(stderr, "    --opt-debug         Trace optimizer passes to stdout\n");
+    fprintf(stderr, "    --stats             Print optimizer counters per function to stderr\n");
+    fprintf(stderr, "    --compact           Use compact varint encoding for binary TAC\n");
+    fprintf(stderr, "    --cache DIR         Reuse and store translations in the cache DIR\n");
+    fprintf(stderr, "    --incremental       Translate only the declarations changed since the "
+                    "last run\n");
+    fprintf(stderr, "    --incremental-check Like --incremental, and verify every reused "
+                    "declaration\n");
+    fprintf(stderr, "    --time-report[=json]\n");
+    fprintf(stderr, "                        Print time and memory per phase to stderr\n");
+    fprintf(stderr, "    --server SOCKET     Serve compile requests on the Unix socket SOCKET\n");
+    fprintf(stderr, "    --profile-use FILE  Lay out code by tacrun --profile-out counts\n");
+    fprintf(stderr, "    --prefix-snapshot FILE\n");
+    fprintf(stderr, "                        Resume after the declarations saved in FILE, when "
+                    "the input\n");
+    fprintf(stderr, "                        begins with them\n");
+    fprintf(stderr, "    --save-prefix-snapshot FILE\n");
+    fprintf(stderr, "                        Save the lowered input as a prefix snapshot in "
+                    "FILE\n");
     fprintf(stderr, "    -t, --target NAME   Target architecture (default: besm6)\n");
     fprintf(stderr, "    -v, --verbose       Enable verbose mode\n");
     fprintf(stderr, "    -D, --debug         Print debug information\n");
@@ -80,17 +115,27 @@ static void print_usage(const char *prog_name)
 //
 static void init_args(Args *args)
 {
-    args->verbose        = 0;
-    args->help           = 0;
-    args->debug          = 0;
-    args->format         = FORMAT_TAC; // Default format
-    args->target_name    = "besm6";
-    args->input_file     = NULL;
-    args->output_file    = NULL;
-    args->no_unreachable = 0;
-    args->no_copy_prop   = 0;
-    args->no_dead_store  = 0;
-    args->opt_debug      = 0;
+    args->verbose           = 0;
+    args->help              = 0;
+    args->debug             = 0;
+    args->format            = FORMAT_TAC; // Default format
+    args->target_name       = "besm6";
+    args->input_file        = NULL;
+    args->output_file       = NULL;
+    args->no_unreachable    = 0;
+    args->no_copy_prop      = 0;
+    args->no_dead_store     = 0;
+    args->opt_debug         = 0;
+    args->compact           = 0;
+    args->time_report       = 0;
+    args->stats             = 0;
+    args->cache_dir         = NULL;
+    args->incremental       = 0;
+    args->incremental_check = 0;
+    args->server            = NULL;
+    args->profile_use       = NULL;
+    args->prefix            = NULL;
+    args->save_prefix       = NULL;
 }
 
 //
@@ -125,18 +170,28 @@ static char *generate_output_filename(const char *input_file, OutputFormat forma
 static int parse_args(int argc, char *argv[], Args *args)
 {
     static struct option long_options[] = {
-        { "verbose", no_argument, 0, 'v' },        //
-        { "help", no_argument, 0, 'h' },           //
-        { "debug", no_argument, 0, 'D' },          //
-        { "tac", no_argument, 0, 'T' },            //
-        { "yaml", no_argument, 0, 'y' },           //
-        { "dot", no_argument, 0, 'd' },            //
-        { "target", required_argument, 0, 't' },   //
-        { "no-unreachable", no_argument, 0, 256 }, //
-        { "no-copy-prop", no_argument, 0, 257 },   //
-        { "no-dead-store", no_argument, 0, 258 },  //
-        { "opt-debug", no_argument, 0, 259 },      //
-        {},                                        //
+        { "verbose", no_argument, 0, 'v' },                    //
+        { "help", no_argument, 0, 'h' },                       //
+        { "debug", no_argument, 0, 'D' },                      //
+        { "tac", no_argument, 0, 'T' },                        //
+        { "yaml", no_argument, 0, 'y' },                       //
+        { "dot", no_argument, 0, 'd' },                        //
+        { "target", required_argument, 0, 't' },               //
+        { "no-unreachable", no_argument, 0, 256 },             //
+        { "no-copy-prop", no_argument, 0, 257 },               //
+        { "no-dead-store", no_argument, 0, 258 },              //
+        { "opt-debug", no_argument, 0, 259 },                  //
+        { "compact", no_argument, 0, 260 },                    //
+        { "time-report", optional_argument, 0, 261 },          //
+        { "stats", no_argument, 0, 262 },                      //
+        { "cache", required_argument, 0, 263 },                //
+        { "incremental", no_argument, 0, 264 },                //
+        { "incremental-check", no_argument, 0, 265 },          //
+        { "server", required_argument, 0, 266 },               //
+        { "profile-use", required_argument, 0, 267 },          //
+        { "prefix-snapshot", required_argument, 0, 268 },      //
+        { "save-prefix-snapshot", required_argument, 0, 269 }, //
+        {},                                                    //
     };
 
     int opt;
@@ -183,10 +238,54 @@ static int parse_args(int argc, char *argv[], Args *args)
         case 259:
             args->opt_debug = 1;
             break;
+        case 260:
+            args->compact = 1;
+            break;
+        case 261:
+            if (!phase_parse_format(optarg, &args->report_format)) {
+                fprintf(stderr, "Error: Unknown --time-report format '%s'\n", optarg);
+                return -1;
+            }
+            args->time_report = 1;
+            break;
+        case 262:
+            args->stats = 1;
+            break;
+        case 263:
+            args->cache_dir = optarg;
+            break;
+        case 264:
+            args->incremental = 1;
+            break;
+        case 265:
+            args->incremental       = 1;
+            args->incremental_check = 1;
+            break;
+        case 266:
+            args->server = optarg;
+            break;
+        case 267:
+            args->profile_use = optarg;
+            break;
+        case 268:
+            args->prefix = optarg;
+            break;
+        case 269:
+            args->save_prefix = optarg;
+            break;
         case '?': // Unknown option
             return -1;
         }
     }
+    if (args->prefix && args->save_prefix) {
+        fprintf(stderr, "Error: --prefix-snapshot and --save-prefix-snapshot exclude each other\n");
+        return -1;
+    }
+
+    // A server takes its files from each request.
+    if (args->server) {
+        return 0;
+    }
 
     // Check for input filename (required)
     if (optind < argc) {
@@ -225,7 +324,10 @@ static void open_input_output(const Args *args)
             break;
         }
     }
-    input_fd = open(args->input_file, O_RDONLY);
+    input_fd = STDIN_FILENO;
+    if (strcmp(args->input_file, "-") != 0) {
+        input_fd = open(args->input_file, O_RDONLY);
+    }
     if (input_fd < 0) {
         perror(args->input_file);
         exit(1);
@@ -239,7 +341,9 @@ static void open_input_output(const Args *args)
 static void close_output(const Args *args)
 {
     (void)args;
-    close(input_fd);
+    if (input_fd != STDIN_FILENO) {
+        close(input_fd);
+    }
     if (output_file != stdout) {
         fclose(output_file);
     }
@@ -263,6 +367,146 @@ static void emit_tac_toplevel(const Args *args, WFILE *tac_out, const Tac_TopLev
     }
 }
 
+//
+// Lay the TAC of a declaration out by the profile, if any, write it and free it.  The
+// cache, the database and a prefix snapshot keep it as translated, so that one entry
+// serves every profile.
+//
+static void emit_decl_tac(const Args *args, WFILE *tac_out, Tac_TopLevel *tac,
+                          const OptProfile *profile, int *label_seq)
+{
+    if (profile) {
+        phase_begin("layout");
+        for (Tac_TopLevel *t = tac; t; t = t->next)
+            if (t->kind == TAC_TOPLEVEL_FUNCTION)
+                layout_function(t, profile, label_seq);
+        phase_end();
+    }
+    phase_begin("export");
+    for (const Tac_TopLevel *t = tac; t; t = t->next) {
+        if (args->debug) {
+            tac_print_toplevel(stdout, t, 0);
+        }
+        emit_tac_toplevel(args, tac_out, t);
+    }
+    tac_free_toplevel(tac);
+    if (tac_out) {
+        // Let the code generator start on this declaration while we read the next.
+        wflush(tac_out);
+    }
+    phase_end();
+}
+
+//
+// Compilation cache (--cache).  Two levels:
+//
+// - The whole output, keyed by the input file and the options: an unchanged file is
+//   copied from the cache without being read.
+//
+// - The TAC of each external declaration, for a file that changed.  The key covers what
+//   the translation depends on besides the unit-wide counters: the declaration itself
+//   and what typecheck derived from the context for it — the names of its static locals
+//   and the count of anonymous structs — and the declarations before it (of a function
+//   definition only the signature, as its body affects nothing that follows but the
+//   counters).
+//
+// Incremental recompilation (--incremental) keys its database by the declaration itself
+// only, and checks the table entries the declaration depended on instead of everything
+// before it.  Both store the TAC of a declaration as a record that is renumbered as it is
+// read back (see incremental.h).  Where both are on, the database is consulted first.
+//
+//
+// Key of the options every entry depends on.
+//
+static void key_options(CacheKey *key, const char *stage, const OptFlags *flags)
+{
+    cache_key_init(key, stage);
+    cache_key_add_str(key, target_config->name);
+    cache_key_add_word(key, flags->unreachable_elim | flags->copy_propagation << 1 |
+                                flags->dead_store_elim << 2);
+}
+
+//
+// What a declaration contributes to the context of the ones after it.
+//
+static uint64_t decl_signature(ExternalDecl *ast, uint64_t digest)
+{
+    if (ast->kind != EXTERNAL_DECL_FUNCTION)
+        return digest;
+    Stmt *body           = ast->u.function.body;
+    ast->u.function.body = NULL;
+    uint64_t signature   = decl_digest(ast);
+    ast->u.function.body = body;
+    return signature;
+}
+
+//
+// Read back the TAC of a declaration from its entry, renumbered from the counters at its
+// start.  Advance the counters past it.
+//
+static Tac_TopLevel *replay_decl(const char *path, int seq_in, int str_in, int *label_seq)
+{
+    WFILE in;
+    if (wopen(&in, path, "r") < 0) {
+        perror(path);
+        exit(1);
+    }
+    Tac_TopLevel *tac = decl_record_read(&in, path, seq_in, str_in, label_seq);
+    wclose(&in);
+    return tac;
+}
+
+static void store_decl(const char *dir, const CacheKey *key, const Tac_TopLevel *tac,
+                       int seq_in, int seq_out, int str_in, int str_out)
+{
+    CacheEntry entry;
+    if (!cache_begin(&entry, dir))
+        return;
+    WFILE out;
+    if (wdopen(&out, fileno(entry.file), "w") < 0) {
+        cache_abort(&entry);
+        return;
+    }
+    decl_record_write(&out, tac, seq_in, seq_out, str_in, str_out);
+    bool failed = wflush(&out) != 0 || werror(&out);
+    wclose(&out);
+    if (failed)
+        cache_abort(&entry);
+    else
+        cache_commit(&entry, dir, key);
+}
+
+//
+// Translation of a declaration for --incremental-check, made before its TAC is reused: a
+// reused declaration moves nothing out of the tables.
+//
+typedef struct {
+    Tac_TopLevel *tac;
+    int seq_out;
+    int str_out;
+} Fresh;
+
+//
+// --incremental-check: stop when the reused TAC of a declaration differs from its
+// translation, or ends elsewhere.
+//
+static void check_reused(const ExternalDecl *ast, const Tac_TopLevel *reused, Fresh *fresh,
+                         int seq_out)
+{
+    const Tac_TopLevel *a = reused, *b = fresh->tac;
+    while (a && b && tac_compare_toplevel(a, b)) {
+        a = a->next;
+        b = b->next;
+    }
+    if (a || b || fresh->seq_out != seq_out || fresh->str_out != symtab_string_seq()) {
+        fprintf(stderr, "Error: reused TAC of %s differs from its translation\n",
+                ast->kind == EXTERNAL_DECL_FUNCTION ? ast->u.function.name : "a declaration");
+        exit(1);
+    }
+    tac_free_toplevel(fresh->tac);
+    fresh->tac = NULL;
+}
+
 //
 // Main processing function
 //
@@ -281,6 +525,27 @@ void process_file(const Args *args)
     flags.dead_store_elim  = !args->no_dead_store;
     flags.debug            = args->opt_debug;
 
+    // The optimizer trace would be missing for whatever comes from the cache.
+    const char *cache_dir = args->opt_debug ? NULL : args->cache_dir;
+    CacheKey file_key;
+    bool cache_file = false;
+    // A snapshot is saved from a run that lowers the input.
+    if (cache_dir && !args->save_prefix && strcmp(args->input_file, "-") != 0 &&
+        args->output_file[0] != '-') {
+        phase_begin("cache");
+        key_options(&file_key, "lower", &flags);
+        cache_key_add_word(&file_key, args->format | args->compact << 2);
+        cache_file = cache_key_add_file(&file_key, args->input_file) &&
+                     (!args->profile_use || cache_key_add_file(&file_key, args->profile_use));
+        bool hit = cache_file && cache_fetch_file(cache_dir, &file_key, args->output_file);
+        phase_end();
+        if (hit) {
+            if (args->verbose)
+                printf("Copied %s from the cache\n", args->output_file);
+            return;
+        }
+    }
+
     if (args->verbose) {
         printf("Processing %s in verbose mode\n", args->input_file);
     }
@@ -306,6 +571,7 @@ void process_file(const Args *args)
             fprintf(stderr, "Cannot reopen output file\n");
             exit(1);
         }
+        tac_export_begin_stream(&tac_out, args->compact, true);
         tac_out_ready = 1;
     }
 
@@ -315,8 +581,66 @@ void process_file(const Args *args)
     // unique within the translation unit (required by the single-file backends —
     // see translate.h).  Reset to 0 once, here, at the start of the unit.
     int label_seq = 0;
+    if (args->stats)
+        opt_stats_print_header(stderr);
+    OptProfile *profile = args->profile_use ? opt_profile_read(args->profile_use) : NULL;
+
+    // Running key of the declarations translated so far, for the per-declaration entries.
+    CacheKey context;
+    if (cache_dir)
+        key_options(&context, "lower-decl", &flags);
+    bool incremental = args->incremental && !args->opt_debug;
+    if (incremental && args->output_file[0] == '-') {
+        fprintf(stderr, "Error: --incremental needs an output file\n");
+        exit(1);
+    }
+    if (incremental) {
+        CacheKey options;
+        key_options(&options, "lower-incremental", &flags);
+        char *db = xalloc(strlen(args->output_file) + 5, __func__, __FILE__, __LINE__);
+        strcpy(db, args->output_file);
+        strcat(db, ".inc");
+        incremental_open(db, options.hash);
+        xfree(db);
+    }
+
+    // The declarations of a prefix snapshot the input begins with are restored instead of
+    // translated.  Those read to compare the input with it are translated first otherwise.
+    ExternalDecl *ahead = NULL;
+    bool ended          = false;
+    if (args->prefix || args->save_prefix) {
+        CacheKey options;
+        key_options(&options, "lower-prefix", &flags);
+        if (args->save_prefix) {
+            snapshot_save_begin(args->save_prefix, options.hash);
+        } else {
+            Tac_TopLevel *tac = NULL;
+            phase_begin("prefix");
+            bool resumed = snapshot_load(args->prefix, options.hash, &input, &tac, &label_seq,
+                                         cache_dir ? &context : NULL, &ahead, &ended);
+            phase_end();
+            if (args->verbose) {
+                printf("%s prefix snapshot %s\n", resumed ? "Resuming after" : "Not using",
+                       args->prefix);
+            }
+            emit_decl_tac(args, tac_out_ready ? &tac_out : NULL, tac, profile, &label_seq);
+        }
+    }
     for (;;) {
-        ExternalDecl *ast = import_external_decl(&input);
+        phase_begin("import");
+        ExternalDecl *ast = NULL;
+        uint64_t bytes    = 0;
+        if (ahead)
+            ast = ahead;
+        else if (args->save_prefix)
+            ast = snapshot_import_decl(&input, &bytes);
+        else if (!ended)
+            ast = import_external_decl(&input);
+        if (ahead) {
+            ahead     = ast->next;
+            ast->next = NULL;
+        }
+        phase_end();
         if (!ast)
             break;
 
@@ -324,34 +648,148 @@ void process_file(const Args *args)
             print_external_decl(stdout, ast, 0);
         }
 
+        // The counters and the static locals before typecheck, which draws on them too.
+        int seq_in                   = label_seq;
+        int str_in                   = symtab_string_seq();
+        const StaticLocalRec *locals = static_locals_head();
+
+        uint64_t digest = 0, signature = 0;
+        if (cache_dir || incremental || args->save_prefix) {
+            phase_begin("cache");
+            digest    = decl_digest(ast);
+            signature = decl_signature(ast, digest);
+            phase_end();
+        }
+        if (incremental)
+            incremental_begin();
+
         // Typecheck definitions and uses of functions and variables.
         // Annotate loops and break/continue statements — loop labels share the
         // unit-wide counter with the translator's temporaries.
+        phase_begin("typecheck");
         typecheck_decl(ast, &label_seq);
+        phase_end();
+
+        // The declaration itself, for both the cache and the database.
+        CacheKey decl_key = { 0 };
+        bool reusable     = false;
+        if (cache_dir || incremental) {
+            phase_begin("cache");
+            cache_key_init(&decl_key, "lower-decl");
+            cache_key_add_word(&decl_key, digest);
+            cache_key_add_word(&decl_key, typecheck_anon_seq());
+            for (const StaticLocalRec *r = static_locals_head(); r != locals; r = r->next)
+                cache_key_add_str(&decl_key, r->name);
+            if (incremental)
+                reusable = incremental_find(decl_key.hash);
+            phase_end();
+        }
 
         // Convert the AST to TAC and optimize. Each function carries its own
         // params + locals, so the optimizer needs no whole-program context.
-        Tac_TopLevel *tac = translate(ast, flags, &label_seq);
-        free_external_decl(ast);
-        if (tac) {
-            for (const Tac_TopLevel *t = tac; t; t = t->next) {
-                if (args->debug) {
-                    tac_print_toplevel(stdout, t, 0);
-                }
-                emit_tac_toplevel(args, tac_out_ready ? &tac_out : NULL, t);
+        OptStats before = opt_stats;
+        Fresh fresh     = { 0 };
+        if (args->incremental_check && incremental) {
+            int seq_typed = label_seq;
+            int str_typed = symtab_string_seq();
+            phase_begin("translate");
+            fresh.tac = translate(ast, flags, &label_seq);
+            phase_end();
+            fresh.seq_out = label_seq;
+            fresh.str_out = symtab_string_seq();
+            label_seq     = seq_typed;
+            symtab_set_string_seq(str_typed);
+        }
+
+        CacheKey key      = { 0 };
+        Tac_TopLevel *tac = NULL;
+        bool cached       = false;
+        if (reusable) {
+            phase_begin("cache");
+            tac    = incremental_replay(seq_in, str_in, &label_seq);
+            cached = true;
+            phase_end();
+        }
+        if (cache_dir) {
+            phase_begin("cache");
+            key = context;
+            cache_key_add_word(&key, decl_key.hash);
+            char *entry = cached ? NULL : cache_lookup(cache_dir, &key);
+            if (entry) {
+                tac    = replay_decl(entry, seq_in, str_in, &label_seq);
+                cached = true;
+                xfree(entry);
             }
-            tac_free_toplevel(tac);
+            cache_key_add_word(&context, signature);
+            phase_end();
+        }
+
+        if (cached && fresh.tac) {
+            check_reused(ast, tac, &fresh, label_seq);
+        } else if (fresh.tac) {
+            tac       = fresh.tac;
+            label_seq = fresh.seq_out;
+            symtab_set_string_seq(fresh.str_out);
+        } else if (!cached) {
+            phase_begin("translate");
+            tac = translate(ast, flags, &label_seq);
+            phase_end();
+        }
+        if (!cached && cache_dir) {
+            phase_begin("cache");
+            store_decl(cache_dir, &key, tac, seq_in, label_seq, str_in, symtab_string_seq());
+            phase_end();
+        }
+        if (incremental) {
+            phase_begin("cache");
+            incremental_store(decl_key.hash, tac, seq_in, label_seq, str_in,
+                              symtab_string_seq());
+            phase_end();
         }
+        if (args->save_prefix) {
+            phase_begin("prefix");
+            snapshot_save_decl(bytes, signature, tac);
+            phase_end();
+        }
+        free_external_decl(ast);
+
+        if (args->stats && opt_stats.functions != before.functions) {
+            const Tac_TopLevel *fn = tac;
+            while (fn->kind != TAC_TOPLEVEL_FUNCTION)
+                fn = fn->next;
+            opt_stats_print(stderr, fn->u.function.name, &before);
+        }
+        emit_decl_tac(args, tac_out_ready ? &tac_out : NULL, tac, profile, &label_seq);
     }
     wclose(&input);
+    if (args->save_prefix)
+        snapshot_save_end(label_seq);
     if (tac_out_ready) {
         tac_export_end_stream(&tac_out);
         wclose(&tac_out);
     }
     close_output(args);
+    if (profile)
+        opt_profile_free(profile);
+    if (args->stats)
+        opt_stats_print(stderr, "total", NULL);
+    if (incremental) {
+        incremental_close();
+        if (args->verbose)
+            printf("Incremental: %lu reused, %lu translated\n", incremental_stats.reused,
+                   incremental_stats.translated);
+    }
+    if (cache_dir) {
+        if (cache_file)
+            cache_store_file(cache_dir, &file_key, args->output_file);
+        if (args->verbose)
+            printf("Cache: %lu hits, %lu misses, %lu stored\n", cache_stats.hits,
+                   cache_stats.misses, cache_stats.stores);
+    }
 
     symtab_destroy();
     structtab_destroy();
+    tac_intern_destroy();
     if (args->debug) {
         xreport_lost_memory();
     }
@@ -389,8 +827,21 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    if (args.server) {
+        // Run the requests of compile clients until stopped; see server.h.
+        return server_run(args.server, main);
+    }
+
+    if (args.time_report) {
+        phase_enable();
+    }
+
     // Pass args to backend for processing
     process_file(&args);
 
+    if (args.time_report) {
+        phase_report(stderr, "lower", args.report_format);
+    }
+
     return 0;
 }
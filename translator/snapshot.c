@@ -0,0 +1,204 @@
+//
+// Prefix snapshots for lower.  See snapshot.h.
+//
+// A snapshot is written in word format:
+//
+//      options
+//      toplevel..., TAG_EOL                -- the TAC of the prefix, as translated
+//      count, count x { digest, signature }
+//      label counter, tables               -- see semantic/snapshot.c
+//      index offset, SNAPSHOT_MAGIC        -- two raw words, at the very end
+//
+// The index offset is in bytes from the start of the file, and points at `count`.  The
+// TAC is written as each declaration is translated, the rest once the input has ended.
+//
+#include "snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "semantic.h"
+#include "xalloc.h"
+
+#define SNAPSHOT_MAGIC 0x736e6170 // 'snap' - trailer of a snapshot
+
+typedef struct {
+    uint64_t digest;
+    uint64_t signature;
+} PrefixDecl;
+
+static char *save_path;
+static char *tmp_path; // the snapshot being written, renamed into place at the end
+static WFILE save_file;
+static bool save_open;
+static PrefixDecl *saved;
+static size_t saved_count, saved_cap;
+
+static void save_failed(void)
+{
+    perror(tmp_path);
+    if (save_open)
+        wclose(&save_file);
+    unlink(tmp_path);
+    exit(1);
+}
+
+ExternalDecl *snapshot_import_decl(WFILE *input, uint64_t *digest)
+{
+    wdigest_begin(input);
+    ExternalDecl *decl = import_external_decl(input);
+    *digest            = wdigest_end(input);
+    return decl;
+}
+
+void snapshot_save_begin(const char *path, uint64_t options)
+{
+    save_path = xstrdup(path);
+    tmp_path  = xalloc(strlen(path) + 5, __func__, __FILE__, __LINE__);
+    strcpy(tmp_path, path);
+    strcat(tmp_path, ".tmp");
+    if (wopen(&save_file, tmp_path, "w") < 0)
+        save_failed();
+    save_open = true;
+    wputw(options, &save_file);
+}
+
+void snapshot_save_decl(uint64_t digest, uint64_t signature, const Tac_TopLevel *tac)
+{
+    if (saved_count == saved_cap) {
+        size_t cap         = saved_cap ? saved_cap * 2 : 256;
+        PrefixDecl *bigger = xalloc(cap * sizeof(PrefixDecl), __func__, __FILE__, __LINE__);
+        if (saved_count > 0)
+            memcpy(bigger, saved, saved_count * sizeof(PrefixDecl));
+        xfree(saved);
+        saved     = bigger;
+        saved_cap = cap;
+    }
+    saved[saved_count].digest    = digest;
+    saved[saved_count].signature = signature;
+    saved_count++;
+    for (const Tac_TopLevel *t = tac; t; t = t->next)
+        tac_export_toplevel(&save_file, t);
+}
+
+void snapshot_save_end(int label_seq)
+{
+    tac_export_toplevel(&save_file, NULL);
+    size_t index_offset = woffset(&save_file);
+    wputw(saved_count, &save_file);
+    for (size_t i = 0; i < saved_count; i++) {
+        wputw(saved[i].digest, &save_file);
+        wputw(saved[i].signature, &save_file);
+    }
+    wputw(label_seq, &save_file);
+    semantic_save_tables(&save_file);
+    wputfixed(index_offset, &save_file);
+    wputfixed(SNAPSHOT_MAGIC, &save_file);
+    if (wflush(&save_file) != 0 || werror(&save_file))
+        save_failed();
+    wclose(&save_file);
+    save_open = false;
+    if (rename(tmp_path, save_path) < 0) {
+        perror(save_path);
+        unlink(tmp_path);
+        exit(1);
+    }
+    xfree(saved);
+    xfree(save_path);
+    xfree(tmp_path);
+    saved       = NULL;
+    saved_count = 0;
+    saved_cap   = 0;
+    save_path   = NULL;
+    tmp_path    = NULL;
+}
+
+//
+// Read the declarations of the snapshot from its index, or return NULL when it is from
+// other options or not a snapshot.  Leave `in` at the label counter.
+//
+static PrefixDecl *read_index(WFILE *in, uint64_t options, size_t *count)
+{
+    size_t word = sizeof(size_t);
+    if (wgetw(in) != options || wseek(in, -2, SEEK_END) < 0)
+        return NULL;
+    size_t index_offset = wgetfixed(in);
+    size_t magic        = wgetfixed(in);
+    if (magic != SNAPSHOT_MAGIC || werror(in) || index_offset % word != 0 ||
+        wseek(in, (long)(index_offset / word), SEEK_SET) < 0)
+        return NULL;
+
+    *count = wgetw(in);
+    if (werror(in) || weof(in))
+        return NULL;
+    PrefixDecl *decls = xalloc((*count + 1) * sizeof(PrefixDecl), __func__, __FILE__, __LINE__);
+    for (size_t i = 0; i < *count; i++) {
+        decls[i].digest    = wgetw(in);
+        decls[i].signature = wgetw(in);
+    }
+    if (werror(in) || weof(in)) {
+        xfree(decls);
+        return NULL;
+    }
+    return decls;
+}
+
+bool snapshot_load(const char *path, uint64_t options, WFILE *input, Tac_TopLevel **tac,
+                   int *label_seq, CacheKey *context, ExternalDecl **ahead, bool *ended)
+{
+    *tac   = NULL;
+    *ahead = NULL;
+    *ended = false;
+    WFILE in;
+    if (wopen(&in, path, "r") < 0)
+        return false;
+    size_t count;
+    PrefixDecl *decls = read_index(&in, options, &count);
+    if (!decls) {
+        wclose(&in);
+        return false;
+    }
+
+    // Compare the input with the prefix, keeping what was read.
+    ExternalDecl **tail = ahead;
+    size_t matched      = 0;
+    while (matched < count) {
+        uint64_t digest;
+        ExternalDecl *decl = snapshot_import_decl(input, &digest);
+        if (!decl) {
+            *ended = true;
+            break;
+        }
+        *tail = decl;
+        tail  = &decl->next;
+        if (digest != decls[matched].digest)
+            break;
+        matched++;
+    }
+    if (matched < count) {
+        xfree(decls);
+        wclose(&in);
+        return false;
+    }
+
+    *label_seq = (int)wgetw(&in);
+    if (!semantic_load_tables(&in) || wseek(&in, 1, SEEK_SET) < 0) {
+        fprintf(stderr, "Error: %s: corrupt prefix snapshot\n", path);
+        exit(1);
+    }
+    Tac_TopLevel **tac_tail = tac;
+    while ((*tac_tail = tac_import_toplevel(&in)) != NULL)
+        while (*tac_tail)
+            tac_tail = &(*tac_tail)->next;
+    wclose(&in);
+
+    if (context)
+        for (size_t i = 0; i < count; i++)
+            cache_key_add_word(context, decls[i].signature);
+    xfree(decls);
+    free_external_decl(*ahead);
+    *ahead = NULL;
+    return true;
+}
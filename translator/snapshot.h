@@ -0,0 +1,64 @@
+//
+// Prefix snapshots for lower (--prefix-snapshot, --save-prefix-snapshot).
+//
+// Inputs preprocessed against the same headers begin with the same external declarations,
+// and lower typechecks each of them again for every input.  A snapshot keeps what lower
+// makes of such a prefix: the TAC of its declarations as translated, the unit-wide label
+// counter, and the symbol, struct and typedef tables with their counters as typecheck and
+// translate leave them (see semantic/snapshot.c).  A later run whose input begins with the
+// same declarations restores all of that instead, and goes on from the first declaration
+// after them; its output is the same as without the snapshot.
+//
+// Declarations are compared by a digest of their bytes in the AST stream, taken as they are
+// imported, so that comparing costs no more than reading.  `parse` writes the same bytes
+// whether it read a declaration from the headers or from its own prefix snapshot; a stream
+// in the other encoding only fails to match.
+//
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "cache.h"
+#include "tac.h"
+#include "wio.h"
+
+//
+// Import the next declaration from `input` as import_external_decl() does, and set *digest
+// to the digest of its bytes.
+//
+ExternalDecl *snapshot_import_decl(WFILE *input, uint64_t *digest);
+
+//
+// Saving, over a whole run: snapshot_save_begin() before the first declaration, with the
+// key of the options the output depends on; snapshot_save_decl() with each declaration's
+// digest from snapshot_import_decl(), its signature for the compilation cache, and its TAC
+// before any layout; and snapshot_save_end() once the input has ended, with the label
+// counter.
+//
+void snapshot_save_begin(const char *path, uint64_t options);
+void snapshot_save_decl(uint64_t digest, uint64_t signature, const Tac_TopLevel *tac);
+void snapshot_save_end(int label_seq);
+
+//
+// Read declarations from `input` as long as they are those of the snapshot at `path`, saved
+// with the same `options`.  When the input begins with all of them, restore the tables and
+// the counters, set *label_seq past them, add their signatures to `context` unless it is
+// NULL, and return true with their TAC in *tac.  Otherwise return false: the declarations
+// read are left in *ahead, to be translated first, and *ended is set when the input ended
+// after them.
+//
+bool snapshot_load(const char *path, uint64_t options, WFILE *input, Tac_TopLevel **tac,
+                   int *label_seq, CacheKey *context, ExternalDecl **ahead, bool *ended);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SNAPSHOT_H */
@@ -247,11 +247,18 @@ void gen_stmt(TacCtx *ctx, Stmt *stmt)
         break;
     case STMT_RETURN: {
         if (ctx->sret_name && stmt->u.expr) {
-            // Multi-word struct return: copy the result, word by word, into the caller's
-            // slot through the hidden return pointer, then return the pointer itself.
+            // Multi-word struct return: copy the result, word by word or by a BLOCK_COPY,
+            // into the caller's slot through the hidden return pointer, then return the
+            // pointer itself.
             Tac_Val *src = gen_expr(ctx, stmt->u.expr); // VAR naming the source aggregate
             int w        = target_word_bytes();
-            int nwords   = ((int)get_size(stmt->u.expr->type) + w - 1) / w;
+            int nbytes   = (int)get_size(stmt->u.expr->type);
+            int nwords   = (nbytes + w - 1) / w;
+            if (aggregate_copy_is_block(nbytes)) {
+                gen_block_copy(ctx, gen_aggregate_address(ctx, src->u.var_name, 0),
+                               val_var(ctx->sret_name), nbytes);
+                nwords = 0; // nothing left to unroll
+            }
             for (int i = 0; i < nwords; i++) {
                 Tac_Val *t          = new_var_val(ctx);
                 Tac_Instruction *ld = tac_new_instruction(TAC_INSTRUCTION_COPY_FROM_OFFSET);
@@ -291,7 +298,7 @@ void gen_stmt(TacCtx *ctx, Stmt *stmt)
 
         Tac_Instruction *jz          = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_ZERO);
         jz->u.jump_if_zero.condition = cond;
-        jz->u.jump_if_zero.target    = else_l; // instruction takes ownership
+        jz->u.jump_if_zero.target    = tac_intern(else_l);
         tac_append(ctx, jz);
         gen_stmt(ctx, stmt->u.if_stmt.then_stmt);
         emit_jump(ctx, end_l);
@@ -300,7 +307,8 @@ void gen_stmt(TacCtx *ctx, Stmt *stmt)
             gen_stmt(ctx, stmt->u.if_stmt.else_stmt);
         }
         emit_label(ctx, end_l);
-        xfree(end_l); // emit_jump and emit_label each xstrdup; free the original
+        xfree(end_l); // emit_jump and emit_label each intern a copy; free the original
+        xfree(else_l);
         break;
     }
     case STMT_WHILE: {
@@ -313,7 +321,7 @@ void gen_stmt(TacCtx *ctx, Stmt *stmt)
         Tac_Val *cond                = gen_cond_val(ctx, stmt->u.while_stmt.condition);
         Tac_Instruction *jz          = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_ZERO);
         jz->u.jump_if_zero.condition = cond;
-        jz->u.jump_if_zero.target    = xstrdup(bl);
+        jz->u.jump_if_zero.target    = tac_intern(bl);
         tac_append(ctx, jz);
         gen_stmt(ctx, stmt->u.while_stmt.body);
         emit_jump(ctx, cl);
@@ -333,8 +341,9 @@ void gen_stmt(TacCtx *ctx, Stmt *stmt)
         Tac_Val *cond                     = gen_cond_val(ctx, stmt->u.do_while.condition);
         Tac_Instruction *jnz              = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_NOT_ZERO);
         jnz->u.jump_if_not_zero.condition = cond;
-        jnz->u.jump_if_not_zero.target    = loop_top;
+        jnz->u.jump_if_not_zero.target    = tac_intern(loop_top);
         tac_append(ctx, jnz);
+        xfree(loop_top);
         emit_label(ctx, bl);
         break;
     }
@@ -359,7 +368,7 @@ void gen_stmt(TacCtx *ctx, Stmt *stmt)
             Tac_Val *cond                = gen_cond_val(ctx, stmt->u.for_stmt.condition);
             Tac_Instruction *jz          = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_ZERO);
             jz->u.jump_if_zero.condition = cond;
-            jz->u.jump_if_zero.target    = xstrdup(bl);
+            jz->u.jump_if_zero.target    = tac_intern(bl);
             tac_append(ctx, jz);
         }
         gen_stmt(ctx, stmt->u.for_stmt.body);
@@ -368,7 +377,7 @@ void gen_stmt(TacCtx *ctx, Stmt *stmt)
             tac_free_val(gen_expr(ctx, stmt->u.for_stmt.update));
         }
         emit_jump(ctx, test_lab);
-        xfree(test_lab); // emit_label and emit_jump each xstrdup; free the original
+        xfree(test_lab); // emit_label and emit_jump each intern a copy; free the original
         emit_label(ctx, bl);
         break;
     }
@@ -400,7 +409,7 @@ void gen_stmt(TacCtx *ctx, Stmt *stmt)
             tac_append(ctx, bin);
             Tac_Instruction *jnz = tac_new_instruction(TAC_INSTRUCTION_JUMP_IF_NOT_ZERO);
             jnz->u.jump_if_not_zero.condition = val_var(cmp_name);
-            jnz->u.jump_if_not_zero.target    = xstrdup(e->label);
+            jnz->u.jump_if_not_zero.target    = tac_intern(e->label);
             tac_append(ctx, jnz);
         }
 
@@ -0,0 +1,153 @@
+//
+// Tests for incremental recompilation: a second run over an edited unit splices in the
+// TAC of every declaration whose dependencies are unchanged, and the result is the same
+// as a translation from scratch.
+//
+#include <unistd.h>
+
+#include "incremental.h"
+#include "translate_test.h"
+
+class IncrementalTest : public TranslateTest {
+protected:
+    char db[32];
+
+    void SetUp() override
+    {
+        TranslateTest::SetUp();
+        strncpy(db, "/tmp/incremental_XXXXXX", sizeof(db));
+        int fd = mkstemp(db);
+        close(fd);
+        unlink(db);
+    }
+
+    void TearDown() override
+    {
+        unlink(db);
+        TranslateTest::TearDown();
+    }
+
+    // Translate a unit as lower does, with the database when `incremental` is set, and
+    // return the YAML of all its TAC.
+    std::string Lower(const char *src, bool incremental)
+    {
+        std::string source = preprocess_source(src);
+        FILE *input        = tmpfile();
+        fwrite(source.data(), 1, source.size(), input);
+        rewind(input);
+        Program *unit = parse(input);
+        fclose(input);
+        EXPECT_NE(nullptr, unit);
+
+        if (incremental)
+            incremental_open(db, 1);
+        FILE *out     = tmpfile();
+        int label_seq = 0;
+        for (ExternalDecl *decl = unit->decls; decl; decl = decl->next) {
+            int seq_in      = label_seq;
+            int str_in      = symtab_string_seq();
+            uint64_t digest = decl_digest(decl);
+            if (incremental)
+                incremental_begin();
+            typecheck_decl(decl, &label_seq);
+
+            Tac_TopLevel *tac = nullptr;
+            uint64_t key      = digest * 31 + typecheck_anon_seq();
+            if (incremental && incremental_find(key))
+                tac = incremental_replay(seq_in, str_in, &label_seq);
+            else
+                tac = translate(decl, OptFlags{}, &label_seq);
+            if (incremental)
+                incremental_store(key, tac, seq_in, label_seq, str_in, symtab_string_seq());
+
+            for (const Tac_TopLevel *t = tac; t; t = t->next)
+                tac_export_yaml(out, t);
+            tac_free_toplevel(tac);
+        }
+        if (incremental)
+            incremental_close();
+        free_program(unit);
+
+        long len = ftell(out);
+        rewind(out);
+        std::string yaml(static_cast<size_t>(len), '\0');
+        EXPECT_EQ(fread(&yaml[0], 1, yaml.size(), out), yaml.size());
+        fclose(out);
+
+        symtab_destroy();
+        structtab_destroy();
+        typetab_destroy();
+        nametab_destroy();
+        tac_intern_destroy();
+        return yaml;
+    }
+
+    // Lower `src` incrementally after `before`, and check it against a fresh translation.
+    void ExpectSameAfter(const char *before, const char *src)
+    {
+        Lower(before, true);
+        std::string incremental = Lower(src, true);
+        std::string fresh       = Lower(src, false);
+        EXPECT_EQ(incremental, fresh);
+    }
+};
+
+static const char *const base_unit = R"(
+struct point { int x; int y; };
+int counter;
+int area(struct point *p) { return p->x * p->y; }
+int bump(void) { counter++; return counter; }
+int loop(int n) { int s = 0; for (int i = 0; i < n; i++) s += i; return s; }
+const char *name(void) { return "name"; }
+)";
+
+TEST_F(IncrementalTest, UnchangedUnitIsReused)
+{
+    std::string fresh = Lower(base_unit, false);
+    EXPECT_EQ(Lower(base_unit, true), fresh);
+    EXPECT_EQ(incremental_stats.translated, 6u);
+
+    EXPECT_EQ(Lower(base_unit, true), fresh);
+    EXPECT_EQ(incremental_stats.reused, 6u);
+    EXPECT_EQ(incremental_stats.translated, 0u);
+}
+
+TEST_F(IncrementalTest, EditedBodyRenumbersLaterFunctions)
+{
+    // area() gets more temporaries: the temporaries and labels of loop(), and the
+    // string of name(), are renumbered.
+    std::string edited = base_unit;
+    edited.replace(edited.find("return p->x * p->y;"), 19,
+                   "int a = p->x + 1; int b = a * p->y; return b - 1;");
+    ExpectSameAfter(base_unit, edited.c_str());
+    EXPECT_EQ(incremental_stats.reused, 5u);
+    EXPECT_EQ(incremental_stats.translated, 1u);
+}
+
+TEST_F(IncrementalTest, ChangedStructRetranslatesUsers)
+{
+    std::string edited = base_unit;
+    edited.replace(edited.find("int x; int y;"), 13, "int z; int x; int y;");
+    ExpectSameAfter(base_unit, edited.c_str());
+
+    // The struct and area().
+    EXPECT_EQ(incremental_stats.translated, 2u);
+}
+
+TEST_F(IncrementalTest, ChangedGlobalRetranslatesUsers)
+{
+    std::string edited = base_unit;
+    edited.replace(edited.find("int counter;"), 12, "long counter;");
+    ExpectSameAfter(base_unit, edited.c_str());
+
+    // The variable and bump().
+    EXPECT_EQ(incremental_stats.translated, 2u);
+}
+
+TEST_F(IncrementalTest, RedeclaredVariableIsEmittedOnce)
+{
+    const char *before = "int x; int x = 5; int x; int get(void) { return x; }";
+    ExpectSameAfter(before, before);
+    EXPECT_EQ(incremental_stats.translated, 0u);
+    ExpectSameAfter(before, "int x; int x = 6; int x; int get(void) { return x; }");
+}
@@ -0,0 +1,157 @@
+//
+// Tests for prefix snapshots: a unit lowered after the snapshot of a prefix it begins with
+// gives the same TAC as when it is lowered whole.
+//
+#include <unistd.h>
+
+#include "snapshot.h"
+#include "translate_test.h"
+#include "wio.h"
+
+class SnapshotTest : public TranslateTest {
+protected:
+    char path[32];
+    bool resumed = false;
+
+    enum Mode { WHOLE, SAVE, RESUME };
+
+    void SetUp() override
+    {
+        TranslateTest::SetUp();
+        strncpy(path, "/tmp/snapshot_XXXXXX", sizeof(path));
+        int fd = mkstemp(path);
+        close(fd);
+        unlink(path);
+    }
+
+    void TearDown() override
+    {
+        unlink(path);
+        TranslateTest::TearDown();
+    }
+
+    static void AppendYaml(FILE *out, Tac_TopLevel *tac)
+    {
+        for (const Tac_TopLevel *t = tac; t; t = t->next)
+            tac_export_yaml(out, t);
+        tac_free_toplevel(tac);
+    }
+
+    // Lower a unit as lower does, from its AST stream, and return the YAML of all its TAC.
+    std::string Lower(const char *src, Mode mode)
+    {
+        std::string source = preprocess_source(src);
+        FILE *input        = tmpfile();
+        fwrite(source.data(), 1, source.size(), input);
+        rewind(input);
+        Program *unit = parse(input);
+        fclose(input);
+        EXPECT_NE(nullptr, unit);
+
+        FILE *ast = tmpfile();
+        WFILE stream;
+        ast_export_open(&stream, fileno(ast), false);
+        for (ExternalDecl *decl = unit->decls; decl; decl = decl->next)
+            export_external_decl(&stream, decl);
+        ast_export_close(&stream);
+        free_program(unit);
+        nametab_destroy();
+        lseek(fileno(ast), 0, SEEK_SET);
+        ast_import_open(&stream, fileno(ast));
+
+        FILE *out           = tmpfile();
+        int label_seq       = 0;
+        ExternalDecl *ahead = nullptr;
+        bool ended          = false;
+        resumed             = false;
+        if (mode == RESUME) {
+            Tac_TopLevel *tac = nullptr;
+            resumed = snapshot_load(path, 1, &stream, &tac, &label_seq, nullptr, &ahead, &ended);
+            AppendYaml(out, tac);
+        }
+        if (mode == SAVE)
+            snapshot_save_begin(path, 1);
+        for (;;) {
+            uint64_t digest    = 0;
+            ExternalDecl *decl = ahead   ? ahead
+                                 : ended ? nullptr
+                                         : snapshot_import_decl(&stream, &digest);
+            if (!decl)
+                break;
+            ahead      = decl->next;
+            decl->next = nullptr;
+
+            typecheck_decl(decl, &label_seq);
+            Tac_TopLevel *tac = translate(decl, OptFlags{}, &label_seq);
+            if (mode == SAVE)
+                snapshot_save_decl(digest, 0, tac);
+            free_external_decl(decl);
+            AppendYaml(out, tac);
+        }
+        if (mode == SAVE)
+            snapshot_save_end(label_seq);
+        wclose(&stream);
+        fclose(ast);
+
+        long len = ftell(out);
+        rewind(out);
+        std::string yaml(static_cast<size_t>(len), '\0');
+        EXPECT_EQ(fread(&yaml[0], 1, yaml.size(), out), yaml.size());
+        fclose(out);
+
+        symtab_destroy();
+        structtab_destroy();
+        typetab_destroy();
+        typecheck_set_anon_seq(0);
+        tac_intern_destroy();
+        return yaml;
+    }
+};
+
+// Everything a header leaves in the tables: a typedef, structs named and anonymous, enum
+// constants, prototypes, an initialized variable, and a function with a string literal
+// and a static local.
+static const char header[] = R"(
+typedef unsigned long size_t;
+struct pair { size_t a, b; };
+struct { int lo, hi; } range = { 1, 9 };
+enum color { RED, GREEN = 5 };
+int lookup(enum color c);
+int puts(const char *s);
+static int next_id(void) { static int id; puts("next"); return ++id; }
+)";
+
+static const char body[] = R"(
+size_t area(struct pair *p) { return p->a * p->b; }
+int green(void) { return lookup(GREEN) + range.hi; }
+int count(void) { static int id; puts("count"); return next_id() + ++id; }
+struct { char c; } other;
+)";
+
+TEST_F(SnapshotTest, ResumesAfterPrefix)
+{
+    std::string unit  = std::string(header) + body;
+    std::string whole = Lower(unit.c_str(), WHOLE);
+    ASSERT_NE(whole.find("id$1"), std::string::npos);
+
+    // The TAC of the header is in the snapshot as well.
+    EXPECT_EQ(Lower(header, SAVE), Lower(header, WHOLE));
+    EXPECT_EQ(Lower(unit.c_str(), RESUME), whole);
+    EXPECT_TRUE(resumed);
+}
+
+TEST_F(SnapshotTest, DifferentPrefixIsNotUsed)
+{
+    Lower(header, SAVE);
+    std::string edited = std::string(header) + body;
+    edited.replace(edited.find("GREEN = 5"), 9, "GREEN = 6");
+    std::string whole = Lower(edited.c_str(), WHOLE);
+    EXPECT_EQ(Lower(edited.c_str(), RESUME), whole);
+    EXPECT_FALSE(resumed);
+
+    // Nor is it when the unit ends before the prefix does.
+    const char *shorter = "typedef unsigned long size_t;";
+    whole               = Lower(shorter, WHOLE);
+    EXPECT_EQ(Lower(shorter, RESUME), whole);
+    EXPECT_FALSE(resumed);
+}
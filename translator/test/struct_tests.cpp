@@ -549,3 +549,22 @@ TEST_F(TranslateTest, StoreToFieldAsValue)
           value: 0
 )");
 }
+
+// An aggregate larger than 16 words is copied by one BLOCK_COPY between word pointers
+// rather than unrolled word by word.
+TEST_F(TranslateTest, LargeStructAssignIsBlockCopy)
+{
+    std::string yaml = CompileToYaml("struct S { int a[17]; };"
+                                     "void f(struct S *p) { struct S s; s = *p; }");
+    EXPECT_NE(yaml.find("kind: block_copy"), std::string::npos);
+    EXPECT_NE(yaml.find("size: 102"), std::string::npos);
+    EXPECT_EQ(yaml.find("kind: copy_from_offset"), std::string::npos);
+    EXPECT_EQ(yaml.find("kind: load"), std::string::npos);
+}
+
+TEST_F(TranslateTest, SixteenWordStructAssignUnrolls)
+{
+    std::string yaml = CompileToYaml("struct S { int a[16]; };"
+                                     "void f(struct S *p) { struct S s; s = *p; }");
+    EXPECT_EQ(yaml.find("kind: block_copy"), std::string::npos);
+}
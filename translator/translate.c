@@ -156,7 +156,7 @@ Tac_Val *val_long_double(long double v)
 Tac_Val *val_var(const char *name)
 {
     Tac_Val *tv    = tac_new_val(TAC_VAL_VAR);
-    tv->u.var_name = xstrdup(name);
+    tv->u.var_name = tac_intern(name);
     return tv;
 }
 
@@ -164,7 +164,8 @@ Tac_Val *new_var_val(TacCtx *ctx)
 {
     char *d       = new_temp(ctx);
     Tac_Val *v    = tac_new_val(TAC_VAL_VAR);
-    v->u.var_name = d;
+    v->u.var_name = tac_intern(d);
+    xfree(d);
     return v;
 }
 
@@ -464,14 +465,14 @@ Tac_Val *emit_cast(TacCtx *ctx, Tac_Val *src, const Type *from, const Type *to)
 void emit_jump(TacCtx *ctx, const char *target)
 {
     Tac_Instruction *j = tac_new_instruction(TAC_INSTRUCTION_JUMP);
-    j->u.jump.target   = xstrdup(target);
+    j->u.jump.target   = tac_intern(target);
     tac_append(ctx, j);
 }
 
 void emit_label(TacCtx *ctx, const char *name)
 {
     Tac_Instruction *l = tac_new_instruction(TAC_INSTRUCTION_LABEL);
-    l->u.label.name    = xstrdup(name);
+    l->u.label.name    = tac_intern(name);
     tac_append(ctx, l);
 }
 
@@ -512,9 +513,56 @@ bool type_is_byval_sret(const Type *t)
     return (int)get_size(t) > target_word_bytes();
 }
 
+// Aggregates of more words than this are copied by one BLOCK_COPY, which the backend
+// expands into a loop.  Smaller ones are unrolled into a COPY_FROM_OFFSET/COPY_TO_OFFSET
+// pair per word, which is faster and, at this size, not much longer.
+#define BLOCK_COPY_MIN_WORDS 16
+
+bool aggregate_copy_is_block(int nbytes)
+{
+    int w = target_word_bytes();
+    return (nbytes + w - 1) / w > BLOCK_COPY_MIN_WORDS;
+}
+
+Tac_Val *gen_aggregate_address(TacCtx *ctx, const char *name, int offset)
+{
+    Tac_Val *ptr          = new_var_val(ctx);
+    Tac_Instruction *ga   = tac_new_instruction(TAC_INSTRUCTION_GET_ADDRESS);
+    ga->u.get_address.src = val_var(name);
+    ga->u.get_address.dst = ptr;
+    tac_append(ctx, ga);
+    if (offset == 0)
+        return val_var(ptr->u.var_name);
+
+    int w               = target_word_bytes();
+    Tac_Val *member     = new_var_val(ctx);
+    Tac_Instruction *ap = tac_new_instruction(TAC_INSTRUCTION_ADD_PTR);
+    ap->u.add_ptr.ptr   = val_var(ptr->u.var_name);
+    ap->u.add_ptr.index = val_int(offset / w);
+    ap->u.add_ptr.scale = w;
+    ap->u.add_ptr.dst   = member;
+    tac_append(ctx, ap);
+    return val_var(member->u.var_name);
+}
+
+void gen_block_copy(TacCtx *ctx, Tac_Val *src_ptr, Tac_Val *dst_ptr, int nbytes)
+{
+    int w                    = target_word_bytes();
+    Tac_Instruction *bc      = tac_new_instruction(TAC_INSTRUCTION_BLOCK_COPY);
+    bc->u.block_copy.src_ptr = src_ptr;
+    bc->u.block_copy.dst_ptr = dst_ptr;
+    bc->u.block_copy.size    = (nbytes + w - 1) / w * w;
+    tac_append(ctx, bc);
+}
+
 void gen_struct_assign(TacCtx *ctx, const char *dst_name, int dst_off, const char *src_name,
                        int nbytes)
 {
+    if (aggregate_copy_is_block(nbytes)) {
+        Tac_Val *from = gen_aggregate_address(ctx, src_name, 0);
+        gen_block_copy(ctx, from, gen_aggregate_address(ctx, dst_name, dst_off), nbytes);
+        return;
+    }
     int w      = target_word_bytes();
     int nwords = (nbytes + w - 1) / w;
     for (int i = 0; i < nwords; i++) {
@@ -845,8 +893,8 @@ static void percent_vals(Tac_Val *v, const StringMap *autos)
         if (!map_get(autos, v->u.var_name, &dummy))
             continue;
         char *renamed = percent_name(v->u.var_name);
-        xfree(v->u.var_name);
-        v->u.var_name = renamed;
+        v->u.var_name = tac_intern(renamed);
+        xfree(renamed);
     }
 }
 
@@ -1010,6 +1058,10 @@ static void percent_instr(Tac_Instruction *in, const StringMap *autos)
         percent_name_field(&in->u.copy_from_offset.src, autos);
         percent_vals(in->u.copy_from_offset.dst, autos);
         break;
+    case TAC_INSTRUCTION_BLOCK_COPY:
+        percent_vals(in->u.block_copy.src_ptr, autos);
+        percent_vals(in->u.block_copy.dst_ptr, autos);
+        break;
     case TAC_INSTRUCTION_JUMP:
     case TAC_INSTRUCTION_LABEL:
         break;
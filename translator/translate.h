@@ -87,9 +87,17 @@ int target_word_bytes(void);
 // True when `t` is a struct/union too large to return in a single word, so it uses the
 // hidden-pointer (sret) calling convention.
 bool type_is_byval_sret(const Type *t);
-// Copy a whole struct/union value, word by word, from named aggregate `src_name`
-// into `dst_name` at byte offset `dst_off`.  Both names denote frame-resident or
-// global aggregates (the bases accepted by COPY_TO_OFFSET / COPY_FROM_OFFSET).
+// True when an aggregate of `nbytes` is copied by a BLOCK_COPY rather than word by word.
+bool aggregate_copy_is_block(int nbytes);
+// Word pointer to byte `offset` (a whole number of words) of named aggregate `name`.
+Tac_Val *gen_aggregate_address(TacCtx *ctx, const char *name, int offset);
+// Copy `nbytes` from word pointer `src_ptr` to word pointer `dst_ptr` with one BLOCK_COPY,
+// which takes ownership of both.
+void gen_block_copy(TacCtx *ctx, Tac_Val *src_ptr, Tac_Val *dst_ptr, int nbytes);
+// Copy a whole struct/union value from named aggregate `src_name` into `dst_name` at byte
+// offset `dst_off`: word by word, or by a BLOCK_COPY when it is large.  Both names denote
+// frame-resident or global aggregates (the bases accepted by COPY_TO_OFFSET /
+// COPY_FROM_OFFSET).
 void gen_struct_assign(TacCtx *ctx, const char *dst_name, int dst_off, const char *src_name,
                        int nbytes);
 // Initialize a whole aggregate (named destination base `dst_name`+`dst_off`) from a value